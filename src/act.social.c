@@ -168,6 +168,7 @@ void create_command_list(void)
     }
   }
   complete_cmd_info[k] = cmd_info[i];
+  command_index_changed();
   log("Command info rebuilt, %d total commands.", k);
 }
 
@@ -175,6 +176,7 @@ void free_command_list(void)
 {
   free(complete_cmd_info);
   complete_cmd_info = NULL;
+  command_index_changed();
 }
 
 void free_social_messages(void)
@@ -19,6 +19,7 @@
 #include "interpreter.h"
 #include "handler.h"
 #include "db.h"
+#include "zone_presence.h"
 #include "magic/spells.h"
 #include "obj/house.h"
 #include "screen.h"
@@ -78,6 +79,7 @@
 #include "olc/genshp.h"
 #include "obj/treasure.h"
 #include "player_rename.h"
+#include "persistence_writer.h"
 
 #define SET_NAME_FIELD 34
 
@@ -1859,6 +1861,7 @@ ACMD(do_switch)
 
     victim->desc = ch->desc;
     ch->desc = NULL;
+    zone_presence_update(victim);
   }
 }
 
@@ -1913,6 +1916,7 @@ ACMD(do_return)
     /* And our body's pointer to descriptor now points to our descriptor. */
     ch->desc->character->desc = ch->desc;
     ch->desc = NULL;
+    zone_presence_update(ch);
   }
 }
 
@@ -3701,9 +3705,9 @@ ACMD(do_show)
                  "  %5d objects          %5d prototypes\r\n"
                  "  %5d rooms            %5d zones\r\n"
                  "  %5d triggers         %5d shops\r\n"
-                 "  %5d large bufs       %5d autoquests\r\n"
+                 "  %5d out segments     %5d autoquests\r\n"
                  "  %5d hlquests app     %5d total hl quests\r\n"
-                 "  %5d buf switches     %5d overflows\r\n"
+                 "  %5d segs chained     %5d overflows\r\n"
                  "  %5d lists\r\n"
                  "  %9zu movement trails\r\n",
                  i, con, top_of_p_table + 1, j, top_of_mobt + 1, k, top_of_objt + 1,
@@ -6463,7 +6467,8 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor,
-                            "\n\r*** COPYOVER FAILED: Copyover already in progress. ***\n\r");
+                            "\n\r*** COPYOVER FAILED: Copyover already in progress. ***\n\r",
+                            d->mccp);
       }
     }
     return;
@@ -6482,7 +6487,7 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Environment validation "
-                                           "failed. Game continues normally. ***\n\r");
+                                           "failed. Game continues normally. ***\n\r", d->mccp);
       }
     }
     copyover_status = COPYOVER_NONE;
@@ -6503,7 +6508,7 @@ void perform_do_copyover()
       {
         write_to_descriptor(d->descriptor,
                             "\n\r*** COPYOVER FAILED: Vessel state could not be saved. "
-                            "Game continues normally. ***\n\r");
+                            "Game continues normally. ***\n\r", d->mccp);
       }
     }
     close_copyover_diagnostics(0);
@@ -6546,7 +6551,7 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Unable to create temporary "
-                                           "file. Game continues normally. ***\n\r");
+                                           "file. Game continues normally. ***\n\r", d->mccp);
       }
     }
     copyover_status = COPYOVER_NONE;
@@ -6567,7 +6572,8 @@ void perform_do_copyover()
       {
         write_to_descriptor(
             d->descriptor,
-            "\n\r*** COPYOVER FAILED: Unable to write to file. Game continues normally. ***\n\r");
+            "\n\r*** COPYOVER FAILED: Unable to write to file. Game continues normally. ***\n\r",
+            d->mccp);
       }
     }
     copyover_status = COPYOVER_NONE;
@@ -6599,17 +6605,20 @@ void perform_do_copyover()
       if (d->connected == CON_MENU)
       {
         write_to_descriptor(d->descriptor,
-                            "\n\rSorry, we are rebooting. Your character has been saved.\n\r");
+                            "\n\rSorry, we are rebooting. Your character has been saved.\n\r",
+                            d->mccp);
       }
       else if (d->connected >= CON_OEDIT && d->connected <= CON_TRIGEDIT)
       {
         write_to_descriptor(d->descriptor,
-                            "\n\rSorry, we are rebooting. Your OLC changes have been lost.\n\r");
+                            "\n\rSorry, we are rebooting. Your OLC changes have been lost.\n\r",
+                            d->mccp);
       }
       else
       {
         write_to_descriptor(d->descriptor,
-                            "\n\rSorry, we are rebooting. Come back in a few minutes.\n\r");
+                            "\n\rSorry, we are rebooting. Come back in a few minutes.\n\r",
+                            d->mccp);
       }
 
       close_socket(d); /* throw'em out */
@@ -6618,7 +6627,7 @@ void perform_do_copyover()
     {
       write_to_descriptor(
           d->descriptor,
-          "\n\r *** Time stops for a moment as space and time folds upon itself! ***\n\r");
+          "\n\r *** Time stops for a moment as space and time folds upon itself! ***\n\r", d->mccp);
       switch (rand_number(1, 3))
       {
       case 1:
@@ -6630,7 +6639,8 @@ void perform_do_copyover()
                             " /   /\\  .     ###\\#|#/###   ..    *    .      *  .  ..  *\r\n"
                             "/___/  ^8/      ###\\|/###  *    *            .      *   *\r\n"
                             "|   ||%%(        # }|{  #\r\n"
-                            "|___|,  ||         }|{                                 ejm\r\n");
+                            "|___|,  ||         }|{                                 ejm\r\n",
+                            d->mccp);
         break;
       case 2:
         write_to_descriptor(d->descriptor,
@@ -6653,7 +6663,7 @@ void perform_do_copyover()
                             "      |;:  |(____.-'     '.   ~   -    `    ~ \r\n"
                             "      |;:  |  \\ / `\\       //.  -    ^   ~ \r\n"
                             "      |;:  |\\ /' /\\_\\_        ~. _ ~   -   //- \r\n"
-                            " jgs\\\\/;:   \\'--' `---`           `\\\\//-\\\\///  \r\n");
+                            " jgs\\\\/;:   \\'--' `---`           `\\\\//-\\\\///  \r\n", d->mccp);
 
         break;
       default:
@@ -6686,7 +6696,7 @@ void perform_do_copyover()
             "    _.-'      .-'   .-'  .'   .' \r\n"
             "_.-'       .-'    .'   .'    / \r\n"
             "       _.-'    .-'   .'    .' \r\n"
-            "    .-'            .' \r\n");
+            "    .-'            .' \r\n", d->mccp);
         break;
       }
       write_to_descriptor(
@@ -6694,7 +6704,7 @@ void perform_do_copyover()
           "[The game will pause for about 30 seconds while new code is being imported, \r\n"
           "you will need to reform if you were grouped.  There is no need to disconnect, \r\n"
           "but if you get disconnected, you should be able to reconnect immediately or \r\n"
-          "within a few minutes.  Your character is being saved automatically!]\r\n");
+          "within a few minutes.  Your character is being saved automatically!]\r\n", d->mccp);
 
       /* and handling we need to do */
 
@@ -6765,7 +6775,7 @@ void perform_do_copyover()
           if (d->character && STATE(d) == CON_PLAYING)
           {
             write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Unable to save player "
-                                               "data. Game continues normally. ***\n\r");
+                                               "data. Game continues normally. ***\n\r", d->mccp);
           }
         }
         copyover_status = COPYOVER_NONE;
@@ -6803,7 +6813,7 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Unable to complete file "
-                                           "write. Game continues normally. ***\n\r");
+                                           "write. Game continues normally. ***\n\r", d->mccp);
       }
     }
     copyover_status = COPYOVER_NONE;
@@ -6823,7 +6833,7 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Unable to save data to disk. "
-                                           "Game continues normally. ***\n\r");
+                                           "Game continues normally. ***\n\r", d->mccp);
       }
     }
     copyover_status = COPYOVER_NONE;
@@ -6846,7 +6856,7 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Unable to finalize save file. "
-                                           "Game continues normally. ***\n\r");
+                                           "Game continues normally. ***\n\r", d->mccp);
       }
     }
     copyover_status = COPYOVER_NONE;
@@ -6882,7 +6892,7 @@ void perform_do_copyover()
       if (d->character && STATE(d) == CON_PLAYING)
       {
         write_to_descriptor(d->descriptor, "\n\r*** COPYOVER FAILED: Unable to change directory. "
-                                           "Game continues normally. ***\n\r");
+                                           "Game continues normally. ***\n\r", d->mccp);
       }
     }
 
@@ -6929,7 +6939,8 @@ void perform_do_copyover()
       {
         write_to_descriptor(
             d->descriptor,
-            "\n\r*** COPYOVER FAILED: Game binary not found. Game continues normally. ***\n\r");
+            "\n\r*** COPYOVER FAILED: Game binary not found. Game continues normally. ***\n\r",
+            d->mccp);
       }
     }
 
@@ -6967,6 +6978,10 @@ void perform_do_copyover()
   /*   CLOSE_SOCKET(mother_desc); */
   /* } */
 
+  /* Let the persistence writer finish the saves above before its
+   * connection goes away. */
+  persistence_writer_stop();
+
   /* Close database connections */
   extern void disconnect_from_mysql(void);
   extern void disconnect_from_mysql2(void);
@@ -7046,7 +7061,8 @@ void perform_do_copyover()
     {
       write_to_descriptor(
           d->descriptor,
-          "\n\r*** COPYOVER FAILED: Unable to restart server. Game continues normally. ***\n\r");
+          "\n\r*** COPYOVER FAILED: Unable to restart server. Game continues normally. ***\n\r",
+          d->mccp);
     }
   }
 
@@ -9834,6 +9850,7 @@ ACMD(do_cmdlev)
 
   /* All checks done - set the command level */
   complete_cmd_info[iCmd].minimum_level = iLev;
+  command_index_changed();
   send_to_char(ch,
                "Command level changed (%s%s%s is now available to anyone level %d or higher)\r\n",
                CCYEL(ch, C_NRM), complete_cmd_info[iCmd].command, CCNRM(ch, C_NRM), iLev);
@@ -10375,6 +10392,7 @@ ACMD(do_perfmon)
                  "perfmon entities [csv]  - Print entity lifecycle and zone-reset telemetry.\r\n"
                  "perfmon combat [count] [csv] - Print slow combat and chain-limit telemetry.\r\n"
                  "perfmon saves           - Print incremental persistence scheduler state.\r\n"
+                 "perfmon presence        - Audit zone presence lists and is_empty() savings.\r\n"
                  "perfmon top <metric> [limit] - Rank sections by total, max, or p99.\r\n"
                  "perfmon csv             - Print cumulative profiling CSV.\r\n"
                  "perfmon reset           - Start a new measurement window.\r\n"
@@ -10402,6 +10420,22 @@ ACMD(do_perfmon)
 
     return;
   }
+  else if (!str_cmp(arg1, "presence"))
+  {
+    char buf[MAX_STRING_LENGTH] = {'\0'};
+    uint64_t checks, visited, scan_bound;
+    int written;
+
+    PERF_zone_presence_stats(&checks, &visited, &scan_bound);
+    written = snprintf(buf, sizeof(buf),
+                       "is_empty() calls: %llu, presence entries looked at: %llu, "
+                       "descriptor scan would have walked up to: %llu\r\n",
+                       (unsigned long long)checks, (unsigned long long)visited,
+                       (unsigned long long)scan_bound);
+    zone_presence_audit(buf + written, sizeof(buf) - (size_t)written);
+    page_string(ch->desc, buf, TRUE);
+    return;
+  }
   else if (!str_cmp(arg1, "summ"))
   {
     char buf[MAX_STRING_LENGTH] = {'\0'};
@@ -237,4 +237,6 @@ void start_action_cooldown(struct char_data *ch, action_type act_type, int durat
   {
     attach_mud_event(new_mud_event(eSWIFTACTION, ch, svar), duration);
   }
+
+  msdp_mark_dirty(ch, MSDP_DIRTY_ACTIONS);
 };
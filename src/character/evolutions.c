@@ -12,6 +12,7 @@
 #include "magic/spells.h"
 #include "handler.h"
 #include "db.h"
+#include "zone_presence.h"
 #include "constants.h"
 #include "interpreter.h"
 #include "dgscript/dg_scripts.h"
@@ -1548,6 +1549,7 @@ ACMD(do_eidolon)
     ch->desc->original = ch;
     eidolon->desc = ch->desc;
     ch->desc = NULL;
+    zone_presence_update(eidolon);
   }
   else if (is_abbrev(arg, "mergeforms"))
   {
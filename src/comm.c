@@ -70,6 +70,7 @@
 #include "interpreter.h"
 #include "handler.h"
 #include "db.h"
+#include "zone_presence.h"
 #include "obj/house.h"
 #include "olc/oasis.h"
 #include "olc/genolc.h"
@@ -100,9 +101,12 @@
 #include "wilderness/wilderness.h"
 #include "magic/spell_prep.h"
 #include "perfmon.h"
+#include "persistence_writer.h"
 #include "elf_build_id.h"
 #include "mysql.h"
 #include "net/onboarding.h"
+#include "net/mccp.h"
+#include "net/netpoll.h"
 #include "roleplay.h"
 #include "help.h"
 #include "vessels/transport.h"
@@ -124,6 +128,24 @@
 #define INVALID_SOCKET (-1)
 #endif
 
+#ifndef HAVE_SYS_UIO_H
+/* Without writev(), perform_socket_writev() sends a segment at a time. */
+struct iovec
+{
+  void *iov_base;
+  size_t iov_len;
+};
+#endif
+
+/* Most pieces process_output() sends a descriptor's output in: an
+ * interruption CRLF, the segments of a full queue (one more when its first
+ * was partly sent, and an empty one taken as the last filled up), the
+ * overflow notice, the compact-mode CRLF and the prompt. */
+#define OUTPUT_SEGMENTS (LARGE_BUFSIZE / (SMALL_BUFSIZE - 1) + 7)
+
+/* Most output segments kept on the pool, enough for five full queues. */
+#define OUTPUT_POOL_SEGMENTS (5 * LARGE_BUFSIZE / (SMALL_BUFSIZE - 1))
+
 /* Keep socket processing responsive when replaying missed heartbeats. */
 #define HEARTBEAT_CATCHUP_BUDGET_USEC ((uint64_t)OPT_USEC)
 #define HEARTBEAT_CATCHUP_LOG_INTERVAL 60
@@ -137,12 +159,12 @@ extern time_t newsmod;
 
 /* locally defined globals, used externally */
 struct descriptor_data *descriptor_list = NULL; /* master desc list */
-int buf_largecount = 0;                         /* # of large buffers which exist */
+int buf_largecount = 0;                         /* # of output segments which exist */
 
 /* Copyover debug toggle - set to 0 to disable debug messages */
 int copyover_debug_enabled = 0;
 int buf_overflows = 0;                               /* # of overflows of output */
-int buf_switches = 0;                                /* # of switches from small to large buf */
+int buf_switches = 0;                                /* # of segments chained onto queues */
 int circle_shutdown = 0;                             /* clean shutdown */
 int circle_reboot = 0;                               /* reboot the game after a shutdown */
 static volatile sig_atomic_t shutdown_requested = 0; /* flag for signal-triggered shutdown */
@@ -156,7 +178,9 @@ int next_tick = SECS_PER_MUD_HOUR; /* Tick countdown */
 const unsigned PERF_pulse_per_second = PASSES_PER_SEC;
 
 /* static local global variable declarations (current file scope only) */
-static struct txt_block *bufpool = NULL; /* pool of large output buffers */
+static struct output_segment *bufpool = NULL; /* pool of output segments */
+static struct descriptor_data *output_pending_list = NULL; /* for the output pass */
+static int bufpool_count = 0;                 /* # of segments on the pool */
 static int max_players = 0;              /* max descriptors available */
 static int tics_passed = 0;              /* for extern checkpointing */
 static struct timeval null_time;         /* zero-valued time structure */
@@ -177,7 +201,6 @@ static RETSIGTYPE reap(int sig);
 static RETSIGTYPE checkpointing(int sig);
 static RETSIGTYPE hupsig(int sig);
 static ssize_t perform_socket_read(socket_t desc, char *read_point, size_t space_left);
-static ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length);
 static void circle_sleep(struct timeval *timeout);
 static int get_from_q(struct txt_q *queue, char *dest, int *aliased);
 static void init_game(ush_int port);
@@ -186,17 +209,23 @@ static socket_t init_socket(ush_int port);
 static int new_descriptor(socket_t s);
 static int get_max_players(void);
 static int process_output(struct descriptor_data *t);
-static void retain_unsent_output(struct descriptor_data *t, const char *output, int result);
+static bool descriptor_output_blocked(struct descriptor_data *d);
+static void process_pending_output(void);
+static void retain_unsent_output(struct descriptor_data *t, const struct iovec *tail,
+                                 int tail_count, int result);
+static int write_segments_to_descriptor(socket_t desc, struct iovec *iov, int count,
+                                        struct mccp_stream *comp);
 static int process_input(struct descriptor_data *t);
 static void timediff(struct timeval *diff, struct timeval *a, struct timeval *b);
 static void timeadd(struct timeval *sum, struct timeval *a, struct timeval *b);
 static void flush_queues(struct descriptor_data *d);
+static void output_clear(struct descriptor_data *t);
 static void nonblock(socket_t s);
 static int perform_subst(struct descriptor_data *t, char *orig, char *subst);
 static void record_usage(void);
 static char *make_prompt(struct descriptor_data *point);
 static void check_idle_passwords(void);
-static void init_descriptor(struct descriptor_data *newd, int desc);
+static bool init_descriptor(struct descriptor_data *newd, int desc);
 static void persistence_schedule_minute(int include_crash_and_houses);
 static void persistence_scheduler_step(uint64_t heart_pulse);
 
@@ -210,6 +239,7 @@ static int open_logfile(const char *filename, FILE *stderr_fp);
 static sigfunc *my_signal(int signo, sigfunc *func);
 #endif
 static void msdp_update(void); /* KaVir plugin*/
+static unsigned long msdp_status_fingerprint(struct char_data *ch);
 void update_msdp_affects(struct char_data *ch);
 void update_damage_and_effects_over_time(void);
 void update_player_last_on(void);
@@ -608,7 +638,7 @@ void copyover_recover()
     }
 
     /* Write something, and check if it goes error-free */
-    if (write_to_descriptor(desc, "\n\rRestoring from copyover...\n\r") < 0)
+    if (write_to_descriptor(desc, "\n\rRestoring from copyover...\n\r", NULL) < 0)
     {
       log("SYSERR: copyover_recover: Failed to write to descriptor %d for player %s", desc, name);
       close(desc); /* nope */
@@ -618,7 +648,13 @@ void copyover_recover()
     /* create a new descriptor */
     CREATE(d, struct descriptor_data, 1);
     memset((char *)d, 0, sizeof(struct descriptor_data));
-    init_descriptor(d, desc); /* set up various stuff */
+    if (!init_descriptor(d, desc)) /* set up various stuff */
+    {
+      log("SYSERR: copyover_recover: Cannot watch descriptor %d for player %s", desc, name);
+      close(desc);
+      free(d);
+      continue;
+    }
 
     strlcpy(d->host, host, sizeof(d->host));
     d->next = descriptor_list;
@@ -659,12 +695,15 @@ void copyover_recover()
     {
       log("SYSERR: copyover_recover: Character '%s' could not be loaded (player_i=%d, deleted=%d)",
           name, player_i, (player_i >= 0 && PLR_FLAGGED(d->character, PLR_DELETED)) ? 1 : 0);
-      write_to_descriptor(desc, "\n\rSomehow, your character was lost in the copyover. Sorry.\n\r");
+      write_to_descriptor(d->descriptor,
+                          "\n\rSomehow, your character was lost in the copyover. Sorry.\n\r",
+                          d->mccp);
       close_socket(d);
     }
     else
     {
-      write_to_descriptor(desc, "\n\rCopyover recovery complete.\n\r");
+      write_to_descriptor(d->descriptor, "\n\rCopyover recovery complete.\n\r", d->mccp);
+      mark_output_pending(d);
       GET_PREF(d->character) = pref;
 
       enter_player_game(d);
@@ -727,6 +766,13 @@ static void init_game(ush_int local_port)
     nonblock(mother_desc);
   }
 
+  if (!netpoll_init(NETPOLL_AUTO) || !netpoll_add(mother_desc, NULL))
+  {
+    log("SYSERR: Could not start polling the network.");
+    exit(1);
+  }
+  log("Polling sockets with %s.", netpoll_backend_name());
+
   event_init();
 
   /* set up hash table for find_char() */
@@ -763,6 +809,10 @@ static void init_game(ush_int local_port)
   log("Initializing terrain bridge API.");
   terrain_api_start();
 
+  /* Player and object saves from here on are written off the game thread. */
+  log("Starting persistence writer.");
+  persistence_writer_start();
+
   /* Event registration begins during boot, which initializes PERFMON before
    * the world has finished allocating its normal resident data. Start the
    * operational window only after boot and copyover recovery are complete so
@@ -802,7 +852,9 @@ static void init_game(ush_int local_port)
   while (descriptor_list)
     close_socket(descriptor_list);
 
+  netpoll_remove(mother_desc);
   CLOSE_SOCKET(mother_desc);
+  netpoll_shutdown();
 
   if (circle_reboot != 2)
     save_all();
@@ -810,6 +862,9 @@ static void init_game(ush_int local_port)
   log("Saving current MUD time.");
   save_mud_time(&time_info);
 
+  log("Finishing queued player saves.");
+  persistence_writer_stop();
+
   if (circle_reboot)
   {
     log("Rebooting.");
@@ -1011,12 +1066,13 @@ static int get_max_players(void)
  * such as mobile_activity(). */
 void game_loop(socket_t local_mother_desc)
 {
-  fd_set input_set, output_set, exc_set, null_set;
   struct timeval last_time, opt_time, process_time, temp_time;
   struct timeval before_sleep, now, timeout, perf_start;
   char comm[MAX_INPUT_LENGTH] = {'\0'};
   struct descriptor_data *d = NULL, *next_d = NULL;
-  int missed_pulses = 0, maxdesc = 0, aliased = 0;
+  struct netpoll_event *events = NULL;
+  socket_t discord_server_fd = INVALID_SOCKET, discord_client_fd = INVALID_SOCKET;
+  int missed_pulses = 0, aliased = 0, ready = 0, i;
   int requested_missed_pulses = 0;
   int requested_heartbeats = 0;
   int replayed_heartbeats = 0;
@@ -1049,7 +1105,6 @@ void game_loop(socket_t local_mother_desc)
   null_time.tv_usec = 0;
   opt_time.tv_usec = OPT_USEC;
   opt_time.tv_sec = 0;
-  FD_ZERO(&null_set);
 
   gettimeofday(&last_time, (struct timezone *)0);
   perf_start = last_time;
@@ -1062,26 +1117,19 @@ void game_loop(socket_t local_mother_desc)
    * Checking both ensures clean exit in all cases. */
   while (!circle_shutdown && !shutdown_requested)
   {
-    /* Sleep if we don't have any connections */
-    if (descriptor_list == NULL)
+    /* Sleep if we don't have any connections, or bridge responses to finish */
+    if (descriptor_list == NULL && !terrain_api_has_pending_output())
     {
-      int i3_event_fd;
-      int max_sleep_desc;
-      int select_result;
+      socket_t sleep_fds[3];
+      int sleep_count = 0, i3_slot = -1, woken;
 
       log("No connections.  Going to sleep.");
-      FD_ZERO(&input_set);
-      FD_SET(local_mother_desc, &input_set);
+      sleep_fds[sleep_count++] = local_mother_desc;
 
-      max_sleep_desc = local_mother_desc;
-      i3_event_fd = i3_get_event_fd();
-      if (i3_event_fd >= 0)
+      if (i3_get_event_fd() >= 0)
       {
-        FD_SET(i3_event_fd, &input_set);
-        if (i3_event_fd > max_sleep_desc)
-        {
-          max_sleep_desc = i3_event_fd;
-        }
+        i3_slot = sleep_count;
+        sleep_fds[sleep_count++] = i3_get_event_fd();
       }
 
       /* Add terrain bridge server socket to wake up on API connections */
@@ -1089,22 +1137,17 @@ void game_loop(socket_t local_mother_desc)
       {
         struct terrain_api_server *terrain_server = get_terrain_api_server();
         if (terrain_server && terrain_server->server_socket != INVALID_SOCKET)
-        {
-          FD_SET(terrain_server->server_socket, &input_set);
-          if (terrain_server->server_socket > max_sleep_desc)
-            max_sleep_desc = terrain_server->server_socket;
-        }
+          sleep_fds[sleep_count++] = terrain_server->server_socket;
       }
 
-      select_result = select(max_sleep_desc + 1, &input_set, (fd_set *)0, (fd_set *)0, NULL);
-      if (select_result < 0)
+      if ((woken = netpoll_sleep(sleep_fds, sleep_count)) < 0)
       {
         if (errno == EINTR)
           log("Waking up to process signal.");
         else
           perror("SYSERR: Select coma");
       }
-      else if (i3_event_fd >= 0 && FD_ISSET(i3_event_fd, &input_set))
+      else if (woken == i3_slot)
       {
         i3_process_events();
       }
@@ -1113,43 +1156,15 @@ void game_loop(socket_t local_mother_desc)
       gettimeofday(&last_time, (struct timezone *)0);
       perf_start = last_time;
     }
-    /* Set up the input, output, and exception sets for select(). */
-    FD_ZERO(&input_set);
-    FD_ZERO(&output_set);
-    FD_ZERO(&exc_set);
-    FD_SET(local_mother_desc, &input_set);
-
-    maxdesc = local_mother_desc;
-
-    /* Add Discord bridge sockets to select sets */
-    if (discord_bridge)
-    {
-      if (discord_bridge->server_socket != INVALID_SOCKET)
-      {
-        FD_SET(discord_bridge->server_socket, &input_set);
-        if (discord_bridge->server_socket > maxdesc)
-          maxdesc = discord_bridge->server_socket;
-      }
-      if (discord_bridge->client_socket != INVALID_SOCKET)
-      {
-        FD_SET(discord_bridge->client_socket, &input_set);
-        if (discord_bridge->outbuf_len > 0)
-          FD_SET(discord_bridge->client_socket, &output_set);
-        if (discord_bridge->client_socket > maxdesc)
-          maxdesc = discord_bridge->client_socket;
-      }
-    }
-
-    for (d = descriptor_list; d; d = d->next)
-    {
-#ifndef CIRCLE_WINDOWS
-      if (d->descriptor > maxdesc)
-        maxdesc = d->descriptor;
-#endif
-      FD_SET(d->descriptor, &input_set);
-      FD_SET(d->descriptor, &output_set);
-      FD_SET(d->descriptor, &exc_set);
-    }
+    /* Descriptors and the mother socket stay registered with the poller from
+     * open to close; the Discord bridge opens and closes its own sockets, so
+     * follow whichever it has now. */
+    netpoll_follow(&discord_server_fd,
+                   discord_bridge ? discord_bridge->server_socket : INVALID_SOCKET);
+    netpoll_follow(&discord_client_fd,
+                   discord_bridge ? discord_bridge->client_socket : INVALID_SOCKET);
+    if (discord_client_fd != INVALID_SOCKET)
+      netpoll_want_write(discord_client_fd, discord_bridge->outbuf_len > 0);
 
     /* At this point, we have completed all input, output and heartbeat
      * activity from the previous iteration, so we have to put ourselves
@@ -1278,13 +1293,10 @@ void game_loop(socket_t local_mother_desc)
     PERF_PROF_ENTER_SAMPLED(pr_main_loop_, "Main Loop");
 
     /* Poll (without blocking) for new input, output, and exceptions */
-    if (select(maxdesc + 1, &input_set, &output_set, &exc_set, &null_time) < 0)
-    {
-      perror("SYSERR: Select poll");
+    if ((ready = netpoll_wait(0, &events)) < 0)
       return;
-    }
     /* If there are new connections waiting, accept them. */
-    if (FD_ISSET(local_mother_desc, &input_set))
+    if (netpoll_ready(local_mother_desc) & NETPOLL_READ)
       new_descriptor(local_mother_desc);
 
     /* Process Discord bridge */
@@ -1292,21 +1304,21 @@ void game_loop(socket_t local_mother_desc)
     {
       /* Check for new Discord bridge connections */
       if (discord_bridge->server_socket != INVALID_SOCKET &&
-          FD_ISSET(discord_bridge->server_socket, &input_set))
+          (netpoll_ready(discord_bridge->server_socket) & NETPOLL_READ))
       {
         accept_discord_connection();
       }
 
       /* Process Discord bridge input */
       if (discord_bridge->client_socket != INVALID_SOCKET &&
-          FD_ISSET(discord_bridge->client_socket, &input_set))
+          (netpoll_ready(discord_bridge->client_socket) & NETPOLL_READ))
       {
         process_discord_input();
       }
 
       /* Process Discord bridge output */
       if (discord_bridge->client_socket != INVALID_SOCKET &&
-          FD_ISSET(discord_bridge->client_socket, &output_set))
+          (netpoll_ready(discord_bridge->client_socket) & NETPOLL_WRITE))
       {
         process_discord_output();
       }
@@ -1315,30 +1327,24 @@ void game_loop(socket_t local_mother_desc)
       /* check_discord_timeout(); */
     }
 
-    /* Kick out the freaky folks in the exception set and marked for close */
-    for (d = descriptor_list; d; d = next_d)
-    {
-      next_d = d->next;
-      if (FD_ISSET(d->descriptor, &exc_set))
-      {
-        FD_CLR(d->descriptor, &input_set);
-        FD_CLR(d->descriptor, &output_set);
+    /* Kick out the freaky folks in the exception set.  Closing a descriptor
+     * clears its event, so the input pass below skips it. */
+    for (i = 0; i < ready; i++)
+      if ((events[i].ready & NETPOLL_ERROR) && (d = events[i].owner) != NULL)
         close_socket(d);
-      }
-    }
 
     PERF_PROF_ENTER(pr_process_input_, "Process Input");
     /* Process descriptors with input pending */
-    for (d = descriptor_list; d; d = next_d)
+    for (i = 0; i < ready; i++)
     {
-      next_d = d->next;
-      if (FD_ISSET(d->descriptor, &input_set))
-      {
-        if (d->pProtocol != NULL)     /* KaVir's plugin */
-          d->pProtocol->WriteOOB = 0; /* KaVir's plugin */
-        if (process_input(d) < 0)
-          close_socket(d);
-      }
+      if (!(events[i].ready & NETPOLL_READ) || (d = events[i].owner) == NULL)
+        continue;
+      if (d->pProtocol != NULL)     /* KaVir's plugin */
+        d->pProtocol->WriteOOB = 0; /* KaVir's plugin */
+      if (!d->has_prompt) /* A prompt held back for out-of-band data */
+        mark_output_pending(d);
+      if (process_input(d) < 0)
+        close_socket(d);
     }
     PERF_PROF_EXIT(pr_process_input_);
 
@@ -1385,6 +1391,7 @@ void game_loop(socket_t local_mother_desc)
           GET_WAIT_STATE(d->character) = 1;
         }
         d->has_prompt = FALSE;
+        mark_output_pending(d);
 
         if (d->showstr_count) /* Reading something w/ pager */
           show_string(d, comm);
@@ -1445,33 +1452,13 @@ void game_loop(socket_t local_mother_desc)
       web_onboarding_tick(d);
 
     PERF_PROF_ENTER(pr_process_output_, "Process Output");
-    /* Send queued output out to the operating system (ultimately to user). */
-    for (d = descriptor_list; d; d = next_d)
-    {
-      next_d = d->next;
-      if (*(d->output) && FD_ISSET(d->descriptor, &output_set))
-      {
-        /* Output for this player is ready */
-        if (process_output(d) < 0)
-          close_socket(d);
-        else
-          d->has_prompt = 1;
-      }
-    }
+    /* Sockets that were full and can take more now rejoin the output pass. */
+    for (i = 0; i < ready; i++)
+      if ((events[i].ready & NETPOLL_WRITE) && (d = events[i].owner) != NULL)
+        mark_output_pending(d);
+    process_pending_output();
     PERF_PROF_EXIT(pr_process_output_);
 
-    /* Print prompts for other descriptors who had no other output */
-    for (d = descriptor_list; d; d = d->next)
-    {
-      /* Ornir's attempt to remove blank lines */
-      if (!d->has_prompt && !d->pProtocol->WriteOOB)
-      {
-        // if (!d->has_prompt) {
-        write_to_descriptor(d->descriptor, make_prompt(d));
-        d->has_prompt = TRUE;
-      }
-    }
-
     /* Kick out folks in the CON_CLOSE or CON_DISCONNECT state */
     for (d = descriptor_list; d; d = next_d)
     {
@@ -1759,7 +1746,7 @@ static int persistence_run_player_task(enum persistence_task task)
   if (task == PERSISTENCE_TASK_CHARACTER)
   {
     PERF_PROF_ENTER_SAMPLED(pr_minute_char_save_, "minute.character_save");
-    success = save_char_checked(ch, 0);
+    success = save_char_async(ch, 0);
     PERF_PROF_EXIT(pr_minute_char_save_);
   }
   else if (task == PERSISTENCE_TASK_PET)
@@ -1916,7 +1903,7 @@ size_t persistence_scheduler_repr(char *out_buf, size_t n)
   }
   if ((size_t)result >= n)
     return n - 1;
-  return (size_t)result;
+  return (size_t)result + persistence_writer_repr(out_buf + result, n - (size_t)result);
 }
 
 void persistence_scheduler_reset_telemetry(void)
@@ -2234,6 +2221,7 @@ void heartbeat(int heart_pulse)
     save_clan_investments();
   }
 
+  persistence_writer_drain();
   persistence_scheduler_step(heart_pulse >= 0 ? (uint64_t)heart_pulse : 0);
 
   /* 3 minute pulse for record usage */
@@ -2915,35 +2903,9 @@ static int get_from_q(struct txt_q *queue, char *dest, int *aliased)
   return (1);
 }
 
-/* Empty the queues before closing connection */
+/* Empty the input queue, for '--' or before closing connection */
 static void flush_queues(struct descriptor_data *d)
 {
-  if (d->large_outbuf)
-  {
-    /* Count how many buffers are already in the pool */
-    int pool_count = 0;
-    struct txt_block *tmp = bufpool;
-    while (tmp)
-    {
-      pool_count++;
-      tmp = tmp->next;
-    }
-
-    /* If we have too many buffers in the pool, free this one instead */
-    if (pool_count >= 5) /* Keep max 5 buffers in pool */
-    {
-      if (d->large_outbuf->text)
-        free(d->large_outbuf->text);
-      free(d->large_outbuf);
-      buf_largecount--;
-    }
-    else
-    {
-      /* Add to pool for reuse */
-      d->large_outbuf->next = bufpool;
-      bufpool = d->large_outbuf;
-    }
-  }
   while (d->input.head)
   {
     struct txt_block *tmp = d->input.head;
@@ -2966,6 +2928,138 @@ size_t write_to_output(struct descriptor_data *t, const char *txt, ...)
   return left;
 }
 
+/* Whether t's output starts in its first pooled segment, all of small_outbuf
+ * having been sent. */
+static bool output_front_pooled(const struct descriptor_data *t)
+{
+  return t->output_segments != NULL &&
+         t->output == t->output_segments->text + t->output_segments->sent;
+}
+
+/* How many of t's queued bytes are in its first segment, at t->output. */
+static size_t output_first_length(const struct descriptor_data *t)
+{
+  const struct output_segment *segment = t->output_segments;
+  size_t later = 0;
+
+  if (segment == NULL)
+    return ((size_t)t->bufptr);
+  if (output_front_pooled(t))
+    return (segment->length - segment->sent);
+
+  for (; segment; segment = segment->next)
+    later += segment->length;
+  return ((size_t)t->bufptr - later);
+}
+
+/* Chain a fresh segment onto t's output queue, to be written into next. */
+static void output_add_segment(struct descriptor_data *t)
+{
+  struct output_segment *segment;
+
+  /* Take one from the pool, or else create a new one. */
+  if (bufpool != NULL)
+  {
+    segment = bufpool;
+    bufpool = segment->next;
+    bufpool_count--;
+  }
+  else
+  {
+    CREATE(segment, struct output_segment, 1);
+    buf_largecount++;
+  }
+  *segment->text = '\0';
+  segment->length = 0;
+  segment->sent = 0;
+  segment->next = NULL;
+
+  if (t->output_tail)
+    t->output_tail->next = segment;
+  else
+    t->output_segments = segment;
+  t->output_tail = segment;
+  t->bufspace = SMALL_BUFSIZE - 1;
+  buf_switches++;
+}
+
+/* Put segment back on the pool, or free it if the pool has enough. */
+static void output_release_segment(struct output_segment *segment)
+{
+  if (bufpool_count >= OUTPUT_POOL_SEGMENTS)
+  {
+    free(segment);
+    buf_largecount--;
+    return;
+  }
+
+  segment->next = bufpool;
+  bufpool = segment;
+  bufpool_count++;
+}
+
+/* Empty t's output queue, back to small_outbuf alone. */
+static void output_clear(struct descriptor_data *t)
+{
+  struct output_segment *segment;
+
+  while ((segment = t->output_segments) != NULL)
+  {
+    t->output_segments = segment->next;
+    output_release_segment(segment);
+  }
+  t->output_tail = NULL;
+  t->output = t->small_outbuf;
+  *t->output = '\0';
+  t->bufptr = 0;
+  t->bufspace = SMALL_BUFSIZE - 1;
+}
+
+/* Append length bytes of data to t's output queue, filling its last segment
+ * and chaining on another whenever that is full.  What does not fit in the
+ * queue at all is cut off, which leaves t in the overflow state (no
+ * bufspace).  Returns the space left. */
+static size_t output_append(struct descriptor_data *t, const char *data, size_t length)
+{
+  bool overflow = FALSE;
+  size_t chunk;
+  char *end;
+
+  if (length + t->bufptr + 1 > LARGE_BUFSIZE)
+  {
+    length = LARGE_BUFSIZE - t->bufptr - 1;
+    overflow = TRUE;
+    buf_overflows++;
+  }
+
+  while (length > 0)
+  {
+    if (t->bufspace == 0)
+      output_add_segment(t);
+
+    end = t->output_tail ? t->output_tail->text + t->output_tail->length : t->output + t->bufptr;
+    chunk = MIN(length, (size_t)t->bufspace);
+    memcpy(end, data, chunk);
+    end[chunk] = '\0';
+    if (t->output_tail)
+      t->output_tail->length += chunk;
+    t->bufptr += (int)chunk;
+    t->bufspace -= (int)chunk;
+    data += chunk;
+    length -= chunk;
+  }
+
+  mark_output_pending(t);
+
+  /* Outside the overflow state there is always room to write to. */
+  if (overflow)
+    t->bufspace = 0;
+  else if (t->bufspace == 0)
+    output_add_segment(t);
+
+  return (t->bufspace);
+}
+
 /* Queue an already encoded protocol frame as one indivisible output record. */
 bool write_to_output_raw_atomic(struct descriptor_data *t, const char *data, size_t data_length,
                                 size_t headroom)
@@ -2980,151 +3074,54 @@ bool write_to_output_raw_atomic(struct descriptor_data *t, const char *data, siz
   if (data_length > available || headroom > available - data_length)
     return FALSE;
 
-  if (data_length < (size_t)t->bufspace)
-  {
-    memcpy(t->output + t->bufptr, data, data_length);
-    t->bufptr += (int)data_length;
-    t->bufspace -= (int)data_length;
-    t->output[t->bufptr] = '\0';
-    return TRUE;
-  }
-
-  buf_switches++;
-  if (t->large_outbuf == NULL)
-  {
-    if (bufpool != NULL)
-    {
-      t->large_outbuf = bufpool;
-      bufpool = bufpool->next;
-    }
-    else
-    {
-      CREATE(t->large_outbuf, struct txt_block, 1);
-      CREATE(t->large_outbuf->text, char, LARGE_BUFSIZE);
-      buf_largecount++;
-    }
-  }
-
-  if (t->output != t->large_outbuf->text)
-    memcpy(t->large_outbuf->text, t->output, (size_t)t->bufptr + 1);
-
-  t->output = t->large_outbuf->text;
-  memcpy(t->output + t->bufptr, data, data_length);
-  t->bufptr += (int)data_length;
-  t->output[t->bufptr] = '\0';
-  t->bufspace = LARGE_BUFSIZE - 1 - t->bufptr;
+  output_append(t, data, data_length);
   return TRUE;
 }
 
-/* Add a new string to a player's output queue. */
+/* Add a new string to a player's output queue.  The text is formatted once
+ * and what the protocol layer makes of it is appended straight from there. */
 size_t vwrite_to_output(struct descriptor_data *t, const char *format, va_list args)
 {
   const char *text_overflow = "\r\nOVERFLOW\r\n";
   static char txt[MAX_STRING_LENGTH] = {'\0'};
-  size_t wantsize = 0;
+  const char *text;
   int size = 0;
 
   /* if we're in the overflow state already, ignore this new output */
   if (t->bufspace == 0)
     return (0);
 
-  wantsize = size = vsnprintf(txt, sizeof(txt), format, args);
-
-  /* this block is Kavir's protocol */
-  strlcpy(txt, ProtocolOutput(t, txt, (int *)&wantsize), sizeof(txt));
-  size = wantsize;
-  if (t->pProtocol->WriteOOB > 0)
-    --t->pProtocol->WriteOOB;
+  size = vsnprintf(txt, sizeof(txt), format, args);
 
   /* If exceeding the size of the buffer, truncate it for the overflow message */
-  if (size < 0 || wantsize >= sizeof(txt))
+  if (size < 0 || (size_t)size >= sizeof(txt))
   {
     size = sizeof(txt) - 1;
     strlcpy(txt + size - strlen(text_overflow), text_overflow,
             sizeof(txt) - (size - strlen(text_overflow)));
   }
 
-  /* If the text is too big to fit into even a large buffer, truncate
-   * the new text to make it fit.  (This will switch to the overflow
-   * state automatically because t->bufspace will end up 0.) */
-  if (size + t->bufptr + 1 > LARGE_BUFSIZE)
-  {
-    size = LARGE_BUFSIZE - t->bufptr - 1;
-    txt[size] = '\0';
-    buf_overflows++;
-  }
-
-  /* If we have enough space, just write to buffer and that's it! If the
-   * text just barely fits, then it's switched to a large buffer instead. */
-  if (t->bufspace > size)
-  {
-    strlcpy(t->output + t->bufptr, txt, t->bufspace);
-    t->bufspace -= size;
-    t->bufptr += size;
-    return (t->bufspace);
-  }
-
-  buf_switches++;
-
-  /* Check if we already have a large buffer allocated */
-  if (t->large_outbuf)
-  {
-    /* We already have a large buffer, just use it */
-    /* IMPORTANT: When reusing an existing large buffer, t->output might already
-     * point to t->large_outbuf->text from a previous buffer switch. This means
-     * the source and destination of the copy operation below could overlap.
-     * We must handle this case carefully to avoid undefined behavior. */
-  }
-  else if (bufpool != NULL)
-  {
-    /* if the pool has a buffer in it, grab it */
-    t->large_outbuf = bufpool;
-    bufpool = bufpool->next;
-  }
-  else
-  { /* else create a new one */
-    CREATE(t->large_outbuf, struct txt_block, 1);
-    CREATE(t->large_outbuf->text, char, LARGE_BUFSIZE);
-    buf_largecount++;
-  }
-
-  /* CRITICAL FIX: Check if source and destination are the same to avoid overlap.
-   * When a large buffer is reused, t->output may already point to t->large_outbuf->text,
-   * causing source and destination to overlap. In this case, we don't need to copy
-   * at all since the data is already in the right place.
-   *
-   * This fixes a critical memory corruption issue detected by Valgrind where
-   * "Source and destination overlap in strcpy" was reported. */
-  if (t->output != t->large_outbuf->text)
-  {
-    strlcpy(t->large_outbuf->text, t->output, LARGE_BUFSIZE);
-  }
-  /* else: source and destination are the same - no copy needed, data already there */
-
-  t->output = t->large_outbuf->text; /* make big buffer primary */
-  strlcat(t->output, txt, LARGE_BUFSIZE);
-
-  /* set the pointer for the next write */
-  t->bufptr = strlen(t->output);
-
-  /* calculate how much space is left in the buffer */
-  t->bufspace = LARGE_BUFSIZE - 1 - t->bufptr;
+  /* this block is Kavir's protocol */
+  text = ProtocolOutput(t, txt, &size);
+  if (*text == '\0') /* Nothing to send, and size may not have been set */
+    size = 0;
+  if (t->pProtocol->WriteOOB > 0)
+    --t->pProtocol->WriteOOB;
 
-  return (t->bufspace);
+  return (output_append(t, text, (size_t)size));
 }
 
 static void free_bufpool(void)
 {
-  struct txt_block *tmp = NULL;
+  struct output_segment *tmp = NULL;
 
   while (bufpool)
   {
     tmp = bufpool->next;
-    if (bufpool->text)
-      free(bufpool->text);
     free(bufpool);
     bufpool = tmp;
   }
+  bufpool_count = 0;
 }
 
 /*  socket handling */
@@ -3220,10 +3217,14 @@ static int set_sendbuf(socket_t s)
 }
 
 /* Initialize a descriptor */
-static void init_descriptor(struct descriptor_data *newd, int desc)
+/* Set up newd for the connection on desc; FALSE if the poller cannot watch
+ * desc, in which case newd is left untouched for the caller to free. */
+static bool init_descriptor(struct descriptor_data *newd, int desc)
 {
   static int last_desc = 0; /* last descriptor number */
 
+  if (!netpoll_add(desc, newd))
+    return FALSE;
   newd->descriptor = desc;
   newd->idle_tics = 0;
   newd->output = newd->small_outbuf;
@@ -3241,6 +3242,7 @@ static void init_descriptor(struct descriptor_data *newd, int desc)
   newd->events = create_list();
   web_onboarding_reset(newd);
   roleplay_pending_clear(newd);
+  return TRUE;
 }
 
 static int new_descriptor(socket_t s)
@@ -3274,9 +3276,10 @@ static int new_descriptor(socket_t s)
   for (newd = descriptor_list; newd; newd = newd->next)
     sockets_connected++;
 
-  if (sockets_connected >= CONFIG_MAX_PLAYING)
+  if (sockets_connected >= CONFIG_MAX_PLAYING || !netpoll_has_room(desc))
   {
-    write_to_descriptor(desc, "Sorry, the game is full right now... please try again later!\r\n");
+    write_to_descriptor(desc, "Sorry, the game is full right now... please try again later!\r\n",
+                        NULL);
     CLOSE_SOCKET(desc);
     return (0);
   }
@@ -3312,7 +3315,13 @@ static int new_descriptor(socket_t s)
   }
 
   /* initialize descriptor data */
-  init_descriptor(newd, desc);
+  if (!init_descriptor(newd, desc))
+  {
+    log("SYSERR: new_descriptor: cannot watch the connection from [%s]", newd->host);
+    CLOSE_SOCKET(desc);
+    free(newd);
+    return (0);
+  }
 
   /* prepend to list */
   newd->next = descriptor_list;
@@ -3340,16 +3349,41 @@ static int new_descriptor(socket_t s)
  *	14 bytes: overflow message
  *	 2 bytes: extra \r\n for non-comapct
  *      14 bytes: unused */
+/* Add length bytes at data to the segments to be written, if there are any. */
+static void output_segment(struct iovec *segments, int *count, const void *data, size_t length)
+{
+  if (length == 0)
+    return;
+  segments[*count].iov_base = (void *)data;
+  segments[*count].iov_len = length;
+  (*count)++;
+}
+
 static int process_output(struct descriptor_data *t)
 {
-  char i[MAX_SOCK_BUF], *osb = i + 2;
-  int result;
+  static const char crlf[] = "\r\n", overflow[] = "**OVERFLOW**";
+  struct iovec segments[OUTPUT_SEGMENTS], sending[OUTPUT_SEGMENTS];
+  struct output_segment *segment;
+  const char *prompt;
+  int count = 0, head, tail, prefix = 0, result, i;
 
-  /* we may need this \r\n for later -- see below */
-  strlcpy(i, "\r\n", sizeof(i));
+  /* The queued segments go out as they are, with what is sent around them
+   * as segments of their own. */
 
-  /* now, append the 'real' output */
-  strlcpy(osb, t->output, sizeof(i) - 2);
+  /* If this is an 'interruption', lead with a CRLF. */
+  if (t->has_prompt && !t->pProtocol->WriteOOB)
+  {
+    t->has_prompt = FALSE;
+    output_segment(segments, &count, crlf, 2);
+    prefix = 2;
+  }
+
+  head = count;
+  output_segment(segments, &count, t->output, output_first_length(t));
+  segment = output_front_pooled(t) ? t->output_segments->next : t->output_segments;
+  for (; segment; segment = segment->next)
+    output_segment(segments, &count, segment->text, segment->length);
+  tail = count;
 
   // color code fix attempt -zusuk
   // parse_at(osb);
@@ -3361,32 +3395,27 @@ static int process_output(struct descriptor_data *t)
   }
   else*/
   if (t->bufspace == 0)
-  {
-    strlcat(osb, "**OVERFLOW**", sizeof(i) - 2);
-  }
+    output_segment(segments, &count, overflow, sizeof(overflow) - 1);
 
   /* add the extra CRLF if the person isn't in compact mode */
   if (STATE(t) == CON_PLAYING && t->character && !IS_NPC(t->character) &&
       !PRF_FLAGGED(t->character, PRF_COMPACT))
   {
     if (!t->pProtocol->WriteOOB)
-      strlcat(osb, "\r\n", sizeof(i) - 2);
+      output_segment(segments, &count, crlf, 2);
   }
 
   if (!t->pProtocol->WriteOOB) /* add a prompt */
-    strlcat(i, make_prompt(t), sizeof(i));
-
-  /* now, send the output.  If this is an 'interruption', use the prepended
-   * CRLF, otherwise send the straight output sans CRLF. */
-  if (t->has_prompt && !t->pProtocol->WriteOOB)
   {
-    t->has_prompt = FALSE;
-    result = write_to_descriptor(t->descriptor, i);
-    if (result > 0)
-      result = MAX(0, result - 2);
+    prompt = make_prompt(t);
+    output_segment(segments, &count, prompt, strlen(prompt));
   }
-  else
-    result = write_to_descriptor(t->descriptor, osb);
+
+  /* write_segments_to_descriptor() steps through the copy it is given. */
+  memcpy(sending, segments, sizeof(segments[0]) * count);
+  result = write_segments_to_descriptor(t->descriptor, sending, count, t->mccp);
+  if (result > 0)
+    result = MAX(0, result - prefix);
 
   if (result < 0)
   { /* Oops, fatal error. Bye! */
@@ -3397,91 +3426,205 @@ static int process_output(struct descriptor_data *t)
 
   /* Handle snooping: prepend "% " and send to snooper. */
   if (t->snoop_by)
-    write_to_output(t->snoop_by, "%% %*s%%%%", result, t->output);
+  {
+    write_to_output(t->snoop_by, "%% ");
+    for (i = head; i < tail; i++)
+      write_to_output(t->snoop_by, "%.*s", (int)segments[i].iov_len,
+                      (const char *)segments[i].iov_base);
+    write_to_output(t->snoop_by, "%%%%");
+  }
 
-  retain_unsent_output(t, osb, result);
+  retain_unsent_output(t, segments + tail, count - tail, result);
   return (result);
 }
 
-/* Retain exactly the portion of an output snapshot that was not accepted by
- * the kernel. Keep descriptor buffer accounting valid across partial writes. */
-static void retain_unsent_output(struct descriptor_data *t, const char *output, int result)
+/* Whether d still has output its socket would not take, and so should wait
+ * for the poller to report it writable. */
+static bool descriptor_output_blocked(struct descriptor_data *d)
 {
-  struct txt_block *tmp;
-  size_t output_length;
-  size_t remaining;
-  int pool_count;
+#ifdef USING_MCCP
+  if (mccp_pending(d->mccp))
+    return TRUE;
+#endif
+  return *(d->output) != '\0';
+}
 
-  if (t == NULL || output == NULL || result < 0)
+/* Queue d for the next output pass, which then visits only the descriptors
+ * with output queued, a prompt owed or a socket writable again. */
+void mark_output_pending(struct descriptor_data *d)
+{
+  if (d->output_pending)
     return;
+  d->output_pending = TRUE;
+  d->next_output = output_pending_list;
+  output_pending_list = d;
+}
 
-  /* The common case: all saved output was handed off to the kernel buffer. */
-  if (result >= t->bufptr)
+/* Send queued output out to the operating system (ultimately to user), and
+ * prompts to those who had no other output.  A socket that was full last
+ * time is left until the poller reports it writable again. */
+static void process_pending_output(void)
+{
+  struct descriptor_data *d;
+
+  while ((d = output_pending_list) != NULL)
   {
-    /* If we were using a large buffer, put the large buffer on the buffer pool
-     * and switch back to the small one. */
-    if (t->large_outbuf)
-    {
-      /* Count how many buffers are already in the pool */
-      pool_count = 0;
-      tmp = bufpool;
-      while (tmp)
-      {
-        pool_count++;
-        tmp = tmp->next;
-      }
+    output_pending_list = d->next_output;
+    d->next_output = NULL;
+    d->output_pending = FALSE;
 
-      /* If we have too many buffers in the pool, free this one instead */
-      if (pool_count >= 5) /* Keep max 5 buffers in pool */
-      {
-        if (t->large_outbuf->text)
-          free(t->large_outbuf->text);
-        free(t->large_outbuf);
-        buf_largecount--;
-      }
-      else
+    if (netpoll_waiting_write(d->descriptor) &&
+        !(netpoll_ready(d->descriptor) & NETPOLL_WRITE))
+      continue;
+#ifdef USING_MCCP
+    /* Compressed output the socket could not take last time goes first */
+    if (d->mccp && mccp_flush(d) < 0)
+    {
+      close_socket(d);
+      continue;
+    }
+#endif
+    if (*(d->output))
+    {
+      /* Output for this player is ready */
+      if (process_output(d) < 0)
       {
-        /* Add to pool for reuse */
-        t->large_outbuf->next = bufpool;
-        bufpool = t->large_outbuf;
+        close_socket(d);
+        continue;
       }
-      t->large_outbuf = NULL;
-      t->output = t->small_outbuf;
+      d->has_prompt = 1;
     }
-    /* reset total bufspace back to that of a small buffer */
-    t->bufspace = SMALL_BUFSIZE - 1;
-    t->bufptr = 0;
-    *(t->output) = '\0';
+    /* Ornir's attempt to remove blank lines */
+    else if (!d->has_prompt && !d->pProtocol->WriteOOB)
+    {
+      write_to_descriptor(d->descriptor, make_prompt(d), d->mccp);
+      d->has_prompt = TRUE;
+    }
+    netpoll_want_write(d->descriptor, descriptor_output_blocked(d));
+  }
+}
+
+/* Retain exactly the portion of the output, and of the tail segments sent
+ * after it, that was not accepted by the kernel; result counts from the start
+ * of the output.  Segments that were sent go back to the pool and t->output
+ * steps past what was sent of the first one left, so nothing is moved. */
+static void retain_unsent_output(struct descriptor_data *t, const struct iovec *tail,
+                                 int tail_count, int result)
+{
+  struct output_segment *segment;
+  size_t skip, first;
+
+  if (t == NULL || (tail == NULL && tail_count > 0) || result < 0)
+    return;
+
+  /* The common case: all saved output was handed off to the kernel buffer. */
+  if (result >= t->bufptr)
+  {
+    skip = (size_t)(result - t->bufptr); /* Sent of the tail */
+    output_clear(t);
 
     /* If a generated overflow message or prompt was only partly written,
-     * preserve its remaining suffix in the small output buffer. */
-    output_length = strlen(output);
-    if ((size_t)result < output_length)
+     * queue its remaining suffix. */
+    for (; tail_count > 0; tail++, tail_count--)
     {
-      remaining = output_length - (size_t)result;
-      if (remaining >= SMALL_BUFSIZE)
-        remaining = SMALL_BUFSIZE - 1;
-      memcpy(t->output, output + result, remaining);
-      t->output[remaining] = '\0';
-      t->bufptr = (int)remaining;
-      t->bufspace = SMALL_BUFSIZE - 1 - t->bufptr;
+      if (skip >= tail->iov_len)
+      {
+        skip -= tail->iov_len;
+        continue;
+      }
+      output_append(t, (const char *)tail->iov_base + skip, tail->iov_len - skip);
+      skip = 0;
     }
+    return;
   }
-  else
+
+  /* Not all data in the queue was sent, so a segment after any that were
+   * becomes the first. */
+  skip = (size_t)result;
+  while (skip >= (first = output_first_length(t)))
   {
-    /* Not all data in buffer sent.  result < output buffersize. */
-    remaining = (size_t)(t->bufptr - result);
-    memmove(t->output, t->output + result, remaining);
-    t->output[remaining] = '\0';
-    t->bufptr = (int)remaining;
-    t->bufspace += result;
+    skip -= first;
+    t->bufptr -= (int)first;
+    if (output_front_pooled(t))
+    {
+      segment = t->output_segments;
+      t->output_segments = segment->next;
+      output_release_segment(segment);
+    }
+    t->output = t->output_segments->text;
   }
+
+  if (output_front_pooled(t))
+    t->output_segments->sent += skip;
+  t->output += skip;
+  t->bufptr -= (int)skip;
+
+  /* What was sent takes the queue out of the overflow state. */
+  if (t->bufspace == 0)
+    output_add_segment(t);
 }
 
 #if defined(LUMINARI_CUTEST)
 void comm_test_retain_unsent_output(struct descriptor_data *t, const char *output, int result)
 {
-  retain_unsent_output(t, output, result);
+  struct iovec tail;
+  int count = 0;
+
+  /* output is what was written: the queued text, then the tail after it. */
+  if (strlen(output) > (size_t)t->bufptr)
+    output_segment(&tail, &count, output + t->bufptr, strlen(output) - t->bufptr);
+  retain_unsent_output(t, &tail, count, result);
+}
+
+int comm_test_process_output(struct descriptor_data *t)
+{
+  return process_output(t);
+}
+
+void comm_test_clear_output(struct descriptor_data *t)
+{
+  output_clear(t);
+}
+
+/* Copy the whole of t's output queue, small_outbuf and the segments chained
+ * after it, into buf as one string; returns the length queued. */
+size_t comm_test_output_text(struct descriptor_data *t, char *buf, size_t size)
+{
+  const struct output_segment *segment;
+  size_t copied, chunk;
+
+  copied = MIN(output_first_length(t), size - 1);
+  memcpy(buf, t->output, copied);
+  segment = output_front_pooled(t) ? t->output_segments->next : t->output_segments;
+  for (; segment && copied < size - 1; segment = segment->next)
+  {
+    chunk = MIN(segment->length, size - 1 - copied);
+    memcpy(buf + copied, segment->text, chunk);
+    copied += chunk;
+  }
+  buf[copied] = '\0';
+  return ((size_t)t->bufptr);
+}
+
+/* Forget the descriptors other tests queued, which may be long gone. */
+void comm_test_reset_output_pending(void)
+{
+  output_pending_list = NULL;
+}
+
+void comm_test_process_pending_output(void)
+{
+  process_pending_output();
+}
+
+void comm_test_msdp_update(void)
+{
+  msdp_update();
+}
+
+unsigned long comm_test_msdp_status_fingerprint(struct char_data *ch)
+{
+  return msdp_status_fingerprint(ch);
 }
 #endif
 
@@ -3527,19 +3670,22 @@ ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length)
   return (-1);
 }
 
+static ssize_t perform_socket_writev(socket_t desc, const struct iovec *iov, int count)
+{
+  (void)count;
+  return (perform_socket_write(desc, iov->iov_base, iov->iov_len));
+}
+
 #else
 
 #if defined(CIRCLE_ACORN)
 #define write socketwrite
 #endif
 
-/* perform_socket_write for all Non-Windows platforms */
-static ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length)
+/* Sort out what a write() or writev() returned, as perform_socket_write()
+ * reports it. */
+static ssize_t socket_write_result(ssize_t result)
 {
-  ssize_t result;
-
-  result = write(desc, txt, length);
-
   if (result > 0)
   {
     /* Write was successful. */
@@ -3574,21 +3720,56 @@ static ssize_t perform_socket_write(socket_t desc, const char *txt, size_t lengt
   /* Looks like the error was fatal.  Too bad. */
   return (-1);
 }
+
+/* perform_socket_write for all Non-Windows platforms */
+ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length)
+{
+  return (socket_write_result(write(desc, txt, length)));
+}
+
+/* As perform_socket_write, for count segments gathered into one call. */
+static ssize_t perform_socket_writev(socket_t desc, const struct iovec *iov, int count)
+{
+#ifdef HAVE_SYS_UIO_H
+  return (socket_write_result(writev(desc, iov, count)));
+#else
+  (void)count;
+  return (perform_socket_write(desc, iov->iov_base, iov->iov_len));
+#endif
+}
 #endif /* CIRCLE_WINDOWS */
 
-/* write_to_descriptor takes a descriptor, and text to write to the descriptor.
- * It keeps calling the system-level write() until all the text has been
- * delivered to the OS, or until an error is encountered. Returns:
- * >=0  If all is well and good.
+/* write_segments_to_descriptor takes a descriptor and count segments of
+ * text, and keeps calling the system-level writev() until all of them have
+ * been delivered to the OS, or until an error is encountered.  The segments
+ * are stepped through as they are sent.  With comp (the descriptor's MCCP2
+ * stream, if it has one) the text is compressed onto the stream instead.
+ * Returns:
+ * >=0  The number of bytes written, if all is well and good.
  *  -1  If an error was encountered, so that the player should be cut off. */
-int write_to_descriptor(socket_t desc, const char *txt)
+static int write_segments_to_descriptor(socket_t desc, struct iovec *iov, int count,
+                                        struct mccp_stream *comp)
 {
   ssize_t bytes_written;
-  size_t total = strlen(txt), write_total = 0;
+  size_t write_total = 0;
+
+#ifdef USING_MCCP
+  if (comp)
+    return mccp_writev(desc, comp, iov, count);
+#else
+  (void)comp;
+#endif
 
-  while (total > 0)
+  while (count > 0)
   {
-    bytes_written = perform_socket_write(desc, txt, total);
+    if (iov->iov_len == 0)
+    {
+      iov++;
+      count--;
+      continue;
+    }
+
+    bytes_written = perform_socket_writev(desc, iov, count);
 
     if (bytes_written < 0)
     {
@@ -3601,17 +3782,33 @@ int write_to_descriptor(socket_t desc, const char *txt)
       /* Temporary failure -- socket buffer full. */
       return (write_total);
     }
-    else
+
+    write_total += bytes_written;
+    for (; count > 0 && (size_t)bytes_written >= iov->iov_len; iov++, count--)
+      bytes_written -= iov->iov_len;
+    if (count > 0)
     {
-      txt += bytes_written;
-      total -= bytes_written;
-      write_total += bytes_written;
+      iov->iov_base = (char *)iov->iov_base + bytes_written;
+      iov->iov_len -= bytes_written;
     }
   }
 
   return (write_total);
 }
 
+/* write_to_descriptor takes a descriptor, and text to write to the descriptor,
+ * and sends it as write_segments_to_descriptor() does.  Returns:
+ * >=0  If all is well and good.
+ *  -1  If an error was encountered, so that the player should be cut off. */
+int write_to_descriptor(socket_t desc, const char *txt, struct mccp_stream *comp)
+{
+  struct iovec segment;
+  int count = 0;
+
+  output_segment(&segment, &count, txt, strlen(txt));
+  return (write_segments_to_descriptor(desc, &segment, count, comp));
+}
+
 /* Same information about perform_socket_write applies here. I like
  * standards, there are so many of them. -gg 6/30/98 */
 static ssize_t perform_socket_read(socket_t desc, char *read_point, size_t space_left)
@@ -3796,8 +3993,9 @@ static int process_input(struct descriptor_data *t)
       char buffer[MAX_INPUT_LENGTH + 64];
 
       snprintf(buffer, sizeof(buffer), "Line too long.  Truncated to:\r\n%s\r\n", tmp);
-      if (write_to_descriptor(t->descriptor, buffer) < 0)
+      if (write_to_descriptor(t->descriptor, buffer, t->mccp) < 0)
         return (-1);
+      mark_output_pending(t);
     }
     if (t->snoop_by)
       write_to_output(t->snoop_by, "%% %s\r\n", tmp);
@@ -3928,8 +4126,14 @@ void close_socket(struct descriptor_data *d)
   struct descriptor_data *temp;
 
   REMOVE_FROM_LIST(d, descriptor_list, next);
+  if (d->output_pending)
+  {
+    REMOVE_FROM_LIST(d, output_pending_list, next_output);
+  }
+  netpoll_remove(d->descriptor);
   CLOSE_SOCKET(d->descriptor);
   flush_queues(d);
+  output_clear(d);
   /* Overwrite and release any private structured-editor content before the
    * attached character or account can be freed or switched. */
   web_onboarding_reset(d);
@@ -3954,6 +4158,7 @@ void close_socket(struct descriptor_data *d)
 
     /* If we're switched, this resets the mobile taken. */
     d->character->desc = NULL;
+    zone_presence_update(d->character);
 
     /* Plug memory leak, from Eric Green. */
     if (!IS_NPC(d->character) && PLR_FLAGGED(d->character, PLR_MAILING) && d->str)
@@ -4019,6 +4224,9 @@ void close_socket(struct descriptor_data *d)
 
   /* KaVir's plugin*/
   ProtocolDestroy(d->pProtocol);
+#ifdef USING_MCCP
+  mccp_free(d);
+#endif
 
   /* Mud Events */
   if (d->events != NULL)
@@ -5685,6 +5893,101 @@ void update_msdp_room(struct char_data *ch)
   }
 }
 
+/* How often, in MSDP passes, each descriptor rebuilds every marked value
+ * anyway, for the changes no mutation point marks (a new title, a light
+ * going out). */
+#define MSDP_REFRESH_PASSES 30
+
+void msdp_mark_dirty(struct char_data *ch, int values)
+{
+  if (ch && ch->desc)
+    ch->desc->msdp_dirty |= values;
+}
+
+static unsigned long msdp_fingerprint(unsigned long sig, long value)
+{
+  return (sig ^ (unsigned long)value) * 16777619UL;
+}
+
+/* Fold in the text itself: a title is often rewritten in place, so its
+ * pointer says nothing about whether it changed. */
+static unsigned long msdp_fingerprint_text(unsigned long sig, const char *text)
+{
+  if (text == NULL)
+    return msdp_fingerprint(sig, -1);
+  for (; *text; text++)
+    sig = msdp_fingerprint(sig, (unsigned char)*text);
+  return msdp_fingerprint(sig, 0);
+}
+
+/* Fingerprints of what has no one place it changes: ch's status, and the
+ * members of ch's group with their vitals. */
+static unsigned long msdp_status_fingerprint(struct char_data *ch)
+{
+  unsigned long sig = 2166136261UL;
+
+  sig = msdp_fingerprint_text(sig, GET_NAME(ch));
+  sig = msdp_fingerprint_text(sig, GET_TITLE(ch));
+  sig = msdp_fingerprint(sig, GET_ALIGNMENT(ch));
+  sig = msdp_fingerprint(sig, GET_POS(ch));
+  sig = msdp_fingerprint(sig, GET_LEVEL(ch));
+  sig = msdp_fingerprint(sig, GET_RACE(ch));
+  return msdp_fingerprint(sig, ch->player.chclass);
+}
+
+static unsigned long msdp_group_fingerprint(struct char_data *ch)
+{
+  unsigned long sig = 2166136261UL;
+  struct char_data *k;
+
+  if (!ch->group)
+    return sig;
+
+  simple_list(NULL);
+  while ((k = (struct char_data *)simple_list(ch->group->members)) != NULL)
+  {
+    sig = msdp_fingerprint(sig, (long)(intptr_t)k);
+    sig = msdp_fingerprint(sig, GROUP_LEADER(GROUP(k)) == k);
+    sig = msdp_fingerprint(sig, GET_LEVEL(k));
+    sig = msdp_fingerprint(sig, GET_HIT(k));
+    sig = msdp_fingerprint(sig, GET_MAX_HIT(k));
+    sig = msdp_fingerprint(sig, GET_MOVE(k));
+    sig = msdp_fingerprint(sig, GET_MAX_MOVE(k));
+  }
+  simple_list(NULL);
+  return sig;
+}
+
+/* Work out which of d's marked values need rebuilding this pass, and clear
+ * the marks. */
+static int msdp_take_dirty(struct descriptor_data *d, struct char_data *ch, unsigned int pass)
+{
+  unsigned long sig;
+  int dirty;
+
+  if (d->msdp_character != ch || (pass + (unsigned int)d->desc_num) % MSDP_REFRESH_PASSES == 0)
+  {
+    d->msdp_character = ch;
+    d->msdp_dirty = MSDP_DIRTY_ALL;
+  }
+
+  /* Armor class and the like follow position and level as well. */
+  if ((sig = msdp_status_fingerprint(ch)) != d->msdp_status_sig)
+  {
+    d->msdp_status_sig = sig;
+    d->msdp_dirty |= MSDP_DIRTY_STATUS | MSDP_DIRTY_STATS;
+  }
+  if ((sig = msdp_group_fingerprint(ch)) != d->msdp_group_sig)
+  {
+    d->msdp_group_sig = sig;
+    d->msdp_dirty |= MSDP_DIRTY_GROUP;
+  }
+
+  dirty = d->msdp_dirty;
+  d->msdp_dirty = 0;
+  return dirty;
+}
+
 static void msdp_update(void)
 {
   const char MsdpVar = (char)MSDP_VAR;
@@ -5693,11 +5996,14 @@ static void msdp_update(void)
   extern const char *dirs[];
   extern const char *sector_types[];
 
+  static unsigned int pass = 0;
   struct descriptor_data *d;
   int PlayerCount = 0;
-  int door, sector;
+  int door, sector, dirty;
   // int damage_bonus = 0;
 
+  pass++;
+
   for (d = descriptor_list; d; d = d->next)
   {
     char buf[MAX_STRING_LENGTH] = {'\0'};
@@ -5719,11 +6025,35 @@ static void msdp_update(void)
 
       ++PlayerCount;
 
-      MSDPSetString(d, eMSDP_CHARACTER_NAME, GET_NAME(ch));
-      set_msdp_plain_text(d, eMSDP_ALIGNMENT, get_align_by_num(GET_ALIGNMENT(ch)));
-      snprintf(buf, sizeof(buf), "%s", GET_TITLE(ch) ? GET_TITLE(ch) : "");
-      strip_colors(buf);
-      MSDPSetString(d, eMSDP_TITLE, buf);
+      /* Nothing is built for a client that speaks neither MSDP nor GMCP. */
+      if (!d->pProtocol || !d->pProtocol->pVariables ||
+          (!d->pProtocol->bMSDP && !d->pProtocol->bGMCP))
+        continue;
+
+      dirty = msdp_take_dirty(d, ch, pass);
+
+      if (dirty & MSDP_DIRTY_STATUS)
+      {
+        MSDPSetString(d, eMSDP_CHARACTER_NAME, GET_NAME(ch));
+        set_msdp_plain_text(d, eMSDP_ALIGNMENT, get_align_by_num(GET_ALIGNMENT(ch)));
+        snprintf(buf, sizeof(buf), "%s", GET_TITLE(ch) ? GET_TITLE(ch) : "");
+        strip_colors(buf);
+        MSDPSetString(d, eMSDP_TITLE, buf);
+
+        snprintf(buf, sizeof(buf), "%s", position_types[GET_POS(ch)]);
+        strip_colors(buf);
+        MSDPSetString(d, eMSDP_POSITION, buf);
+
+        snprintf(buf, sizeof(buf), "%s", race_list[GET_RACE(ch)].type);
+        strip_colors(buf);
+        MSDPSetString(d, eMSDP_RACE, buf);
+
+        // sprinttype(ch->player.chclass, CLSLIST_NAME, buf, sizeof (buf));
+        snprintf(buf, sizeof(buf), "%s", CLSLIST_NAME(ch->player.chclass));
+        strip_colors(buf);
+        MSDPSetString(d, eMSDP_CLASS, buf);
+      }
+
       MSDPSetNumber(d, eMSDP_EXPERIENCE, GET_EXP(ch));
       MSDPSetNumber(d, eMSDP_EXPERIENCE_TNL, level_exp(ch, GET_LEVEL(ch) + 1) - GET_EXP(ch));
       MSDPSetNumber(d, eMSDP_EXPERIENCE_MAX,
@@ -5740,21 +6070,21 @@ static void msdp_update(void)
       MSDPSetNumber(d, eMSDP_CON, GET_CON(ch));
       MSDPSetNumber(d, eMSDP_CHA, GET_CHA(ch));
 
-      snprintf(buf, sizeof(buf), "%s", position_types[GET_POS(ch)]);
-      strip_colors(buf);
-      MSDPSetString(d, eMSDP_POSITION, buf);
-
       /* Affects */
-      update_msdp_affects(ch);
+      if (dirty & MSDP_DIRTY_AFFECTS)
+        update_msdp_affects(ch);
 
       /* Actions */
-      update_msdp_actions(ch);
+      if (dirty & MSDP_DIRTY_ACTIONS)
+        update_msdp_actions(ch);
 
       /* Group */
-      update_msdp_group(ch);
+      if (dirty & MSDP_DIRTY_GROUP)
+        update_msdp_group(ch);
 
       /* Inventory */
-      update_msdp_inventory(ch);
+      if (dirty & MSDP_DIRTY_INVENTORY)
+        update_msdp_inventory(ch);
 
       /* Room */
       update_msdp_room(ch);
@@ -5769,16 +6099,8 @@ static void msdp_update(void)
                                           NO_DICEROLL, MODE_NORMAL_HIT, FALSE, ATTACK_TYPE_PRIMARY);
       MSDPSetNumber(d, eMSDP_DAMAGE_BONUS, damage_bonus);
        */
-      MSDPSetNumber(d, eMSDP_ATTACK_BONUS, compute_attack_bonus(ch, ch, ATTACK_TYPE_PRIMARY));
-
-      snprintf(buf, sizeof(buf), "%s", race_list[GET_RACE(ch)].type);
-      strip_colors(buf);
-      MSDPSetString(d, eMSDP_RACE, buf);
-
-      // sprinttype(ch->player.chclass, CLSLIST_NAME, buf, sizeof (buf));
-      snprintf(buf, sizeof(buf), "%s", CLSLIST_NAME(ch->player.chclass));
-      strip_colors(buf);
-      MSDPSetString(d, eMSDP_CLASS, buf);
+      if (dirty & MSDP_DIRTY_STATS)
+        MSDPSetNumber(d, eMSDP_ATTACK_BONUS, compute_attack_bonus(ch, ch, ATTACK_TYPE_PRIMARY));
 
       /* Location information */
       /*  Only update room stuff if they've changed room */
@@ -5847,10 +6169,13 @@ static void msdp_update(void)
       MSDPSetNumber(d, eMSDP_MONEY, GET_GOLD(ch));
       MSDPSetNumber(d, eMSDP_MOVEMENT, GET_MOVE(ch));
       MSDPSetNumber(d, eMSDP_MOVEMENT_MAX, GET_MAX_MOVE(ch));
-      MSDPSetNumber(d, eMSDP_FORTITUDE, compute_mag_saves(ch, SAVING_FORT, 0));
-      MSDPSetNumber(d, eMSDP_REFLEX, compute_mag_saves(ch, SAVING_REFL, 0));
-      MSDPSetNumber(d, eMSDP_WILLPOWER, compute_mag_saves(ch, SAVING_WILL, 0));
-      MSDPSetNumber(d, eMSDP_AC, compute_armor_class(NULL, ch, FALSE, MODE_ARMOR_CLASS_NORMAL));
+      if (dirty & MSDP_DIRTY_STATS)
+      {
+        MSDPSetNumber(d, eMSDP_FORTITUDE, compute_mag_saves(ch, SAVING_FORT, 0));
+        MSDPSetNumber(d, eMSDP_REFLEX, compute_mag_saves(ch, SAVING_REFL, 0));
+        MSDPSetNumber(d, eMSDP_WILLPOWER, compute_mag_saves(ch, SAVING_WILL, 0));
+        MSDPSetNumber(d, eMSDP_AC, compute_armor_class(NULL, ch, FALSE, MODE_ARMOR_CLASS_NORMAL));
+      }
 
       /* This would be better moved elsewhere? */
       if (pOpponent != NULL)
@@ -5885,13 +6210,13 @@ static void msdp_update(void)
 
       MSDPUpdate(d);
     }
-
-    /* Ideally this should be called once at startup, and again whenever
-     * someone leaves or joins the mud.  But this works, and it keeps the
-     * snippet simple.  Optimise as you see fit.
-     */
-    MSSPSetPlayers(PlayerCount);
   }
+
+  /* Ideally this should be called once at startup, and again whenever
+   * someone leaves or joins the mud.  But this works, and it keeps the
+   * snippet simple.  Optimise as you see fit.
+   */
+  MSSPSetPlayers(PlayerCount);
 }
 #undef MODE_NORMAL_HIT
 #undef MODE_DISPLAY_PRIMARY
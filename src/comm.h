@@ -49,14 +49,33 @@ void send_to_range(room_vnum start, room_vnum finish, const char *messg, ...)
     __attribute__((format(printf, 3, 4)));
 void update_msdp_room(struct char_data *ch);
 void msdp_mark_map_state_changed(void);
+void msdp_mark_dirty(struct char_data *ch, int values);
+void mark_output_pending(struct descriptor_data *d);
 void send_to_mud(struct char_data *broadcaster, char *message);
 
 #if defined(LUMINARI_CUTEST)
 protocol_error_t set_msdp_plain_text_for_test(struct descriptor_data *d, variable_t variable,
                                               const char *value);
 void comm_test_retain_unsent_output(struct descriptor_data *d, const char *output, int result);
+int comm_test_process_output(struct descriptor_data *d);
+void comm_test_clear_output(struct descriptor_data *d);
+size_t comm_test_output_text(struct descriptor_data *d, char *buf, size_t size);
+void comm_test_reset_output_pending(void);
+void comm_test_process_pending_output(void);
+void comm_test_msdp_update(void);
+unsigned long comm_test_msdp_status_fingerprint(struct char_data *ch);
 #endif
 
+/* MSDP values msdp_update() rebuilds only once they are marked with
+ * msdp_mark_dirty() where they change, or on its slow refresh. */
+#define MSDP_DIRTY_AFFECTS (1 << 0)   /**< AFFECTS */
+#define MSDP_DIRTY_ACTIONS (1 << 1)   /**< ACTIONS */
+#define MSDP_DIRTY_INVENTORY (1 << 2) /**< INVENTORY, which also depends on what ch can see */
+#define MSDP_DIRTY_GROUP (1 << 3)     /**< GROUP */
+#define MSDP_DIRTY_STATS (1 << 4)     /**< Saves, armor class and attack bonus */
+#define MSDP_DIRTY_STATUS (1 << 5)    /**< Name, title, alignment, position, race and class */
+#define MSDP_DIRTY_ALL ((1 << 6) - 1)
+
 /* Act type settings and flags */
 #define TO_ROOM 1      /**< act() type: to everyone in room, except ch. */
 #define TO_VICT 2      /**< act() type: to vict_obj. */
@@ -73,8 +92,10 @@ const char *act(const char *str, int hide_invisible, struct char_data *ch, struc
                 void *vict_obj, int type);
 
 /* I/O functions */
+struct mccp_stream;
 void write_to_q(const char *txt, struct txt_q *queue, int aliased);
-int write_to_descriptor(socket_t desc, const char *txt);
+int write_to_descriptor(socket_t desc, const char *txt, struct mccp_stream *comp);
+ssize_t perform_socket_write(socket_t desc, const char *txt, size_t length);
 size_t write_to_output(struct descriptor_data *d, const char *txt, ...)
     __attribute__((format(printf, 2, 3)));
 size_t vwrite_to_output(struct descriptor_data *d, const char *format, va_list args);
@@ -336,6 +336,12 @@ int special_in_comm = YES;
 /* debug mode on or off? */
 int debug_mode = NO;
 
+/* Mobiles in zones no player is in, or near, only run their AI one
+ * mobile_activity cycle in mob_dormant_cadence (0 = every cycle, -1 = never).
+ * mob_active_ring is how many zones out from an occupied one stay awake. */
+int mob_active_ring = 1;
+int mob_dormant_cadence = 10;
+
 // Player stat modifiers
 
 // spell damage.  This is the percent of extra damage done.
@@ -73,6 +73,8 @@ extern int display_closed_doors;
 extern int protocol_negotiation;
 extern int special_in_comm;
 extern int debug_mode;
+extern int mob_active_ring;
+extern int mob_dormant_cadence;
 extern int use_introduction_system;
 extern int perk_system;
 /* Automap and map options */
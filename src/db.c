@@ -23,6 +23,8 @@
 #include "interpreter.h"
 #include "obj/house.h"
 #include "constants.h"
+#include "graph.h"
+#include "zone_presence.h"
 #include "olc/oasis.h"
 #include "dgscript/dg_scripts.h"
 #include "dgscript/dg_event.h"
@@ -66,6 +68,8 @@
 #include "mob/mob_autoroll.h"
 #include "wilderness/perlin.h"
 #include "wilderness/wilderness.h"
+#include "wilderness/terrain_raster.h"
+#include "wilderness/spatial_grid.h"
 #include "wilderness/resource_system.h"
 #include "mysql.h"
 #include "comms/mysql_boards.h" /* MySQL board system */
@@ -799,6 +803,14 @@ void boot_world(void)
   init_perlin(NOISE_STONE, NOISE_STONE_SEED);
   init_perlin(NOISE_CRYSTAL, NOISE_CRYSTAL_SEED);
 
+  /* Baked elevation and moisture; built here the first time, or when the
+   * seeds or the generator change. */
+  if (!scheck)
+  {
+    log("Mapping wilderness terrain raster.");
+    terrain_raster_load(TERRAIN_RASTER_FILE);
+  }
+
   log("Indexing wilderness rooms.");
   initialize_wilderness_lists();
 
@@ -1212,6 +1224,7 @@ void destroy_db(void)
           j = i->next;
           if (i->cmd)
             free(i->cmd);
+          free(i->tokens);
           free(i);
           i = j;
         }
@@ -1251,6 +1264,8 @@ void destroy_db(void)
 
   destroy_perks();
   cleanup_region_path_tables();
+  terrain_raster_close();
+  spatial_grid_shutdown();
 
   /* Clan economy system */
   shutdown_clan_economy();
@@ -2631,6 +2646,8 @@ void renum_world(void)
       if (world[room].dir_option[door])
         if (world[room].dir_option[door]->to_room != NOWHERE)
           world[room].dir_option[door]->to_room = real_room(world[room].dir_option[door]->to_room);
+
+  graph_exits_changed();
 }
 
 /** This is not the same ZCMD as used elsewhere. GRUMBLE... namespace conflict
@@ -5055,6 +5072,74 @@ void remove_obj_from_rnum_hash(struct obj_data *obj)
   obj->prev_in_hash = NULL;
 }
 
+/* The adjustments read_object() makes to every fresh copy of a prototype.
+ * They touch only fields held in the object itself, so the save code can
+ * apply them to a copy on the stack to learn what a fresh load looks like. */
+void apply_object_load_rules(struct obj_data *obj)
+{
+  int j;
+
+  /* going to put some caps here -zusuk */
+  /* weapons, max_weapon_x is defined in oasis.h */
+  if (GET_OBJ_TYPE(obj) == ITEM_WEAPON)
+  {
+    GET_OBJ_VAL(obj, 1) = MIN(MAX_WEAPON_NDICE, GET_OBJ_VAL(obj, 1));
+    GET_OBJ_VAL(obj, 2) = MIN(MAX_WEAPON_SDICE, GET_OBJ_VAL(obj, 2));
+  }
+  /* no longer allowing untyped gear affection -zusuk */
+  for (j = 0; j < MAX_OBJ_AFFECT; j++)
+  {
+    if (obj->affected[j].modifier)
+    {
+      if (obj->affected[j].bonus_type == BONUS_TYPE_UNDEFINED)
+      {
+        obj->affected[j].bonus_type = BONUS_TYPE_ENHANCEMENT;
+      }
+    }
+  }
+  /* item cost cap */
+  // GET_OBJ_COST(obj) = MIN(MAX(GET_OBJ_LEVEL(obj), 1) * 100, GET_OBJ_COST(obj));
+
+  /* conversion for instrument system for bards */
+  if (GET_OBJ_TYPE(obj) == ITEM_INSTRUMENT)
+  {
+    SET_BIT_AR(GET_OBJ_WEAR(obj), ITEM_WEAR_INSTRUMENT);
+  }
+
+  if (OBJ_FLAGGED(obj, ITEM_SET_STATS_AT_LOAD))
+  {
+    int cost = GET_OBJ_COST(obj);
+    int enhancement_bonus = GET_ENHANCEMENT_BONUS(obj);
+    if (GET_OBJ_TYPE(obj) == ITEM_WEAPON)
+    {
+      set_weapon_object(obj, GET_OBJ_VAL(obj, 0));
+      GET_OBJ_COST(obj) = cost;
+    }
+    else if (GET_OBJ_TYPE(obj) == ITEM_ARMOR)
+    {
+      set_armor_object(obj, GET_OBJ_VAL(obj, 1));
+      GET_OBJ_COST(obj) = cost;
+    }
+    GET_OBJ_VAL(obj, 4) = enhancement_bonus;
+    if (cost <= 100)
+    {
+      GET_OBJ_VAL(obj, 4) = 0;
+    }
+
+    if (GET_OBJ_LEVEL(obj) < 1)
+      GET_OBJ_LEVEL(obj) = 1;
+    if (GET_OBJ_LEVEL(obj) > 30)
+      GET_OBJ_LEVEL(obj) = 30;
+
+    // if (obj->activate_spell[ACT_SPELL_SPELLNUM] > 0)
+    // {
+    //   obj->activate_spell[ACT_SPELL_CURRENT_USES] = obj->activate_spell[ACT_SPELL_MAX_USES];
+    // }
+
+    // REMOVE_BIT_AR(GET_OBJ_EXTRA(obj), ITEM_SET_STATS_AT_LOAD);
+  }
+}
+
 /* create a new object from a prototype */
 struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
 {
@@ -5134,69 +5219,11 @@ struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
     obj->special_abilities = specab_list;
   }
 
-  /* going to put some caps here -zusuk */
-  /* weapons, max_weapon_x is defined in oasis.h */
-  if (GET_OBJ_TYPE(obj) == ITEM_WEAPON)
-  {
-    GET_OBJ_VAL(obj, 1) = MIN(MAX_WEAPON_NDICE, GET_OBJ_VAL(obj, 1));
-    GET_OBJ_VAL(obj, 2) = MIN(MAX_WEAPON_SDICE, GET_OBJ_VAL(obj, 2));
-  }
-  /* no longer allowing untyped gear affection -zusuk */
-  for (j = 0; j < MAX_OBJ_AFFECT; j++)
-  {
-    if (obj->affected[j].modifier)
-    {
-      if (obj->affected[j].bonus_type == BONUS_TYPE_UNDEFINED)
-      {
-        obj->affected[j].bonus_type = BONUS_TYPE_ENHANCEMENT;
-      }
-    }
-  }
-  /* item cost cap */
-  // GET_OBJ_COST(obj) = MIN(MAX(GET_OBJ_LEVEL(obj), 1) * 100, GET_OBJ_COST(obj));
-
-  /* conversion for instrument system for bards */
-  if (GET_OBJ_TYPE(obj) == ITEM_INSTRUMENT)
-  {
-    SET_BIT_AR(GET_OBJ_WEAR(obj), ITEM_WEAR_INSTRUMENT);
-  }
+  apply_object_load_rules(obj);
 
   copy_proto_script(obj_proto[i].proto_script, &obj->proto_script);
   assign_obj_triggers(obj);
 
-  if (OBJ_FLAGGED(obj, ITEM_SET_STATS_AT_LOAD))
-  {
-    int cost = GET_OBJ_COST(obj);
-    int enhancement_bonus = GET_ENHANCEMENT_BONUS(obj);
-    if (GET_OBJ_TYPE(obj) == ITEM_WEAPON)
-    {
-      set_weapon_object(obj, GET_OBJ_VAL(obj, 0));
-      GET_OBJ_COST(obj) = cost;
-    }
-    else if (GET_OBJ_TYPE(obj) == ITEM_ARMOR)
-    {
-      set_armor_object(obj, GET_OBJ_VAL(obj, 1));
-      GET_OBJ_COST(obj) = cost;
-    }
-    GET_OBJ_VAL(obj, 4) = enhancement_bonus;
-    if (cost <= 100)
-    {
-      GET_OBJ_VAL(obj, 4) = 0;
-    }
-
-    if (GET_OBJ_LEVEL(obj) < 1)
-      GET_OBJ_LEVEL(obj) = 1;
-    if (GET_OBJ_LEVEL(obj) > 30)
-      GET_OBJ_LEVEL(obj) = 30;
-
-    // if (obj->activate_spell[ACT_SPELL_SPELLNUM] > 0)
-    // {
-    //   obj->activate_spell[ACT_SPELL_CURRENT_USES] = obj->activate_spell[ACT_SPELL_MAX_USES];
-    // }
-
-    // REMOVE_BIT_AR(GET_OBJ_EXTRA(obj), ITEM_SET_STATS_AT_LOAD);
-  }
-
   reason = PERF_entity_current_reason();
   origin_zone = real_zone_by_thing(GET_OBJ_VNUM(obj));
   obj->perf_origin_zone_vnum = origin_zone != NOWHERE ? zone_table[origin_zone].number : NOWHERE;
@@ -6465,26 +6492,7 @@ void reset_zone(zone_rnum zone)
 /* for use in reset_zone; return TRUE if zone 'nr' is free of PC's  */
 int is_empty(zone_rnum zone_nr)
 {
-  struct descriptor_data *i;
-
-  for (i = descriptor_list; i; i = i->next)
-  {
-    if (STATE(i) != CON_PLAYING)
-      continue;
-    if (IN_ROOM(i->character) == NOWHERE)
-      continue;
-    if (world[IN_ROOM(i->character)].zone != zone_nr)
-      continue;
-    /* If an immortal has nohassle off, he counts as present. Added for testing
-     * zone reset triggers -Welcor */
-    if ((!IS_NPC(i->character)) && (GET_LEVEL(i->character) >= LVL_IMMORT) &&
-        (PRF_FLAGGED(i->character, PRF_NOHASSLE)))
-      continue;
-
-    return (0);
-  }
-
-  return (1);
+  return (zone_presence_is_empty(zone_nr));
 }
 
 /* Functions of a general utility nature. */
@@ -7556,7 +7564,12 @@ void init_char(struct char_data *ch)
     GET_REAL_RACE(ch) = RACE_UNDEFINED;
 
   if ((i = get_ptable_by_name(GET_NAME(ch))) != -1)
+  {
+    long old_id = player_table[i].id;
+
     player_table[i].id = GET_IDNUM(ch) = ++top_idnum;
+    player_index_id_changed(i, old_id);
+  }
   else
     log("SYSERR: init_char: Character '%s' not found in player table.", GET_NAME(ch));
 
@@ -8084,6 +8097,8 @@ static void load_default_config(void)
   CONFIG_USE_INTRO_SYSTEM = use_introduction_system;
   CONFIG_PERK_SYSTEM = perk_system;
   CONFIG_DEBUG_MODE = debug_mode;
+  CONFIG_MOB_ACTIVE_RING = mob_active_ring;
+  CONFIG_MOB_DORMANT_CADENCE = mob_dormant_cadence;
 
   /* Rent / crashsave options. */
   CONFIG_FREE_RENT = free_rent;
@@ -8418,6 +8433,10 @@ void load_config(void)
         CONFIG_MEDIT_ADVANCED = num;
       else if (!str_cmp(tag, "min_pop_to_claim"))
         CONFIG_MIN_POP_TO_CLAIM = fl_num;
+      else if (!str_cmp(tag, "mob_active_ring"))
+        CONFIG_MOB_ACTIVE_RING = num;
+      else if (!str_cmp(tag, "mob_dormant_cadence"))
+        CONFIG_MOB_DORMANT_CADENCE = num;
       else if (!str_cmp(tag, "mob_warriors_hp"))
         CONFIG_MOB_WARRIORS_HP = num;
       else if (!str_cmp(tag, "mob_warriors_ac"))
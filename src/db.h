@@ -224,6 +224,10 @@ struct zone_data
   int reset_state;    /* 0 = normal, 1 = resetting */
   time_t reset_start; /* When reset started (for timeout detection) */
 
+  /* Players and possessed mobiles in the zone, see zone_presence.h */
+  struct char_data *presence;
+  int presence_count;
+
   /* Reset mode:
     *   0: Don't reset, and don't update age.
     *   1: Reset if no PC's are located in zone.
@@ -329,6 +333,11 @@ void Crash_rentsave(struct char_data *ch, int cost);
 obj_save_data *objsave_parse_objects(FILE *fl);
 obj_save_data *objsave_parse_objects_db(char *name, room_vnum house_vnum);
 int objsave_save_obj_record(struct obj_data *obj, struct char_data *ch, FILE *fl, int location);
+/* Hash of what a save would write for a list of objects, to skip unchanged saves. */
+#define OBJSAVE_HASH_SEED UINT64_C(1469598103934665603)
+uint64_t objsave_hash_bytes(uint64_t hash, const void *data, size_t size);
+uint64_t objsave_hash_string(uint64_t hash, const char *text);
+uint64_t objsave_hash_objects(uint64_t hash, const struct obj_data *obj);
 int objsave_save_obj_record_db(struct obj_data *obj, struct char_data *ch, room_vnum house_vnum,
                                FILE *fl, int location);
 #ifdef LUMINARI_CUTEST
@@ -347,7 +356,15 @@ int load_char(const char *name, struct char_data *ch);
 bool save_char_checked(struct char_data *ch, int mode);
 bool update_player_last_on_single(struct char_data *ch);
 
-/** Result-discarding wrapper over save_char_checked(), for legacy callers. */
+/**
+ * Snapshot a player file and leave the write to the persistence writer.
+ *
+ * Returns FALSE only if the snapshot could not be taken.  A write that fails
+ * later is logged and flags the player PLR_CRASH, so the crash saver retries.
+ */
+bool save_char_async(struct char_data *ch, int mode);
+
+/** Result-discarding save_char_async(), for legacy callers. */
 void save_char(struct char_data *ch, int mode);
 void init_char(struct char_data *ch);
 struct char_data *create_char(void);
@@ -361,11 +378,24 @@ const char *player_file_account_name(const struct char_data *ch);
 #ifdef LUMINARI_CUTEST
 bool apply_clone_owner_identity_for_test(struct char_data *mob, const char *owner_name);
 #endif
+/* Queues the index for the persistence writer; the checked form waits for it. */
 void save_player_index(void);
 bool save_player_index_checked(void);
 long get_ptable_by_name(const char *name);
+void remove_player_from_index(int pos);
 bool remove_player(int pfilepos);
 
+/*
+ * Name and idnum hashes over player_table behind get_ptable_by_name(),
+ * get_id_by_name() and get_name_by_id().  Code that changes an entry's name
+ * or id in place reports it with the old value; code that moves entries
+ * about rebuilds.  The validator returns the number of problems it logged.
+ */
+void player_index_name_changed(int pos, const char *old_name);
+void player_index_id_changed(int pos, long old_id);
+void player_index_rebuild(void);
+int player_index_validate(void);
+
 /*
  * Two-phase removal used by character-creation restart. Preparing moves all
  * player-owned files out of their live paths and durably removes the index
@@ -393,6 +423,7 @@ void autoproc_registry_reset_for_test(void);
 void clear_object(struct obj_data *obj);
 void free_obj(struct obj_data *obj);
 void free_obj_special_abilities(struct obj_special_ability *list);
+void apply_object_load_rules(struct obj_data *obj);
 struct obj_data *read_object(obj_vnum nr, int type);
 struct obj_data *read_object_reason(obj_vnum nr, int type, enum perf_entity_reason reason);
 int vnum_object(char *searchname, struct char_data *ch);
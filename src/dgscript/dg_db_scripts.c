@@ -72,6 +72,7 @@ void parse_trigger(FILE *trig_f, int nr)
     cle = cle->next;
     cle->cmd = strdup(s);
   }
+  dg_compile_cmdlist(trig->cmdlist);
 
   free(cmds);
 
@@ -28,6 +28,7 @@
 #include "mud_event.h"
 #include "perfmon.h"
 #include <limits.h> /* For LONG_MAX used in overflow checks */
+#include <stddef.h> /* For max_align_t used by the event pools */
 
 /***************************************************************************
  * Begin mud specific event queue functions
@@ -42,6 +43,39 @@ static int total_events = 0;
 /** New events created by callbacks during the current event_process() call. */
 static uint64_t events_created_during_process = 0;
 
+/** Number of objects carved out of each pool chunk. */
+#define EVENT_POOL_CHUNK_OBJECTS 1024
+
+/** Header of one pooled allocation block. Objects follow the header. */
+struct event_pool_chunk
+{
+  struct event_pool_chunk *next; /**< Next block owned by the same pool. */
+  max_align_t align;             /**< Keeps the objects after the header aligned. */
+};
+
+/** Fixed-size object pool. Freed objects are threaded onto free_list through
+ * their first pointer-sized bytes and reused before a new block is allocated.
+ *
+ * BEGINNERS NOTE: Events are created and destroyed constantly (every combat
+ * round, affect tick and cooldown). Reusing a handful of large blocks instead
+ * of calling calloc()/free() for every event keeps the allocator out of the
+ * hot path and keeps related events close together in memory. */
+struct event_pool
+{
+  size_t object_size;             /**< Size of each pooled object. */
+  void *free_list;                /**< Objects ready for reuse. */
+  struct event_pool_chunk *chunks; /**< Every block allocated for this pool. */
+};
+
+/** Pool backing every struct event. */
+static struct event_pool event_pool = {sizeof(struct event), NULL, NULL};
+/** Pool backing every struct q_element. */
+static struct event_pool q_element_pool = {sizeof(struct q_element), NULL, NULL};
+
+static void *event_pool_alloc(struct event_pool *pool);
+static void event_pool_release(struct event_pool *pool, void *object);
+static void event_pool_destroy(struct event_pool *pool);
+
 #if defined(LUMINARI_CUTEST)
 static int event_init_calls = 0;
 static int event_free_all_calls = 0;
@@ -146,7 +180,7 @@ struct event *event_create_named_with_cleanup(EVENTFUNC(*func), void *event_obj,
     target_time = when + (long)pulse;
   }
 
-  CREATE(new_event, struct event, 1);
+  new_event = (struct event *)event_pool_alloc(&event_pool);
   new_event->func = func;
   new_event->event_obj = event_obj;
   new_event->q_el = queue_enq(event_q, new_event, target_time);
@@ -223,7 +257,7 @@ void event_cancel(struct event *event)
   if (event->event_obj)
     cleanup_event_obj(event);
 
-  free(event);
+  event_pool_release(&event_pool, event);
 
   /* Decrement event counter since we freed an event */
   total_events--;
@@ -310,6 +344,11 @@ void event_process(void)
   events_created_during_process = 0;
   processing_events = 1;
 
+  /* Move every event due at or before this pulse onto the ready list. Events
+   * created by callbacks below are always scheduled at least one pulse ahead,
+   * so they never join the current pass. */
+  queue_advance(event_q, pulse);
+
   while ((long)pulse >= queue_key(event_q))
   {
     if (!(the_event = (struct event *)queue_head(event_q)))
@@ -341,7 +380,7 @@ void event_process(void)
       /* Clean up the broken event */
       if (the_event->event_obj != NULL)
         cleanup_event_obj(the_event);
-      free(the_event);
+      event_pool_release(&event_pool, the_event);
 
       /* Decrement event counter since we freed a broken event */
       total_events--;
@@ -389,7 +428,7 @@ void event_process(void)
         free_mud_event((struct mud_event_data *)the_event->event_obj);
 
       /* It is assumed that the_event will already have freed ->event_obj. */
-      free(the_event);
+      event_pool_release(&event_pool, the_event);
 
       /* Decrement event counter since we freed an event */
       total_events--;
@@ -452,6 +491,11 @@ void event_free_all(void)
 
   queue_free(event_q);
   event_q = NULL;
+
+  /* Every event and queue element has been returned, so the pool blocks
+   * themselves can go back to the system. */
+  event_pool_destroy(&event_pool);
+  event_pool_destroy(&q_element_pool);
 }
 
 #if defined(LUMINARI_CUTEST)
@@ -490,24 +534,261 @@ int event_is_queued(struct event *event)
  * End mud specific event queue functions
  **************************************************************************/
 
+/***************************************************************************
+ * Begin event object pools
+ **************************************************************************/
+/** Returns a zeroed object from pool, growing the pool by one block when it
+ * has nothing left to reuse.
+ * @param pool The pool to allocate from.
+ * @retval void * The zeroed object. Never NULL; allocation failure aborts
+ * like CREATE(). */
+static void *event_pool_alloc(struct event_pool *pool)
+{
+  struct event_pool_chunk *chunk = NULL;
+  char *object = NULL;
+  size_t header_size = sizeof(struct event_pool_chunk);
+  int i = 0;
+
+  if (!pool->free_list)
+  {
+    chunk = (struct event_pool_chunk *)malloc(header_size +
+                                              pool->object_size * EVENT_POOL_CHUNK_OBJECTS);
+    if (!chunk)
+    {
+      perror("SYSERR: malloc failure");
+      abort();
+    }
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    /* Thread the new block onto the free list, last object first, so objects
+     * are handed out in address order. */
+    object = (char *)chunk + header_size;
+    for (i = EVENT_POOL_CHUNK_OBJECTS - 1; i >= 0; i--)
+    {
+      *(void **)(object + (size_t)i * pool->object_size) = pool->free_list;
+      pool->free_list = object + (size_t)i * pool->object_size;
+    }
+  }
+
+  object = (char *)pool->free_list;
+  pool->free_list = *(void **)object;
+  memset(object, 0, pool->object_size);
+  return object;
+}
+
+/** Returns object to pool for reuse.
+ * @param pool The pool object was allocated from.
+ * @param object The object to release. NULL is ignored. */
+static void event_pool_release(struct event_pool *pool, void *object)
+{
+  if (!object)
+    return;
+
+  *(void **)object = pool->free_list;
+  pool->free_list = object;
+}
+
+/** Frees every block owned by pool.
+ * @pre No object allocated from pool is still in use. */
+static void event_pool_destroy(struct event_pool *pool)
+{
+  struct event_pool_chunk *chunk = NULL, *next_chunk = NULL;
+
+  for (chunk = pool->chunks; chunk; chunk = next_chunk)
+  {
+    next_chunk = chunk->next;
+    free(chunk);
+  }
+
+  pool->chunks = NULL;
+  pool->free_list = NULL;
+}
+/***************************************************************************
+ * End event object pools
+ **************************************************************************/
+
 /***************************************************************************
  * Begin generic (abstract) priority queue functions
  **************************************************************************/
+/** Appends qe to the end of slot. */
+static void q_slot_append(struct q_slot *slot, struct q_element *qe)
+{
+  qe->slot = slot;
+  qe->next = NULL;
+  qe->prev = slot->tail;
+
+  if (slot->tail)
+    slot->tail->next = qe;
+  else
+    slot->head = qe;
+
+  slot->tail = qe;
+}
+
+/** Unlinks qe from whichever slot currently holds it. */
+static void q_slot_unlink(struct q_element *qe)
+{
+  struct q_slot *slot = qe->slot;
+
+  if (qe->prev == NULL)
+    slot->head = qe->next;
+  else
+    qe->prev->next = qe->next;
+
+  if (qe->next == NULL)
+    slot->tail = qe->prev;
+  else
+    qe->next->prev = qe->prev;
+
+  qe->prev = NULL;
+  qe->next = NULL;
+  qe->slot = NULL;
+}
+
+/** Files an element that is not linked anywhere into the wheel level, the
+ * overflow list or the ready list that matches its key.
+ *
+ * BEGINNERS NOTE: The level is chosen from how far away the event is. An
+ * event less than 256 pulses away goes to level 0, less than 65536 pulses
+ * away to level 1, and so on. Within the level, the slot is taken straight
+ * from the matching bits of the due pulse, which is why no searching is
+ * needed. */
+static void q_place(struct dg_queue *q, struct q_element *qe)
+{
+  unsigned long key = (unsigned long)qe->key;
+  unsigned long delta;
+  int level = 0;
+  int slot = 0;
+
+  if (qe->key < 0 || key <= q->now)
+  {
+    /* Already due: it fires on the next pass of event_process(). */
+    qe->level = -1;
+    q_slot_append(&q->ready, qe);
+    return;
+  }
+
+  delta = key - q->now;
+  for (level = 0; level < EVENT_WHEEL_LEVELS; level++)
+  {
+    if ((level + 1) * EVENT_WHEEL_BITS >= (int)(sizeof(unsigned long) * CHAR_BIT) ||
+        delta < (1UL << ((level + 1) * EVENT_WHEEL_BITS)))
+      break;
+  }
+
+  if (level >= EVENT_WHEEL_LEVELS)
+  {
+    qe->level = EVENT_WHEEL_LEVELS;
+    q->overflow_count++;
+    q_slot_append(&q->overflow, qe);
+    return;
+  }
+
+  slot = (int)((key >> (level * EVENT_WHEEL_BITS)) & (EVENT_WHEEL_SIZE - 1));
+  qe->level = level;
+  q->level_count[level]++;
+  q_slot_append(&q->wheel[level][slot], qe);
+}
+
+/** Unlinks qe and keeps the per-level element counts in step. */
+static void q_remove(struct dg_queue *q, struct q_element *qe)
+{
+  if (qe->level >= 0 && qe->level < EVENT_WHEEL_LEVELS)
+    q->level_count[qe->level]--;
+  else if (qe->level == EVENT_WHEEL_LEVELS)
+    q->overflow_count--;
+
+  q_slot_unlink(qe);
+}
+
+/** Re-files every element of slot against the current wheel time. */
+static void q_cascade(struct dg_queue *q, struct q_slot *slot)
+{
+  struct q_element *qe = NULL;
+
+  while ((qe = slot->head) != NULL)
+  {
+    q_remove(q, qe);
+    q_place(q, qe);
+  }
+}
+
+/** Moves the wheel forward by exactly one pulse, cascading any higher level
+ * slot whose turn has come and moving level 0's current slot to the ready
+ * list. */
+static void q_tick(struct dg_queue *q)
+{
+  int level = 0;
+  int top = 0;
+
+  q->now++;
+
+  /* Find the highest level whose boundary this pulse crosses. */
+  for (level = 1; level <= EVENT_WHEEL_LEVELS; level++)
+  {
+    if (level * EVENT_WHEEL_BITS >= (int)(sizeof(unsigned long) * CHAR_BIT) ||
+        (q->now & ((1UL << (level * EVENT_WHEEL_BITS)) - 1)) != 0)
+      break;
+    top = level;
+  }
+
+  /* Cascade from the top down so elements can drop several levels at once. */
+  if (top == EVENT_WHEEL_LEVELS)
+  {
+    q_cascade(q, &q->overflow);
+    top--;
+  }
+  for (level = top; level >= 1; level--)
+    q_cascade(q, &q->wheel[level][(q->now >> (level * EVENT_WHEEL_BITS)) &
+                                   (EVENT_WHEEL_SIZE - 1)]);
+
+  q_cascade(q, &q->wheel[0][q->now & (EVENT_WHEEL_SIZE - 1)]);
+}
+
+/** Re-files every queued element after the game pulse moved backwards.
+ * Only happens when tests or copyover reset the pulse counter. */
+static void q_rebase(struct dg_queue *q, unsigned long now)
+{
+  struct q_slot pending = {NULL, NULL};
+  struct q_element *qe = NULL;
+  int level = 0, slot = 0;
+
+  while ((qe = q->ready.head) != NULL)
+  {
+    q_remove(q, qe);
+    q_slot_append(&pending, qe);
+  }
+  for (level = 0; level < EVENT_WHEEL_LEVELS; level++)
+    for (slot = 0; slot < EVENT_WHEEL_SIZE && q->level_count[level] > 0; slot++)
+      while ((qe = q->wheel[level][slot].head) != NULL)
+      {
+        q_remove(q, qe);
+        q_slot_append(&pending, qe);
+      }
+  while ((qe = q->overflow.head) != NULL)
+  {
+    q_remove(q, qe);
+    q_slot_append(&pending, qe);
+  }
+
+  q->now = now;
+  while ((qe = pending.head) != NULL)
+  {
+    q_slot_unlink(qe);
+    q_place(q, qe);
+  }
+}
+
 /** Create a new, empty, priority queue and return it.
  * @retval dg_queue * Pointer to the newly created queue structure. */
 struct dg_queue *queue_init(void)
 {
   struct dg_queue *q = NULL;
-  int i;
 
+  /* CREATE() zeroes every slot, count and the ready list. */
   CREATE(q, struct dg_queue, 1);
-
-  /* Initialize all head and tail pointers to NULL to prevent valgrind warnings */
-  for (i = 0; i < NUM_EVENT_QUEUES; i++)
-  {
-    q->head[i] = NULL;
-    q->tail[i] = NULL;
-  }
+  q->now = pulse;
 
   return q;
 }
@@ -524,8 +805,7 @@ struct dg_queue *queue_init(void)
  * the data. */
 struct q_element *queue_enq(struct dg_queue *q, void *data, long key)
 {
-  struct q_element *qe = NULL, *i = NULL;
-  int bucket = 0;
+  struct q_element *qe = NULL;
 
   /* Safety check for NULL queue */
   if (!q)
@@ -534,57 +814,11 @@ struct q_element *queue_enq(struct dg_queue *q, void *data, long key)
     return NULL;
   }
 
-  CREATE(qe, struct q_element, 1);
+  qe = (struct q_element *)event_pool_alloc(&q_element_pool);
   qe->data = data;
   qe->key = key;
-  qe->prev = NULL; /* Explicitly initialize to prevent valgrind warnings */
-  qe->next = NULL; /* Explicitly initialize to prevent valgrind warnings */
-
-  /* BUCKETING STRATEGY EXPLAINED FOR BEGINNERS:
-   *
-   * We use the modulo operator (%) to distribute events across buckets.
-   * For example, if NUM_EVENT_QUEUES is 10:
-   * - Event at pulse 103 goes in bucket 3 (103 % 10 = 3)
-   * - Event at pulse 217 goes in bucket 7 (217 % 10 = 7)
-   * - Event at pulse 1000 goes in bucket 0 (1000 % 10 = 0)
-   *
-   * This distributes events evenly and reduces the time needed to find
-   * the right insertion point, since we only search within one bucket. */
-  bucket = key % NUM_EVENT_QUEUES; /* which queue does this go in */
-
-  if (!q->head[bucket])
-  { /* queue is empty */
-    q->head[bucket] = qe;
-    q->tail[bucket] = qe;
-  }
-
-  else
-  {
-    for (i = q->tail[bucket]; i; i = i->prev)
-    {
-      if (i->key < key)
-      { /* found insertion point */
-        if (i == q->tail[bucket])
-          q->tail[bucket] = qe;
-        else
-        {
-          qe->next = i->next;
-          i->next->prev = qe;
-        }
-
-        qe->prev = i;
-        i->next = qe;
-        break;
-      }
-    }
 
-    if (i == NULL)
-    { /* insertion point is front of list */
-      qe->next = q->head[bucket];
-      q->head[bucket] = qe;
-      qe->next->prev = qe;
-    }
-  }
+  q_place(q, qe);
 
   return qe;
 }
@@ -597,8 +831,6 @@ struct q_element *queue_enq(struct dg_queue *q, void *data, long key)
  */
 void queue_deq(struct dg_queue *q, struct q_element *qe)
 {
-  int i = 0;
-
   /* CRITICAL SAFETY CHECK:
    * Replace assert with proper NULL check for production safety.
    * Assert only works in debug builds - in production (with NDEBUG),
@@ -621,65 +853,103 @@ void queue_deq(struct dg_queue *q, struct q_element *qe)
     return;
   }
 
-  i = qe->key % NUM_EVENT_QUEUES;
+  /* Every element knows the slot it lives in, so removal is constant time
+   * no matter how many other events are queued. */
+  q_remove(q, qe);
+  event_pool_release(&q_element_pool, qe);
+}
 
-  if (qe->prev == NULL)
-    q->head[i] = qe->next;
-  else
-    qe->prev->next = qe->next;
+/** Advances the wheel to pulse now, moving every element due at or before
+ * now onto the ready list in firing order.
+ * @param q The queue to advance.
+ * @param now The pulse to advance to, normally the current game pulse. */
+void queue_advance(struct dg_queue *q, unsigned long now)
+{
+  unsigned long span;
+  unsigned long boundary;
+  int empty_levels = 0;
+  int bits = 0;
 
-  if (qe->next == NULL)
-    q->tail[i] = qe->prev;
-  else
-    qe->next->prev = qe->prev;
+  if (!q)
+    return;
+
+  if (now < q->now)
+  {
+    q_rebase(q, now);
+    return;
+  }
+
+  while (q->now < now)
+  {
+    /* Count the empty levels from the bottom. Nothing can come due before the
+     * next boundary of the first occupied level, so the wheel may jump
+     * straight there instead of ticking through empty slots. */
+    for (empty_levels = 0; empty_levels < EVENT_WHEEL_LEVELS; empty_levels++)
+      if (q->level_count[empty_levels] > 0)
+        break;
+    if (empty_levels == EVENT_WHEEL_LEVELS && q->overflow_count == 0)
+    {
+      q->now = now;
+      break;
+    }
+
+    if (empty_levels > 0)
+    {
+      bits = empty_levels * EVENT_WHEEL_BITS;
+      if (bits >= (int)(sizeof(unsigned long) * CHAR_BIT))
+      {
+        q->now = now;
+        break;
+      }
+      span = (1UL << bits) - 1;
+      boundary = (q->now | span) + 1;
+      if (boundary == 0 || boundary > now)
+      {
+        q->now = now;
+        break;
+      }
+      q->now = boundary - 1;
+    }
 
-  free(qe);
+    q_tick(q);
+  }
 }
 
-/** Removes and returns the data of the first element of the priority queue q.
- * @pre pulse must be defined. This is a multi-headed queue, the current
- * head is determined by the current pulse.
- * @post the q->head is dequeued.
+/** Removes and returns the data of the first element of the ready list.
+ * @pre queue_advance() has moved every due element onto the ready list.
+ * @post the head of the ready list is dequeued.
  * @param q The queue to return the head of.
  * @retval void * NULL if there is not a currently available head, pointer
  * to any data object associated with the queue element. */
 void *queue_head(struct dg_queue *q)
 {
   void *dg_data = NULL;
-  int i = 0;
 
   /* Safety check for NULL queue */
   if (!q)
     return NULL;
 
-  i = pulse % NUM_EVENT_QUEUES;
-
-  if (!q->head[i])
+  if (!q->ready.head)
     return NULL;
 
-  dg_data = q->head[i]->data;
-  queue_deq(q, q->head[i]);
+  dg_data = q->ready.head->data;
+  queue_deq(q, q->ready.head);
   return dg_data;
 }
 
-/** Returns the key of the head element of the priority queue.
- * @pre pulse must be defined. This is a multi-headed queue, the current
- * head is determined by the current pulse.
+/** Returns the key of the head element of the ready list.
+ * @pre queue_advance() has moved every due element onto the ready list.
  * @param q Queue to check for.
  * @retval long Return the key element of the head q_element. If no head
  * q_element is available, return LONG_MAX. */
 long queue_key(struct dg_queue *q)
 {
-  int i = 0;
-
   /* Safety check for NULL queue */
   if (!q)
     return LONG_MAX;
 
-  i = pulse % NUM_EVENT_QUEUES;
-
-  if (q->head[i])
-    return q->head[i]->key;
+  if (q->ready.head)
+    return q->ready.head->key;
   else
     return LONG_MAX;
 }
@@ -702,13 +972,62 @@ long queue_elmt_key(struct q_element *qe)
   return qe->key;
 }
 
+/** Frees the event held by one queue element during queue_free(). */
+static void queue_free_element(struct q_element *qe)
+{
+  struct event *event = NULL;
+
+  /* Extract the event from this queue element */
+  if ((event = (struct event *)qe->data) != NULL)
+  {
+    /* DOUBLE-FREE PREVENTION CHECK:
+     * If q_el is NULL, this event might be currently processing.
+     * However, since queue_free() should NEVER be called during
+     * event_process(), we log an error if we detect this situation. */
+    if (!event->q_el)
+    {
+      log("SYSERR: queue_free() found event with NULL q_el - possible concurrent processing!");
+      /* Continue anyway as we're likely shutting down */
+    }
+
+    /* Free any associated data with this event */
+    if (event->event_obj)
+      cleanup_event_obj(event);
+
+    /* Free the event structure itself */
+    event_pool_release(&event_pool, event);
+
+    /* Decrement event counter since we freed an event during shutdown */
+    total_events--;
+  }
+  /* Free the queue element that held this event */
+  event_pool_release(&q_element_pool, qe);
+}
+
+/** Frees every element linked into slot. */
+static void queue_free_slot(struct q_slot *slot)
+{
+  struct q_element *qe = NULL, *next_qe = NULL;
+
+  for (qe = slot->head; qe; qe = next_qe)
+  {
+    /* Save the next pointer BEFORE freeing current element
+     * (once freed, qe->next would be invalid memory!) */
+    next_qe = qe->next;
+    queue_free_element(qe);
+  }
+
+  slot->head = NULL;
+  slot->tail = NULL;
+}
+
 /** Free q and all contents.
  * @pre Function requires definition of struct event.
  * @post All items associated with q, including non-abstract data, are freed.
  * @param q The priority queue to free.
  *
  * CRITICAL WARNING FOR BEGINNERS:
- * This function frees ALL events in ALL queue buckets. It should NEVER be
+ * This function frees ALL events in ALL wheel slots. It should NEVER be
  * called while event_process() is running, as that would cause double-free
  * crashes when event_process() tries to access already-freed memory.
  *
@@ -717,9 +1036,7 @@ long queue_elmt_key(struct q_element *qe)
  */
 void queue_free(struct dg_queue *q)
 {
-  int i = 0;
-  struct q_element *qe = NULL, *next_qe = NULL;
-  struct event *event = NULL;
+  int level = 0, slot = 0;
 
   /* Safety check for NULL queue */
   if (!q)
@@ -737,45 +1054,12 @@ void queue_free(struct dg_queue *q)
     return;
   }
 
-  /* IMPORTANT: We iterate through all queue buckets (0 to NUM_EVENT_QUEUES-1)
-   * Events are distributed across buckets based on their scheduled time
-   * to improve performance (reduces search time for insertion). */
-  for (i = 0; i < NUM_EVENT_QUEUES; i++)
-  {
-    /* Process each event in this bucket's linked list */
-    for (qe = q->head[i]; qe; qe = next_qe)
-    {
-      /* Save the next pointer BEFORE freeing current element
-       * (once freed, qe->next would be invalid memory!) */
-      next_qe = qe->next;
-
-      /* Extract the event from this queue element */
-      if ((event = (struct event *)qe->data) != NULL)
-      {
-        /* DOUBLE-FREE PREVENTION CHECK:
-         * If q_el is NULL, this event might be currently processing.
-         * However, since queue_free() should NEVER be called during
-         * event_process(), we log an error if we detect this situation. */
-        if (!event->q_el)
-        {
-          log("SYSERR: queue_free() found event with NULL q_el - possible concurrent processing!");
-          /* Continue anyway as we're likely shutting down */
-        }
-
-        /* Free any associated data with this event */
-        if (event->event_obj)
-          cleanup_event_obj(event);
-
-        /* Free the event structure itself */
-        free(event);
-
-        /* Decrement event counter since we freed an event during shutdown */
-        total_events--;
-      }
-      /* Free the queue element that held this event */
-      free(qe);
-    }
-  }
+  /* Events due now fire first, so release them first too. */
+  queue_free_slot(&q->ready);
+  for (level = 0; level < EVENT_WHEEL_LEVELS; level++)
+    for (slot = 0; slot < EVENT_WHEEL_SIZE; slot++)
+      queue_free_slot(&q->wheel[level][slot]);
+  queue_free_slot(&q->overflow);
 
   /* Finally, free the queue structure itself */
   free(q);
@@ -50,40 +50,50 @@ struct event
 /**************************************************************************
  * Begin priority queue structures and defines.
  **************************************************************************/
-/** Number of buckets available in each queue. Reduces enqueue cost.
+/** Bits of the scheduled pulse consumed by each timing wheel level. */
+#define EVENT_WHEEL_BITS 8
+/** Slots in each timing wheel level. */
+#define EVENT_WHEEL_SIZE (1 << EVENT_WHEEL_BITS)
+/** Number of timing wheel levels. Four levels of 256 slots cover 2^32 pulses
+ * (about 13 years of uptime); anything further out waits in an overflow list.
  *
  * TECHNICAL EXPLANATION FOR BEGINNERS:
- * Instead of having one giant queue for all events, we use multiple
- * smaller queues (buckets). Events are distributed across these buckets
- * based on their scheduled time (using modulo/remainder operation).
- *
- * WHY USE MULTIPLE BUCKETS?
- * - Faster insertion: Searching for the right position in a smaller list
- *   is faster than searching in one huge list.
- * - Better cache performance: Smaller lists fit better in CPU cache.
- * - Distributed processing: Each pulse only checks one bucket.
- *
- * The value 10 was chosen as a good balance between:
- * - Memory usage (more buckets = more memory)
- * - Performance (more buckets = smaller lists to search)
- * - Even distribution (10 divides evenly into many common timer values)
- */
-#define NUM_EVENT_QUEUES 10
+ * A timing wheel works like the hands of a clock. Level 0 has one slot per
+ * pulse for the next 256 pulses. Level 1 has one slot per 256 pulses, level 2
+ * one slot per 65536 pulses, and so on. Scheduling an event just picks the
+ * slot from the event's due pulse, so it never searches a list. When level 0
+ * wraps around, the next level 1 slot is "cascaded": its events are spread
+ * back out over level 0. Each event is cascaded at most once per level, so
+ * insert, cancel and firing are all constant time. */
+#define EVENT_WHEEL_LEVELS 4
 
 /** Maximum number of events allowed in the system at once.
  * This prevents resource exhaustion attacks where someone could
  * create millions of events and crash the server.
  *
- * BEGINNERS NOTE: This is a safety limit. Normal gameplay should
- * never reach this limit. If it does, either there's a bug creating
- * too many events, or this limit needs to be increased. */
-#define MAX_EVENTS 10000
+ * BEGINNERS NOTE: This is a safety limit. Busy servers carry tens of
+ * thousands of affect, combat and cooldown events at peak. If the limit is
+ * reached, either there's a bug creating too many events, or this limit
+ * needs to be increased. */
+#define MAX_EVENTS 100000
+
+/** One doubly-linked list of queued elements: a wheel slot, the overflow
+ * list, or the list of elements that are due now. */
+struct q_slot
+{
+  struct q_element *head; /**< First element in the slot. */
+  struct q_element *tail; /**< Last element in the slot. */
+};
 
-/** The priority queue. */
+/** The priority queue, implemented as a hierarchical timing wheel. */
 struct dg_queue
 {
-  struct q_element *head[NUM_EVENT_QUEUES]; /**< Front of each queue bucket. */
-  struct q_element *tail[NUM_EVENT_QUEUES]; /**< Rear of each queue bucket. */
+  struct q_slot wheel[EVENT_WHEEL_LEVELS][EVENT_WHEEL_SIZE]; /**< Timing wheel slots. */
+  int level_count[EVENT_WHEEL_LEVELS]; /**< Elements currently held by each level. */
+  struct q_slot overflow;              /**< Elements beyond the last wheel level. */
+  int overflow_count;                  /**< Elements held by the overflow list. */
+  struct q_slot ready;                 /**< Due elements, in firing order. */
+  unsigned long now;                   /**< Last pulse the wheel was advanced to. */
 };
 
 /** Queued elements. */
@@ -92,6 +102,8 @@ struct q_element
   void *data;                    /**< The event to be handled. */
   long key;                      /**< When the event should be handled. */
   struct q_element *prev, *next; /**< Points to other q_elements in line. */
+  struct q_slot *slot;           /**< The list this element is linked into. */
+  int level;                     /**< Wheel level holding the element, or -1. */
 };
 /**************************************************************************
  * End priority queue structures and defines.
@@ -117,6 +129,7 @@ int event_queue_depth(void);
 struct dg_queue *queue_init(void);
 struct q_element *queue_enq(struct dg_queue *q, void *data, long key);
 void queue_deq(struct dg_queue *q, struct q_element *qe);
+void queue_advance(struct dg_queue *q, unsigned long now);
 void *queue_head(struct dg_queue *q);
 long queue_key(struct dg_queue *q);
 long queue_elmt_key(struct q_element *qe);
@@ -1526,6 +1526,8 @@ ACMD(do_mdoor)
       break;
     }
   }
+
+  graph_exits_changed();
 }
 
 ACMD(do_mfollow)
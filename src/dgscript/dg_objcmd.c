@@ -18,6 +18,7 @@
 #include "handler.h"
 #include "db.h"
 #include "constants.h"
+#include "graph.h"
 #include "olc/genzon.h"   /* for access to real_zone_by_thing */
 #include "combat/fight.h" /* for die() */
 
@@ -786,6 +787,8 @@ static OCMD(do_odoor)
       break;
     }
   }
+
+  graph_exits_changed();
 }
 
 static OCMD(do_osetval)
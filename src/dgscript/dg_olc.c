@@ -436,6 +436,7 @@ void trigedit_save(struct descriptor_data *d)
       next_cmd = cmd->next;
       if (cmd->cmd)
         free(cmd->cmd);
+      free(cmd->tokens);
       free(cmd);
     }
 
@@ -464,6 +465,7 @@ void trigedit_save(struct descriptor_data *d)
     }
     else
       trig->cmdlist->cmd = strdup("* No Script");
+    dg_compile_cmdlist(trig->cmdlist);
 
     /* make the prorotype look like what we have */
     trig_data_copy(proto, trig);
@@ -540,6 +542,7 @@ void trigedit_save(struct descriptor_data *d)
     }
     else
       trig->cmdlist->cmd = strdup("* No Script");
+    dg_compile_cmdlist(trig->cmdlist);
 
     for (i = 0; i < top_of_trigt; i++)
     {
@@ -49,7 +49,8 @@ static void eval_expr(char *line, char *result, void *go, struct script_data *sc
                       int type);
 static int eval_lhs_op_rhs(char *expr, char *result, void *go, struct script_data *sc,
                            trig_data *trig, int type);
-static int process_if(char *cond, void *go, struct script_data *sc, trig_data *trig, int type);
+static int process_if(struct cmdlist_element *cl, char *cond, void *go, struct script_data *sc,
+                      trig_data *trig, int type);
 static struct cmdlist_element *find_end(trig_data *trig, struct cmdlist_element *cl);
 static struct cmdlist_element *find_else_end(trig_data *trig, struct cmdlist_element *cl, void *go,
                                              struct script_data *sc, int type);
@@ -1650,28 +1651,22 @@ static void eval_expr(char *line, char *result, void *go, struct script_data *sc
   }
 }
 
-/* Evaluates expr if it is in the form lhs op rhs, and copies answer in result.
- * Returns 1 if expr is evaluated, else 0. */
-static int eval_lhs_op_rhs(char *expr, char *result, void *go, struct script_data *sc,
-                           trig_data *trig, int type)
+/*
+ * valid operands, in order of priority
+ * each must also be defined in eval_op()
+ */
+static const char *const dg_expr_ops[] = {"||", "&&", "==", "!=", "<=", ">=", "<", ">",
+                                          "/=", "-",  "+",  "/",  "*",  "!",  "\n"};
+
+/* Cuts line, a copy of an expression, at the operator it is evaluated
+ * around and returns the start of the right-hand side, with the operator's
+ * place in dg_expr_ops[] in *op.  Returns NULL if line has no operator. */
+static char *split_lhs_op_rhs(char *line, int *op)
 {
-  char *p = NULL;
+  char *p = line;
   char *tokens[MAX_INPUT_LENGTH] = {NULL};
-  char line[MAX_INPUT_LENGTH] = {'\0'};
-  char lhr[MAX_INPUT_LENGTH] = {'\0'};
-  char rhr[MAX_INPUT_LENGTH] = {'\0'};
   int i = 0, j = 0;
 
-  /*
-   * valid operands, in order of priority
-   * each must also be defined in eval_op()
-   */
-  const char *const ops[] = {"||", "&&", "==", "!=", "<=", ">=", "<", ">",
-                             "/=", "-",  "+",  "/",  "*",  "!",  "\n"};
-
-  strlcpy(line, expr, sizeof(line));
-  p = line;
-
   /* Initialize tokens, an array of pointers to locations in line where the
    * ops could possibly occur. */
   for (j = 0; *p; j++)
@@ -1689,29 +1684,82 @@ static int eval_lhs_op_rhs(char *expr, char *result, void *go, struct script_dat
   }
   tokens[j] = NULL;
 
-  for (i = 0; *ops[i] != '\n'; i++)
+  for (i = 0; *dg_expr_ops[i] != '\n'; i++)
     for (j = 0; tokens[j]; j++)
-      if (!strn_cmp(ops[i], tokens[j], strlen(ops[i])))
+      if (!strn_cmp(dg_expr_ops[i], tokens[j], strlen(dg_expr_ops[i])))
       {
         *tokens[j] = '\0';
-        p = tokens[j] + strlen(ops[i]);
+        *op = i;
+        return tokens[j] + strlen(dg_expr_ops[i]);
+      }
 
-        eval_expr(line, lhr, go, sc, trig, type);
-        eval_expr(p, rhr, go, sc, trig, type);
-        eval_op(ops[i], lhr, rhr, result, go, sc, trig);
+  return NULL;
+}
 
-        return 1;
-      }
+/* Evaluates expr if it is in the form lhs op rhs, and copies answer in result.
+ * Returns 1 if expr is evaluated, else 0. */
+static int eval_lhs_op_rhs(char *expr, char *result, void *go, struct script_data *sc,
+                           trig_data *trig, int type)
+{
+  char *p = NULL;
+  char line[MAX_INPUT_LENGTH] = {'\0'};
+  char lhr[MAX_INPUT_LENGTH] = {'\0'};
+  char rhr[MAX_INPUT_LENGTH] = {'\0'};
+  int op = 0;
 
-  return 0;
+  strlcpy(line, expr, sizeof(line));
+  if (!(p = split_lhs_op_rhs(line, &op)))
+    return 0;
+
+  eval_expr(line, lhr, go, sc, trig, type);
+  eval_expr(p, rhr, go, sc, trig, type);
+  eval_op(dg_expr_ops[op], lhr, rhr, result, go, sc, trig);
+
+  return 1;
 }
 
-/* returns 1 if cond is true, else 0 */
-static int process_if(char *cond, void *go, struct script_data *sc, trig_data *trig, int type)
+/* The most values a compiled condition holds at once; deeper ones are read
+ * from their text. */
+#define DG_EXPR_STACK 16
+
+/* eval_expr() over a condition dg_compile_cmdlist() has already split up. */
+static void eval_tokens(const struct dg_token *token, int count, char *result, void *go,
+                        struct script_data *sc, trig_data *trig, int type)
+{
+  char stack[DG_EXPR_STACK][MAX_INPUT_LENGTH], value[MAX_INPUT_LENGTH];
+  int depth = 0;
+
+  while (count > 0)
+  {
+    if (token->type == DG_TOKEN_LEAF)
+    {
+      var_subst_tokens(go, sc, trig, type, token + 1, token->value, stack[depth++]);
+      count -= token->value + 1;
+      token += token->value + 1;
+    }
+    else
+    {
+      depth--;
+      eval_op(dg_expr_ops[token->value], stack[depth - 1], stack[depth], value, go, sc, trig);
+      strlcpy(stack[depth - 1], value, sizeof(stack[depth - 1]));
+      count--;
+      token++;
+    }
+  }
+
+  strlcpy(result, stack[0], MAX_INPUT_LENGTH);
+}
+
+/* returns 1 if cond, the condition on line cl, is true, else 0 */
+static int process_if(struct cmdlist_element *cl, char *cond, void *go, struct script_data *sc,
+                      trig_data *trig, int type)
 {
   char result[MAX_INPUT_LENGTH] = {'\0'}, *p = NULL;
 
-  eval_expr(cond, result, go, sc, trig, type);
+  if (!dg_scripts_from_text && cl->tokens)
+    eval_tokens(cl->tokens, cl->token_count, result, go, sc, trig, type);
+  else
+    eval_expr(cond, result, go, sc, trig, type);
 
   p = result;
   skip_spaces(&p);
@@ -1722,39 +1770,346 @@ static int process_if(char *cond, void *go, struct script_data *sc, trig_data *t
     return 1;
 }
 
-/* Scans for end of if-block.  returns the line containg 'end', or the last
- * line of the trigger if not found. */
+/* The compiled form of a command list.  Each line's leading keyword is
+ * classified once into DG_LINE_* flags, and the block scans below keep
+ * where an if, while or switch block ends, so running a trigger no longer
+ * re-reads the text of every line it passes or skips.  The scans are the
+ * same loops they always were, asking the flags instead of the text; an if
+ * scan that had to log about a broken script is not kept, so it logs again
+ * on every pass as it used to.  Each command line is also split into its
+ * text and %variables%, and each condition into postfix operators and the
+ * operands between them, as var_subst() and eval_expr() would find them. */
+
+bool dg_scripts_from_text = FALSE;
+
+static char *dg_line_body(char *cmd)
+{
+  while (*cmd && isspace(*cmd))
+    cmd++;
+  return cmd;
+}
+
+static int dg_line_flags(const char *p)
+{
+  int flags = DG_LINE_COMPILED;
+
+  if (*p == '*')
+    flags |= DG_LINE_COMMENT;
+  if (!strn_cmp("if ", p, 3))
+    flags |= DG_LINE_IF;
+  if (!strn_cmp("elseif ", p, 7))
+    flags |= DG_LINE_ELSEIF;
+  if (!strn_cmp("else", p, 4))
+    flags |= DG_LINE_ELSE;
+  if (!strn_cmp("while ", p, 6))
+    flags |= DG_LINE_WHILE;
+  if (!strn_cmp("switch ", p, 7))
+    flags |= DG_LINE_SWITCH;
+  if (!strn_cmp("switch", p, 6))
+    flags |= DG_LINE_SWITCH_ANY;
+  if (!strn_cmp("end", p, 3))
+    flags |= DG_LINE_END;
+  if (!strn_cmp("done", p, 4))
+    flags |= DG_LINE_DONE;
+  if (!strn_cmp("don", p, 3))
+    flags |= DG_LINE_DON;
+  if (!strn_cmp("break", p, 5))
+    flags |= DG_LINE_BREAK;
+  if (!strn_cmp("case", p, 4))
+    flags |= DG_LINE_CASE;
+  if (!strn_cmp("case ", p, 5))
+    flags |= DG_LINE_CASE_ARG;
+  if (!strn_cmp("default", p, 7))
+    flags |= DG_LINE_DEFAULT;
+  return flags;
+}
+
+/* Whether line c starts with any of the given DG_LINE_* keywords. */
+static bool dg_line_is(struct cmdlist_element *c, int keywords)
+{
+  if (dg_scripts_from_text)
+    return (dg_line_flags(dg_line_body(c->cmd)) & keywords) != 0;
+  return (c->flags & keywords) != 0;
+}
+
+static char *dg_line_start(struct cmdlist_element *c)
+{
+  return dg_scripts_from_text ? dg_line_body(c->cmd) : c->body;
+}
+
+#define DG_PROGRAM_TOKENS (2 * MAX_INPUT_LENGTH)
+
+/* One line's tokens while it is being compiled. */
+struct dg_program
+{
+  struct dg_token token[DG_PROGRAM_TOKENS];
+  int count;
+  char text[2 * MAX_INPUT_LENGTH];
+  size_t used;
+  int depth; /* values a condition holds at this point */
+  bool failed;
+};
+
+static void dg_add_token(struct dg_program *prog, int type, int value, const char *text,
+                         size_t len)
+{
+  struct dg_token *token;
+
+  if (prog->count >= DG_PROGRAM_TOKENS || prog->used + len > sizeof(prog->text))
+  {
+    prog->failed = TRUE;
+    return;
+  }
+
+  token = &prog->token[prog->count++];
+  token->type = type;
+  token->value = value;
+  token->text = NULL;
+  if (text)
+  {
+    token->text = prog->text + prog->used;
+    memcpy(token->text, text, len);
+    prog->used += len;
+  }
+}
+
+/* Splits line as var_subst() walks it.  A variable whose lookup may copy
+ * "tmpvr" over its own unread text leaves the line to be read as text. */
+static void dg_compile_subst(struct dg_program *prog, char *line)
+{
+  char text[MAX_INPUT_LENGTH];
+  char *p = line, *var;
+  int len = 0, paren_count = 0, dots;
+
+  if (strlen(line) >= MAX_INPUT_LENGTH - 1)
+  {
+    prog->failed = TRUE;
+    return;
+  }
+
+  while (*p)
+  {
+    while (*p && *p != '%')
+      text[len++] = *p++;
+    if (!*p)
+      break;
+
+    /* double %, or a lone one at the end */
+    if (*++p == '%')
+    {
+      text[len++] = *p++;
+      continue;
+    }
+    if (!*p)
+      break;
+
+    if (len)
+      dg_add_token(prog, DG_TOKEN_TEXT, len, text, len);
+    len = 0;
+
+    for (var = p; *p && *p != '%' && *p != '.'; p++)
+      ;
+    if (*p == '.')
+    {
+      dots = 0;
+      for (p++; *p && (*p != '%' || paren_count > 0 || dots); p++)
+      {
+        if (dots > 0)
+        {
+          if (p - var <= 5)
+            prog->failed = TRUE;
+          dots = 0;
+        }
+        else if (*p == '(')
+          paren_count++;
+        else if (*p == ')')
+          paren_count--;
+        else if (paren_count > 0)
+          continue;
+        else if (*p == '.')
+          dots++;
+      }
+    }
+
+    dg_add_token(prog, DG_TOKEN_VAR, p - var, var, p - var);
+    if (!*p)
+      break;
+    p++;
+  }
+
+  if (len)
+    dg_add_token(prog, DG_TOKEN_TEXT, len, text, len);
+}
+
+/* Splits line into postfix as eval_expr() walks it. */
+static void dg_compile_expr(struct dg_program *prog, char *line)
+{
+  char split[MAX_INPUT_LENGTH] = {'\0'}, expr[MAX_INPUT_LENGTH] = {'\0'}, *p;
+  int op = 0, leaf;
+
+  if (prog->failed)
+    return;
+
+  while (*line && isspace(*line))
+    line++;
+
+  strlcpy(split, line, sizeof(split));
+  if ((p = split_lhs_op_rhs(split, &op)))
+  {
+    dg_compile_expr(prog, split);
+    dg_compile_expr(prog, p);
+    dg_add_token(prog, DG_TOKEN_OP, op, NULL, 0);
+    prog->depth--;
+  }
+  else if (*line == '(')
+  {
+    strcpy(expr, line);
+    p = matching_paren(expr);
+    *p = '\0';
+    dg_compile_expr(prog, expr + 1);
+  }
+  else
+  {
+    leaf = prog->count;
+    dg_add_token(prog, DG_TOKEN_LEAF, 0, NULL, 0);
+    dg_compile_subst(prog, line);
+    if (!prog->failed)
+      prog->token[leaf].value = prog->count - leaf - 1;
+    if (++prog->depth > DG_EXPR_STACK)
+      prog->failed = TRUE;
+  }
+}
+
+/* Fills in c->tokens, or leaves it NULL for the line to be read as text. */
+static void dg_compile_line(struct cmdlist_element *c)
+{
+  static struct dg_program prog;
+  char *text;
+  int i;
+
+  free(c->tokens);
+  c->tokens = NULL;
+  c->token_count = 0;
+
+  prog.count = prog.depth = 0;
+  prog.used = 0;
+  prog.failed = FALSE;
+
+  if (c->flags & DG_LINE_IF)
+    dg_compile_expr(&prog, c->body + 3);
+  else if (c->flags & DG_LINE_ELSEIF)
+    dg_compile_expr(&prog, c->body + 7);
+  else if (c->flags & DG_LINE_WHILE)
+    dg_compile_expr(&prog, c->body + 6);
+  else if (c->flags & DG_LINE_SWITCH)
+    dg_compile_expr(&prog, c->body + 7);
+  else if (!(c->flags & (DG_LINE_COMMENT | DG_LINE_ELSE | DG_LINE_END | DG_LINE_DONE |
+                         DG_LINE_BREAK | DG_LINE_CASE)))
+    dg_compile_subst(&prog, c->body);
+
+  if (prog.failed || !prog.count)
+    return;
+
+  /* the tokens and their text in one block */
+  c->tokens = (struct dg_token *)malloc(prog.count * sizeof(struct dg_token) + prog.used);
+  if (!c->tokens)
+    return;
+  text = (char *)(c->tokens + prog.count);
+  memcpy(text, prog.text, prog.used);
+  for (i = 0; i < prog.count; i++)
+  {
+    c->tokens[i] = prog.token[i];
+    if (prog.token[i].text)
+      c->tokens[i].text = text + (prog.token[i].text - prog.text);
+  }
+  c->token_count = prog.count;
+}
+
+static struct cmdlist_element *find_end_at(trig_data *trig, struct cmdlist_element *cl,
+                                           bool *clean);
+
+void dg_compile_cmdlist(struct cmdlist_element *cmdlist)
+{
+  struct cmdlist_element *c;
+  bool clean;
+
+  for (c = cmdlist; c; c = c->next)
+  {
+    c->body = dg_line_body(c->cmd);
+    c->flags = dg_line_flags(c->body);
+    c->end = c->done = NULL;
+    dg_compile_line(c);
+  }
+
+  for (c = cmdlist; c; c = c->next)
+  {
+    if (c->flags & DG_LINE_IF)
+    {
+      clean = TRUE;
+      find_end_at(NULL, c, &clean);
+    }
+    if (c->flags & (DG_LINE_WHILE | DG_LINE_SWITCH_ANY | DG_LINE_BREAK))
+      find_done(c);
+  }
+}
+
+static void dg_if_without_end(trig_data *trig, int error)
+{
+  if (trig)
+    script_log("Trigger VNum %d has 'if' without 'end'. (error %d)", GET_TRIG_VNUM(trig), error);
+}
+
 static struct cmdlist_element *find_end(trig_data *trig, struct cmdlist_element *cl)
+{
+  bool clean = TRUE;
+
+  return find_end_at(trig, cl, &clean);
+}
+
+/* Scans for end of if-block.  returns the line containg 'end', or the last
+ * line of the trigger if not found.  Clears *clean if the if, or one inside
+ * it, has no end.  With no trig, nothing is logged. */
+static struct cmdlist_element *find_end_at(trig_data *trig, struct cmdlist_element *cl,
+                                           bool *clean)
 {
   struct cmdlist_element *c;
-  char *p;
+  bool ended = TRUE;
+
+  if (!dg_scripts_from_text && cl->end)
+    return cl->end;
 
   if (!(cl->next))
   { /* rryan: if this is the last line, theres no end */
-    script_log("Trigger VNum %d has 'if' without 'end'. (error 1)", GET_TRIG_VNUM(trig));
+    dg_if_without_end(trig, 1);
+    *clean = FALSE;
     return cl;
   }
 
   for (c = cl->next; c; c = c->next)
   {
-    for (p = c->cmd; *p && isspace(*p); p++)
-      ;
-
-    if (!strn_cmp("if ", p, 3))
-      c = find_end(trig, c);
-    else if (!strn_cmp("end", p, 3))
+    if (dg_line_is(c, DG_LINE_IF))
+      c = find_end_at(trig, c, &ended);
+    else if (dg_line_is(c, DG_LINE_END))
+    {
+      if (!ended)
+        *clean = FALSE;
+      else if (!dg_scripts_from_text)
+        cl->end = c;
       return c;
+    }
 
     /* thanks to Russell Ryan for this fix */
     if (!c->next)
     { /* rryan: this is the last line, we didn't find an end. */
-      script_log("Trigger VNum %d has 'if' without 'end'. (error 2)", GET_TRIG_VNUM(trig));
+      dg_if_without_end(trig, 2);
+      *clean = FALSE;
       return c;
     }
   }
 
   /* rryan: we didn't find an end */
-  script_log("Trigger VNum %d has 'if' without 'end'. (error 3)", GET_TRIG_VNUM(trig));
+  dg_if_without_end(trig, 3);
+  *clean = FALSE;
   return c;
 }
 
@@ -1764,35 +2119,31 @@ static struct cmdlist_element *find_else_end(trig_data *trig, struct cmdlist_ele
                                              struct script_data *sc, int type)
 {
   struct cmdlist_element *c;
-  char *p;
 
   if (!(cl->next))
     return cl;
 
   for (c = cl->next; c->next; c = c->next)
   {
-    for (p = c->cmd; *p && isspace(*p); p++)
-      ; /* skip spaces */
-
-    if (!strn_cmp("if ", p, 3))
+    if (dg_line_is(c, DG_LINE_IF))
       c = find_end(trig, c);
 
-    else if (!strn_cmp("elseif ", p, 7))
+    else if (dg_line_is(c, DG_LINE_ELSEIF))
     {
-      if (process_if(p + 7, go, sc, trig, type))
+      if (process_if(c, dg_line_start(c) + 7, go, sc, trig, type))
       {
         GET_TRIG_DEPTH(trig)
         ++;
         return c;
       }
     }
-    else if (!strn_cmp("else", p, 4))
+    else if (dg_line_is(c, DG_LINE_ELSE))
     {
       GET_TRIG_DEPTH(trig)
       ++;
       return c;
     }
-    else if (!strn_cmp("end", p, 3))
+    else if (dg_line_is(c, DG_LINE_END))
       return c;
 
     /* thanks to Russell Ryan for this fix */
@@ -1804,9 +2155,7 @@ static struct cmdlist_element *find_else_end(trig_data *trig, struct cmdlist_ele
   }
 
   /* rryan: if we got here, it's the last line, if its not an end, log it. */
-  for (p = c->cmd; *p && isspace(*p); p++)
-    ; /* skip spaces */
-  if (strn_cmp("end", p, 3))
+  if (!dg_line_is(c, DG_LINE_END))
     script_log("Trigger VNum %d has 'if' without 'end'. (error 5)", GET_TRIG_VNUM(trig));
   return c;
 }
@@ -3113,23 +3462,25 @@ int script_driver(struct script_call_args *args)
 
   dg_owner_purged = 0;
 
+  if (trig->cmdlist && !(trig->cmdlist->flags & DG_LINE_COMPILED))
+    dg_compile_cmdlist(trig->cmdlist);
+
   for (cl = (mode == TRIG_NEW) ? trig->cmdlist : trig->curr_state;
        cl && GET_TRIG_DEPTH(trig) && !dg_owner_purged; cl = cl->next)
   {
-    for (p = cl->cmd; *p && isspace(*p); p++)
-      ;
+    p = dg_line_start(cl);
 
-    if (*p == '*') /* comment */
+    if (dg_line_is(cl, DG_LINE_COMMENT))
       continue;
 
-    else if (!strn_cmp(p, "if ", 3))
+    else if (dg_line_is(cl, DG_LINE_IF))
     {
-      if (process_if(p + 3, go, sc, trig, type))
+      if (process_if(cl, p + 3, go, sc, trig, type))
         GET_TRIG_DEPTH(trig)
       ++;
       else cl = find_else_end(trig, cl, go, sc, type);
     }
-    else if (!strn_cmp("elseif ", p, 7) || !strn_cmp("else", p, 4))
+    else if (dg_line_is(cl, DG_LINE_ELSE))
     {
       /* If not in an if-block, ignore the extra 'else[if]' and warn about it. */
       if (GET_TRIG_DEPTH(trig) == 1)
@@ -3141,7 +3492,7 @@ int script_driver(struct script_call_args *args)
       GET_TRIG_DEPTH(trig)
       --;
     }
-    else if (!strn_cmp("while ", p, 6))
+    else if (dg_line_is(cl, DG_LINE_WHILE))
     {
       temp = find_done(cl);
       if (!temp)
@@ -3149,7 +3500,7 @@ int script_driver(struct script_call_args *args)
         script_log("Trigger VNum %d has 'while' without 'done'.", GET_TRIG_VNUM(trig));
         return ret_val;
       }
-      if (process_if(p + 6, go, sc, trig, type))
+      if (process_if(cl, p + 6, go, sc, trig, type))
       {
         temp->original = cl;
       }
@@ -3159,11 +3510,11 @@ int script_driver(struct script_call_args *args)
         cl = temp;
       }
     }
-    else if (!strn_cmp("switch ", p, 7))
+    else if (dg_line_is(cl, DG_LINE_SWITCH))
     {
       cl = find_case(trig, cl, go, sc, type, p + 7);
     }
-    else if (!strn_cmp("end", p, 3))
+    else if (dg_line_is(cl, DG_LINE_END))
     {
       /* If not in an if-block, ignore the extra 'end' and warn about it. */
       if (GET_TRIG_DEPTH(trig) == 1)
@@ -3174,15 +3525,13 @@ int script_driver(struct script_call_args *args)
       GET_TRIG_DEPTH(trig)
       --;
     }
-    else if (!strn_cmp("done", p, 4))
+    else if (dg_line_is(cl, DG_LINE_DONE))
     {
       /* if in a while loop, cl->original is non-NULL */
       if (cl->original)
       {
-        char *orig_cmd = cl->original->cmd;
-        while (*orig_cmd && isspace(*orig_cmd))
-          orig_cmd++;
-        if (cl->original && process_if(orig_cmd + 6, go, sc, trig, type))
+        char *orig_cmd = dg_line_start(cl->original);
+        if (cl->original && process_if(cl->original, orig_cmd + 6, go, sc, trig, type))
         {
           cl = cl->original;
           cl->loops++;
@@ -3207,17 +3556,20 @@ int script_driver(struct script_call_args *args)
         }
       }
     }
-    else if (!strn_cmp("break", p, 5))
+    else if (dg_line_is(cl, DG_LINE_BREAK))
     {
       cl = find_done(cl);
     }
-    else if (!strn_cmp("case", p, 4))
+    else if (dg_line_is(cl, DG_LINE_CASE))
     {
       /* Do nothing, this allows multiple cases to a single instance */
     }
     else
     {
-      var_subst(go, sc, trig, type, p, cmd);
+      if (!dg_scripts_from_text && cl->tokens)
+        var_subst_tokens(go, sc, trig, type, cl->tokens, cl->token_count, cmd);
+      else
+        var_subst(go, sc, trig, type, p, cmd);
 
       if (!strn_cmp(cmd, "eval ", 5))
       {
@@ -3381,26 +3733,26 @@ static struct cmdlist_element *find_case(struct trig_data *trig, struct cmdlist_
 {
   char result[MAX_INPUT_LENGTH] = {'\0'};
   struct cmdlist_element *c;
-  char *p, *buf = NULL;
+  char *buf = NULL;
 
-  eval_expr(cond, result, go, sc, trig, type);
+  if (!dg_scripts_from_text && cl->tokens)
+    eval_tokens(cl->tokens, cl->token_count, result, go, sc, trig, type);
+  else
+    eval_expr(cond, result, go, sc, trig, type);
 
   if (!(cl->next))
     return cl;
 
   for (c = cl->next; c->next; c = c->next)
   {
-    for (p = c->cmd; *p && isspace(*p); p++)
-      ;
-
-    if (!strn_cmp("while ", p, 6) || !strn_cmp("switch", p, 6))
+    if (dg_line_is(c, DG_LINE_WHILE | DG_LINE_SWITCH_ANY))
       c = find_done(c);
-    else if (!strn_cmp("case ", p, 5))
+    else if (dg_line_is(c, DG_LINE_CASE_ARG))
     {
       buf = (char *)malloc(MAX_STRING_LENGTH);
       if (buf != NULL)
       {
-        eval_op("==", result, p + 5, buf, go, sc, trig);
+        eval_op("==", result, dg_line_start(c) + 5, buf, go, sc, trig);
         if (*buf && *buf != '0')
         {
           free(buf);
@@ -3409,9 +3761,9 @@ static struct cmdlist_element *find_case(struct trig_data *trig, struct cmdlist_
         free(buf);
       }
     }
-    else if (!strn_cmp("default", p, 7))
+    else if (dg_line_is(c, DG_LINE_DEFAULT))
       return c;
-    else if (!strn_cmp("done", p, 3))
+    else if (dg_line_is(c, DG_LINE_DON))
       return c;
   }
   return c;
@@ -3423,22 +3775,22 @@ static struct cmdlist_element *find_case(struct trig_data *trig, struct cmdlist_
 static struct cmdlist_element *find_done(struct cmdlist_element *cl)
 {
   struct cmdlist_element *c;
-  char *p;
 
   if (!cl || !(cl->next))
     return cl;
+  if (!dg_scripts_from_text && cl->done)
+    return cl->done;
 
   for (c = cl->next; c && c->next; c = c->next)
   {
-    for (p = c->cmd; *p && isspace(*p); p++)
-      ;
-
-    if (!strn_cmp("while ", p, 6) || !strn_cmp("switch ", p, 7))
+    if (dg_line_is(c, DG_LINE_WHILE | DG_LINE_SWITCH))
       c = find_done(c);
-    else if (!strn_cmp("done", p, 3))
-      return c;
+    else if (dg_line_is(c, DG_LINE_DON))
+      break;
   }
 
+  if (!dg_scripts_from_text)
+    cl->done = c;
   return c;
 }
 
@@ -3608,68 +3960,111 @@ void save_char_vars_ascii(FILE *file, struct char_data *ch)
 }
 
 /* find_char() helpers */
+/* An open-addressing hash from UID to character or object.  Slots are
+ * Robin Hood ordered: an entry placed further from its home slot than the
+ * one sitting in its way takes that slot and moves the other on, which
+ * keeps probe runs short and lets a lookup stop at the first entry nearer
+ * home than itself.  Removal shifts the rest of the run back a slot, so
+ * there are no tombstones.  The table doubles before it is 7/8 full. */
 /* Must be power of 2. */
-#define BUCKET_COUNT 64
-/* To recognize an empty bucket. */
-#define UID_OUT_OF_RANGE 1000000000
+#define UID_TABLE_MIN_SLOTS 1024
 
 struct lookup_table_t
 {
   long uid;
   void *c;
-  struct lookup_table_t *next;
+  unsigned int dist; /* 1 + slots from its home slot; 0 when empty */
 };
-struct lookup_table_t lookup_table[BUCKET_COUNT];
 
-void init_lookup_table(void)
+static struct
 {
-  int i;
-  for (i = 0; i < BUCKET_COUNT; i++)
-  {
-    lookup_table[i].uid = UID_OUT_OF_RANGE;
-    lookup_table[i].c = NULL;
-    lookup_table[i].next = NULL;
-  }
+  struct lookup_table_t *slots;
+  size_t size; /* Slots, a power of two */
+  int shift;   /* 64 - log2(size) */
+  size_t count;
+} lookup_table;
+
+static inline size_t uid_home_slot(long uid)
+{
+  return (size_t)(((uint64_t)uid * UINT64_C(11400714819323198485)) >> lookup_table.shift);
 }
 
-void cleanup_lookup_table(void)
+static void lookup_table_alloc(size_t size)
 {
-  int i;
-  struct lookup_table_t *lt, *next;
+  lookup_table.size = size;
+  for (lookup_table.shift = 64; size > 1; size >>= 1)
+    lookup_table.shift--;
+  CREATE(lookup_table.slots, struct lookup_table_t, lookup_table.size);
+  lookup_table.count = 0;
+}
 
-  for (i = 0; i < BUCKET_COUNT; i++)
+/* Put an entry for a UID the table does not hold yet, with room for it. */
+static void lookup_table_place(long uid, void *c)
+{
+  struct lookup_table_t entry, displaced;
+  size_t i, mask = lookup_table.size - 1;
+
+  entry.uid = uid;
+  entry.c = c;
+  entry.dist = 1;
+  for (i = uid_home_slot(uid);; i = (i + 1) & mask, entry.dist++)
   {
-    /* Free all entries in the linked list for this bucket */
-    lt = lookup_table[i].next;
-    while (lt)
+    if (lookup_table.slots[i].dist == 0)
     {
-      next = lt->next;
-      free(lt);
-      lt = next;
+      lookup_table.slots[i] = entry;
+      lookup_table.count++;
+      return;
+    }
+    if (lookup_table.slots[i].dist < entry.dist)
+    {
+      displaced = lookup_table.slots[i];
+      lookup_table.slots[i] = entry;
+      entry = displaced;
     }
-
-    /* Reset the static bucket entry */
-    lookup_table[i].uid = UID_OUT_OF_RANGE;
-    lookup_table[i].c = NULL;
-    lookup_table[i].next = NULL;
   }
 }
 
-static inline struct lookup_table_t *get_bucket_head(long uid)
+static void lookup_table_grow(void)
 {
-  int bucket = (int)(uid & (BUCKET_COUNT - 1));
+  struct lookup_table_t *old = lookup_table.slots;
+  size_t i, old_size = lookup_table.size;
+
+  lookup_table_alloc(old ? old_size * 2 : UID_TABLE_MIN_SLOTS);
+  for (i = 0; i < old_size; i++)
+    if (old[i].dist)
+      lookup_table_place(old[i].uid, old[i].c);
+  free(old);
+}
 
-  return &lookup_table[bucket];
+void init_lookup_table(void)
+{
+  cleanup_lookup_table();
+  lookup_table_alloc(UID_TABLE_MIN_SLOTS);
+}
+
+void cleanup_lookup_table(void)
+{
+  free(lookup_table.slots);
+  lookup_table.slots = NULL;
+  lookup_table.size = 0;
+  lookup_table.count = 0;
 }
 
 static inline struct lookup_table_t *find_element_by_uid_in_lookup_table(long uid)
 {
-  struct lookup_table_t *lt = get_bucket_head(uid);
+  size_t i, mask = lookup_table.size - 1;
+  unsigned int dist;
 
-  for (; lt && lt->uid != uid; lt = lt->next)
-    ;
+  if (lookup_table.slots == NULL)
+    return NULL;
 
-  return lt;
+  for (i = uid_home_slot(uid), dist = 1;; i = (i + 1) & mask, dist++)
+  {
+    if (lookup_table.slots[i].dist < dist)
+      return NULL;
+    if (lookup_table.slots[i].uid == uid)
+      return &lookup_table.slots[i];
+  }
 }
 
 static struct char_data *find_char_by_uid_in_lookup_table(long uid)
@@ -3741,76 +4136,50 @@ void format_dg_command_choices(char *buf, size_t size, const char *const choices
 
 void add_to_lookup_table(long uid, void *c)
 {
-  struct lookup_table_t *lt = get_bucket_head(uid);
+  struct lookup_table_t *lt = find_element_by_uid_in_lookup_table(uid);
 
-  if (lt && lt->uid == uid)
+  if (lt)
   {
     log("add_to_lookup updating existing value for uid=%ld (%p -> %p)", uid, lt->c, c);
     lt->c = c;
     return;
   }
 
-  for (; lt && lt->next; lt = lt->next)
-    if (lt->next->uid == uid)
-    {
-      log("add_to_lookup updating existing value for uid=%ld (%p -> %p)", uid, lt->next->c, c);
-      lt->next->c = c;
-      return;
-    }
-
-  CREATE(lt->next, struct lookup_table_t, 1);
-  lt->next->uid = uid;
-  lt->next->c = c;
+  if (lookup_table.slots == NULL || (lookup_table.count + 1) * 8 > lookup_table.size * 7)
+    lookup_table_grow();
+  lookup_table_place(uid, c);
 }
 
 void remove_from_lookup_table(long uid)
 {
-  int bucket = (int)(uid & (BUCKET_COUNT - 1));
-  struct lookup_table_t *lt = &lookup_table[bucket], *prev = NULL;
+  struct lookup_table_t *lt;
+  size_t i, next, mask = lookup_table.size - 1;
 
   /* This is not supposed to happen. UID 0 is not used. However, while I'm
    * debugging the issue, let's just return right away. - Welcor */
   if (uid == 0)
     return;
 
-  /* Special case: if the uid is in the static bucket entry */
-  if (lt->uid == uid)
+  if ((lt = find_element_by_uid_in_lookup_table(uid)) == NULL)
   {
-    /* If there's a next entry, copy it to the static bucket and free the next */
-    if (lt->next)
-    {
-      struct lookup_table_t *temp = lt->next;
-      lt->uid = temp->uid;
-      lt->c = temp->c;
-      lt->next = temp->next;
-      free(temp);
-    }
-    else
-    {
-      /* No next entry, just mark the bucket as empty */
-      lt->uid = UID_OUT_OF_RANGE;
-      lt->c = NULL;
-    }
+    log("remove_from_lookup. UID %ld not found.", uid);
     return;
   }
 
-  /* Search the linked list for the uid */
-  prev = lt;
-  lt = lt->next;
-
-  while (lt)
+  /* Pull the rest of the run back a slot, until an empty slot or an entry
+   * already in its home slot. */
+  for (i = (size_t)(lt - lookup_table.slots);; i = next)
   {
-    if (lt->uid == uid)
-    {
-      prev->next = lt->next;
-      free(lt);
-      return;
-    }
-    prev = lt;
-    lt = lt->next;
+    next = (i + 1) & mask;
+    if (lookup_table.slots[next].dist <= 1)
+      break;
+    lookup_table.slots[i] = lookup_table.slots[next];
+    lookup_table.slots[i].dist--;
   }
-
-  log("remove_from_lookup. UID %ld not found.", uid);
+  lookup_table.slots[i].uid = 0;
+  lookup_table.slots[i].c = NULL;
+  lookup_table.slots[i].dist = 0;
+  lookup_table.count--;
 }
 
 bool check_flags_by_name_ar(int *array, int numflags, char *search, const char *namelist[])
@@ -132,6 +132,43 @@
 
 #define SCRIPT_ERROR_CODE -9999999 /* this shouldn't happen too often */
 
+/* What dg_compile_cmdlist() found at the start of a line (after blanks).
+ * Some of these look alike: each records exactly the prefix one of
+ * script_driver()'s tests or block scans compares against. */
+#define DG_LINE_COMPILED (1 << 0)
+#define DG_LINE_COMMENT (1 << 1)   /* "*" */
+#define DG_LINE_IF (1 << 2)        /* "if " */
+#define DG_LINE_ELSEIF (1 << 3)    /* "elseif " */
+#define DG_LINE_ELSE (1 << 4)      /* "else", so also every elseif */
+#define DG_LINE_WHILE (1 << 5)     /* "while " */
+#define DG_LINE_SWITCH (1 << 6)    /* "switch " */
+#define DG_LINE_SWITCH_ANY (1 << 7) /* "switch", as find_case() skips them */
+#define DG_LINE_END (1 << 8)       /* "end" */
+#define DG_LINE_DONE (1 << 9)      /* "done" */
+#define DG_LINE_DON (1 << 10)      /* "don", as the block scans match done */
+#define DG_LINE_BREAK (1 << 11)    /* "break" */
+#define DG_LINE_CASE (1 << 12)     /* "case" */
+#define DG_LINE_CASE_ARG (1 << 13) /* "case " */
+#define DG_LINE_DEFAULT (1 << 14)  /* "default" */
+
+/* A line's text, compiled by dg_compile_cmdlist().  A command line is a
+ * run of TEXT (with %% already folded to %) and VAR (the reference between
+ * its % signs) tokens for var_subst_tokens().  An if, elseif, while or
+ * switch condition is its expression in postfix: each LEAF is followed by
+ * value TEXT/VAR tokens to substitute, and each OP (value indexes
+ * dg_expr_ops[]) combines the two values before it. */
+#define DG_TOKEN_TEXT 0
+#define DG_TOKEN_VAR 1
+#define DG_TOKEN_LEAF 2
+#define DG_TOKEN_OP 3
+
+struct dg_token
+{
+  int type;   /* DG_TOKEN_* */
+  int value;  /* TEXT/VAR: length of text, LEAF: tokens after it, OP: operator */
+  char *text; /* TEXT/VAR only */
+};
+
 /* one line of the trigger */
 struct cmdlist_element
 {
@@ -140,6 +177,14 @@ struct cmdlist_element
   unsigned int loops;
   struct cmdlist_element *original;
   struct cmdlist_element *next;
+
+  /* Filled in by dg_compile_cmdlist(), shared by every copy of the trigger. */
+  int flags;                    /* DG_LINE_* */
+  char *body;                   /* cmd past its leading blanks */
+  struct cmdlist_element *end;  /* if: its end, when the scan for it logged nothing */
+  struct cmdlist_element *done; /* while/switch/break: where its block ends */
+  struct dg_token *tokens;      /* its text or condition; NULL to read cmd instead */
+  int token_count;
 };
 
 struct trig_var_data
@@ -330,6 +375,11 @@ struct script_call_args
 /* To maintain strict-aliasing we'll have to do this trick with a union */
 /* Thanks to Chris Gilbert for reminding me that there are other options. */
 int script_driver(struct script_call_args *args);
+/* Classify and compile every line and find its block ends; call on each new
+ * command list. */
+void dg_compile_cmdlist(struct cmdlist_element *cmdlist);
+/* Run triggers from their raw text as before, ignoring the compiled form. */
+extern bool dg_scripts_from_text;
 trig_rnum real_trigger(trig_vnum vnum);
 void process_eval(void *go, struct script_data *sc, trig_data *trig, int type, char *cmd);
 void read_saved_vars(struct char_data *ch);
@@ -359,6 +409,8 @@ int item_in_list(char *item, obj_data *list);
 const char *skill_percent(struct char_data *ch, char *skill);
 int char_has_item(char *item, struct char_data *ch);
 void var_subst(void *go, struct script_data *sc, trig_data *trig, int type, char *line, char *buf);
+void var_subst_tokens(void *go, struct script_data *sc, trig_data *trig, int type,
+                      const struct dg_token *token, int count, char *buf);
 int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *str, size_t slen);
 void find_replacement(void *go, struct script_data *sc, trig_data *trig, int type, char *var,
                       char *field, char *subfield, char *str, size_t slen);
@@ -213,17 +213,339 @@ static int handle_oset(struct obj_data *obj, char *argument)
   return 1;
 }
 
+/* The fields find_replacement() and text_processed() know, by name. */
+enum dg_field
+{
+  DG_FIELD_UNKNOWN = 0,
+  DG_FIELD_AFFECT,
+  DG_FIELD_AFFECTS,
+  DG_FIELD_ALIAS,
+  DG_FIELD_ALIGN,
+  DG_FIELD_ARMOR,
+  DG_FIELD_BOUND,
+  DG_FIELD_CANBESEEN,
+  DG_FIELD_CAR,
+  DG_FIELD_CARRIED_BY,
+  DG_FIELD_CDR,
+  DG_FIELD_CHA,
+  DG_FIELD_CHARAT,
+  DG_FIELD_CLAN,
+  DG_FIELD_CLAN_GOLD,
+  DG_FIELD_CLANNAME,
+  DG_FIELD_CLANRANK,
+  DG_FIELD_CLASS,
+  DG_FIELD_CON,
+  DG_FIELD_CONTAINS,
+  DG_FIELD_CONTENTS,
+  DG_FIELD_COST,
+  DG_FIELD_COST_PER_DAY,
+  DG_FIELD_COUNT,
+  DG_FIELD_DAMROLL,
+  DG_FIELD_DEX,
+  DG_FIELD_DOWN,
+  DG_FIELD_DRUNK,
+  DG_FIELD_EAST,
+  DG_FIELD_EQ,
+  DG_FIELD_EXP,
+  DG_FIELD_EXTRA,
+  DG_FIELD_FEAT,
+  DG_FIELD_FIGHTING,
+  DG_FIELD_FOLLOWER,
+  DG_FIELD_GOLD,
+  DG_FIELD_HAS_CLASS,
+  DG_FIELD_HAS_IN,
+  DG_FIELD_HAS_ITEM,
+  DG_FIELD_HASATTACHED,
+  DG_FIELD_HESHE,
+  DG_FIELD_HIMHER,
+  DG_FIELD_HISHER,
+  DG_FIELD_HITP,
+  DG_FIELD_HITROLL,
+  DG_FIELD_HUNGER,
+  DG_FIELD_ID,
+  DG_FIELD_INT,
+  DG_FIELD_INVENTORY,
+  DG_FIELD_IS_CLAN_LEADER,
+  DG_FIELD_IS_INROOM,
+  DG_FIELD_IS_KILLER,
+  DG_FIELD_IS_ON_QUEST,
+  DG_FIELD_IS_PC,
+  DG_FIELD_IS_THIEF,
+  DG_FIELD_LEVEL,
+  DG_FIELD_MASTER,
+  DG_FIELD_MAXHITP,
+  DG_FIELD_MAXMOVE,
+  DG_FIELD_MAXPSP,
+  DG_FIELD_MOVE,
+  DG_FIELD_MUDCOMMAND,
+  DG_FIELD_NAME,
+  DG_FIELD_NEXT_IN_LIST,
+  DG_FIELD_NEXT_IN_ROOM,
+  DG_FIELD_NORTH,
+  DG_FIELD_NPCFLAG,
+  DG_FIELD_OSET,
+  DG_FIELD_PEOPLE,
+  DG_FIELD_POS,
+  DG_FIELD_PRAC,
+  DG_FIELD_PREF,
+  DG_FIELD_PSP,
+  DG_FIELD_QP,
+  DG_FIELD_QPNTS,
+  DG_FIELD_QUEST,
+  DG_FIELD_QUESTDONE,
+  DG_FIELD_QUESTPOINTS,
+  DG_FIELD_RACE,
+  DG_FIELD_RESIST_ACID,
+  DG_FIELD_RESIST_AIR,
+  DG_FIELD_RESIST_COLD,
+  DG_FIELD_RESIST_DISEASE,
+  DG_FIELD_RESIST_EARTH,
+  DG_FIELD_RESIST_ELECTRIC,
+  DG_FIELD_RESIST_ENERGY,
+  DG_FIELD_RESIST_FIRE,
+  DG_FIELD_RESIST_FORCE,
+  DG_FIELD_RESIST_HOLY,
+  DG_FIELD_RESIST_ILLUSION,
+  DG_FIELD_RESIST_LIGHT,
+  DG_FIELD_RESIST_MENTAL,
+  DG_FIELD_RESIST_NEGATIVE,
+  DG_FIELD_RESIST_POISON,
+  DG_FIELD_RESIST_PUNCTURE,
+  DG_FIELD_RESIST_SLICE,
+  DG_FIELD_RESIST_SOUND,
+  DG_FIELD_RESIST_UNHOLY,
+  DG_FIELD_RESIST_WATER,
+  DG_FIELD_ROOM,
+  DG_FIELD_ROOMFLAG,
+  DG_FIELD_SAVING_DEATH,
+  DG_FIELD_SAVING_FORT,
+  DG_FIELD_SAVING_POISON,
+  DG_FIELD_SAVING_REFL,
+  DG_FIELD_SAVING_WILL,
+  DG_FIELD_SECTOR,
+  DG_FIELD_SEX,
+  DG_FIELD_SHORTDESC,
+  DG_FIELD_SIZE,
+  DG_FIELD_SIZENUMBER,
+  DG_FIELD_SKILL,
+  DG_FIELD_SKILLROLL,
+  DG_FIELD_SKILLSET,
+  DG_FIELD_SOUTH,
+  DG_FIELD_STR,
+  DG_FIELD_STRADD,
+  DG_FIELD_STRLEN,
+  DG_FIELD_SUBRACE1,
+  DG_FIELD_SUBRACE2,
+  DG_FIELD_SUBRACE3,
+  DG_FIELD_THIRST,
+  DG_FIELD_TIMER,
+  DG_FIELD_TITLE,
+  DG_FIELD_TOUPPER,
+  DG_FIELD_TRIM,
+  DG_FIELD_TYPE,
+  DG_FIELD_UP,
+  DG_FIELD_VAL0,
+  DG_FIELD_VAL1,
+  DG_FIELD_VAL2,
+  DG_FIELD_VAL3,
+  DG_FIELD_VAREXISTS,
+  DG_FIELD_VNUM,
+  DG_FIELD_WAIT,
+  DG_FIELD_WEARFLAG,
+  DG_FIELD_WEATHER,
+  DG_FIELD_WEIGHT,
+  DG_FIELD_WEST,
+  DG_FIELD_WIS,
+  DG_FIELD_WORN_BY,
+  DG_FIELD_XCOORD,
+  DG_FIELD_YCOORD,
+  DG_FIELD_ZONENAME,
+  DG_FIELD_ZONENUMBER,
+};
+
+struct dg_field_name
+{
+  const char *name;
+  enum dg_field id;
+};
+
+/* Sorted by name for dg_field_id(). */
+static const struct dg_field_name dg_field_names[] = {
+    {"affect", DG_FIELD_AFFECT},
+    {"affects", DG_FIELD_AFFECTS},
+    {"alias", DG_FIELD_ALIAS},
+    {"align", DG_FIELD_ALIGN},
+    {"armor", DG_FIELD_ARMOR},
+    {"bound", DG_FIELD_BOUND},
+    {"canbeseen", DG_FIELD_CANBESEEN},
+    {"car", DG_FIELD_CAR},
+    {"carried_by", DG_FIELD_CARRIED_BY},
+    {"cdr", DG_FIELD_CDR},
+    {"cha", DG_FIELD_CHA},
+    {"charat", DG_FIELD_CHARAT},
+    {"clan", DG_FIELD_CLAN},
+    {"clan_gold", DG_FIELD_CLAN_GOLD},
+    {"clanname", DG_FIELD_CLANNAME},
+    {"clanrank", DG_FIELD_CLANRANK},
+    {"class", DG_FIELD_CLASS},
+    {"con", DG_FIELD_CON},
+    {"contains", DG_FIELD_CONTAINS},
+    {"contents", DG_FIELD_CONTENTS},
+    {"cost", DG_FIELD_COST},
+    {"cost_per_day", DG_FIELD_COST_PER_DAY},
+    {"count", DG_FIELD_COUNT},
+    {"damroll", DG_FIELD_DAMROLL},
+    {"dex", DG_FIELD_DEX},
+    {"down", DG_FIELD_DOWN},
+    {"drunk", DG_FIELD_DRUNK},
+    {"east", DG_FIELD_EAST},
+    {"eq", DG_FIELD_EQ},
+    {"exp", DG_FIELD_EXP},
+    {"extra", DG_FIELD_EXTRA},
+    {"feat", DG_FIELD_FEAT},
+    {"fighting", DG_FIELD_FIGHTING},
+    {"follower", DG_FIELD_FOLLOWER},
+    {"gold", DG_FIELD_GOLD},
+    {"has_class", DG_FIELD_HAS_CLASS},
+    {"has_in", DG_FIELD_HAS_IN},
+    {"has_item", DG_FIELD_HAS_ITEM},
+    {"hasattached", DG_FIELD_HASATTACHED},
+    {"heshe", DG_FIELD_HESHE},
+    {"himher", DG_FIELD_HIMHER},
+    {"hisher", DG_FIELD_HISHER},
+    {"hitp", DG_FIELD_HITP},
+    {"hitroll", DG_FIELD_HITROLL},
+    {"hunger", DG_FIELD_HUNGER},
+    {"id", DG_FIELD_ID},
+    {"int", DG_FIELD_INT},
+    {"inventory", DG_FIELD_INVENTORY},
+    {"is_clan_leader", DG_FIELD_IS_CLAN_LEADER},
+    {"is_inroom", DG_FIELD_IS_INROOM},
+    {"is_killer", DG_FIELD_IS_KILLER},
+    {"is_on_quest", DG_FIELD_IS_ON_QUEST},
+    {"is_pc", DG_FIELD_IS_PC},
+    {"is_thief", DG_FIELD_IS_THIEF},
+    {"level", DG_FIELD_LEVEL},
+    {"master", DG_FIELD_MASTER},
+    {"maxhitp", DG_FIELD_MAXHITP},
+    {"maxmove", DG_FIELD_MAXMOVE},
+    {"maxpsp", DG_FIELD_MAXPSP},
+    {"move", DG_FIELD_MOVE},
+    {"mudcommand", DG_FIELD_MUDCOMMAND},
+    {"name", DG_FIELD_NAME},
+    {"next_in_list", DG_FIELD_NEXT_IN_LIST},
+    {"next_in_room", DG_FIELD_NEXT_IN_ROOM},
+    {"north", DG_FIELD_NORTH},
+    {"npcflag", DG_FIELD_NPCFLAG},
+    {"oset", DG_FIELD_OSET},
+    {"people", DG_FIELD_PEOPLE},
+    {"pos", DG_FIELD_POS},
+    {"prac", DG_FIELD_PRAC},
+    {"pref", DG_FIELD_PREF},
+    {"psp", DG_FIELD_PSP},
+    {"qp", DG_FIELD_QP},
+    {"qpnts", DG_FIELD_QPNTS},
+    {"quest", DG_FIELD_QUEST},
+    {"questdone", DG_FIELD_QUESTDONE},
+    {"questpoints", DG_FIELD_QUESTPOINTS},
+    {"race", DG_FIELD_RACE},
+    {"resist_acid", DG_FIELD_RESIST_ACID},
+    {"resist_air", DG_FIELD_RESIST_AIR},
+    {"resist_cold", DG_FIELD_RESIST_COLD},
+    {"resist_disease", DG_FIELD_RESIST_DISEASE},
+    {"resist_earth", DG_FIELD_RESIST_EARTH},
+    {"resist_electric", DG_FIELD_RESIST_ELECTRIC},
+    {"resist_energy", DG_FIELD_RESIST_ENERGY},
+    {"resist_fire", DG_FIELD_RESIST_FIRE},
+    {"resist_force", DG_FIELD_RESIST_FORCE},
+    {"resist_holy", DG_FIELD_RESIST_HOLY},
+    {"resist_illusion", DG_FIELD_RESIST_ILLUSION},
+    {"resist_light", DG_FIELD_RESIST_LIGHT},
+    {"resist_mental", DG_FIELD_RESIST_MENTAL},
+    {"resist_negative", DG_FIELD_RESIST_NEGATIVE},
+    {"resist_poison", DG_FIELD_RESIST_POISON},
+    {"resist_puncture", DG_FIELD_RESIST_PUNCTURE},
+    {"resist_slice", DG_FIELD_RESIST_SLICE},
+    {"resist_sound", DG_FIELD_RESIST_SOUND},
+    {"resist_unholy", DG_FIELD_RESIST_UNHOLY},
+    {"resist_water", DG_FIELD_RESIST_WATER},
+    {"room", DG_FIELD_ROOM},
+    {"roomflag", DG_FIELD_ROOMFLAG},
+    {"saving_death", DG_FIELD_SAVING_DEATH},
+    {"saving_fort", DG_FIELD_SAVING_FORT},
+    {"saving_poison", DG_FIELD_SAVING_POISON},
+    {"saving_refl", DG_FIELD_SAVING_REFL},
+    {"saving_will", DG_FIELD_SAVING_WILL},
+    {"sector", DG_FIELD_SECTOR},
+    {"sex", DG_FIELD_SEX},
+    {"shortdesc", DG_FIELD_SHORTDESC},
+    {"size", DG_FIELD_SIZE},
+    {"sizenumber", DG_FIELD_SIZENUMBER},
+    {"skill", DG_FIELD_SKILL},
+    {"skillroll", DG_FIELD_SKILLROLL},
+    {"skillset", DG_FIELD_SKILLSET},
+    {"south", DG_FIELD_SOUTH},
+    {"str", DG_FIELD_STR},
+    {"stradd", DG_FIELD_STRADD},
+    {"strlen", DG_FIELD_STRLEN},
+    {"subrace1", DG_FIELD_SUBRACE1},
+    {"subrace2", DG_FIELD_SUBRACE2},
+    {"subrace3", DG_FIELD_SUBRACE3},
+    {"thirst", DG_FIELD_THIRST},
+    {"timer", DG_FIELD_TIMER},
+    {"title", DG_FIELD_TITLE},
+    {"toupper", DG_FIELD_TOUPPER},
+    {"trim", DG_FIELD_TRIM},
+    {"type", DG_FIELD_TYPE},
+    {"up", DG_FIELD_UP},
+    {"val0", DG_FIELD_VAL0},
+    {"val1", DG_FIELD_VAL1},
+    {"val2", DG_FIELD_VAL2},
+    {"val3", DG_FIELD_VAL3},
+    {"varexists", DG_FIELD_VAREXISTS},
+    {"vnum", DG_FIELD_VNUM},
+    {"wait", DG_FIELD_WAIT},
+    {"wearflag", DG_FIELD_WEARFLAG},
+    {"weather", DG_FIELD_WEATHER},
+    {"weight", DG_FIELD_WEIGHT},
+    {"west", DG_FIELD_WEST},
+    {"wis", DG_FIELD_WIS},
+    {"worn_by", DG_FIELD_WORN_BY},
+    {"xcoord", DG_FIELD_XCOORD},
+    {"ycoord", DG_FIELD_YCOORD},
+    {"zonename", DG_FIELD_ZONENAME},
+    {"zonenumber", DG_FIELD_ZONENUMBER},
+};
+
+static int dg_field_name_cmp(const void *key, const void *entry)
+{
+  return str_cmp((const char *)key, ((const struct dg_field_name *)entry)->name);
+}
+
+/* Which field a script asks for, so one lookup replaces a run of string
+ * compares; DG_FIELD_UNKNOWN for the rest, such as global variable names. */
+static enum dg_field dg_field_id(const char *field)
+{
+  const struct dg_field_name *found;
+
+  found = bsearch(field, dg_field_names, sizeof(dg_field_names) / sizeof(dg_field_names[0]),
+                  sizeof(dg_field_names[0]), dg_field_name_cmp);
+  return found ? found->id : DG_FIELD_UNKNOWN;
+}
+
 int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *str, size_t slen)
 {
   char *p, *p2;
   char tmpvar[MAX_STRING_LENGTH] = {'\0'};
 
-  if (!str_cmp(field, "strlen"))
+  switch (dg_field_id(field))
+  {
+  case DG_FIELD_STRLEN:
   { /* strlen    */
     snprintf(str, slen, "%d", (int)strlen(vd->value));
     return TRUE;
   }
-  else if (!str_cmp(field, "toupper"))
+  case DG_FIELD_TOUPPER:
   { /* toupper   */
     if (*vd->value)
       snprintf(str, slen, "%c%s", UPPER(*vd->value), vd->value + 1);
@@ -231,7 +553,7 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
       *str = '\0';
     return TRUE;
   }
-  else if (!str_cmp(field, "trim"))
+  case DG_FIELD_TRIM:
   { /* trim      */
     /* trim whitespace from ends */
     snprintf(tmpvar, sizeof(tmpvar) - 1, "%s", vd->value); /* -1 to use later*/
@@ -250,7 +572,7 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
     snprintf(str, slen, "%s", p);
     return TRUE;
   }
-  else if (!str_cmp(field, "contains"))
+  case DG_FIELD_CONTAINS:
   { /* contains  */
     if (str_str(vd->value, subfield))
       strcpy(str, "1");
@@ -258,7 +580,7 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
       strcpy(str, "0");
     return TRUE;
   }
-  else if (!str_cmp(field, "car"))
+  case DG_FIELD_CAR:
   { /* car       */
     char *car = vd->value;
     while (*car && !isspace(*car))
@@ -266,7 +588,7 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
     *str = '\0';
     return TRUE;
   }
-  else if (!str_cmp(field, "cdr"))
+  case DG_FIELD_CDR:
   { /* cdr       */
     char *cdr = vd->value;
     while (*cdr && !isspace(*cdr))
@@ -277,7 +599,7 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
     snprintf(str, slen, "%s", cdr);
     return TRUE;
   }
-  else if (!str_cmp(field, "charat"))
+  case DG_FIELD_CHARAT:
   { /* CharAt    */
     size_t len = strlen(vd->value), cindex = atoi(subfield);
     if (cindex > len || cindex < 1)
@@ -286,7 +608,7 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
       snprintf(str, slen, "%c", vd->value[cindex - 1]);
     return TRUE;
   }
-  else if (!str_cmp(field, "mudcommand"))
+  case DG_FIELD_MUDCOMMAND:
   {
     /* find the mud command returned from this text */
     /* NOTE: you may need to replace "cmd_info" with "complete_cmd_info", */
@@ -303,8 +625,9 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd, char *
       snprintf(str, slen, "%s", cmd_info[cmd].command);
     return TRUE;
   }
-
-  return FALSE;
+  default:
+    return FALSE;
+  }
 }
 
 /* sets str to be the value of var.field */
@@ -729,551 +1052,579 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
       /* set str to some 'non-text' first */
       *str = '\x1';
 
-      switch (LOWER(*field))
+      switch (dg_field_id(field))
       {
-      case 'a':
-        if (!str_cmp(field, "affect"))
+      case DG_FIELD_AFFECT:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int spell = find_skill_num(subfield);
-            if (affected_by_spell(c, spell))
-              strcpy(str, "1");
-            else
-              strcpy(str, "0");
-          }
+          int spell = find_skill_num(subfield);
+          if (affected_by_spell(c, spell))
+            strcpy(str, "1");
           else
             strcpy(str, "0");
         }
-        else if (!str_cmp(field, "alias"))
-          snprintf(str, slen, "%s", GET_PC_NAME(c));
+        else
+          strcpy(str, "0");
+        break;
+      }
+      case DG_FIELD_ALIAS:
+        snprintf(str, slen, "%s", GET_PC_NAME(c));
+        break;
 
-        else if (!str_cmp(field, "align"))
+      case DG_FIELD_ALIGN:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_ALIGNMENT(c) = MAX(-1000, MIN(addition, 1000));
-          }
-          snprintf(str, slen, "%d", GET_ALIGNMENT(c));
+          int addition = atoi(subfield);
+          GET_ALIGNMENT(c) = MAX(-1000, MIN(addition, 1000));
         }
-        else if (!str_cmp(field, "armor"))
-          snprintf(str, slen, "%d", compute_armor_class(NULL, c, FALSE, MODE_ARMOR_CLASS_NORMAL));
+        snprintf(str, slen, "%d", GET_ALIGNMENT(c));
+        break;
+      }
+      case DG_FIELD_ARMOR:
+        snprintf(str, slen, "%d", compute_armor_class(NULL, c, FALSE, MODE_ARMOR_CLASS_NORMAL));
+        break;
+      case DG_FIELD_CANBESEEN:
+      {
+        if ((type == MOB_TRIGGER) && !CAN_SEE(((char_data *)go), c))
+          strcpy(str, "0");
+        else
+          strcpy(str, "1");
         break;
-      case 'c':
-        if (!str_cmp(field, "canbeseen"))
+      }
+      case DG_FIELD_CHA:
+      {
+        if (subfield && *subfield)
         {
-          if ((type == MOB_TRIGGER) && !CAN_SEE(((char_data *)go), c))
-            strcpy(str, "0");
-          else
-            strcpy(str, "1");
+          int addition = atoi(subfield);
+          int max = 50;
+          c->real_abils.cha += addition;
+          c->real_abils.cha = MAX(3, MIN(c->real_abils.cha, max));
+          affect_total(c);
         }
-        else if (!str_cmp(field, "cha"))
+        snprintf(str, slen, "%d", GET_CHA(c));
+        break;
+      }
+      case DG_FIELD_CLAN:
+      {
+        if (!IS_NPC(c))
         {
           if (subfield && *subfield)
           {
             int addition = atoi(subfield);
-            int max = 50;
-            c->real_abils.cha += addition;
-            c->real_abils.cha = MAX(3, MIN(c->real_abils.cha, max));
-            affect_total(c);
+            GET_CLAN(c) = MAX(0, MIN(addition, MAX_CLANS));
           }
-          snprintf(str, slen, "%d", GET_CHA(c));
+          snprintf(str, slen, "%d", GET_CLAN(c));
         }
-        else if (!str_cmp(field, "clan"))
+        else
         {
-          if (!IS_NPC(c))
-          {
-            if (subfield && *subfield)
-            {
-              int addition = atoi(subfield);
-              GET_CLAN(c) = MAX(0, MIN(addition, MAX_CLANS));
-            }
-            snprintf(str, slen, "%d", GET_CLAN(c));
-          }
-          else
-          {
-            snprintf(str, slen, "%d", NO_CLAN); /* Mobs have no clan */
-          }
+          snprintf(str, slen, "%d", NO_CLAN); /* Mobs have no clan */
         }
-        else if (!str_cmp(field, "clanrank"))
+        break;
+      }
+      case DG_FIELD_CLANRANK:
+      {
+        if (!IS_NPC(c))
         {
-          if (!IS_NPC(c))
-          {
-            snprintf(str, slen, "%d", GET_CLANRANK(c));
-          }
-          else
-          {
-            snprintf(str, slen, "%d", NO_CLANRANK); /* Mobs have no clan */
-          }
+          snprintf(str, slen, "%d", GET_CLANRANK(c));
+        }
+        else
+        {
+          snprintf(str, slen, "%d", NO_CLANRANK); /* Mobs have no clan */
         }
-        else if (!str_cmp(field, "clanname"))
+        break;
+      }
+      case DG_FIELD_CLANNAME:
+      {
+        if (!IS_NPC(c) && GET_CLAN(c) != NO_CLAN)
         {
-          if (!IS_NPC(c) && GET_CLAN(c) != NO_CLAN)
-          {
-            clan_rnum cr = real_clan(GET_CLAN(c));
-            if (cr != NO_CLAN)
-              snprintf(str, slen, "%s", clan_list[cr].clan_name);
-            else
-              strcpy(str, "None");
-          }
+          clan_rnum cr = real_clan(GET_CLAN(c));
+          if (cr != NO_CLAN)
+            snprintf(str, slen, "%s", clan_list[cr].clan_name);
           else
-          {
             strcpy(str, "None");
-          }
         }
-        else if (!str_cmp(field, "is_clan_leader"))
+        else
         {
-          if (!IS_NPC(c) && check_clan_leader(c))
-            snprintf(str, slen, "1");
+          strcpy(str, "None");
+        }
+        break;
+      }
+      case DG_FIELD_IS_CLAN_LEADER:
+      {
+        if (!IS_NPC(c) && check_clan_leader(c))
+          snprintf(str, slen, "1");
+        else
+          snprintf(str, slen, "0");
+        break;
+      }
+      case DG_FIELD_CLAN_GOLD:
+      {
+        if (!IS_NPC(c) && GET_CLAN(c) != NO_CLAN)
+        {
+          clan_rnum cr = real_clan(GET_CLAN(c));
+          if (cr != NO_CLAN)
+            snprintf(str, slen, "%ld", clan_list[cr].treasure);
           else
             snprintf(str, slen, "0");
         }
-        else if (!str_cmp(field, "clan_gold"))
+        else
+        {
+          snprintf(str, slen, "0");
+        }
+        break;
+      }
+      case DG_FIELD_CLASS:
+      {
+        if (subfield && *subfield)
         {
-          if (!IS_NPC(c) && GET_CLAN(c) != NO_CLAN)
+          int cl = get_class_by_name(subfield);
+          if (cl != -1)
           {
-            clan_rnum cr = real_clan(GET_CLAN(c));
-            if (cr != NO_CLAN)
-              snprintf(str, slen, "%ld", clan_list[cr].treasure);
-            else
-              snprintf(str, slen, "0");
+            GET_CLASS(c) = cl;
+            snprintf(str, slen, "1");
           }
           else
           {
             snprintf(str, slen, "0");
           }
         }
-        else if (!str_cmp(field, "class"))
+        else
         {
-          if (subfield && *subfield)
-          {
-            int cl = get_class_by_name(subfield);
-            if (cl != -1)
-            {
-              GET_CLASS(c) = cl;
-              snprintf(str, slen, "1");
-            }
-            else
-            {
-              snprintf(str, slen, "0");
-            }
-          }
-          else
-          {
-            // sprinttype(GET_CLASS(c), CLSLIST_NAME, str, slen);
-            snprintf(str, slen, "%s", CLSLIST_NAME(GET_CLASS(c)));
-          }
+          // sprinttype(GET_CLASS(c), CLSLIST_NAME, str, slen);
+          snprintf(str, slen, "%s", CLSLIST_NAME(GET_CLASS(c)));
         }
-        else if (!str_cmp(field, "con"))
+        break;
+      }
+      case DG_FIELD_CON:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            int max = 50;
-            c->real_abils.con += addition;
-            c->real_abils.con = MAX(3, MIN(c->real_abils.con, max));
-            affect_total(c);
-          }
-          snprintf(str, slen, "%d", GET_CON(c));
+          int addition = atoi(subfield);
+          int max = 50;
+          c->real_abils.con += addition;
+          c->real_abils.con = MAX(3, MIN(c->real_abils.con, max));
+          affect_total(c);
         }
+        snprintf(str, slen, "%d", GET_CON(c));
         break;
-      case 'd':
-        if (!str_cmp(field, "damroll"))
+      }
+      case DG_FIELD_DAMROLL:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_DAMROLL(c) = MAX(1, GET_DAMROLL(c) + addition);
-          }
-          snprintf(str, slen, "%d", GET_DAMROLL(c));
+          int addition = atoi(subfield);
+          GET_DAMROLL(c) = MAX(1, GET_DAMROLL(c) + addition);
         }
-        else if (!str_cmp(field, "dex"))
+        snprintf(str, slen, "%d", GET_DAMROLL(c));
+        break;
+      }
+      case DG_FIELD_DEX:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            int max = 50;
-            c->real_abils.dex += addition;
-            c->real_abils.dex = MAX(3, MIN(c->real_abils.dex, max));
-            affect_total(c);
-          }
-          snprintf(str, slen, "%d", GET_DEX(c));
+          int addition = atoi(subfield);
+          int max = 50;
+          c->real_abils.dex += addition;
+          c->real_abils.dex = MAX(3, MIN(c->real_abils.dex, max));
+          affect_total(c);
         }
-        else if (!str_cmp(field, "drunk"))
+        snprintf(str, slen, "%d", GET_DEX(c));
+        break;
+      }
+      case DG_FIELD_DRUNK:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_COND(c, DRUNK) = MAX(-1, MIN(addition, 24));
-          }
-          snprintf(str, slen, "%d", GET_COND(c, DRUNK));
+          int addition = atoi(subfield);
+          GET_COND(c, DRUNK) = MAX(-1, MIN(addition, 24));
         }
+        snprintf(str, slen, "%d", GET_COND(c, DRUNK));
         break;
-      case 'e':
-        if (!str_cmp(field, "eq"))
+      }
+      case DG_FIELD_EQ:
+      {
+        int pos;
+        if (!subfield || !*subfield)
+          *str = '\0';
+        else if (*subfield == '*')
         {
-          int pos;
-          if (!subfield || !*subfield)
+          for (i = 0, j = 0; i < NUM_WEARS; i++)
+            if (GET_EQ(c, i))
+            {
+              j++;
+              break;
+            }
+          if (j > 0)
+            strcpy(str, "1");
+          else
             *str = '\0';
-          else if (*subfield == '*')
+        }
+        else if ((pos = find_eq_pos_script(subfield)) < 0 || !GET_EQ(c, pos))
+          *str = '\0';
+        else
+          snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(GET_EQ(c, pos)));
+        break;
+      }
+      case DG_FIELD_EXP:
+      {
+        if (subfield && *subfield)
+        {
+          int addition = MIN(atoi(subfield), 1000);
+
+          gain_exp(c, addition, GAIN_EXP_MODE_SCRIPT);
+        }
+        snprintf(str, slen, "%ld", GET_EXP(c));
+        break;
+      }
+      case DG_FIELD_FEAT:
+        snprintf(str, slen, "%d", dg_has_feat(c, subfield, 0));
+        break;
+      case DG_FIELD_FIGHTING:
+      {
+        if (FIGHTING(c))
+          snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(FIGHTING(c)));
+        else
+          *str = '\0';
+        break;
+      }
+      case DG_FIELD_FOLLOWER:
+      {
+        if (!c->followers || !c->followers->follower)
+          *str = '\0';
+        else
+          snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(c->followers->follower));
+        break;
+      }
+      case DG_FIELD_GOLD:
+      {
+        if (subfield && *subfield)
+        {
+          int addition = atoi(subfield);
+          increase_gold(c, addition);
+        }
+        snprintf(str, slen, "%d", GET_GOLD(c));
+        break;
+      }
+      case DG_FIELD_HAS_ITEM:
+      {
+        if (!(subfield && *subfield))
+          *str = '\0';
+        else
+          snprintf(str, slen, "%d", char_has_item(subfield, c));
+        break;
+      }
+      case DG_FIELD_HAS_CLASS:
+      {
+        strcpy(str, "0");
+        if (subfield && *subfield)
+        {
+          int cl = get_class_by_name(subfield);
+          if (cl >= 0 && cl < NUM_CLASSES)
           {
-            for (i = 0, j = 0; i < NUM_WEARS; i++)
-              if (GET_EQ(c, i))
-              {
-                j++;
-                break;
-              }
-            if (j > 0)
+            if (CLASS_LEVEL(c, cl))
+            {
               strcpy(str, "1");
-            else
-              *str = '\0';
+            }
           }
-          else if ((pos = find_eq_pos_script(subfield)) < 0 || !GET_EQ(c, pos))
-            *str = '\0';
-          else
-            snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(GET_EQ(c, pos)));
         }
-        else if (!str_cmp(field, "exp"))
+        break;
+      }
+      case DG_FIELD_HASATTACHED:
+      {
+        if (!(subfield && *subfield) || !IS_NPC(c))
+          *str = '\0';
+        else
         {
-          if (subfield && *subfield)
-          {
-            int addition = MIN(atoi(subfield), 1000);
-
-            gain_exp(c, addition, GAIN_EXP_MODE_SCRIPT);
-          }
-          snprintf(str, slen, "%ld", GET_EXP(c));
+          i = atoi(subfield);
+          snprintf(str, slen, "%d", trig_is_attached(SCRIPT(c), i));
         }
         break;
-      case 'f':
-        if (!str_cmp(field, "feat"))
-          snprintf(str, slen, "%d", dg_has_feat(c, subfield, 0));
-        else if (!str_cmp(field, "fighting"))
+      }
+      case DG_FIELD_HESHE:
+        snprintf(str, slen, "%s", HSSH(c));
+        break;
+      case DG_FIELD_HIMHER:
+        snprintf(str, slen, "%s", HMHR(c));
+        break;
+      case DG_FIELD_HISHER:
+        snprintf(str, slen, "%s", HSHR(c));
+        break;
+      case DG_FIELD_HITP:
+      {
+        if (subfield && *subfield)
         {
-          if (FIGHTING(c))
-            snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(FIGHTING(c)));
-          else
-            *str = '\0';
+          int addition = atoi(subfield);
+          GET_HIT(c) += addition;
+          update_pos(c);
         }
-        else if (!str_cmp(field, "follower"))
+        snprintf(str, slen, "%d", GET_HIT(c));
+        break;
+      }
+      case DG_FIELD_HITROLL:
+      {
+        if (subfield && *subfield)
         {
-          if (!c->followers || !c->followers->follower)
-            *str = '\0';
-          else
-            snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(c->followers->follower));
+          int addition = atoi(subfield);
+          GET_HITROLL(c) = MAX(1, GET_HITROLL(c) + addition);
         }
+        snprintf(str, slen, "%d", GET_HITROLL(c));
         break;
-      case 'g':
-        if (!str_cmp(field, "gold"))
+      }
+      case DG_FIELD_HUNGER:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            increase_gold(c, addition);
-          }
-          snprintf(str, slen, "%d", GET_GOLD(c));
+          int addition = atoi(subfield);
+          GET_COND(c, HUNGER) = MAX(-1, MIN(addition, 24));
         }
+        snprintf(str, slen, "%d", GET_COND(c, HUNGER));
+        break;
+      }
+      case DG_FIELD_ID:
+        snprintf(str, slen, "%ld", char_script_id(c));
+        break;
+      /* new check for pc/npc status */
+      case DG_FIELD_IS_PC:
+      {
+        if (IS_NPC(c))
+          strcpy(str, "0");
+        else
+          strcpy(str, "1");
         break;
-      case 'h':
-        if (!str_cmp(field, "has_item"))
+      }
+      case DG_FIELD_INT:
+      {
+        if (subfield && *subfield)
         {
-          if (!(subfield && *subfield))
-            *str = '\0';
-          else
-            snprintf(str, slen, "%d", char_has_item(subfield, c));
+          int addition = atoi(subfield);
+          int max = 50;
+          c->real_abils.intel += addition;
+          c->real_abils.intel = MAX(3, MIN(c->real_abils.intel, max));
+          affect_total(c);
         }
-        else if (!str_cmp(field, "has_class"))
+        snprintf(str, slen, "%d", GET_INT(c));
+        break;
+      }
+      case DG_FIELD_INVENTORY:
+      {
+        if (subfield && *subfield)
         {
-          strcpy(str, "0");
-          if (subfield && *subfield)
+          for (obj = c->carrying; obj; obj = obj->next_content)
           {
-            int cl = get_class_by_name(subfield);
-            if (cl >= 0 && cl < NUM_CLASSES)
+            if (GET_OBJ_VNUM(obj) == atoidx(subfield))
             {
-              if (CLASS_LEVEL(c, cl))
-              {
-                strcpy(str, "1");
-              }
+              snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(obj)); /* arg given, found */
+              return;
             }
           }
+          if (!obj)
+            *str = '\0'; /* arg given, not found */
         }
-        else if (!str_cmp(field, "hasattached"))
-        {
-          if (!(subfield && *subfield) || !IS_NPC(c))
-            *str = '\0';
+        else
+        { /* no arg given */
+          if (c->carrying)
+          {
+            snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(c->carrying));
+          }
           else
           {
-            i = atoi(subfield);
-            snprintf(str, slen, "%d", trig_is_attached(SCRIPT(c), i));
+            *str = '\0';
           }
         }
-        else if (!str_cmp(field, "heshe"))
-          snprintf(str, slen, "%s", HSSH(c));
-        else if (!str_cmp(field, "himher"))
-          snprintf(str, slen, "%s", HMHR(c));
-        else if (!str_cmp(field, "hisher"))
-          snprintf(str, slen, "%s", HSHR(c));
-        else if (!str_cmp(field, "hitp"))
-        {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_HIT(c) += addition;
-            update_pos(c);
-          }
-          snprintf(str, slen, "%d", GET_HIT(c));
-        }
-        else if (!str_cmp(field, "hitroll"))
-        {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_HITROLL(c) = MAX(1, GET_HITROLL(c) + addition);
-          }
-          snprintf(str, slen, "%d", GET_HITROLL(c));
-        }
-        else if (!str_cmp(field, "hunger"))
-        {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_COND(c, HUNGER) = MAX(-1, MIN(addition, 24));
-          }
-          snprintf(str, slen, "%d", GET_COND(c, HUNGER));
-        }
         break;
-      case 'i':
-        if (!str_cmp(field, "id"))
-          snprintf(str, slen, "%ld", char_script_id(c));
-        /* new check for pc/npc status */
-        else if (!str_cmp(field, "is_pc"))
-        {
-          if (IS_NPC(c))
-            strcpy(str, "0");
-          else
-            strcpy(str, "1");
-        }
-        else if (!str_cmp(field, "int"))
-        {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            int max = 50;
-            c->real_abils.intel += addition;
-            c->real_abils.intel = MAX(3, MIN(c->real_abils.intel, max));
-            affect_total(c);
-          }
-          snprintf(str, slen, "%d", GET_INT(c));
-        }
-        else if (!str_cmp(field, "inventory"))
-        {
-          if (subfield && *subfield)
-          {
-            for (obj = c->carrying; obj; obj = obj->next_content)
-            {
-              if (GET_OBJ_VNUM(obj) == atoidx(subfield))
-              {
-                snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(obj)); /* arg given, found */
-                return;
-              }
-            }
-            if (!obj)
-              *str = '\0'; /* arg given, not found */
-          }
-          else
-          { /* no arg given */
-            if (c->carrying)
-            {
-              snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(c->carrying));
-            }
-            else
-            {
-              *str = '\0';
-            }
-          }
-        }
-        else if (!str_cmp(field, "is_killer"))
+      }
+      case DG_FIELD_IS_KILLER:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            if (!str_cmp("on", subfield))
-              SET_BIT_AR(PLR_FLAGS(c), PLR_KILLER);
-            else if (!str_cmp("off", subfield))
-              REMOVE_BIT_AR(PLR_FLAGS(c), PLR_KILLER);
-          }
-          if (PLR_FLAGGED(c, PLR_KILLER))
-            strcpy(str, "1");
-          else
-            strcpy(str, "0");
+          if (!str_cmp("on", subfield))
+            SET_BIT_AR(PLR_FLAGS(c), PLR_KILLER);
+          else if (!str_cmp("off", subfield))
+            REMOVE_BIT_AR(PLR_FLAGS(c), PLR_KILLER);
         }
+        if (PLR_FLAGGED(c, PLR_KILLER))
+          strcpy(str, "1");
+        else
+          strcpy(str, "0");
+        break;
+      }
 
-        else if (!str_cmp(field, "is_on_quest"))
+      case DG_FIELD_IS_ON_QUEST:
+      {
+        if (!IS_NPC(c) && subfield && *subfield)
         {
-          if (!IS_NPC(c) && subfield && *subfield)
-          {
-            int q_num = atoi(subfield);
-            bool found = FALSE;
-
-            /* loop through all the character's quest slots */
-            for (index = 0; index < MAX_CURRENT_QUESTS; index++)
-              if (GET_QUEST(c, index) == q_num)
-                found = TRUE;
+          int q_num = atoi(subfield);
+          bool found = FALSE;
 
-            if (found)
-              strcpy(str, "1");
-            else
-              strcpy(str, "0");
-          }
-          else
-            strcpy(str, "0");
-        }
+          /* loop through all the character's quest slots */
+          for (index = 0; index < MAX_CURRENT_QUESTS; index++)
+            if (GET_QUEST(c, index) == q_num)
+              found = TRUE;
 
-        else if (!str_cmp(field, "is_thief"))
-        {
-          if (subfield && *subfield)
-          {
-            if (!str_cmp("on", subfield))
-              SET_BIT_AR(PLR_FLAGS(c), PLR_THIEF);
-            else if (!str_cmp("off", subfield))
-              REMOVE_BIT_AR(PLR_FLAGS(c), PLR_THIEF);
-          }
-          if (PLR_FLAGGED(c, PLR_THIEF))
+          if (found)
             strcpy(str, "1");
           else
             strcpy(str, "0");
         }
+        else
+          strcpy(str, "0");
         break;
-      case 'l':
-        if (!str_cmp(field, "level"))
+      }
+
+      case DG_FIELD_IS_THIEF:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int lev = atoi(subfield);
-            GET_LEVEL(c) = MIN(MAX(lev, 0), LVL_IMMORT - 1);
-          }
-          else
-            snprintf(str, slen, "%d", GET_LEVEL(c));
+          if (!str_cmp("on", subfield))
+            SET_BIT_AR(PLR_FLAGS(c), PLR_THIEF);
+          else if (!str_cmp("off", subfield))
+            REMOVE_BIT_AR(PLR_FLAGS(c), PLR_THIEF);
         }
+        if (PLR_FLAGGED(c, PLR_THIEF))
+          strcpy(str, "1");
+        else
+          strcpy(str, "0");
         break;
-      case 'm':
-        if (!str_cmp(field, "psp"))
+      }
+      case DG_FIELD_LEVEL:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_PSP(c) += addition;
-          }
-          snprintf(str, slen, "%d", GET_PSP(c));
+          int lev = atoi(subfield);
+          GET_LEVEL(c) = MIN(MAX(lev, 0), LVL_IMMORT - 1);
         }
-        else if (!str_cmp(field, "master"))
+        else
+          snprintf(str, slen, "%d", GET_LEVEL(c));
+        break;
+      }
+      case DG_FIELD_PSP:
+      {
+        if (subfield && *subfield)
         {
-          if (!c->master)
-            *str = '\0';
-          else
-            snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(c->master));
+          int addition = atoi(subfield);
+          GET_PSP(c) += addition;
         }
-        else if (!str_cmp(field, "maxhitp"))
+        snprintf(str, slen, "%d", GET_PSP(c));
+        break;
+      }
+      case DG_FIELD_MASTER:
+      {
+        if (!c->master)
+          *str = '\0';
+        else
+          snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(c->master));
+        break;
+      }
+      case DG_FIELD_MAXHITP:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_MAX_HIT(c) = MAX(GET_MAX_HIT(c) + addition, 1);
-          }
-          snprintf(str, slen, "%d", GET_MAX_HIT(c));
+          int addition = atoi(subfield);
+          GET_MAX_HIT(c) = MAX(GET_MAX_HIT(c) + addition, 1);
         }
-        else if (!str_cmp(field, "maxpsp"))
+        snprintf(str, slen, "%d", GET_MAX_HIT(c));
+        break;
+      }
+      case DG_FIELD_MAXPSP:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_MAX_PSP(c) = MAX(GET_MAX_PSP(c) + addition, 1);
-          }
-          snprintf(str, slen, "%d", GET_MAX_PSP(c));
+          int addition = atoi(subfield);
+          GET_MAX_PSP(c) = MAX(GET_MAX_PSP(c) + addition, 1);
         }
-        else if (!str_cmp(field, "maxmove"))
+        snprintf(str, slen, "%d", GET_MAX_PSP(c));
+        break;
+      }
+      case DG_FIELD_MAXMOVE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_MAX_MOVE(c) = MAX(GET_MAX_MOVE(c) + addition, 1);
-          }
-          snprintf(str, slen, "%d", GET_MAX_MOVE(c));
+          int addition = atoi(subfield);
+          GET_MAX_MOVE(c) = MAX(GET_MAX_MOVE(c) + addition, 1);
         }
-        else if (!str_cmp(field, "move"))
+        snprintf(str, slen, "%d", GET_MAX_MOVE(c));
+        break;
+      }
+      case DG_FIELD_MOVE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_MOVE(c) += addition;
-          }
-          snprintf(str, slen, "%d", GET_MOVE(c));
+          int addition = atoi(subfield);
+          GET_MOVE(c) += addition;
         }
+        snprintf(str, slen, "%d", GET_MOVE(c));
+        break;
+      }
+      case DG_FIELD_NAME:
+        snprintf(str, slen, "%s", GET_NAME(c));
         break;
-      case 'n':
-        if (!str_cmp(field, "name"))
-          snprintf(str, slen, "%s", GET_NAME(c));
 
-        else if (!str_cmp(field, "npcflag"))
-        {
-          int flag = get_flag_by_name(action_bits, subfield);
+      case DG_FIELD_NPCFLAG:
+      {
+        int flag = get_flag_by_name(action_bits, subfield);
 
-          snprintf(str, slen, "%d",
-                   IS_NPC(c) && flag != (int)NOFLAG && MOB_FLAGGED(c, flag) ? TRUE : FALSE);
-        }
-        else if (!str_cmp(field, "next_in_room"))
-        {
-          if (c->next_in_room)
-            snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(c->next_in_room));
-          else
-            *str = '\0';
-        }
+        snprintf(str, slen, "%d",
+                 IS_NPC(c) && flag != (int)NOFLAG && MOB_FLAGGED(c, flag) ? TRUE : FALSE);
+        break;
+      }
+      case DG_FIELD_NEXT_IN_ROOM:
+      {
+        if (c->next_in_room)
+          snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(c->next_in_room));
+        else
+          *str = '\0';
         break;
-      case 'p':
-        /* Thanks to Christian Ejlertsen for this idea
-             And to Ken Ray for speeding the implementation up :)*/
-        if (!str_cmp(field, "pos"))
+      }
+      /* Thanks to Christian Ejlertsen for this idea
+           And to Ken Ray for speeding the implementation up :)*/
+      case DG_FIELD_POS:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
+          for (i = POS_SLEEPING; i <= POS_STANDING; i++)
           {
-            for (i = POS_SLEEPING; i <= POS_STANDING; i++)
+            /* allows : Sleeping, Resting, Sitting, Fighting, Standing */
+            if (!strn_cmp(subfield, position_types[i], strlen(subfield)))
             {
-              /* allows : Sleeping, Resting, Sitting, Fighting, Standing */
-              if (!strn_cmp(subfield, position_types[i], strlen(subfield)))
-              {
-                GET_POS(c) = i;
-                break;
-              }
+              GET_POS(c) = i;
+              break;
             }
           }
-          snprintf(str, slen, "%s", position_types[GET_POS(c)]);
         }
-        else if (!str_cmp(field, "prac"))
+        snprintf(str, slen, "%s", position_types[GET_POS(c)]);
+        break;
+      }
+      case DG_FIELD_PRAC:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_PRACTICES(c) = MAX(0, GET_PRACTICES(c) + addition);
-          }
-          snprintf(str, slen, "%d", GET_PRACTICES(c));
+          int addition = atoi(subfield);
+          GET_PRACTICES(c) = MAX(0, GET_PRACTICES(c) + addition);
         }
-        else if (!str_cmp(field, "pref"))
+        snprintf(str, slen, "%d", GET_PRACTICES(c));
+        break;
+      }
+      case DG_FIELD_PREF:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int pref = get_flag_by_name(preference_bits, subfield);
-            if (!IS_NPC(c) && pref != (int)NOFLAG && PRF_FLAGGED(c, pref))
-              strcpy(str, "1");
-            else
-              strcpy(str, "0");
-          }
+          int pref = get_flag_by_name(preference_bits, subfield);
+          if (!IS_NPC(c) && pref != (int)NOFLAG && PRF_FLAGGED(c, pref))
+            strcpy(str, "1");
           else
             strcpy(str, "0");
         }
+        else
+          strcpy(str, "0");
         break;
-      case 'q':
+      }
 
-        if (!IS_NPC(c) &&
-            (!str_cmp(field, "questpoints") || !str_cmp(field, "qp") || !str_cmp(field, "qpnts")))
+      case DG_FIELD_QUESTPOINTS:
+      case DG_FIELD_QP:
+      case DG_FIELD_QPNTS:
+        if (!IS_NPC(c))
         {
           if (subfield && *subfield)
           {
@@ -1282,502 +1633,541 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
           }
           snprintf(str, slen, "%d", GET_QUESTPOINTS(c));
         }
+        break;
 
-        else if (!str_cmp(field, "quest"))
-        {
-          int index = 0;
-          bool found = FALSE;
+      case DG_FIELD_QUEST:
+      {
+        int index = 0;
+        bool found = FALSE;
 
-          for (index = 0; index < MAX_CURRENT_QUESTS; index++)
-          { /* loop through all the character's quest slots */
-            if (!IS_NPC(c) && (GET_QUEST(c, index) != (int)NOTHING) &&
-                (real_quest(GET_QUEST(c, index)) != NOTHING))
-            {
-              snprintf(str, slen, "%d", GET_QUEST(c, index));
-              found = TRUE;
-              break;
-            }
+        for (index = 0; index < MAX_CURRENT_QUESTS; index++)
+        { /* loop through all the character's quest slots */
+          if (!IS_NPC(c) && (GET_QUEST(c, index) != (int)NOTHING) &&
+              (real_quest(GET_QUEST(c, index)) != NOTHING))
+          {
+            snprintf(str, slen, "%d", GET_QUEST(c, index));
+            found = TRUE;
+            break;
           }
-
-          if (!found)
-            strcpy(str, "0");
         }
 
-        else if (!str_cmp(field, "questdone"))
+        if (!found)
+          strcpy(str, "0");
+        break;
+      }
+
+      case DG_FIELD_QUESTDONE:
+      {
+        if (!IS_NPC(c) && subfield && *subfield)
         {
-          if (!IS_NPC(c) && subfield && *subfield)
-          {
-            int q_num = atoi(subfield);
-            if (is_complete(c, q_num))
-              strcpy(str, "1");
-            else
-              strcpy(str, "0");
-          }
+          int q_num = atoi(subfield);
+          if (is_complete(c, q_num))
+            strcpy(str, "1");
           else
             strcpy(str, "0");
         }
-
+        else
+          strcpy(str, "0");
         break;
-      case 'r':
-        if (!str_cmp(field, "race"))
+      }
+
+      case DG_FIELD_RACE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
+          int ra = get_race_by_name(subfield);
+          if (ra != -1)
           {
-            int ra = get_race_by_name(subfield);
-            if (ra != -1)
-            {
-              GET_REAL_RACE(c) = ra;
-              snprintf(str, slen, "1");
-            }
-            else
-            {
-              snprintf(str, slen, "0");
-            }
+            GET_REAL_RACE(c) = ra;
+            snprintf(str, slen, "1");
           }
           else
           {
-            snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
-            // sprinttype(GET_RACE(c), pc_race_types, str, slen);
+            snprintf(str, slen, "0");
           }
         }
-        else if (!str_cmp(field, "resist_fire"))
+        else
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_FIRE) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_FIRE));
+          snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
+          // sprinttype(GET_RACE(c), pc_race_types, str, slen);
         }
-        else if (!str_cmp(field, "resist_cold"))
+        break;
+      }
+      case DG_FIELD_RESIST_FIRE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_COLD) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_COLD));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_FIRE) += addition;
         }
-        else if (!str_cmp(field, "resist_air"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_FIRE));
+        break;
+      }
+      case DG_FIELD_RESIST_COLD:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_AIR) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_AIR));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_COLD) += addition;
         }
-        else if (!str_cmp(field, "resist_earth"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_COLD));
+        break;
+      }
+      case DG_FIELD_RESIST_AIR:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_EARTH) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_EARTH));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_AIR) += addition;
         }
-        else if (!str_cmp(field, "resist_acid"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_AIR));
+        break;
+      }
+      case DG_FIELD_RESIST_EARTH:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_ACID) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ACID));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_EARTH) += addition;
         }
-        else if (!str_cmp(field, "resist_holy"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_EARTH));
+        break;
+      }
+      case DG_FIELD_RESIST_ACID:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_HOLY) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_HOLY));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_ACID) += addition;
         }
-        else if (!str_cmp(field, "resist_electric"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ACID));
+        break;
+      }
+      case DG_FIELD_RESIST_HOLY:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_ELECTRIC) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ELECTRIC));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_HOLY) += addition;
         }
-        else if (!str_cmp(field, "resist_unholy"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_HOLY));
+        break;
+      }
+      case DG_FIELD_RESIST_ELECTRIC:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_UNHOLY) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_UNHOLY));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_ELECTRIC) += addition;
         }
-        else if (!str_cmp(field, "resist_slice"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ELECTRIC));
+        break;
+      }
+      case DG_FIELD_RESIST_UNHOLY:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_SLICE) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_SLICE));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_UNHOLY) += addition;
+        }
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_UNHOLY));
+        break;
+      }
+      case DG_FIELD_RESIST_SLICE:
+      {
+        if (subfield && *subfield)
+        {
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_SLICE) += addition;
         }
-        else if (!str_cmp(field, "resist_puncture"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_SLICE));
+        break;
+      }
+      case DG_FIELD_RESIST_PUNCTURE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_PUNCTURE) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_PUNCTURE));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_PUNCTURE) += addition;
         }
-        else if (!str_cmp(field, "resist_force"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_PUNCTURE));
+        break;
+      }
+      case DG_FIELD_RESIST_FORCE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_FORCE) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_FORCE));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_FORCE) += addition;
         }
-        else if (!str_cmp(field, "resist_sound"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_FORCE));
+        break;
+      }
+      case DG_FIELD_RESIST_SOUND:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_SOUND) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_SOUND));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_SOUND) += addition;
         }
-        else if (!str_cmp(field, "resist_poison"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_SOUND));
+        break;
+      }
+      case DG_FIELD_RESIST_POISON:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_POISON) += addition;
-            GET_RESISTANCES(c, DAM_CELESTIAL_POISON) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_POISON));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_POISON) += addition;
+          GET_RESISTANCES(c, DAM_CELESTIAL_POISON) += addition;
         }
-        else if (!str_cmp(field, "resist_disease"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_POISON));
+        break;
+      }
+      case DG_FIELD_RESIST_DISEASE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_DISEASE) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_DISEASE));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_DISEASE) += addition;
         }
-        else if (!str_cmp(field, "resist_negative"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_DISEASE));
+        break;
+      }
+      case DG_FIELD_RESIST_NEGATIVE:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_NEGATIVE) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_NEGATIVE));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_NEGATIVE) += addition;
         }
-        else if (!str_cmp(field, "resist_illusion"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_NEGATIVE));
+        break;
+      }
+      case DG_FIELD_RESIST_ILLUSION:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_ILLUSION) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ILLUSION));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_ILLUSION) += addition;
         }
-        else if (!str_cmp(field, "resist_mental"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ILLUSION));
+        break;
+      }
+      case DG_FIELD_RESIST_MENTAL:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_MENTAL) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_MENTAL));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_MENTAL) += addition;
         }
-        else if (!str_cmp(field, "resist_light"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_MENTAL));
+        break;
+      }
+      case DG_FIELD_RESIST_LIGHT:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_LIGHT) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_LIGHT));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_LIGHT) += addition;
         }
-        else if (!str_cmp(field, "resist_energy"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_LIGHT));
+        break;
+      }
+      case DG_FIELD_RESIST_ENERGY:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_ENERGY) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ENERGY));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_ENERGY) += addition;
         }
-        else if (!str_cmp(field, "resist_water"))
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_ENERGY));
+        break;
+      }
+      case DG_FIELD_RESIST_WATER:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_RESISTANCES(c, DAM_WATER) += addition;
-          }
-          snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_WATER));
+          int addition = atoi(subfield);
+          GET_RESISTANCES(c, DAM_WATER) += addition;
         }
-        else if (!str_cmp(field, "room"))
-        { /* in NOWHERE, return the void */
-          /* see note in dg_scripts.h */
+        snprintf(str, slen, "%d", GET_RESISTANCES(c, DAM_WATER));
+        break;
+      }
+      case DG_FIELD_ROOM:
+      { /* in NOWHERE, return the void */
+        /* see note in dg_scripts.h */
 #ifdef ACTOR_ROOM_IS_UID
-          snprintf(str, slen, "%c%ld", UID_CHAR,
-                   (IN_ROOM(c) != NOWHERE) ? (long)world[IN_ROOM(c)].number + ROOM_ID_BASE
-                                           : ROOM_ID_BASE);
+        snprintf(str, slen, "%c%ld", UID_CHAR,
+                 (IN_ROOM(c) != NOWHERE) ? (long)world[IN_ROOM(c)].number + ROOM_ID_BASE
+                                         : ROOM_ID_BASE);
 #else
-          snprintf(str, slen, "%d", (IN_ROOM(c) != NOWHERE) ? world[IN_ROOM(c)].number : 0);
+        snprintf(str, slen, "%d", (IN_ROOM(c) != NOWHERE) ? world[IN_ROOM(c)].number : 0);
 #endif
+        break;
+      }
+      case DG_FIELD_SAVING_DEATH:
+      {
+        if (subfield && *subfield)
+        {
+          int addition = atoi(subfield);
+          GET_SAVE(c, SAVING_DEATH) += addition;
         }
+        snprintf(str, slen, "%d", GET_SAVE(c, SAVING_DEATH));
         break;
-      case 's':
-        if (!str_cmp(field, "saving_death"))
+      }
+      case DG_FIELD_SAVING_POISON:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_SAVE(c, SAVING_DEATH) += addition;
-          }
-          snprintf(str, slen, "%d", GET_SAVE(c, SAVING_DEATH));
+          int addition = atoi(subfield);
+          GET_SAVE(c, SAVING_POISON) += addition;
         }
-        else if (!str_cmp(field, "saving_poison"))
+        snprintf(str, slen, "%d", GET_SAVE(c, SAVING_POISON));
+        break;
+      }
+      case DG_FIELD_SAVING_FORT:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_SAVE(c, SAVING_POISON) += addition;
-          }
-          snprintf(str, slen, "%d", GET_SAVE(c, SAVING_POISON));
+          int addition = atoi(subfield);
+          GET_SAVE(c, SAVING_FORT) += addition;
         }
-        else if (!str_cmp(field, "saving_fort"))
+        snprintf(str, slen, "%d", GET_SAVE(c, SAVING_FORT));
+        break;
+      }
+      case DG_FIELD_SAVING_REFL:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_SAVE(c, SAVING_FORT) += addition;
-          }
-          snprintf(str, slen, "%d", GET_SAVE(c, SAVING_FORT));
+          int addition = atoi(subfield);
+          GET_SAVE(c, SAVING_REFL) += addition;
         }
-        else if (!str_cmp(field, "saving_refl"))
+        snprintf(str, slen, "%d", GET_SAVE(c, SAVING_REFL));
+        break;
+      }
+      case DG_FIELD_SAVING_WILL:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_SAVE(c, SAVING_REFL) += addition;
-          }
-          snprintf(str, slen, "%d", GET_SAVE(c, SAVING_REFL));
+          int addition = atoi(subfield);
+          GET_SAVE(c, SAVING_WILL) += addition;
         }
-        else if (!str_cmp(field, "saving_will"))
+        snprintf(str, slen, "%d", GET_SAVE(c, SAVING_WILL));
+        break;
+      }
+      case DG_FIELD_SEX:
+        snprintf(str, slen, "%s", genders[(int)GET_SEX(c)]);
+        break;
+      case DG_FIELD_SIZE:
+        snprintf(str, slen, "%s", size_names[(int)GET_SIZE(c)]);
+        break;
+      case DG_FIELD_SIZENUMBER:
+        snprintf(str, slen, "%d", (int)GET_SIZE(c));
+        break;
+      case DG_FIELD_SKILL:
+        snprintf(str, slen, "%s", skill_percent(c, subfield));
+        break;
+      case DG_FIELD_SKILLROLL:
+        snprintf(str, slen, "%s", skill_percent_plus_d20(c, subfield));
+        break;
+      case DG_FIELD_SKILLSET:
+      {
+        if (!IS_NPC(c) && subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_SAVE(c, SAVING_WILL) += addition;
-          }
-          snprintf(str, slen, "%d", GET_SAVE(c, SAVING_WILL));
-        }
-        else if (!str_cmp(field, "sex"))
-          snprintf(str, slen, "%s", genders[(int)GET_SEX(c)]);
-        else if (!str_cmp(field, "size"))
-          snprintf(str, slen, "%s", size_names[(int)GET_SIZE(c)]);
-        else if (!str_cmp(field, "sizenumber"))
-          snprintf(str, slen, "%d", (int)GET_SIZE(c));
-        else if (!str_cmp(field, "skill"))
-          snprintf(str, slen, "%s", skill_percent(c, subfield));
-        else if (!str_cmp(field, "skillroll"))
-          snprintf(str, slen, "%s", skill_percent_plus_d20(c, subfield));
-        else if (!str_cmp(field, "skillset"))
-        {
-          if (!IS_NPC(c) && subfield && *subfield)
+          char skillname[MAX_INPUT_LENGTH] = {'\0'}, *amount;
+          amount = one_word(subfield, skillname);
+          skip_spaces(&amount);
+          if (amount && *amount && is_number(amount))
           {
-            char skillname[MAX_INPUT_LENGTH] = {'\0'}, *amount;
-            amount = one_word(subfield, skillname);
-            skip_spaces(&amount);
-            if (amount && *amount && is_number(amount))
+            int skillnum = find_skill_num(skillname);
+            if (skillnum > 0)
             {
-              int skillnum = find_skill_num(skillname);
-              if (skillnum > 0)
-              {
-                int new_value = MAX(0, MIN(100, atoi(amount)));
-                SET_SKILL(c, skillnum, new_value);
-              }
+              int new_value = MAX(0, MIN(100, atoi(amount)));
+              SET_SKILL(c, skillnum, new_value);
             }
           }
-          *str = '\0'; /* so the parser know we recognize 'skillset' as a field */
         }
-        else if (!str_cmp(field, "str"))
+        *str = '\0'; /* so the parser know we recognize 'skillset' as a field */
+        break;
+      }
+      case DG_FIELD_STR:
+      {
+        if (subfield && *subfield)
+        {
+          int addition = atoi(subfield);
+          int max = 50;
+          c->real_abils.str += addition;
+          c->real_abils.str = MAX(3, MIN(c->real_abils.str, max));
+          affect_total(c);
+        }
+        snprintf(str, slen, "%d", GET_STR(c));
+        break;
+      }
+      case DG_FIELD_STRADD:
+      {
+        if (GET_STR(c) >= 18)
         {
           if (subfield && *subfield)
           {
             int addition = atoi(subfield);
-            int max = 50;
-            c->real_abils.str += addition;
-            c->real_abils.str = MAX(3, MIN(c->real_abils.str, max));
+            c->real_abils.str_add += addition;
+            c->real_abils.str_add = MAX(0, MIN(c->real_abils.str_add, 100));
             affect_total(c);
           }
-          snprintf(str, slen, "%d", GET_STR(c));
-        }
-        else if (!str_cmp(field, "stradd"))
-        {
-          if (GET_STR(c) >= 18)
-          {
-            if (subfield && *subfield)
-            {
-              int addition = atoi(subfield);
-              c->real_abils.str_add += addition;
-              c->real_abils.str_add = MAX(0, MIN(c->real_abils.str_add, 100));
-              affect_total(c);
-            }
-            snprintf(str, slen, "%d", GET_ADD(c));
-          }
+          snprintf(str, slen, "%d", GET_ADD(c));
         }
-        else if (!str_cmp(field, "subrace1"))
+        break;
+      }
+      case DG_FIELD_SUBRACE1:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
+          int ra = get_subrace_by_name(subfield);
+          if (ra != -1)
           {
-            int ra = get_subrace_by_name(subfield);
-            if (ra != -1)
-            {
-              GET_SUBRACE(c, 0) = ra;
-              snprintf(str, slen, "1");
-            }
-            else
-            {
-              snprintf(str, slen, "0");
-            }
+            GET_SUBRACE(c, 0) = ra;
+            snprintf(str, slen, "1");
           }
           else
           {
-            snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
-            // sprinttype(GET_RACE(c), pc_race_types, str, slen);
+            snprintf(str, slen, "0");
           }
         }
-        else if (!str_cmp(field, "subrace2"))
+        else
         {
-          if (subfield && *subfield)
+          snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
+          // sprinttype(GET_RACE(c), pc_race_types, str, slen);
+        }
+        break;
+      }
+      case DG_FIELD_SUBRACE2:
+      {
+        if (subfield && *subfield)
+        {
+          int ra = get_subrace_by_name(subfield);
+          if (ra != -1)
           {
-            int ra = get_subrace_by_name(subfield);
-            if (ra != -1)
-            {
-              GET_SUBRACE(c, 1) = ra;
-              snprintf(str, slen, "1");
-            }
-            else
-            {
-              snprintf(str, slen, "0");
-            }
+            GET_SUBRACE(c, 1) = ra;
+            snprintf(str, slen, "1");
           }
           else
           {
-            snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
-            // sprinttype(GET_RACE(c), pc_race_types, str, slen);
+            snprintf(str, slen, "0");
           }
         }
-        else if (!str_cmp(field, "subrace3"))
+        else
         {
-          if (subfield && *subfield)
+          snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
+          // sprinttype(GET_RACE(c), pc_race_types, str, slen);
+        }
+        break;
+      }
+      case DG_FIELD_SUBRACE3:
+      {
+        if (subfield && *subfield)
+        {
+          int ra = get_subrace_by_name(subfield);
+          if (ra != -1)
           {
-            int ra = get_subrace_by_name(subfield);
-            if (ra != -1)
-            {
-              GET_SUBRACE(c, 2) = ra;
-              snprintf(str, slen, "1");
-            }
-            else
-            {
-              snprintf(str, slen, "0");
-            }
+            GET_SUBRACE(c, 2) = ra;
+            snprintf(str, slen, "1");
           }
           else
           {
-            snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
-            // sprinttype(GET_RACE(c), pc_race_types, str, slen);
+            snprintf(str, slen, "0");
           }
         }
-        break;
-      case 't':
-        if (!str_cmp(field, "thirst"))
+        else
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_COND(c, THIRST) = MAX(-1, MIN(addition, 24));
-          }
-          snprintf(str, slen, "%d", GET_COND(c, THIRST));
+          snprintf(str, slen, "%s", race_list[GET_RACE(c)].type);
+          // sprinttype(GET_RACE(c), pc_race_types, str, slen);
         }
-        else if (!str_cmp(field, "title"))
+        break;
+      }
+      case DG_FIELD_THIRST:
+      {
+        if (subfield && *subfield)
         {
-          if (!IS_NPC(c) && subfield && *subfield && valid_dg_target(c, DG_ALLOW_STAFFS))
-          {
-            if (GET_TITLE(c))
-              free(GET_TITLE(c));
-            GET_TITLE(c) = strdup(subfield);
-          }
-          snprintf(str, slen, "%s", IS_NPC(c) ? "" : GET_TITLE(c));
+          int addition = atoi(subfield);
+          GET_COND(c, THIRST) = MAX(-1, MIN(addition, 24));
         }
+        snprintf(str, slen, "%d", GET_COND(c, THIRST));
         break;
-      case 'v':
-        if (!str_cmp(field, "varexists"))
+      }
+      case DG_FIELD_TITLE:
+      {
+        if (!IS_NPC(c) && subfield && *subfield && valid_dg_target(c, DG_ALLOW_STAFFS))
         {
-          struct trig_var_data *remote_vd;
-          strcpy(str, "0");
-          if (SCRIPT(c))
-          {
-            for (remote_vd = SCRIPT(c)->global_vars; remote_vd; remote_vd = remote_vd->next)
-            {
-              if (!str_cmp(remote_vd->name, subfield))
-                break;
-            }
-            if (remote_vd)
-              strcpy(str, "1");
-          }
+          if (GET_TITLE(c))
+            free(GET_TITLE(c));
+          GET_TITLE(c) = strdup(subfield);
         }
-        else if (!str_cmp(field, "vnum"))
+        snprintf(str, slen, "%s", IS_NPC(c) ? "" : GET_TITLE(c));
+        break;
+      }
+      case DG_FIELD_VAREXISTS:
+      {
+        struct trig_var_data *remote_vd;
+        strcpy(str, "0");
+        if (SCRIPT(c))
         {
-          if (subfield && *subfield)
+          for (remote_vd = SCRIPT(c)->global_vars; remote_vd; remote_vd = remote_vd->next)
           {
-            snprintf(str, slen, "%d", IS_NPC(c) ? (int)(GET_MOB_VNUM(c) == atoidx(subfield)) : 0);
-          }
-          else
-          {
-            if (IS_NPC(c))
-              snprintf(str, slen, "%u", GET_MOB_VNUM(c));
-            else
-              /*
-               * for compatibility with unsigned indexes
-               * - this is deprecated - use %actor.is_pc% to check
-               * instead of %actor.vnum% == -1  --Welcor 09/03
-               */
-              strcpy(str, "-1");
+            if (!str_cmp(remote_vd->name, subfield))
+              break;
           }
+          if (remote_vd)
+            strcpy(str, "1");
         }
         break;
-      case 'w':
-        if (!str_cmp(field, "wait"))
+      }
+      case DG_FIELD_VNUM:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-            GET_WAIT_STATE(c) = MAX(0, atoi(subfield)) * (PULSE_VIOLENCE / 2);
-          snprintf(str, slen, "%d", GET_WAIT_STATE(c));
+          snprintf(str, slen, "%d", IS_NPC(c) ? (int)(GET_MOB_VNUM(c) == atoidx(subfield)) : 0);
         }
-        else if (!str_cmp(field, "weight"))
-          snprintf(str, slen, "%d", GET_WEIGHT(c));
-        else if (!str_cmp(field, "wis"))
+        else
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            int max = 50;
-            c->real_abils.wis += addition;
-            c->real_abils.wis = MAX(3, MIN(c->real_abils.wis, max));
-            affect_total(c);
-          }
-          snprintf(str, slen, "%d", GET_WIS(c));
+          if (IS_NPC(c))
+            snprintf(str, slen, "%u", GET_MOB_VNUM(c));
+          else
+            /*
+             * for compatibility with unsigned indexes
+             * - this is deprecated - use %actor.is_pc% to check
+             * instead of %actor.vnum% == -1  --Welcor 09/03
+             */
+            strcpy(str, "-1");
+        }
+        break;
+      }
+      case DG_FIELD_WAIT:
+      {
+        if (subfield && *subfield)
+          GET_WAIT_STATE(c) = MAX(0, atoi(subfield)) * (PULSE_VIOLENCE / 2);
+        snprintf(str, slen, "%d", GET_WAIT_STATE(c));
+        break;
+      }
+      case DG_FIELD_WEIGHT:
+        snprintf(str, slen, "%d", GET_WEIGHT(c));
+        break;
+      case DG_FIELD_WIS:
+      {
+        if (subfield && *subfield)
+        {
+          int addition = atoi(subfield);
+          int max = 50;
+          c->real_abils.wis += addition;
+          c->real_abils.wis = MAX(3, MIN(c->real_abils.wis, max));
+          affect_total(c);
         }
+        snprintf(str, slen, "%d", GET_WIS(c));
+        break;
+      }
+      default:
         break;
-      } /* switch *field */
+      } /* switch field */
 
       if (*str == '\x1')
       { /* no match found in switch */
@@ -1810,229 +2200,233 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
     else if (o)
     {
       *str = '\x1';
-      switch (LOWER(*field))
+      switch (dg_field_id(field))
+      {
+      case DG_FIELD_AFFECTS:
       {
-      case 'a':
-        if (!str_cmp(field, "affects"))
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            if (check_flags_by_name_ar(GET_OBJ_AFFECT(o), NUM_AFF_FLAGS, subfield, affected_bits) ==
-                    TRUE ||
-                check_flags_by_name_ar(GET_OBJ2_AFFECT(o), NUM_AFF2_FLAGS, subfield,
-                                       affected2_bits) == TRUE)
-              snprintf(str, slen, "1");
-            else
-              snprintf(str, slen, "0");
-          }
+          if (check_flags_by_name_ar(GET_OBJ_AFFECT(o), NUM_AFF_FLAGS, subfield, affected_bits) ==
+                  TRUE ||
+              check_flags_by_name_ar(GET_OBJ2_AFFECT(o), NUM_AFF2_FLAGS, subfield,
+                                     affected2_bits) == TRUE)
+            snprintf(str, slen, "1");
           else
             snprintf(str, slen, "0");
         }
+        else
+          snprintf(str, slen, "0");
         break;
-      case 'b':
-        if (!str_cmp(field, "bound"))
-        {
-          if (GET_OBJ_BOUND_ID(o) != (int)NOBODY)
-          {
-            snprintf(str, slen, "%c%ld", UID_CHAR, (long)GET_OBJ_BOUND_ID(o));
-          }
-          else
-          {
-            *str = '\0';
-          }
-        }
-        break;
-      case 'c':
-        if (!str_cmp(field, "cost"))
-        {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_OBJ_COST(o) = MAX(1, addition + GET_OBJ_COST(o));
-          }
-          snprintf(str, slen, "%d", GET_OBJ_COST(o));
-        }
-        else if (!str_cmp(field, "cost_per_day"))
+      }
+      case DG_FIELD_BOUND:
+      {
+        if (GET_OBJ_BOUND_ID(o) != (int)NOBODY)
         {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_OBJ_RENT(o) = MAX(1, addition + GET_OBJ_RENT(o));
-          }
-          snprintf(str, slen, "%d", GET_OBJ_RENT(o));
+          snprintf(str, slen, "%c%ld", UID_CHAR, (long)GET_OBJ_BOUND_ID(o));
         }
-        else if (!str_cmp(field, "carried_by"))
+        else
         {
-          if (o->carried_by)
-            snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(o->carried_by));
-          else
-            *str = '\0';
+          *str = '\0';
         }
-        else if (!str_cmp(field, "contents"))
-        {
-          if (o->contains)
-            snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(o->contains));
-          else
-            *str = '\0';
-        } /* thanks to Jamie Nelson (Mordecai of 4 Dimensions MUD) */
-        else if (!str_cmp(field, "count"))
+        break;
+      }
+      case DG_FIELD_COST:
+      {
+        if (subfield && *subfield)
         {
-          if (GET_OBJ_TYPE(o) == ITEM_CONTAINER || GET_OBJ_TYPE(o) == ITEM_AMMO_POUCH)
-            snprintf(str, slen, "%d", item_in_list(subfield, o->contains));
-          else
-            strcpy(str, "0");
+          int addition = atoi(subfield);
+          GET_OBJ_COST(o) = MAX(1, addition + GET_OBJ_COST(o));
         }
+        snprintf(str, slen, "%d", GET_OBJ_COST(o));
         break;
-      case 'e':
-        if (!str_cmp(field, "extra"))
+      }
+      case DG_FIELD_COST_PER_DAY:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            if (check_flags_by_name_ar(GET_OBJ_EXTRA(o), NUM_ITEM_FLAGS, subfield, extra_bits) > 0)
-              snprintf(str, slen, "1");
-            else
-              snprintf(str, slen, "0");
-          }
-          else
-          {
-            sprintbitarray(GET_OBJ_EXTRA(o), extra_bits, EF_ARRAY_MAX, str);
-          }
+          int addition = atoi(subfield);
+          GET_OBJ_RENT(o) = MAX(1, addition + GET_OBJ_RENT(o));
         }
+        snprintf(str, slen, "%d", GET_OBJ_RENT(o));
+        break;
+      }
+      case DG_FIELD_CARRIED_BY:
+      {
+        if (o->carried_by)
+          snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(o->carried_by));
+        else
+          *str = '\0';
+        break;
+      }
+      case DG_FIELD_CONTENTS:
+      {
+        if (o->contains)
+          snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(o->contains));
+        else
+          *str = '\0';
+        break;
+      } /* thanks to Jamie Nelson (Mordecai of 4 Dimensions MUD) */
+      case DG_FIELD_COUNT:
+      {
+        if (GET_OBJ_TYPE(o) == ITEM_CONTAINER || GET_OBJ_TYPE(o) == ITEM_AMMO_POUCH)
+          snprintf(str, slen, "%d", item_in_list(subfield, o->contains));
+        else
+          strcpy(str, "0");
         break;
-      case 'h':
-        /* thanks to Jamie Nelson (Mordecai of 4 Dimensions MUD) */
-        if (!str_cmp(field, "has_in"))
+      }
+      case DG_FIELD_EXTRA:
+      {
+        if (subfield && *subfield)
         {
-          if (GET_OBJ_TYPE(o) == ITEM_CONTAINER || GET_OBJ_TYPE(o) == ITEM_AMMO_POUCH)
-            snprintf(str, slen, "%s", (item_in_list(subfield, o->contains) ? "1" : "0"));
+          if (check_flags_by_name_ar(GET_OBJ_EXTRA(o), NUM_ITEM_FLAGS, subfield, extra_bits) > 0)
+            snprintf(str, slen, "1");
           else
-            strcpy(str, "0");
+            snprintf(str, slen, "0");
         }
-        else if (!str_cmp(field, "hasattached"))
+        else
         {
-          if (!(subfield && *subfield))
-            *str = '\0';
-          else
-          {
-            i = atoi(subfield);
-            snprintf(str, slen, "%d", trig_is_attached(SCRIPT(o), i));
-          }
+          sprintbitarray(GET_OBJ_EXTRA(o), extra_bits, EF_ARRAY_MAX, str);
         }
         break;
-      case 'i':
-        if (!str_cmp(field, "id"))
-          snprintf(str, slen, "%ld", obj_script_id(o));
-
-        else if (!str_cmp(field, "is_inroom"))
-        {
-          if (IN_ROOM(o) != NOWHERE)
-            snprintf(str, slen, "%c%ld", UID_CHAR, (long)world[IN_ROOM(o)].number + ROOM_ID_BASE);
-          else
-            *str = '\0';
-        }
-        else if (!str_cmp(field, "is_pc"))
+      }
+      /* thanks to Jamie Nelson (Mordecai of 4 Dimensions MUD) */
+      case DG_FIELD_HAS_IN:
+      {
+        if (GET_OBJ_TYPE(o) == ITEM_CONTAINER || GET_OBJ_TYPE(o) == ITEM_AMMO_POUCH)
+          snprintf(str, slen, "%s", (item_in_list(subfield, o->contains) ? "1" : "0"));
+        else
+          strcpy(str, "0");
+        break;
+      }
+      case DG_FIELD_HASATTACHED:
+      {
+        if (!(subfield && *subfield))
+          *str = '\0';
+        else
         {
-          strcpy(str, "-1");
+          i = atoi(subfield);
+          snprintf(str, slen, "%d", trig_is_attached(SCRIPT(o), i));
         }
         break;
-      case 'n':
-        if (!str_cmp(field, "name"))
-          snprintf(str, slen, "%s", o->name);
+      }
+      case DG_FIELD_ID:
+        snprintf(str, slen, "%ld", obj_script_id(o));
+        break;
+
+      case DG_FIELD_IS_INROOM:
+      {
+        if (IN_ROOM(o) != NOWHERE)
+          snprintf(str, slen, "%c%ld", UID_CHAR, (long)world[IN_ROOM(o)].number + ROOM_ID_BASE);
+        else
+          *str = '\0';
+        break;
+      }
+      case DG_FIELD_IS_PC:
+      {
+        strcpy(str, "-1");
+        break;
+      }
+      case DG_FIELD_NAME:
+        snprintf(str, slen, "%s", o->name);
+        break;
 
-        else if (!str_cmp(field, "next_in_list"))
+      case DG_FIELD_NEXT_IN_LIST:
+      {
+        if (o->next_content)
+          snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(o->next_content));
+        else
+          *str = '\0';
+        break;
+      }
+      case DG_FIELD_OSET:
+      {
+        if (subfield && *subfield)
         {
-          if (o->next_content)
-            snprintf(str, slen, "%c%ld", UID_CHAR, obj_script_id(o->next_content));
+          if (handle_oset(o, subfield))
+            strcpy(str, "1");
           else
-            *str = '\0';
+            strcpy(str, "0");
         }
         break;
-      case 'o':
-        if (!str_cmp(field, "oset"))
+      }
+      case DG_FIELD_ROOM:
+      {
+        room_rnum rm = obj_room(o);
+        if (VALID_ROOM_RNUM(rm))
+          snprintf(str, slen, "%c%ld", UID_CHAR, (long)world[rm].number + ROOM_ID_BASE);
+        else
+          *str = '\0';
+        break;
+      }
+      case DG_FIELD_SHORTDESC:
+        snprintf(str, slen, "%s", o->short_description);
+        break;
+      case DG_FIELD_TYPE:
+        sprinttype(GET_OBJ_TYPE(o), item_types, str, slen);
+        break;
+
+      case DG_FIELD_TIMER:
+        snprintf(str, slen, "%d", GET_OBJ_TIMER(o));
+        break;
+      case DG_FIELD_VNUM:
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            if (handle_oset(o, subfield))
-              strcpy(str, "1");
-            else
-              strcpy(str, "0");
-          }
+          snprintf(str, slen, "%d", (int)(GET_OBJ_VNUM(o) == atoidx(subfield)));
         }
-        break;
-      case 'r':
-        if (!str_cmp(field, "room"))
+        else
         {
-          room_rnum rm = obj_room(o);
-          if (VALID_ROOM_RNUM(rm))
-            snprintf(str, slen, "%c%ld", UID_CHAR, (long)world[rm].number + ROOM_ID_BASE);
-          else
-            *str = '\0';
+          snprintf(str, slen, "%u", GET_OBJ_VNUM(o));
         }
         break;
-      case 's':
-        if (!str_cmp(field, "shortdesc"))
-          snprintf(str, slen, "%s", o->short_description);
+      case DG_FIELD_VAL0:
+        snprintf(str, slen, "%d", GET_OBJ_VAL(o, 0));
         break;
-      case 't':
-        if (!str_cmp(field, "type"))
-          sprinttype(GET_OBJ_TYPE(o), item_types, str, slen);
 
-        else if (!str_cmp(field, "timer"))
-          snprintf(str, slen, "%d", GET_OBJ_TIMER(o));
+      case DG_FIELD_VAL1:
+        snprintf(str, slen, "%d", GET_OBJ_VAL(o, 1));
         break;
-      case 'v':
-        if (!str_cmp(field, "vnum"))
-          if (subfield && *subfield)
-          {
-            snprintf(str, slen, "%d", (int)(GET_OBJ_VNUM(o) == atoidx(subfield)));
-          }
-          else
-          {
-            snprintf(str, slen, "%u", GET_OBJ_VNUM(o));
-          }
-        else if (!str_cmp(field, "val0"))
-          snprintf(str, slen, "%d", GET_OBJ_VAL(o, 0));
-
-        else if (!str_cmp(field, "val1"))
-          snprintf(str, slen, "%d", GET_OBJ_VAL(o, 1));
 
-        else if (!str_cmp(field, "val2"))
-          snprintf(str, slen, "%d", GET_OBJ_VAL(o, 2));
+      case DG_FIELD_VAL2:
+        snprintf(str, slen, "%d", GET_OBJ_VAL(o, 2));
+        break;
 
-        else if (!str_cmp(field, "val3"))
-          snprintf(str, slen, "%d", GET_OBJ_VAL(o, 3));
+      case DG_FIELD_VAL3:
+        snprintf(str, slen, "%d", GET_OBJ_VAL(o, 3));
         break;
-      case 'w':
-        if (!str_cmp(field, "wearflag"))
+      case DG_FIELD_WEARFLAG:
+      {
+        if (subfield && *subfield)
         {
-          if (subfield && *subfield)
-          {
-            if (can_wear_on_pos(o, find_eq_pos_script(subfield)))
-              snprintf(str, slen, "1");
-            else
-              snprintf(str, slen, "0");
-          }
+          if (can_wear_on_pos(o, find_eq_pos_script(subfield)))
+            snprintf(str, slen, "1");
           else
             snprintf(str, slen, "0");
         }
-        else if (!str_cmp(field, "weight"))
-        {
-          if (subfield && *subfield)
-          {
-            int addition = atoi(subfield);
-            GET_OBJ_WEIGHT(o) = MAX(1, addition + GET_OBJ_WEIGHT(o));
-          }
-          snprintf(str, slen, "%d", GET_OBJ_WEIGHT(o));
-        }
-        else if (!str_cmp(field, "worn_by"))
+        else
+          snprintf(str, slen, "0");
+        break;
+      }
+      case DG_FIELD_WEIGHT:
+      {
+        if (subfield && *subfield)
         {
-          if (o->worn_by)
-            snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(o->worn_by));
-          else
-            *str = '\0';
+          int addition = atoi(subfield);
+          GET_OBJ_WEIGHT(o) = MAX(1, addition + GET_OBJ_WEIGHT(o));
         }
+        snprintf(str, slen, "%d", GET_OBJ_WEIGHT(o));
+        break;
+      }
+      case DG_FIELD_WORN_BY:
+      {
+        if (o->worn_by)
+          snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(o->worn_by));
+        else
+          *str = '\0';
+        break;
+      }
+      default:
         break;
-      } /* switch *field */
+      } /* switch field */
 
       if (*str == '\x1')
       { /* no match in switch */
@@ -2084,14 +2478,20 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
           else
             *str = '\0';
         }
+        return;
       }
-      else if (!str_cmp(field, "name"))
+
+      switch (dg_field_id(field))
+      {
+      case DG_FIELD_NAME:
         snprintf(str, slen, "%s", r->name);
+        break;
 
-      else if (!str_cmp(field, "sector"))
+      case DG_FIELD_SECTOR:
         sprinttype(r->sector_type, sector_types, str, slen);
+        break;
 
-      else if (!str_cmp(field, "vnum"))
+      case DG_FIELD_VNUM:
       {
         if (subfield && *subfield)
         {
@@ -2101,8 +2501,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         {
           snprintf(str, slen, "%u", r->number);
         }
+        break;
       }
-      else if (!str_cmp(field, "contents"))
+      case DG_FIELD_CONTENTS:
       {
         if (subfield && *subfield)
         {
@@ -2129,23 +2530,26 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
             *str = '\0';
           }
         }
+        break;
       }
-      else if (!str_cmp(field, "people"))
+      case DG_FIELD_PEOPLE:
       {
         if (r->people)
           snprintf(str, slen, "%c%ld", UID_CHAR, char_script_id(r->people));
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "id"))
+      case DG_FIELD_ID:
       {
         room_rnum rnum = real_room(r->number);
         if (rnum != NOWHERE)
           snprintf(str, slen, "%ld", (long)world[rnum].number + ROOM_ID_BASE);
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "weather"))
+      case DG_FIELD_WEATHER:
       {
         const char *sky_look[] = {"sunny", "cloudy", "rainy", "lightning"};
 
@@ -2155,8 +2559,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
           snprintf(str, slen, "%s", sky_look[weather_info.sky]);
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "hasattached"))
+      case DG_FIELD_HASATTACHED:
       {
         if (!(subfield && *subfield))
           *str = '\0';
@@ -2165,12 +2570,15 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
           i = atoi(subfield);
           snprintf(str, slen, "%d", trig_is_attached(SCRIPT(r), i));
         }
+        break;
       }
-      else if (!str_cmp(field, "zonenumber"))
+      case DG_FIELD_ZONENUMBER:
         snprintf(str, slen, "%d", zone_table[r->zone].number);
-      else if (!str_cmp(field, "zonename"))
+        break;
+      case DG_FIELD_ZONENAME:
         snprintf(str, slen, "%s", zone_table[r->zone].name);
-      else if (!str_cmp(field, "roomflag"))
+        break;
+      case DG_FIELD_ROOMFLAG:
       {
         if (subfield && *subfield)
         {
@@ -2183,8 +2591,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           snprintf(str, slen, "0");
+        break;
       }
-      else if (!str_cmp(field, "north"))
+      case DG_FIELD_NORTH:
       {
         if (R_EXIT(r, NORTH))
         {
@@ -2210,8 +2619,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "east"))
+      case DG_FIELD_EAST:
       {
         if (R_EXIT(r, EAST))
         {
@@ -2237,8 +2647,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "south"))
+      case DG_FIELD_SOUTH:
       {
         if (R_EXIT(r, SOUTH))
         {
@@ -2264,8 +2675,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "west"))
+      case DG_FIELD_WEST:
       {
         if (R_EXIT(r, WEST))
         {
@@ -2291,8 +2703,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "up"))
+      case DG_FIELD_UP:
       {
         if (R_EXIT(r, UP))
         {
@@ -2318,8 +2731,9 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "down"))
+      case DG_FIELD_DOWN:
       {
         if (R_EXIT(r, DOWN))
         {
@@ -2345,24 +2759,27 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
         }
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "xcoord"))
+      case DG_FIELD_XCOORD:
       {
         room_rnum rnum = real_room(r->number);
         if (rnum != NOWHERE)
           snprintf(str, slen, "%d", world[rnum].coords[0]);
         else
           *str = '\0';
+        break;
       }
-      else if (!str_cmp(field, "ycoord"))
+      case DG_FIELD_YCOORD:
       {
         room_rnum rnum = real_room(r->number);
         if (rnum != NOWHERE)
           snprintf(str, slen, "%d", world[rnum].coords[1]);
         else
           *str = '\0';
+        break;
       }
-      else
+      default:
       {
         if (SCRIPT(r))
         { /* check for global var */
@@ -2387,6 +2804,8 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
                      "script, attempted access: %%<room_var>.%s%%)",
                      GET_TRIG_NAME(trig), GET_TRIG_VNUM(trig), type, field, field);
         }
+        break;
+      }
       }
     } /* if (r).. */
   }
@@ -2399,16 +2818,91 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig, int typ
  * %actor.gold(%actor.gold%)% will double the actors gold every time its called.
  * - Jamie Nelson */
 
+/* What var_subst() carries from one variable to the next in a line. */
+struct subst_state
+{
+  char subfield[MAX_INPUT_LENGTH];
+  char *subfield_p;
+  int paren_count;
+  int dots;
+};
+
+/* p is just past the % opening a variable: looks it up into repl_str and
+ * returns where the rest of the line starts. */
+static char *subst_variable(void *go, struct script_data *sc, trig_data *trig, int type,
+                            struct subst_state *st, char *p, char *repl_str, size_t slen)
+{
+  char *var = NULL, *field = NULL;
+  char tmp2[MAX_INPUT_LENGTH + 16] = {'\0'};
+
+  /* search until end of var or beginning of field */
+  for (var = p; *p && (*p != '%') && (*p != '.'); p++)
+    ;
+
+  field = p;
+  if (*p == '.')
+  {
+    *(p++) = '\0';
+    st->dots = 0;
+    for (field = p; *p && ((*p != '%') || (st->paren_count > 0) || (st->dots)); p++)
+    {
+      if (st->dots > 0)
+      {
+        *st->subfield_p = '\0';
+        find_replacement(go, sc, trig, type, var, field, st->subfield, repl_str, slen);
+        if (*repl_str)
+        {
+          snprintf(tmp2, sizeof(tmp2), "eval tmpvr %s", repl_str); // temp var
+          process_eval(go, sc, trig, type, tmp2);
+          strcpy(var, "tmpvr");
+          field = p;
+          st->dots = 0;
+          continue;
+        }
+        st->dots = 0;
+      }
+      else if (*p == '(')
+      {
+        *p = '\0';
+        st->paren_count++;
+      }
+      else if (*p == ')')
+      {
+        *p = '\0';
+        st->paren_count--;
+      }
+      else if (st->paren_count > 0)
+      {
+        *st->subfield_p++ = *p;
+      }
+      else if (*p == '.')
+      {
+        *p = '\0';
+        st->dots++;
+      }
+    } /* for (field.. */
+  } /* if *p == '.' */
+
+  *(p++) = '\0';
+  *st->subfield_p = '\0';
+
+  if (*st->subfield)
+  {
+    var_subst(go, sc, trig, type, st->subfield, tmp2);
+    strlcpy(st->subfield, tmp2, sizeof(st->subfield));
+  }
+
+  find_replacement(go, sc, trig, type, var, field, st->subfield, repl_str, slen);
+  return p;
+}
+
 /* substitutes any variables into line and returns it as buf */
 void var_subst(void *go, struct script_data *sc, trig_data *trig, int type, char *line, char *buf)
 {
   char tmp[MAX_INPUT_LENGTH] = {'\0'}, repl_str[MAX_INPUT_LENGTH] = {'\0'};
-  char *var = NULL, *field = NULL, *p = NULL;
-  char tmp2[MAX_INPUT_LENGTH + 16] = {'\0'};
-  char *subfield_p, subfield[MAX_INPUT_LENGTH] = {'\0'};
+  struct subst_state state = {{'\0'}, NULL, 0, 0};
+  char *p = NULL;
   int left, len;
-  int paren_count = 0;
-  int dots = 0;
 
   /* skip out if no %'s */
   if (!strchr(line, '%'))
@@ -2416,12 +2910,10 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig, int type, char
     strlcpy(buf, line, MAX_INPUT_LENGTH);
     return;
   }
-  /*lets just empty these to start with*/
-  *repl_str = *tmp = *tmp2 = '\0';
 
   strlcpy(tmp, line, sizeof(tmp));
   p = tmp;
-  subfield_p = subfield;
+  state.subfield_p = state.subfield;
 
   left = MAX_INPUT_LENGTH - 1;
 
@@ -2446,64 +2938,7 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig, int type, char
     } /* so it wasn't double %'s */
     else if (*p && (left > 0))
     {
-      /* search until end of var or beginning of field */
-      for (var = p; *p && (*p != '%') && (*p != '.'); p++)
-        ;
-
-      field = p;
-      if (*p == '.')
-      {
-        *(p++) = '\0';
-        dots = 0;
-        for (field = p; *p && ((*p != '%') || (paren_count > 0) || (dots)); p++)
-        {
-          if (dots > 0)
-          {
-            *subfield_p = '\0';
-            find_replacement(go, sc, trig, type, var, field, subfield, repl_str, sizeof(repl_str));
-            if (*repl_str)
-            {
-              snprintf(tmp2, sizeof(tmp2), "eval tmpvr %s", repl_str); // temp var
-              process_eval(go, sc, trig, type, tmp2);
-              strcpy(var, "tmpvr");
-              field = p;
-              dots = 0;
-              continue;
-            }
-            dots = 0;
-          }
-          else if (*p == '(')
-          {
-            *p = '\0';
-            paren_count++;
-          }
-          else if (*p == ')')
-          {
-            *p = '\0';
-            paren_count--;
-          }
-          else if (paren_count > 0)
-          {
-            *subfield_p++ = *p;
-          }
-          else if (*p == '.')
-          {
-            *p = '\0';
-            dots++;
-          }
-        } /* for (field.. */
-      } /* if *p == '.' */
-
-      *(p++) = '\0';
-      *subfield_p = '\0';
-
-      if (*subfield)
-      {
-        var_subst(go, sc, trig, type, subfield, tmp2);
-        strlcpy(subfield, tmp2, sizeof(subfield));
-      }
-
-      find_replacement(go, sc, trig, type, var, field, subfield, repl_str, sizeof(repl_str));
+      p = subst_variable(go, sc, trig, type, &state, p, repl_str, sizeof(repl_str));
 
       len = MIN((int)strlen(repl_str), left);
       memcpy(buf, repl_str, len);
@@ -2514,3 +2949,38 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig, int type, char
   } /* while *p .. */
   *buf = '\0';
 }
+
+/* var_subst() over a line dg_compile_cmdlist() has already split up. */
+void var_subst_tokens(void *go, struct script_data *sc, trig_data *trig, int type,
+                      const struct dg_token *token, int count, char *buf)
+{
+  char var[MAX_INPUT_LENGTH], repl_str[MAX_INPUT_LENGTH] = {'\0'};
+  struct subst_state state = {{'\0'}, NULL, 0, 0};
+  const char *text;
+  int left = MAX_INPUT_LENGTH - 1, len;
+
+  state.subfield_p = state.subfield;
+
+  for (; count > 0 && left > 0; token++, count--)
+  {
+    if (token->type == DG_TOKEN_VAR)
+    {
+      memset(var, 0, sizeof(var));
+      memcpy(var, token->text, token->value);
+      subst_variable(go, sc, trig, type, &state, var, repl_str, sizeof(repl_str));
+      text = repl_str;
+      len = strlen(repl_str);
+    }
+    else
+    {
+      text = token->text;
+      len = token->value;
+    }
+
+    len = MIN(len, left);
+    memcpy(buf, text, len);
+    buf += len;
+    left -= len;
+  }
+  *buf = '\0';
+}
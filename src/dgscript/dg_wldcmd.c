@@ -18,6 +18,7 @@
 #include "handler.h"
 #include "db.h"
 #include "constants.h"
+#include "graph.h"
 #include "olc/genzon.h"   /* for zone_rnum real_zone_by_thing */
 #include "combat/fight.h" /* for die() */
 
@@ -303,6 +304,8 @@ WCMD(do_wdoor)
       break;
     }
   }
+
+  graph_exits_changed();
 }
 
 WCMD(do_wteleport)
@@ -29,31 +29,68 @@
 #include "character/evolutions.h"
 #include "character/perks.h"
 
-/* local functions */
-static int VALID_EDGE(room_rnum x, int y);
-static void bfs_enqueue(room_rnum room, int dir);
-static void bfs_dequeue(void);
-static void bfs_clear_queue(void);
-struct bfs_queue_struct
+#if defined(GRAPH_CACHE_VALIDATE)
+bool graph_cache_validate = TRUE;
+#else
+bool graph_cache_validate = FALSE;
+#endif
+bool graph_next_hop_cache = TRUE;
+
+/* Utility macros */
+#define TOROOM(x, y) (world[(x)].dir_option[(y)]->to_room)
+#define IS_CLOSED(x, y) (EXIT_FLAGGED(world[(x)].dir_option[(y)], EX_CLOSED))
+
+struct bfs_queue_entry
 {
   room_rnum room;
-  char dir;
-  struct bfs_queue_struct *next;
+  int dir; /* First step taken from the source; hop count in count_rooms_between() */
 };
 
-/* had to rename queue_head because it already exists in dg_event.h */
-static struct bfs_queue_struct *queue_head_2 = 0, *queue_tail = 0;
+/* Search scratch space, sized to the world and reused by every search.  A room
+ * has been reached in the current search when its stamp equals the current
+ * generation, so starting a search is one increment rather than a pass over
+ * every room, and the queue is a flat array since each room enters it at most
+ * once. */
+static struct
+{
+  struct room_data *world; /* world / top_of_world the buffers were sized for */
+  room_rnum top;
+  unsigned int generation;
+  unsigned int *stamp;
+  struct bfs_queue_entry *queue;
+} bfs;
 
-/* Utility macros */
-#define MARK(room) (SET_BIT_AR(ROOM_FLAGS(room), ROOM_BFS_MARK))
-#define UNMARK(room) (REMOVE_BIT_AR(ROOM_FLAGS(room), ROOM_BFS_MARK))
-#define IS_MARKED(room) (ROOM_FLAGGED(room, ROOM_BFS_MARK))
-#define TOROOM(x, y) (world[(x)].dir_option[(y)]->to_room)
-#define IS_CLOSED(x, y) (EXIT_FLAGGED(world[(x)].dir_option[(y)], EX_CLOSED))
+#define MARK(room) (bfs.stamp[(room)] = bfs.generation)
+#define IS_MARKED(room) (bfs.stamp[(room)] == bfs.generation)
+
+static void bfs_begin(void)
+{
+  size_t room_count = (size_t)top_of_world + 1;
+
+  if (bfs.stamp == NULL || bfs.world != world || bfs.top != top_of_world)
+  {
+    if (bfs.stamp)
+      free(bfs.stamp);
+    if (bfs.queue)
+      free(bfs.queue);
+    CREATE(bfs.stamp, unsigned int, room_count);
+    CREATE(bfs.queue, struct bfs_queue_entry, room_count);
+    bfs.world = world;
+    bfs.top = top_of_world;
+    bfs.generation = 0;
+  }
+
+  /* After four billion searches the stamps wrap; start them over. */
+  if (++bfs.generation == 0)
+  {
+    memset(bfs.stamp, 0, sizeof(unsigned int) * room_count);
+    bfs.generation = 1;
+  }
+}
 
 static int VALID_EDGE(room_rnum x, int y)
 {
-  if (world[x].dir_option[y] == NULL || TOROOM(x, y) == NOWHERE)
+  if (world[x].dir_option[y] == NULL || TOROOM(x, y) == NOWHERE || TOROOM(x, y) > top_of_world)
     return 0;
   if (CONFIG_TRACK_T_DOORS == FALSE && IS_CLOSED(x, y))
     return 0;
@@ -63,39 +100,211 @@ static int VALID_EDGE(room_rnum x, int y)
   return 1;
 }
 
-static void bfs_enqueue(room_rnum room, int dir)
+/* The classic BFS.  Returns the first step from src toward target, or
+ * BFS_NO_PATH.  Called with target NOWHERE it runs until every reachable room
+ * is queued, and *reached says how much of bfs.queue holds them. */
+static int bfs_search(room_rnum src, room_rnum target, int *reached)
 {
-  struct bfs_queue_struct *curr;
+  int curr_dir, head = 0, tail = 0;
+  room_rnum curr_room;
 
-  CREATE(curr, struct bfs_queue_struct, 1);
-  curr->room = room;
-  curr->dir = dir;
-  curr->next = 0;
+  bfs_begin();
+  MARK(src);
+
+  /* first, enqueue the first steps, saving which direction we're going. */
+  for (curr_dir = 0; curr_dir < DIR_COUNT; curr_dir++)
+    if (VALID_EDGE(src, curr_dir))
+    {
+      MARK(TOROOM(src, curr_dir));
+      bfs.queue[tail].room = TOROOM(src, curr_dir);
+      bfs.queue[tail++].dir = curr_dir;
+    }
 
-  if (queue_tail)
+  while (head < tail)
   {
-    queue_tail->next = curr;
-    queue_tail = curr;
+    curr_room = bfs.queue[head].room;
+    if (curr_room == target)
+      return (bfs.queue[head].dir);
+
+    for (curr_dir = 0; curr_dir < DIR_COUNT; curr_dir++)
+      if (VALID_EDGE(curr_room, curr_dir))
+      {
+        MARK(TOROOM(curr_room, curr_dir));
+        bfs.queue[tail].room = TOROOM(curr_room, curr_dir);
+        bfs.queue[tail++].dir = bfs.queue[head].dir;
+      }
+    head++;
   }
-  else
-    queue_head_2 = queue_tail = curr;
+
+  if (reached)
+    *reached = tail;
+  return (BFS_NO_PATH);
+}
+
+/* Per-zone next-hop tables.  Row r of a zone's table holds the first step
+ * from the zone's r-th room to each of its rooms, filled by one exhaustive
+ * search (paths may wander through other zones, so the search does too).  A
+ * row is built the second time its room is asked about, so one-off tracks
+ * cost no more than before while hunters and trackers that keep asking from
+ * the same rooms get their answer by table lookup.
+ *
+ * Everything is thrown away whenever graph_exits_changed() is called, the
+ * world is reallocated, or the diagonal-directions option changes.  With
+ * CONFIG_TRACK_T_DOORS off every door that opens or closes changes the graph,
+ * so the tables are bypassed entirely. */
+struct next_hop_zone
+{
+  int count;            /* Rooms in the zone; 0 until examined, -1 if not cached */
+  room_rnum base;       /* The zone's rooms are rnums base..base + count - 1 */
+  bool *asked;          /* Asked once from this room since the last flush */
+  signed char **rows;   /* rows[src - base][target - base], NULL until built */
+};
+
+static struct
+{
+  unsigned int epoch; /* graph_epoch the tables were built under */
+  struct room_data *world;
+  room_rnum top;
+  struct zone_data *zone_table;
+  zone_rnum top_zone;
+  int dir_count;
+  struct next_hop_zone *zones; /* One per zone, or NULL when empty */
+} next_hop;
+
+static unsigned int graph_epoch = 1;
+
+void graph_exits_changed(void)
+{
+  graph_epoch++;
 }
 
-static void bfs_dequeue(void)
+unsigned int graph_exits_epoch(void)
 {
-  struct bfs_queue_struct *curr;
+  return graph_epoch;
+}
 
-  curr = queue_head_2;
+static void next_hop_flush(void)
+{
+  zone_rnum zone;
+  int i;
 
-  if (!(queue_head_2 = queue_head_2->next))
-    queue_tail = 0;
-  free(curr);
+  if (next_hop.zones)
+  {
+    for (zone = 0; zone <= next_hop.top_zone; zone++)
+    {
+      if (next_hop.zones[zone].count <= 0)
+        continue;
+      for (i = 0; i < next_hop.zones[zone].count; i++)
+        if (next_hop.zones[zone].rows[i])
+          free(next_hop.zones[zone].rows[i]);
+      free(next_hop.zones[zone].rows);
+      free(next_hop.zones[zone].asked);
+    }
+    free(next_hop.zones);
+    next_hop.zones = NULL;
+  }
+  next_hop.epoch = 0;
 }
 
-static void bfs_clear_queue(void)
+static void next_hop_current(void)
 {
-  while (queue_head_2)
-    bfs_dequeue();
+  if (next_hop.zones && next_hop.epoch == graph_epoch && next_hop.world == world &&
+      next_hop.top == top_of_world && next_hop.zone_table == zone_table &&
+      next_hop.top_zone == top_of_zone_table && next_hop.dir_count == DIR_COUNT)
+    return;
+
+  next_hop_flush();
+  CREATE(next_hop.zones, struct next_hop_zone, top_of_zone_table + 1);
+  next_hop.epoch = graph_epoch;
+  next_hop.world = world;
+  next_hop.top = top_of_world;
+  next_hop.zone_table = zone_table;
+  next_hop.top_zone = top_of_zone_table;
+  next_hop.dir_count = DIR_COUNT;
+}
+
+/* The zone's rooms are contiguous in the world since both are sorted by vnum;
+ * walk out from one of them to find the span. */
+static struct next_hop_zone *next_hop_zone_of(room_rnum room)
+{
+  zone_rnum zone = GET_ROOM_ZONE(room);
+  struct next_hop_zone *cache;
+  room_rnum first = room, last = room;
+
+  if (zone == NOWHERE || zone > top_of_zone_table)
+    return NULL;
+
+  cache = &next_hop.zones[zone];
+  if (cache->count == 0)
+  {
+    while (first > 0 && GET_ROOM_ZONE(first - 1) == zone)
+      first--;
+    while (last < top_of_world && GET_ROOM_ZONE(last + 1) == zone)
+      last++;
+
+    if (ZONE_FLAGGED(zone, ZONE_WILDERNESS) || last - first + 1 > GRAPH_CACHE_MAX_ROOMS)
+      cache->count = -1;
+    else
+    {
+      cache->base = first;
+      cache->count = last - first + 1;
+      CREATE(cache->rows, signed char *, cache->count);
+      CREATE(cache->asked, bool, cache->count);
+    }
+  }
+
+  return cache->count > 0 ? cache : NULL;
+}
+
+static signed char *next_hop_build_row(struct next_hop_zone *cache, room_rnum src)
+{
+  signed char *row;
+  room_rnum room;
+  int i, reached = 0;
+
+  CREATE(row, signed char, cache->count);
+  for (i = 0; i < cache->count; i++)
+    row[i] = BFS_NO_PATH;
+  row[src - cache->base] = BFS_ALREADY_THERE;
+
+  bfs_search(src, NOWHERE, &reached);
+  for (i = 0; i < reached; i++)
+  {
+    room = bfs.queue[i].room;
+    if (room >= cache->base && room - cache->base < (room_rnum)cache->count)
+      row[room - cache->base] = bfs.queue[i].dir;
+  }
+
+  return row;
+}
+
+/* TRUE with *dir set when the answer came from (or went into) a table. */
+static bool next_hop_lookup(room_rnum src, room_rnum target, int *dir)
+{
+  struct next_hop_zone *cache;
+  int from;
+
+  if (!graph_next_hop_cache || CONFIG_TRACK_T_DOORS == FALSE)
+    return FALSE;
+
+  next_hop_current();
+  if ((cache = next_hop_zone_of(src)) == NULL || target < cache->base ||
+      target - cache->base >= (room_rnum)cache->count)
+    return FALSE;
+
+  from = src - cache->base;
+  if (cache->rows[from] == NULL)
+  {
+    if (!cache->asked[from])
+    {
+      cache->asked[from] = TRUE;
+      return FALSE;
+    }
+    cache->rows[from] = next_hop_build_row(cache, src);
+  }
+
+  *dir = cache->rows[from][target - cache->base];
+  return TRUE;
 }
 
 /* find_first_step: given a source room and a target room, find the first step
@@ -104,8 +313,7 @@ static void bfs_clear_queue(void)
  * PC.  Or, a 'track' skill for PCs. */
 int find_first_step(room_rnum src, room_rnum target)
 {
-  int curr_dir;
-  room_rnum curr_room;
+  int dir, searched;
 
   if (src == NOWHERE || target == NOWHERE || src > top_of_world || target > top_of_world)
   {
@@ -123,42 +331,18 @@ int find_first_step(room_rnum src, room_rnum target)
   if (src == target)
     return (BFS_ALREADY_THERE);
 
-  /* clear marks first, some OLC systems will save the mark. */
-  for (curr_room = 0; curr_room <= top_of_world; curr_room++)
-    UNMARK(curr_room);
-
-  MARK(src);
-
-  /* first, enqueue the first steps, saving which direction we're going. */
-  for (curr_dir = 0; curr_dir < DIR_COUNT; curr_dir++)
-    if (VALID_EDGE(src, curr_dir))
-    {
-      MARK(TOROOM(src, curr_dir));
-      bfs_enqueue(TOROOM(src, curr_dir), curr_dir);
-    }
+  if (!next_hop_lookup(src, target, &dir))
+    return (bfs_search(src, target, NULL));
 
-  /* now, do the classic BFS. */
-  while (queue_head_2)
+  if (graph_cache_validate && (searched = bfs_search(src, target, NULL)) != dir)
   {
-    if (queue_head_2->room == target)
-    {
-      curr_dir = queue_head_2->dir;
-      bfs_clear_queue();
-      return (curr_dir);
-    }
-    else
-    {
-      for (curr_dir = 0; curr_dir < DIR_COUNT; curr_dir++)
-        if (VALID_EDGE(queue_head_2->room, curr_dir))
-        {
-          MARK(TOROOM(queue_head_2->room, curr_dir));
-          bfs_enqueue(TOROOM(queue_head_2->room, curr_dir), queue_head_2->dir);
-        }
-      bfs_dequeue();
-    }
+    log("SYSERR: find_first_step(%d, %d) next-hop table said %d, search found %d; flushing",
+        (int)world[src].number, (int)world[target].number, dir, searched);
+    next_hop_flush();
+    dir = searched;
   }
 
-  return (BFS_NO_PATH);
+  return (dir);
 }
 
 /* Functions and Commands which use the above functions. */
@@ -595,12 +779,8 @@ int count_rooms_between(room_rnum src, room_rnum target)
 {
   room_rnum curr;
   room_rnum next;
-  room_rnum *queue;
-  int *visited;
   int head = 0, tail = 0;
   int dir = 0;
-  int result = -1;
-  size_t room_count;
 
   if (!world || top_of_world == NOWHERE || src == NOWHERE || src > top_of_world ||
       target == NOWHERE || target > top_of_world)
@@ -609,36 +789,32 @@ int count_rooms_between(room_rnum src, room_rnum target)
   if (src == target)
     return 0;
 
-  room_count = (size_t)top_of_world + 1;
-  CREATE(visited, int, room_count);
-  CREATE(queue, room_rnum, room_count);
-  visited[src] = 1;
-  queue[tail++] = src;
+  /* Shares the find_first_step() scratch space; dir holds the hop count. */
+  bfs_begin();
+  MARK(src);
+  bfs.queue[tail].room = src;
+  bfs.queue[tail++].dir = 0;
 
-  while (head < tail && result < 0)
+  while (head < tail)
   {
-    curr = queue[head++];
+    curr = bfs.queue[head].room;
 
     for (dir = 0; dir < NUM_OF_DIRS; dir++)
     {
       next = world[curr].dir_option[dir] ? world[curr].dir_option[dir]->to_room : NOWHERE;
 
-      if (next == NOWHERE || next > top_of_world || visited[next])
+      if (next == NOWHERE || next > top_of_world || IS_MARKED(next))
         continue;
 
-      visited[next] = visited[curr] + 1;
-
       if (next == target)
-      {
-        result = visited[next] - 1;
-        break;
-      }
+        return bfs.queue[head].dir + 1;
 
-      queue[tail++] = next;
+      MARK(next);
+      bfs.queue[tail].room = next;
+      bfs.queue[tail++].dir = bfs.queue[head].dir + 1;
     }
+    head++;
   }
 
-  free(queue);
-  free(visited);
-  return result;
+  return -1;
 }
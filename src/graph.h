@@ -23,4 +23,19 @@ void hunt_loadroom(struct char_data *ch);
 int find_first_step(room_rnum src, room_rnum target);
 int count_rooms_between(room_rnum src, room_rnum target);
 
+/* Largest zone find_first_step() keeps a next-hop table for. */
+#define GRAPH_CACHE_MAX_ROOMS 512
+
+/* Runtime switch for the per-zone next-hop tables. */
+extern bool graph_next_hop_cache;
+/* When TRUE every table answer is cross-checked against a fresh search.
+ * Defaults on when built with -DGRAPH_CACHE_VALIDATE. */
+extern bool graph_cache_validate;
+
+/* Call after adding, removing or retargeting exits, or changing room flags
+ * that affect tracking; drops every next-hop table. */
+void graph_exits_changed(void);
+/* Bumped by every graph_exits_changed(), for other caches keyed on exits. */
+unsigned int graph_exits_epoch(void);
+
 #endif /* _GRAPH_H_*/
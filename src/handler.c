@@ -40,6 +40,9 @@
 #include "graph.h"
 #include "perfmon.h"
 #include "mob/mob_act.h"
+#include "zone_presence.h"
+#include "wilderness/spatial_grid.h"
+#include "pubsub/pubsub.h"
 
 /* local file scope variables */
 static int extractions_pending = 0;
@@ -632,26 +635,318 @@ int calculate_best_mod(struct char_data *ch, int location, int bonus_type, int e
   return best - penalty;
 }
 
+/* Incremental bonus aggregation for affect_total().
+ *
+ * BEGINNERS NOTE: affect_total() used to call calculate_best_mod() for every
+ * APPLY_ location and every bonus type - 75 x 25 full scans of the affect
+ * list and all worn gear. The cache below keeps the summed result for each
+ * location. Adding or removing an affect, or equipping or removing an item,
+ * only marks the locations it touches, and those are rebuilt together in one
+ * pass the next time affect_total() asks for them. Results are identical to
+ * calculate_best_mod(), including the two-handed weapon doubling. */
+
+/** Set to TRUE to cross-check every affect_total() against a full recompute. */
+#if defined(AFFECT_BONUS_VALIDATE)
+bool affect_bonus_validate = TRUE;
+#else
+bool affect_bonus_validate = FALSE;
+#endif
+
+#define AFFECT_BONUS_BIT_SET(mask, loc) ((mask)[(loc) / 32] |= (1U << ((loc) % 32)))
+#define AFFECT_BONUS_BIT_CLEAR(mask, loc) ((mask)[(loc) / 32] &= ~(1U << ((loc) % 32)))
+#define AFFECT_BONUS_BIT_TEST(mask, loc) (((mask)[(loc) / 32] >> ((loc) % 32)) & 1U)
+
+/* Locations calculate_best_mod() always reports as zero. */
+#define AFFECT_BONUS_IGNORED(loc, type)                                                            \
+  ((loc) <= APPLY_NONE || (loc) >= NUM_APPLIES || (loc) == APPLY_DR || (type) < 0 ||               \
+   (type) >= NUM_BONUS_TYPES || BONUS_TYPE_STACKS(type))
+
+static unsigned int affect_bonus_mix(unsigned int hash, int value)
+{
+  hash ^= (unsigned int)value + 0x9e3779b9U + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+static unsigned int affect_bonus_affect_hash(const struct affected_type *af)
+{
+  unsigned int hash = 0x5bd1e995U;
+
+  hash = affect_bonus_mix(hash, af->location);
+  hash = affect_bonus_mix(hash, af->bonus_type);
+  return affect_bonus_mix(hash, af->modifier);
+}
+
+/* Fingerprint of everything calculate_best_mod() reads from one worn item. */
+static unsigned int affect_bonus_slot_hash(const struct obj_data *obj, int pos)
+{
+  unsigned int hash = 0x27d4eb2fU;
+  int j;
+
+  hash = affect_bonus_mix(hash, pos);
+  hash = affect_bonus_mix(hash, GET_OBJ_TYPE(obj));
+  hash = affect_bonus_mix(hash, GET_OBJ_SIZE(obj));
+  hash = affect_bonus_mix(hash, OBJ_FLAGGED(obj, ITEM_ROL_TWO_HANDED) ? 1 : 0);
+  for (j = 0; j < MAX_OBJ_AFFECT; j++)
+  {
+    hash = affect_bonus_mix(hash, obj->affected[j].location);
+    hash = affect_bonus_mix(hash, obj->affected[j].bonus_type);
+    hash = affect_bonus_mix(hash, obj->affected[j].modifier);
+  }
+  return hash;
+}
+
+/* Character state is_weapon_wielded_two_handed() depends on. */
+static ubyte affect_bonus_wield_sig(struct char_data *ch)
+{
+  int sig = GET_SIZE(ch) << 4;
+
+  if (GET_EQ(ch, WEAR_HOLD_1))
+    sig |= 1;
+  if (GET_EQ(ch, WEAR_HOLD_2))
+    sig |= 2;
+  if (GET_EQ(ch, WEAR_WIELD_OFFHAND))
+    sig |= 4;
+  if (GET_EQ(ch, WEAR_SHIELD))
+    sig |= 8;
+  return (ubyte)sig;
+}
+
+static void affect_bonus_fingerprint(struct char_data *ch, unsigned int *affect_hash,
+                                     unsigned int *gear_hash)
+{
+  struct affected_type *af;
+  int i;
+
+  *affect_hash = 0;
+  *gear_hash = 0;
+  for (af = ch->affected; af; af = af->next)
+    *affect_hash += affect_bonus_affect_hash(af);
+  for (i = 0; i < NUM_WEARS; i++)
+    if (GET_EQ(ch, i))
+      *gear_hash += affect_bonus_slot_hash(GET_EQ(ch, i), i);
+}
+
+/* Rebuild every dirty location in a single pass over affects and gear. The
+ * comparisons mirror calculate_best_mod() exactly, including its habit of
+ * comparing a gear modifier against a best value that may already be doubled. */
+static void affect_bonus_rebuild(struct char_data *ch)
+{
+  struct affect_bonus_cache *cache = &ch->char_specials.bonus_cache;
+  int best[NUM_APPLIES][NUM_BONUS_TYPES];
+  int penalty[NUM_APPLIES][NUM_BONUS_TYPES];
+  struct affected_type *af;
+  struct obj_data *obj;
+  int i, j, loc, type, modifier, two_handed;
+  ubyte sig;
+
+  for (loc = 0; loc < NUM_APPLIES; loc++)
+  {
+    if (!AFFECT_BONUS_BIT_TEST(cache->dirty, loc))
+      continue;
+    memset(best[loc], 0, sizeof(best[loc]));
+    memset(penalty[loc], 0, sizeof(penalty[loc]));
+    AFFECT_BONUS_BIT_CLEAR(cache->weapon, loc);
+  }
+
+  for (af = ch->affected; af; af = af->next)
+  {
+    loc = af->location;
+    type = af->bonus_type;
+    if (AFFECT_BONUS_IGNORED(loc, type) || !AFFECT_BONUS_BIT_TEST(cache->dirty, loc))
+      continue;
+    modifier = af->modifier;
+    if (modifier < 0)
+      penalty[loc][type] -= modifier;
+    if (modifier > best[loc][type])
+      best[loc][type] = modifier;
+  }
+
+  for (i = 0; i < NUM_WEARS; i++)
+  {
+    if (!(obj = GET_EQ(ch, i)))
+      continue;
+    two_handed = -1;
+    for (j = 0; j < MAX_OBJ_AFFECT; j++)
+    {
+      loc = obj->affected[j].location;
+      type = obj->affected[j].bonus_type;
+      if (AFFECT_BONUS_IGNORED(loc, type) || !AFFECT_BONUS_BIT_TEST(cache->dirty, loc))
+        continue;
+      if (GET_OBJ_TYPE(obj) == ITEM_WEAPON)
+        AFFECT_BONUS_BIT_SET(cache->weapon, loc);
+      modifier = obj->affected[j].modifier;
+      if (modifier < 0)
+        penalty[loc][type] -= modifier;
+      if (modifier > best[loc][type])
+      {
+        if (two_handed < 0)
+          two_handed = is_weapon_wielded_two_handed(obj, ch) ? 1 : 0;
+        best[loc][type] = two_handed ? modifier * 2 : modifier;
+      }
+    }
+  }
+
+  sig = affect_bonus_wield_sig(ch);
+  for (loc = 0; loc < NUM_APPLIES; loc++)
+  {
+    if (!AFFECT_BONUS_BIT_TEST(cache->dirty, loc))
+      continue;
+    cache->total[loc] = 0;
+    for (type = 0; type < NUM_BONUS_TYPES; type++)
+      cache->total[loc] += best[loc][type] - penalty[loc][type];
+    cache->wield_sig[loc] = sig;
+    AFFECT_BONUS_BIT_CLEAR(cache->dirty, loc);
+  }
+}
+
+/** Forget every cached total; the next affect_total() rebuilds them all. */
+void affect_bonus_cache_invalidate(struct char_data *ch)
+{
+  struct affect_bonus_cache *cache;
+
+  if (ch == NULL)
+    return;
+
+  cache = &ch->char_specials.bonus_cache;
+  memset(cache, 0, sizeof(*cache));
+}
+
+/* Record an affect joining (add) or leaving the affect list. */
+static void affect_bonus_note_affect(struct char_data *ch, const struct affected_type *af,
+                                     bool add)
+{
+  struct affect_bonus_cache *cache = &ch->char_specials.bonus_cache;
+
+  if (!cache->valid)
+    return;
+
+  if (add)
+    cache->affect_hash += affect_bonus_affect_hash(af);
+  else
+    cache->affect_hash -= affect_bonus_affect_hash(af);
+  if (!AFFECT_BONUS_IGNORED(af->location, af->bonus_type))
+    AFFECT_BONUS_BIT_SET(cache->dirty, af->location);
+}
+
+/* Record an item being worn on (add) or removed from pos. */
+static void affect_bonus_note_obj(struct char_data *ch, const struct obj_data *obj, int pos,
+                                  bool add)
+{
+  struct affect_bonus_cache *cache = &ch->char_specials.bonus_cache;
+  int j;
+
+  if (!cache->valid)
+    return;
+
+  if (add)
+    cache->gear_hash += affect_bonus_slot_hash(obj, pos);
+  else
+    cache->gear_hash -= affect_bonus_slot_hash(obj, pos);
+  for (j = 0; j < MAX_OBJ_AFFECT; j++)
+    if (!AFFECT_BONUS_IGNORED(obj->affected[j].location, obj->affected[j].bonus_type))
+      AFFECT_BONUS_BIT_SET(cache->dirty, obj->affected[j].location);
+}
+
+/** Make sure the cache describes ch's current affects and gear. Code that
+ * edits an affect or a worn item in place is caught here by the fingerprints
+ * and costs a full rebuild instead of a wrong answer. */
+void affect_bonus_cache_sync(struct char_data *ch)
+{
+  struct affect_bonus_cache *cache = &ch->char_specials.bonus_cache;
+  unsigned int affect_hash, gear_hash;
+  int i;
+
+  affect_bonus_fingerprint(ch, &affect_hash, &gear_hash);
+  if (cache->valid && cache->affect_hash == affect_hash && cache->gear_hash == gear_hash)
+    return;
+
+  for (i = 0; i < AFFECT_BONUS_MASK_WORDS; i++)
+    cache->dirty[i] = ~0U;
+  cache->affect_hash = affect_hash;
+  cache->gear_hash = gear_hash;
+  cache->valid = TRUE;
+}
+
+/** Sum over all bonus types of calculate_best_mod(ch, location, type, -1, -1),
+ * served from the cache. Callers sync the cache first. */
+int affect_bonus_total(struct char_data *ch, int location)
+{
+  struct affect_bonus_cache *cache = &ch->char_specials.bonus_cache;
+
+  if (location <= APPLY_NONE || location >= NUM_APPLIES || location == APPLY_DR)
+    return 0;
+
+  if (!cache->valid)
+    affect_bonus_cache_sync(ch);
+
+  /* Size or an off-hand item can change whether a weapon counts double. */
+  if (AFFECT_BONUS_BIT_TEST(cache->weapon, location) &&
+      !AFFECT_BONUS_BIT_TEST(cache->dirty, location) &&
+      cache->wield_sig[location] != affect_bonus_wield_sig(ch))
+    AFFECT_BONUS_BIT_SET(cache->dirty, location);
+
+  if (AFFECT_BONUS_BIT_TEST(cache->dirty, location))
+    affect_bonus_rebuild(ch);
+
+  return cache->total[location];
+}
+
+/** Compare every cached total against calculate_best_mod(). Mismatches are
+ * logged and repaired; returns how many locations were wrong. */
+int affect_bonus_cache_verify(struct char_data *ch)
+{
+  struct affect_bonus_cache *cache;
+  int loc, type, expected, cached, mismatches = 0;
+
+  if (ch == NULL)
+    return 0;
+
+  cache = &ch->char_specials.bonus_cache;
+  for (loc = 0; loc < NUM_APPLIES; loc++)
+  {
+    expected = 0;
+    for (type = 0; type < NUM_BONUS_TYPES; type++)
+      expected += calculate_best_mod(ch, loc, type, -1, -1);
+    cached = affect_bonus_total(ch, loc);
+    if (cached == expected)
+      continue;
+
+    log("SYSERR: affect bonus cache for %s has %d at location %d, expected %d.", GET_NAME(ch),
+        cached, loc, expected);
+    cache->total[loc] = expected;
+    mismatches++;
+  }
+  return mismatches;
+}
+
+/* Reset the modifiable fields of points to real_points, leaving the pools,
+ * money and experience alone. */
+void reset_point_data(struct char_point_data *points, const struct char_point_data *real_points)
+{
+  int i = 0;
+
+  points->max_psp = real_points->max_psp;
+  points->max_hit = real_points->max_hit;
+  points->max_move = real_points->max_move;
+  points->armor = real_points->armor;
+  points->spell_res = real_points->spell_res;
+  points->hitroll = real_points->hitroll;
+  points->damroll = real_points->damroll;
+  points->size = real_points->size;
+  for (i = 0; i < NUM_OF_SAVING_THROWS; i++)
+    points->apply_saving_throw[i] = real_points->apply_saving_throw[i];
+  for (i = 0; i < NUM_DAM_TYPES; i++)
+    points->resistances[i] = real_points->resistances[i];
+}
+
 /* this will take a character's modified 'points' and reset it
  to their 'real points' */
 void reset_char_points(struct char_data *ch)
 {
-  int i = 0;
   // struct damage_reduction_type *damreduct;
   // struct dr_bypass_type *dr_bypass;
 
-  ch->points.max_psp = ch->real_points.max_psp;
-  ch->points.max_hit = ch->real_points.max_hit;
-  ch->points.max_move = ch->real_points.max_move;
-  ch->points.armor = ch->real_points.armor;
-  ch->points.spell_res = ch->real_points.spell_res;
-  ch->points.hitroll = ch->real_points.hitroll;
-  ch->points.damroll = ch->real_points.damroll;
-  ch->points.size = ch->real_points.size;
-  for (i = 0; i < NUM_OF_SAVING_THROWS; i++)
-    ch->points.apply_saving_throw[i] = ch->real_points.apply_saving_throw[i];
-  for (i = 0; i < NUM_DAM_TYPES; i++)
-    ch->points.resistances[i] = ch->real_points.resistances[i];
+  reset_point_data(&ch->points, &ch->real_points);
 
   /* NOTE: Perk bonuses are applied in affect_total_plus() */
 
@@ -1068,13 +1363,12 @@ int affect_total_sub(struct char_data *ch)
   }
 
   /* Adjust the modifiers to APPLY_ fields. */
+  affect_bonus_cache_sync(ch);
+  if (affect_bonus_validate)
+    affect_bonus_cache_verify(ch);
   for (i = 0; i < NUM_APPLIES; i++)
   {
-    modifier = 0;
-    for (j = 0; j < NUM_BONUS_TYPES; j++)
-    {
-      modifier += calculate_best_mod(ch, i, j, -1, -1);
-    }
+    modifier = affect_bonus_total(ch, i);
     aff_apply_modify(ch, i, -modifier, "affect_total_sub");
     // affect_modify_ar(ch, i, modifier, empty_bits, FALSE);
   }
@@ -1089,6 +1383,50 @@ int affect_total_sub(struct char_data *ch)
   return at_armor;
 }
 
+/* What affect_total_sub() would take off ch, worked out without touching
+ * it: the total gear and affects add at each APPLY_ location, and every AFF
+ * bit they grant. */
+void affect_total_applied(struct char_data *ch, int totals[NUM_APPLIES],
+                          int aff_bits[AF_ARRAY_MAX])
+{
+  struct affected_type *af;
+  struct obj_data *obj;
+  int i, j, loc, temp_mod;
+
+  memset(totals, 0, sizeof(int) * NUM_APPLIES);
+  memset(aff_bits, 0, sizeof(int) * AF_ARRAY_MAX);
+
+  for (i = 0; i < NUM_WEARS; i++)
+  {
+    if (!(obj = GET_EQ(ch, i)))
+      continue;
+    for (j = 0; j < AF_ARRAY_MAX; j++)
+      aff_bits[j] |= GET_OBJ_AFFECT(obj)[j];
+    for (j = 0; j < MAX_OBJ_AFFECT; j++)
+    {
+      loc = obj->affected[j].location;
+      if (loc < 0 || loc >= NUM_APPLIES || !BONUS_TYPE_STACKS(obj->affected[j].bonus_type))
+        continue;
+      temp_mod = obj->affected[j].modifier;
+      if (is_weapon_wielded_two_handed(obj, ch))
+        temp_mod *= 2;
+      totals[loc] += temp_mod;
+    }
+  }
+
+  for (af = ch->affected; af; af = af->next)
+  {
+    for (j = 0; j < AF_ARRAY_MAX; j++)
+      aff_bits[j] |= af->bitvector[j];
+    if (af->location >= 0 && af->location < NUM_APPLIES && BONUS_TYPE_STACKS(af->bonus_type))
+      totals[af->location] += af->modifier;
+  }
+
+  affect_bonus_cache_sync(ch);
+  for (i = 0; i < NUM_APPLIES; i++)
+    totals[i] += affect_bonus_total(ch, i);
+}
+
 /* this is just affect-total, the 're-adding' portion of the function */
 void affect_total_plus(struct char_data *ch, int at_armor)
 {
@@ -1136,11 +1474,10 @@ void affect_total_plus(struct char_data *ch, int at_armor)
   }
 
   /* Adjust the modifiers to APPLY_ fields. */
+  affect_bonus_cache_sync(ch);
   for (i = 0; i < NUM_APPLIES; i++)
   {
-    modifier = 0;
-    for (j = 0; j < NUM_BONUS_TYPES; j++)
-      modifier += calculate_best_mod(ch, i, j, -1, -1);
+    modifier = affect_bonus_total(ch, i);
     aff_apply_modify(ch, i, modifier, "affect_total_plus");
     // affect_modify_ar(ch, i, modifier, empty_bits, TRUE);
   }
@@ -1390,6 +1727,7 @@ void affect_total(struct char_data *ch)
 
   /* this will re-add all affects, cap the char, and modify any dynamics */
   affect_total_plus(ch, at_armor);
+  msdp_mark_dirty(ch, MSDP_DIRTY_STATS | MSDP_DIRTY_INVENTORY);
 
   /* MSDP */
   if (!defer_msdp)
@@ -1415,6 +1753,7 @@ void affect_to_char_source(struct char_data *ch, struct affected_type *af, long
   affected_alloc->next = ch->affected;
   ch->affected = affected_alloc;
   affected_registry_sync(ch);
+  affect_bonus_note_affect(ch, affected_alloc, TRUE);
 
   /*affect_modify_ar(ch, af->location, af->modifier, af->bitvector, TRUE);*/
   affect_modify_ar(ch, af->location, 0, af->bitvector, TRUE);
@@ -1492,6 +1831,7 @@ void affect_remove_no_total(struct char_data *ch, struct affected_type *af)
   }
 
   REMOVE_FROM_LIST(af, ch->affected, next);
+  affect_bonus_note_affect(ch, af, FALSE);
   free_affect(af);
   affected_registry_sync(ch);
 
@@ -1551,6 +1891,7 @@ void affect_remove(struct char_data *ch, struct affected_type *af)
   }
 
   REMOVE_FROM_LIST(af, ch->affected, next);
+  affect_bonus_note_affect(ch, af, FALSE);
 
   free_affect(af);
   affected_registry_sync(ch);
@@ -1877,6 +2218,8 @@ void char_from_room(struct char_data *ch)
     }
   }
 
+  zone_presence_leave(ch);
+  spatial_grid_char_leave(ch);
   REMOVE_FROM_LIST(ch, world[IN_ROOM(ch)].people, next_in_room);
   IN_ROOM(ch) = NOWHERE;
   ch->next_in_room = NULL;
@@ -2023,6 +2366,8 @@ void char_to_room(struct char_data *ch, room_rnum room)
     ch->next_in_room = world[room].people;
     world[room].people = ch;
     IN_ROOM(ch) = room;
+    zone_presence_update(ch);
+    spatial_grid_char_update(ch);
 
     /* Trigger lazy regeneration for wilderness rooms (Phase 6) */
     if (is_wilderness_room && !IS_NPC(ch))
@@ -2061,6 +2406,7 @@ void char_to_room(struct char_data *ch, room_rnum room)
     }
     // Send new MSDP data.
     update_msdp_room(ch);
+    msdp_mark_dirty(ch, MSDP_DIRTY_INVENTORY); /* What ch can see of it */
     if (ch->desc)
     {
       MSDPFlush(ch->desc, eMSDP_ROOM);
@@ -2516,6 +2862,8 @@ void equip_char(struct char_data *ch, struct obj_data *obj, int pos)
   GET_EQ(ch, pos) = obj;
   obj->worn_by = ch;
   obj->worn_on = pos;
+  affect_bonus_note_obj(ch, obj, pos, TRUE);
+  rebuild_equip_feats(ch);
 
   /* Object special abilities, process for ACTMTD_WEAR */
   process_item_abilities(obj, ch, NULL, ACTMTD_WEAR, NULL);
@@ -2602,6 +2950,8 @@ struct obj_data *unequip_char(struct char_data *ch, int pos)
     log("SYSERR: IN_ROOM(ch) = NOWHERE when unequipping char %s.", GET_NAME(ch));
 
   GET_EQ(ch, pos) = NULL;
+  affect_bonus_note_obj(ch, obj, pos, FALSE);
+  rebuild_equip_feats(ch);
 
   for (j = 0; j < MAX_OBJ_AFFECT; j++)
   {
@@ -3050,6 +3400,7 @@ void extract_char_final(struct char_data *ch)
                                (enum perf_entity_reason)ch->perf_create_reason);
 
   mobile_activity_forget_character(ch);
+  pubsub_index_player_offline(ch);
 
   PERF_prof_sect_init(&pr_last_attacker, "extract.last_attacker");
   PERF_prof_sect_enter(pr_last_attacker);
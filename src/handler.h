@@ -18,6 +18,15 @@ void check_room_lighting(room_rnum room, struct char_data *ch, bool enter);
 int affect_total_sub(struct char_data *ch);
 void affect_total_plus(struct char_data *ch, int at_armor);
 void affect_total(struct char_data *ch);
+void affect_total_applied(struct char_data *ch, int totals[NUM_APPLIES],
+                          int aff_bits[AF_ARRAY_MAX]);
+int calculate_best_mod(struct char_data *ch, int location, int bonus_type, int except_eq,
+                       int except_spell);
+extern bool affect_bonus_validate;
+void affect_bonus_cache_sync(struct char_data *ch);
+void affect_bonus_cache_invalidate(struct char_data *ch);
+int affect_bonus_total(struct char_data *ch, int location);
+int affect_bonus_cache_verify(struct char_data *ch);
 void affect_batch_begin(struct char_data *ch);
 void affect_batch_end(struct char_data *ch);
 void affect_to_char(struct char_data *ch, struct affected_type *af);
@@ -49,6 +58,7 @@ void affect_modify_ar(struct char_data *ch, byte loc, sh_int mod, int bitv[], bo
 void clear_repulsion_lists(struct char_data *ch);
 void ensure_repulsion_lists(struct char_data *ch);
 void change_spell_mod(struct char_data *ch, int spellnum, int location, int amount, bool display);
+void reset_point_data(struct char_point_data *points, const struct char_point_data *real_points);
 void reset_char_points(struct char_data *ch);
 void compute_char_cap(struct char_data *ch, int mode);
 
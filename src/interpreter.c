@@ -5716,6 +5716,208 @@ int script_command_interpreter(struct char_data *ch, char *arg)
 
 const char *reserved[] = {"a", "an", "self", "me", "all", "room", "someone", "something", "\n"};
 
+/* Command lookup index.  A trie over the names in complete_cmd_info: the
+ * node reached by reading an abbreviation holds, for the commands and for
+ * the socials separately, the entries a character of some level would
+ * resolve it to.  Walking complete_cmd_info in order, an entry is added to
+ * a node's list only if it is open to a lower level than every entry
+ * already there, so the first entry in the list a character may use is the
+ * first the old strncmp scan would have stopped on. */
+
+#if defined(COMMAND_INDEX_VALIDATE)
+bool command_index_validate = TRUE;
+#else
+bool command_index_validate = FALSE;
+#endif
+
+#define CMD_LADDER_COMMANDS 0
+#define CMD_LADDER_SOCIALS 1
+
+struct cmd_ladder_step
+{
+  int cmd;
+  int level;
+  int next; /* Next step with a lower level, or -1 */
+};
+
+struct cmd_trie_node
+{
+  unsigned char ch;
+  int child, sibling; /* -1 when there is none */
+  int exact;          /* First command named exactly this, or -1 */
+  int ladder[2];      /* CMD_LADDER_*: first step, or -1 */
+  int tail[2];        /* ... and last step */
+};
+
+static struct
+{
+  bool built;
+  const struct command_info *commands;
+  int num_of_cmds; /* Index of the "\n" terminator */
+  struct cmd_trie_node *nodes;
+  int num_nodes, max_nodes;
+  struct cmd_ladder_step *steps;
+  int num_steps, max_steps;
+} cmd_index;
+
+static int cmd_index_new_node(unsigned char ch)
+{
+  struct cmd_trie_node *node;
+
+  if (cmd_index.num_nodes == cmd_index.max_nodes)
+  {
+    cmd_index.max_nodes = MAX(256, cmd_index.max_nodes * 2);
+    RECREATE(cmd_index.nodes, struct cmd_trie_node, cmd_index.max_nodes);
+  }
+  node = &cmd_index.nodes[cmd_index.num_nodes];
+  node->ch = ch;
+  node->child = node->sibling = node->exact = -1;
+  node->ladder[0] = node->ladder[1] = node->tail[0] = node->tail[1] = -1;
+  return cmd_index.num_nodes++;
+}
+
+static int cmd_index_child(int node, unsigned char ch, bool create)
+{
+  int i;
+
+  for (i = cmd_index.nodes[node].child; i != -1; i = cmd_index.nodes[i].sibling)
+    if (cmd_index.nodes[i].ch == ch)
+      return i;
+  if (!create)
+    return -1;
+
+  i = cmd_index_new_node(ch);
+  cmd_index.nodes[i].sibling = cmd_index.nodes[node].child;
+  cmd_index.nodes[node].child = i;
+  return i;
+}
+
+static void cmd_index_climb(int node, int ladder, int cmd, int level)
+{
+  struct cmd_trie_node *n = &cmd_index.nodes[node];
+  int step;
+
+  if (n->tail[ladder] != -1 && cmd_index.steps[n->tail[ladder]].level <= level)
+    return;
+
+  if (cmd_index.num_steps == cmd_index.max_steps)
+  {
+    cmd_index.max_steps = MAX(256, cmd_index.max_steps * 2);
+    RECREATE(cmd_index.steps, struct cmd_ladder_step, cmd_index.max_steps);
+  }
+  step = cmd_index.num_steps++;
+  cmd_index.steps[step].cmd = cmd;
+  cmd_index.steps[step].level = level;
+  cmd_index.steps[step].next = -1;
+  if (n->tail[ladder] == -1)
+    n->ladder[ladder] = step;
+  else
+    cmd_index.steps[n->tail[ladder]].next = step;
+  n->tail[ladder] = step;
+}
+
+static void command_index_build(void)
+{
+  const char *name;
+  int cmd, node, ladder;
+
+  cmd_index.num_nodes = cmd_index.num_steps = 0;
+  cmd_index.built = FALSE;
+  if (complete_cmd_info == NULL)
+    return;
+
+  cmd_index_new_node('\0');
+  for (cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
+  {
+    ladder = complete_cmd_info[cmd].command_pointer == do_action ? CMD_LADDER_SOCIALS
+                                                                 : CMD_LADDER_COMMANDS;
+    node = 0;
+    cmd_index_climb(node, ladder, cmd, complete_cmd_info[cmd].minimum_level);
+    for (name = complete_cmd_info[cmd].command; *name; name++)
+    {
+      node = cmd_index_child(node, (unsigned char)*name, TRUE);
+      cmd_index_climb(node, ladder, cmd, complete_cmd_info[cmd].minimum_level);
+    }
+    if (cmd_index.nodes[node].exact == -1)
+      cmd_index.nodes[node].exact = cmd;
+  }
+
+  cmd_index.commands = complete_cmd_info;
+  cmd_index.num_of_cmds = cmd;
+  cmd_index.built = TRUE;
+}
+
+/* Rebuilt when the command list is recreated or a command's level changes. */
+static void command_index_current(void)
+{
+  if (!cmd_index.built || cmd_index.commands != complete_cmd_info)
+    command_index_build();
+}
+
+void command_index_changed(void)
+{
+  cmd_index.built = FALSE;
+}
+
+/* The linear scans command_interpreter() used, kept for
+ * command_index_validate and the tests. */
+int lookup_command_scan(const char *arg, int level)
+{
+  size_t length = strlen(arg);
+  int cmd;
+
+  for (cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
+    if (complete_cmd_info[cmd].command_pointer != do_action &&
+        !strncmp(complete_cmd_info[cmd].command, arg, length))
+      if (level >= complete_cmd_info[cmd].minimum_level)
+        return cmd;
+
+  /* it's not a 'real' command, so it's a social */
+  for (cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
+    if (complete_cmd_info[cmd].command_pointer == do_action &&
+        !strncmp(complete_cmd_info[cmd].command, arg, length))
+      if (level >= complete_cmd_info[cmd].minimum_level)
+        return cmd;
+
+  return cmd;
+}
+
+static int command_index_lookup(const char *arg, int level)
+{
+  int node = 0, ladder, step;
+
+  for (; *arg && node != -1; arg++)
+    node = cmd_index_child(node, (unsigned char)*arg, FALSE);
+
+  if (node != -1)
+    for (ladder = CMD_LADDER_COMMANDS; ladder <= CMD_LADDER_SOCIALS; ladder++)
+      for (step = cmd_index.nodes[node].ladder[ladder]; step != -1;
+           step = cmd_index.steps[step].next)
+        if (level >= cmd_index.steps[step].level)
+          return cmd_index.steps[step].cmd;
+
+  return cmd_index.num_of_cmds;
+}
+
+int lookup_command(const char *arg, int level)
+{
+  int cmd, scanned;
+
+  command_index_current();
+  if (!cmd_index.built)
+    return lookup_command_scan(arg, level);
+
+  cmd = command_index_lookup(arg, level);
+  if (command_index_validate && (scanned = lookup_command_scan(arg, level)) != cmd)
+  {
+    log("SYSERR: lookup_command('%s', %d) from the index was %d, scan %d; rebuilding", arg,
+        level, cmd, scanned);
+    command_index_build();
+    cmd = scanned;
+  }
+  return cmd;
+}
+
 static int sort_commands_helper(const void *a, const void *b)
 {
   return strcmp(complete_cmd_info[*(const int *)a].sort_as,
@@ -5737,6 +5939,8 @@ void sort_commands(void)
 
   /* Don't sort the RESERVED or \n entries. */
   qsort(cmd_sort_info + 1, num_of_cmds - 2, sizeof(int), sort_commands_helper);
+
+  command_index_build();
 }
 
 bool command_actions_available(struct char_data *ch, int actions_required)
@@ -5786,7 +5990,7 @@ bool command_has_queue_preflight(int cmd)
  * then calls the appropriate function. */
 void command_interpreter(struct char_data *ch, char *argument)
 {
-  int cmd = 0, length = 0;
+  int cmd = 0;
   char *line = NULL;
   char arg[MAX_INPUT_LENGTH] = {'\0'};
 
@@ -5857,20 +6061,8 @@ void command_interpreter(struct char_data *ch, char *argument)
       return;
   }
 
-  for (length = strlen(arg), cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
-    if (complete_cmd_info[cmd].command_pointer != do_action &&
-        !strncmp(complete_cmd_info[cmd].command, arg, length))
-      if (GET_LEVEL(ch) >= complete_cmd_info[cmd].minimum_level)
-        break;
-
-  /* it's not a 'real' command, so it's a social */
-
-  if (*complete_cmd_info[cmd].command == '\n')
-    for (length = strlen(arg), cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
-      if (complete_cmd_info[cmd].command_pointer == do_action &&
-          !strncmp(complete_cmd_info[cmd].command, arg, length))
-        if (GET_LEVEL(ch) >= complete_cmd_info[cmd].minimum_level)
-          break;
+  /* Commands first; if it's not a 'real' command, it's a social. */
+  cmd = lookup_command(arg, GET_LEVEL(ch));
 
   if (*complete_cmd_info[cmd].command == '\n')
   {
@@ -6515,7 +6707,15 @@ int is_abbrev(const char *arg1, const char *arg2)
 /* Used in specprocs, mostly.  (Exactly) matches "command" to cmd number */
 int find_command(const char *command)
 {
-  int cmd;
+  int cmd, node = 0;
+
+  command_index_current();
+  if (cmd_index.built && *command)
+  {
+    for (; *command && node != -1; command++)
+      node = cmd_index_child(node, (unsigned char)*command, FALSE);
+    return node == -1 ? -1 : cmd_index.nodes[node].exact;
+  }
 
   for (cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
     if (!strcmp(complete_cmd_info[cmd].command, command))
@@ -6889,6 +7089,7 @@ int enter_player_game(struct descriptor_data *d)
   d->character->next = character_list;
   character_list = d->character;
   affected_registry_attach(d->character);
+  pubsub_index_player_online(d->character);
   char_to_room(d->character, load_room);
   load_result = Crash_load(d->character);
 
@@ -46,6 +46,14 @@ void nanny(struct descriptor_data *d, char *arg);
 int is_abbrev(const char *arg1, const char *arg2);
 int is_number(const char *str);
 int find_command(const char *command);
+/* The command arg abbreviates for a character of the given level: the first
+ * such command in complete_cmd_info, else the first such social, else the
+ * "\n" terminator. */
+int lookup_command(const char *arg, int level);
+int lookup_command_scan(const char *arg, int level);
+/* Call after recreating complete_cmd_info or changing a minimum_level. */
+void command_index_changed(void);
+extern bool command_index_validate;
 bool command_actions_available(struct char_data *ch, int actions_required);
 bool command_has_queue_preflight(int cmd);
 void skip_spaces(char **string);
@@ -1386,9 +1386,9 @@ void affect_update(void)
       dispatch_affect_wearoff(i, wearoff_spells[wearoff_index]);
     free(wearoff_spells);
 
-    /* Only update MSDP for player characters with active descriptors */
-    if (!IS_NPC(i) && i->desc)
-      update_msdp_affects(i);
+    /* Durations have changed; MSDP sends them with its next update. */
+    if (!IS_NPC(i))
+      msdp_mark_dirty(i, MSDP_DIRTY_AFFECTS);
   }
   affected_registry_iteration_end();
 
@@ -1396,7 +1396,7 @@ void affect_update(void)
   for (descriptor = descriptor_list; descriptor != NULL; descriptor = descriptor->next)
     if (descriptor->character != NULL && !IS_NPC(descriptor->character) &&
         descriptor->character->affected == NULL)
-      update_msdp_affects(descriptor->character);
+      msdp_mark_dirty(descriptor->character, MSDP_DIRTY_AFFECTS);
 
   PERF_note_sweep(PERF_SWEEP_AFFECT, (uint64_t)char_count, (uint64_t)eligible_count,
                   (uint64_t)processed_affects);
@@ -17,6 +17,7 @@
 #include "spells.h"
 #include "handler.h"
 #include "db.h"
+#include "zone_presence.h"
 #include "constants.h"
 #include "character/perks.h"
 #include "interpreter.h"
@@ -3833,6 +3834,7 @@ ASPELL(spell_wizard_eye)
   ch->desc->original = ch;
   eye->desc = ch->desc;
   ch->desc = NULL;
+  zone_presence_update(eye);
 }
 
 ASPELL(psionic_concussive_onslaught)
@@ -37,6 +37,7 @@
 #include "mob_known_spells.h"
 #include "mob_spells.h"
 #include "vessels/vessels.h"
+#include "perfmon.h"
 
 /* External function prototypes */
 void npc_offensive_spells(struct char_data *ch);
@@ -70,6 +71,8 @@ static struct char_data *run_mobile_activity(struct char_data *start, size_t nod
   int mob_rnum = 0;                     /* Cache for mob rnum */
   bool disabled = false;
   size_t nodes_visited = 0;
+  uint64_t tier_visited[NUM_MOB_TIERS] = {0}, tier_acted[NUM_MOB_TIERS] = {0};
+  int tier;
 
   for (ch = start; ch && nodes_visited < node_limit; ch = next_ch)
   {
@@ -90,6 +93,13 @@ static struct char_data *run_mobile_activity(struct char_data *start, size_t nod
     if (!IS_MOB(ch))
       continue;
 
+    /* Mobiles far from any player only get a turn now and then. */
+    tier = mob_dormancy_tier(ch);
+    tier_visited[tier]++;
+    if (!mob_dormancy_should_act(ch, tier))
+      continue;
+    tier_acted[tier]++;
+
     if (rol_automatic_race_activity(ch))
       continue;
 
@@ -561,6 +571,7 @@ static struct char_data *run_mobile_activity(struct char_data *start, size_t nod
 
   } /* end for() */
 
+  PERF_note_mob_activity(tier_visited, tier_acted);
   if (nodes_visited_out != NULL)
     *nodes_visited_out = nodes_visited;
   return ch;
@@ -568,6 +579,7 @@ static struct char_data *run_mobile_activity(struct char_data *start, size_t nod
 
 void mobile_activity(void)
 {
+  mob_dormancy_begin_cycle();
   run_mobile_activity(character_list, (size_t)-1, NULL);
 }
 
@@ -577,6 +589,7 @@ void mobile_activity_reset(void)
   mobile_activity_nodes_remaining = 0;
   mobile_activity_pulses_remaining = 0;
   mobile_activity_cursor_running = false;
+  mob_dormancy_reset();
 }
 
 void mobile_activity_forget_character(struct char_data *ch)
@@ -607,6 +620,7 @@ void mobile_activity_pulse(int heart_pulse)
     mobile_activity_cursor = character_list;
     mobile_activity_nodes_remaining = count_mobile_activity_nodes();
     mobile_activity_pulses_remaining = PULSE_MOBILE;
+    mob_dormancy_begin_cycle();
   }
 
   if (mobile_activity_nodes_remaining > 0 && mobile_activity_cursor != NULL)
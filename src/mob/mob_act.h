@@ -18,6 +18,7 @@
 #include "mob_psionic.h"
 #include "mob_class.h"
 #include "mob_spells.h"
+#include "mob_dormancy.h"
 
 /* Main mobile activity function */
 void mobile_activity(void);
@@ -0,0 +1,223 @@
+/**************************************************************************
+ *  File: mob_dormancy.c                              Part of LuminariMUD *
+ *  Usage: Activity tiers for the mobile activity scheduler               *
+ *                                                                         *
+ *  All rights reserved.  See license for complete information.           *
+ *                                                                         *
+ *  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+ *  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.              *
+ **************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "graph.h"
+#include "zone_presence.h"
+#include "dgscript/dg_scripts.h"
+#include "mob_dormancy.h"
+
+struct zone_edge
+{
+  zone_rnum from, to;
+};
+
+static struct
+{
+  /* Zone neighbour table, rebuilt when the world or its exits change. */
+  bool built;
+  struct room_data *world;
+  room_rnum top_of_world;
+  struct zone_data *zone_table;
+  zone_rnum top_of_zone_table;
+  unsigned int exits_epoch;
+  int *first; /* Neighbours of zone z are next[first[z]] .. next[first[z + 1] - 1] */
+  zone_rnum *next;
+
+  /* Tiers worked out at the start of the current cycle. */
+  struct zone_data *tier_zone_table;
+  int tier_zones; /* 0 when there are none */
+  int capacity;
+  unsigned char *tiers;
+  int *depth;
+  zone_rnum *queue;
+  unsigned int cycle;
+} dormancy;
+
+static int zone_edge_compare(const void *a, const void *b)
+{
+  const struct zone_edge *x = a, *y = b;
+
+  if (x->from != y->from)
+    return x->from < y->from ? -1 : 1;
+  if (x->to != y->to)
+    return x->to < y->to ? -1 : 1;
+  return 0;
+}
+
+/* Two zones are neighbours when an exit runs between them, either way. */
+static void dormancy_build_neighbours(void)
+{
+  struct zone_edge *edges = NULL;
+  int count = 0, capacity = 0, zones = top_of_zone_table + 1, i, kept;
+  room_rnum room, to;
+  zone_rnum from_zone, to_zone;
+  int dir;
+
+  for (room = 0; room <= top_of_world; room++)
+  {
+    from_zone = world[room].zone;
+    if (from_zone == NOWHERE || from_zone > top_of_zone_table)
+      continue;
+    for (dir = 0; dir < NUM_OF_DIRS; dir++)
+    {
+      if (world[room].dir_option[dir] == NULL)
+        continue;
+      to = world[room].dir_option[dir]->to_room;
+      if (to == NOWHERE || to > top_of_world)
+        continue;
+      to_zone = world[to].zone;
+      if (to_zone == from_zone || to_zone == NOWHERE || to_zone > top_of_zone_table)
+        continue;
+      if (count + 2 > capacity)
+      {
+        capacity = MAX(64, capacity * 2);
+        RECREATE(edges, struct zone_edge, capacity);
+      }
+      edges[count].from = from_zone;
+      edges[count++].to = to_zone;
+      edges[count].from = to_zone;
+      edges[count++].to = from_zone;
+    }
+  }
+
+  if (count > 1)
+    qsort(edges, count, sizeof(struct zone_edge), zone_edge_compare);
+
+  RECREATE(dormancy.first, int, zones + 1);
+  RECREATE(dormancy.next, zone_rnum, MAX(count, 1));
+  for (i = 0; i <= zones; i++)
+    dormancy.first[i] = 0;
+  for (i = 0, kept = 0; i < count; i++)
+  {
+    if (i > 0 && !zone_edge_compare(&edges[i - 1], &edges[i]))
+      continue;
+    dormancy.next[kept++] = edges[i].to;
+    dormancy.first[edges[i].from + 1] = kept;
+  }
+  /* Zones with no neighbours start where the previous one ended. */
+  for (i = 1; i <= zones; i++)
+    if (dormancy.first[i] < dormancy.first[i - 1])
+      dormancy.first[i] = dormancy.first[i - 1];
+  free(edges);
+
+  dormancy.world = world;
+  dormancy.top_of_world = top_of_world;
+  dormancy.zone_table = zone_table;
+  dormancy.top_of_zone_table = top_of_zone_table;
+  dormancy.exits_epoch = graph_exits_epoch();
+  dormancy.built = TRUE;
+}
+
+static void dormancy_current_neighbours(void)
+{
+  if (!dormancy.built || dormancy.world != world || dormancy.top_of_world != top_of_world ||
+      dormancy.zone_table != zone_table || dormancy.top_of_zone_table != top_of_zone_table ||
+      dormancy.exits_epoch != graph_exits_epoch())
+    dormancy_build_neighbours();
+}
+
+void mob_dormancy_begin_cycle(void)
+{
+  int zones, head = 0, tail = 0, ring = CONFIG_MOB_ACTIVE_RING, i;
+  zone_rnum zone;
+
+  dormancy.cycle++;
+  dormancy.tier_zones = 0;
+  if (world == NULL || zone_table == NULL || top_of_zone_table == NOWHERE)
+    return;
+
+  zones = top_of_zone_table + 1;
+  if (zones > dormancy.capacity)
+  {
+    RECREATE(dormancy.tiers, unsigned char, zones);
+    RECREATE(dormancy.depth, int, zones);
+    RECREATE(dormancy.queue, zone_rnum, zones);
+    dormancy.capacity = zones;
+  }
+
+  for (zone = 0; (int)zone < zones; zone++)
+  {
+    if (zone_presence_occupied(zone))
+    {
+      dormancy.tiers[zone] = MOB_TIER_OCCUPIED;
+      dormancy.depth[zone] = 0;
+      dormancy.queue[tail++] = zone;
+    }
+    else
+      dormancy.tiers[zone] = MOB_TIER_DORMANT;
+  }
+
+  /* Breadth-first out from every occupied zone at once, ring zones deep. */
+  if (ring > 0 && tail > 0)
+  {
+    dormancy_current_neighbours();
+    while (head < tail)
+    {
+      zone = dormancy.queue[head++];
+      if (dormancy.depth[zone] >= ring)
+        continue;
+      for (i = dormancy.first[zone]; i < dormancy.first[zone + 1]; i++)
+        if (dormancy.tiers[dormancy.next[i]] == MOB_TIER_DORMANT)
+        {
+          dormancy.tiers[dormancy.next[i]] = MOB_TIER_NEARBY;
+          dormancy.depth[dormancy.next[i]] = dormancy.depth[zone] + 1;
+          dormancy.queue[tail++] = dormancy.next[i];
+        }
+    }
+  }
+
+  dormancy.tier_zone_table = zone_table;
+  dormancy.tier_zones = zones;
+}
+
+int mob_dormancy_zone_tier(zone_rnum zone)
+{
+  /* Zones added or renumbered since the cycle began have no tier yet. */
+  if (zone == NOWHERE || (int)zone >= dormancy.tier_zones ||
+      dormancy.tier_zone_table != zone_table || dormancy.tier_zones != (int)top_of_zone_table + 1)
+    return MOB_TIER_ALWAYS;
+  return dormancy.tiers[zone];
+}
+
+int mob_dormancy_tier(struct char_data *ch)
+{
+  if (ch->desc || FIGHTING(ch) || HUNTING(ch) || ch->master || MOB_FLAGGED(ch, MOB_HUNTER) ||
+      SCRIPT_CHECK(ch, MTRIG_GLOBAL) || world[IN_ROOM(ch)].ship != NULL)
+    return MOB_TIER_ALWAYS;
+  return mob_dormancy_zone_tier(world[IN_ROOM(ch)].zone);
+}
+
+bool mob_dormancy_should_act(struct char_data *ch, int tier)
+{
+  unsigned int cadence, stagger;
+
+  if (tier != MOB_TIER_DORMANT || CONFIG_MOB_DORMANT_CADENCE == 0)
+    return TRUE;
+  if (CONFIG_MOB_DORMANT_CADENCE < 0)
+    return FALSE;
+
+  /* Spread a dormant zone's mobiles over the cadence rather than waking
+   * them all on the same cycle. */
+  cadence = (unsigned int)CONFIG_MOB_DORMANT_CADENCE;
+  stagger = (unsigned int)((uintptr_t)ch >> 4) * 2654435761U;
+  return (dormancy.cycle + (stagger >> 16)) % cadence == 0;
+}
+
+void mob_dormancy_reset(void)
+{
+  dormancy.built = FALSE;
+  dormancy.tier_zones = 0;
+  dormancy.tier_zone_table = NULL;
+}
@@ -0,0 +1,42 @@
+/**************************************************************************
+ *  File: mob_dormancy.h                              Part of LuminariMUD *
+ *  Usage: Activity tiers for the mobile activity scheduler               *
+ *                                                                         *
+ *  All rights reserved.  See license for complete information.           *
+ *                                                                         *
+ *  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+ *  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.              *
+ **************************************************************************/
+
+#ifndef _MOB_DORMANCY_H_
+#define _MOB_DORMANCY_H_
+
+/* Every mobile_activity cycle each zone is sorted into a tier: occupied if
+ * a player is in it, nearby if it is within CONFIG_MOB_ACTIVE_RING zones
+ * of an occupied one (zones are neighbours when an exit joins them), and
+ * dormant otherwise.  Mobiles in dormant zones only get their AI one cycle
+ * in CONFIG_MOB_DORMANT_CADENCE.  Mobiles that have something to do
+ * regardless (fighting, hunting, switched into, following someone, global
+ * triggers, vessel crews) are always on. */
+#define MOB_TIER_ALWAYS 0
+#define MOB_TIER_OCCUPIED 1
+#define MOB_TIER_NEARBY 2
+#define MOB_TIER_DORMANT 3
+#define NUM_MOB_TIERS 4 /* Must match PERF_MOB_TIERS */
+
+/* Work out the zone tiers for the cycle about to start. */
+void mob_dormancy_begin_cycle(void);
+
+/* The tier ch's AI runs under this cycle. */
+int mob_dormancy_tier(struct char_data *ch);
+
+/* Whether ch, in the given tier, gets its AI this cycle. */
+bool mob_dormancy_should_act(struct char_data *ch, int tier);
+
+/* Tier of a zone this cycle, or MOB_TIER_ALWAYS if it has none. */
+int mob_dormancy_zone_tier(zone_rnum zone);
+
+/* Forget the zone tiers and the zone neighbour table. */
+void mob_dormancy_reset(void);
+
+#endif /* _MOB_DORMANCY_H_ */
@@ -0,0 +1,172 @@
+/**
+ * @file mud_options.example.h
+ * @brief MUD configuration options and compile-time settings
+ *
+ * This file contains various MUD options that must be set in the code.
+ *
+ * IMPORTANT: Make a copy of this file and name it mud_options.h, then change
+ * the options to suit your MUD's needs. Please ensure you read the comment
+ * associated with each option, as some configurations, if not done correctly,
+ * can cause your game to crash.
+ *
+ * This file controls compile-time options that affect game behavior, including:
+ * - Container system configuration
+ * - Newbie equipment selection
+ * - Crafting system selection
+ * - Available races
+ */
+
+#ifndef _MUD_OPTIONS_H_
+#define _MUD_OPTIONS_H_
+
+/* ************************************************************************
+ * Container System Configuration
+ *
+ * WARNING: ONE AND ONLY ONE of the following two options MUST be defined.
+ * Defining both or neither will cause compilation errors.
+ * ************************************************************************ */
+
+/**
+ * USE_CONTAINER_OBJECTS - Traditional container object system
+ *
+ * If defined, the game will use container objects.
+ *
+ * Status: RECOMMENDED
+ */
+#define USE_CONTAINER_OBJECTS
+
+/**
+ * USE_VIRTUAL_BAGS_ONLY - Virtual bag container system
+ *
+ * If defined, the game will only use virtual bags for containers. This is
+ * the recommended option for most MUDs. Instead of using container objects,
+ * everything will be contained in virtual bags.
+ *
+ * See HELP BAGS in game for more information.
+ *
+ * Status: Up to you!
+ */
+/* #define USE_VIRTUAL_BAGS_ONLY */
+
+/* ************************************************************************
+ * Crafting System Configuration
+ *
+ * WARNING: ONE AND ONLY ONE of the following two options MUST be defined.
+ * Defining both or neither will cause compilation errors.
+ *
+ * The crafting system determines how magic items are awarded in the game.
+ * ************************************************************************ */
+
+/**
+ * USE_OLD_CRAFTING_SYSTEM - Traditional magic item award system
+ *
+ * This is the simpler, more stable option and is recommended for most MUDs.
+ * Provides basic crafting functionality with proven stability.
+ *
+ * Status: RECOMMENDED - Stable and well-tested
+ */
+#define USE_OLD_CRAFTING_SYSTEM
+
+/**
+ * USE_NEW_CRAFTING_SYSTEM - Advanced crafting system
+ *
+ * Provides more advanced crafting features including:
+ * - More complex recipes
+ * - Additional crafting skills
+ * - Enhanced customization options
+ *
+ * Status: EXPERIMENTAL - May be less stable
+ */
+/* #define USE_NEW_CRAFTING_SYSTEM */
+
+// One of these two must be chosen.
+// basic materials means that each type of material (iron, steel, mithril, etc) has a static quality
+// variable quality means that each time materials are harvested, their quality can vary, such as
+// iron of a quality 1.5 or 0.6 or 1.8 with the quality affecting crafting success and degree
+// Variable quality requires the use of wilderness maps
+// #define USE_BASIC_MATERIALS
+#define USE_VARIABLE_QUALITY_MATERIALS
+
+/* ************************************************************************
+ * Available Races Configuration
+ *
+ * Define which races are available for player selection.
+ * Comment out any races you don't want available in your MUD.
+ * ************************************************************************ */
+
+/**
+ * RACE_ALLOW_KENDER - Enable Kender race
+ *
+ * Kender are known for their curiosity, fearlessness, and "borrowing"
+ * habits.
+ */
+#define RACE_ALLOW_KENDER
+
+/**
+ * RACE_ALLOW_DROW - Enable Drow Elf race
+ *
+ * Drow are dark elves who typically dwell in the Underdark. They have
+ * unique abilities including innate magic and superior darkvision.
+ */
+#define RACE_ALLOW_DROW
+
+/**
+ * RACE_ALLOW_VAMPIRE - Enable Vampire race
+ *
+ * Vampires are undead creatures with special powers and limitations.
+ * This is an advanced race that may require special handling.
+ */
+#define RACE_ALLOW_VAMPIRE
+
+/**
+ * WalkTo - Enabling either:
+ *   Landmarks - walk across the world (non-wilderness system)
+ *   City landmarks - walk within a city (wilderness system)
+ *
+ * You should only have one enabled!
+ */
+
+/* for non-wilderness system uncomment this and make sure to comment out the other */
+/* #define USE_WALKTO_LANDMARKS */
+
+/* Otherwise if you want to use city landmarks only, uncomment the following line and make sure to comment out above */
+#define USE_CITY_LANDMARKS_ONLY
+
+/* ************************************************************************
+ * Random Object Guidelines Configuration
+ *
+ * Define which random object guidelines to use.
+ *
+ * WARNING: ONE AND ONLY ONE of the following two options MUST be defined.
+ * Defining both or neither will cause compilation errors.
+ * ************************************************************************ */
+/* #define USE_NEW_RANDOM_OBJECT_GUIDELINES */
+#define USE_ORIGINAL_RANDOM_OBJECT_GUIDELINES
+
+/* Uncomment this line if you want to allow restrngs. Note that currently this is incomaptible with the new cratfing system */
+/* #define ALLOW_OBJECT_RETSRINGS_BY_PLAYERS */
+
+/* ************************************************************************
+ * Casting Visuals Configuration
+ *
+ * These options control the visual effects during spellcasting.
+ * ************************************************************************ */
+
+/**
+ * CASTING_ENV_EFFECTS_ENABLED - Environmental reactions during casting
+ *
+ * When defined, powerful spells will cause ambient environmental effects
+ * to be displayed to observers in the room (torches flickering, ground
+ * trembling, etc.). Effects scale with spell circle:
+ * - Circles 1-3: Subtle effects (15% chance per tick)
+ * - Circles 4-6: Moderate effects (25% chance per tick)
+ * - Circles 7-9: Dramatic effects (40% chance per tick)
+ *
+ * Comment out this line to disable environmental effects if they feel
+ * too spammy or affect server performance.
+ *
+ * Status: ENABLED by default
+ */
+#define CASTING_ENV_EFFECTS_ENABLED
+
+#endif /* _MUD_OPTIONS_H_ */
@@ -20,6 +20,8 @@
 #include "perfmon.h"
 
 #include "wilderness/wilderness.h"
+#include "wilderness/region_grid.h"
+#include "wilderness/region_geometry.h"
 #include "mud_event.h"
 
 #define MYSQL_DEBUG 0
@@ -43,6 +45,9 @@ static bool mysql_library_initialized;
 
 #ifdef LUMINARI_CUTEST
 static atomic_uint test_query_failure_countdown;
+static bool test_queries_accepted;
+static char *test_query_transcript;
+static size_t test_query_transcript_size;
 
 static bool mysql_test_should_fail_query(void)
 {
@@ -78,6 +83,16 @@ int luminari_mysql_query(MYSQL *mysql_conn, const char *query)
     PERF_note_sql_query(query, elapsed_usec, 1);
     return 1;
   }
+  if (test_queries_accepted)
+  {
+    if (test_query_transcript != NULL)
+    {
+      strlcat(test_query_transcript, query, test_query_transcript_size);
+      strlcat(test_query_transcript, "\n", test_query_transcript_size);
+    }
+    PERF_note_sql_query(query, 0, 0);
+    return 0;
+  }
 #endif
   result = (mysql_query)(mysql_conn, query);
   end_usec = PERF_monotonic_usec();
@@ -106,6 +121,15 @@ void mysql_test_clear_query_failure(void)
 {
   atomic_store_explicit(&test_query_failure_countdown, 0, memory_order_relaxed);
 }
+
+void mysql_test_accept_queries(bool accept, char *transcript, size_t size)
+{
+  test_queries_accepted = accept;
+  test_query_transcript = accept ? transcript : NULL;
+  test_query_transcript_size = accept ? size : 0;
+  if (test_query_transcript != NULL && size > 0)
+    *test_query_transcript = '\0';
+}
 #endif
 
 void after_world_load()
@@ -283,6 +307,7 @@ MYSQL_POOL_CONN *mysql_pool_acquire(void)
 {
   MYSQL_POOL_CONN *pc;
   time_t now;
+  uint64_t wait_start = 0;
 
   if (!mysql_pool || !mysql_pool->initialized)
   {
@@ -350,6 +375,9 @@ MYSQL_POOL_CONN *mysql_pool_acquire(void)
 
         pthread_mutex_unlock(&mysql_pool->pool_mutex);
 
+        if (wait_start)
+          PERF_note_sql_pool_wait(PERF_monotonic_usec() - wait_start);
+
         if (MYSQL_DEBUG)
         {
           log("DEBUG: Acquired connection %d from pool (active: %d/%d)", pc->id,
@@ -371,6 +399,8 @@ MYSQL_POOL_CONN *mysql_pool_acquire(void)
 
     /* Wait for a connection to become available */
     mysql_pool->wait_count++;
+    if (!wait_start)
+      wait_start = PERF_monotonic_usec();
     if (MYSQL_DEBUG)
     {
       log("DEBUG: Waiting for connection (all %d in use)", mysql_pool->current_size);
@@ -932,6 +962,22 @@ void connect_to_mysql()
       }
     }
 
+    /* The game thread queries through the legacy handles without acquiring
+     * them, so keep them out of mysql_pool_acquire()'s reach; another thread
+     * handed one would interleave with the game's own queries. */
+    {
+      MYSQL_POOL_CONN *pc;
+      int legacy = 0;
+
+      pthread_mutex_lock(&mysql_pool->pool_mutex);
+      for (pc = mysql_pool->connections; pc && legacy < 3; pc = pc->next, legacy++)
+      {
+        pc->state = CONN_STATE_IN_USE;
+        mysql_pool->active_count++;
+      }
+      pthread_mutex_unlock(&mysql_pool->pool_mutex);
+    }
+
     /* Log successful connection - password is intentionally not logged for security */
     log("Success: Connected to MySQL database '%s' on host '%s' as user '%s'", mysql_pool->database,
         mysql_pool->host, mysql_pool->username);
@@ -2156,6 +2202,8 @@ static void free_region_table_data(void)
 {
   int i;
 
+  region_grid_free_regions();
+
   if (region_table == NULL)
   {
     top_of_region_table = NOWHERE;
@@ -2181,6 +2229,8 @@ static void free_path_table_data(void)
 {
   int i;
 
+  region_grid_free_paths();
+
   if (path_table == NULL)
   {
     top_of_path_table = NOWHERE;
@@ -2368,6 +2418,7 @@ void load_regions()
   {
     top_of_region_table = i - 1;
     log("Info: Loaded %d regions, top_of_region_table set to %d", i, top_of_region_table);
+    region_grid_build_regions();
 
     /* Now create events after top_of_region_table is set */
     for (j = 0; j <= (int)top_of_region_table; j++)
@@ -2394,233 +2445,95 @@ void load_regions()
   mysql_free_result(result);
 }
 
-/* Move this out to another file... */
+/* ST_Within() on the loaded polygon; boundary points are not within. */
 bool is_point_within_region(region_vnum region, int x, int y)
 {
-  MYSQL_RES *result;
-  MYSQL_ROW row;
-  bool retval;
+  region_rnum rnum = real_region(region);
 
-  char buf[1024];
-
-  /* Need an ORDER BY here, since we can have multiple regions. */
-  snprintf(buf, sizeof(buf),
-           "SELECT 1 "
-           "from region_index "
-           "where vnum = %d and "
-           "ST_Within(ST_GeomFromText('POINT(%d %d)'), region_polygon)",
-           region, x, y);
-
-  /* Check the connection, reconnect if necessary. */
-  if (!MYSQL_PING_CONN(conn))
+  if (rnum == NOWHERE)
   {
-    log("SYSERR: %s: Database connection failed", __func__);
+    log("SYSERR: %s: region %d is not loaded", __func__, region);
     return false;
   }
 
-  if (mysql_query(conn, buf))
-  {
-    log("SYSERR: Unable to SELECT from region_index: %s", mysql_error(conn));
-    exit(1);
-  }
-
-  if (!(result = mysql_store_result(conn)))
-  {
-    log("SYSERR: Unable to SELECT from region_index: %s", mysql_error(conn));
-    exit(1);
-  }
-
-  retval = false;
-  while ((row = mysql_fetch_row(result)))
-  {
-    retval = true;
-  }
-  mysql_free_result(result);
-
-  return retval;
+  return region_geom_point_within(region_table[rnum].vertices, region_table[rnum].num_vertices, x,
+                                  y);
 }
 
-static double mysql_point_to_segment_dist_sq(double px, double py, double x1, double y1, double x2,
-                                             double y2)
+/* Test region i against (x, y) and prepend a node to *regions if it encloses
+ * the point. */
+static void mysql_add_enclosing_region(struct region_list **regions, zone_rnum zone, int i, int x,
+                                       int y)
 {
-  double dx = x2 - x1;
-  double dy = y2 - y1;
-  double len_sq = dx * dx + dy * dy;
-  double t;
-  double proj_x, proj_y, diff_x, diff_y;
-
-  if (len_sq == 0.0)
-  {
-    double dpx = px - x1;
-    double dpy = py - y1;
-    return (dpx * dpx + dpy * dpy);
-  }
-
-  t = ((px - x1) * dx + (py - y1) * dy) / len_sq;
-  if (t < 0.0)
-    t = 0.0;
-  else if (t > 1.0)
-    t = 1.0;
-
-  proj_x = x1 + t * dx;
-  proj_y = y1 + t * dy;
-  diff_x = px - proj_x;
-  diff_y = py - proj_y;
-
-  return (diff_x * diff_x + diff_y * diff_y);
-}
-
-static void mysql_polygon_centroid(const struct vertex *vertices, int vertex_count, double *cx,
-                                   double *cy)
-{
-  double area_twice = 0.0;
-  double weighted_x = 0.0;
-  double weighted_y = 0.0;
-  double cross;
-  int current, next;
-  int average_count;
-
-  *cx = 0.0;
-  *cy = 0.0;
+  struct region_list *new_node = NULL;
+  double cx, cy;
+  double dist_centroid, min_edge_dist_sq;
+  int pos = REGION_POS_INSIDE;
+  int v;
 
-  for (current = 0; current < vertex_count; current++)
-  {
-    next = (current + 1) % vertex_count;
-    cross = (double)vertices[current].x * vertices[next].y -
-            (double)vertices[next].x * vertices[current].y;
-    area_twice += cross;
-    weighted_x += ((double)vertices[current].x + vertices[next].x) * cross;
-    weighted_y += ((double)vertices[current].y + vertices[next].y) * cross;
-  }
+  if (region_table[i].zone != zone || region_table[i].vertices == NULL ||
+      region_table[i].num_vertices < 3)
+    return;
 
-  if (fabs(area_twice) > 1.0e-12)
-  {
-    *cx = weighted_x / (3.0 * area_twice);
-    *cy = weighted_y / (3.0 * area_twice);
+  if (!region_geom_point_within(region_table[i].vertices, region_table[i].num_vertices, x, y))
     return;
-  }
 
-  /* Region polygons should be non-degenerate. Retain deterministic behavior
-   * for malformed data while excluding a repeated closing vertex. */
-  average_count = vertex_count;
-  if (vertex_count > 1 && vertices[0].x == vertices[vertex_count - 1].x &&
-      vertices[0].y == vertices[vertex_count - 1].y)
-    average_count--;
+  region_geom_centroid(region_table[i].vertices, region_table[i].num_vertices, &cx, &cy);
 
-  for (current = 0; current < average_count; current++)
+  if (fabs((double)x - cx) < 1.0e-9 && fabs((double)y - cy) < 1.0e-9)
   {
-    *cx += vertices[current].x;
-    *cy += vertices[current].y;
+    pos = REGION_POS_CENTER;
   }
-  if (average_count > 0)
-  {
-    *cx /= average_count;
-    *cy /= average_count;
-  }
-}
-
-static bool mysql_point_in_polygon(const struct vertex *vertices, int vertex_count, int x, int y)
-{
-  bool inside;
-  long long cross_product;
-  double intersection_x;
-  int current, previous;
-  int current_x, current_y, previous_x, previous_y;
-
-  if (vertices == NULL || vertex_count < 3)
-    return FALSE;
-
-  inside = FALSE;
-  previous = vertex_count - 1;
-  for (current = 0; current < vertex_count; current++)
+  else
   {
-    current_x = vertices[current].x;
-    current_y = vertices[current].y;
-    previous_x = vertices[previous].x;
-    previous_y = vertices[previous].y;
-
-    cross_product = ((long long)x - current_x) * ((long long)previous_y - current_y) -
-                    ((long long)y - current_y) * ((long long)previous_x - current_x);
-    if (cross_product == 0 && x >= MIN(current_x, previous_x) && x <= MAX(current_x, previous_x) &&
-        y >= MIN(current_y, previous_y) && y <= MAX(current_y, previous_y))
+    min_edge_dist_sq = 1e30;
+    for (v = 0; v < region_table[i].num_vertices; v++)
     {
-      return FALSE;
+      int next_v = (v + 1) % region_table[i].num_vertices;
+      double d_sq = region_geom_segment_dist_sq(
+          (double)x, (double)y, (double)region_table[i].vertices[v].x,
+          (double)region_table[i].vertices[v].y, (double)region_table[i].vertices[next_v].x,
+          (double)region_table[i].vertices[next_v].y);
+      if (d_sq < min_edge_dist_sq)
+        min_edge_dist_sq = d_sq;
     }
 
-    if ((current_y > y) != (previous_y > y))
-    {
-      intersection_x = ((double)previous_x - current_x) * ((double)y - current_y) /
-                           ((double)previous_y - current_y) +
-                       current_x;
-      if ((double)x < intersection_x)
-      {
-        inside = !inside;
-      }
-    }
-    previous = current;
+    dist_centroid =
+        sqrt(((double)x - cx) * ((double)x - cx) + ((double)y - cy) * ((double)y - cy));
+    if (sqrt(min_edge_dist_sq) > dist_centroid / 2.0)
+      pos = REGION_POS_INSIDE;
+    else
+      pos = REGION_POS_EDGE;
   }
 
-  return inside;
+  CREATE(new_node, struct region_list, 1);
+  new_node->rnum = i;
+  new_node->pos = pos;
+  new_node->next = *regions;
+  *regions = new_node;
 }
 
+/* The list comes back in descending rnum order, whether the region grid
+ * supplied the candidates or the whole table was scanned. */
 struct region_list *get_enclosing_regions(zone_rnum zone, int x, int y)
 {
   struct region_list *regions = NULL;
-  struct region_list *new_node = NULL;
-  int i, v;
+  const int *candidates = NULL;
+  int i, count;
 
   if (region_table == NULL || top_of_region_table == NOWHERE)
     return NULL;
 
-  for (i = 0; i <= (int)top_of_region_table; i++)
+  if ((count = region_grid_region_candidates(x, y, &candidates)) >= 0)
   {
-    if (region_table[i].zone != zone || region_table[i].vertices == NULL ||
-        region_table[i].num_vertices < 3)
-      continue;
-
-    if (mysql_point_in_polygon(region_table[i].vertices, region_table[i].num_vertices, x, y))
-    {
-      double cx, cy;
-      double dist_centroid, min_edge_dist_sq;
-      int pos = REGION_POS_INSIDE;
-
-      mysql_polygon_centroid(region_table[i].vertices, region_table[i].num_vertices, &cx, &cy);
-
-      if (fabs((double)x - cx) < 1.0e-9 && fabs((double)y - cy) < 1.0e-9)
-      {
-        pos = REGION_POS_CENTER;
-      }
-      else
-      {
-        min_edge_dist_sq = 1e30;
-        for (v = 0; v < region_table[i].num_vertices; v++)
-        {
-          int next_v = (v + 1) % region_table[i].num_vertices;
-          double d_sq = mysql_point_to_segment_dist_sq(
-              (double)x, (double)y, (double)region_table[i].vertices[v].x,
-              (double)region_table[i].vertices[v].y, (double)region_table[i].vertices[next_v].x,
-              (double)region_table[i].vertices[next_v].y);
-          if (d_sq < min_edge_dist_sq)
-            min_edge_dist_sq = d_sq;
-        }
-
-        dist_centroid =
-            sqrt(((double)x - cx) * ((double)x - cx) + ((double)y - cy) * ((double)y - cy));
-        if (sqrt(min_edge_dist_sq) > dist_centroid / 2.0)
-          pos = REGION_POS_INSIDE;
-        else
-          pos = REGION_POS_EDGE;
-      }
-
-      CREATE(new_node, struct region_list, 1);
-      new_node->rnum = i;
-      new_node->pos = pos;
-      new_node->next = regions;
-      regions = new_node;
-      new_node = NULL;
-    }
+    for (i = 0; i < count; i++)
+      mysql_add_enclosing_region(&regions, zone, candidates[i], x, y);
+    return regions;
   }
 
+  for (i = 0; i <= (int)top_of_region_table; i++)
+    mysql_add_enclosing_region(&regions, zone, i, x, y);
+
   return regions;
 }
 
@@ -2650,171 +2563,122 @@ void free_path_list(struct path_list *paths)
   }
 }
 
-#define ROUND(num) (num < 0 ? num - 0.5 : num + 0.5)
+/* The eight directional sector rectangles around (x, y) out to r tiles, in
+ * the order of region_proximity_list.dirs[]: n, ne, e, se, s, sw, w, nw.
+ * Each row is {x1, y1, x2, y2}. */
+static void nearby_region_sectors(int x, int y, int r, int sectors[8][4])
+{
+  const int rects[8][4] = {{x - 1, y + 1, x + 1, y + r}, {x + 1, y + 1, x + r, y + r},
+                           {x + 1, y - 1, x + r, y + 1}, {x + 1, y - r, x + r, y - 1},
+                           {x - 1, y - r, x + 1, y - 1}, {x - r, y - r, x - 1, y - 1},
+                           {x - r, y - 1, x - 1, y + 1}, {x - r, y + 1, x - 1, y + r}};
 
-/* Move this out to another file... */
-struct region_proximity_list *get_nearby_regions(zone_rnum zone, int x, int y, int r)
+  memcpy(sectors, rects, sizeof(rects));
+}
+
+/* Nearest first, rnum breaking ties so the list order is deterministic. */
+static int nearby_region_compare(const void *a, const void *b)
 {
-  MYSQL_RES *result;
-  MYSQL_ROW row;
+  const struct region_proximity_list *ra = *(const struct region_proximity_list *const *)a;
+  const struct region_proximity_list *rb = *(const struct region_proximity_list *const *)b;
 
-  struct region_proximity_list *regions = NULL;
-  struct region_proximity_list *new_node = NULL;
-
-  int i = 0;
-  char buf[8192]; /* Increased buffer size for large query */
-
-  /* Polygon-based approach: Check which directional sectors each region intersects */
-  /* Uses simpler logic to avoid geometry type issues */
-  /* Use non-overlapping rectangular sectors to avoid invalid geometry issues */
-  snprintf(
-      buf, sizeof(buf),
-      "SELECT ri.vnum, "
-      "       rd.name, "
-      "       CASE "
-      "         WHEN ST_Within(ST_GeomFromText('POINT(%d %d)'), ri.region_polygon) THEN 'INSIDE' "
-      "         WHEN ST_Distance(ri.region_polygon, ST_GeomFromText('POINT(%d %d)')) = 0 THEN "
-      "'EDGE' "
-      "         ELSE 'NEARBY' "
-      "       END AS position, "
-      "       ST_Distance(ri.region_polygon, ST_GeomFromText('POINT(%d %d)')) AS distance, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS n, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS ne, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS e, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS se, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS s, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS sw, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS w, "
-      "       CASE WHEN ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, "
-      "%d %d, %d %d, %d %d))')) THEN 1 ELSE 0 END AS nw "
-      "FROM region_index ri "
-      "JOIN region_data rd ON ri.vnum = rd.vnum "
-      "WHERE rd.region_type = 1 "
-      "  AND (ST_Within(ST_GeomFromText('POINT(%d %d)'), ri.region_polygon) "
-      "       OR ST_Distance(ri.region_polygon, ST_GeomFromText('POINT(%d %d)')) <= %d) "
-      "ORDER BY distance ASC",
-      x, y, x, y, x, y,
-      /* N: Rectangle directly north */
-      x - 1, y + 1, x + 1, y + 1, x + 1, y + r, x - 1, y + r, x - 1, y + 1,
-      /* NE: Rectangle northeast */
-      x + 1, y + 1, x + r, y + 1, x + r, y + r, x + 1, y + r, x + 1, y + 1,
-      /* E: Rectangle directly east */
-      x + 1, y - 1, x + r, y - 1, x + r, y + 1, x + 1, y + 1, x + 1, y - 1,
-      /* SE: Rectangle southeast */
-      x + 1, y - r, x + r, y - r, x + r, y - 1, x + 1, y - 1, x + 1, y - r,
-      /* S: Rectangle directly south */
-      x - 1, y - r, x + 1, y - r, x + 1, y - 1, x - 1, y - 1, x - 1, y - r,
-      /* SW: Rectangle southwest */
-      x - r, y - r, x - 1, y - r, x - 1, y - 1, x - r, y - 1, x - r, y - r,
-      /* W: Rectangle directly west */
-      x - r, y - 1, x - 1, y - 1, x - 1, y + 1, x - r, y + 1, x - r, y - 1,
-      /* NW: Rectangle northwest */
-      x - r, y + 1, x - 1, y + 1, x - 1, y + r, x - r, y + r, x - r, y + 1,
-      /* WHERE clause coordinates */
-      x, y, x, y, r);
+  if (ra->dist != rb->dist)
+    return ra->dist < rb->dist ? -1 : 1;
+  return (ra->rnum > rb->rnum) - (ra->rnum < rb->rnum);
+}
 
-  /* Check the connection, reconnect if necessary. */
-  if (!MYSQL_PING_CONN(conn))
-  {
-    log("SYSERR: %s: Database connection failed", __func__);
+/* Geographic regions containing (x, y) or within r tiles of it, with the
+ * directional sectors (see nearby_region_sectors()) each one reaches into.
+ * Evaluated natively against region_table, so describing a room never
+ * touches the database. As with the old region_index query, regions from
+ * every zone are considered; zone is kept for the callers' signature.
+ *
+ * The returned list runs farthest first, as desc_engine.c expects. */
+struct region_proximity_list *get_nearby_regions(zone_rnum zone, int x, int y, int r)
+{
+  struct region_proximity_list *regions = NULL, *new_node = NULL;
+  struct region_proximity_list **found = NULL;
+  const struct region_grid_bounds *bounds;
+  const struct vertex *vertices;
+  int sectors[8][4];
+  int i, d, count = 0, num_vertices;
+  double dist, strength;
+  bool within;
+
+  if (region_table == NULL || top_of_region_table == NOWHERE || (int)top_of_region_table < 0)
     return NULL;
-  }
 
-  if (mysql_query(conn, buf))
-  {
-    log("SYSERR: Unable to SELECT from region_index: %s", mysql_error(conn));
-    log("SYSERR: get_nearby_regions failed for zone %d, coords (%d,%d)", zone, x, y);
-    return NULL; /* Return empty region list on error */
-  }
+  nearby_region_sectors(x, y, r, sectors);
 
-  if (!(result = mysql_store_result(conn)))
+  for (i = 0; i <= (int)top_of_region_table; i++)
   {
-    log("SYSERR: Unable to SELECT from region_index: %s", mysql_error(conn));
-    log("SYSERR: get_nearby_regions failed to store result for zone %d, coords (%d,%d)", zone, x,
-        y);
-    return NULL; /* Return empty region list on error */
-  }
+    if (region_table[i].region_type != REGION_GEOGRAPHIC)
+      continue;
+    vertices = region_table[i].vertices;
+    num_vertices = region_table[i].num_vertices;
+    if (vertices == NULL || num_vertices < 3)
+      continue;
 
-  while ((row = mysql_fetch_row(result)))
-  {
-    region_rnum rnum = real_region(atoi(row[0]));
+    /* Cheap reject on the cached bounding box before walking the edges. */
+    if ((bounds = region_grid_region_bounds(i)) != NULL &&
+        ((long)x < (long)bounds->min_x - r || (long)x > (long)bounds->max_x + r ||
+         (long)y < (long)bounds->min_y - r || (long)y > (long)bounds->max_y + r))
+      continue;
 
-    /* Skip regions that don't exist in the region table */
-    if (rnum == NOWHERE)
-    {
-      log("SYSERR: Region vnum %d from database not found in region table", atoi(row[0]));
+    within = region_geom_point_within(vertices, num_vertices, x, y);
+    dist = within ? 0.0 : region_geom_point_distance(vertices, num_vertices, x, y);
+    if (!within && dist > r)
       continue;
-    }
 
-    /* Allocate memory for the region data. */
     CREATE(new_node, struct region_proximity_list, 1);
-    new_node->rnum = rnum;
-    new_node->dist = atof(row[3]); /* Distance from query */
-
-    /* Check position - inside, edge, or nearby the region */
-    bool is_inside = (strcmp(row[2], "INSIDE") == 0);
-    bool is_edge = (strcmp(row[2], "EDGE") == 0);
-    new_node->is_inside = is_inside || is_edge; /* Treat edge as "inside" for positioning */
+    new_node->rnum = i;
+    new_node->dist = dist;
 
-    /* Set the position constant for room descriptions */
-    if (is_inside)
-    {
+    /* Edge counts as "inside" for positioning. */
+    new_node->is_inside = within || dist == 0.0;
+    if (within)
       new_node->pos = REGION_POS_INSIDE;
-    }
-    else if (is_edge)
-    {
+    else if (dist == 0.0)
       new_node->pos = REGION_POS_EDGE;
-    }
     else
-    {
       new_node->pos = REGION_POS_UNDEFINED; /* This is for nearby regions */
-    }
 
-    if (is_inside || is_edge)
+    if (new_node->is_inside)
     {
       /* When inside or on edge of a region, set all directions to indicate we're surrounded */
-      for (i = 0; i < 8; i++)
-      {
-        new_node->dirs[i] = 100.0; /* Maximum strength for all directions */
-      }
+      for (d = 0; d < 8; d++)
+        new_node->dirs[d] = 100.0;
     }
     else
     {
-      /* Process the directional flags from the query (rows 4-11: n, ne, e, se, s, sw, w, nw) */
-      for (i = 0; i < 8; i++)
-      {
-        int intersects = atoi(row[i + 4]); /* 1 if region intersects this direction, 0 if not */
-        if (intersects)
-        {
-          /* Use inverse distance as strength - closer regions have higher influence */
-          double strength = (new_node->dist > 0) ? (100.0 / (1.0 + new_node->dist)) : 100.0;
-          new_node->dirs[i] = strength;
-        }
-        else
-        {
-          new_node->dirs[i] = 0.0;
-        }
-      }
+      /* Use inverse distance as strength - closer regions have higher influence */
+      strength = 100.0 / (1.0 + dist);
+      for (d = 0; d < 8; d++)
+        if (region_geom_intersects_rect(vertices, num_vertices, sectors[d][0], sectors[d][1],
+                                        sectors[d][2], sectors[d][3]))
+          new_node->dirs[d] = strength;
     }
 
-    new_node->next = regions;
-    regions = new_node;
+    RECREATE(found, struct region_proximity_list *, count + 1);
+    found[count++] = new_node;
     new_node = NULL;
   }
-  mysql_free_result(result);
 
+  if (count == 0)
+    return NULL;
+
+  qsort(found, count, sizeof(*found), nearby_region_compare);
+  for (i = 0; i < count; i++)
+  {
+    found[i]->next = regions;
+    regions = found[i];
+  }
+  free(found);
+
+  (void)zone;
   return regions;
 }
 
-#undef ROUND
-
 void save_regions()
 {
 }
@@ -2950,6 +2814,8 @@ void load_paths()
     i++;
   }
   mysql_free_result(result);
+
+  region_grid_build_paths();
 }
 
 /* Insert a path into the database. */
@@ -3108,44 +2974,57 @@ static bool mysql_point_on_path(const struct path_data *path, int px, int py)
   return FALSE;
 }
 
+/* Test path i against (x, y) and prepend a node to *paths if it runs
+ * through the point. */
+static void mysql_add_enclosing_path(struct path_list **paths, zone_rnum zone, int i, int x, int y)
+{
+  struct path_list *new_node = NULL;
+  int glyph = GLYPH_TYPE_PATH_INT;
+
+  if (path_table[i].zone != zone || path_table[i].vertices == NULL ||
+      path_table[i].num_vertices < 2)
+    return;
+
+  if (!mysql_point_on_path(&path_table[i], x, y))
+    return;
+
+  if (mysql_point_on_path(&path_table[i], x, y - 1) &&
+      mysql_point_on_path(&path_table[i], x, y + 1))
+  {
+    glyph = GLYPH_TYPE_PATH_NS;
+  }
+  else if (mysql_point_on_path(&path_table[i], x - 1, y) &&
+           mysql_point_on_path(&path_table[i], x + 1, y))
+  {
+    glyph = GLYPH_TYPE_PATH_EW;
+  }
+
+  CREATE(new_node, struct path_list, 1);
+  new_node->rnum = i;
+  new_node->glyph_type = glyph;
+  new_node->next = *paths;
+  *paths = new_node;
+}
+
 struct path_list *get_enclosing_paths(zone_rnum zone, int x, int y)
 {
   struct path_list *paths = NULL;
-  struct path_list *new_node = NULL;
-  int i;
+  const int *candidates = NULL;
+  int i, count;
 
   if (path_table == NULL || top_of_path_table == NOWHERE)
     return NULL;
 
-  for (i = 0; i <= (int)top_of_path_table; i++)
+  if ((count = region_grid_path_candidates(x, y, &candidates)) >= 0)
   {
-    if (path_table[i].zone != zone || path_table[i].vertices == NULL ||
-        path_table[i].num_vertices < 2)
-      continue;
-
-    if (mysql_point_on_path(&path_table[i], x, y))
-    {
-      int glyph = GLYPH_TYPE_PATH_INT;
-      if (mysql_point_on_path(&path_table[i], x, y - 1) &&
-          mysql_point_on_path(&path_table[i], x, y + 1))
-      {
-        glyph = GLYPH_TYPE_PATH_NS;
-      }
-      else if (mysql_point_on_path(&path_table[i], x - 1, y) &&
-               mysql_point_on_path(&path_table[i], x + 1, y))
-      {
-        glyph = GLYPH_TYPE_PATH_EW;
-      }
-
-      CREATE(new_node, struct path_list, 1);
-      new_node->rnum = i;
-      new_node->glyph_type = glyph;
-      new_node->next = paths;
-      paths = new_node;
-      new_node = NULL;
-    }
+    for (i = 0; i < count; i++)
+      mysql_add_enclosing_path(&paths, zone, candidates[i], x, y);
+    return paths;
   }
 
+  for (i = 0; i <= (int)top_of_path_table; i++)
+    mysql_add_enclosing_path(&paths, zone, i, x, y);
+
   return paths;
 }
 
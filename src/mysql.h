@@ -104,6 +104,9 @@ void mysql_query_counter_reset(void);
 #ifdef LUMINARI_CUTEST
 void mysql_test_fail_nth_query(unsigned int query_number);
 void mysql_test_clear_query_failure(void);
+/* Report success for every query without sending it, appending each one and
+ * a newline to transcript (which may be NULL) until called with false. */
+void mysql_test_accept_queries(bool accept, char *transcript, size_t size);
 #endif
 
 /* Count direct mysql_query() calls without changing their return semantics.
@@ -214,6 +217,7 @@ struct path_list *get_enclosing_paths(zone_rnum zone, int x, int y);
 void free_path_list(struct path_list *paths);
 void cleanup_region_path_tables(void);
 bool get_random_region_location(region_vnum region, int *x, int *y);
+bool is_point_within_region(region_vnum region, int x, int y);
 struct region_proximity_list *get_nearby_regions(zone_rnum zone, int x, int y, int r);
 char **tokenize(const char *input, const char *delim);
 void free_tokens(char **tokens);
@@ -0,0 +1,314 @@
+/**
+ * @file mccp.c
+ * @brief MCCP2 and MCCP3 stream compression for descriptors
+ *
+ * See mccp.h.  An output stream keeps the bytes the socket has not taken
+ * yet in front of anything written later, so the MCCP2 start sequence,
+ * the compressed text and the end of the stream always reach the client
+ * in order, however the kernel splits the writes.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#ifdef HAVE_ZLIB
+
+#include <arpa/telnet.h>
+#include <poll.h>
+#include <zlib.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "perfmon.h"
+#include "protocol.h"
+#include "mccp.h"
+
+/* zlib's default level: higher ones cost a good deal more CPU per player
+ * for a few percent on text like ours. */
+#define MCCP_LEVEL 6
+#define MCCP_CHUNK 4096
+
+struct mccp_stream
+{
+  z_stream z;
+  bool output;   /* Deflating what we send rather than inflating input */
+  bool finished; /* Output stream ended; what follows goes out plain */
+  /* Bytes for the socket, oldest first, from pending + pending_start */
+  char *pending;
+  size_t pending_start, pending_length, pending_size;
+};
+
+static struct mccp_stream *mccp_stream_new(bool output)
+{
+  struct mccp_stream *s;
+  int result;
+
+  CREATE(s, struct mccp_stream, 1);
+  s->output = output;
+  result = output ? deflateInit(&s->z, MCCP_LEVEL) : inflateInit(&s->z);
+  if (result != Z_OK)
+  {
+    log("SYSERR: MCCP: could not start %s stream: %s", output ? "an output" : "an input",
+        s->z.msg ? s->z.msg : zError(result));
+    free(s);
+    return NULL;
+  }
+  return s;
+}
+
+static void mccp_stream_free(struct mccp_stream *s)
+{
+  if (s == NULL)
+    return;
+  if (s->output)
+    deflateEnd(&s->z);
+  else
+    inflateEnd(&s->z);
+  free(s->pending);
+  free(s);
+}
+
+/* Make room for extra more pending bytes, unsent ones moved to the front. */
+static void mccp_reserve(struct mccp_stream *s, size_t extra)
+{
+  if (s->pending_start)
+  {
+    memmove(s->pending, s->pending + s->pending_start, s->pending_length);
+    s->pending_start = 0;
+  }
+  if (s->pending_length + extra > s->pending_size)
+  {
+    s->pending_size = MAX(s->pending_size * 2, s->pending_length + extra);
+    RECREATE(s->pending, char, s->pending_size);
+  }
+}
+
+static void mccp_queue_plain(struct mccp_stream *s, const char *data, size_t length)
+{
+  mccp_reserve(s, length);
+  memcpy(s->pending + s->pending_length, data, length);
+  s->pending_length += length;
+}
+
+/* Deflate length bytes of txt onto the pending bytes, then flush. */
+static bool mccp_deflate(struct mccp_stream *s, const char *txt, size_t length, int flush)
+{
+  size_t before = s->pending_length;
+  int result;
+
+  s->z.next_in = (Bytef *)txt;
+  s->z.avail_in = (uInt)length;
+  do
+  {
+    mccp_reserve(s, MCCP_CHUNK);
+    s->z.next_out = (Bytef *)s->pending + s->pending_length;
+    s->z.avail_out = (uInt)(s->pending_size - s->pending_length);
+    result = deflate(&s->z, flush);
+    s->pending_length = s->pending_size - s->z.avail_out;
+    if (result == Z_STREAM_ERROR)
+    {
+      log("SYSERR: MCCP: deflate failed: %s", s->z.msg ? s->z.msg : zError(result));
+      return FALSE;
+    }
+  } while (flush == Z_FINISH ? result != Z_STREAM_END
+                             : (s->z.avail_in > 0 || s->z.avail_out == 0));
+
+  PERF_note_mccp_output(length, s->pending_length - before);
+  return TRUE;
+}
+
+int mccp_send_pending(socket_t desc, struct mccp_stream *s)
+{
+  ssize_t written;
+
+  while (s->pending_length > 0)
+  {
+    written = perform_socket_write(desc, s->pending + s->pending_start, s->pending_length);
+    if (written < 0)
+    {
+      perror("SYSERR: Write to compressed socket");
+      return -1;
+    }
+    if (written == 0)
+      break;
+    s->pending_start += (size_t)written;
+    s->pending_length -= (size_t)written;
+  }
+  if (s->pending_length == 0)
+    s->pending_start = 0;
+  return (int)MIN(s->pending_length, (size_t)INT_MAX);
+}
+
+bool mccp_pending(const struct mccp_stream *s)
+{
+  return s != NULL && s->pending_length > 0;
+}
+
+int mccp_writev(socket_t desc, struct mccp_stream *s, const struct iovec *iov, int count)
+{
+  size_t length = 0;
+  int left, i;
+
+  /* Older bytes go first; until they have, the socket counts as full. */
+  if ((left = mccp_send_pending(desc, s)) != 0)
+    return left < 0 ? -1 : 0;
+  for (i = 0; i < count; i++)
+    length += iov[i].iov_len;
+  if (length == 0)
+    return 0;
+
+  /* One flush, after the last segment, so they go out as a single block. */
+  for (i = 0; i < count; i++)
+  {
+    if (s->finished)
+      mccp_queue_plain(s, iov[i].iov_base, iov[i].iov_len);
+    else if (!mccp_deflate(s, iov[i].iov_base, iov[i].iov_len,
+                           i == count - 1 ? Z_SYNC_FLUSH : Z_NO_FLUSH))
+      return -1;
+  }
+
+  if (mccp_send_pending(desc, s) < 0)
+    return -1;
+  return (int)MIN(length, (size_t)INT_MAX);
+}
+
+int mccp_write(socket_t desc, struct mccp_stream *s, const char *txt, size_t length)
+{
+  struct iovec segment;
+
+  segment.iov_base = (void *)txt;
+  segment.iov_len = length;
+  return mccp_writev(desc, s, &segment, 1);
+}
+
+bool mccp_start(struct descriptor_data *d)
+{
+  static const char start[] = {(char)IAC, (char)SB, TELOPT_MCCP, (char)IAC, (char)SE};
+  struct mccp_stream *s = d->mccp;
+
+  if (s != NULL && !s->finished)
+    return TRUE;
+
+  /* A stream still sending its end is restarted behind what it holds. */
+  if (s != NULL)
+  {
+    if (deflateReset(&s->z) != Z_OK)
+      return FALSE;
+    s->finished = FALSE;
+  }
+  else if ((s = mccp_stream_new(TRUE)) == NULL)
+    return FALSE;
+
+  mccp_queue_plain(s, start, sizeof(start));
+  d->mccp = s;
+  /* A dead socket shows up on the next write */
+  if (mccp_send_pending(d->descriptor, s) != 0)
+    mark_output_pending(d);
+  return TRUE;
+}
+
+void mccp_end(struct descriptor_data *d)
+{
+  struct mccp_stream *s = d->mccp;
+
+  if (s == NULL || s->finished)
+    return;
+
+  if (!mccp_deflate(s, NULL, 0, Z_FINISH) || mccp_send_pending(d->descriptor, s) <= 0)
+  {
+    mccp_stream_free(s);
+    d->mccp = NULL;
+    return;
+  }
+  /* The socket is full: send the rest of the stream, then plain text, from
+   * the game loop. */
+  s->finished = TRUE;
+  mark_output_pending(d);
+}
+
+int mccp_flush(struct descriptor_data *d)
+{
+  if (d->mccp == NULL)
+    return 0;
+  if (mccp_send_pending(d->descriptor, d->mccp) < 0)
+    return -1;
+  if (d->mccp->finished && d->mccp->pending_length == 0)
+  {
+    mccp_stream_free(d->mccp);
+    d->mccp = NULL;
+  }
+  return 0;
+}
+
+bool mccp_finish(struct descriptor_data *d, int timeout_ms)
+{
+  struct pollfd wait;
+  uint64_t now, deadline = PERF_monotonic_usec() + (uint64_t)timeout_ms * 1000;
+
+  while (d->mccp != NULL && mccp_pending(d->mccp))
+  {
+    if (mccp_flush(d) < 0)
+      return FALSE;
+    if (d->mccp == NULL || !mccp_pending(d->mccp))
+      break;
+    if ((now = PERF_monotonic_usec()) >= deadline)
+    {
+      log("SYSERR: MCCP: gave up on %lu compressed bytes for descriptor %d",
+          (unsigned long)d->mccp->pending_length, d->descriptor);
+      return FALSE;
+    }
+    wait.fd = d->descriptor;
+    wait.events = POLLOUT;
+    wait.revents = 0;
+    if (poll(&wait, 1, (int)((deadline - now + 999) / 1000)) < 0 && errno != EINTR)
+      return FALSE;
+  }
+  return mccp_flush(d) == 0;
+}
+
+bool mccp_input_start(struct descriptor_data *d)
+{
+  if (d->mccp_in == NULL)
+    d->mccp_in = mccp_stream_new(FALSE);
+  return d->mccp_in != NULL;
+}
+
+void mccp_input_end(struct descriptor_data *d)
+{
+  mccp_stream_free(d->mccp_in);
+  d->mccp_in = NULL;
+}
+
+ssize_t mccp_inflate(struct mccp_stream *s, const char *in, size_t length, size_t *used,
+                     char *out, size_t size, bool *ended)
+{
+  int result;
+
+  s->z.next_in = (Bytef *)in;
+  s->z.avail_in = (uInt)length;
+  s->z.next_out = (Bytef *)out;
+  s->z.avail_out = (uInt)size;
+  result = inflate(&s->z, Z_SYNC_FLUSH);
+  *used = length - s->z.avail_in;
+  *ended = result == Z_STREAM_END;
+  if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+  {
+    log("SYSERR: MCCP: client sent a corrupt stream: %s", s->z.msg ? s->z.msg : zError(result));
+    return -1;
+  }
+  return (ssize_t)(size - s->z.avail_out);
+}
+
+void mccp_free(struct descriptor_data *d)
+{
+  mccp_stream_free(d->mccp);
+  mccp_stream_free(d->mccp_in);
+  d->mccp = NULL;
+  d->mccp_in = NULL;
+}
+
+#endif /* HAVE_ZLIB */
@@ -0,0 +1,80 @@
+/**
+ * @file mccp.h
+ * @brief MCCP2 and MCCP3 stream compression for descriptors
+ *
+ * MCCP2 (telnet option 86) compresses what the server sends and MCCP3
+ * (option 87) what the client sends.  Each is one zlib stream per
+ * descriptor, started and ended by the telnet option handling in
+ * protocol.c.
+ *
+ * Output is deflated by write_to_descriptor() and sync-flushed once per
+ * call, after the last of the segments it was given, so process_output()
+ * sends a pulse of text and its prompt as a single block.
+ * Compressed bytes the socket will not take yet stay with the stream and
+ * are sent first on the next pulse; until then write_to_descriptor()
+ * reports the socket as full, so process_output() keeps the text queued.
+ *
+ * Without zlib (HAVE_ZLIB unset) USING_MCCP is left off, the options are
+ * never offered, and none of this is called.
+ */
+
+#ifndef LUMINARI_MCCP_H
+#define LUMINARI_MCCP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+struct descriptor_data;
+struct mccp_stream;
+struct iovec;
+
+/** @brief Announce MCCP2 on d and compress everything it is sent after. */
+bool mccp_start(struct descriptor_data *d);
+/** @brief Finish d's output stream, send what is left of it and drop it. */
+void mccp_end(struct descriptor_data *d);
+
+/**
+ * @brief Compress length bytes of txt onto s and send what the socket takes
+ *
+ * @return length once the text is in the stream, 0 if earlier output is
+ *         still waiting for the socket, -1 on a fatal error
+ */
+int mccp_write(socket_t desc, struct mccp_stream *s, const char *txt, size_t length);
+/** @brief As mccp_write(), for count segments flushed together. */
+int mccp_writev(socket_t desc, struct mccp_stream *s, const struct iovec *iov, int count);
+/** @brief Send what s still holds; -1 on a fatal error, else bytes left. */
+int mccp_send_pending(socket_t desc, struct mccp_stream *s);
+/** @brief Whether s holds compressed bytes the socket has not taken. */
+bool mccp_pending(const struct mccp_stream *s);
+/** @brief Send what d's output stream holds, dropping it once it has ended. */
+int mccp_flush(struct descriptor_data *d);
+/**
+ * @brief Send all d's output stream holds, blocking up to timeout_ms for it
+ *
+ * For a copyover, whose exec would cut off the end of the stream that the
+ * game loop would otherwise send once the socket drains.
+ *
+ * @return TRUE once nothing is left to send
+ */
+bool mccp_finish(struct descriptor_data *d, int timeout_ms);
+
+/** @brief Inflate what d sends from here on (after IAC SB MCCP3 IAC SE). */
+bool mccp_input_start(struct descriptor_data *d);
+void mccp_input_end(struct descriptor_data *d);
+
+/**
+ * @brief Inflate client bytes into out
+ *
+ * Consumes what it can of in, reporting how much in used.  Sets ended when
+ * the client has closed its stream; the bytes after that are plain again.
+ *
+ * @return Bytes written to out, or -1 if the stream is corrupt
+ */
+ssize_t mccp_inflate(struct mccp_stream *s, const char *in, size_t length, size_t *used,
+                     char *out, size_t size, bool *ended);
+
+/** @brief Drop both of d's streams without sending anything; close_socket(). */
+void mccp_free(struct descriptor_data *d);
+
+#endif /* LUMINARI_MCCP_H */
@@ -0,0 +1,414 @@
+/**
+ * @file netpoll.c
+ * @brief Socket readiness polling for the game loop
+ *
+ * See netpoll.h.  Registered sockets are kept in a table indexed by fd,
+ * which remembers what each is watched for and where the last wait reported
+ * it, so removing a socket mid-pulse also drops its pending event.  The
+ * select() backend keeps a dense list of the registered fds to build its
+ * sets from.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "perfmon.h"
+#include "netpoll.h"
+
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+
+struct netpoll_entry
+{
+  bool registered;
+  void *owner;
+  int watch;  /* NETPOLL_* flags asked for */
+  int ready;  /* Flags from the last wait */
+  int event;  /* Index of that event */
+  int listed; /* Index in the dense fd list */
+};
+
+static enum netpoll_backend backend = NETPOLL_AUTO; /* AUTO: not started */
+static struct netpoll_entry *entries;
+static int entries_size;
+static socket_t *listed_fds;
+static int listed_count, listed_size;
+static struct netpoll_event *events;
+static int event_count, events_size;
+#ifdef HAVE_SYS_EPOLL_H
+static int epoll_fd = -1;
+static struct epoll_event *epoll_events;
+#endif
+
+static struct netpoll_entry *netpoll_entry(socket_t fd)
+{
+  if (fd < 0 || fd >= entries_size || !entries[fd].registered)
+    return NULL;
+  return &entries[fd];
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static uint32_t netpoll_epoll_flags(int watch)
+{
+  return EPOLLIN | EPOLLPRI | EPOLLRDHUP | (watch & NETPOLL_WRITE ? EPOLLOUT : 0);
+}
+#endif
+
+bool netpoll_init(enum netpoll_backend wanted)
+{
+  netpoll_shutdown();
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (wanted != NETPOLL_SELECT)
+  {
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) >= 0)
+    {
+      backend = NETPOLL_EPOLL;
+      return TRUE;
+    }
+    perror("SYSERR: epoll_create1");
+    if (wanted == NETPOLL_EPOLL)
+      return FALSE;
+  }
+#else
+  if (wanted == NETPOLL_EPOLL)
+    return FALSE;
+#endif
+
+  backend = NETPOLL_SELECT;
+  return TRUE;
+}
+
+void netpoll_shutdown(void)
+{
+#ifdef HAVE_SYS_EPOLL_H
+  if (epoll_fd >= 0)
+    close(epoll_fd);
+  epoll_fd = -1;
+  free(epoll_events);
+  epoll_events = NULL;
+#endif
+  free(entries);
+  free(listed_fds);
+  free(events);
+  entries = NULL;
+  listed_fds = NULL;
+  events = NULL;
+  entries_size = listed_count = listed_size = event_count = events_size = 0;
+  backend = NETPOLL_AUTO;
+}
+
+const char *netpoll_backend_name(void)
+{
+  switch (backend)
+  {
+  case NETPOLL_EPOLL:
+    return "epoll";
+  case NETPOLL_SELECT:
+    return "select";
+  default:
+    return "none";
+  }
+}
+
+bool netpoll_has_room(socket_t fd)
+{
+  if (fd < 0 || backend == NETPOLL_AUTO)
+    return FALSE;
+  return backend != NETPOLL_SELECT || fd < FD_SETSIZE;
+}
+
+bool netpoll_add(socket_t fd, void *owner)
+{
+  struct netpoll_entry *e;
+  int size;
+
+  if (!netpoll_has_room(fd))
+  {
+    log("SYSERR: netpoll: cannot watch fd %d with %s", fd, netpoll_backend_name());
+    return FALSE;
+  }
+  if ((e = netpoll_entry(fd)) != NULL)
+  {
+    /* Registered already, so it was closed without being removed and the
+     * fd has been reused: start over. */
+    netpoll_remove(fd);
+  }
+
+  if (fd >= entries_size)
+  {
+    size = MAX(fd + 1, MAX(64, entries_size * 2));
+    RECREATE(entries, struct netpoll_entry, size);
+    memset(entries + entries_size, 0, sizeof(*entries) * (size - entries_size));
+    entries_size = size;
+  }
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (backend == NETPOLL_EPOLL)
+  {
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = netpoll_epoll_flags(NETPOLL_READ);
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      perror("SYSERR: epoll_ctl add");
+      return FALSE;
+    }
+  }
+#endif
+
+  if (listed_count == listed_size)
+  {
+    listed_size = MAX(64, listed_size * 2);
+    RECREATE(listed_fds, socket_t, listed_size);
+  }
+
+  e = &entries[fd];
+  memset(e, 0, sizeof(*e));
+  e->registered = TRUE;
+  e->owner = owner;
+  e->watch = NETPOLL_READ | NETPOLL_ERROR;
+  e->listed = listed_count;
+  listed_fds[listed_count++] = fd;
+  return TRUE;
+}
+
+void netpoll_remove(socket_t fd)
+{
+  struct netpoll_entry *e = netpoll_entry(fd);
+  socket_t last;
+
+  if (e == NULL)
+    return;
+
+#ifdef HAVE_SYS_EPOLL_H
+  /* A socket another process still holds stays in the set after close(), so
+   * it is taken out here, before the caller closes it.  A socket closed
+   * already has left the set by itself. */
+  if (backend == NETPOLL_EPOLL && epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL) < 0 &&
+      errno != EBADF && errno != ENOENT)
+    perror("SYSERR: epoll_ctl del");
+#endif
+
+  if (e->ready)
+    events[e->event].ready = 0;
+
+  last = listed_fds[--listed_count];
+  listed_fds[e->listed] = last;
+  entries[last].listed = e->listed;
+
+  memset(e, 0, sizeof(*e));
+}
+
+void netpoll_want_write(socket_t fd, bool want)
+{
+  struct netpoll_entry *e = netpoll_entry(fd);
+  int watch;
+
+  if (e == NULL)
+    return;
+  watch = want ? (e->watch | NETPOLL_WRITE) : (e->watch & ~NETPOLL_WRITE);
+  if (watch == e->watch)
+    return;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (backend == NETPOLL_EPOLL)
+  {
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = netpoll_epoll_flags(watch);
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0)
+    {
+      perror("SYSERR: epoll_ctl mod");
+      return;
+    }
+  }
+#endif
+  e->watch = watch;
+}
+
+bool netpoll_waiting_write(socket_t fd)
+{
+  struct netpoll_entry *e = netpoll_entry(fd);
+
+  return e != NULL && (e->watch & NETPOLL_WRITE);
+}
+
+void netpoll_follow(socket_t *watched, socket_t current)
+{
+  struct netpoll_entry *e;
+
+  if (*watched == current)
+    return;
+  if ((e = netpoll_entry(*watched)) != NULL && e->owner == NULL)
+    netpoll_remove(*watched);
+  *watched = INVALID_SOCKET;
+  if (current != INVALID_SOCKET && netpoll_add(current, NULL))
+    *watched = current;
+}
+
+/* Record that fd is ready with flags, one event per fd. */
+static void netpoll_report(socket_t fd, int flags)
+{
+  struct netpoll_entry *e = netpoll_entry(fd);
+
+  if (e == NULL || !(flags &= e->watch))
+    return;
+  if (event_count == events_size)
+  {
+    events_size = MAX(64, events_size * 2);
+    RECREATE(events, struct netpoll_event, events_size);
+  }
+  e->ready = flags;
+  e->event = event_count;
+  events[event_count].fd = fd;
+  events[event_count].owner = e->owner;
+  events[event_count].ready = flags;
+  event_count++;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static int netpoll_wait_epoll(int timeout_ms)
+{
+  static int epoll_events_size;
+  int i, count, flags;
+  uint32_t got;
+
+  if (epoll_events == NULL || epoll_events_size < MAX(64, listed_count))
+  {
+    epoll_events_size = MAX(64, listed_count);
+    RECREATE(epoll_events, struct epoll_event, epoll_events_size);
+  }
+
+  if ((count = epoll_wait(epoll_fd, epoll_events, epoll_events_size, timeout_ms)) < 0)
+    return errno == EINTR ? 0 : -1;
+
+  for (i = 0; i < count; i++)
+  {
+    got = epoll_events[i].events;
+    flags = 0;
+    if (got & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))
+      flags |= NETPOLL_READ;
+    if (got & EPOLLOUT)
+      flags |= NETPOLL_WRITE;
+    if (got & (EPOLLPRI | EPOLLERR))
+      flags |= NETPOLL_ERROR;
+    netpoll_report(epoll_events[i].data.fd, flags);
+  }
+  return count;
+}
+#endif
+
+static int netpoll_wait_select(int timeout_ms)
+{
+  fd_set input_set, output_set, exc_set;
+  struct timeval timeout;
+  socket_t fd, maxdesc = -1;
+  int i, flags;
+
+  FD_ZERO(&input_set);
+  FD_ZERO(&output_set);
+  FD_ZERO(&exc_set);
+  for (i = 0; i < listed_count; i++)
+  {
+    fd = listed_fds[i];
+    FD_SET(fd, &input_set);
+    FD_SET(fd, &exc_set);
+    if (entries[fd].watch & NETPOLL_WRITE)
+      FD_SET(fd, &output_set);
+    if (fd > maxdesc)
+      maxdesc = fd;
+  }
+
+  timeout.tv_sec = timeout_ms / 1000;
+  timeout.tv_usec = (timeout_ms % 1000) * 1000;
+  if (select(maxdesc + 1, &input_set, &output_set, &exc_set, timeout_ms < 0 ? NULL : &timeout) <
+      0)
+    return errno == EINTR ? 0 : -1;
+
+  for (i = 0; i < listed_count; i++)
+  {
+    fd = listed_fds[i];
+    flags = (FD_ISSET(fd, &input_set) ? NETPOLL_READ : 0) |
+            (FD_ISSET(fd, &output_set) ? NETPOLL_WRITE : 0) |
+            (FD_ISSET(fd, &exc_set) ? NETPOLL_ERROR : 0);
+    if (flags)
+      netpoll_report(fd, flags);
+  }
+  return event_count;
+}
+
+int netpoll_wait(int timeout_ms, struct netpoll_event **ready)
+{
+  int i, result;
+
+  /* Forget what the last wait reported. */
+  for (i = 0; i < event_count; i++)
+    if (events[i].ready && netpoll_entry(events[i].fd) != NULL)
+      entries[events[i].fd].ready = 0;
+  event_count = 0;
+  *ready = events;
+
+  switch (backend)
+  {
+#ifdef HAVE_SYS_EPOLL_H
+  case NETPOLL_EPOLL:
+    result = netpoll_wait_epoll(timeout_ms);
+    break;
+#endif
+  case NETPOLL_SELECT:
+    result = netpoll_wait_select(timeout_ms);
+    break;
+  default:
+    return -1;
+  }
+  if (result < 0)
+  {
+    perror("SYSERR: netpoll wait");
+    return -1;
+  }
+
+  PERF_note_netpoll_wait((uint64_t)listed_count, (uint64_t)event_count);
+  *ready = events;
+  return event_count;
+}
+
+int netpoll_ready(socket_t fd)
+{
+  struct netpoll_entry *e = netpoll_entry(fd);
+
+  return e != NULL ? e->ready : 0;
+}
+
+int netpoll_sleep(const socket_t *fds, int count)
+{
+  struct pollfd wait[8];
+  int i;
+
+  count = MIN(count, (int)(sizeof(wait) / sizeof(wait[0])));
+  for (i = 0; i < count; i++)
+  {
+    wait[i].fd = fds[i];
+    wait[i].events = POLLIN;
+    wait[i].revents = 0;
+  }
+
+  if (poll(wait, (nfds_t)count, -1) <= 0)
+    return -1;
+  for (i = 0; i < count; i++)
+    if (wait[i].revents)
+      return i;
+  return -1;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file netpoll.h
+ * @brief Socket readiness polling for the game loop
+ *
+ * Sockets are registered once, when they are opened, and removed when they
+ * are closed, so a pulse costs what is ready rather than what is connected.
+ * epoll is used where the system has it; elsewhere, or when asked for,
+ * select() is the fallback, building its sets from the registered sockets
+ * and still limited to FD_SETSIZE.
+ *
+ * Every registered socket is watched for input and errors.  Write interest
+ * is added only while a socket has output it would not take, so a pulse is
+ * not woken by every idle, writable socket.
+ *
+ * Descriptors register with themselves as owner; the listening and bridge
+ * sockets register with no owner.
+ */
+
+#ifndef LUMINARI_NETPOLL_H
+#define LUMINARI_NETPOLL_H
+
+#include <stdbool.h>
+
+#define NETPOLL_READ 0x01  /**< Input waiting, or the peer hung up */
+#define NETPOLL_WRITE 0x02 /**< Writable again, for sockets waiting to write */
+#define NETPOLL_ERROR 0x04 /**< Out-of-band data or a socket error, as select()'s exceptions */
+
+enum netpoll_backend
+{
+  NETPOLL_AUTO,  /**< epoll where available, otherwise select() */
+  NETPOLL_EPOLL,
+  NETPOLL_SELECT
+};
+
+struct netpoll_event
+{
+  socket_t fd;
+  void *owner; /**< As registered: the descriptor, or NULL */
+  int ready;   /**< NETPOLL_* flags; cleared if the socket is removed */
+};
+
+/** @brief Start polling with backend; false if it is not available. */
+bool netpoll_init(enum netpoll_backend backend);
+/** @brief Forget every socket and release the backend. */
+void netpoll_shutdown(void);
+/** @brief "epoll", "select" or "none". */
+const char *netpoll_backend_name(void);
+
+/** @brief Whether fd could be registered (select() cannot take fds past FD_SETSIZE). */
+bool netpoll_has_room(socket_t fd);
+/** @brief Watch fd for input and errors on behalf of owner. */
+bool netpoll_add(socket_t fd, void *owner);
+/** @brief Stop watching fd; call before closing it. */
+void netpoll_remove(socket_t fd);
+/** @brief Watch fd for writability too, or stop. */
+void netpoll_want_write(socket_t fd, bool want);
+/** @brief Whether fd is waiting to become writable. */
+bool netpoll_waiting_write(socket_t fd);
+
+/**
+ * @brief Keep an ownerless socket that its module opens and closes registered
+ *
+ * Registers current in place of *watched when they differ.  The old fd is
+ * only dropped if it is still registered without an owner, since a closed fd
+ * may already be back in use by a descriptor.
+ */
+void netpoll_follow(socket_t *watched, socket_t current);
+
+/**
+ * @brief Wait up to timeout_ms (0 to poll, -1 forever) for registered sockets
+ *
+ * @param events Set to the ready sockets, valid until the next wait
+ * @return The number of events, or -1 on an error other than a signal
+ */
+int netpoll_wait(int timeout_ms, struct netpoll_event **events);
+/** @brief NETPOLL_* flags fd was reported with by the last wait. */
+int netpoll_ready(socket_t fd);
+
+/**
+ * @brief Sleep until one of count sockets has input, registered or not
+ *
+ * @return The index of a ready socket, or -1 if interrupted or on an error
+ */
+int netpoll_sleep(const socket_t *fds, int count);
+
+#endif /* LUMINARI_NETPOLL_H */
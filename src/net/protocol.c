@@ -27,6 +27,8 @@
 #include "modify.h"
 #include "onboarding.h"
 #include "msdp_json.h"
+#include "mccp.h"
+#include "perfmon.h"
 
 /* Globals */
 const char *RGBone = "F022";
@@ -34,6 +36,9 @@ const char *RGBtwo = "F055";
 const char *RGBthree = "F555";
 
 #define MAX_MSP_TRIGGER_LENGTH 128
+/* How long a copyover waits for each client to take the end of its MCCP2
+ * stream before the exec. */
+#define COPYOVER_MCCP_FINISH_MS 500
 
 static void Write(descriptor_t *apDescriptor, const char *apData)
 {
@@ -91,28 +96,24 @@ static void InfoMessage(descriptor_t *apDescriptor, const char *apData)
   apDescriptor->pProtocol->WriteOOB = 0;
 }
 
-static void CompressStart(descriptor_t *apDescriptor)
+/* Start compressing what apDescriptor is sent (MCCP2); false if it cannot. */
+static bool_t CompressStart(descriptor_t *apDescriptor)
 {
-  /* If your mud uses MCCP (Mud Client Compression Protocol), you need to
-   * call whatever function normally starts compression from here - the
-   * ReportBug() call should then be deleted.
-   *
-   * Otherwise you can just ignore this function.
-   */
+#ifdef USING_MCCP
+  return mccp_start(apDescriptor) ? true : false;
+#else
   (void)apDescriptor;
-  ReportBug("CompressStart() in protocol.c is being called, but it doesn't do anything!\n");
+  return false;
+#endif /* USING_MCCP */
 }
 
 static void CompressEnd(descriptor_t *apDescriptor)
 {
-  /* If your mud uses MCCP (Mud Client Compression Protocol), you need to
-   * call whatever function normally starts compression from here - the
-   * ReportBug() call should then be deleted.
-   *
-   * Otherwise you can just ignore this function.
-   */
+#ifdef USING_MCCP
+  mccp_end(apDescriptor);
+#else
   (void)apDescriptor;
-  ReportBug("CompressEnd() in protocol.c is being called, but it doesn't do anything!\n");
+#endif /* USING_MCCP */
 }
 
 /******************************************************************************
@@ -398,6 +399,7 @@ protocol_t *ProtocolCreate(void)
   pProtocol->bMSP = false;
   pProtocol->bMXP = false;
   pProtocol->bMCCP = false;
+  pProtocol->bMCCP3 = false;
   pProtocol->b256Support = eUNKNOWN;
   pProtocol->ScreenWidth = 0;
   pProtocol->ScreenHeight = 0;
@@ -789,7 +791,10 @@ static void ParseMxpResponse(descriptor_t *apDescriptor, char *apResponse)
   }
 }
 
-ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char *apOut)
+/* Parse plain client bytes into apOut.  *apUsed is how many of them were
+ * parsed: all of them, unless an MCCP3 stream starts part way through. */
+static ssize_t ParseInput(descriptor_t *apDescriptor, char *apData, int aSize, char *apOut,
+                          int *apUsed)
 {
   ssize_t CmdIndex = 0;
   ssize_t Index;
@@ -799,11 +804,9 @@ ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char
   char *CmdBuf;
   protocol_t *pProtocol;
   bool_t bCmdTruncated = false;
+  bool_t bInflating, bCompressed = false;
 
-  if (apData == NULL || apOut == NULL)
-    return PROTOCOL_ERROR_NULL_POINTER;
-  if (aSize < 0)
-    return PROTOCOL_ERROR_INVALID_INPUT;
+  *apUsed = aSize;
   if (aSize == 0)
     return 0;
 
@@ -827,8 +830,9 @@ ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char
     return PROTOCOL_ERROR_NULL_POINTER;
 
   CmdBuf = pProtocol->CmdBuf;
+  bInflating = apDescriptor->mccp_in != NULL;
 
-  for (Index = 0; Index < aSize; ++Index)
+  for (Index = 0; Index < aSize && !bCompressed; ++Index)
   {
     unsigned char Byte;
 
@@ -955,6 +959,8 @@ ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char
         {
           PerformSubnegotiation(apDescriptor, pProtocol->IacBuf[0], &pProtocol->IacBuf[1],
                                 (int)pProtocol->IacLength - 1);
+          /* The rest of apData belongs to a new MCCP3 stream */
+          bCompressed = !bInflating && apDescriptor->mccp_in != NULL;
         }
         pProtocol->IacLength = 0;
         pProtocol->bIacTruncated = false;
@@ -987,12 +993,21 @@ ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char
   }
 
   CmdBuf[CmdIndex] = '\0';
+  *apUsed = (int)Index;
 
   OutputLength = strnlen(apOut, MAX_PROTOCOL_BUFFER);
   if (OutputLength >= MAX_PROTOCOL_BUFFER)
     return PROTOCOL_ERROR_BUFFER_FULL;
 
   Available = MAX_PROTOCOL_BUFFER - OutputLength - 1;
+  /* Reads are sized to the room left, so only inflated MCCP3 input can
+   * outgrow it.  Refuse it, as an overlong plain read is refused, rather
+   * than run whatever part of it happens to fit. */
+  if (bInflating && (size_t)CmdIndex > Available)
+  {
+    ReportBug("ProtocolInput: Inflated MCCP3 input overflows the input buffer\n");
+    return PROTOCOL_ERROR_BUFFER_FULL;
+  }
   CopyLength = (size_t)CmdIndex < Available ? (size_t)CmdIndex : Available;
   memcpy(apOut + OutputLength, CmdBuf, CopyLength);
   apOut[OutputLength + CopyLength] = '\0';
@@ -1002,6 +1017,62 @@ ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char
   return (ssize_t)CopyLength;
 }
 
+ssize_t ProtocolInput(descriptor_t *apDescriptor, char *apData, int aSize, char *apOut)
+{
+#ifdef USING_MCCP
+  char Inflated[MAX_PROTOCOL_BUFFER];
+  ssize_t Length = 0;
+  size_t Used;
+  bool bEnded;
+#endif /* USING_MCCP */
+  ssize_t Result, Total = 0;
+  int Parsed;
+
+  if (apData == NULL || apOut == NULL)
+    return PROTOCOL_ERROR_NULL_POINTER;
+  if (aSize < 0)
+    return PROTOCOL_ERROR_INVALID_INPUT;
+
+  do
+  {
+#ifdef USING_MCCP
+    if (apDescriptor != NULL && apDescriptor->mccp_in != NULL)
+    {
+      /* Inflate what fits and parse that; go round while zlib has more. */
+      Length = mccp_inflate(apDescriptor->mccp_in, apData, (size_t)aSize, &Used, Inflated,
+                            sizeof(Inflated), &bEnded);
+      if (Length < 0)
+        return PROTOCOL_ERROR_INVALID_INPUT;
+      if (bEnded)
+        mccp_input_end(apDescriptor);
+      apData += Used;
+      aSize -= (int)Used;
+      if (Length > 0)
+      {
+        if ((Result = ParseInput(apDescriptor, Inflated, (int)Length, apOut, &Parsed)) < 0)
+          return Result;
+        Total += Result;
+      }
+      else if (Used == 0 && !bEnded)
+        break;
+      continue;
+    }
+    Length = 0;
+#endif /* USING_MCCP */
+    if ((Result = ParseInput(apDescriptor, apData, aSize, apOut, &Parsed)) < 0)
+      return Result;
+    Total += Result;
+    apData += Parsed;
+    aSize -= Parsed;
+  } while (aSize > 0
+#ifdef USING_MCCP
+           || Length == (ssize_t)sizeof(Inflated)
+#endif /* USING_MCCP */
+  );
+
+  return Total;
+}
+
 const char *ProtocolOutput(descriptor_t *apDescriptor, const char *apData, int *apLength)
 {
   static char Result[MAX_OUTPUT_BUFFER + 1];
@@ -1412,6 +1483,22 @@ const char *CopyoverGet(descriptor_t *apDescriptor)
       *pBuffer++ = 'c';
       CompressEnd(apDescriptor);
     }
+#ifdef USING_MCCP
+    /* The client's input stream cannot outlive this process: ask it to stop
+     * compressing.  MCCP3 is not carried over. */
+    if (pProtocol->bMCCP3)
+    {
+      const char WontMCCP3[] = {(char)IAC, (char)WONT, TELOPT_MCCP3, '\0'};
+
+      write_to_descriptor(apDescriptor->descriptor, WontMCCP3, apDescriptor->mccp);
+      mccp_input_end(apDescriptor);
+      pProtocol->bMCCP3 = false;
+    }
+    /* The exec follows at once, so the end of the MCCP2 stream and what was
+     * sent behind it have to go now, not from the game loop. */
+    if (!mccp_finish(apDescriptor, COPYOVER_MCCP_FINISH_MS))
+      ReportBug("CopyoverGet: Compressed output cut short by the copyover\n");
+#endif /* USING_MCCP */
     if (pProtocol->pVariables[eMSDP_256_COLORS]->ValueInt)
       *pBuffer++ = 'C';
     if (pProtocol->bCHARSET)
@@ -1463,8 +1550,7 @@ protocol_error_t CopyoverSet(descriptor_t *apDescriptor, const char *apData)
         pProtocol->pVariables[eMSDP_MXP]->ValueInt = 1;
         break;
       case 'c':
-        pProtocol->bMCCP = true;
-        CompressStart(apDescriptor);
+        pProtocol->bMCCP = CompressStart(apDescriptor);
         break;
       case 'C':
         /* Only auto-enable if not explicitly disabled by user */
@@ -1591,6 +1677,17 @@ protocol_error_t MSDPFlush(descriptor_t *apDescriptor, variable_t aMSDP)
   return PROTOCOL_SUCCESS;
 }
 
+/* Write the frame carrying variable aMSDP, counting it for perfmon. */
+static protocol_error_t WriteVariable(descriptor_t *apDescriptor, variable_t aMSDP,
+                                      const char *apFrame, size_t aFrameLength)
+{
+  protocol_error_t Result = WriteFrame(apDescriptor, apFrame, aFrameLength);
+
+  if (Result == PROTOCOL_SUCCESS)
+    PERF_note_msdp_emit((int)aMSDP, VariableNameTable[aMSDP].pName);
+  return Result;
+}
+
 protocol_error_t MSDPSend(descriptor_t *apDescriptor, variable_t aMSDP)
 {
   char MSDPBuffer[MAX_VARIABLE_LENGTH + 1] = {'\0'};
@@ -1648,7 +1745,7 @@ protocol_error_t MSDPSend(descriptor_t *apDescriptor, variable_t aMSDP)
           ReportBug("MSDPSend: Escaped GMCP frame exceeds MAX_VARIABLE_LENGTH\n");
         return Result;
       }
-      return WriteFrame(apDescriptor, MSDPBuffer, FrameLength);
+      return WriteVariable(apDescriptor, aMSDP, MSDPBuffer, FrameLength);
     }
   }
   else
@@ -1670,7 +1767,7 @@ protocol_error_t MSDPSend(descriptor_t *apDescriptor, variable_t aMSDP)
           ReportBug("MSDPSend: GMCP numeric frame exceeds MAX_VARIABLE_LENGTH\n");
         return Result;
       }
-      return WriteFrame(apDescriptor, MSDPBuffer, FrameLength);
+      return WriteVariable(apDescriptor, aMSDP, MSDPBuffer, FrameLength);
     }
   }
 
@@ -1680,7 +1777,7 @@ protocol_error_t MSDPSend(descriptor_t *apDescriptor, variable_t aMSDP)
     return PROTOCOL_ERROR_BUFFER_FULL;
   }
 
-  return WriteFrame(apDescriptor, MSDPBuffer, (size_t)Written);
+  return WriteVariable(apDescriptor, aMSDP, MSDPBuffer, (size_t)Written);
 }
 
 protocol_error_t MSDPSendPair(descriptor_t *apDescriptor, const char *apVariable,
@@ -2295,6 +2392,7 @@ static void Negotiate(descriptor_t *apDescriptor)
     ConfirmNegotiation(apDescriptor, eNEGOTIATED_MSP, true, true);
     ConfirmNegotiation(apDescriptor, eNEGOTIATED_MXP, true, true);
     ConfirmNegotiation(apDescriptor, eNEGOTIATED_MCCP, true, true);
+    ConfirmNegotiation(apDescriptor, eNEGOTIATED_MCCP3, true, true);
   }
 }
 
@@ -2521,10 +2619,7 @@ static void PerformHandshake(descriptor_t *apDescriptor, char aCmd, char aProtoc
       ConfirmNegotiation(apDescriptor, eNEGOTIATED_MCCP, true, true);
 
       if (!pProtocol->bMCCP)
-      {
-        pProtocol->bMCCP = true;
-        CompressStart(apDescriptor);
-      }
+        pProtocol->bMCCP = CompressStart(apDescriptor);
     }
     else if (aCmd == (char)DONT)
     {
@@ -2543,6 +2638,28 @@ static void PerformHandshake(descriptor_t *apDescriptor, char aCmd, char aProtoc
     }
     break;
 
+  case (char)TELOPT_MCCP3:
+    if (aCmd == (char)DO)
+    {
+      /* The client starts its stream with IAC SB MCCP3 IAC SE. */
+      ConfirmNegotiation(apDescriptor, eNEGOTIATED_MCCP3, true, true);
+#ifdef USING_MCCP
+      pProtocol->bMCCP3 = true;
+#endif /* USING_MCCP */
+    }
+    else if (aCmd == (char)DONT)
+    {
+      /* A stream already running ends when the client finishes it. */
+      ConfirmNegotiation(apDescriptor, eNEGOTIATED_MCCP3, false, pProtocol->bMCCP3);
+      pProtocol->bMCCP3 = false;
+    }
+    else if (aCmd == (char)WILL)
+    {
+      /* Invalid negotiation, send a rejection */
+      SendNegotiationSequence(apDescriptor, (char)DONT, (char)aProtocol);
+    }
+    break;
+
   case (char)TELOPT_MSP:
     if (aCmd == (char)DO)
     {
@@ -3090,6 +3207,14 @@ static void PerformSubnegotiation(descriptor_t *apDescriptor, char aCmd, char *a
     }
     break;
 
+#ifdef USING_MCCP
+  case (char)TELOPT_MCCP3:
+    /* Everything after this subnegotiation is compressed; see ProtocolInput() */
+    if (pProtocol->bMCCP3 && !mccp_input_start(apDescriptor))
+      ReportBug("PerformSubnegotiation: Could not start MCCP3 input stream\n");
+    break;
+#endif /* USING_MCCP */
+
   default: /* Unknown subnegotiation, so we simply ignore it. */
     break;
   }
@@ -3165,6 +3290,11 @@ static bool_t ConfirmNegotiation(descriptor_t *apDescriptor, negotiated_t aProto
         case eNEGOTIATED_MCCP:
 #ifdef USING_MCCP
           SendNegotiationSequence(apDescriptor, abWillDo ? WILL : WONT, TELOPT_MCCP);
+#endif /* USING_MCCP */
+          break;
+        case eNEGOTIATED_MCCP3:
+#ifdef USING_MCCP
+          SendNegotiationSequence(apDescriptor, abWillDo ? WILL : WONT, TELOPT_MCCP3);
 #endif /* USING_MCCP */
           break;
         default:
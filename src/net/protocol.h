@@ -19,7 +19,7 @@
  * - TTYPE: Client identification and terminal type detection
  * - NAWS: Window size negotiation for optimal display formatting
  * - CHARSET: Character encoding negotiation (UTF-8 support)
- * - MCCP: Compression protocol framework (not fully implemented)
+ * - MCCP: Compression of output (MCCP2) and of client input (MCCP3)
  *
  * KEY FEATURES:
  * - Real-time variable evaluation once per second plus immediate subsystem updates
@@ -142,17 +142,13 @@ typedef struct descriptor_data descriptor_t;
 /******************************************************************************
  *                           COMPRESSION SUPPORT
  *
- * MCCP (Mud Client Compression Protocol) v2 support framework.
+ * MCCP (Mud Client Compression Protocol) v2 and v3.
  *
- * STATUS: Framework implemented, compression functions stubbed
- *
- * The protocol system includes full MCCP negotiation support, but the actual
- * compression functions (CompressStart/CompressEnd) are not implemented.
- * To enable compression:
- *
- * 1. Uncomment the USING_MCCP define below
- * 2. Implement CompressStart() and CompressEnd() functions in protocol.c
- * 3. Link with zlib compression library
+ * MCCP2 compresses everything the server sends once the client answers
+ * WILL MCCP2 with DO; MCCP3 lets the client compress what it sends.  The
+ * zlib streams themselves live in net/mccp.c, one per descriptor and
+ * direction; CompressStart() and CompressEnd() in protocol.c hand over to
+ * it, and ProtocolInput() inflates MCCP3 input before parsing it.
  *
  * BENEFITS:
  * - Reduces bandwidth usage by up to 80% for text-heavy output
@@ -160,21 +156,17 @@ typedef struct descriptor_data descriptor_t;
  * - Transparent to both client and server application code
  *
  * REQUIREMENTS:
- * - zlib development libraries
- * - Client support for MCCP v2 (most modern clients support this)
+ * - zlib development libraries (HAVE_ZLIB, set by the build)
  ******************************************************************************/
 
 /**
  * Enable MCCP (Mud Client Compression Protocol) support
  *
- * Uncomment this line after implementing compression functions to enable
- * automatic compression negotiation with supporting clients.
- *
- * @note Requires zlib and implementation of CompressStart/CompressEnd functions
+ * On whenever the build found zlib; without it neither option is offered.
  */
-/*
+#ifdef HAVE_ZLIB
 #define USING_MCCP
-*/
+#endif
 
 /******************************************************************************
  *                           CLIENT GUI INTEGRATION
@@ -251,6 +243,7 @@ typedef struct descriptor_data descriptor_t;
 #define TELOPT_MSDP 69    /**< Mud Server Data Protocol (official) */
 #define TELOPT_MSSP 70    /**< MUD Server Status Protocol (official) */
 #define TELOPT_MCCP 86    /**< MUD Client Compression Protocol v2 (official) */
+#define TELOPT_MCCP3 87   /**< MUD Client Compression Protocol v3, client to server */
 #define TELOPT_MSP 90     /**< MUD Sound Protocol (official) */
 #define TELOPT_MXP 91     /**< MUD eXtension Protocol (official) */
 #define TELOPT_GMCP 201   /**< Generic MUD Communication Protocol (experimental) */
@@ -428,6 +421,7 @@ typedef enum
   eNEGOTIATED_MXP,     /**< MXP markup protocol negotiation completed */
   eNEGOTIATED_MXP2,    /**< MXP version 2 features negotiated */
   eNEGOTIATED_MCCP,    /**< MCCP compression negotiation completed */
+  eNEGOTIATED_MCCP3,   /**< MCCP3 input compression negotiation completed */
 
   eNEGOTIATED_MAX /**< Array size marker - must always be last */
 } negotiated_t;
@@ -738,6 +732,7 @@ typedef struct
   bool_t bMSP;     /**< Sound protocol support */
   bool_t bMXP;     /**< Markup protocol support */
   bool_t bMCCP;    /**< Compression protocol support */
+  bool_t bMCCP3;   /**< Client may compress its input */
 
   /* Client capabilities */
   support_t b256Support; /**< 256-color support level */
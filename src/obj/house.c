@@ -33,7 +33,6 @@ struct house_control_rec house_control[MAX_HOUSES];
 int num_of_houses = 0;
 
 /* functions */
-void House_delete_file(room_vnum vnum);
 house_rnum find_house(room_vnum vnum);
 void House_save_control(void);
 
@@ -152,6 +151,58 @@ static void House_restore_weight(struct obj_data *obj)
   }
 }
 
+/* What House_crashsave() last committed for each house, so a house whose
+ * contents hash the same is not deleted and reinserted again. */
+struct house_save_mark
+{
+  room_vnum vnum;
+  uint64_t fingerprint;
+};
+
+static struct house_save_mark house_saved[MAX_HOUSES];
+static int house_saved_count;
+
+static struct house_save_mark *House_saved_mark(room_vnum vnum)
+{
+  int i;
+
+  for (i = 0; i < house_saved_count; i++)
+    if (house_saved[i].vnum == vnum)
+      return &house_saved[i];
+  return NULL;
+}
+
+static void House_remember_saved(room_vnum vnum, uint64_t fingerprint)
+{
+  struct house_save_mark *mark = House_saved_mark(vnum);
+
+  if (mark == NULL)
+  {
+    if (house_saved_count >= MAX_HOUSES)
+      return;
+    mark = &house_saved[house_saved_count++];
+    mark->vnum = vnum;
+  }
+  mark->fingerprint = fingerprint;
+}
+
+static void House_forget_saved(room_vnum vnum)
+{
+  struct house_save_mark *mark = House_saved_mark(vnum);
+
+  if (mark != NULL)
+    *mark = house_saved[--house_saved_count];
+}
+
+static int House_count_objects(const struct obj_data *obj)
+{
+  int count = 0;
+
+  for (; obj != NULL; obj = obj->next_content)
+    count += 1 + House_count_objects(obj->contains);
+  return count;
+}
+
 /* Save all objects in a house */
 bool House_crashsave(room_vnum vnum)
 {
@@ -160,12 +211,30 @@ bool House_crashsave(room_vnum vnum)
   FILE *fp;
   char del_buf[2048];
   enum perf_sql_category previous_sql_category;
+  struct house_save_mark *mark;
+  uint64_t fingerprint = 0;
   bool success;
 
   PERF_PROF_ENTER_SAMPLED(pr_house_save_, "save.house");
   previous_sql_category = PERF_sql_scope_set(PERF_SQL_HOUSE);
   success = false;
 
+  /* Nothing to write if the house holds what it held at the last save.  The
+   * hash is taken before House_save() takes the contents' weight off their
+   * containers. */
+  if ((rnum = real_room(vnum)) != NOWHERE)
+  {
+    fingerprint = objsave_hash_objects(OBJSAVE_HASH_SEED, world[rnum].contents);
+    if ((mark = House_saved_mark(vnum)) != NULL && mark->fingerprint == fingerprint)
+    {
+      PERF_note_object_save_rows(0, House_count_objects(world[rnum].contents), 0);
+      REMOVE_BIT_AR(ROOM_FLAGS(rnum), ROOM_HOUSE_CRASH);
+      success = true;
+      goto cleanup;
+    }
+  }
+  House_forget_saved(vnum);
+
   if (mysql_query(conn, "start transaction;"))
   {
     log("SYSERR: Unable to start transaction for saving of house data: %s", mysql_error(conn));
@@ -213,6 +282,7 @@ bool House_crashsave(room_vnum vnum)
     goto cleanup;
   }
 
+  House_remember_saved(vnum, fingerprint);
   REMOVE_BIT_AR(ROOM_FLAGS(rnum), ROOM_HOUSE_CRASH);
   success = true;
 
@@ -228,6 +298,8 @@ void House_delete_file(room_vnum vnum)
   char filename[MAX_INPUT_LENGTH] = {'\0'};
   FILE *fl;
 
+  House_forget_saved(vnum);
+
   if (!House_get_filename(vnum, filename, sizeof(filename)))
     return;
 
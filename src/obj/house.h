@@ -66,6 +66,7 @@ void House_boot(void);
 void House_save_all(void);
 int House_can_enter(struct char_data *ch, room_vnum house);
 bool House_crashsave(room_vnum vnum);
+void House_delete_file(room_vnum vnum);
 enum persistence_step_result House_save_incremental(int max_saves);
 void House_list_guests(struct char_data *ch, int i, int quiet);
 int House_save(struct obj_data *obj, room_vnum vnum, FILE *fp, int location);
@@ -27,6 +27,7 @@
 #include "spec_artifacts.h"
 #include "objsave.h"
 #include "perfmon.h"
+#include "persistence_writer.h"
 
 #define OBJSAVE_DB 1
 
@@ -112,6 +113,202 @@ static bool objsave_replace_special_ability(struct obj_data *obj, const char *li
 }
 
 
+/* What obj would look like fresh from its prototype, for the save code to
+ * diff against: the prototype with read_object()'s load rules applied, kept
+ * in the caller's baseline so no object is created, indexed, or extracted.
+ * Strings, lists and scripts still point at the prototype's, which is what a
+ * new copy shares with it too.  An object with no prototype gets a cleared
+ * baseline, as create_obj() would make. */
+static void objsave_proto_baseline(const struct obj_data *obj, struct obj_data *baseline)
+{
+  obj_rnum rnum = GET_OBJ_RNUM(obj);
+
+  if (rnum == NOTHING || rnum > top_of_objt)
+  {
+    clear_object(baseline);
+    baseline->item_number = NOWHERE;
+    return;
+  }
+  *baseline = obj_proto[rnum];
+  apply_object_load_rules(baseline);
+}
+
+/* FNV-1a over everything objsave_save_obj_record_db() can write for a list
+ * of objects and their contents, so a save can tell nothing has changed
+ * without serializing anything.  The pet save uses it too. */
+uint64_t objsave_hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+  const unsigned char *bytes;
+  size_t i;
+
+  bytes = data;
+  for (i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= UINT64_C(1099511628211);
+  }
+  return hash;
+}
+
+uint64_t objsave_hash_string(uint64_t hash, const char *text)
+{
+  if (text == NULL)
+    return objsave_hash_bytes(hash, "", 1);
+  return objsave_hash_bytes(hash, text, strlen(text) + 1);
+}
+
+uint64_t objsave_hash_objects(uint64_t hash, const struct obj_data *obj)
+{
+  const struct extra_descr_data *extra;
+  const struct obj_special_ability *ability;
+  unsigned char marker;
+  int vnum;
+  int i;
+
+  for (; obj != NULL; obj = obj->next_content)
+  {
+    marker = 1;
+    hash = objsave_hash_bytes(hash, &marker, sizeof(marker));
+    vnum = GET_OBJ_VNUM(obj);
+    hash = objsave_hash_bytes(hash, &vnum, sizeof(vnum));
+    hash = objsave_hash_bytes(hash, &obj->obj_flags, sizeof(obj->obj_flags));
+    hash = objsave_hash_bytes(hash, obj->affected, sizeof(obj->affected));
+    hash = objsave_hash_bytes(hash, &obj->weapon_poison, sizeof(obj->weapon_poison));
+    hash = objsave_hash_bytes(hash, obj->activate_spell, sizeof(obj->activate_spell));
+    hash = objsave_hash_bytes(hash, &obj->tinker_bonus, sizeof(obj->tinker_bonus));
+    hash = objsave_hash_string(hash, obj->name);
+    hash = objsave_hash_string(hash, obj->description);
+    hash = objsave_hash_string(hash, obj->short_description);
+    hash = objsave_hash_string(hash, obj->action_description);
+    hash = objsave_hash_string(hash, obj->arcane_mark);
+    hash = objsave_hash_string(hash, obj->restring_identifier);
+    for (extra = obj->ex_description; extra != NULL; extra = extra->next)
+    {
+      hash = objsave_hash_string(hash, extra->keyword);
+      hash = objsave_hash_string(hash, extra->description);
+    }
+    marker = 2;
+    hash = objsave_hash_bytes(hash, &marker, sizeof(marker));
+    if (obj->sbinfo != NULL)
+      for (i = 0; i < SPELLBOOK_SIZE; i++)
+        hash = objsave_hash_bytes(hash, &obj->sbinfo[i], sizeof(obj->sbinfo[i]));
+    for (ability = obj->special_abilities; ability != NULL; ability = ability->next)
+    {
+      hash = objsave_hash_bytes(hash, &ability->ability, sizeof(ability->ability));
+      hash = objsave_hash_bytes(hash, &ability->level, sizeof(ability->level));
+      hash = objsave_hash_bytes(hash, &ability->activation_method,
+                                sizeof(ability->activation_method));
+      hash = objsave_hash_bytes(hash, ability->value, sizeof(ability->value));
+      hash = objsave_hash_string(hash, ability->command_word);
+    }
+    /* Sheathed weapons are saved alongside their sheath. */
+    hash = objsave_hash_objects(hash, obj->sheath_primary);
+    hash = objsave_hash_objects(hash, obj->sheath_secondary);
+    hash = objsave_hash_objects(hash, obj->contains);
+  }
+  marker = 0;
+  hash = objsave_hash_bytes(hash, &marker, sizeof(marker));
+  return hash;
+}
+
+/* While Crash_crashsave() takes its snapshot, the statements it would send
+ * are added to it for the persistence writer instead.  A sheath row's id is
+ * only known once the writer has inserted it, so the captured INSERTs of
+ * its contents read it from @objsave_sheath. */
+static struct persistence_write *objsave_capture;
+#define OBJSAVE_CAPTURED_SHEATH -1L
+
+#ifdef OBJSAVE_DB
+/* How objsave_save_obj_record_db() sends a player's rows.  Crash_crashsave()
+ * batches them into multi-row INSERTs, or leaves them alone entirely when
+ * the player's objects hash the same as at the last committed save; every
+ * other caller inserts a row at a time. */
+#define OBJSAVE_ROWS_EACH 0
+#define OBJSAVE_ROWS_BATCH 1
+#define OBJSAVE_ROWS_UNCHANGED 2
+
+#define OBJSAVE_BATCH_SIZE (256 * 1024) /* well under the server's max_allowed_packet */
+#define OBJSAVE_BATCH_INSERT                                                                       \
+  "insert into player_save_objs (name, serialized_obj, creation_date) values "
+
+static int objsave_rows_mode = OBJSAVE_ROWS_EACH;
+static char objsave_batch[OBJSAVE_BATCH_SIZE];
+static size_t objsave_batch_len;
+static int objsave_batch_rows;
+static int objsave_batch_sequence; /* rows queued since objsave_rows_begin() */
+static bool objsave_batch_failed;
+
+static void objsave_rows_begin(int mode)
+{
+  objsave_rows_mode = mode;
+  objsave_batch_len = 0;
+  objsave_batch_rows = 0;
+  objsave_batch_sequence = 0;
+  objsave_batch_failed = FALSE;
+}
+
+/* Send the queued rows.  A failure is remembered for objsave_rows_end(), so
+ * the caller can roll the whole save back rather than commit part of it. */
+static bool objsave_batch_flush(void)
+{
+  if (objsave_batch_rows == 0)
+    return !objsave_batch_failed;
+
+  if (objsave_capture == NULL && mysql_query(conn, objsave_batch))
+  {
+    log("SYSERR: Unable to INSERT %d rows into player_save_objs: %s", objsave_batch_rows,
+        mysql_error(conn));
+    objsave_batch_failed = TRUE;
+  }
+  else
+  {
+    if (objsave_capture != NULL)
+      persistence_write_sql(objsave_capture, objsave_batch);
+    PERF_note_object_save_rows(objsave_batch_rows, 0, 1);
+  }
+
+  objsave_batch_len = 0;
+  objsave_batch_rows = 0;
+  return !objsave_batch_failed;
+}
+
+/* Queue one row; values is "('name', 'serialized" with the escaped object.
+ * The loader reads rows back by creation_date, and rows sharing one INSERT
+ * would share its timestamp, so each is stamped a microsecond after the
+ * last to keep them in the order they were saved. */
+static void objsave_batch_row(const char *values)
+{
+  char stamp[64];
+  size_t stamp_len, needed;
+
+  stamp_len = snprintf(stamp, sizeof(stamp), "', NOW(6) + INTERVAL %d MICROSECOND)",
+                       objsave_batch_sequence++);
+  needed = strlen(values) + stamp_len + 2;
+  if (objsave_batch_rows > 0 && objsave_batch_len + needed >= sizeof(objsave_batch))
+    objsave_batch_flush();
+
+  if (objsave_batch_rows == 0)
+    objsave_batch_len = strlcpy(objsave_batch, OBJSAVE_BATCH_INSERT, sizeof(objsave_batch));
+  else
+    objsave_batch_len = strlcat(objsave_batch, ", ", sizeof(objsave_batch));
+  strlcat(objsave_batch, values, sizeof(objsave_batch));
+  objsave_batch_len = strlcat(objsave_batch, stamp, sizeof(objsave_batch));
+  objsave_batch_rows++;
+}
+
+/* Flush what is left and go back to a row at a time; FALSE if any row did
+ * not make it. */
+static bool objsave_rows_end(void)
+{
+  bool ok = TRUE;
+
+  if (objsave_rows_mode == OBJSAVE_ROWS_BATCH)
+    ok = objsave_batch_flush();
+  objsave_rows_mode = OBJSAVE_ROWS_EACH;
+  return ok;
+}
+#endif
+
 int objsave_save_obj_record(struct obj_data *obj, struct char_data *ch, FILE *fp, int locate)
 {
   return objsave_save_obj_record_db(obj, ch, NOWHERE, fp, locate);
@@ -137,25 +334,20 @@ int objsave_save_obj_record_db(struct obj_data *obj, struct char_data *ch, room_
 #ifdef OBJSAVE_DB
   static char ins_buf[36767]; /* For MySQL insert - static to avoid stack allocation */
   static char line_buf[4096]; /* For building MySQL insert statement - reduced size */
+  size_t values_at = 0;       /* Where the row's parenthesized values start in ins_buf */
 #endif
 
   int counter2, i = 0;
   size_t x;
   struct extra_descr_data *ex_desc;
   char buf1[4096]; /* Reduced from MAX_STRING_LENGTH */
-  struct obj_data *temp = NULL;
+  struct obj_data baseline, *temp = &baseline;
   struct obj_special_ability *specab = NULL;
   char escaped_buf[4096]; /* Reduced from MAX_STRING_LENGTH */
   char escaped_key[512];  /* Reduced from MAX_STRING_LENGTH */
 
-  /* load up the object */
-  if (GET_OBJ_VNUM(obj) != NOTHING)
-    temp = read_object(GET_OBJ_VNUM(obj), VIRTUAL);
-  else
-  {
-    temp = create_obj();
-    temp->item_number = NOWHERE;
-  }
+  /* what it would look like fresh from its prototype */
+  objsave_proto_baseline(obj, temp);
 
   /* copy the action-description to buf1 */
   if (obj->action_description)
@@ -168,8 +360,11 @@ int objsave_save_obj_record_db(struct obj_data *obj, struct char_data *ch, room_
 
 #ifdef OBJSAVE_DB
   if (ch != NULL) /* GHETTTTTOOOOOOOOO */
+  {
+    values_at = strlen("insert into player_save_objs (name, serialized_obj) values ");
     snprintf(ins_buf, sizeof(ins_buf),
              "insert into player_save_objs (name, serialized_obj) values ('%s', '", GET_NAME(ch));
+  }
   else
     snprintf(ins_buf, sizeof(ins_buf),
              "insert into house_data (vnum, serialized_obj) values ('%d', '", house_vnum);
@@ -567,28 +762,54 @@ int objsave_save_obj_record_db(struct obj_data *obj, struct char_data *ch, room_
   fprintf(fp, "\n");
 
 #ifdef OBJSAVE_DB
-  snprintf(line_buf, sizeof(line_buf), "');");
-  strlcat(ins_buf, line_buf, sizeof(ins_buf));
-  if (ch != NULL)
-  { /* GHETTTTTTTOOOOOOOOO */
-    if (mysql_query(conn, ins_buf))
-    {
-      log("SYSERR: Unable to REPLACE into player_save_objs: %s", mysql_error(conn));
-      extract_obj(temp);
+  if (ch != NULL && objsave_rows_mode == OBJSAVE_ROWS_UNCHANGED)
+  {
+    /* The rows from the last save still hold this object. */
+    PERF_note_object_save_rows(0, 1, 0);
+    return 1;
+  }
+  if (ch != NULL && objsave_rows_mode == OBJSAVE_ROWS_BATCH)
+  {
+    /* A sheath's contents are filed under its row id, which only an INSERT
+     * of that one row reports back. */
+    if (CAN_WEAR(obj, ITEM_WEAR_SHEATH))
+      objsave_batch_flush();
+    objsave_batch_row(ins_buf + values_at);
+    if (!CAN_WEAR(obj, ITEM_WEAR_SHEATH) || !objsave_batch_flush())
       return 1;
-    }
   }
   else
   {
-    if (mysql_query(conn, ins_buf))
+    snprintf(line_buf, sizeof(line_buf), "');");
+    strlcat(ins_buf, line_buf, sizeof(ins_buf));
+    if (ch != NULL)
+    { /* GHETTTTTTTOOOOOOOOO */
+      if (mysql_query(conn, ins_buf))
+      {
+        log("SYSERR: Unable to REPLACE into player_save_objs: %s", mysql_error(conn));
+        return 1;
+      }
+    }
+    else
     {
-      log("SYSERR: Unable to INSERT into house_data: %s", mysql_error(conn));
-      extract_obj(temp);
-      return 1;
+      if (mysql_query(conn, ins_buf))
+      {
+        log("SYSERR: Unable to INSERT into house_data: %s", mysql_error(conn));
+        return 1;
+      }
     }
+    PERF_note_object_save_rows(1, 0, 1);
   }
 
-  int insert_id = mysql_insert_id(conn);
+  long insert_id;
+
+  if (objsave_capture != NULL && CAN_WEAR(obj, ITEM_WEAR_SHEATH))
+  {
+    persistence_write_sql(objsave_capture, "set @objsave_sheath = last_insert_id();");
+    insert_id = OBJSAVE_CAPTURED_SHEATH;
+  }
+  else
+    insert_id = mysql_insert_id(conn);
 
   if (CAN_WEAR(obj, ITEM_WEAR_SHEATH))
   {
@@ -603,8 +824,6 @@ int objsave_save_obj_record_db(struct obj_data *obj, struct char_data *ch, room_
   }
 #endif
 
-  extract_obj(temp);
-
   return 1;
 }
 #undef TEST_OBJS
@@ -838,6 +1057,7 @@ int Crash_delete_file(char *name)
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
     return FALSE;
 
+  persistence_writer_flush();
   if (!(fl = fopen(filename, "r")))
   {
     if (errno != ENOENT) /* if it fails but NOT because of no file */
@@ -978,6 +1198,7 @@ void Crash_listrent(struct char_data *ch, char *name)
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
     return;
 
+  persistence_writer_flush();
   if (!(fl = fopen(filename, "r")))
   {
     send_to_char(ch, "%s has no rent file.\r\n", name);
@@ -1227,49 +1448,130 @@ bool pet_save_objs(struct char_data *ch, struct char_data *owner, long int pet_i
   return true;
 }
 
+#ifdef OBJSAVE_DB
+/* Everything Crash_crashsave() writes rows for, and where it is worn. */
+static uint64_t Crash_fingerprint(struct char_data *ch)
+{
+  uint64_t hash;
+  int j;
+
+  hash = objsave_hash_string(OBJSAVE_HASH_SEED, GET_NAME(ch));
+  for (j = 0; j < NUM_WEARS; j++)
+    if (GET_EQ(ch, j))
+    {
+      hash = objsave_hash_bytes(hash, &j, sizeof(j));
+      hash = objsave_hash_objects(hash, GET_EQ(ch, j));
+    }
+  hash = objsave_hash_objects(hash, ch->bags->bag1);
+  hash = objsave_hash_objects(hash, ch->bags->bag2);
+  hash = objsave_hash_objects(hash, ch->bags->bag3);
+  hash = objsave_hash_objects(hash, ch->bags->bag4);
+  hash = objsave_hash_objects(hash, ch->bags->bag5);
+  hash = objsave_hash_objects(hash, ch->bags->bag6);
+  hash = objsave_hash_objects(hash, ch->bags->bag7);
+  hash = objsave_hash_objects(hash, ch->bags->bag8);
+  hash = objsave_hash_objects(hash, ch->bags->bag9);
+  hash = objsave_hash_objects(hash, ch->bags->bag10);
+  return objsave_hash_objects(hash, ch->carrying);
+}
+#endif
+
+/* Crash_crashsave() leaves its writes to the persistence writer.  Anything
+ * else that replaces a player's rent file or rows waits for those first,
+ * and makes sure no save still in flight vouches for the rows it leaves. */
+static void Crash_forget_saved(struct char_data *ch)
+{
+  persistence_writer_flush();
+  ch->player_specials->obj_save_fingerprint_valid = FALSE;
+  ch->player_specials->obj_save_sequence++;
+}
+
+/* Give up on a crash save part way through. */
+static void Crash_crashsave_abort(FILE *fp, char **image, struct persistence_write *job)
+{
+  fclose(fp);
+  free(*image);
+#ifdef OBJSAVE_DB
+  objsave_rows_end();
+#endif
+  objsave_capture = NULL;
+  persistence_write_free(job);
+}
+
+/* Back on the game thread once the writer has run a crash save.  Only the
+ * player's newest save may vouch for their rows; a failure leaves them to
+ * be saved again. */
+static void Crash_crashsave_done(struct persistence_write *job, struct char_data *ch)
+{
+  if (ch == NULL || job->sequence != ch->player_specials->obj_save_sequence)
+    return;
+  if (job->failed)
+  {
+    ch->player_specials->obj_save_fingerprint_valid = FALSE;
+    SET_BIT_AR(PLR_FLAGS(ch), PLR_CRASH);
+    return;
+  }
+  ch->player_specials->obj_save_fingerprint = job->fingerprint;
+  ch->player_specials->obj_save_fingerprint_valid = TRUE;
+}
+
+/* Player objects are also kept in player_save_objs.  When they hash the same
+ * as at the last committed save the rows are left alone, and only the rent
+ * file and its header are rewritten; otherwise they are replaced in a few
+ * multi-row INSERTs.  The rent file and statements are only formatted here;
+ * the persistence writer installs and sends them. */
 void Crash_crashsave(struct char_data *ch)
 {
   char buf[MAX_INPUT_LENGTH] = {'\0'};
   int j;
   FILE *fp;
+  char *image = NULL;
+  size_t image_length = 0;
+  struct persistence_write *job;
+#ifdef OBJSAVE_DB
+  uint64_t fingerprint;
+  bool rewrite_rows;
+#endif
 
-  if (IS_NPC(ch))
+  /* Without bags this was never loaded as a player. */
+  if (IS_NPC(ch) || ch->bags == NULL)
     return;
 
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
-  if (!(fp = fopen_restricted(buf, "w")))
+  if (!(fp = open_memstream(&image, &image_length)))
     return;
 
+  job = persistence_write_new("crash save", GET_IDNUM(ch), Crash_crashsave_done);
+  job->sql_category = PERF_SQL_CRASH_OBJECT;
+  objsave_capture = job;
+
 #ifdef OBJSAVE_DB
   char del_buf[2048];
-  if (mysql_query(conn, "start transaction;"))
-  {
-    log("SYSERR: Unable to start transaction for saving of player object data: %s",
-        mysql_error(conn));
-    fclose(fp);
-    return;
-  }
-  /* Delete existing save data.  In the future may just flag these for deletion. */
-  snprintf(del_buf, sizeof(del_buf), "delete from player_save_objs where name = '%s';",
-           GET_NAME(ch));
-  if (mysql_query(conn, del_buf))
+
+  /* Before Crash_save() takes the contents' weight off their containers. */
+  fingerprint = Crash_fingerprint(ch);
+  rewrite_rows = !ch->player_specials->obj_save_fingerprint_valid ||
+                 ch->player_specials->obj_save_fingerprint != fingerprint;
+  ch->player_specials->obj_save_fingerprint_valid = FALSE;
+  job->fingerprint = fingerprint;
+  job->sequence = ++ch->player_specials->obj_save_sequence;
+
+  if (rewrite_rows)
   {
-    log("SYSERR: Unable to delete player object save data: %s", mysql_error(conn));
-    mysql_query(conn, "rollback;");
-    fclose(fp);
-    return;
+    /* Delete existing save data.  In the future may just flag these for deletion. */
+    snprintf(del_buf, sizeof(del_buf), "delete from player_save_objs where name = '%s';",
+             GET_NAME(ch));
+    persistence_write_sql(job, del_buf);
   }
+  objsave_rows_begin(rewrite_rows ? OBJSAVE_ROWS_BATCH : OBJSAVE_ROWS_UNCHANGED);
 #endif
 
   /* write to file rentcode: rentcode, time, cost for renting, gold, bank-gold */
   if (!objsave_write_rentcode(fp, RENT_CRASH, 0, ch))
   {
-#ifdef OBJSAVE_DB
-    mysql_query(conn, "rollback;");
-#endif
-    fclose(fp);
+    Crash_crashsave_abort(fp, &image, job);
     return;
   }
 
@@ -1279,10 +1581,7 @@ void Crash_crashsave(struct char_data *ch)
       /* recursive write-to-file function (like bags) */
       if (!Crash_save(GET_EQ(ch, j), ch, fp, j + 1))
       {
-        fclose(fp);
-#ifdef OBJSAVE_DB
-        mysql_query(conn, "rollback;");
-#endif
+        Crash_crashsave_abort(fp, &image, job);
         return;
       }
       /* makes sure containers have proper weight for carrying objects with weight value */
@@ -1304,10 +1603,7 @@ void Crash_crashsave(struct char_data *ch)
   /* inventory: recursive write-to-file function (like bags) */
   if (!Crash_save(ch->carrying, ch, fp, 0))
   {
-    fclose(fp);
-#ifdef OBJSAVE_DB
-    mysql_query(conn, "rollback;");
-#endif
+    Crash_crashsave_abort(fp, &image, job);
     return;
   }
 
@@ -1315,18 +1611,21 @@ void Crash_crashsave(struct char_data *ch)
   Crash_restore_weight(ch->carrying);
 
   fprintf(fp, "$~\n");
-  fclose(fp);
-
 #ifdef OBJSAVE_DB
-  if (mysql_query(conn, "commit;"))
+  objsave_rows_end();
+#endif
+  objsave_capture = NULL;
+  if (fclose(fp) != 0)
   {
-    log("SYSERR: Unable to commit transaction for saving of player object data: %s",
-        mysql_error(conn));
-    mysql_query(conn, "rollback;");
+    free(image);
+    persistence_write_free(job);
     return;
   }
-#endif
+
+  /* Cleared first: a write that fails sets it again. */
   REMOVE_BIT_AR(PLR_FLAGS(ch), PLR_CRASH);
+  persistence_write_file(job, buf, image, image_length);
+  persistence_writer_submit(job, ch, FALSE);
 }
 
 void Crash_idlesave(struct char_data *ch)
@@ -1339,6 +1638,8 @@ void Crash_idlesave(struct char_data *ch)
   if (IS_NPC(ch))
     return;
 
+  Crash_forget_saved(ch);
+
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
@@ -1478,6 +1779,8 @@ void Crash_rentsave(struct char_data *ch, int cost)
   if (IS_NPC(ch))
     return;
 
+  Crash_forget_saved(ch);
+
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
@@ -1590,7 +1893,9 @@ static int objsave_write_rentcode(FILE *fl, int rentcode, int cost_per_day, stru
            "update player_data set obj_save_header = '%d %ld %d %d %d %d'"
            "where name = '%s';",
            rentcode, (long)time(0), cost_per_day, GET_GOLD(ch), GET_BANK_GOLD(ch), 0, GET_NAME(ch));
-  if (mysql_query(conn, buf))
+  if (objsave_capture != NULL)
+    persistence_write_sql(objsave_capture, buf);
+  else if (mysql_query(conn, buf))
   {
     log("SYSERR: Unable to INSERT obj_save_header into PLAYER_DATA: %s", mysql_error(conn));
     return FALSE;
@@ -1615,6 +1920,8 @@ static void Crash_cryosave(struct char_data *ch, int cost)
   if (IS_NPC(ch))
     return;
 
+  Crash_forget_saved(ch);
+
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
@@ -1890,7 +2197,7 @@ int Crash_save_single(struct char_data *ch, uint64_t *obj_usec, uint64_t *char_u
   PERF_PROF_EXIT(pr_crash_object_save_);
   gettimeofday(&t_mid, NULL);
   PERF_PROF_ENTER_SAMPLED(pr_crash_character_save_, "save.crash_character");
-  character_saved = save_char_checked(ch, 0);
+  character_saved = save_char_async(ch, 0);
   PERF_PROF_EXIT(pr_crash_character_save_);
   gettimeofday(&t_end, NULL);
 
@@ -2962,6 +3269,9 @@ static int Crash_load_objs(struct char_data *ch)
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch)))
     return 1;
 
+  /* The file and rows as the last crash save left them. */
+  persistence_writer_flush();
+
 
   for (i = 0; i < MAX_BAG_ROWS; i++)
     cont_row[i] = NULL;
@@ -3280,22 +3590,14 @@ int objsave_save_obj_record_db_pet(struct obj_data *obj,
   char *escaped_owner = NULL;
   char *escaped_payload = NULL;
   char *insert_query = NULL;
-  struct obj_data *temp = NULL;
+  struct obj_data baseline, *temp = &baseline;
   struct obj_special_ability *specab = NULL;
   size_t query_size;
   int result = 0;
   int written;
 
-  /* load up the object */
-  if (GET_OBJ_VNUM(obj) != NOTHING)
-    temp = read_object(GET_OBJ_VNUM(obj), VIRTUAL);
-  else
-  {
-    temp = create_obj();
-    temp->item_number = NOWHERE;
-  }
-  if (!temp)
-    return 0;
+  /* what it would look like fresh from its prototype */
+  objsave_proto_baseline(obj, temp);
 
   /* copy the action-description to buf1 */
   if (obj->action_description)
@@ -3539,7 +3841,6 @@ cleanup:
   free(insert_query);
   free(escaped_payload);
   free(escaped_owner);
-  extract_obj(temp);
   return result;
 }
 #undef TEST_OBJS
@@ -4007,17 +4308,11 @@ int objsave_save_obj_record_db_sheath(struct obj_data *obj, struct char_data *ch
   int counter2, i = 0;
   struct extra_descr_data *ex_desc;
   char buf1[4096]; /* Reduced from MAX_STRING_LENGTH */
-  struct obj_data *temp = NULL;
+  struct obj_data baseline, *temp = &baseline;
   struct obj_special_ability *specab = NULL;
 
-  /* load up the object */
-  if (GET_OBJ_VNUM(obj) != NOTHING)
-    temp = read_object(GET_OBJ_VNUM(obj), VIRTUAL);
-  else
-  {
-    temp = create_obj();
-    temp->item_number = NOWHERE;
-  }
+  /* what it would look like fresh from its prototype */
+  objsave_proto_baseline(obj, temp);
 
   /* copy the action-description to buf1 */
   if (obj->action_description)
@@ -4028,10 +4323,16 @@ int objsave_save_obj_record_db_sheath(struct obj_data *obj, struct char_data *ch
   else
     *buf1 = 0;
 
-  snprintf(ins_buf, sizeof(ins_buf),
-           "insert into player_save_objs_sheathed (id, sheath_obj_id, sheathed_position, "
-           "owner_name, serialized_obj) values (NULL, '%ld', %d, '%s', '",
-           sheath_idnum, sheath_slot, GET_NAME(ch));
+  if (sheath_idnum == OBJSAVE_CAPTURED_SHEATH)
+    snprintf(ins_buf, sizeof(ins_buf),
+             "insert into player_save_objs_sheathed (id, sheath_obj_id, sheathed_position, "
+             "owner_name, serialized_obj) values (NULL, @objsave_sheath, %d, '%s', '",
+             sheath_slot, GET_NAME(ch));
+  else
+    snprintf(ins_buf, sizeof(ins_buf),
+             "insert into player_save_objs_sheathed (id, sheath_obj_id, sheathed_position, "
+             "owner_name, serialized_obj) values (NULL, '%ld', %d, '%s', '",
+             sheath_idnum, sheath_slot, GET_NAME(ch));
 
   snprintf(line_buf, sizeof(line_buf), "#%d\n", GET_OBJ_VNUM(obj));
   strlcat(ins_buf, line_buf, sizeof(ins_buf));
@@ -4228,16 +4529,15 @@ int objsave_save_obj_record_db_sheath(struct obj_data *obj, struct char_data *ch
 
   snprintf(line_buf, sizeof(line_buf), "');");
   strlcat(ins_buf, line_buf, sizeof(ins_buf));
-  if (mysql_query(conn, ins_buf))
+  if (objsave_capture != NULL)
+    persistence_write_sql(objsave_capture, ins_buf);
+  else if (mysql_query(conn, ins_buf))
   {
     log("SYSERR: Unable to INSERT into player_save_objs_sheathed: %s\n%s\n", mysql_error(conn),
         ins_buf);
-    extract_obj(temp);
     return 1;
   }
 
-  extract_obj(temp);
-
   return 1;
 }
 
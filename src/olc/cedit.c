@@ -153,6 +153,8 @@ static void cedit_setup(struct descriptor_data *d)
   OLC_CONFIG(d)->operation.protocol_negotiation = CONFIG_PROTOCOL_NEGOTIATION;
   OLC_CONFIG(d)->operation.special_in_comm = CONFIG_SPECIAL_IN_COMM;
   OLC_CONFIG(d)->operation.debug_mode = CONFIG_DEBUG_MODE;
+  OLC_CONFIG(d)->operation.mob_active_ring = CONFIG_MOB_ACTIVE_RING;
+  OLC_CONFIG(d)->operation.mob_dormant_cadence = CONFIG_MOB_DORMANT_CADENCE;
 
   /* Autowiz */
   OLC_CONFIG(d)->autowiz.use_autowiz = CONFIG_USE_AUTOWIZ;
@@ -338,6 +340,8 @@ static void cedit_save_internally(struct descriptor_data *d)
   CONFIG_PROTOCOL_NEGOTIATION = OLC_CONFIG(d)->operation.protocol_negotiation;
   CONFIG_SPECIAL_IN_COMM = OLC_CONFIG(d)->operation.special_in_comm;
   CONFIG_DEBUG_MODE = OLC_CONFIG(d)->operation.debug_mode;
+  CONFIG_MOB_ACTIVE_RING = OLC_CONFIG(d)->operation.mob_active_ring;
+  CONFIG_MOB_DORMANT_CADENCE = OLC_CONFIG(d)->operation.mob_dormant_cadence;
 
   /* Autowiz */
   CONFIG_USE_AUTOWIZ = OLC_CONFIG(d)->autowiz.use_autowiz;
@@ -859,6 +863,18 @@ int save_config(IDXTYPE nowhere __attribute__((unused)))
           "debug_mode = %d\n\n",
           CONFIG_DEBUG_MODE);
 
+  fprintf(fl,
+          "* How many zones out from a zone with players in it mobiles keep\n"
+          "* full-rate AI.\n"
+          "mob_active_ring = %d\n\n",
+          CONFIG_MOB_ACTIVE_RING);
+
+  fprintf(fl,
+          "* Mobiles further away act one mobile cycle in this many.\n"
+          "* 0 = every cycle, -1 = never.\n"
+          "mob_dormant_cadence = %d\n\n",
+          CONFIG_MOB_DORMANT_CADENCE);
+
   fprintf(fl,
           "* Chance for Happy Hour to Occur randomly and automatically each rl hour.\n"
           "happy_hour_chance = %d\n\n",
@@ -1451,9 +1467,19 @@ static void cedit_disp_room_numbers(struct descriptor_data *d)
 
 static void cedit_disp_operation_options(struct descriptor_data *d)
 {
+  char cadence[32];
+
   get_char_colors(d->character);
   clear_screen(d);
 
+  if (OLC_CONFIG(d)->operation.mob_dormant_cadence < 0)
+    strlcpy(cadence, "Never", sizeof(cadence));
+  else if (OLC_CONFIG(d)->operation.mob_dormant_cadence <= 1)
+    strlcpy(cadence, "Every cycle", sizeof(cadence));
+  else
+    snprintf(cadence, sizeof(cadence), "1 cycle in %d",
+             OLC_CONFIG(d)->operation.mob_dormant_cadence);
+
   write_to_output(
       d,
       "\r\n\r\n"
@@ -1476,6 +1502,8 @@ static void cedit_disp_operation_options(struct descriptor_data *d)
       "%sR%s) Enable Protocol Negotiation : %s%s\r\n"
       "%sS%s) Enable Special Char in Comm : %s%s\r\n"
       "%sT%s) Current Debug Mode : %s%s\r\n"
+      "%sU%s) Mob AI Active Zone Ring : %s%d\r\n"
+      "%sV%s) Dormant Mob AI Cadence  : %s%s\r\n"
       "%sQ%s) Exit To The Main Menu\r\n"
       "Enter your choice : ",
       grn, nrm, cyn, OLC_CONFIG(d)->operation.DFLT_PORT, grn, nrm, cyn,
@@ -1501,7 +1529,7 @@ static void cedit_disp_operation_options(struct descriptor_data *d)
           : (OLC_CONFIG(d)->operation.debug_mode == 1
                  ? "BRIEF"
                  : (OLC_CONFIG(d)->operation.debug_mode == 2 ? "NORMAL" : "COMPLETE")),
-      grn, nrm);
+      grn, nrm, cyn, OLC_CONFIG(d)->operation.mob_active_ring, grn, nrm, cyn, cadence, grn, nrm);
 
   OLC_MODE(d) = CEDIT_OPERATION_OPTIONS_MENU;
 }
@@ -2552,6 +2580,20 @@ void cedit_parse(struct descriptor_data *d, char *arg)
       OLC_MODE(d) = CEDIT_DEBUG_MODE;
       return;
 
+    case 'u':
+    case 'U':
+      write_to_output(d, "Enter how many zones out from an occupied zone mobs stay fully active "
+                         "(0-10) : ");
+      OLC_MODE(d) = CEDIT_MOB_ACTIVE_RING;
+      return;
+
+    case 'v':
+    case 'V':
+      write_to_output(d, "Enter how many mobile cycles apart dormant mobs act "
+                         "(0: Always, -1: Never, up to 100) : ");
+      OLC_MODE(d) = CEDIT_MOB_DORMANT_CADENCE;
+      return;
+
     case 'q':
     case 'Q':
       cedit_disp_menu(d);
@@ -3353,6 +3395,16 @@ void cedit_parse(struct descriptor_data *d, char *arg)
     cedit_disp_operation_options(d);
     break;
 
+  case CEDIT_MOB_ACTIVE_RING:
+    OLC_CONFIG(d)->operation.mob_active_ring = LIMIT(atoi(arg), 0, 10);
+    cedit_disp_operation_options(d);
+    break;
+
+  case CEDIT_MOB_DORMANT_CADENCE:
+    OLC_CONFIG(d)->operation.mob_dormant_cadence = LIMIT(atoi(arg), -1, 100);
+    cedit_disp_operation_options(d);
+    break;
+
   case CEDIT_MIN_WIZLIST_LEV:
     if (atoi(arg) > LVL_IMPL)
     {
@@ -86,6 +86,10 @@ static int update_all_objects(struct obj_data *refobj)
     obj->autoproc_prev = NULL;
     obj->autoproc_registered = false;
     autoproc_registry_sync(obj);
+
+    /* Its APPLY_FEATs may have changed under the wearer's feat counts. */
+    if (obj->worn_by)
+      rebuild_equip_feats(obj->worn_by);
   }
 
   return count;
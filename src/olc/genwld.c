@@ -12,6 +12,7 @@
 #include "db.h"
 #include "handler.h"
 #include "comm.h"
+#include "graph.h"
 #include "genolc.h"
 #include "genwld.h"
 #include "genzon.h"
@@ -55,6 +56,9 @@ static room_rnum add_room_internal(struct room_data *room, bool persistent)
   if (room == NULL)
     return NOWHERE;
 
+  /* Saving a room can add, drop or retarget exits, or change its flags. */
+  graph_exits_changed();
+
   if ((i = real_room(room->number)) != NOWHERE)
   {
     if (!spec_binding_copy(&binding_copy, room->spec_binding, binding_error, sizeof(binding_error)))
@@ -227,6 +231,7 @@ static int delete_room_internal(room_rnum rnum, bool persistent)
   if (rnum <= 0 || rnum > top_of_world) /* Can't delete void yet. */
     return FALSE;
 
+  graph_exits_changed();
   room = &world[rnum];
 
   if (persistent)
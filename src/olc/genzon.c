@@ -262,6 +262,8 @@ zone_rnum create_new_zone(zone_vnum vzone_num, room_vnum bottom, room_vnum top,
   zone->min_level = -1;
   zone->max_level = -1;
   zone->show_weather = 1;
+  zone->presence = NULL; /* No rooms yet, so nobody in them */
+  zone->presence_count = 0;
 
   for (i = 0; i < ZN_ARRAY_MAX; i++)
     zone->zone_flags[i] = 0;
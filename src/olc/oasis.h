@@ -613,6 +613,8 @@ i added this trying to debug issues with qedit-copy -zusuk
 #define CEDIT_SET_SPELLCASTING_TIME_MODE 128
 #define CEDIT_SET_VESSEL_SYSTEM 129
 #define CEDIT_SET_AUTO_DL_MUDLET_PACKAGE 130
+#define CEDIT_MOB_ACTIVE_RING 131
+#define CEDIT_MOB_DORMANT_CADENCE 132
 
 /* Hedit Submodes of connectedness. */
 #define HEDIT_CONFIRM_SAVESTRING 0
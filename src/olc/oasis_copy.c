@@ -14,6 +14,7 @@
 #include "interpreter.h"
 #include "handler.h"
 #include "db.h"
+#include "graph.h"
 #include "obj/shop.h"
 #include "genshp.h"
 #include "genolc.h"
@@ -338,6 +339,7 @@ ACMD(do_dig)
     W_EXIT(rrnum, rev_dir[dir])->to_room = IN_ROOM(ch);
     add_to_save_list(zone_table[world[rrnum].zone].number, SL_WLD);
   }
+  graph_exits_changed();
 }
 
 /* BuildWalk - OasisOLC Extension by D. Tyler Barnes. */
@@ -496,6 +498,7 @@ int buildwalk(struct char_data *ch, int dir)
         /* Report room creation to user */
         send_to_char(ch, "%sRoom #%d created by BuildWalk.%s\r\n", yel, vnum, nrm);
       }
+      graph_exits_changed();
 
       cleanup_olc(d, CLEANUP_STRUCTS);
 
@@ -10,6 +10,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <pthread.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <sys/resource.h>
 #if defined(__GLIBC__)
@@ -325,6 +326,26 @@ static uint64_t prof_reset_wall_time_sec;
 static uint64_t logged_pulse_count;
 static uint64_t missed_pulse_count;
 static uint64_t vessel_message_throttled_count;
+static uint64_t zone_presence_checks;
+static uint64_t zone_presence_visited;
+static uint64_t zone_presence_scan_bound;
+static uint64_t object_save_rows_written;
+static uint64_t object_save_rows_unchanged;
+static uint64_t object_save_statements;
+static uint64_t player_saves;
+static uint64_t player_save_usec;
+static uint64_t player_save_max_usec;
+static uint64_t mccp_raw_bytes;
+static uint64_t mccp_compressed_bytes;
+static uint64_t netpoll_waits;
+static uint64_t netpoll_watched;
+static uint64_t netpoll_ready;
+static uint64_t msdp_emits[PERF_MSDP_VARIABLES];
+static const char *msdp_emit_names[PERF_MSDP_VARIABLES];
+static uint64_t mob_tier_visited[PERF_MOB_TIERS];
+static uint64_t mob_tier_acted[PERF_MOB_TIERS];
+static const char *const mob_tier_names[PERF_MOB_TIERS] = {"always", "occupied", "nearby",
+                                                           "dormant"};
 static struct perf_event_callback event_profiles[EVENT_PROFILE_CAPACITY];
 static size_t event_profile_count;
 static struct perf_event_callback event_profile_overflow;
@@ -347,6 +368,9 @@ static uint64_t sql_family_overflow_calls;
 static uint64_t sql_reconnect_attempts;
 static uint64_t sql_reconnect_successes;
 static uint64_t sql_reconnect_failures;
+static uint64_t sql_pool_waits;
+static uint64_t sql_pool_wait_usec;
+static uint64_t sql_pool_wait_max_usec;
 static pthread_mutex_t sql_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t perf_main_thread;
 static int perf_main_thread_set;
@@ -380,6 +404,7 @@ static uint64_t combat_rejected_procs;
 /* Pulse performance tracking */
 static double last_pulse = 0.0;
 static double max_pulse = 0.0;
+static uint64_t logged_pulse_usec;
 
 /* Performance data buffers */
 static struct perf_interval pulse_data;
@@ -629,6 +654,16 @@ void PERF_note_sql_query(const char *query, uint64_t elapsed_usec, int failed)
   pthread_mutex_unlock(&sql_stats_mutex);
 }
 
+void PERF_note_sql_pool_wait(uint64_t elapsed_usec)
+{
+  pthread_mutex_lock(&sql_stats_mutex);
+  sql_pool_waits = saturating_add_u64(sql_pool_waits, 1);
+  sql_pool_wait_usec = saturating_add_u64(sql_pool_wait_usec, elapsed_usec);
+  if (elapsed_usec > sql_pool_wait_max_usec)
+    sql_pool_wait_max_usec = elapsed_usec;
+  pthread_mutex_unlock(&sql_stats_mutex);
+}
+
 void PERF_note_sql_reconnect(int succeeded)
 {
   pthread_mutex_lock(&sql_stats_mutex);
@@ -706,6 +741,16 @@ static void insert_slow_section(struct perf_slow_pulse *record, const char *iden
   record->sections[position].elapsed_usec = elapsed_usec;
 }
 
+/* Convert a pulse's share of its budget to microseconds. */
+static uint64_t pulse_usage_usec(double usage_percent)
+{
+  if (usage_percent <= 0.0)
+    return 0;
+  if (usage_percent >= ((double)UINT64_MAX * 100.0 / (double)USEC_PER_PULSE))
+    return UINT64_MAX;
+  return (uint64_t)((usage_percent * (double)USEC_PER_PULSE) / 100.0);
+}
+
 static void capture_slow_pulse(double usage_percent)
 {
   struct perf_slow_pulse *record;
@@ -722,9 +767,7 @@ static void capture_slow_pulse(double usage_percent)
   record->wall_timestamp_sec = now_sec;
   record->monotonic_timestamp_usec = monotonic_usec();
   record->pulse_number = pulse_last_heartbeat;
-  record->duration_usec = usage_percent >= ((double)UINT64_MAX * 100.0 / (double)USEC_PER_PULSE)
-                              ? UINT64_MAX
-                              : (uint64_t)((usage_percent * (double)USEC_PER_PULSE) / 100.0);
+  record->duration_usec = pulse_usage_usec(usage_percent);
   record->schedule_flags = pulse_schedule_flags;
   pthread_mutex_lock(&sql_stats_mutex);
   record->sql_queries = pulse_main_sql_calls;
@@ -1161,8 +1204,26 @@ void PERF_reset(void)
   last_pulse = 0.0;
   max_pulse = 0.0;
   logged_pulse_count = 0;
+  logged_pulse_usec = 0;
   missed_pulse_count = 0;
   vessel_message_throttled_count = 0;
+  zone_presence_checks = 0;
+  zone_presence_visited = 0;
+  zone_presence_scan_bound = 0;
+  object_save_rows_written = 0;
+  object_save_rows_unchanged = 0;
+  object_save_statements = 0;
+  player_saves = 0;
+  player_save_usec = 0;
+  player_save_max_usec = 0;
+  mccp_raw_bytes = 0;
+  mccp_compressed_bytes = 0;
+  netpoll_waits = 0;
+  netpoll_watched = 0;
+  netpoll_ready = 0;
+  memset(msdp_emits, 0, sizeof(msdp_emits));
+  memset(mob_tier_visited, 0, sizeof(mob_tier_visited));
+  memset(mob_tier_acted, 0, sizeof(mob_tier_acted));
   pulse_schedule_flags = 0;
   pulse_last_heartbeat = 0;
   total_heartbeats_executed = 0;
@@ -1202,6 +1263,9 @@ void PERF_reset(void)
   sql_reconnect_attempts = 0;
   sql_reconnect_successes = 0;
   sql_reconnect_failures = 0;
+  sql_pool_waits = 0;
+  sql_pool_wait_usec = 0;
+  sql_pool_wait_max_usec = 0;
   perf_main_thread = pthread_self();
   perf_main_thread_set = 1;
   pthread_mutex_unlock(&sql_stats_mutex);
@@ -1264,6 +1328,7 @@ void PERF_log_pulse(double val)
 
   last_pulse = val;
   logged_pulse_count++;
+  logged_pulse_usec = saturating_add_u64(logged_pulse_usec, pulse_usage_usec(val));
 
   if (val > max_pulse)
   {
@@ -1385,6 +1450,151 @@ void PERF_note_catchup_pass(uint64_t requested_missed, uint64_t replayed_missed,
                        budget_exhausted);
 }
 
+void PERF_note_zone_presence_check(uint64_t visited, uint64_t scan_bound)
+{
+  zone_presence_checks++;
+  zone_presence_visited += visited;
+  zone_presence_scan_bound += scan_bound;
+}
+
+void PERF_zone_presence_stats(uint64_t *checks, uint64_t *visited, uint64_t *scan_bound)
+{
+  *checks = zone_presence_checks;
+  *visited = zone_presence_visited;
+  *scan_bound = zone_presence_scan_bound;
+}
+
+void PERF_note_object_save_rows(uint64_t written, uint64_t unchanged, uint64_t statements)
+{
+  object_save_rows_written += written;
+  object_save_rows_unchanged += unchanged;
+  object_save_statements += statements;
+}
+
+void PERF_object_save_row_stats(uint64_t *written, uint64_t *unchanged, uint64_t *statements)
+{
+  *written = object_save_rows_written;
+  *unchanged = object_save_rows_unchanged;
+  *statements = object_save_statements;
+}
+
+void PERF_note_player_save(uint64_t elapsed_usec)
+{
+  player_saves++;
+  player_save_usec += elapsed_usec;
+  if (elapsed_usec > player_save_max_usec)
+    player_save_max_usec = elapsed_usec;
+}
+
+void PERF_player_save_stats(uint64_t *saves, uint64_t *total_usec, uint64_t *max_usec)
+{
+  *saves = player_saves;
+  *total_usec = player_save_usec;
+  *max_usec = player_save_max_usec;
+}
+
+void PERF_note_mccp_output(uint64_t raw, uint64_t compressed)
+{
+  mccp_raw_bytes += raw;
+  mccp_compressed_bytes += compressed;
+}
+
+void PERF_mccp_output_stats(uint64_t *raw, uint64_t *compressed)
+{
+  *raw = mccp_raw_bytes;
+  *compressed = mccp_compressed_bytes;
+}
+
+void PERF_note_netpoll_wait(uint64_t watched, uint64_t ready)
+{
+  netpoll_waits++;
+  netpoll_watched += watched;
+  netpoll_ready += ready;
+}
+
+void PERF_netpoll_stats(uint64_t *waits, uint64_t *watched, uint64_t *ready)
+{
+  *waits = netpoll_waits;
+  *watched = netpoll_watched;
+  *ready = netpoll_ready;
+}
+
+void PERF_note_msdp_emit(int variable, const char *name)
+{
+  if (variable < 0 || variable >= PERF_MSDP_VARIABLES)
+    return;
+  msdp_emits[variable]++;
+  msdp_emit_names[variable] = name;
+}
+
+uint64_t PERF_msdp_emit_count(int variable)
+{
+  if (variable < 0 || variable >= PERF_MSDP_VARIABLES)
+    return 0;
+  return msdp_emits[variable];
+}
+
+/* "NAME=count" for every variable sent, space separated; with elapsed_usec,
+ * only the busiest few, as "NAME=rate/s". */
+static size_t format_msdp_emits(char *out_buf, size_t n, uint64_t elapsed_usec)
+{
+  bool shown[PERF_MSDP_VARIABLES] = {FALSE};
+  size_t written = 0;
+  int variable, best, listed;
+
+  for (listed = 0; written < n - 1; listed++)
+  {
+    if (elapsed_usec && listed == 5)
+      break;
+    best = -1;
+    for (variable = 0; variable < PERF_MSDP_VARIABLES; variable++)
+      if (msdp_emits[variable] && !shown[variable] &&
+          (best < 0 || msdp_emits[variable] > msdp_emits[best]))
+        best = variable;
+    if (best < 0)
+      break;
+    shown[best] = TRUE;
+
+    if (elapsed_usec)
+      written += bounded_format_length(
+          snprintf(out_buf + written, n - written, "%s%s=%.2f/s", listed ? " " : "",
+                   msdp_emit_names[best], msdp_emits[best] * 1000000.0 / elapsed_usec),
+          n - written);
+    else
+      written += bounded_format_length(snprintf(out_buf + written, n - written,
+                                                "%s%s=%" PRIu64, listed ? " " : "",
+                                                msdp_emit_names[best], msdp_emits[best]),
+                                       n - written);
+  }
+  return written;
+}
+
+void PERF_note_mob_activity(const uint64_t *visited, const uint64_t *acted)
+{
+  int tier;
+
+  for (tier = 0; tier < PERF_MOB_TIERS; tier++)
+  {
+    mob_tier_visited[tier] += visited[tier];
+    mob_tier_acted[tier] += acted[tier];
+  }
+}
+
+/* "name=visited/acted" for every tier, space separated. */
+static size_t format_mob_tiers(char *out_buf, size_t n)
+{
+  size_t written = 0;
+  int tier;
+
+  for (tier = 0; tier < PERF_MOB_TIERS && written < n - 1; tier++)
+    written += bounded_format_length(snprintf(out_buf + written, n - written,
+                                              "%s%s=%" PRIu64 "/%" PRIu64, tier ? " " : "",
+                                              mob_tier_names[tier], mob_tier_visited[tier],
+                                              mob_tier_acted[tier]),
+                                     n - written);
+  return written;
+}
+
 uint64_t PERF_missed_pulse_count(void)
 {
   return missed_pulse_count;
@@ -1490,6 +1700,92 @@ size_t PERF_repr(char *out_buf, size_t n)
         n - written);
   }
 
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "Zone presence: is_empty=%" PRIu64 " list_visits=%" PRIu64
+                 " descriptor_scan_bound=%" PRIu64 "\n\r",
+                 zone_presence_checks, zone_presence_visited, zone_presence_scan_bound),
+        n - written);
+  }
+
+  /* Rows per minute actually written, against what rewriting every owner's
+   * objects on every save would have written. */
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "Object save rows: written=%" PRIu64 " (%.1f/min) unchanged=%" PRIu64
+                 " without skipping=%.1f/min inserts=%" PRIu64 "\n\r",
+                 object_save_rows_written,
+                 elapsed_usec ? object_save_rows_written * 60000000.0 / elapsed_usec : 0.0,
+                 object_save_rows_unchanged,
+                 elapsed_usec ? (object_save_rows_written + object_save_rows_unchanged) *
+                                    60000000.0 / elapsed_usec
+                              : 0.0,
+                 object_save_statements),
+        n - written);
+  }
+
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "Player saves: %" PRIu64 " avg=%.1f usec max=%" PRIu64 " usec\n\r",
+                 player_saves, player_saves ? (double)player_save_usec / player_saves : 0.0,
+                 player_save_max_usec),
+        n - written);
+  }
+
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "MCCP output: %" PRIu64 " bytes sent as %" PRIu64 " (%.1f%%)\n\r",
+                 mccp_raw_bytes, mccp_compressed_bytes,
+                 mccp_raw_bytes ? mccp_compressed_bytes * 100.0 / mccp_raw_bytes : 0.0),
+        n - written);
+  }
+
+  if (written < n - 1 && netpoll_waits)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "Network poll: %" PRIu64 " waits, %.1f sockets watched and %.2f ready each\n\r",
+                 netpoll_waits, (double)netpoll_watched / netpoll_waits,
+                 (double)netpoll_ready / netpoll_waits),
+        n - written);
+  }
+
+  if (written < n - 1)
+  {
+    uint64_t msdp_total = 0;
+
+    for (i = 0; i < PERF_MSDP_VARIABLES; i++)
+      msdp_total += msdp_emits[i];
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written, "MSDP sent: %" PRIu64 " variables (%.1f/s) ",
+                 msdp_total, elapsed_usec ? msdp_total * 1000000.0 / elapsed_usec : 0.0),
+        n - written);
+    if (written < n - 1 && elapsed_usec)
+      written += format_msdp_emits(out_buf + written, n - written, elapsed_usec);
+    if (written < n - 1)
+      written += bounded_format_length(snprintf(out_buf + written, n - written, "\n\r"),
+                                       n - written);
+  }
+
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written, "Mob activity (visited/acted): "), n - written);
+    if (written < n - 1)
+      written += format_mob_tiers(out_buf + written, n - written);
+    if (written < n - 1)
+      written += bounded_format_length(snprintf(out_buf + written, n - written, "\n\r"),
+                                       n - written);
+  }
+
   return written;
 }
 
@@ -3222,6 +3518,70 @@ size_t PERF_prof_repr_csv(char *out_buf, size_t n)
                                               vessel_message_throttled_count),
                                      n - written);
   }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "# zone_presence_checks=%" PRIu64 " zone_presence_visits=%" PRIu64
+                 " zone_presence_scan_bound=%" PRIu64 "\n\r",
+                 zone_presence_checks, zone_presence_visited, zone_presence_scan_bound),
+        n - written);
+  }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "# object_save_rows_written=%" PRIu64 " object_save_rows_unchanged=%" PRIu64
+                 " object_save_inserts=%" PRIu64 "\n\r",
+                 object_save_rows_written, object_save_rows_unchanged, object_save_statements),
+        n - written);
+  }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "# player_saves=%" PRIu64 " player_save_usec=%" PRIu64
+                 " player_save_max_usec=%" PRIu64 "\n\r",
+                 player_saves, player_save_usec, player_save_max_usec),
+        n - written);
+  }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "# mccp_raw_bytes=%" PRIu64 " mccp_compressed_bytes=%" PRIu64 "\n\r",
+                 mccp_raw_bytes, mccp_compressed_bytes),
+        n - written);
+  }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written,
+                 "# netpoll_waits=%" PRIu64 " netpoll_watched=%" PRIu64 " netpoll_ready=%" PRIu64
+                 "\n\r",
+                 netpoll_waits, netpoll_watched, netpoll_ready),
+        n - written);
+  }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written, "# msdp_emits "), n - written);
+    if (written < n - 1)
+      written += format_msdp_emits(out_buf + written, n - written, 0);
+    if (written < n - 1)
+      written += bounded_format_length(snprintf(out_buf + written, n - written, "\n\r"),
+                                       n - written);
+  }
+  if (written < n - 1)
+  {
+    written += bounded_format_length(
+        snprintf(out_buf + written, n - written, "# mob_tiers "), n - written);
+    if (written < n - 1)
+      written += format_mob_tiers(out_buf + written, n - written);
+    if (written < n - 1)
+      written += bounded_format_length(snprintf(out_buf + written, n - written, "\n\r"),
+                                       n - written);
+  }
   if (written < n - 1)
     written += format_event_telemetry_csv(out_buf + written, n - written);
 
@@ -4196,3 +4556,228 @@ fail:
   log("SYSERR: PERFMON copyover snapshot failed during %s: %s", failure, strerror(saved_errno));
   return 0;
 }
+
+/* ========================================================================
+ * OPENMETRICS EXPORT
+ * ======================================================================== */
+
+/* Append one formatted piece of the exposition, bounded like the reports. */
+static size_t metrics_append(char *out_buf, size_t n, size_t written, const char *format, ...)
+{
+  va_list args;
+  int result;
+
+  if (written >= n - 1)
+    return written;
+  va_start(args, format);
+  result = vsnprintf(out_buf + written, n - written, format, args);
+  va_end(args);
+  return written + bounded_format_length(result, n - written);
+}
+
+/* Start a metric family: its TYPE and HELP lines. */
+static size_t metrics_family(char *out_buf, size_t n, size_t written, const char *name,
+                             const char *type, const char *help)
+{
+  return metrics_append(out_buf, n, written, "# TYPE %s %s\n# HELP %s %s\n", name, type, name,
+                        help);
+}
+
+/* Copy a label value with the escapes the text format requires. */
+static void metrics_label_value(char *destination, size_t capacity, const char *value)
+{
+  size_t length = 0;
+
+  for (; *value && length + 3 < capacity; value++)
+  {
+    if (*value == '\\' || *value == '"')
+      destination[length++] = '\\';
+    else if (*value == '\n')
+    {
+      destination[length++] = '\\';
+      destination[length++] = 'n';
+      continue;
+    }
+    destination[length++] = *value;
+  }
+  destination[length] = '\0';
+}
+
+size_t PERF_metrics_repr(char *out_buf, size_t n)
+{
+  static const char *const sql_threads[] = {"main", "worker"};
+  struct perf_sql_rollup sql[2];
+  struct PERF_prof_sect *sect;
+  uint64_t pool_waits, pool_wait_usec, pool_wait_max_usec;
+  uint64_t sample_age = 0;
+  char label[2 * sizeof(sect->id)];
+  size_t written = 0;
+  size_t threshold_count = sizeof(thresholds) / sizeof(thresholds[0]);
+  size_t i;
+  int s;
+
+  if (out_buf == NULL || n < 1)
+    return 0;
+  ensure_initialized();
+  out_buf[0] = '\0';
+
+  written = metrics_family(out_buf, n, written, "luminari_stats_reset_timestamp_seconds", "gauge",
+                           "When the counters below last started from zero.");
+  written = metrics_append(out_buf, n, written,
+                           "luminari_stats_reset_timestamp_seconds %" PRIu64 "\n",
+                           prof_reset_wall_time_sec);
+
+  /* The threshold counters are cumulative from the top, which is the
+   * histogram's buckets read the other way round. */
+  written = metrics_family(out_buf, n, written, "luminari_pulse_duration_seconds", "histogram",
+                           "Time spent running each game pulse.");
+  for (i = 0; i < threshold_count; i++)
+    written = metrics_append(
+        out_buf, n, written, "luminari_pulse_duration_seconds_bucket{le=\"%g\"} %" PRIu64 "\n",
+        (double)thresholds[i].threshold * USEC_PER_PULSE / 100.0 / USEC_PER_SEC,
+        logged_pulse_count - MIN(logged_pulse_count, thresholds[i].count));
+  written = metrics_append(out_buf, n, written,
+                           "luminari_pulse_duration_seconds_bucket{le=\"+Inf\"} %" PRIu64 "\n"
+                           "luminari_pulse_duration_seconds_count %" PRIu64 "\n"
+                           "luminari_pulse_duration_seconds_sum %.6f\n",
+                           logged_pulse_count, logged_pulse_count,
+                           (double)logged_pulse_usec / USEC_PER_SEC);
+
+  written = metrics_family(out_buf, n, written, "luminari_pulses_missed", "counter",
+                           "Heartbeats skipped because the loop ran late.");
+  written = metrics_append(out_buf, n, written, "luminari_pulses_missed_total %" PRIu64 "\n",
+                           missed_pulse_count);
+
+  written = metrics_family(out_buf, n, written, "luminari_section_seconds", "counter",
+                           "Time spent in each profiled section.");
+  for (s = 0; s < prof_section_count; s++)
+  {
+    sect = prof_sections[s];
+    metrics_label_value(label, sizeof(label), sect->id);
+    written = metrics_append(out_buf, n, written,
+                             "luminari_section_seconds_total{section=\"%s\"} %.6f\n", label,
+                             (double)sect->total_usec / USEC_PER_SEC);
+  }
+  written = metrics_family(out_buf, n, written, "luminari_section_calls", "counter",
+                           "Completed runs of each profiled section.");
+  for (s = 0; s < prof_section_count; s++)
+  {
+    sect = prof_sections[s];
+    metrics_label_value(label, sizeof(label), sect->id);
+    written = metrics_append(out_buf, n, written,
+                             "luminari_section_calls_total{section=\"%s\"} %" PRIu64 "\n", label,
+                             sect->total_exit_count);
+  }
+  written = metrics_family(out_buf, n, written, "luminari_section_max_seconds", "gauge",
+                           "Longest single run of each profiled section.");
+  for (s = 0; s < prof_section_count; s++)
+  {
+    sect = prof_sections[s];
+    metrics_label_value(label, sizeof(label), sect->id);
+    written = metrics_append(out_buf, n, written,
+                             "luminari_section_max_seconds{section=\"%s\"} %.6f\n", label,
+                             (double)sect->max_usec / USEC_PER_SEC);
+  }
+
+  pthread_mutex_lock(&sql_stats_mutex);
+  sql[0] = main_sql_stats;
+  sql[1] = worker_sql_stats;
+  pool_waits = sql_pool_waits;
+  pool_wait_usec = sql_pool_wait_usec;
+  pool_wait_max_usec = sql_pool_wait_max_usec;
+  pthread_mutex_unlock(&sql_stats_mutex);
+
+  written = metrics_family(out_buf, n, written, "luminari_sql_queries", "counter",
+                           "SQL queries run, by the thread that ran them.");
+  for (i = 0; i < 2; i++)
+    written = metrics_append(out_buf, n, written,
+                             "luminari_sql_queries_total{thread=\"%s\"} %" PRIu64 "\n",
+                             sql_threads[i], sql[i].calls);
+  written = metrics_family(out_buf, n, written, "luminari_sql_query_seconds", "counter",
+                           "Time spent running SQL queries.");
+  for (i = 0; i < 2; i++)
+    written = metrics_append(out_buf, n, written,
+                             "luminari_sql_query_seconds_total{thread=\"%s\"} %.6f\n",
+                             sql_threads[i], (double)sql[i].total_usec / USEC_PER_SEC);
+  written = metrics_family(out_buf, n, written, "luminari_sql_query_errors", "counter",
+                           "SQL queries that failed.");
+  for (i = 0; i < 2; i++)
+    written = metrics_append(out_buf, n, written,
+                             "luminari_sql_query_errors_total{thread=\"%s\"} %" PRIu64 "\n",
+                             sql_threads[i], sql[i].errors);
+  written = metrics_family(out_buf, n, written, "luminari_sql_pool_waits", "counter",
+                           "Times a thread waited for a free pooled connection.");
+  written = metrics_append(out_buf, n, written, "luminari_sql_pool_waits_total %" PRIu64 "\n",
+                           pool_waits);
+  written = metrics_family(out_buf, n, written, "luminari_sql_pool_wait_seconds", "counter",
+                           "Time spent waiting for a free pooled connection.");
+  written = metrics_append(out_buf, n, written, "luminari_sql_pool_wait_seconds_total %.6f\n",
+                           (double)pool_wait_usec / USEC_PER_SEC);
+  written = metrics_family(out_buf, n, written, "luminari_sql_pool_wait_max_seconds", "gauge",
+                           "Longest wait for a free pooled connection.");
+  written = metrics_append(out_buf, n, written, "luminari_sql_pool_wait_max_seconds %.6f\n",
+                           (double)pool_wait_max_usec / USEC_PER_SEC);
+
+  written = metrics_family(out_buf, n, written, "luminari_event_queue_depth", "gauge",
+                           "Events queued after the last event pass.");
+  written = metrics_append(out_buf, n, written, "luminari_event_queue_depth %" PRIu64 "\n",
+                           total_event_process_stats.latest_depth);
+  written = metrics_family(out_buf, n, written, "luminari_event_queue_max_depth", "gauge",
+                           "Most events queued before any event pass.");
+  written = metrics_append(out_buf, n, written, "luminari_event_queue_max_depth %" PRIu64 "\n",
+                           total_event_process_stats.max_depth_before);
+  written = metrics_family(out_buf, n, written, "luminari_event_callbacks", "counter",
+                           "Event callbacks run.");
+  written = metrics_append(out_buf, n, written, "luminari_event_callbacks_total %" PRIu64 "\n",
+                           total_event_process_stats.callbacks_processed);
+
+  written = metrics_family(out_buf, n, written, "luminari_entities_created", "counter",
+                           "Mobiles and objects created.");
+  written = metrics_append(out_buf, n, written,
+                           "luminari_entities_created_total{kind=\"mobile\"} %" PRIu64 "\n"
+                           "luminari_entities_created_total{kind=\"object\"} %" PRIu64 "\n",
+                           mobiles_created_total, objects_created_total);
+  written = metrics_family(out_buf, n, written, "luminari_entities_extracted", "counter",
+                           "Mobiles and objects extracted.");
+  written = metrics_append(out_buf, n, written,
+                           "luminari_entities_extracted_total{kind=\"mobile\"} %" PRIu64 "\n"
+                           "luminari_entities_extracted_total{kind=\"object\"} %" PRIu64 "\n",
+                           mobiles_extracted_total, objects_extracted_total);
+
+  /* Counts come from the last periodic memory sample, not a fresh walk. */
+  if (latest_memory_stats_valid)
+  {
+    if ((uint64_t)time(NULL) >= latest_memory_stats.timestamp_sec)
+      sample_age = (uint64_t)time(NULL) - latest_memory_stats.timestamp_sec;
+    written = metrics_family(out_buf, n, written, "luminari_sample_age_seconds", "gauge",
+                             "Age of the sample the counts below were taken from.");
+    written = metrics_append(out_buf, n, written, "luminari_sample_age_seconds %" PRIu64 "\n",
+                             sample_age);
+    written = metrics_family(out_buf, n, written, "luminari_descriptors", "gauge",
+                             "Connections, and those playing.");
+    written = metrics_append(out_buf, n, written,
+                             "luminari_descriptors{state=\"connected\"} %" PRIu64 "\n"
+                             "luminari_descriptors{state=\"playing\"} %" PRIu64 "\n",
+                             latest_memory_stats.count_descriptors,
+                             latest_memory_stats.count_playing);
+    written = metrics_family(out_buf, n, written, "luminari_entities", "gauge",
+                             "Entities in the world.");
+    written = metrics_append(
+        out_buf, n, written,
+        "luminari_entities{kind=\"player\"} %" PRIu64 "\n"
+        "luminari_entities{kind=\"mobile\"} %" PRIu64 "\n"
+        "luminari_entities{kind=\"object\"} %" PRIu64 "\n"
+        "luminari_entities{kind=\"affect\"} %" PRIu64 "\n"
+        "luminari_entities{kind=\"event\"} %" PRIu64 "\n"
+        "luminari_entities{kind=\"pending_extraction\"} %" PRIu64 "\n",
+        latest_memory_stats.count_pcs, latest_memory_stats.count_mobs,
+        latest_memory_stats.count_objs, latest_memory_stats.count_affects,
+        latest_memory_stats.count_events, latest_memory_stats.count_pending_extractions);
+    written = metrics_family(out_buf, n, written, "luminari_resident_memory_bytes", "gauge",
+                             "Resident set size of the process.");
+    written = metrics_append(out_buf, n, written, "luminari_resident_memory_bytes %" PRIu64 "\n",
+                             latest_memory_stats.vm_rss_kib * 1024);
+  }
+
+  return metrics_append(out_buf, n, written, "# EOF\n");
+}
@@ -103,6 +103,98 @@ void PERF_note_missed_pulses(uint64_t count);
  */
 void PERF_note_vessel_message_throttled(void);
 
+/**
+ * @brief Record one is_empty() answered from a zone presence list
+ *
+ * @param visited Presence-list entries looked at
+ * @param scan_bound Characters the old descriptor scan could have walked
+ */
+void PERF_note_zone_presence_check(uint64_t visited, uint64_t scan_bound);
+
+/**
+ * @brief Read the is_empty() counters since the last reset
+ */
+void PERF_zone_presence_stats(uint64_t *checks, uint64_t *visited, uint64_t *scan_bound);
+
+/**
+ * @brief Record saved object rows for a player or house
+ *
+ * @param written Rows sent to player_save_objs or house_data
+ * @param unchanged Rows left in place because the owner's objects had not changed
+ * @param statements INSERT statements the written rows took
+ */
+void PERF_note_object_save_rows(uint64_t written, uint64_t unchanged, uint64_t statements);
+
+/**
+ * @brief Read the object save row counters since the last reset
+ */
+void PERF_object_save_row_stats(uint64_t *written, uint64_t *unchanged, uint64_t *statements);
+
+/**
+ * @brief Record one player file formatted on the game thread
+ *
+ * @param elapsed_usec Time from the start of save_char until the image was handed off
+ */
+void PERF_note_player_save(uint64_t elapsed_usec);
+
+/**
+ * @brief Read the player save counters since the last reset
+ */
+void PERF_player_save_stats(uint64_t *saves, uint64_t *total_usec, uint64_t *max_usec);
+
+/**
+ * @brief Record text deflated onto an MCCP2 stream
+ *
+ * @param raw Bytes of text that went in
+ * @param compressed Bytes of stream that came out
+ */
+void PERF_note_mccp_output(uint64_t raw, uint64_t compressed);
+
+/**
+ * @brief Read the MCCP2 output counters since the last reset
+ */
+void PERF_mccp_output_stats(uint64_t *raw, uint64_t *compressed);
+
+/**
+ * @brief Record one wait of the network poller
+ *
+ * @param watched Sockets registered with it
+ * @param ready Sockets it reported ready
+ */
+void PERF_note_netpoll_wait(uint64_t watched, uint64_t ready);
+
+/**
+ * @brief Read the network poll counters since the last reset
+ */
+void PERF_netpoll_stats(uint64_t *waits, uint64_t *watched, uint64_t *ready);
+
+/* MSDP variables counted on their own; protocol.h's eMSDP_MAX is below it. */
+#define PERF_MSDP_VARIABLES 128
+
+/**
+ * @brief Record one MSDP or GMCP variable sent to a client
+ *
+ * @param variable Its eMSDP_* index
+ * @param name Its name as sent, used in the reports
+ */
+void PERF_note_msdp_emit(int variable, const char *name);
+
+/**
+ * @brief Read how many times a variable has been sent since the last reset
+ */
+uint64_t PERF_msdp_emit_count(int variable);
+
+/* Mobile activity tiers, in MOB_TIER_* order (mob/mob_dormancy.h). */
+#define PERF_MOB_TIERS 4
+
+/**
+ * @brief Record one mobile_activity slice
+ *
+ * @param visited Mobiles looked at, per tier
+ * @param acted Mobiles that got their AI, per tier
+ */
+void PERF_note_mob_activity(const uint64_t *visited, const uint64_t *acted);
+
 /**
  * @brief Return the current monotonic clock value in microseconds
  */
@@ -196,6 +288,9 @@ void PERF_note_sql_query(const char *query, uint64_t elapsed_usec, int failed);
 /** Record a reconnect attempt and whether it restored service. */
 void PERF_note_sql_reconnect(int succeeded);
 
+/** Record time a thread spent waiting for a free pooled connection. */
+void PERF_note_sql_pool_wait(uint64_t elapsed_usec);
+
 /** Format cumulative SQL latency and normalized-family telemetry. */
 size_t PERF_sql_repr(char *out_buf, size_t n, int csv);
 
@@ -434,6 +529,27 @@ void PERF_memory_periodic_check(void);
 int PERF_memory_growth_rate(double *rss_kib_per_min, double *anon_kib_per_min,
                             double *heap_kib_per_min);
 
+/* ========================================================================
+ * OPENMETRICS EXPORT
+ * ======================================================================== */
+
+/** Content type of PERF_metrics_repr() output, for an HTTP response. */
+#define PERF_METRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+/**
+ * @brief Generate the counters and gauges in OpenMetrics text format
+ *
+ * Reads only what perfmon has already aggregated: pulse durations as a
+ * histogram, profiled sections, SQL and pool waits, the event queue, and the
+ * entity counts from the latest memory sample.  Nothing is sampled or
+ * walked, so a scrape costs a small fraction of a pulse.
+ *
+ * @param out_buf Buffer to write to
+ * @param n Size of buffer
+ * @return Number of characters written, ending "# EOF\n" unless truncated
+ */
+size_t PERF_metrics_repr(char *out_buf, size_t n);
+
 /* ========================================================================
  * CONVENIENCE MACROS
  * ======================================================================== */
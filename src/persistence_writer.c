@@ -0,0 +1,464 @@
+/**
+ * @file persistence_writer.c
+ * @brief Background writer for player files and object saves
+ *
+ * See persistence_writer.h.  The writer thread only touches the jobs it is
+ * handed and its own connection; everything about the game, including the
+ * log, stays on the game thread, so a failure is described in job->error
+ * and logged when the job is drained.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "mysql.h"
+#include "perfmon.h"
+#include "persistence_writer.h"
+
+#include <sys/stat.h>
+
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_wake = PTHREAD_COND_INITIALIZER; /* work queued, or stop */
+static pthread_cond_t writer_idle = PTHREAD_COND_INITIALIZER; /* a job finished */
+static pthread_t writer_thread;
+static bool writer_running;
+static bool writer_stopping;
+static MYSQL_POOL_CONN *writer_connection;
+
+static struct persistence_write *queue_head, *queue_tail;
+static struct persistence_write *finished_head, *finished_tail;
+static struct persistence_write *in_flight;
+static struct persistence_writer_stats writer_stats;
+
+#ifdef LUMINARI_CUTEST
+static unsigned long writer_test_latency_usec;
+
+void persistence_writer_test_latency(unsigned long usec)
+{
+  writer_test_latency_usec = usec;
+}
+#endif
+
+struct persistence_write *persistence_write_new(const char *what, long idnum,
+                                                persistence_write_done done)
+{
+  struct persistence_write *job;
+
+  CREATE(job, struct persistence_write, 1);
+  job->what = what;
+  job->idnum = idnum;
+  job->done = done;
+  job->sql_category = PERF_SQL_OTHER;
+  return job;
+}
+
+void persistence_write_file(struct persistence_write *job, const char *path, char *data,
+                            size_t length)
+{
+  free(job->path);
+  free(job->data);
+  job->path = strdup(path);
+  job->data = data;
+  job->length = length;
+}
+
+void persistence_write_sql(struct persistence_write *job, const char *statement)
+{
+  if (job->statement_count == job->statement_capacity)
+  {
+    job->statement_capacity = MAX(8, job->statement_capacity * 2);
+    RECREATE(job->statements, char *, job->statement_capacity);
+  }
+  job->statements[job->statement_count++] = strdup(statement);
+}
+
+void persistence_write_free(struct persistence_write *job)
+{
+  int i;
+
+  if (job == NULL)
+    return;
+  for (i = 0; i < job->statement_count; i++)
+    free(job->statements[i]);
+  free(job->statements);
+  free(job->path);
+  free(job->data);
+  free(job);
+}
+
+static bool write_fail(struct persistence_write *job, const char *step, const char *detail)
+{
+  job->failed = TRUE;
+  snprintf(job->error, sizeof(job->error), "%s%s%s", step, detail ? ": " : "",
+           detail ? detail : "");
+  return FALSE;
+}
+
+/* Write the image beside its destination, get it to disk and rename it over
+ * the old file, so a crash leaves either the old save or the new one. */
+static bool write_install_file(struct persistence_write *job)
+{
+  char temp_name[MAX_FILEPATH + 32];
+  struct stat old_stat;
+  size_t done = 0;
+  ssize_t written;
+  int fd;
+
+  if (snprintf(temp_name, sizeof(temp_name), "%s.rename-tmp.XXXXXX", job->path) >=
+      (int)sizeof(temp_name))
+    return write_fail(job, "path too long", job->path);
+  if ((fd = mkstemp(temp_name)) < 0)
+    return write_fail(job, "create temporary file", strerror(errno));
+
+  /* Keep the owner and mode of the file being replaced, and never replace
+   * a link or anything else that is not a plain file; mkstemp() makes 0600,
+   * and a new file gets what fopen_restricted() would give it. */
+  if (lstat(job->path, &old_stat) == 0)
+  {
+    if (!S_ISREG(old_stat.st_mode) || fchown(fd, old_stat.st_uid, old_stat.st_gid) != 0 ||
+        fchmod(fd, old_stat.st_mode & 07777) != 0)
+    {
+      write_fail(job, "keep permissions",
+                 S_ISREG(old_stat.st_mode) ? strerror(errno) : "not a regular file");
+      close(fd);
+      unlink(temp_name);
+      return FALSE;
+    }
+  }
+  else if (errno != ENOENT)
+  {
+    write_fail(job, "inspect file", strerror(errno));
+    close(fd);
+    unlink(temp_name);
+    return FALSE;
+  }
+  else if (fchmod(fd, 0640) != 0)
+  {
+    write_fail(job, "set permissions", strerror(errno));
+    close(fd);
+    unlink(temp_name);
+    return FALSE;
+  }
+
+  while (done < job->length)
+  {
+    written = write(fd, job->data + done, job->length - done);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+    {
+      write_fail(job, "write", written < 0 ? strerror(errno) : "short write");
+      close(fd);
+      unlink(temp_name);
+      return FALSE;
+    }
+    done += (size_t)written;
+  }
+
+  if (fsync(fd) != 0)
+  {
+    write_fail(job, "fsync", strerror(errno));
+    close(fd);
+    unlink(temp_name);
+    return FALSE;
+  }
+  if (close(fd) != 0)
+  {
+    write_fail(job, "close", strerror(errno));
+    unlink(temp_name);
+    return FALSE;
+  }
+  if (rename(temp_name, job->path) != 0)
+  {
+    write_fail(job, "rename", strerror(errno));
+    unlink(temp_name);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static bool write_query(struct persistence_write *job, MYSQL *db, const char *statement)
+{
+  if (mysql_query(db, statement) == 0)
+    return TRUE;
+  return write_fail(job, "query", db ? mysql_error(db) : "failed");
+}
+
+static bool write_run_statements(struct persistence_write *job, MYSQL *db)
+{
+  bool transaction = job->statement_count > 1;
+  int i;
+
+#ifndef LUMINARI_CUTEST
+  /* The unit tests' query seam answers without a connection. */
+  if (db == NULL)
+    return write_fail(job, "no database connection", NULL);
+#endif
+  if (transaction && !write_query(job, db, "start transaction;"))
+    return FALSE;
+  for (i = 0; i < job->statement_count; i++)
+    if (!write_query(job, db, job->statements[i]))
+    {
+      if (transaction)
+        mysql_query(db, "rollback;");
+      return FALSE;
+    }
+  if (transaction && !write_query(job, db, "commit;"))
+  {
+    mysql_query(db, "rollback;");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static void write_run(struct persistence_write *job, MYSQL *db)
+{
+  enum perf_sql_category previous;
+
+#ifdef LUMINARI_CUTEST
+  if (writer_test_latency_usec > 0)
+    usleep(writer_test_latency_usec);
+#endif
+  if (job->path && !write_install_file(job))
+    return;
+  if (job->statement_count > 0)
+  {
+    previous = PERF_sql_scope_set(job->sql_category);
+    write_run_statements(job, db);
+    PERF_sql_scope_restore(previous);
+  }
+}
+
+/* Called with writer_mutex held. */
+static void write_note_finished(unsigned long long elapsed_usec, bool failed)
+{
+  if (failed)
+    writer_stats.failed++;
+  else
+    writer_stats.written++;
+  writer_stats.total_usec += elapsed_usec;
+  if (elapsed_usec > writer_stats.max_usec)
+    writer_stats.max_usec = elapsed_usec;
+}
+
+static void *persistence_writer_thread(void *arg)
+{
+  struct persistence_write *job;
+  MYSQL *db = writer_connection ? writer_connection->conn : NULL;
+  uint64_t started;
+
+  (void)arg;
+  pthread_mutex_lock(&writer_mutex);
+  for (;;)
+  {
+    while (queue_head == NULL && !writer_stopping)
+      pthread_cond_wait(&writer_wake, &writer_mutex);
+    if (queue_head == NULL)
+      break;
+
+    job = queue_head;
+    if ((queue_head = job->next) == NULL)
+      queue_tail = NULL;
+    job->next = NULL;
+    writer_stats.queued--;
+    in_flight = job;
+    pthread_mutex_unlock(&writer_mutex);
+
+    started = PERF_monotonic_usec();
+    write_run(job, db);
+
+    pthread_mutex_lock(&writer_mutex);
+    write_note_finished(PERF_monotonic_usec() - started, job->failed);
+    in_flight = NULL;
+    job->finished = TRUE;
+    if (!job->waited)
+    {
+      if (finished_tail)
+        finished_tail->next = job;
+      else
+        finished_head = job;
+      finished_tail = job;
+    }
+    pthread_cond_broadcast(&writer_idle);
+  }
+  pthread_mutex_unlock(&writer_mutex);
+  return NULL;
+}
+
+/* Log a failure and let the saver react, then let the job go. */
+static void write_complete(struct persistence_write *job, struct char_data *ch)
+{
+  if (job->failed)
+    log("SYSERR: Could not save %s%s%s: %s", job->what, job->path ? " " : "",
+        job->path ? job->path : "", job->error);
+  if (job->done)
+    job->done(job, ch);
+  persistence_write_free(job);
+}
+
+bool persistence_writer_submit(struct persistence_write *job, struct char_data *ch, bool wait)
+{
+  uint64_t started;
+  bool ok;
+
+  pthread_mutex_lock(&writer_mutex);
+  writer_stats.submitted++;
+  if (!writer_running)
+  {
+    writer_stats.inline_writes++;
+    pthread_mutex_unlock(&writer_mutex);
+
+    started = PERF_monotonic_usec();
+    write_run(job, conn);
+    pthread_mutex_lock(&writer_mutex);
+    write_note_finished(PERF_monotonic_usec() - started, job->failed);
+    pthread_mutex_unlock(&writer_mutex);
+  }
+  else
+  {
+    job->waited = wait;
+    if (queue_tail)
+      queue_tail->next = job;
+    else
+      queue_head = job;
+    queue_tail = job;
+    if (++writer_stats.queued > writer_stats.peak_queued)
+      writer_stats.peak_queued = writer_stats.queued;
+    pthread_cond_signal(&writer_wake);
+    if (!wait)
+    {
+      pthread_mutex_unlock(&writer_mutex);
+      return TRUE;
+    }
+    while (!job->finished)
+      pthread_cond_wait(&writer_idle, &writer_mutex);
+    pthread_mutex_unlock(&writer_mutex);
+  }
+
+  ok = !job->failed;
+  write_complete(job, ch);
+  return ok;
+}
+
+/* The player a finished save belongs to, if they are still about. */
+static struct char_data *write_find_player(long idnum)
+{
+  struct char_data *ch;
+
+  if (idnum <= 0)
+    return NULL;
+  for (ch = character_list; ch; ch = ch->next)
+    if (!IS_NPC(ch) && GET_IDNUM(ch) == idnum)
+      return ch;
+  return NULL;
+}
+
+void persistence_writer_drain(void)
+{
+  struct persistence_write *job, *next;
+
+  pthread_mutex_lock(&writer_mutex);
+  job = finished_head;
+  finished_head = finished_tail = NULL;
+  pthread_mutex_unlock(&writer_mutex);
+
+  for (; job; job = next)
+  {
+    next = job->next;
+    job->next = NULL;
+    write_complete(job, write_find_player(job->idnum));
+  }
+}
+
+void persistence_writer_flush(void)
+{
+  pthread_mutex_lock(&writer_mutex);
+  while (queue_head != NULL || in_flight != NULL)
+    pthread_cond_wait(&writer_idle, &writer_mutex);
+  pthread_mutex_unlock(&writer_mutex);
+}
+
+bool persistence_writer_start(void)
+{
+  if (writer_running)
+    return TRUE;
+
+  /* Its own connection, never one of the legacy handles the game thread
+   * queries through. */
+  writer_connection = NULL;
+  if (mysql_available && (writer_connection = mysql_pool_acquire()) == NULL)
+  {
+    log("SYSERR: Persistence writer could not get a database connection; saving inline.");
+    return FALSE;
+  }
+
+  writer_stopping = FALSE;
+  if (pthread_create(&writer_thread, NULL, persistence_writer_thread, NULL) != 0)
+  {
+    log("SYSERR: Unable to start the persistence writer thread; saving inline.");
+    if (writer_connection)
+      mysql_pool_release(writer_connection);
+    writer_connection = NULL;
+    return FALSE;
+  }
+  pthread_mutex_lock(&writer_mutex);
+  writer_running = TRUE;
+  pthread_mutex_unlock(&writer_mutex);
+  return TRUE;
+}
+
+void persistence_writer_stop(void)
+{
+  if (!writer_running)
+    return;
+
+  pthread_mutex_lock(&writer_mutex);
+  writer_stopping = TRUE;
+  pthread_cond_signal(&writer_wake);
+  pthread_mutex_unlock(&writer_mutex);
+  pthread_join(writer_thread, NULL);
+
+  pthread_mutex_lock(&writer_mutex);
+  writer_running = FALSE;
+  pthread_mutex_unlock(&writer_mutex);
+  if (writer_connection)
+    mysql_pool_release(writer_connection);
+  writer_connection = NULL;
+  persistence_writer_drain();
+}
+
+void persistence_writer_get_stats(struct persistence_writer_stats *stats)
+{
+  pthread_mutex_lock(&writer_mutex);
+  *stats = writer_stats;
+  stats->running = writer_running;
+  pthread_mutex_unlock(&writer_mutex);
+}
+
+size_t persistence_writer_repr(char *out_buf, size_t n)
+{
+  struct persistence_writer_stats stats;
+  unsigned long long finished;
+  int result;
+
+  if (out_buf == NULL || n == 0)
+    return 0;
+  persistence_writer_get_stats(&stats);
+  finished = stats.written + stats.failed;
+  result = snprintf(out_buf, n,
+                    "Writer: %s queued=%d peak=%d submitted=%llu written=%llu failed=%llu "
+                    "inline=%llu avg_write=%llu usec max_write=%llu usec\n\r",
+                    stats.running ? "thread" : "inline", stats.queued, stats.peak_queued,
+                    stats.submitted, stats.written, stats.failed, stats.inline_writes,
+                    finished ? stats.total_usec / finished : 0, stats.max_usec);
+  if (result < 0)
+  {
+    out_buf[0] = '\0';
+    return 0;
+  }
+  if ((size_t)result >= n)
+    return n - 1;
+  return (size_t)result;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file persistence_writer.h
+ * @brief Background writer for player files and object saves
+ *
+ * Saving used to format, write, flush and run its SQL on the game thread,
+ * so one slow disk or database stall froze every player.  Savers now take
+ * a snapshot on the game thread: the bytes of the file they would write
+ * and the statements they would send.  They hand it to the persistence
+ * writer, whose thread installs the file (temporary file, fsync, rename)
+ * and runs the statements as one transaction on a pooled connection of
+ * its own.
+ *
+ * Writes are done one at a time in the order they were submitted, so a
+ * later save of the same file always lands last.  Each finished write
+ * comes back to the game thread through persistence_writer_drain(), which
+ * logs failures and calls the saver's done callback to retry or to record
+ * what is now on disk.  Until persistence_writer_start() is called (at boot,
+ * in the unit tests, after shutdown) submit writes inline instead.
+ *
+ * Anything that reads or replaces a file the writer might still be writing
+ * calls persistence_writer_flush() first.
+ */
+
+#ifndef LUMINARI_PERSISTENCE_WRITER_H
+#define LUMINARI_PERSISTENCE_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "perfmon.h"
+
+struct char_data;
+struct persistence_write;
+
+/** Called on the game thread once a write has finished.  ch is the saved
+ * player if they are still in the game, otherwise NULL. */
+typedef void (*persistence_write_done)(struct persistence_write *job, struct char_data *ch);
+
+/* One snapshot: an optional file image, then optional SQL statements. */
+struct persistence_write
+{
+  const char *what; /* "player file", for log messages */
+  long idnum;       /* Whose save this is; 0 for none */
+  enum perf_sql_category sql_category;
+  persistence_write_done done;
+  unsigned long long sequence;    /* The saver's own bookkeeping, handed back */
+  unsigned long long fingerprint; /* untouched by the writer */
+
+  char *path; /* Installed atomically when set */
+  char *data;
+  size_t length;
+  char **statements; /* Run as one transaction when there is more than one */
+  int statement_count, statement_capacity;
+
+  bool failed;
+  char error[256];
+
+  /* Writer bookkeeping. */
+  bool waited, finished;
+  struct persistence_write *next;
+};
+
+struct persistence_writer_stats
+{
+  unsigned long long submitted, written, failed, inline_writes;
+  unsigned long long total_usec, max_usec; /* Time spent writing */
+  int queued, peak_queued;
+  bool running;
+};
+
+/** @brief Start a write for idnum; done may be NULL. */
+struct persistence_write *persistence_write_new(const char *what, long idnum,
+                                                persistence_write_done done);
+/** @brief Have the job install data (taken over, freed later) at path. */
+void persistence_write_file(struct persistence_write *job, const char *path, char *data,
+                            size_t length);
+/** @brief Append a copy of statement to the job's transaction. */
+void persistence_write_sql(struct persistence_write *job, const char *statement);
+/** @brief Free a job that was never submitted. */
+void persistence_write_free(struct persistence_write *job);
+
+/**
+ * @brief Hand job to the writer, which owns it from here on.
+ *
+ * With wait set, or with no writer running, the write is done before this
+ * returns, done is called with ch, and the result says whether it worked.
+ * Otherwise the job is queued and TRUE only means that.
+ */
+bool persistence_writer_submit(struct persistence_write *job, struct char_data *ch, bool wait);
+/** @brief Run the done callbacks of finished writes; game thread only. */
+void persistence_writer_drain(void);
+/** @brief Block until every submitted write has finished. */
+void persistence_writer_flush(void);
+
+/** @brief Start the writer thread; FALSE leaves writes inline. */
+bool persistence_writer_start(void);
+/** @brief Finish the queue, stop the thread and drain what it finished. */
+void persistence_writer_stop(void);
+
+void persistence_writer_get_stats(struct persistence_writer_stats *stats);
+/** @brief Describe the writer for the persistence report; returns the length. */
+size_t persistence_writer_repr(char *out_buf, size_t n);
+
+#ifdef LUMINARI_CUTEST
+/** @brief Make every write sleep first, standing in for a slow disk. */
+void persistence_writer_test_latency(unsigned long usec);
+#endif
+
+#endif /* LUMINARI_PERSISTENCE_WRITER_H */
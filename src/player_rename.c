@@ -19,6 +19,7 @@
 #include "net/protocol.h"
 #include "movement/movement_tracks.h"
 #include "vessels/vessels.h"
+#include "persistence_writer.h"
 #include "player_rename.h"
 
 #include <errno.h>
@@ -925,6 +926,8 @@ static int rename_plan_files(struct rename_context *ctx)
   struct stat new_stat;
   int modes[MAX_FILES] = {PLR_FILE, CRASH_FILE, SCRIPT_VARS_FILE, ETEXT_FILE};
 
+  /* Plan around the files as the last save left them. */
+  persistence_writer_flush();
   for (i = 0; i < MAX_FILES; i++)
   {
     ctx->files[i].mode = modes[i];
@@ -2296,6 +2299,7 @@ static int rename_change_memory(struct rename_context *ctx)
   ctx->old_player_index_name = player_table[ctx->player_index_position].name;
   ctx->old_victim_name = GET_PC_NAME(ctx->victim);
   player_table[ctx->player_index_position].name = ctx->new_player_index_name;
+  player_index_name_changed(ctx->player_index_position, ctx->old_player_index_name);
   GET_PC_NAME(ctx->victim) = ctx->new_victim_name;
   ctx->memory_changed = TRUE;
   return TRUE;
@@ -2632,6 +2636,7 @@ static int rename_rollback(struct rename_context *ctx)
   if (ctx->memory_changed)
   {
     player_table[ctx->player_index_position].name = ctx->old_player_index_name;
+    player_index_name_changed(ctx->player_index_position, ctx->new_player_index_name);
     GET_PC_NAME(ctx->victim) = ctx->old_victim_name;
     free(ctx->new_player_index_name);
     free(ctx->new_victim_name);
@@ -45,6 +45,7 @@
 #include "vessels/vessels.h"
 #include "bardic_performance.h"
 #include "perfmon.h"
+#include "persistence_writer.h"
 #include <stdint.h>
 #include <sys/time.h>
 #include <sys/stat.h>
@@ -179,6 +180,395 @@ void autoroll_mob(struct char_data *mob, bool realmode, bool summoned);
 bool pet_save_objs(struct char_data *ch, struct char_data *owner, long int pet_idnum);
 void pet_load_objs(struct char_data *ch, struct char_data *owner, long int pet_idnum);
 
+/* Hashes over player_table: lowercased name to position and idnum to
+ * position, so the lookups below do not walk the whole index.  Both are
+ * open-addressing tables in the style of the DG UID table: Robin Hood
+ * ordered, with backward-shift removal and doubling before 7/8 full.  A
+ * name or id held by more than one entry maps to the lowest position, as
+ * the linear scans did.  Unnamed entries and ids of 0 or less are left out.
+ *
+ * Code that renames an entry or assigns its id tells the index through
+ * player_index_name_changed() and player_index_id_changed(); code that moves
+ * entries about calls player_index_rebuild().  The index also remembers the
+ * table it was built for and rebuilds itself if that has been swapped out
+ * from under it, as the unit tests do. */
+#define PLAYER_INDEX_MIN_SLOTS 1024
+
+struct player_index_slot
+{
+  unsigned long key; /* Name hash or idnum */
+  int pos;           /* Position in player_table */
+  unsigned int dist; /* 1 + slots from its home slot; 0 when empty */
+};
+
+struct player_index_hash
+{
+  struct player_index_slot *slots;
+  size_t size; /* Slots, a power of two */
+  int shift;   /* 64 - log2(size) */
+  size_t count;
+};
+
+static struct
+{
+  struct player_index_hash names, ids;
+  /* What the hashes were built for */
+  const struct player_index_element *table;
+  int top;
+  const char *first_name, *last_name;
+} player_index;
+
+static unsigned long player_name_hash(const char *name)
+{
+  uint64_t hash = UINT64_C(14695981039346656037);
+
+  for (; *name; name++)
+    hash = (hash ^ (unsigned char)LOWER(*name)) * UINT64_C(1099511628211);
+  return (unsigned long)hash;
+}
+
+static inline size_t player_index_home(const struct player_index_hash *h, unsigned long key)
+{
+  return (size_t)(((uint64_t)key * UINT64_C(11400714819323198485)) >> h->shift);
+}
+
+static void player_index_alloc(struct player_index_hash *h, size_t size)
+{
+  h->size = size;
+  for (h->shift = 64; size > 1; size >>= 1)
+    h->shift--;
+  CREATE(h->slots, struct player_index_slot, h->size);
+  h->count = 0;
+}
+
+/* Put an entry for a key the hash does not hold yet, with room for it. */
+static void player_index_place(struct player_index_hash *h, unsigned long key, int pos)
+{
+  struct player_index_slot entry, displaced;
+  size_t i, mask = h->size - 1;
+
+  entry.key = key;
+  entry.pos = pos;
+  entry.dist = 1;
+  for (i = player_index_home(h, key);; i = (i + 1) & mask, entry.dist++)
+  {
+    if (h->slots[i].dist == 0)
+    {
+      h->slots[i] = entry;
+      h->count++;
+      return;
+    }
+    if (h->slots[i].dist < entry.dist)
+    {
+      displaced = h->slots[i];
+      h->slots[i] = entry;
+      entry = displaced;
+    }
+  }
+}
+
+static void player_index_reserve(struct player_index_hash *h)
+{
+  struct player_index_slot *old = h->slots;
+  size_t i, old_size = h->size;
+
+  if (old && (h->count + 1) * 8 <= h->size * 7)
+    return;
+  player_index_alloc(h, old ? old_size * 2 : PLAYER_INDEX_MIN_SLOTS);
+  for (i = 0; i < old_size; i++)
+    if (old[i].dist)
+      player_index_place(h, old[i].key, old[i].pos);
+  free(old);
+}
+
+/* Empty slot i, pulling the rest of its run back a slot. */
+static void player_index_remove_slot(struct player_index_hash *h, size_t i)
+{
+  size_t next, mask = h->size - 1;
+
+  for (;; i = next)
+  {
+    next = (i + 1) & mask;
+    if (h->slots[next].dist <= 1)
+      break;
+    h->slots[i] = h->slots[next];
+    h->slots[i].dist--;
+  }
+  h->slots[i].key = 0;
+  h->slots[i].pos = 0;
+  h->slots[i].dist = 0;
+  h->count--;
+}
+
+/* The slot holding key for position pos, or -1. */
+static long player_index_find_pos(const struct player_index_hash *h, unsigned long key, int pos)
+{
+  size_t i, mask = h->size - 1;
+  unsigned int dist;
+
+  if (h->slots == NULL)
+    return -1;
+  for (i = player_index_home(h, key), dist = 1;; i = (i + 1) & mask, dist++)
+  {
+    if (h->slots[i].dist < dist)
+      return -1;
+    if (h->slots[i].key == key && h->slots[i].pos == pos)
+      return (long)i;
+  }
+}
+
+static long player_index_find_name(const char *name)
+{
+  const struct player_index_hash *h = &player_index.names;
+  unsigned long key = player_name_hash(name);
+  size_t i, mask = h->size - 1;
+  unsigned int dist;
+
+  if (h->slots == NULL)
+    return -1;
+  for (i = player_index_home(h, key), dist = 1;; i = (i + 1) & mask, dist++)
+  {
+    if (h->slots[i].dist < dist)
+      return -1;
+    if (h->slots[i].key == key && !str_cmp(player_table[h->slots[i].pos].name, name))
+      return (long)i;
+  }
+}
+
+static long player_index_find_id(long id)
+{
+  const struct player_index_hash *h = &player_index.ids;
+  size_t i, mask = h->size - 1;
+  unsigned int dist;
+
+  if (h->slots == NULL)
+    return -1;
+  for (i = player_index_home(h, (unsigned long)id), dist = 1;; i = (i + 1) & mask, dist++)
+  {
+    if (h->slots[i].dist < dist)
+      return -1;
+    if (h->slots[i].key == (unsigned long)id)
+      return (long)i;
+  }
+}
+
+static void player_index_note(void)
+{
+  player_index.table = player_table;
+  player_index.top = top_of_p_table;
+  player_index.first_name = player_table && top_of_p_table >= 0 ? player_table[0].name : NULL;
+  player_index.last_name =
+      player_table && top_of_p_table >= 0 ? player_table[top_of_p_table].name : NULL;
+}
+
+/* Index pos under its name unless a lower position holds it already. */
+static void player_index_add_name(int pos)
+{
+  const char *name = player_table[pos].name;
+  long slot;
+
+  if (name == NULL || *name == '\0')
+    return;
+  if ((slot = player_index_find_name(name)) != -1)
+  {
+    if (player_index.names.slots[slot].pos > pos)
+      player_index.names.slots[slot].pos = pos;
+    return;
+  }
+  player_index_reserve(&player_index.names);
+  player_index_place(&player_index.names, player_name_hash(name), pos);
+}
+
+static void player_index_add_id(int pos)
+{
+  long id = player_table[pos].id, slot;
+
+  if (id <= 0)
+    return;
+  if ((slot = player_index_find_id(id)) != -1)
+  {
+    if (player_index.ids.slots[slot].pos > pos)
+      player_index.ids.slots[slot].pos = pos;
+    return;
+  }
+  player_index_reserve(&player_index.ids);
+  player_index_place(&player_index.ids, (unsigned long)id, pos);
+}
+
+static void player_index_clear(struct player_index_hash *h)
+{
+  free(h->slots);
+  h->slots = NULL;
+  h->size = 0;
+  h->count = 0;
+}
+
+void player_index_rebuild(void)
+{
+  size_t size = PLAYER_INDEX_MIN_SLOTS;
+  int i;
+
+  player_index_clear(&player_index.names);
+  player_index_clear(&player_index.ids);
+  if (player_table && top_of_p_table >= 0)
+  {
+    while ((size_t)(top_of_p_table + 1) * 8 > size * 7)
+      size *= 2;
+    player_index_alloc(&player_index.names, size);
+    player_index_alloc(&player_index.ids, size);
+    for (i = 0; i <= top_of_p_table; i++)
+    {
+      player_index_add_name(i);
+      player_index_add_id(i);
+    }
+  }
+  player_index_note();
+}
+
+/* Rebuild if player_table is not the table the hashes were built for. */
+static void player_index_sync(void)
+{
+  if (player_index.table != player_table || player_index.top != top_of_p_table ||
+      (player_table && top_of_p_table >= 0 &&
+       (player_index.first_name != player_table[0].name ||
+        player_index.last_name != player_table[top_of_p_table].name)))
+    player_index_rebuild();
+}
+
+void player_index_name_changed(int pos, const char *old_name)
+{
+  long slot;
+  int i;
+
+  if (pos < 0 || pos > top_of_p_table || player_index.table != player_table ||
+      player_index.top != top_of_p_table)
+  {
+    player_index_rebuild();
+    return;
+  }
+  if (old_name && *old_name &&
+      (slot = player_index_find_pos(&player_index.names, player_name_hash(old_name), pos)) != -1)
+  {
+    player_index_remove_slot(&player_index.names, (size_t)slot);
+    /* Another entry may share the old name */
+    for (i = pos + 1; i <= top_of_p_table; i++)
+      if (player_table[i].name && !str_cmp(player_table[i].name, old_name))
+      {
+        player_index_add_name(i);
+        break;
+      }
+  }
+  player_index_add_name(pos);
+  player_index_note();
+}
+
+void player_index_id_changed(int pos, long old_id)
+{
+  long slot;
+  int i;
+
+  if (pos < 0 || pos > top_of_p_table || player_index.table != player_table ||
+      player_index.top != top_of_p_table)
+  {
+    player_index_rebuild();
+    return;
+  }
+  if (old_id > 0 &&
+      (slot = player_index_find_pos(&player_index.ids, (unsigned long)old_id, pos)) != -1)
+  {
+    player_index_remove_slot(&player_index.ids, (size_t)slot);
+    for (i = pos + 1; i <= top_of_p_table; i++)
+      if (player_table[i].id == old_id)
+      {
+        player_index_add_id(i);
+        break;
+      }
+  }
+  player_index_add_id(pos);
+}
+
+/* Index a position create_entry() has just added. */
+static void player_index_added(int pos)
+{
+  player_index_add_name(pos);
+  player_index_add_id(pos);
+  player_index_note();
+}
+
+/* Check the hashes against player_table without rebuilding them; returns
+ * the number of problems found, each logged as a SYSERR. */
+int player_index_validate(void)
+{
+  int i, problems = 0, name_heads = 0, id_heads = 0;
+  const struct player_index_slot *s;
+  long slot;
+  size_t n;
+
+#define PLAYER_INDEX_PROBLEM(...)                                                                  \
+  do                                                                                               \
+  {                                                                                                \
+    if (problems++ < 10)                                                                           \
+      log("SYSERR: player index: " __VA_ARGS__);                                                   \
+  } while (0)
+
+  if (player_index.table != player_table || player_index.top != top_of_p_table)
+  {
+    PLAYER_INDEX_PROBLEM("built for %d entries at %p, table has %d at %p", player_index.top + 1,
+                         (const void *)player_index.table, top_of_p_table + 1,
+                         (const void *)player_table);
+    return problems;
+  }
+
+  for (i = 0; player_table && i <= top_of_p_table; i++)
+  {
+    if (player_table[i].name && *player_table[i].name)
+    {
+      if ((slot = player_index_find_name(player_table[i].name)) == -1)
+        PLAYER_INDEX_PROBLEM("name '%s' at %d is not indexed", player_table[i].name, i);
+      else if (player_index.names.slots[slot].pos > i)
+        PLAYER_INDEX_PROBLEM("name '%s' at %d is indexed at %d", player_table[i].name, i,
+                             player_index.names.slots[slot].pos);
+      else if (player_index.names.slots[slot].pos == i)
+        name_heads++;
+    }
+    if (player_table[i].id > 0)
+    {
+      if ((slot = player_index_find_id(player_table[i].id)) == -1)
+        PLAYER_INDEX_PROBLEM("id %ld at %d is not indexed", player_table[i].id, i);
+      else if (player_index.ids.slots[slot].pos > i)
+        PLAYER_INDEX_PROBLEM("id %ld at %d is indexed at %d", player_table[i].id, i,
+                             player_index.ids.slots[slot].pos);
+      else if (player_index.ids.slots[slot].pos == i)
+        id_heads++;
+    }
+  }
+
+  /* Every slot must point at a live entry that still carries its key */
+  for (n = 0; n < player_index.names.size; n++)
+  {
+    s = &player_index.names.slots[n];
+    if (s->dist && (s->pos < 0 || s->pos > top_of_p_table || !player_table[s->pos].name ||
+                    player_name_hash(player_table[s->pos].name) != s->key))
+      PLAYER_INDEX_PROBLEM("stale name slot for position %d", s->pos);
+  }
+  for (n = 0; n < player_index.ids.size; n++)
+  {
+    s = &player_index.ids.slots[n];
+    if (s->dist && (s->pos < 0 || s->pos > top_of_p_table ||
+                    (unsigned long)player_table[s->pos].id != s->key))
+      PLAYER_INDEX_PROBLEM("stale id slot for position %d", s->pos);
+  }
+  if ((size_t)name_heads != player_index.names.count)
+    PLAYER_INDEX_PROBLEM("%zu names indexed, %d expected", player_index.names.count, name_heads);
+  if ((size_t)id_heads != player_index.ids.count)
+    PLAYER_INDEX_PROBLEM("%zu ids indexed, %d expected", player_index.ids.count, id_heads);
+
+#undef PLAYER_INDEX_PROBLEM
+  if (problems > 10)
+    log("SYSERR: player index: %d problems in all", problems);
+  return problems;
+}
+
 /* New version to build player index for ASCII Player Files. Generate index
  * table for the player file. */
 void build_player_index(void)
@@ -193,6 +583,7 @@ void build_player_index(void)
   if (!(plr_index = fopen(index_name, "r")))
   {
     top_of_p_table = -1;
+    player_index_rebuild();
     log("No player index file!  First new char will be IMP!");
     return;
   }
@@ -206,6 +597,7 @@ void build_player_index(void)
   {
     player_table = NULL;
     top_of_p_table = -1;
+    player_index_rebuild();
     return;
   }
 
@@ -246,6 +638,7 @@ void build_player_index(void)
 
   fclose(plr_index);
   top_of_p_file = top_of_p_table = i - 1;
+  player_index_rebuild();
 }
 
 /* Create a new entry in the in-memory index table for the player file. If the
@@ -254,6 +647,8 @@ void build_player_index(void)
 int create_entry(char *name)
 {
   int i, pos;
+  long old_id = 0;
+  bool added = TRUE;
 
   if (top_of_p_table == -1)
   { /* no table */
@@ -267,6 +662,12 @@ int create_entry(char *name)
     RECREATE(player_table, struct player_index_element, i);
     pos = top_of_p_table;
   }
+  else
+  {
+    old_id = player_table[pos].id;
+    added = FALSE;
+    free(player_table[pos].name);
+  }
 
   CREATE(player_table[pos].name, char, strlen(name) + 1);
 
@@ -283,6 +684,16 @@ int create_entry(char *name)
   player_table[pos].level = 0;
   player_table[pos].last = 0;
 
+  if (top_of_p_table == 0)
+    player_index_rebuild();
+  else if (added)
+    player_index_added(pos);
+  else
+  {
+    player_index_id_changed(pos, old_id);
+    player_index_note();
+  }
+
   return (pos);
 }
 
@@ -321,64 +732,21 @@ void remove_player_from_index(int pos)
     free(player_table);
     player_table = NULL;
   }
+  player_index_rebuild();
 }
 
-/* This function necessary to save a separate ASCII player index */
-bool save_player_index_checked(void)
+/* The ASCII player index as it would be written; NULL if it cannot be
+ * formatted. */
+static char *player_index_image(size_t *length)
 {
   int i = 0;
-  int fd = -1;
-  int index_exists;
   int write_failed = FALSE;
-  char index_name[MAX_FILEPATH] = {'\0'}, temp_name[MAX_FILEPATH] = {'\0'}, bits[64] = {'\0'};
+  char bits[64] = {'\0'};
+  char *image = NULL;
   FILE *index_file;
-  struct stat index_stat;
-
-  i = snprintf(index_name, sizeof(index_name), "%s%s", LIB_PLRFILES, INDEX_FILE);
-  if (i < 0 || i >= (int)sizeof(index_name))
-  {
-    log("SYSERR: Player index path is too long");
-    return FALSE;
-  }
-  i = snprintf(temp_name, sizeof(temp_name), "%s.rename-tmp.XXXXXX", index_name);
-  if (i < 0 || i >= (int)sizeof(temp_name))
-  {
-    log("SYSERR: Player index temporary path is too long");
-    return FALSE;
-  }
 
-  if ((fd = mkstemp(temp_name)) < 0)
-  {
-    log("SYSERR: Could not create temporary player index file: %s", strerror(errno));
-    return FALSE;
-  }
-
-  index_exists = lstat(index_name, &index_stat) == 0;
-  if (!index_exists && errno != ENOENT)
-  {
-    log("SYSERR: Could not inspect player index file: %s", strerror(errno));
-    close(fd);
-    unlink(temp_name);
-    return FALSE;
-  }
-
-  if (index_exists &&
-      (!S_ISREG(index_stat.st_mode) || fchown(fd, index_stat.st_uid, index_stat.st_gid) != 0 ||
-       fchmod(fd, index_stat.st_mode & 07777) != 0))
-  {
-    log("SYSERR: Could not preserve player index permissions: %s", strerror(errno));
-    close(fd);
-    unlink(temp_name);
-    return FALSE;
-  }
-
-  if (!(index_file = fdopen(fd, "w")))
-  {
-    log("SYSERR: Could not open temporary player index file: %s", strerror(errno));
-    close(fd);
-    unlink(temp_name);
-    return FALSE;
-  }
+  if (!(index_file = open_memstream(&image, length)))
+    return NULL;
 
   for (i = 0; i <= top_of_p_table; i++)
     if (player_table[i].name && *player_table[i].name)
@@ -400,32 +768,53 @@ bool save_player_index_checked(void)
     }
   if (fprintf(index_file, "~\n") < 0)
     write_failed = TRUE;
-
-  if (fflush(index_file) != 0 || ferror(index_file) || fsync(fileno(index_file)) != 0)
-    write_failed = TRUE;
   if (fclose(index_file) != 0)
     write_failed = TRUE;
 
   if (write_failed)
   {
-    log("SYSERR: Could not durably write player index file: %s", strerror(errno));
-    unlink(temp_name);
-    return FALSE;
+    free(image);
+    return NULL;
   }
+  return image;
+}
 
-  if (rename(temp_name, index_name) != 0)
+/* Hand the player index to the persistence writer, which replaces the file
+ * through a temporary file and a rename. */
+static bool save_player_index_write(bool wait)
+{
+  char index_name[MAX_FILEPATH] = {'\0'};
+  struct persistence_write *job;
+  size_t length = 0;
+  char *image;
+  int i;
+
+  i = snprintf(index_name, sizeof(index_name), "%s%s", LIB_PLRFILES, INDEX_FILE);
+  if (i < 0 || i >= (int)sizeof(index_name))
   {
-    log("SYSERR: Could not install player index file: %s", strerror(errno));
-    unlink(temp_name);
+    log("SYSERR: Player index path is too long");
+    return FALSE;
+  }
+  if (!(image = player_index_image(&length)))
+  {
+    log("SYSERR: Could not format player index file: %s", strerror(errno));
     return FALSE;
   }
 
-  return TRUE;
+  job = persistence_write_new("player index", 0, NULL);
+  persistence_write_file(job, index_name, image, length);
+  return persistence_writer_submit(job, NULL, wait);
+}
+
+/* This function necessary to save a separate ASCII player index */
+bool save_player_index_checked(void)
+{
+  return save_player_index_write(TRUE);
 }
 
 void save_player_index(void)
 {
-  if (!save_player_index_checked())
+  if (!save_player_index_write(FALSE))
     log("SYSERR: Could not write player index file");
 }
 
@@ -443,39 +832,45 @@ void free_player_index(void)
   free(player_table);
   player_table = NULL;
   top_of_p_table = 0;
+  player_index_rebuild();
 }
 
 long get_ptable_by_name(const char *name)
 {
-  int i;
-
-  for (i = 0; i <= top_of_p_table; i++)
-    if (!str_cmp(player_table[i].name, name))
-      return (i);
+  long slot;
 
-  return (-1);
+  if (name == NULL)
+    return (-1);
+  player_index_sync();
+  if ((slot = player_index_find_name(name)) == -1)
+    return (-1);
+  return (player_index.names.slots[slot].pos);
 }
 
 long get_id_by_name(const char *name)
 {
-  int i;
-
-  for (i = 0; i <= top_of_p_table; i++)
-    if (!str_cmp(player_table[i].name, name))
-      return (player_table[i].id);
+  long pos = get_ptable_by_name(name);
 
-  return (-1);
+  return (pos == -1 ? -1 : player_table[pos].id);
 }
 
 char *get_name_by_id(long id)
 {
+  long slot;
   int i;
 
-  for (i = 0; i <= top_of_p_table; i++)
-    if (player_table[i].id == id)
-      return (player_table[i].name);
-
-  return (NULL);
+  /* Ids of 0 or less are not hashed; entries without one yet carry 0 */
+  if (id <= 0)
+  {
+    for (i = 0; player_table && i <= top_of_p_table; i++)
+      if (player_table[i].id == id)
+        return (player_table[i].name);
+    return (NULL);
+  }
+  player_index_sync();
+  if ((slot = player_index_find_id(id)) == -1)
+    return (NULL);
+  return (player_table[player_index.ids.slots[slot].pos].name);
 }
 
 /* Stuff related to the save/load player system. */
@@ -493,6 +888,9 @@ int load_char(const char *name, struct char_data *ch)
   trig_data *t = NULL;
   trig_rnum t_rnum = NOTHING;
 
+  /* Read what the last save wrote, not what it is still writing. */
+  persistence_writer_flush();
+
   if ((id = get_ptable_by_name(name)) < 0)
     return (-1);
   else
@@ -2262,29 +2660,98 @@ static bool append_player_save_buffer(char **buffer, size_t *capacity, size_t *u
   return true;
 }
 
+/* A player file write the persistence writer could not finish.  Flag the
+ * player so the crash saver writes them out again. */
+static void save_char_done(struct persistence_write *job, struct char_data *ch)
+{
+  if (job->failed && ch != NULL)
+    SET_BIT_AR(PLR_FLAGS(ch), PLR_CRASH);
+}
+
+/* What a player file records for everything gear and affects change: the
+ * character as they would stand with nothing worn and nothing active.  The
+ * file has always held these raw values, so the effects are not applied
+ * twice when the player logs back in. */
+struct player_save_base
+{
+  struct char_ability_data abils;
+  struct char_point_data points;
+  int aff_flags[AF_ARRAY_MAX];
+  ubyte height, weight;
+  int hp_regen, mv_regen, psp_regen, encumbrance_mod, fast_healing_mod;
+};
+
+/* Work out the raw values beside the live character, which this leaves
+ * exactly as it was: the same numbers the save used to get by unequipping
+ * everything and removing every affect, then putting it all back. */
+static void player_save_base(struct char_data *ch, struct player_save_base *base)
+{
+  int totals[NUM_APPLIES], granted[AF_ARRAY_MAX];
+  int i;
+
+  affect_total_applied(ch, totals, granted);
+
+  base->abils = ch->real_abils;
+  base->points = ch->points;
+  reset_point_data(&base->points, &ch->real_points);
+  for (i = 0; i < AF_ARRAY_MAX; i++)
+    base->aff_flags[i] = AFF_FLAGS(ch)[i] & ~granted[i];
+
+  base->height = GET_HEIGHT(ch) - totals[APPLY_CHAR_HEIGHT];
+  base->weight = GET_WEIGHT(ch) - totals[APPLY_CHAR_WEIGHT];
+  base->hp_regen = GET_HP_REGEN(ch) - totals[APPLY_HP_REGEN];
+  base->mv_regen = GET_MV_REGEN(ch) - totals[APPLY_MV_REGEN];
+  base->psp_regen = GET_PSP_REGEN(ch) - totals[APPLY_PSP_REGEN];
+  base->encumbrance_mod = GET_ENCUMBRANCE_MOD(ch) - totals[APPLY_ENCUMBRANCE];
+  base->fast_healing_mod = GET_FAST_HEALING_MOD(ch) - totals[APPLY_FAST_HEALING];
+
+  /* A wild shape no affect granted still reads through the disguise. */
+  if (IS_SET_AR(base->aff_flags, AFF_WILD_SHAPE) && GET_DISGUISE_RACE(ch))
+  {
+    base->abils.str += GET_DISGUISE_STR(ch);
+    base->abils.dex += GET_DISGUISE_DEX(ch);
+    base->abils.con += GET_DISGUISE_CON(ch);
+    base->points.armor += GET_DISGUISE_AC(ch);
+  }
+}
+
+/* Whether dr came from an affect that removing every affect would take
+ * with it. */
+static bool player_save_dr_from_affect(struct char_data *ch, struct damage_reduction_type *dr)
+{
+  struct affected_type *af;
+
+  for (af = ch->affected; af; af = af->next)
+    if (af->location == APPLY_DR && af->spell == dr->spell)
+      return TRUE;
+  return FALSE;
+}
+
 /**
- * Write a player file, reporting whether the write actually succeeded.
+ * Format a player file in memory and hand it to the persistence writer.
  *
- * This is the real implementation; save_char() below is a result-discarding
- * wrapper kept for the many legacy call sites. Every allocation, open, write,
- * flush, close, and player-index failure returns FALSE, so a caller that must
- * not acknowledge durable success until the bytes are down (the structured
- * onboarding role-play commits) can tell the difference.
+ * The image is formatted straight from the live character, with the raw
+ * values from player_save_base(), so saving never changes game state.  With
+ * wait set this returns once the file is installed, and every allocation,
+ * format, write, and player-index failure returns FALSE; otherwise TRUE
+ * means the image was queued.
  */
-bool save_char_checked(struct char_data *ch, int mode)
+static bool save_char_write(struct char_data *ch, int mode, bool wait)
 {
   FILE *fl;
+  char *image = NULL;
+  size_t image_length = 0;
+  struct persistence_write *job;
   bool save_ok = TRUE;
-  bool old_mute_equip_messages = FALSE;
   const char *account_name = NULL;
   char filename[40] = {'\0'}, bits[127] = {'\0'}, bits2[127] = {'\0'}, bits3[127] = {'\0'},
        bits4[127] = {'\0'};
   int i = 0, j = 0, id = 0, save_index = FALSE;
   int aff_count = 0, saved_aff_count = 0;
   struct affected_type *aff = NULL;
-  struct affected_type tmp_aff[MAX_AFFECT] = {{0}};
-  struct damage_reduction_type *tmp_dr = NULL, *cur_dr = NULL;
-  struct obj_data *char_eq[NUM_WEARS] = {NULL};
+  struct damage_reduction_type *spell_dr[100], *dr_walk = NULL;
+  int spell_dr_count = 0, permanent_dr_count = 0;
+  struct player_save_base base;
   trig_data *t = NULL;
   struct mud_event_data *pMudEvent = NULL;
 
@@ -2320,6 +2787,8 @@ bool save_char_checked(struct char_data *ch, int mode)
     if (!append_player_save_buffer(&write_buffer, &buffer_size, &buffer_used, __VA_ARGS__))        \
     {                                                                                              \
       log("SYSERR: save_char: Buffer formatting or allocation failed");                            \
+      fclose(fl);                                                                                  \
+      free(image);                                                                                 \
       free(write_buffer);                                                                          \
       PERF_PROF_EXIT(pr_save_char_checked_);                                                       \
       return FALSE;                                                                                \
@@ -2333,6 +2802,8 @@ bool save_char_checked(struct char_data *ch, int mode)
                                    field_value))                                                   \
     {                                                                                              \
       log("SYSERR: save_char: String buffer formatting or allocation failed");                     \
+      fclose(fl);                                                                                  \
+      free(image);                                                                                 \
       free(write_buffer);                                                                          \
       PERF_PROF_EXIT(pr_save_char_checked_);                                                       \
       return FALSE;                                                                                \
@@ -2368,90 +2839,35 @@ bool save_char_checked(struct char_data *ch, int mode)
     PERF_PROF_EXIT(pr_save_char_checked_);
     return FALSE;
   }
-  if (!(fl = fopen_restricted(filename, "w")))
+  if (!(fl = open_memstream(&image, &image_length)))
   {
-    mudlog(NRM, LVL_STAFF, TRUE, "SYSERR: Couldn't open player file %s for write", filename);
+    mudlog(NRM, LVL_STAFF, TRUE, "SYSERR: Couldn't format player file %s", filename);
     free(write_buffer);
     PERF_PROF_EXIT(pr_save_char_checked_);
     return FALSE;
   }
 
-  /* Unaffect everything a character can be affected by.  This is save-file
-   * bookkeeping, not a visible equipment change, so suppress both removal
-   * and wear messages while the equipment hooks run. */
-  old_mute_equip_messages = ch->mute_equip_messages;
-  ch->mute_equip_messages = TRUE;
-  for (i = 0; i < NUM_WEARS; i++)
-  {
-    if (GET_EQ(ch, i))
-    {
-      char_eq[i] = unequip_char(ch, i);
-#ifndef NO_EXTRANEOUS_TRIGGERS
-      remove_otrigger(char_eq[i], ch);
-#endif
-    }
-    else
-      char_eq[i] = NULL;
-  }
-  ch->mute_equip_messages = old_mute_equip_messages;
-
-  aff_count = 0;
-  saved_aff_count = 0;
+  player_save_base(ch, &base);
 
+  /* Affects are written as they stand, artifact bonuses aside; those come
+   * back with the artifact. */
   for (aff = ch->affected; aff; aff = aff->next)
-  {
-    if (aff->spell == SPELL_ARTIFACT_PASSIVE || aff->spell == SPELL_ARTIFACT_BONUS)
-      continue;
-
-    aff_count++;
-    if (saved_aff_count < MAX_AFFECT)
-    {
-      tmp_aff[saved_aff_count] = *aff;
-      for (j = 0; j < AF_ARRAY_MAX; j++)
-        tmp_aff[saved_aff_count].bitvector[j] = aff->bitvector[j];
-      tmp_aff[saved_aff_count].next = 0;
-      saved_aff_count++;
-    }
-  }
-
-  for (i = saved_aff_count; i < MAX_AFFECT; i++)
-  {
-    new_affect(&(tmp_aff[i]));
-    tmp_aff[i].next = 0;
-  }
-
-  /* Save off the dr since that is attached to affects (i.e. stoneskin will
-   * create a dr structure that is loosely coupled to the affect for the spell.
-   * If the spell affect is removed, however, the stoneskin dr is dropped.)
-   * This only counts for dr where spell is != 0. */
-  if (ch && GET_DR(ch) != NULL)
-  {
-    for (cur_dr = GET_DR(ch); cur_dr != NULL; cur_dr = cur_dr->next)
-    {
-      if (cur_dr->spell != 0)
-      {
-        struct damage_reduction_type *tmp;
-
-        CREATE(tmp, struct damage_reduction_type, 1);
-        *tmp = *cur_dr;
-        tmp->next = tmp_dr;
-        tmp_dr = tmp;
-      }
-    }
-  }
-
-  /* Remove the affections so that the raw values are stored; otherwise the
-   * effects are doubled when the char logs back in. */
-
-  while (ch->affected)
-    affect_remove(ch, ch->affected);
-
+    if (aff->spell != SPELL_ARTIFACT_PASSIVE && aff->spell != SPELL_ARTIFACT_BONUS)
+      aff_count++;
   if (aff_count > MAX_AFFECT)
     log("SYSERR: WARNING: OUT OF STORE ROOM FOR AFFECTED TYPES for %s (%d affects, max %d)!",
         GET_NAME(ch), aff_count, MAX_AFFECT);
 
-  ch->aff_abils = ch->real_abils;
-  reset_char_points(ch);
+  /* Damage reduction is loosely coupled to the affect that made it (i.e.
+   * stoneskin).  Spell DR is written first, from the end of the list, then
+   * the DR no affect owns. */
+  for (dr_walk = GET_DR(ch); dr_walk != NULL; dr_walk = dr_walk->next)
+  {
+    if (dr_walk->spell != 0 && spell_dr_count < (int)(sizeof(spell_dr) / sizeof(*spell_dr)))
+      spell_dr[spell_dr_count++] = dr_walk;
+    if (!player_save_dr_from_affect(ch, dr_walk))
+      permanent_dr_count++;
+  }
 
   /* Make sure size doesn't go over/under caps */
 
@@ -2565,14 +2981,14 @@ bool save_char_checked(struct char_data *ch, int mode)
     BUFFER_WRITE("Host: %s\n", GET_HOST(ch));
   if (GET_ARCANE_MARK(ch) && *GET_ARCANE_MARK(ch))
     BUFFER_WRITE("AMrk: %s\n", GET_ARCANE_MARK(ch));
-  if (GET_HEIGHT(ch) != PFDEF_HEIGHT)
-    BUFFER_WRITE("Hite: %d\n", GET_HEIGHT(ch));
+  if (base.height != PFDEF_HEIGHT)
+    BUFFER_WRITE("Hite: %d\n", base.height);
   if (HIGH_ELF_CANTRIP(ch))
     BUFFER_WRITE("HECn: %d\n", HIGH_ELF_CANTRIP(ch));
   if (GET_HOLY_WEAPON_TYPE(ch) != PFDEF_HOLY_WEAPON_TYPE)
     BUFFER_WRITE("HlyW: %d\n", GET_HOLY_WEAPON_TYPE(ch));
-  if (GET_WEIGHT(ch) != PFDEF_WEIGHT)
-    BUFFER_WRITE("Wate: %d\n", GET_WEIGHT(ch));
+  if (base.weight != PFDEF_WEIGHT)
+    BUFFER_WRITE("Wate: %d\n", base.weight);
   if (GET_ALIGNMENT(ch) != PFDEF_ALIGNMENT)
     BUFFER_WRITE("Alin: %d\n", GET_ALIGNMENT(ch));
   if (GET_CH_AGE(ch) != 0)
@@ -2609,10 +3025,10 @@ bool save_char_checked(struct char_data *ch, int mode)
   sprintascii(bits4, PLR_FLAGS(ch)[3]);
   BUFFER_WRITE("Act : %s %s %s %s\n", bits, bits2, bits3, bits4);
 
-  sprintascii(bits, AFF_FLAGS(ch)[0]);
-  sprintascii(bits2, AFF_FLAGS(ch)[1]);
-  sprintascii(bits3, AFF_FLAGS(ch)[2]);
-  sprintascii(bits4, AFF_FLAGS(ch)[3]);
+  sprintascii(bits, base.aff_flags[0]);
+  sprintascii(bits2, base.aff_flags[1]);
+  sprintascii(bits3, base.aff_flags[2]);
+  sprintascii(bits4, base.aff_flags[3]);
   BUFFER_WRITE("Aff : %s %s %s %s\n", bits, bits2, bits3, bits4);
 
   sprintascii(bits, PRF_FLAGS(ch)[0]);
@@ -2621,57 +3037,57 @@ bool save_char_checked(struct char_data *ch, int mode)
   sprintascii(bits4, PRF_FLAGS(ch)[3]);
   BUFFER_WRITE("Pref: %s %s %s %s\n", bits, bits2, bits3, bits4);
 
-  if (GET_SAVE(ch, 0) != PFDEF_SAVETHROW)
-    BUFFER_WRITE("Thr1: %d\n", GET_SAVE(ch, 0));
-  if (GET_SAVE(ch, 1) != PFDEF_SAVETHROW)
-    BUFFER_WRITE("Thr2: %d\n", GET_SAVE(ch, 1));
-  if (GET_SAVE(ch, 2) != PFDEF_SAVETHROW)
-    BUFFER_WRITE("Thr3: %d\n", GET_SAVE(ch, 2));
-  if (GET_SAVE(ch, 3) != PFDEF_SAVETHROW)
-    BUFFER_WRITE("Thr4: %d\n", GET_SAVE(ch, 3));
-  if (GET_SAVE(ch, 4) != PFDEF_SAVETHROW)
-    BUFFER_WRITE("Thr5: %d\n", GET_SAVE(ch, 4));
-
-  if (GET_RESISTANCES(ch, 1) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res1: %d\n", GET_RESISTANCES(ch, 1));
-  if (GET_RESISTANCES(ch, 2) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res2: %d\n", GET_RESISTANCES(ch, 2));
-  if (GET_RESISTANCES(ch, 3) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res3: %d\n", GET_RESISTANCES(ch, 3));
-  if (GET_RESISTANCES(ch, 4) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res4: %d\n", GET_RESISTANCES(ch, 4));
-  if (GET_RESISTANCES(ch, 5) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res5: %d\n", GET_RESISTANCES(ch, 5));
-  if (GET_RESISTANCES(ch, 6) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res6: %d\n", GET_RESISTANCES(ch, 6));
-  if (GET_RESISTANCES(ch, 7) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res7: %d\n", GET_RESISTANCES(ch, 7));
-  if (GET_RESISTANCES(ch, 8) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res8: %d\n", GET_RESISTANCES(ch, 8));
-  if (GET_RESISTANCES(ch, 9) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("Res9: %d\n", GET_RESISTANCES(ch, 9));
-  if (GET_RESISTANCES(ch, 10) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResA: %d\n", GET_RESISTANCES(ch, 10));
-  if (GET_RESISTANCES(ch, 11) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResB: %d\n", GET_RESISTANCES(ch, 11));
-  if (GET_RESISTANCES(ch, 12) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResC: %d\n", GET_RESISTANCES(ch, 12));
-  if (GET_RESISTANCES(ch, 13) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResD: %d\n", GET_RESISTANCES(ch, 13));
-  if (GET_RESISTANCES(ch, 14) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResE: %d\n", GET_RESISTANCES(ch, 14));
-  if (GET_RESISTANCES(ch, 15) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResF: %d\n", GET_RESISTANCES(ch, 15));
-  if (GET_RESISTANCES(ch, 16) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResG: %d\n", GET_RESISTANCES(ch, 16));
-  if (GET_RESISTANCES(ch, 17) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResH: %d\n", GET_RESISTANCES(ch, 17));
-  if (GET_RESISTANCES(ch, 18) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResI: %d\n", GET_RESISTANCES(ch, 18));
-  if (GET_RESISTANCES(ch, 19) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResJ: %d\n", GET_RESISTANCES(ch, 19));
-  if (GET_RESISTANCES(ch, 20) != PFDEF_RESISTANCES)
-    BUFFER_WRITE("ResK: %d\n", GET_RESISTANCES(ch, 20));
+  if (base.points.apply_saving_throw[0] != PFDEF_SAVETHROW)
+    BUFFER_WRITE("Thr1: %d\n", base.points.apply_saving_throw[0]);
+  if (base.points.apply_saving_throw[1] != PFDEF_SAVETHROW)
+    BUFFER_WRITE("Thr2: %d\n", base.points.apply_saving_throw[1]);
+  if (base.points.apply_saving_throw[2] != PFDEF_SAVETHROW)
+    BUFFER_WRITE("Thr3: %d\n", base.points.apply_saving_throw[2]);
+  if (base.points.apply_saving_throw[3] != PFDEF_SAVETHROW)
+    BUFFER_WRITE("Thr4: %d\n", base.points.apply_saving_throw[3]);
+  if (base.points.apply_saving_throw[4] != PFDEF_SAVETHROW)
+    BUFFER_WRITE("Thr5: %d\n", base.points.apply_saving_throw[4]);
+
+  if (base.points.resistances[1] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res1: %d\n", base.points.resistances[1]);
+  if (base.points.resistances[2] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res2: %d\n", base.points.resistances[2]);
+  if (base.points.resistances[3] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res3: %d\n", base.points.resistances[3]);
+  if (base.points.resistances[4] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res4: %d\n", base.points.resistances[4]);
+  if (base.points.resistances[5] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res5: %d\n", base.points.resistances[5]);
+  if (base.points.resistances[6] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res6: %d\n", base.points.resistances[6]);
+  if (base.points.resistances[7] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res7: %d\n", base.points.resistances[7]);
+  if (base.points.resistances[8] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res8: %d\n", base.points.resistances[8]);
+  if (base.points.resistances[9] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("Res9: %d\n", base.points.resistances[9]);
+  if (base.points.resistances[10] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResA: %d\n", base.points.resistances[10]);
+  if (base.points.resistances[11] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResB: %d\n", base.points.resistances[11]);
+  if (base.points.resistances[12] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResC: %d\n", base.points.resistances[12]);
+  if (base.points.resistances[13] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResD: %d\n", base.points.resistances[13]);
+  if (base.points.resistances[14] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResE: %d\n", base.points.resistances[14]);
+  if (base.points.resistances[15] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResF: %d\n", base.points.resistances[15]);
+  if (base.points.resistances[16] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResG: %d\n", base.points.resistances[16]);
+  if (base.points.resistances[17] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResH: %d\n", base.points.resistances[17]);
+  if (base.points.resistances[18] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResI: %d\n", base.points.resistances[18]);
+  if (base.points.resistances[19] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResJ: %d\n", base.points.resistances[19]);
+  if (base.points.resistances[20] != PFDEF_RESISTANCES)
+    BUFFER_WRITE("ResK: %d\n", base.points.resistances[20]);
 
   if (GET_WIMP_LEV(ch) != PFDEF_WIMPLEV)
     BUFFER_WRITE("Wimp: %d\n", GET_WIMP_LEV(ch));
@@ -2767,19 +3183,19 @@ bool save_char_checked(struct char_data *ch, int mode)
   if (GET_COND(ch, DRUNK) != PFDEF_DRUNK && GET_LEVEL(ch) < LVL_IMMORT)
     BUFFER_WRITE("Drnk: %d\n", GET_COND(ch, DRUNK));
 
-  if (GET_HIT(ch) != PFDEF_HIT || GET_MAX_HIT(ch) != PFDEF_MAXHIT)
-    BUFFER_WRITE("Hit : %d/%d\n", GET_HIT(ch), GET_MAX_HIT(ch));
-  if (GET_PSP(ch) != PFDEF_PSP || GET_MAX_PSP(ch) != PFDEF_MAXPSP)
-    BUFFER_WRITE("PSP : %d/%d\n", GET_PSP(ch), GET_MAX_PSP(ch));
-  if (GET_MOVE(ch) != PFDEF_MOVE || GET_MAX_MOVE(ch) != PFDEF_MAXMOVE)
-    BUFFER_WRITE("Move: %d/%d\n", GET_MOVE(ch), GET_MAX_MOVE(ch));
+  if (GET_HIT(ch) != PFDEF_HIT || base.points.max_hit != PFDEF_MAXHIT)
+    BUFFER_WRITE("Hit : %d/%d\n", GET_HIT(ch), base.points.max_hit);
+  if (GET_PSP(ch) != PFDEF_PSP || base.points.max_psp != PFDEF_MAXPSP)
+    BUFFER_WRITE("PSP : %d/%d\n", GET_PSP(ch), base.points.max_psp);
+  if (GET_MOVE(ch) != PFDEF_MOVE || base.points.max_move != PFDEF_MAXMOVE)
+    BUFFER_WRITE("Move: %d/%d\n", GET_MOVE(ch), base.points.max_move);
 
-  if (GET_HP_REGEN(ch) != PFDEF_HP_REGEN)
-    BUFFER_WRITE("HPRg : %d\n", GET_HP_REGEN(ch));
-  if (GET_MV_REGEN(ch) != PFDEF_MV_REGEN)
-    BUFFER_WRITE("MVRg : %d\n", GET_MV_REGEN(ch));
-  if (GET_PSP_REGEN(ch) != PFDEF_PSP_REGEN)
-    BUFFER_WRITE("PSRg : %d\n", GET_PSP_REGEN(ch));
+  if (base.hp_regen != PFDEF_HP_REGEN)
+    BUFFER_WRITE("HPRg : %d\n", base.hp_regen);
+  if (base.mv_regen != PFDEF_MV_REGEN)
+    BUFFER_WRITE("MVRg : %d\n", base.mv_regen);
+  if (base.psp_regen != PFDEF_PSP_REGEN)
+    BUFFER_WRITE("PSRg : %d\n", base.psp_regen);
 
   /* Moon bonus spells */
   if (ch->player_specials->saved.moon_bonus_spells != 0)
@@ -2798,22 +3214,22 @@ bool save_char_checked(struct char_data *ch, int mode)
   if (ch->player_specials->saved.last_device_recharge != 0)
     BUFFER_WRITE("DvRc: %ld\n", ch->player_specials->saved.last_device_recharge);
 
-  if (GET_STR(ch) != PFDEF_STR || GET_ADD(ch) != PFDEF_STRADD)
-    BUFFER_WRITE("Str : %d/%d\n", GET_STR(ch), GET_ADD(ch));
-
-  if (GET_INT(ch) != PFDEF_INT)
-    BUFFER_WRITE("Int : %d\n", GET_INT(ch));
-  if (GET_WIS(ch) != PFDEF_WIS)
-    BUFFER_WRITE("Wis : %d\n", GET_WIS(ch));
-  if (GET_DEX(ch) != PFDEF_DEX)
-    BUFFER_WRITE("Dex : %d\n", GET_DEX(ch));
-  if (GET_CON(ch) != PFDEF_CON)
-    BUFFER_WRITE("Con : %d\n", GET_CON(ch));
-  if (GET_CHA(ch) != PFDEF_CHA)
-    BUFFER_WRITE("Cha : %d\n", GET_CHA(ch));
-
-  if (GET_AC(ch) != PFDEF_AC)
-    BUFFER_WRITE("Ac  : %d\n", GET_AC(ch));
+  if (base.abils.str != PFDEF_STR || base.abils.str_add != PFDEF_STRADD)
+    BUFFER_WRITE("Str : %d/%d\n", base.abils.str, base.abils.str_add);
+
+  if (base.abils.intel != PFDEF_INT)
+    BUFFER_WRITE("Int : %d\n", base.abils.intel);
+  if (base.abils.wis != PFDEF_WIS)
+    BUFFER_WRITE("Wis : %d\n", base.abils.wis);
+  if (base.abils.dex != PFDEF_DEX)
+    BUFFER_WRITE("Dex : %d\n", base.abils.dex);
+  if (base.abils.con != PFDEF_CON)
+    BUFFER_WRITE("Con : %d\n", base.abils.con);
+  if (base.abils.cha != PFDEF_CHA)
+    BUFFER_WRITE("Cha : %d\n", base.abils.cha);
+
+  if (base.points.armor != PFDEF_AC)
+    BUFFER_WRITE("Ac  : %d\n", base.points.armor);
   if (GET_GOLD(ch) != PFDEF_GOLD)
     BUFFER_WRITE("Gold: %d\n", GET_GOLD(ch));
   if (GET_BANK_GOLD(ch) != PFDEF_BANK)
@@ -2822,12 +3238,12 @@ bool save_char_checked(struct char_data *ch, int mode)
     BUFFER_WRITE("Exp : %ld\n", GET_EXP(ch));
   if (GET_ARTISAN_EXP(ch) != 0)
     BUFFER_WRITE("AExp: %d\n", GET_ARTISAN_EXP(ch));
-  if (GET_HITROLL(ch) != PFDEF_HITROLL)
-    BUFFER_WRITE("Hrol: %d\n", GET_HITROLL(ch));
-  if (GET_DAMROLL(ch) != PFDEF_DAMROLL)
-    BUFFER_WRITE("Drol: %d\n", GET_DAMROLL(ch));
-  if (GET_SPELL_RES(ch) != PFDEF_SPELL_RES)
-    BUFFER_WRITE("SpRs: %d\n", GET_SPELL_RES(ch));
+  if (base.points.hitroll != PFDEF_HITROLL)
+    BUFFER_WRITE("Hrol: %d\n", base.points.hitroll);
+  if (base.points.damroll != PFDEF_DAMROLL)
+    BUFFER_WRITE("Drol: %d\n", base.points.damroll);
+  if (base.points.spell_res != PFDEF_SPELL_RES)
+    BUFFER_WRITE("SpRs: %d\n", base.points.spell_res);
   if (IS_MORPHED(ch) != PFDEF_MORPHED)
     BUFFER_WRITE("Mrph: %d\n", IS_MORPHED(ch));
   if (MERGE_FORMS_TIMER(ch) != 0)
@@ -2878,8 +3294,8 @@ bool save_char_checked(struct char_data *ch, int mode)
     BUFFER_WRITE("EfMU: %d\n", EFREETI_MAGIC_USES(ch));
   if (EFREETI_MAGIC_TIMER(ch) != PFDEF_EFREETI_MAGIC_TIMER)
     BUFFER_WRITE("EfMT: %d\n", EFREETI_MAGIC_TIMER(ch));
-  if (GET_ENCUMBRANCE_MOD(ch) != 0)
-    BUFFER_WRITE("EncM: %d\n", GET_ENCUMBRANCE_MOD(ch));
+  if (base.encumbrance_mod != 0)
+    BUFFER_WRITE("EncM: %d\n", base.encumbrance_mod);
   BUFFER_WRITE("EldE: %d\n", GET_ELDRITCH_ESSENCE(ch));
   BUFFER_WRITE("EldS: %d\n", GET_ELDRITCH_SHAPE(ch));
   if (GET_DR_MOD(ch) > 0)
@@ -2909,8 +3325,8 @@ bool save_char_checked(struct char_data *ch, int mode)
   if (FEY_SHADOW_WALK_TIMER(ch) != PFDEF_FEY_SHADOW_WALK_TIMER)
     BUFFER_WRITE("FSWT: %d\n", FEY_SHADOW_WALK_TIMER(ch));
 
-  if (GET_FAST_HEALING_MOD(ch) != 0)
-    BUFFER_WRITE("FstH: %d\n", GET_FAST_HEALING_MOD(ch));
+  if (base.fast_healing_mod != 0)
+    BUFFER_WRITE("FstH: %d\n", base.fast_healing_mod);
   if (GRAVE_TOUCH_USES(ch) != PFDEF_GRAVE_TOUCH_USES)
     BUFFER_WRITE("GTCU: %d\n", GRAVE_TOUCH_USES(ch));
   if (GRAVE_TOUCH_TIMER(ch) != PFDEF_GRAVE_TOUCH_TIMER)
@@ -3938,12 +4354,17 @@ bool save_char_checked(struct char_data *ch, int mode)
   }
 
   /* Save affects */
-  if (tmp_aff[0].spell > 0)
+  for (aff = ch->affected; aff; aff = aff->next)
+    if (aff->spell != SPELL_ARTIFACT_PASSIVE && aff->spell != SPELL_ARTIFACT_BONUS)
+      break;
+  if (aff && aff->spell > 0)
   {
     BUFFER_WRITE("Affs: %d\n", PLAYER_AFFECT_FILE_VERSION);
-    for (i = 0; i < MAX_AFFECT; i++)
+    for (; aff && saved_aff_count < MAX_AFFECT; aff = aff->next)
     {
-      aff = &tmp_aff[i];
+      if (aff->spell == SPELL_ARTIFACT_PASSIVE || aff->spell == SPELL_ARTIFACT_BONUS)
+        continue;
+      saved_aff_count++;
       if (aff->spell)
         BUFFER_WRITE("%d %d %d %d %d %d %d %d %d %d %d %d %d %d\n", aff->spell, aff->duration,
                      aff->modifier, aff->location, aff->bitvector[0], aff->bitvector[1],
@@ -3955,7 +4376,7 @@ bool save_char_checked(struct char_data *ch, int mode)
   }
 
   /* Save Damage Reduction */
-  if ((tmp_dr != NULL) || (GET_DR(ch) != NULL))
+  if (spell_dr_count > 0 || permanent_dr_count > 0)
   {
     struct damage_reduction_type *dr;
     int k = 0, x = 0;
@@ -3967,8 +4388,9 @@ bool save_char_checked(struct char_data *ch, int mode)
     BUFFER_WRITE("DmgR:\n");
 
     /* DR from affects...*/
-    for (dr = tmp_dr; dr != NULL && 0 <= max_loops--; dr = dr->next)
+    for (j = spell_dr_count - 1; j >= 0 && 0 <= max_loops--; j--)
     {
+      dr = spell_dr[j];
       // dupe check -- only want one DR entry per spell/ability/power
       found = false;
       for (x = 0; x < 100; x++)
@@ -3998,8 +4420,11 @@ bool save_char_checked(struct char_data *ch, int mode)
     max_loops = 100;
 
     /* Permanent DR. */
-    for (dr = GET_DR(ch); dr != NULL && 0 <= max_loops--; dr = dr->next)
+    for (dr = GET_DR(ch); dr != NULL && 0 <= max_loops; dr = dr->next)
     {
+      if (player_save_dr_from_affect(ch, dr))
+        continue;
+      max_loops--;
       // dupe check -- only want one DR entry per spell/ability/power
       found = false;
       for (x = 0; x < 100; x++)
@@ -4060,7 +4485,7 @@ bool save_char_checked(struct char_data *ch, int mode)
   write_aliases_ascii(fl, ch);
   save_char_vars_ascii(fl, ch);
 
-  /* Write buffer to file and close */
+  /* Append the buffer to the image and close it */
   if (buffer_used > 0)
   {
     if (fwrite(write_buffer, 1, buffer_used, fl) != buffer_used)
@@ -4070,22 +4495,9 @@ bool save_char_checked(struct char_data *ch, int mode)
     }
   }
 
-  /*
-   * Flush explicitly so a full disk or quota is reported here rather than
-   * being swallowed. Deliberately no early return: the code below restores the
-   * equipment and affects that were stripped for serialization, and skipping
-   * that would corrupt the in-memory character on top of a failed save.
-   */
-  if (fflush(fl) != 0)
-  {
-    log("SYSERR: save_char: Failed to flush player file for %s", GET_NAME(ch));
-    save_ok = FALSE;
-  }
-
-  /* FILE CLOSED!!! */
   if (fclose(fl) != 0)
   {
-    log("SYSERR: save_char: Failed to close player file for %s", GET_NAME(ch));
+    log("SYSERR: save_char: Failed to finish player file image for %s", GET_NAME(ch));
     save_ok = FALSE;
   }
 
@@ -4094,41 +4506,15 @@ bool save_char_checked(struct char_data *ch, int mode)
 #undef BUFFER_WRITE
 #undef BUFFER_WRITE_STRING
 
-  /* add affects, dr, etc back in */
-
-  /* More char_to_store code to add spell and eq affections back in. */
-  for (i = 0; i < MAX_AFFECT; i++)
+  if (save_ok)
   {
-    if (tmp_aff[i].spell)
-      affect_to_char_source(ch, &tmp_aff[i], tmp_aff[i].source_id);
-  }
-
-  /* Reapply dr.*/
-  if (tmp_dr != NULL)
-  {
-    GET_DR(ch) = tmp_dr;
-  }
-
-  /* Keep the matching re-equip pass silent as well. */
-  old_mute_equip_messages = ch->mute_equip_messages;
-  ch->mute_equip_messages = TRUE;
-
-  for (i = 0; i < NUM_WEARS; i++)
-  {
-    if (char_eq[i])
-#ifndef NO_EXTRANEOUS_TRIGGERS
-      if (wear_otrigger(char_eq[i], ch, i))
-#endif
-        equip_char(ch, char_eq[i], i);
-#ifndef NO_EXTRANEOUS_TRIGGERS
-      else
-        obj_to_char(char_eq[i], ch);
-#endif
+    job = persistence_write_new("player file", GET_IDNUM(ch), save_char_done);
+    persistence_write_file(job, filename, image, image_length);
+    image = NULL;
+    if (!persistence_writer_submit(job, ch, wait))
+      save_ok = FALSE;
   }
-
-  ch->mute_equip_messages = old_mute_equip_messages;
-
-  /* end char_to_store code */
+  free(image);
 
   if ((id = get_ptable_by_name(GET_NAME(ch))) < 0)
   {
@@ -4163,7 +4549,12 @@ bool save_char_checked(struct char_data *ch, int mode)
     REMOVE_BIT(player_table[id].flags, PINDEX_NOWIZLIST);
 
   if (player_table[id].flags != i || save_index)
-    save_player_index();
+  {
+    if (!wait)
+      save_player_index();
+    else if (!save_player_index_checked())
+      save_ok = FALSE;
+  }
 
   /* Log performance metrics */
   gettimeofday(&end_time, NULL);
@@ -4171,6 +4562,8 @@ bool save_char_checked(struct char_data *ch, int mode)
       (end_time.tv_sec - start_time.tv_sec) * 1000000 + (end_time.tv_usec - start_time.tv_usec);
   long elapsed_ms = elapsed_usec / 1000;
 
+  PERF_note_player_save((uint64_t)elapsed_usec);
+
   /* Log if save took more than 260ms */
   if (elapsed_ms > 260)
   {
@@ -4182,6 +4575,23 @@ bool save_char_checked(struct char_data *ch, int mode)
   return save_ok;
 }
 
+/**
+ * Write a player file, reporting whether the write actually succeeded.
+ *
+ * Waits for the persistence writer, so a caller that must not acknowledge
+ * durable success until the bytes are down (the structured onboarding
+ * role-play commits) can tell the difference.
+ */
+bool save_char_checked(struct char_data *ch, int mode)
+{
+  return save_char_write(ch, mode, TRUE);
+}
+
+bool save_char_async(struct char_data *ch, int mode)
+{
+  return save_char_write(ch, mode, FALSE);
+}
+
 /**
  * Compatibility wrapper for the existing call sites, which have no way to act
  * on a failure. New code that must confirm durability should call
@@ -4189,7 +4599,7 @@ bool save_char_checked(struct char_data *ch, int mode)
  */
 void save_char(struct char_data *ch, int mode)
 {
-  (void)save_char_checked(ch, mode);
+  (void)save_char_async(ch, mode);
 }
 
 /* Separate a 4-character id tag from the data it precedes */
@@ -4238,6 +4648,7 @@ static bool restore_player_index_entry(struct player_removal_transaction *transa
     player_table[index] = player_table[index - 1];
 
   player_table[position] = transaction->index_entry;
+  player_index_rebuild();
   transaction->index_entry.name = NULL;
   transaction->index_removed = FALSE;
   return TRUE;
@@ -4297,6 +4708,9 @@ struct player_removal_transaction *prepare_player_removal_checked(int pfilepos)
       !*player_table[pfilepos].name)
     return NULL;
 
+  /* A save still in the writer would put the files back. */
+  persistence_writer_flush();
+
   CREATE(transaction, struct player_removal_transaction, 1);
   transaction->index_position = pfilepos;
   transaction->index_entry = player_table[pfilepos];
@@ -4410,7 +4824,9 @@ bool remove_player(int pfilepos)
     return FALSE;
   }
 
-  /* Unlink all player-owned files */
+  /* Unlink all player-owned files, once no save in the writer can put them
+   * back */
+  persistence_writer_flush();
   for (i = 0; i < MAX_FILES; i++)
   {
     if (get_filename(filename, sizeof(filename), i, player_table[pfilepos].name))
@@ -6432,95 +6848,24 @@ void reset_pet_save_cache_for_test(void)
 }
 #endif
 
-static uint64_t pet_hash_bytes(uint64_t hash, const void *data, size_t size)
-{
-  const unsigned char *bytes;
-  size_t i;
-
-  bytes = data;
-  for (i = 0; i < size; i++)
-  {
-    hash ^= bytes[i];
-    hash *= UINT64_C(1099511628211);
-  }
-  return hash;
-}
-
-static uint64_t pet_hash_string(uint64_t hash, const char *text)
-{
-  if (text == NULL)
-    return pet_hash_bytes(hash, "", 1);
-  return pet_hash_bytes(hash, text, strlen(text) + 1);
-}
-
-static uint64_t pet_hash_objects(uint64_t hash, const struct obj_data *obj)
-{
-  const struct extra_descr_data *extra;
-  const struct obj_special_ability *ability;
-  unsigned char marker;
-  int vnum;
-  int i;
-
-  for (; obj != NULL; obj = obj->next_content)
-  {
-    marker = 1;
-    hash = pet_hash_bytes(hash, &marker, sizeof(marker));
-    vnum = GET_OBJ_VNUM(obj);
-    hash = pet_hash_bytes(hash, &vnum, sizeof(vnum));
-    hash = pet_hash_bytes(hash, &obj->obj_flags, sizeof(obj->obj_flags));
-    hash = pet_hash_bytes(hash, obj->affected, sizeof(obj->affected));
-    hash = pet_hash_bytes(hash, &obj->weapon_poison, sizeof(obj->weapon_poison));
-    hash = pet_hash_bytes(hash, obj->activate_spell, sizeof(obj->activate_spell));
-    hash = pet_hash_bytes(hash, &obj->tinker_bonus, sizeof(obj->tinker_bonus));
-    hash = pet_hash_string(hash, obj->name);
-    hash = pet_hash_string(hash, obj->description);
-    hash = pet_hash_string(hash, obj->short_description);
-    hash = pet_hash_string(hash, obj->action_description);
-    hash = pet_hash_string(hash, obj->arcane_mark);
-    hash = pet_hash_string(hash, obj->restring_identifier);
-    for (extra = obj->ex_description; extra != NULL; extra = extra->next)
-    {
-      hash = pet_hash_string(hash, extra->keyword);
-      hash = pet_hash_string(hash, extra->description);
-    }
-    marker = 2;
-    hash = pet_hash_bytes(hash, &marker, sizeof(marker));
-    if (obj->sbinfo != NULL)
-      for (i = 0; i < SPELLBOOK_SIZE; i++)
-        hash = pet_hash_bytes(hash, &obj->sbinfo[i], sizeof(obj->sbinfo[i]));
-    for (ability = obj->special_abilities; ability != NULL; ability = ability->next)
-    {
-      hash = pet_hash_bytes(hash, &ability->ability, sizeof(ability->ability));
-      hash = pet_hash_bytes(hash, &ability->level, sizeof(ability->level));
-      hash = pet_hash_bytes(hash, &ability->activation_method, sizeof(ability->activation_method));
-      hash = pet_hash_bytes(hash, ability->value, sizeof(ability->value));
-      hash = pet_hash_string(hash, ability->command_word);
-    }
-    hash = pet_hash_objects(hash, obj->contains);
-  }
-  marker = 0;
-  hash = pet_hash_bytes(hash, &marker, sizeof(marker));
-  return hash;
-}
-
 static uint64_t pet_save_fingerprint(const struct pet_save_record *records)
 {
   const struct pet_save_record *record;
   uint64_t hash;
   int wear;
 
-  hash = UINT64_C(1469598103934665603);
+  hash = OBJSAVE_HASH_SEED;
   for (record = records; record != NULL; record = record->next)
   {
-    hash = pet_hash_string(hash, record->insert_query);
+    hash = objsave_hash_string(hash, record->insert_query);
     for (wear = 0; wear < NUM_WEARS; wear++)
     {
-      hash = pet_hash_bytes(hash, &wear, sizeof(wear));
-      hash = pet_hash_objects(hash, GET_EQ(record->pet, wear));
+      hash = objsave_hash_bytes(hash, &wear, sizeof(wear));
+      hash = objsave_hash_objects(hash, GET_EQ(record->pet, wear));
     }
     wear = -1;
-    hash = pet_hash_bytes(hash, &wear, sizeof(wear));
-    hash = pet_hash_objects(hash, record->pet->carrying);
+    hash = objsave_hash_bytes(hash, &wear, sizeof(wear));
+    hash = objsave_hash_objects(hash, record->pet->carrying);
   }
   return hash;
 }
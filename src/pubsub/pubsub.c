@@ -154,8 +154,9 @@ void pubsub_shutdown(void)
   }
   handler_list = NULL;
 
-  /* Clean up subscription cache */
+  /* Clean up subscription cache and the online subscriber index */
   pubsub_cleanup_cache();
+  pubsub_index_clear();
 
   pubsub_info("PubSub system shutdown complete");
 }
@@ -433,6 +434,8 @@ int pubsub_delete_topic_by_name(const char *name, const char *deleter_name)
     free(topic->description);
   if (topic->creator_name)
     free(topic->creator_name);
+  if (topic->online_subscribers)
+    free(topic->online_subscribers);
   free(topic);
 
   /* Update statistics */
@@ -529,8 +532,9 @@ int pubsub_subscribe(struct char_data *ch, int topic_id, const char *handler)
   /* Update in-memory topic */
   topic->subscriber_count++;
 
-  /* Update player's subscription cache */
+  /* Update player's subscription cache and the topic's online subscribers */
   pubsub_cache_player_subscriptions(player_name);
+  pubsub_index_add(ch, topic_id);
 
   /* Update statistics */
   pubsub_stats.total_subscriptions++;
@@ -541,6 +545,74 @@ int pubsub_subscribe(struct char_data *ch, int topic_id, const char *handler)
   return PUBSUB_SUCCESS;
 }
 
+/*
+ * Unsubscribe a player from a topic
+ */
+int pubsub_unsubscribe(struct char_data *ch, int topic_id)
+{
+  char query[MAX_STRING_LENGTH];
+  char escaped_player[64];
+  struct pubsub_topic *topic;
+
+  /* Input validation */
+  if (!ch || topic_id <= 0 || !GET_NAME(ch))
+  {
+    return PUBSUB_ERROR_INVALID_PARAM;
+  }
+
+  if (!pubsub_system_enabled)
+  {
+    return PUBSUB_ERROR_DATABASE;
+  }
+
+  topic = pubsub_find_topic_by_id(topic_id);
+  if (!topic)
+  {
+    return PUBSUB_ERROR_NOT_FOUND;
+  }
+
+  if (!pubsub_is_subscribed(GET_NAME(ch), topic_id))
+  {
+    return PUBSUB_ERROR_NOT_FOUND;
+  }
+
+  mysql_real_escape_string(conn, escaped_player, GET_NAME(ch), strlen(GET_NAME(ch)));
+
+  snprintf(query, sizeof(query),
+           "DELETE FROM pubsub_subscriptions WHERE topic_id = %d AND player_name = '%s'",
+           topic_id, escaped_player);
+
+  if (mysql_query(conn, query))
+  {
+    pubsub_error("PubSub unsubscribe failed: %s", mysql_error(conn));
+    return PUBSUB_ERROR_DATABASE;
+  }
+
+  snprintf(query, sizeof(query),
+           "UPDATE pubsub_topics SET subscriber_count = subscriber_count - 1 "
+           "WHERE topic_id = %d AND subscriber_count > 0",
+           topic_id);
+  mysql_query(conn, query);
+
+  if (topic->subscriber_count > 0)
+  {
+    topic->subscriber_count--;
+  }
+
+  pubsub_cache_player_subscriptions(GET_NAME(ch));
+  pubsub_index_remove(ch, topic_id);
+
+  if (pubsub_stats.active_subscriptions > 0)
+  {
+    pubsub_stats.active_subscriptions--;
+  }
+
+  pubsub_info("Player %s unsubscribed from topic '%s' (ID: %d)", GET_NAME(ch), topic->name,
+              topic_id);
+
+  return PUBSUB_SUCCESS;
+}
+
 /*
  * Publish a message to a topic (Phase 2A - uses message queue)
  */
@@ -550,7 +622,7 @@ int pubsub_publish(int topic_id, const char *sender_name, const char *content, i
   struct pubsub_topic *topic;
   struct pubsub_message *msg;
   struct char_data *target;
-  int processed = 0;
+  int processed = 0, i;
 
   if (!sender_name || !content || topic_id <= 0)
   {
@@ -588,25 +660,23 @@ int pubsub_publish(int topic_id, const char *sender_name, const char *content, i
   msg->metadata = NULL;
   msg->spatial_data = NULL;
 
-  /* Queue message for all subscribers */
-  /* Note: In a full implementation, we'd query the database for subscribers
-     * For now, we'll iterate through online players and check subscriptions */
+  /* Every recipient's queue node shares this one message; our own reference
+     * keeps it alive until the fan-out is done */
+  msg->reference_count = 1;
 
-  for (target = character_list; target; target = target->next)
+  /* Queue message for the topic's subscribers who are in the game */
+  for (i = 0; i < topic->online_count; i++)
   {
-    if (IS_NPC(target) || !target->desc)
+    target = topic->online_subscribers[i];
+    if (!target->desc)
       continue;
 
-    /* Check if player is subscribed to this topic */
-    if (pubsub_is_subscribed(GET_NAME(target), topic_id))
+    /* Get the player's preferred handler for this topic
+         * For now, we'll use the default "send_text" handler */
+    int result = pubsub_queue_message(msg, target, "send_text");
+    if (result == PUBSUB_SUCCESS)
     {
-      /* Get the player's preferred handler for this topic
-             * For now, we'll use the default "send_text" handler */
-      int result = pubsub_queue_message(msg, target, "send_text");
-      if (result == PUBSUB_SUCCESS)
-      {
-        processed++;
-      }
+      processed++;
     }
   }
 
@@ -615,11 +685,11 @@ int pubsub_publish(int topic_id, const char *sender_name, const char *content, i
   topic->total_messages++;
   topic->last_message_at = time(NULL);
 
-  pubsub_info("Published message to topic '%s' (ID: %d), queued for %d players", topic->name,
-              topic_id, processed);
+  pubsub_debug("Published message to topic '%s' (ID: %d), queued for %d players", topic->name,
+               topic_id, processed);
 
-  /* Clean up message structure (queue makes copies) */
-  PUBSUB_FREE_MESSAGE(msg);
+  /* Let go of our reference; the queue nodes hold the rest */
+  pubsub_release_message(msg);
 
   return processed > 0 ? PUBSUB_SUCCESS : PUBSUB_ERROR_NOT_FOUND;
 }
@@ -684,6 +754,7 @@ int pubsub_publish_wilderness_audio(int source_x, int source_y, int source_z,
   msg->expires_at = msg->created_at + 300; /* 5 minute TTL */
   msg->delivery_attempts = 0;
   msg->metadata = NULL;
+  msg->reference_count = 1;
 
   /* Find all players in wilderness within range */
   for (target = character_list; target; target = target->next)
@@ -730,8 +801,9 @@ int pubsub_publish_wilderness_audio(int source_x, int source_y, int source_z,
   pubsub_info("Published wilderness audio from (%d,%d,%d), delivered to %d players", source_x,
               source_y, source_z, processed);
 
-  /* NOTE: Don't free message here - it's still referenced by queued nodes
-     * Message will be freed when queue processing completes */
+  /* Let go of our reference; queued nodes keep the message until they are
+     * processed, and nobody in range means it goes now */
+  pubsub_release_message(msg);
 
   return PUBSUB_SUCCESS;
 }
@@ -990,6 +1062,9 @@ void pubsub_process_message_queue(void)
     return;
   }
 
+  /* Keep the online subscriber index in step with the database */
+  pubsub_index_refresh();
+
   /* Process queue every few pulses to avoid overloading */
   pulse_count++;
   if (pulse_count < 3)
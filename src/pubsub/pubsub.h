@@ -26,6 +26,7 @@
 #define PUBSUB_DEFAULT_MESSAGE_TTL 3600
 #define SUBSCRIPTION_CACHE_SIZE 1024
 #define CACHE_TIMEOUT 300
+#define PUBSUB_INDEX_REFRESH_BATCH 2 /* players whose subscriptions are reloaded per heartbeat */
 
 /* Message Queue Configuration */
 #define PUBSUB_QUEUE_MAX_SIZE 10000
@@ -130,6 +131,9 @@ struct pubsub_topic
   int message_ttl;
   bool is_persistent;
   bool is_active;
+  struct char_data **online_subscribers; /* Subscribers in the game, see pubsub_index.c */
+  int online_count;
+  int online_capacity;
   struct pubsub_topic *next;
 };
 
@@ -211,7 +215,7 @@ struct pubsub_message
   int failed_deliveries;
   bool is_processed;
   time_t processed_at;
-  int reference_count; /* Number of queue nodes referencing this message */
+  int reference_count; /* Queue nodes (and a publisher mid fan-out) holding this message */
   struct pubsub_message *next;
 };
 
@@ -390,6 +394,17 @@ int pubsub_queue_get_size(void);
 int pubsub_queue_get_priority_count(int priority);
 void pubsub_queue_start_processing(void);
 void pubsub_queue_stop_processing(void);
+void pubsub_queue_forget_player(struct char_data *ch);
+void pubsub_release_message(struct pubsub_message *msg);
+
+/* Online Subscriber Index */
+void pubsub_index_player_online(struct char_data *ch);
+void pubsub_index_player_offline(struct char_data *ch);
+void pubsub_index_set_player_topics(struct char_data *ch, const int *topic_ids, int count);
+void pubsub_index_add(struct char_data *ch, int topic_id);
+void pubsub_index_remove(struct char_data *ch, int topic_id);
+void pubsub_index_refresh(void);
+void pubsub_index_clear(void);
 
 /* Handler Management */
 int pubsub_register_handler(const char *name, const char *description, pubsub_handler_func func);
@@ -398,6 +413,7 @@ int pubsub_call_handler(struct char_data *ch, struct pubsub_message *msg, const
 
 /* Cache Management */
 void pubsub_cache_player_subscriptions(const char *player_name);
+struct pubsub_player_cache *pubsub_get_player_cache(const char *player_name);
 void pubsub_invalidate_player_cache(const char *player_name);
 void pubsub_cleanup_cache(void);
 
@@ -467,6 +483,8 @@ void pubsub_trigger_event(const char *event_topic, struct char_data *ch, const c
         free((t)->name);                                                                           \
       if ((t)->description)                                                                        \
         free((t)->description);                                                                    \
+      if ((t)->online_subscribers)                                                                 \
+        free((t)->online_subscribers);                                                             \
       free(t);                                                                                     \
     }                                                                                              \
   } while (0)
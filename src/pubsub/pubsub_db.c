@@ -250,6 +250,35 @@ void pubsub_cache_player_subscriptions(const char *player_name)
   pubsub_debug("Cached %d subscriptions for player %s", cache->subscription_count, player_name);
 }
 
+/*
+ * Find a player's cached subscriptions without reloading them
+ */
+struct pubsub_player_cache *pubsub_get_player_cache(const char *player_name)
+{
+  struct pubsub_player_cache *cache;
+  int hash, i;
+
+  if (!player_name)
+  {
+    return NULL;
+  }
+
+  hash = 0;
+  for (i = 0; player_name[i]; i++)
+  {
+    hash = (hash * 31 + player_name[i]) % SUBSCRIPTION_CACHE_SIZE;
+  }
+
+  for (cache = subscription_cache[hash]; cache; cache = cache->next)
+  {
+    if (cache->player_name && strcmp(cache->player_name, player_name) == 0)
+    {
+      return cache;
+    }
+  }
+  return NULL;
+}
+
 /*
  * Check if player is subscribed to topic (with caching)
  */
@@ -0,0 +1,204 @@
+/*************************************************************************
+*   File: pubsub_index.c                               Part of LuminariMUD *
+*  Usage: Topic to online subscriber index for PubSub                     *
+*  Author: Luminari Development Team                                       *
+*                                                                          *
+*  All rights reserved.  See license for complete information.            *
+*                                                                          *
+*  LuminariMUD is based on CircleMUD, Copyright (C) 1993, 94 by the       *
+*  Department of Computer Science at the Johns Hopkins University         *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+/*
+ * Each topic keeps the players in the game who subscribe to it, so that
+ * publishing walks only those players instead of every character.  The
+ * lists are filled from the subscription cache when a player enters the
+ * game, follow subscribe and unsubscribe, and are refreshed from the
+ * database a few players at a time from the heartbeat, never while
+ * publishing.
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "db.h"
+#include "pubsub.h"
+
+struct pubsub_online_player
+{
+  struct char_data *ch;
+  time_t refreshed_at;
+};
+
+static struct
+{
+  struct pubsub_online_player *players;
+  int count;
+  int capacity;
+  int cursor; /* Where the heartbeat refresh picks up next */
+} online;
+
+static int find_online_player(struct char_data *ch)
+{
+  int i;
+
+  for (i = 0; i < online.count; i++)
+    if (online.players[i].ch == ch)
+      return i;
+  return -1;
+}
+
+static void topic_add_subscriber(struct pubsub_topic *topic, struct char_data *ch)
+{
+  int i;
+
+  for (i = 0; i < topic->online_count; i++)
+    if (topic->online_subscribers[i] == ch)
+      return;
+
+  if (topic->online_count == topic->online_capacity)
+  {
+    topic->online_capacity = MAX(8, topic->online_capacity * 2);
+    RECREATE(topic->online_subscribers, struct char_data *, topic->online_capacity);
+  }
+  topic->online_subscribers[topic->online_count++] = ch;
+}
+
+static void topic_remove_subscriber(struct pubsub_topic *topic, struct char_data *ch)
+{
+  int i;
+
+  for (i = 0; i < topic->online_count; i++)
+    if (topic->online_subscribers[i] == ch)
+    {
+      topic->online_subscribers[i] = topic->online_subscribers[--topic->online_count];
+      return;
+    }
+}
+
+/*
+ * Replace the topics a player is listed under
+ */
+void pubsub_index_set_player_topics(struct char_data *ch, const int *topic_ids, int count)
+{
+  struct pubsub_topic *topic;
+  int i;
+
+  if (!ch || IS_NPC(ch))
+    return;
+
+  for (topic = topic_list; topic; topic = topic->next)
+    topic_remove_subscriber(topic, ch);
+
+  for (i = 0; i < count; i++)
+    if ((topic = pubsub_find_topic_by_id(topic_ids[i])) != NULL)
+      topic_add_subscriber(topic, ch);
+}
+
+/* Reload a player's subscriptions; if the database could not be reached
+ * they keep the topics they had. */
+static void refresh_online_player(struct pubsub_online_player *player)
+{
+  struct pubsub_player_cache *cache;
+
+  player->refreshed_at = time(NULL);
+  pubsub_cache_player_subscriptions(GET_NAME(player->ch));
+  if ((cache = pubsub_get_player_cache(GET_NAME(player->ch))) != NULL)
+    pubsub_index_set_player_topics(player->ch, cache->subscribed_topics,
+                                   cache->subscription_count);
+}
+
+/*
+ * A player entered the game: list them under their topics
+ */
+void pubsub_index_player_online(struct char_data *ch)
+{
+  int i;
+
+  if (!ch || IS_NPC(ch) || !pubsub_system_enabled)
+    return;
+
+  if ((i = find_online_player(ch)) < 0)
+  {
+    if (online.count == online.capacity)
+    {
+      online.capacity = MAX(32, online.capacity * 2);
+      RECREATE(online.players, struct pubsub_online_player, online.capacity);
+    }
+    i = online.count++;
+    online.players[i].ch = ch;
+  }
+  refresh_online_player(&online.players[i]);
+}
+
+/*
+ * A player is leaving the game: drop them from every topic and drop any
+ * messages still queued for them
+ */
+void pubsub_index_player_offline(struct char_data *ch)
+{
+  int i;
+
+  if (!ch || IS_NPC(ch))
+    return;
+
+  if ((i = find_online_player(ch)) >= 0)
+    online.players[i] = online.players[--online.count];
+
+  pubsub_index_set_player_topics(ch, NULL, 0);
+  pubsub_queue_forget_player(ch);
+}
+
+/*
+ * Follow a single subscribe or unsubscribe
+ */
+void pubsub_index_add(struct char_data *ch, int topic_id)
+{
+  struct pubsub_topic *topic;
+
+  if (ch && !IS_NPC(ch) && (topic = pubsub_find_topic_by_id(topic_id)) != NULL)
+    topic_add_subscriber(topic, ch);
+}
+
+void pubsub_index_remove(struct char_data *ch, int topic_id)
+{
+  struct pubsub_topic *topic;
+
+  if (ch && (topic = pubsub_find_topic_by_id(topic_id)) != NULL)
+    topic_remove_subscriber(topic, ch);
+}
+
+/*
+ * Reload the subscriptions of a few players whose lists are older than
+ * CACHE_TIMEOUT (called from the heartbeat)
+ */
+void pubsub_index_refresh(void)
+{
+  time_t now = time(NULL);
+  int looked, refreshed = 0;
+  struct pubsub_online_player *player;
+
+  for (looked = 0; looked < online.count && refreshed < PUBSUB_INDEX_REFRESH_BATCH; looked++)
+  {
+    if (online.cursor >= online.count)
+      online.cursor = 0;
+    player = &online.players[online.cursor++];
+    if (now - player->refreshed_at <= CACHE_TIMEOUT)
+      continue;
+    refresh_online_player(player);
+    refreshed++;
+  }
+}
+
+/*
+ * Forget every online player (the topics free their own lists)
+ */
+void pubsub_index_clear(void)
+{
+  free(online.players);
+  online.players = NULL;
+  online.count = online.capacity = online.cursor = 0;
+}
@@ -426,6 +426,67 @@ void pubsub_queue_stop_processing(void)
   pubsub_info("PubSub queue processing stopped");
 }
 
+/*
+ * Drop one reference to a message, freeing it with the last one
+ */
+void pubsub_release_message(struct pubsub_message *msg)
+{
+  if (msg && --msg->reference_count <= 0)
+  {
+    PUBSUB_FREE_MESSAGE(msg);
+  }
+}
+
+/* Unlink and free every node in one priority list that targets ch */
+static void forget_player_in(struct pubsub_queue_node **head, struct pubsub_queue_node **tail,
+                             int *count, struct char_data *ch)
+{
+  struct pubsub_queue_node *node, *next, *prev = NULL;
+
+  for (node = *head; node; node = next)
+  {
+    next = node->next;
+    if (node->target_player != ch)
+    {
+      prev = node;
+      continue;
+    }
+
+    if (prev)
+      prev->next = next;
+    else
+      *head = next;
+    if (*tail == node)
+      *tail = prev;
+    (*count)--;
+    message_queue.total_queued--;
+    free_queue_node(node);
+  }
+}
+
+/*
+ * Drop everything still queued for a character who is leaving the game
+ */
+void pubsub_queue_forget_player(struct char_data *ch)
+{
+  if (!ch || message_queue.total_queued <= 0)
+  {
+    return;
+  }
+
+  forget_player_in(&message_queue.critical_head, &message_queue.critical_tail,
+                   &message_queue.critical_count, ch);
+  forget_player_in(&message_queue.urgent_head, &message_queue.urgent_tail,
+                   &message_queue.urgent_count, ch);
+  forget_player_in(&message_queue.high_head, &message_queue.high_tail, &message_queue.high_count,
+                   ch);
+  forget_player_in(&message_queue.normal_head, &message_queue.normal_tail,
+                   &message_queue.normal_count, ch);
+  forget_player_in(&message_queue.low_head, &message_queue.low_tail, &message_queue.low_count, ch);
+
+  update_queue_statistics();
+}
+
 /*
  * Static helper functions
  */
@@ -455,16 +516,8 @@ static void free_queue_node(struct pubsub_queue_node *node)
 {
   if (node)
   {
-    /* Decrement reference count on the message */
-    if (node->message)
-    {
-      node->message->reference_count--;
-      /* If no more references, free the message */
-      if (node->message->reference_count <= 0)
-      {
-        PUBSUB_FREE_MESSAGE(node->message);
-      }
-    }
+    /* Drop this node's reference on the message */
+    pubsub_release_message(node->message);
 
     if (node->handler_name)
     {
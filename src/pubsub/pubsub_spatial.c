@@ -25,6 +25,7 @@
 #include "screen.h"
 #include "constants.h"
 #include "wilderness/wilderness.h"
+#include "wilderness/spatial_grid.h"
 #include "pubsub.h"
 
 /* Constants for spatial audio calculations */
@@ -57,11 +58,14 @@ struct spatial_audio_source
   float volume;
   time_t start_time;
   int duration;
+  int grid_cell; /* In audio_source_grid */
   struct spatial_audio_source *next;
 };
 
-/* Global audio source tracking */
+/* Global audio source tracking, also filed by where each source is */
 static struct spatial_audio_source *active_audio_sources = NULL;
+static struct spatial_grid audio_source_grid;
+static struct spatial_grid_result nearby_audio_sources;
 
 /* Static function prototypes */
 static float calculate_distance_3d(int x1, int y1, int z1, int x2, int y2, int z2);
@@ -71,8 +75,9 @@ static bool has_line_of_sound(int listener_x, int listener_y, int source_x, int
 static void add_audio_source(int x, int y, int z, const char *content, const char *source_name,
                              int priority, float volume, int duration);
 static void remove_expired_audio_sources(void);
-static struct spatial_audio_source *get_nearby_audio_sources(int x, int y, int max_distance);
-static char *blend_audio_sources(struct char_data *ch, struct spatial_audio_source *sources);
+static int get_nearby_audio_sources(int x, int y, int max_distance);
+static char *blend_audio_sources(struct char_data *ch, struct spatial_audio_source **sources,
+                                 int source_count);
 static float get_sector_audio_modifier(int sector_type);
 
 /*
@@ -299,7 +304,7 @@ int pubsub_handler_wilderness_spatial_audio(struct char_data *ch, struct pubsub_
  */
 int pubsub_handler_audio_mixing(struct char_data *ch, struct pubsub_message *msg)
 {
-  struct spatial_audio_source *nearby_sources;
+  int nearby_count;
   char *mixed_audio;
 
   if (!ch || !ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
@@ -311,16 +316,17 @@ int pubsub_handler_audio_mixing(struct char_data *ch, struct pubsub_message *msg
   remove_expired_audio_sources();
 
   /* Get nearby audio sources */
-  nearby_sources = get_nearby_audio_sources(X_LOC(ch), Y_LOC(ch), SPATIAL_AUDIO_MAX_DISTANCE);
+  nearby_count = get_nearby_audio_sources(X_LOC(ch), Y_LOC(ch), SPATIAL_AUDIO_MAX_DISTANCE);
 
-  if (!nearby_sources)
+  if (!nearby_count)
   {
     /* No other audio sources, process normally */
     return pubsub_handler_wilderness_spatial_audio(ch, msg);
   }
 
   /* Blend multiple audio sources */
-  mixed_audio = blend_audio_sources(ch, nearby_sources);
+  mixed_audio = blend_audio_sources(
+      ch, (struct spatial_audio_source **)nearby_audio_sources.items, nearby_count);
 
   if (mixed_audio)
   {
@@ -457,6 +463,7 @@ static void add_audio_source(int x, int y, int z, const char *content, const cha
   source->volume = volume;
   source->start_time = time(NULL);
   source->duration = duration;
+  source->grid_cell = spatial_grid_insert(&audio_source_grid, source, x, y);
   source->next = active_audio_sources;
 
   active_audio_sources = source;
@@ -483,6 +490,7 @@ static void remove_expired_audio_sources(void)
         active_audio_sources = next;
       }
 
+      spatial_grid_remove(&audio_source_grid, source, source->grid_cell);
       if (source->content)
         free(source->content);
       if (source->source_name)
@@ -496,44 +504,47 @@ static void remove_expired_audio_sources(void)
   }
 }
 
-static struct spatial_audio_source *get_nearby_audio_sources(int x, int y, int max_distance)
+static int compare_audio_source_age(const void *a, const void *b)
 {
-  struct spatial_audio_source *source, *nearby = NULL, *new_source;
-  float distance;
+  const struct spatial_audio_source *first = *(struct spatial_audio_source *const *)a;
+  const struct spatial_audio_source *second = *(struct spatial_audio_source *const *)b;
 
-  for (source = active_audio_sources; source; source = source->next)
-  {
-    distance = calculate_distance_3d(x, y, 0, source->source_x, source->source_y, source->source_z);
+  if (first->start_time != second->start_time)
+    return first->start_time < second->start_time ? -1 : 1;
+  return 0;
+}
 
-    if (distance <= max_distance)
-    {
-      /* Create a copy for the nearby list */
-      CREATE(new_source, struct spatial_audio_source, 1);
-      *new_source = *source; /* Copy all fields */
-      new_source->content = strdup(source->content);
-      new_source->source_name = strdup(source->source_name);
-      new_source->next = nearby;
-      nearby = new_source;
-    }
+/* Gather the sources within max_distance into nearby_audio_sources, oldest
+ * first, and return how many there are.  The entries point at the live
+ * sources, which stay put until remove_expired_audio_sources() runs. */
+static int get_nearby_audio_sources(int x, int y, int max_distance)
+{
+  struct spatial_audio_source *source;
+  int i, kept = 0;
+
+  spatial_grid_query(&audio_source_grid, x, y, max_distance, &nearby_audio_sources);
+  for (i = 0; i < nearby_audio_sources.count; i++)
+  {
+    source = nearby_audio_sources.items[i];
+    if (calculate_distance_3d(x, y, 0, source->source_x, source->source_y, source->source_z) <=
+        max_distance)
+      nearby_audio_sources.items[kept++] = source;
   }
+  nearby_audio_sources.count = kept;
 
-  return nearby;
+  qsort(nearby_audio_sources.items, kept, sizeof(*nearby_audio_sources.items),
+        compare_audio_source_age);
+  return kept;
 }
 
 static char *blend_audio_sources(struct char_data *ch __attribute__((unused)),
-                                 struct spatial_audio_source *sources)
+                                 struct spatial_audio_source **sources, int source_count)
 {
   char *result;
   struct spatial_audio_source *source;
-  int count = 0;
-
-  /* Count sources and limit to maximum */
-  for (source = sources; source && count < MAX_CONCURRENT_AUDIO_SOURCES; source = source->next)
-  {
-    count++;
-  }
+  int count = MIN(source_count, MAX_CONCURRENT_AUDIO_SOURCES), i;
 
-  if (count == 0)
+  if (count <= 0)
     return NULL;
 
   CREATE(result, char, MAX_STRING_LENGTH);
@@ -541,8 +552,8 @@ static char *blend_audio_sources(struct char_data *ch __attribute__((unused)),
   if (count == 1)
   {
     /* Single source, no mixing needed */
-    snprintf(result, MAX_STRING_LENGTH, "You hear %s from %s.\r\n", sources->content,
-             sources->source_name);
+    snprintf(result, MAX_STRING_LENGTH, "You hear %s from %s.\r\n", sources[0]->content,
+             sources[0]->source_name);
   }
   else
   {
@@ -550,11 +561,12 @@ static char *blend_audio_sources(struct char_data *ch __attribute__((unused)),
     snprintf(result, MAX_STRING_LENGTH, "You hear a mixture of sounds: ");
 
     int pos = strlen(result);
-    for (source = sources; source && count > 0; source = source->next, count--)
+    for (i = 0; i < count; i++)
     {
+      source = sources[i];
       if (pos + strlen(source->content) + 20 < MAX_STRING_LENGTH)
       {
-        if (count > 1)
+        if (i < count - 1)
         {
           pos = snprintf_append(result, MAX_STRING_LENGTH, pos, "%s, ", source->content);
         }
@@ -589,4 +601,6 @@ void pubsub_spatial_cleanup(void)
   }
 
   active_audio_sources = NULL;
+  spatial_grid_free(&audio_source_grid);
+  spatial_grid_free_result(&nearby_audio_sources);
 }
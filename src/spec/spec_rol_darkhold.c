@@ -12,6 +12,7 @@
 #include "act.h"
 #include "comm.h"
 #include "db.h"
+#include "graph.h"
 #include "handler.h"
 #include "interpreter.h"
 #include "magic/domains_schools.h"
@@ -191,7 +192,10 @@ static int rol_darkhold_gem(struct char_data *ch, struct obj_data *obj,
   act("As you try to drop $p, a flashing light brightens the room.", TRUE, ch, obj, NULL, TO_CHAR);
   act("As $n tries to drop $p, a flashing light brightens the room.", TRUE, ch, obj, NULL, TO_ROOM);
   if (exit->to_room != destination)
+  {
     exit->to_room = destination;
+    graph_exits_changed();
+  }
   return TRUE;
 }
 
@@ -13,6 +13,7 @@
 #include "comm.h"
 #include "interpreter.h"
 #include "db.h"
+#include "graph.h"
 #include "spec_zone_abyss.h"
 
 #define ZONE_VNUM 1423
@@ -145,6 +146,7 @@ SPECIAL(abyss_randomizer)
       world[current_room].dir_option[DOWN] = NULL;
     }
   }
+  graph_exits_changed();
 
   snprintf(buf, sizeof(buf), "\tpThe world seems to shift.\tn\r\n");
 
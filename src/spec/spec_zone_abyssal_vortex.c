@@ -13,6 +13,7 @@
 #include "comm.h"
 #include "interpreter.h"
 #include "db.h"
+#include "graph.h"
 #include "spec_zone_abyssal_vortex.h"
 
 /* from homeland */
@@ -35,6 +36,7 @@ SPECIAL(abyssal_vortex)
     world[ch->in_room].dir_option[3]->to_room = world[ch->in_room].dir_option[5]->to_room;
     world[ch->in_room].dir_option[5]->to_room = world[ch->in_room].dir_option[2]->to_room;
     world[ch->in_room].dir_option[2]->to_room = temp;
+    graph_exits_changed();
 
     send_to_room(ch->in_room,
                  "\tLThe reality seems to \tCshift\tL as madness descends in the \tcvortex\tn\r\n");
@@ -14,6 +14,7 @@
 #include "interpreter.h"
 #include "handler.h"
 #include "db.h"
+#include "graph.h"
 #include "magic/spells.h"
 #include "act.h"
 #include "spec_zone_kenjin_tower.h"
@@ -114,6 +115,7 @@ SPECIAL(kt_twister)
 
       world[real_room(132901)].dir_option[3]->to_room;
   world[real_room(32901)].dir_option[3]->to_room = temp;
+  graph_exits_changed();
 
   send_to_room(real_room(132901), "\tCThe world seems to turn.\tn\r\n");
 
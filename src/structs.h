@@ -6288,6 +6288,24 @@ struct condensed_combat_data
   int num_times_hit_by_spell;
 };
 
+/** Words needed for one bit per APPLY_ location. */
+#define AFFECT_BONUS_MASK_WORDS ((NUM_APPLIES + 31) / 32)
+
+/** Cached per-location totals of non-stacking bonuses, used by affect_total().
+ * total[loc] equals the sum over bonus types of calculate_best_mod(ch, loc,
+ * type, -1, -1). Affect and equipment changes mark only the locations they
+ * touch as dirty; the fingerprints catch anything edited behind our back. */
+struct affect_bonus_cache
+{
+  int total[NUM_APPLIES];                       /**< Best bonus minus penalties, all types */
+  ubyte wield_sig[NUM_APPLIES];                 /**< Size/hands state total[] was built with */
+  unsigned int dirty[AFFECT_BONUS_MASK_WORDS];  /**< Locations needing a rebuild */
+  unsigned int weapon[AFFECT_BONUS_MASK_WORDS]; /**< Locations fed by a worn weapon */
+  unsigned int affect_hash;                     /**< Fingerprint of ch->affected */
+  unsigned int gear_hash;                       /**< Fingerprint of worn gear affects */
+  bool valid;                                   /**< FALSE until the first full build */
+};
+
 /** Special playing constants shared by PCs and NPCs which aren't in pfile */
 struct char_special_data
 {
@@ -6340,6 +6358,7 @@ struct char_special_data
   unsigned long crescendo_last_cast_serial;   /* last Crescendo invocation received */
   int affect_batch_depth;                     /* nested deferred affect MSDP updates */
   bool affect_batch_dirty;                    /* affect state changed in current batch */
+  struct affect_bonus_cache bonus_cache;      /* incremental affect_total() totals */
 
   /** crafting **/
   ubyte crafting_type;              // like SCMD_x
@@ -6962,6 +6981,10 @@ struct player_special_data
   int save_co_holder_dc_bonus; // a holder for bonus to save dc for psionic_concussive_onslaught
   bool cosmic_awareness;       // cosmic awareness psionic power and command
   int energy_conversion[NUM_DAM_TYPES]; // energy conversion ability
+  ubyte equip_feats[NUM_FEATS];         // worn items granting each feat, see rebuild_equip_feats()
+  unsigned long long obj_save_fingerprint; // Crash_crashsave() hash at the last commit
+  bool obj_save_fingerprint_valid;         // player_save_objs still holds that save
+  unsigned long long obj_save_sequence;    // Bumped per save; only the newest sets the hash
 
   int casting_class;   // The class number that is currently casting a spell
   sbyte canCastInnate; // for innate racial skills and other innate powers
@@ -7358,6 +7381,12 @@ struct char_data
   struct char_data *next;          /**< Next char_data in the room */
   struct char_data *next_fighting; /**< Next in line to fight */
 
+  struct char_data *next_in_zone; /**< Zone presence list, see zone_presence.h */
+  struct char_data *prev_in_zone;
+  bool in_zone_presence; /**< On its zone's presence list */
+  int spatial_grid_cell;  /**< Wilderness player grid cell, see spatial_grid.h */
+  bool in_spatial_grid;   /**< Filed in the wilderness player grid */
+
   struct follow_type *followers; /**< List of characters following */
   struct char_data *master;      /**< List of character being followed */
 
@@ -7392,6 +7421,16 @@ struct txt_block
   struct txt_block *next; /**< ? */
 };
 
+/** A fixed-size piece of a descriptor's output queue, after the first one in
+ * small_outbuf.  Segments not in use wait on a pool in comm.c. */
+struct output_segment
+{
+  char text[SMALL_BUFSIZE];    /**< Queued output, NUL-terminated */
+  size_t length;               /**< Bytes of text queued */
+  size_t sent;                 /**< Bytes of text already written out */
+  struct output_segment *next; /**< Next segment of the queue or pool */
+};
+
 /** ? */
 struct txt_q
 {
@@ -7457,21 +7496,30 @@ struct descriptor_data
   char inbuf[MAX_RAW_INPUT_LENGTH];  /**< buffer for raw input		*/
   char last_input[MAX_INPUT_LENGTH]; /**< the last input			*/
   char small_outbuf[SMALL_BUFSIZE];  /**< standard output buffer		*/
-  char *output;                      /**< ptr to the current output buffer	*/
+  char *output;                      /**< ptr to unsent output, first segment */
   char **history;                    /**< History of commands, for ! mostly.	*/
   int history_pos;                   /**< Circular array position.		*/
-  int bufptr;                        /**< ptr to end of current output		*/
-  int bufspace;                      /**< space left in the output buffer	*/
-  struct txt_block *large_outbuf;    /**< ptr to large buffer, if we need it */
+  int bufptr;                        /**< bytes of output queued		*/
+  int bufspace;                      /**< space left in the last segment	*/
+  struct output_segment *output_segments; /**< queued after small_outbuf */
+  struct output_segment *output_tail;     /**< last of output_segments */
   struct txt_q input;                /**< q of unprocessed input		*/
   struct char_data *character;       /**< linked to char			*/
   struct char_data *original;        /**< original char if switched		*/
   struct descriptor_data *snooping;  /**< Who is this char snooping	*/
   struct descriptor_data *snoop_by;  /**< And who is snooping this char	*/
   struct descriptor_data *next;      /**< link to next descriptor		*/
+  struct descriptor_data *next_output; /**< next in the pending output list */
+  bool output_pending;                 /**< queued for the next output pass */
   struct oasis_olc_data *olc;        /**< OLC info */
 
   protocol_t *pProtocol;    /**< Kavir plugin */
+  struct mccp_stream *mccp;    /**< MCCP2 output compression, NULL when off */
+  struct mccp_stream *mccp_in; /**< MCCP3 input decompression, NULL when off */
+  int msdp_dirty;                   /**< MSDP_DIRTY_* values to rebuild next MSDP pulse */
+  struct char_data *msdp_character; /**< Character the MSDP values were built for */
+  unsigned long msdp_group_sig;     /**< Fingerprint of the GROUP table last built */
+  unsigned long msdp_status_sig;    /**< Fingerprint of the status values last built */
   struct list_data *events; // event system
 
   struct account_data *account; /**< Account system */
@@ -7804,6 +7852,8 @@ struct game_operation
   int protocol_negotiation; /**< Enable the protocol negotiation system ? */
   int special_in_comm;      /**< Enable use of a special character in communication channels ? */
   int debug_mode;           /**< Current Debug Mode */
+  int mob_active_ring;      /**< Zones around an occupied zone kept at full mob AI */
+  int mob_dormant_cadence;  /**< Dormant mob AI runs 1 cycle in N; 0 off, -1 never */
 };
 
 /** The Autowizard options. */
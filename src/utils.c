@@ -5032,13 +5032,85 @@ const char *get_align_by_num(int align)
   return "Unknown";
 }
 /* Feats */
-int get_feat_value(struct char_data *ch, int featnum)
+/** Set to TRUE to check every cached HAS_FEAT() answer against the old
+ * equipment scan and log any difference. */
+#if defined(FEAT_CACHE_VALIDATE)
+bool feat_cache_validate = TRUE;
+#else
+bool feat_cache_validate = FALSE;
+#endif
+
+/* Rebuild the count of worn items granting each feat. Called by equip_char()
+ * and unequip_char() so get_feat_value() never has to walk the gear.
+ *
+ * BEGINNERS NOTE: HAS_FEAT() is called hundreds of times per combat round.
+ * Equipment changes are rare by comparison, so we pay for the scan here. */
+void rebuild_equip_feats(struct char_data *ch)
+{
+  struct obj_data *obj;
+  int i, j, k, featnum;
+
+  if (!ch || IS_NPC(ch) || !ch->player_specials)
+    return;
+
+  memset(ch->player_specials->equip_feats, 0, sizeof(ch->player_specials->equip_feats));
+  for (j = 0; j < NUM_WEARS; j++)
+  {
+    if ((obj = GET_EQ(ch, j)) == NULL)
+      continue;
+    for (i = 0; i < MAX_OBJ_AFFECT; i++)
+    {
+      if (obj->affected[i].location != APPLY_FEAT)
+        continue;
+      featnum = obj->affected[i].modifier;
+      if (featnum <= FEAT_UNDEFINED || featnum >= FEAT_LAST_FEAT)
+        continue;
+      /* capped at +1 per item, sorry folks */
+      for (k = 0; k < i; k++)
+        if (obj->affected[k].location == APPLY_FEAT && obj->affected[k].modifier == featnum)
+          break;
+      if (k == i)
+        ch->player_specials->equip_feats[featnum]++;
+    }
+  }
+}
+
+/* The original, uncached lookup. Kept for feat_cache_validate. */
+static int get_feat_value_slow(struct char_data *ch, int featnum)
 {
   struct obj_data *obj;
   struct char_data *mob = NULL;
   int i = 0, j = 0;
   int featval = 0;
 
+  /* check if we got this feat equipped */
+  for (j = 0; j < NUM_WEARS; j++)
+  {
+    if ((obj = GET_EQ(ch, j)) == NULL)
+      continue;
+    for (i = 0; i < MAX_OBJ_AFFECT; i++)
+    {
+      if (obj->affected[i].location == APPLY_FEAT && obj->affected[i].modifier == featnum)
+      {
+        featval++;
+        break; /* capped at +1, sorry folks */
+      }
+    }
+  }
+  featval += HAS_REAL_FEAT(ch, featnum);
+  if ((mob = get_mob_follower(ch, MOB_EIDOLON)))
+  {
+    if (HAS_EVOLUTION(mob, EVOLUTION_RIDER_BOND) && featnum == FEAT_MOUNTED_COMBAT)
+      featval++;
+  }
+  return featval;
+}
+
+int get_feat_value(struct char_data *ch, int featnum)
+{
+  struct char_data *mob = NULL;
+  int featval = 0;
+
   if ((featnum <= FEAT_UNDEFINED) || (featnum >= FEAT_LAST_FEAT))
   {
     log("SYSERR: %s called get_feat_value with invalid featnum: %d", GET_NAME(ch), featnum);
@@ -5050,27 +5122,26 @@ int get_feat_value(struct char_data *ch, int featnum)
     featval = MOB_HAS_FEAT(ch, featnum);
   else if (AFF_FLAGGED(ch, AFF_WILD_SHAPE) && GET_DISGUISE_RACE(ch))
     featval = MOB_HAS_FEAT(ch, featnum);
+  else if (!ch->player_specials)
+    featval = get_feat_value_slow(ch, featnum);
   else
   {
-    /* check if we got this feat equipped */
-    for (j = 0; j < NUM_WEARS; j++)
+    /* equipped feats are counted by rebuild_equip_feats() */
+    featval = ch->player_specials->equip_feats[featnum] + HAS_REAL_FEAT(ch, featnum);
+
+    /* only one feat depends on our eidolon, so only look for it then */
+    if (featnum == FEAT_MOUNTED_COMBAT && (mob = get_mob_follower(ch, MOB_EIDOLON)))
     {
-      if ((obj = GET_EQ(ch, j)) == NULL)
-        continue;
-      for (i = 0; i < MAX_OBJ_AFFECT; i++)
-      {
-        if (obj->affected[i].location == APPLY_FEAT && obj->affected[i].modifier == featnum)
-        {
-          featval++;
-          break; /* capped at +1, sorry folks */
-        }
-      }
+      if (HAS_EVOLUTION(mob, EVOLUTION_RIDER_BOND))
+        featval++;
     }
-    featval += HAS_REAL_FEAT(ch, featnum);
-    if ((mob = get_mob_follower(ch, MOB_EIDOLON)))
+
+    if (feat_cache_validate && featval != get_feat_value_slow(ch, featnum))
     {
-      if (HAS_EVOLUTION(mob, EVOLUTION_RIDER_BOND) && featnum == FEAT_MOUNTED_COMBAT)
-        featval++;
+      log("SYSERR: %s has cached feat %d value %d, equipment scan says %d", GET_NAME(ch), featnum,
+          featval, get_feat_value_slow(ch, featnum));
+      rebuild_equip_feats(ch);
+      featval = get_feat_value_slow(ch, featnum);
     }
   }
 
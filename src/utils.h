@@ -457,6 +457,8 @@ bool ensure_dir_exists(const char *path);
 
 /* Feats */
 int get_feat_value(struct char_data *ch, int featnum);
+void rebuild_equip_feats(struct char_data *ch);
+extern bool feat_cache_validate;
 
 /* Public functions made available form weather.c */
 void weather_and_time(int mode);
@@ -2702,6 +2704,10 @@ bool can_blood_drain_target(struct char_data *ch, struct char_data *vict);
 #define CONFIG_SPECIAL_IN_COMM config_info.operation.special_in_comm
 /** Activate debug mode? */
 #define CONFIG_DEBUG_MODE config_info.operation.debug_mode
+/** How many zones out from an occupied zone mobiles keep full-rate AI. */
+#define CONFIG_MOB_ACTIVE_RING config_info.operation.mob_active_ring
+/** Mobiles in dormant zones act one cycle in this many (0 off, -1 never). */
+#define CONFIG_MOB_DORMANT_CADENCE config_info.operation.mob_dormant_cadence
 
 /* Autowiz */
 /** Use autowiz or not? */
@@ -12,6 +12,7 @@
 #include "interpreter.h"
 #include "handler.h"
 #include "db.h"
+#include "graph.h"
 #include "vessels.h"
 #include "act.h"
 #include "character/abilities.h"
@@ -174,6 +175,7 @@ void create_ship_connection(room_rnum room1, room_rnum room2, int dir)
                     world[room2].number, world[room1].number);
   }
 
+  graph_exits_changed();
   VSSL_DEBUG_EXIT("create_ship_connection");
 }
 
@@ -231,6 +233,8 @@ void remove_ship_connection(room_rnum room1, room_rnum room2)
   }
 
   VSSL_DEBUG_DOCK("Removed %d connection(s)", removed_count);
+  if (removed_count)
+    graph_exits_changed();
   VSSL_DEBUG_EXIT("remove_ship_connection");
 }
 
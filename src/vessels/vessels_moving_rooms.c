@@ -12,6 +12,7 @@
 #include "utils.h"
 #include "comm.h"
 #include "db.h"
+#include "graph.h"
 #include "spec/spec_dispatch.h"
 #include "vessels_moving_rooms.h"
 
@@ -323,6 +324,7 @@ int unlinkMovingRoom(struct moving_room_data *theRoom, struct oldNextMove *ONMda
     free(world[real_room(ONMdata->oldRoom)].dir_option[ONMdata->oldDir]);
 #endif
     world[real_room(ONMdata->oldRoom)].dir_option[ONMdata->oldDir] = NULL;
+    graph_exits_changed();
 
     /* log("SPEC(move): all is Ok after unlinking the old room..."); */
     sprintf(errStr, "SPEC(moving_rooms): [%d] unlinked %d  FROM  %d", (int)ONMdata->moveRoom,
@@ -432,6 +434,7 @@ return 0;
     world[real_room(ONMdata->moveRoom)].dir_option[theRoom->inbound_dir]->key = -1;
     world[real_room(ONMdata->moveRoom)].dir_option[theRoom->inbound_dir]->to_room =
         real_room(ONMdata->nextRoom);
+    graph_exits_changed();
 
     /*  play 'dest_docking' message  */
     if (theRoom->msg_dest_docking)
@@ -12,6 +12,7 @@
 #include "interpreter.h"
 #include "handler.h"
 #include "db.h"
+#include "graph.h"
 #include "vessels.h"
 #include "constants.h"
 #include "act.h"
@@ -995,6 +996,7 @@ void generate_room_connections(struct greyhawk_ship_data *ship)
     }
   }
 
+  graph_exits_changed();
   log("Generated %d connections for ship %s", ship->num_connections, ship->name);
 }
 
@@ -1117,6 +1119,7 @@ static bool restore_ship_connection(struct greyhawk_ship_data *ship,
   exit->general_description =
       strdup(connection->is_hatch ? "A fitted hatch leads back." : "A passage leads back.");
   world[to_room].dir_option[reverse] = exit;
+  graph_exits_changed();
   return TRUE;
 }
 
@@ -0,0 +1,230 @@
+/* *************************************************************************
+ *   File: region_geometry.c                           Part of LuminariMUD *
+ *  Usage: Native polygon tests over in-memory region vertices            *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Region Geometry                                                         *
+ * ===============                                                         *
+ * See region_geometry.h.  Coordinates are small integers, so the         *
+ * predicates below work in long long / double without tolerances.       *
+ ***************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include <math.h>
+#include "structs.h"
+#include "utils.h"
+#include "wilderness.h"
+#include "region_geometry.h"
+
+double region_geom_segment_dist_sq(double px, double py, double x1, double y1, double x2,
+                                   double y2)
+{
+  double dx = x2 - x1;
+  double dy = y2 - y1;
+  double len_sq = dx * dx + dy * dy;
+  double t;
+  double proj_x, proj_y, diff_x, diff_y;
+
+  if (len_sq == 0.0)
+  {
+    double dpx = px - x1;
+    double dpy = py - y1;
+    return (dpx * dpx + dpy * dpy);
+  }
+
+  t = ((px - x1) * dx + (py - y1) * dy) / len_sq;
+  if (t < 0.0)
+    t = 0.0;
+  else if (t > 1.0)
+    t = 1.0;
+
+  proj_x = x1 + t * dx;
+  proj_y = y1 + t * dy;
+  diff_x = px - proj_x;
+  diff_y = py - proj_y;
+
+  return (diff_x * diff_x + diff_y * diff_y);
+}
+
+void region_geom_centroid(const struct vertex *vertices, int vertex_count, double *cx,
+                          double *cy)
+{
+  double area_twice = 0.0;
+  double weighted_x = 0.0;
+  double weighted_y = 0.0;
+  double cross;
+  int current, next;
+  int average_count;
+
+  *cx = 0.0;
+  *cy = 0.0;
+
+  for (current = 0; current < vertex_count; current++)
+  {
+    next = (current + 1) % vertex_count;
+    cross = (double)vertices[current].x * vertices[next].y -
+            (double)vertices[next].x * vertices[current].y;
+    area_twice += cross;
+    weighted_x += ((double)vertices[current].x + vertices[next].x) * cross;
+    weighted_y += ((double)vertices[current].y + vertices[next].y) * cross;
+  }
+
+  if (fabs(area_twice) > 1.0e-12)
+  {
+    *cx = weighted_x / (3.0 * area_twice);
+    *cy = weighted_y / (3.0 * area_twice);
+    return;
+  }
+
+  /* Region polygons should be non-degenerate. Retain deterministic behavior
+   * for malformed data while excluding a repeated closing vertex. */
+  average_count = vertex_count;
+  if (vertex_count > 1 && vertices[0].x == vertices[vertex_count - 1].x &&
+      vertices[0].y == vertices[vertex_count - 1].y)
+    average_count--;
+
+  for (current = 0; current < average_count; current++)
+  {
+    *cx += vertices[current].x;
+    *cy += vertices[current].y;
+  }
+  if (average_count > 0)
+  {
+    *cx /= average_count;
+    *cy /= average_count;
+  }
+}
+
+bool region_geom_point_within(const struct vertex *vertices, int vertex_count, int x, int y)
+{
+  bool inside;
+  long long cross_product;
+  double intersection_x;
+  int current, previous;
+  int current_x, current_y, previous_x, previous_y;
+
+  if (vertices == NULL || vertex_count < 3)
+    return FALSE;
+
+  inside = FALSE;
+  previous = vertex_count - 1;
+  for (current = 0; current < vertex_count; current++)
+  {
+    current_x = vertices[current].x;
+    current_y = vertices[current].y;
+    previous_x = vertices[previous].x;
+    previous_y = vertices[previous].y;
+
+    cross_product = ((long long)x - current_x) * ((long long)previous_y - current_y) -
+                    ((long long)y - current_y) * ((long long)previous_x - current_x);
+    if (cross_product == 0 && x >= MIN(current_x, previous_x) && x <= MAX(current_x, previous_x) &&
+        y >= MIN(current_y, previous_y) && y <= MAX(current_y, previous_y))
+    {
+      return FALSE;
+    }
+
+    if ((current_y > y) != (previous_y > y))
+    {
+      intersection_x = ((double)previous_x - current_x) * ((double)y - current_y) /
+                           ((double)previous_y - current_y) +
+                       current_x;
+      if ((double)x < intersection_x)
+      {
+        inside = !inside;
+      }
+    }
+    previous = current;
+  }
+
+  return inside;
+}
+
+double region_geom_point_distance(const struct vertex *vertices, int vertex_count, int x, int y)
+{
+  double best_sq = -1.0, d_sq;
+  int v, next;
+
+  if (vertices == NULL || vertex_count < 1)
+    return 0.0;
+
+  if (region_geom_point_within(vertices, vertex_count, x, y))
+    return 0.0;
+
+  /* Outside or on the boundary: the nearest edge is the answer, and it is
+   * exactly 0 for boundary points. */
+  for (v = 0; v < vertex_count; v++)
+  {
+    next = (v + 1) % vertex_count;
+    d_sq = region_geom_segment_dist_sq((double)x, (double)y, (double)vertices[v].x,
+                                       (double)vertices[v].y, (double)vertices[next].x,
+                                       (double)vertices[next].y);
+    if (best_sq < 0.0 || d_sq < best_sq)
+      best_sq = d_sq;
+  }
+
+  return sqrt(best_sq);
+}
+
+/* Liang-Barsky clip of one segment against a closed rectangle. One clip
+ * step: returns FALSE once the segment is known to miss. */
+static bool region_geom_clip(double p, double q, double *t0, double *t1)
+{
+  double r;
+
+  if (p == 0.0)
+    return q >= 0.0;
+
+  r = q / p;
+  if (p < 0.0)
+  {
+    if (r > *t1)
+      return FALSE;
+    if (r > *t0)
+      *t0 = r;
+  }
+  else
+  {
+    if (r < *t0)
+      return FALSE;
+    if (r < *t1)
+      *t1 = r;
+  }
+  return TRUE;
+}
+
+static bool region_geom_segment_hits_rect(int ax, int ay, int bx, int by, int min_x, int min_y,
+                                          int max_x, int max_y)
+{
+  double dx = (double)bx - ax, dy = (double)by - ay;
+  double t0 = 0.0, t1 = 1.0;
+
+  return region_geom_clip(-dx, (double)ax - min_x, &t0, &t1) &&
+         region_geom_clip(dx, (double)max_x - ax, &t0, &t1) &&
+         region_geom_clip(-dy, (double)ay - min_y, &t0, &t1) &&
+         region_geom_clip(dy, (double)max_y - ay, &t0, &t1);
+}
+
+bool region_geom_intersects_rect(const struct vertex *vertices, int vertex_count, int x1, int y1,
+                                 int x2, int y2)
+{
+  int min_x = MIN(x1, x2), max_x = MAX(x1, x2);
+  int min_y = MIN(y1, y2), max_y = MAX(y1, y2);
+  int v, next;
+
+  if (vertices == NULL || vertex_count < 3)
+    return FALSE;
+
+  /* Any edge touching the rectangle, including a vertex inside it. */
+  for (v = 0; v < vertex_count; v++)
+  {
+    next = (v + 1) % vertex_count;
+    if (region_geom_segment_hits_rect(vertices[v].x, vertices[v].y, vertices[next].x,
+                                      vertices[next].y, min_x, min_y, max_x, max_y))
+      return TRUE;
+  }
+
+  /* No edge crosses it, so the rectangle is either wholly inside the
+   * polygon or wholly outside; one corner decides. */
+  return region_geom_point_within(vertices, vertex_count, min_x, min_y);
+}
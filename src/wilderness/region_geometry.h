@@ -0,0 +1,44 @@
+/* *************************************************************************
+ *   File: region_geometry.h                           Part of LuminariMUD *
+ *  Usage: Native polygon tests over in-memory region vertices            *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Region Geometry                                                         *
+ * ===============                                                         *
+ * Plain C versions of the handful of OGC predicates the wilderness used  *
+ * to ask MariaDB for (ST_Within, ST_Distance, ST_Intersects), evaluated  *
+ * against region_table[].vertices so describing a room never has to     *
+ * touch the database.                                                     *
+ *                                                                         *
+ * BEGINNERS NOTE: Region polygons are stored as their exterior ring,     *
+ * usually with the first vertex repeated at the end.  Every routine here *
+ * treats the ring as closed and tolerates that repeated vertex.          *
+ ***************************************************************************/
+
+#ifndef REGION_GEOMETRY_H
+#define REGION_GEOMETRY_H
+
+struct vertex;
+
+/* Squared distance from (px, py) to the segment (x1, y1)-(x2, y2). */
+double region_geom_segment_dist_sq(double px, double py, double x1, double y1, double x2,
+                                   double y2);
+
+/* Area centroid of the ring, or the vertex average for degenerate rings. */
+void region_geom_centroid(const struct vertex *vertices, int vertex_count, double *cx,
+                          double *cy);
+
+/* TRUE when (x, y) lies strictly inside the ring; points on the boundary
+ * are not "within", matching ST_Within(). */
+bool region_geom_point_within(const struct vertex *vertices, int vertex_count, int x, int y);
+
+/* Distance from (x, y) to the polygon: 0 inside or on the boundary,
+ * otherwise the distance to the nearest edge, matching ST_Distance(). */
+double region_geom_point_distance(const struct vertex *vertices, int vertex_count, int x, int y);
+
+/* TRUE when the polygon and the closed rectangle share any point, matching
+ * ST_Intersects() against a rectangular POLYGON. */
+bool region_geom_intersects_rect(const struct vertex *vertices, int vertex_count, int x1, int y1,
+                                 int x2, int y2);
+
+#endif /* REGION_GEOMETRY_H */
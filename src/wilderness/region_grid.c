@@ -0,0 +1,222 @@
+/* *************************************************************************
+ *   File: region_grid.c                               Part of LuminariMUD *
+ *  Usage: Uniform grid index over wilderness regions and paths           *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Region Grid                                                             *
+ * ===========                                                             *
+ * Built by load_regions() and load_paths() and thrown away with the       *
+ * tables they index.  See region_grid.h for the layout.                   *
+ ***************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "wilderness.h"
+#include "region_grid.h"
+
+static struct region_grid region_grid;
+static struct region_grid path_grid;
+
+static void region_grid_reset(struct region_grid *grid)
+{
+  free(grid->cell_start);
+  free(grid->entries);
+  free(grid->bounds);
+  memset(grid, 0, sizeof(*grid));
+}
+
+static void region_grid_vertex_bounds(const struct vertex *vertices, int num_vertices,
+                                      int min_vertices, struct region_grid_bounds *bounds)
+{
+  int v;
+
+  memset(bounds, 0, sizeof(*bounds));
+  if (vertices == NULL || num_vertices < min_vertices)
+    return;
+
+  bounds->min_x = bounds->max_x = vertices[0].x;
+  bounds->min_y = bounds->max_y = vertices[0].y;
+  for (v = 1; v < num_vertices; v++)
+  {
+    bounds->min_x = MIN(bounds->min_x, vertices[v].x);
+    bounds->max_x = MAX(bounds->max_x, vertices[v].x);
+    bounds->min_y = MIN(bounds->min_y, vertices[v].y);
+    bounds->max_y = MAX(bounds->max_y, vertices[v].y);
+  }
+  bounds->valid = TRUE;
+}
+
+static int region_grid_col(const struct region_grid *grid, int x)
+{
+  return (int)(((long)x - grid->origin_x) / grid->cell_size);
+}
+
+static int region_grid_row(const struct region_grid *grid, int y)
+{
+  return (int)(((long)y - grid->origin_y) / grid->cell_size);
+}
+
+/* Lay the grid over the union of all valid bounds and fill its cells. Each
+ * shape is added to every cell its bounding box touches, in rnum order. */
+static void region_grid_build(struct region_grid *grid, const void *table, int top)
+{
+  struct region_grid_bounds *b;
+  long span, ncells;
+  int min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+  int i, col, row, c0, c1, r0, r1, any = FALSE;
+  int *fill;
+
+  for (i = 0; i <= top; i++)
+  {
+    b = &grid->bounds[i];
+    if (!b->valid)
+      continue;
+    if (!any)
+    {
+      min_x = b->min_x;
+      min_y = b->min_y;
+      max_x = b->max_x;
+      max_y = b->max_y;
+      any = TRUE;
+      continue;
+    }
+    min_x = MIN(min_x, b->min_x);
+    min_y = MIN(min_y, b->min_y);
+    max_x = MAX(max_x, b->max_x);
+    max_y = MAX(max_y, b->max_y);
+  }
+
+  span = MAX((long)max_x - min_x, (long)max_y - min_y) + 1;
+  grid->cell_size = MAX(REGION_GRID_MIN_CELL,
+                        (int)((span + REGION_GRID_MAX_AXIS - 1) / REGION_GRID_MAX_AXIS));
+  grid->origin_x = min_x;
+  grid->origin_y = min_y;
+  grid->cols = (int)(((long)max_x - min_x) / grid->cell_size) + 1;
+  grid->rows = (int)(((long)max_y - min_y) / grid->cell_size) + 1;
+  ncells = (long)grid->cols * grid->rows;
+
+  CREATE(grid->cell_start, int, ncells + 1);
+
+  /* First pass counts, second pass fills. */
+  for (i = 0; i <= top; i++)
+  {
+    b = &grid->bounds[i];
+    if (!b->valid)
+      continue;
+    c0 = region_grid_col(grid, b->min_x);
+    c1 = region_grid_col(grid, b->max_x);
+    r0 = region_grid_row(grid, b->min_y);
+    r1 = region_grid_row(grid, b->max_y);
+    for (row = r0; row <= r1; row++)
+      for (col = c0; col <= c1; col++)
+        grid->cell_start[row * grid->cols + col + 1]++;
+  }
+  for (i = 0; i < ncells; i++)
+    grid->cell_start[i + 1] += grid->cell_start[i];
+
+  CREATE(grid->entries, int, MAX(1, grid->cell_start[ncells]));
+  CREATE(fill, int, ncells);
+  for (i = 0; i <= top; i++)
+  {
+    b = &grid->bounds[i];
+    if (!b->valid)
+      continue;
+    c0 = region_grid_col(grid, b->min_x);
+    c1 = region_grid_col(grid, b->max_x);
+    r0 = region_grid_row(grid, b->min_y);
+    r1 = region_grid_row(grid, b->max_y);
+    for (row = r0; row <= r1; row++)
+      for (col = c0; col <= c1; col++)
+      {
+        int cell = row * grid->cols + col;
+        grid->entries[grid->cell_start[cell] + fill[cell]++] = i;
+      }
+  }
+  free(fill);
+
+  grid->table = table;
+  grid->top = top;
+}
+
+void region_grid_build_regions(void)
+{
+  int i;
+
+  region_grid_reset(&region_grid);
+  if (region_table == NULL || top_of_region_table == NOWHERE || (int)top_of_region_table < 0)
+    return;
+
+  CREATE(region_grid.bounds, struct region_grid_bounds, top_of_region_table + 1);
+  for (i = 0; i <= (int)top_of_region_table; i++)
+    region_grid_vertex_bounds(region_table[i].vertices, region_table[i].num_vertices, 3,
+                              &region_grid.bounds[i]);
+  region_grid_build(&region_grid, region_table, (int)top_of_region_table);
+}
+
+void region_grid_build_paths(void)
+{
+  int i;
+
+  region_grid_reset(&path_grid);
+  if (path_table == NULL || top_of_path_table == NOWHERE || (int)top_of_path_table < 0)
+    return;
+
+  CREATE(path_grid.bounds, struct region_grid_bounds, top_of_path_table + 1);
+  for (i = 0; i <= (int)top_of_path_table; i++)
+    region_grid_vertex_bounds(path_table[i].vertices, path_table[i].num_vertices, 2,
+                              &path_grid.bounds[i]);
+  region_grid_build(&path_grid, path_table, (int)top_of_path_table);
+}
+
+void region_grid_free_regions(void)
+{
+  region_grid_reset(&region_grid);
+}
+
+void region_grid_free_paths(void)
+{
+  region_grid_reset(&path_grid);
+}
+
+static int region_grid_candidates(const struct region_grid *grid, const void *table, int top,
+                                  int x, int y, const int **list)
+{
+  int col, row, cell;
+
+  *list = NULL;
+  if (grid->cell_start == NULL || grid->table != table || grid->top != top)
+    return -1;
+
+  if (x < grid->origin_x || y < grid->origin_y)
+    return 0;
+  col = region_grid_col(grid, x);
+  row = region_grid_row(grid, y);
+  if (col >= grid->cols || row >= grid->rows)
+    return 0;
+
+  cell = row * grid->cols + col;
+  *list = &grid->entries[grid->cell_start[cell]];
+  return grid->cell_start[cell + 1] - grid->cell_start[cell];
+}
+
+int region_grid_region_candidates(int x, int y, const int **list)
+{
+  return region_grid_candidates(&region_grid, region_table, (int)top_of_region_table, x, y, list);
+}
+
+int region_grid_path_candidates(int x, int y, const int **list)
+{
+  return region_grid_candidates(&path_grid, path_table, (int)top_of_path_table, x, y, list);
+}
+
+const struct region_grid_bounds *region_grid_region_bounds(int rnum)
+{
+  if (region_grid.bounds == NULL || region_grid.table != region_table ||
+      region_grid.top != (int)top_of_region_table || rnum < 0 || rnum > region_grid.top ||
+      !region_grid.bounds[rnum].valid)
+    return NULL;
+  return &region_grid.bounds[rnum];
+}
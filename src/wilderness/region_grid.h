@@ -0,0 +1,63 @@
+/* *************************************************************************
+ *   File: region_grid.h                               Part of LuminariMUD *
+ *  Usage: Uniform grid index over wilderness regions and paths           *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Region Grid                                                             *
+ * ===========                                                             *
+ * get_enclosing_regions() and get_enclosing_paths() are asked about every *
+ * tile of every wilderness map and every room description.  This index   *
+ * buckets each region polygon and path polyline into fixed-size grid     *
+ * cells by bounding box, so a lookup only tests the handful of shapes    *
+ * whose bounds overlap the tile instead of the whole table.              *
+ ***************************************************************************/
+
+#ifndef REGION_GRID_H
+#define REGION_GRID_H
+
+/* Smallest cell edge, in tiles. */
+#define REGION_GRID_MIN_CELL 16
+/* Upper bound on cells per axis; cells grow when the shapes span more. */
+#define REGION_GRID_MAX_AXIS 256
+
+/* Axis-aligned bounding box of one shape. */
+struct region_grid_bounds
+{
+  int min_x, min_y;
+  int max_x, max_y;
+  bool valid; /* FALSE for shapes with too few vertices to ever match */
+};
+
+/* One grid over either region_table or path_table.
+ *
+ * BEGINNERS NOTE: Candidates are stored "compressed sparse row" style:
+ * cell c owns entries[cell_start[c]] .. entries[cell_start[c + 1] - 1],
+ * sorted by rnum.  Two flat arrays instead of a list per cell. */
+struct region_grid
+{
+  const void *table; /* Table the grid was built from, to detect swaps */
+  int top;           /* top_of_*_table at build time */
+  int origin_x, origin_y;
+  int cell_size;
+  int cols, rows;
+  int *cell_start;                  /* cols * rows + 1 offsets into entries */
+  int *entries;                     /* Candidate rnums, ascending within each cell */
+  struct region_grid_bounds *bounds; /* Per-rnum bounding boxes */
+};
+
+void region_grid_build_regions(void);
+void region_grid_build_paths(void);
+void region_grid_free_regions(void);
+void region_grid_free_paths(void);
+
+/* Candidate rnums whose bounds may contain (x, y). Returns the count and
+ * points *list at them, or -1 when no grid matches the live table and the
+ * caller must scan it. */
+int region_grid_region_candidates(int x, int y, const int **list);
+int region_grid_path_candidates(int x, int y, const int **list);
+
+/* Cached bounding box of region rnum, or NULL when the grid is stale or the
+ * region has no usable polygon. */
+const struct region_grid_bounds *region_grid_region_bounds(int rnum);
+
+#endif /* REGION_GRID_H */
@@ -0,0 +1,306 @@
+/* *************************************************************************
+ *   File: room_pool.c                                 Part of LuminariMUD *
+ *  Usage: Coordinate hash and free-list for dynamic wilderness rooms     *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Dynamic Room Pool                                                       *
+ * =================                                                       *
+ * See room_pool.h.  Slots are indexed by vnum offset into the pool, so   *
+ * the index never has to care where OLC has shuffled the rnums; it just  *
+ * rebuilds when world or top_of_world change.                             *
+ ***************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "wilderness.h"
+#include "room_pool.h"
+
+#if defined(WILD_POOL_VALIDATE)
+bool wild_pool_validate = TRUE;
+#else
+bool wild_pool_validate = FALSE;
+#endif
+
+struct wild_pool_slot
+{
+  room_rnum rnum; /* NOWHERE for a gap in the pool */
+  int x, y;       /* Key this slot is hashed under */
+  int next;       /* Next slot in the same bucket, or -1 */
+  int free_pos;   /* Index in free_list, or -1 */
+  bool hashed;
+};
+
+static struct
+{
+  bool built;
+  struct room_data *world; /* world / top_of_world at build time */
+  room_rnum top;
+  int heads[WILD_POOL_BUCKETS];
+  struct wild_pool_slot slots[WILD_POOL_SIZE];
+  int free_list[WILD_POOL_SIZE];
+  int free_count;
+} pool;
+
+static unsigned int wild_pool_bucket(int x, int y)
+{
+  return ((unsigned int)x * 73856093U ^ (unsigned int)y * 19349663U) & (WILD_POOL_BUCKETS - 1);
+}
+
+static void wild_pool_hash(int slot, int x, int y)
+{
+  unsigned int bucket = wild_pool_bucket(x, y);
+
+  pool.slots[slot].x = x;
+  pool.slots[slot].y = y;
+  pool.slots[slot].next = pool.heads[bucket];
+  pool.slots[slot].hashed = TRUE;
+  pool.heads[bucket] = slot;
+}
+
+static void wild_pool_unhash(int slot)
+{
+  int *link;
+
+  if (!pool.slots[slot].hashed)
+    return;
+
+  link = &pool.heads[wild_pool_bucket(pool.slots[slot].x, pool.slots[slot].y)];
+  while (*link != -1 && *link != slot)
+    link = &pool.slots[*link].next;
+  if (*link == slot)
+    *link = pool.slots[slot].next;
+  pool.slots[slot].next = -1;
+  pool.slots[slot].hashed = FALSE;
+}
+
+static void wild_pool_push_free(int slot)
+{
+  if (pool.slots[slot].free_pos != -1)
+    return;
+  pool.slots[slot].free_pos = pool.free_count;
+  pool.free_list[pool.free_count++] = slot;
+}
+
+/* Swap the last free slot into the hole so removal stays O(1). */
+static void wild_pool_remove_free(int slot)
+{
+  int pos = pool.slots[slot].free_pos, last;
+
+  if (pos == -1)
+    return;
+  last = pool.free_list[--pool.free_count];
+  pool.free_list[pos] = last;
+  pool.slots[last].free_pos = pos;
+  pool.slots[slot].free_pos = -1;
+}
+
+static void wild_pool_build(void)
+{
+  room_rnum rnum;
+  int i;
+
+  for (i = 0; i < WILD_POOL_BUCKETS; i++)
+    pool.heads[i] = -1;
+  pool.free_count = 0;
+
+  for (i = 0; i < WILD_POOL_SIZE; i++)
+  {
+    pool.slots[i].next = -1;
+    pool.slots[i].free_pos = -1;
+    pool.slots[i].hashed = FALSE;
+    pool.slots[i].rnum = world ? real_room(WILD_DYNAMIC_ROOM_VNUM_START + i) : NOWHERE;
+  }
+
+  /* Pushed high to low so the lowest free vnum is handed out first. */
+  for (i = WILD_POOL_SIZE - 1; i >= 0; i--)
+  {
+    if ((rnum = pool.slots[i].rnum) == NOWHERE)
+      continue;
+    if (ROOM_FLAGGED(rnum, ROOM_OCCUPIED))
+      wild_pool_hash(i, world[rnum].coords[X_COORD], world[rnum].coords[Y_COORD]);
+    else
+      wild_pool_push_free(i);
+  }
+
+  pool.world = world;
+  pool.top = top_of_world;
+  pool.built = TRUE;
+}
+
+static void wild_pool_current(void)
+{
+  if (!pool.built || pool.world != world || pool.top != top_of_world)
+    wild_pool_build();
+}
+
+/* Pool slot for rnum, or -1 if it is not a pool room. */
+static int wild_pool_slot_of(room_rnum room)
+{
+  int slot;
+
+  if (room == NOWHERE || world == NULL || room > top_of_world || !IS_DYNAMIC(room))
+    return -1;
+  slot = world[room].number - WILD_DYNAMIC_ROOM_VNUM_START;
+  return pool.slots[slot].rnum == room ? slot : -1;
+}
+
+void wild_pool_reset(void)
+{
+  pool.built = FALSE;
+}
+
+/* The old linear scans, kept for wild_pool_validate. */
+static room_rnum wild_pool_scan_find(int x, int y)
+{
+  room_rnum rnum;
+  int i;
+
+  for (i = WILD_DYNAMIC_ROOM_VNUM_START; i <= WILD_DYNAMIC_ROOM_VNUM_END; i++)
+  {
+    if ((rnum = real_room(i)) == NOWHERE)
+      continue;
+    if (ROOM_FLAGGED(rnum, ROOM_OCCUPIED) && world[rnum].coords[X_COORD] == x &&
+        world[rnum].coords[Y_COORD] == y)
+      return rnum;
+  }
+  return NOWHERE;
+}
+
+static room_rnum wild_pool_scan_available(void)
+{
+  room_rnum rnum;
+  int i;
+
+  for (i = WILD_DYNAMIC_ROOM_VNUM_START; i <= WILD_DYNAMIC_ROOM_VNUM_END; i++)
+    if ((rnum = real_room(i)) != NOWHERE && !ROOM_FLAGGED(rnum, ROOM_OCCUPIED))
+      return rnum;
+  return NOWHERE;
+}
+
+/* Lowest-vnum occupied room hashed at (x, y). Sets *stale if the chain
+ * holds a room whose flags or coordinates changed behind our back. */
+static room_rnum wild_pool_lookup(int x, int y, bool *stale)
+{
+  int slot, best = -1;
+  room_rnum rnum;
+
+  *stale = FALSE;
+  for (slot = pool.heads[wild_pool_bucket(x, y)]; slot != -1; slot = pool.slots[slot].next)
+  {
+    if (pool.slots[slot].x != x || pool.slots[slot].y != y)
+      continue;
+    rnum = pool.slots[slot].rnum;
+    if (!ROOM_FLAGGED(rnum, ROOM_OCCUPIED) || world[rnum].coords[X_COORD] != x ||
+        world[rnum].coords[Y_COORD] != y)
+    {
+      *stale = TRUE;
+      return NOWHERE;
+    }
+    if (best == -1 || slot < best)
+      best = slot;
+  }
+  return best == -1 ? NOWHERE : pool.slots[best].rnum;
+}
+
+room_rnum wild_pool_find(int x, int y)
+{
+  room_rnum found, scanned;
+  bool stale;
+
+  if (world == NULL)
+    return NOWHERE;
+
+  wild_pool_current();
+  found = wild_pool_lookup(x, y, &stale);
+  if (stale)
+  {
+    wild_pool_build();
+    found = wild_pool_lookup(x, y, &stale);
+  }
+
+  if (wild_pool_validate && (scanned = wild_pool_scan_find(x, y)) != found)
+  {
+    log("SYSERR: wild_pool_find(%d, %d) returned room %d, scan found %d; rebuilding", x, y,
+        found == NOWHERE ? -1 : (int)world[found].number,
+        scanned == NOWHERE ? -1 : (int)world[scanned].number);
+    wild_pool_build();
+    found = scanned;
+  }
+
+  return found;
+}
+
+room_rnum wild_pool_available(void)
+{
+  room_rnum found = NOWHERE;
+  int attempt;
+
+  if (world == NULL)
+    return NOWHERE;
+
+  wild_pool_current();
+  for (attempt = 0; attempt < 2 && found == NOWHERE; attempt++)
+  {
+    if (pool.free_count == 0)
+      break;
+    found = pool.slots[pool.free_list[pool.free_count - 1]].rnum;
+    if (ROOM_FLAGGED(found, ROOM_OCCUPIED))
+    {
+      /* Flagged without telling us. */
+      found = NOWHERE;
+      wild_pool_build();
+    }
+  }
+
+  if (wild_pool_validate && (found == NOWHERE) != (wild_pool_scan_available() == NOWHERE))
+  {
+    log("SYSERR: wild_pool_available() disagrees with the pool scan; rebuilding");
+    wild_pool_build();
+    found = wild_pool_scan_available();
+  }
+
+  return found;
+}
+
+void wild_pool_note_occupied(room_rnum room)
+{
+  int slot;
+
+  wild_pool_current();
+  if ((slot = wild_pool_slot_of(room)) == -1)
+    return;
+
+  wild_pool_remove_free(slot);
+  if (pool.slots[slot].hashed && pool.slots[slot].x == world[room].coords[X_COORD] &&
+      pool.slots[slot].y == world[room].coords[Y_COORD])
+    return;
+  wild_pool_unhash(slot);
+  wild_pool_hash(slot, world[room].coords[X_COORD], world[room].coords[Y_COORD]);
+}
+
+void wild_pool_note_released(room_rnum room)
+{
+  int slot;
+
+  wild_pool_current();
+  if ((slot = wild_pool_slot_of(room)) == -1)
+    return;
+
+  wild_pool_unhash(slot);
+  wild_pool_push_free(slot);
+}
+
+void wild_pool_note_moved(room_rnum room)
+{
+  int slot;
+
+  wild_pool_current();
+  if ((slot = wild_pool_slot_of(room)) == -1 || !pool.slots[slot].hashed)
+    return;
+
+  wild_pool_unhash(slot);
+  wild_pool_hash(slot, world[room].coords[X_COORD], world[room].coords[Y_COORD]);
+}
@@ -0,0 +1,49 @@
+/* *************************************************************************
+ *   File: room_pool.h                                 Part of LuminariMUD *
+ *  Usage: Coordinate hash and free-list for dynamic wilderness rooms     *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Dynamic Room Pool                                                       *
+ * =================                                                       *
+ * Every step through the wilderness asks "which pool room is at (x, y)?" *
+ * and, on a miss, "which pool room is free?".  Both used to walk the     *
+ * whole WILD_DYNAMIC_ROOM_VNUM_START.._END range with a real_room()      *
+ * binary search per vnum.  This index answers both in O(1):              *
+ *                                                                         *
+ *   - occupied pool rooms are hashed by their coordinates, and           *
+ *   - unoccupied pool rooms sit on a free-list.                           *
+ *                                                                         *
+ * mark_wilderness_room_occupied(), event_check_occupied() and            *
+ * assign_wilderness_room() keep it current.  It rebuilds itself whenever *
+ * the world array is replaced or resized.  Lookups re-check the flags   *
+ * and coordinates of what they return, so a stale entry is never handed  *
+ * out; a room flagged ROOM_OCCUPIED by hand, without going through       *
+ * mark_wilderness_room_occupied(), is only seen after the next rebuild.  *
+ ***************************************************************************/
+
+#ifndef ROOM_POOL_H
+#define ROOM_POOL_H
+
+/* Number of vnums in the dynamic room pool. */
+#define WILD_POOL_SIZE (WILD_DYNAMIC_ROOM_VNUM_END - WILD_DYNAMIC_ROOM_VNUM_START + 1)
+/* Coordinate hash buckets; a power of two at least the pool size. */
+#define WILD_POOL_BUCKETS 8192
+
+/* When TRUE every lookup is cross-checked against the old linear scans.
+ * Defaults on when built with -DWILD_POOL_VALIDATE. */
+extern bool wild_pool_validate;
+
+/* Occupied pool room at (x, y), or NOWHERE. */
+room_rnum wild_pool_find(int x, int y);
+/* Some unoccupied pool room, or NOWHERE when the pool is exhausted. The
+ * room stays on the free-list until it is marked occupied. */
+room_rnum wild_pool_available(void);
+
+void wild_pool_note_occupied(room_rnum room);
+void wild_pool_note_released(room_rnum room);
+void wild_pool_note_moved(room_rnum room);
+
+/* Drop the index; the next lookup rebuilds it from the world. */
+void wild_pool_reset(void);
+
+#endif /* ROOM_POOL_H */
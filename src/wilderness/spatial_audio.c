@@ -19,6 +19,7 @@
 #include "comm.h"
 #include "wilderness.h"
 #include "spatial_core.h"
+#include "spatial_grid.h"
 #include "spatial_audio.h"
 
 /* Forward declarations for strategy functions */
@@ -101,6 +102,15 @@ struct spatial_system audio_system = {.system_name = "Audio",
                                       .successful_transmissions = 0,
                                       .avg_processing_time_ms = 0.0};
 
+/* Listeners found for the stimulus being delivered, reused between calls */
+static struct spatial_grid_result audio_listeners;
+
+/* How far spatial_process_stimulus() lets an audio stimulus reach */
+static int audio_system_range(void)
+{
+  return (int)ceil(audio_system.stimulus->base_range * audio_system.global_range_multiplier);
+}
+
 /*
  * AUDIO STIMULUS STRATEGY IMPLEMENTATION
  */
@@ -727,7 +737,7 @@ int spatial_audio_test_thunder(int thunder_x, int thunder_y, const char *thunder
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!thunder_desc)
   {
@@ -748,16 +758,16 @@ int spatial_audio_test_thunder(int thunder_x, int thunder_y, const char *thunder
   ctx->source_x = thunder_x;
   ctx->source_y = thunder_y;
   ctx->source_z = 100; /* Thunder comes from sky */
-  ctx->source_description = strdup(thunder_desc);
+  ctx->source_description = (char *)thunder_desc;
   ctx->base_intensity = 1.0;
   ctx->audio_frequency = AUDIO_FREQ_LOW; /* Thunder is low frequency */
 
-  /* Process for all wilderness players */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within the system's range */
+  spatial_grid_players_near(thunder_x, thunder_y, audio_system_range(), &audio_listeners);
+  for (i = 0; i < audio_listeners.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = audio_listeners.items[i];
+    if (!ch->desc)
       continue;
 
     /* Set observer information */
@@ -800,7 +810,7 @@ int spatial_audio_test_shout(int source_x, int source_y, const char *shout_messa
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!shout_message)
   {
@@ -821,16 +831,16 @@ int spatial_audio_test_shout(int source_x, int source_y, const char *shout_messa
   ctx->source_x = source_x;
   ctx->source_y = source_y;
   ctx->source_z = 0; /* Ground level */
-  ctx->source_description = strdup(shout_message);
+  ctx->source_description = (char *)shout_message;
   ctx->base_intensity = 1.0;
   ctx->audio_frequency = AUDIO_FREQ_MID; /* Human voice is mid frequency */
 
-  /* Process for all wilderness players */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within the system's range */
+  spatial_grid_players_near(source_x, source_y, audio_system_range(), &audio_listeners);
+  for (i = 0; i < audio_listeners.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = audio_listeners.items[i];
+    if (!ch->desc)
       continue;
 
     /* Set observer information */
@@ -865,7 +875,7 @@ int spatial_audio_test_sound_effect(int source_x, int source_y, int source_z,
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!sound_desc)
   {
@@ -886,19 +896,19 @@ int spatial_audio_test_sound_effect(int source_x, int source_y, int source_z,
   ctx->source_x = source_x;
   ctx->source_y = source_y;
   ctx->source_z = source_z;
-  ctx->source_description = strdup(sound_desc);
+  ctx->source_description = (char *)sound_desc;
   ctx->base_intensity = 1.0;
   ctx->audio_frequency = frequency;
 
   /* Set effective range */
   ctx->effective_range = range;
 
-  /* Process for all wilderness players */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within range */
+  spatial_grid_players_near(source_x, source_y, range, &audio_listeners);
+  for (i = 0; i < audio_listeners.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = audio_listeners.items[i];
+    if (!ch->desc)
       continue;
 
     /* Check if player is within audio range using horizontal distance */
@@ -37,6 +37,19 @@ static int stimulus_strategy_count = 0;
 static int los_strategy_count = 0;
 static int modifier_strategy_count = 0; */
 
+/* Line of sight cache, direct mapped: a new result replaces whatever
+ * shared its slot */
+struct spatial_cache_entry
+{
+  const struct los_strategy *strategy; /* NULL while the slot is empty */
+  int source_x, source_y, source_z;
+  int observer_x, observer_y, observer_z;
+  float obstruction;
+  time_t stored_at;
+};
+
+static struct spatial_cache_entry spatial_cache[SPATIAL_CACHE_SIZE];
+
 /* Performance tracking */
 static struct
 {
@@ -182,11 +195,18 @@ int spatial_process_stimulus(struct spatial_context *ctx, struct spatial_system
     return SPATIAL_ERROR_STIMULUS;
   }
 
-  /* Step 3: Check line of sight using appropriate strategy */
-  if (system->line_of_sight->calculate_obstruction(ctx, &obstruction_factor) != SPATIAL_SUCCESS)
+  /* Step 3: Check line of sight using appropriate strategy, or its cached
+   * answer for these two points */
+  if (!ctx->use_cache || !system->line_of_sight->use_caching ||
+      spatial_get_cached_result(ctx, &obstruction_factor) != SPATIAL_SUCCESS)
   {
-    spatial_debug("Failed to calculate line of sight obstruction");
-    return SPATIAL_ERROR_LOS;
+    if (system->line_of_sight->calculate_obstruction(ctx, &obstruction_factor) != SPATIAL_SUCCESS)
+    {
+      spatial_debug("Failed to calculate line of sight obstruction");
+      return SPATIAL_ERROR_LOS;
+    }
+    if (ctx->use_cache && system->line_of_sight->use_caching)
+      spatial_cache_result(ctx, obstruction_factor);
   }
 
   /* Step 4: Apply environmental modifiers */
@@ -769,30 +789,95 @@ int spatial_get_terrain_type(int x __attribute__((unused)), int y __attribute__(
 }
 
 /*
- * Stub cache functions - to be implemented
+ * Line of sight cache
  */
 int spatial_init_cache(void)
 {
+  memset(spatial_cache, 0, sizeof(spatial_cache));
   return SPATIAL_SUCCESS;
 }
 
 void spatial_cleanup_cache(void)
 {
-  /* TODO: Implement cache cleanup */
+  memset(spatial_cache, 0, sizeof(spatial_cache));
 }
 
-int spatial_cache_result(struct spatial_context *ctx __attribute__((unused)),
-                         float result __attribute__((unused)))
+static const struct los_strategy *spatial_cache_strategy(struct spatial_context *ctx)
 {
-  /* TODO: Implement result caching */
+  if (!ctx || !ctx->active_system)
+    return NULL;
+  return ctx->active_system->line_of_sight;
+}
+
+/* Slot for the context's strategy and points; also kept in ctx->cache_key. */
+static struct spatial_cache_entry *spatial_cache_slot(struct spatial_context *ctx,
+                                                      const struct los_strategy *strategy)
+{
+  unsigned int hash = (unsigned int)(uintptr_t)strategy;
+
+  hash = hash * 31 + (unsigned int)ctx->source_x;
+  hash = hash * 31 + (unsigned int)ctx->source_y;
+  hash = hash * 31 + (unsigned int)ctx->source_z;
+  hash = hash * 31 + (unsigned int)ctx->observer_x;
+  hash = hash * 31 + (unsigned int)ctx->observer_y;
+  hash = hash * 31 + (unsigned int)ctx->observer_z;
+  hash ^= hash >> 16;
+
+  ctx->cache_key = (int)(hash % SPATIAL_CACHE_SIZE);
+  return &spatial_cache[ctx->cache_key];
+}
+
+static bool spatial_cache_matches(const struct spatial_cache_entry *entry,
+                                  const struct spatial_context *ctx,
+                                  const struct los_strategy *strategy)
+{
+  return entry->strategy == strategy && entry->source_x == ctx->source_x &&
+         entry->source_y == ctx->source_y && entry->source_z == ctx->source_z &&
+         entry->observer_x == ctx->observer_x && entry->observer_y == ctx->observer_y &&
+         entry->observer_z == ctx->observer_z;
+}
+
+int spatial_cache_result(struct spatial_context *ctx, float result)
+{
+  const struct los_strategy *strategy = spatial_cache_strategy(ctx);
+  struct spatial_cache_entry *entry;
+
+  if (!strategy)
+    return SPATIAL_ERROR_INVALID_PARAM;
+
+  entry = spatial_cache_slot(ctx, strategy);
+  entry->strategy = strategy;
+  entry->source_x = ctx->source_x;
+  entry->source_y = ctx->source_y;
+  entry->source_z = ctx->source_z;
+  entry->observer_x = ctx->observer_x;
+  entry->observer_y = ctx->observer_y;
+  entry->observer_z = ctx->observer_z;
+  entry->obstruction = result;
+  entry->stored_at = time(NULL);
+  ctx->last_calculated = entry->stored_at;
   return SPATIAL_SUCCESS;
 }
 
-int spatial_get_cached_result(struct spatial_context *ctx __attribute__((unused)),
-                              float *cached_result __attribute__((unused)))
+int spatial_get_cached_result(struct spatial_context *ctx, float *cached_result)
 {
-  /* TODO: Implement cache lookup */
-  return SPATIAL_ERROR_NOT_IMPLEMENTED;
+  const struct los_strategy *strategy = spatial_cache_strategy(ctx);
+  struct spatial_cache_entry *entry;
+
+  if (!strategy || !cached_result)
+    return SPATIAL_ERROR_INVALID_PARAM;
+
+  entry = spatial_cache_slot(ctx, strategy);
+  if (!spatial_cache_matches(entry, ctx, strategy) ||
+      time(NULL) - entry->stored_at > SPATIAL_CACHE_TTL)
+  {
+    ctx->active_system->line_of_sight->cache_misses++;
+    return SPATIAL_ERROR_NOT_CACHED;
+  }
+
+  ctx->active_system->line_of_sight->cache_hits++;
+  *cached_result = entry->obstruction;
+  return SPATIAL_SUCCESS;
 }
 
 /*
@@ -848,6 +933,8 @@ const char *spatial_error_string(int error_code)
     return "Memory allocation failed";
   case SPATIAL_ERROR_NOT_IMPLEMENTED:
     return "Feature not implemented";
+  case SPATIAL_ERROR_NOT_CACHED:
+    return "No cached result";
   default:
     return "Unknown error";
   }
@@ -21,7 +21,8 @@
 #define SPATIAL_MAX_MESSAGE_LENGTH 1024
 #define SPATIAL_MAX_OBSTACLES 100
 #define SPATIAL_MAX_NEARBY_ENTITIES 50
-#define SPATIAL_CACHE_SIZE 256
+#define SPATIAL_CACHE_SIZE 256 /* Line of sight results kept, see spatial_cache_result() */
+#define SPATIAL_CACHE_TTL 60    /* Seconds a line of sight result stays good */
 
 /* Stimulus Types */
 #define STIMULUS_VISUAL 1
@@ -57,6 +58,7 @@ typedef enum
 #define SPATIAL_ERROR_INVALID_PARAM -5
 #define SPATIAL_ERROR_MEMORY -6
 #define SPATIAL_ERROR_NOT_IMPLEMENTED -7
+#define SPATIAL_ERROR_NOT_CACHED -8
 
 /* Forward Declarations */
 struct spatial_context;
@@ -278,7 +280,9 @@ int spatial_get_terrain_type(int x, int y);
 int spatial_get_weather_type(struct char_data *observer);
 int spatial_get_raw_weather(struct char_data *observer);
 
-/* Cache Management */
+/* Cache Management: line of sight obstruction for a system's strategy,
+ * keyed by the source and observer positions.  Terrain changes too rarely
+ * to track, so results simply expire after SPATIAL_CACHE_TTL. */
 int spatial_init_cache(void);
 void spatial_cleanup_cache(void);
 int spatial_cache_result(struct spatial_context *ctx, float result);
@@ -0,0 +1,204 @@
+/* *************************************************************************
+ *   File: spatial_grid.c                              Part of LuminariMUD *
+ *  Usage: Bucketed grid over wilderness coordinates                      *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * See spatial_grid.h.  Each cell is an unordered array; an item is found *
+ * for removal by a scan of its own cell, which holds at most the few     *
+ * things standing in one SPATIAL_GRID_CELL_SIZE square.                  *
+ ***************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "wilderness.h"
+#include "spatial_grid.h"
+
+static struct spatial_grid player_grid;
+
+static int grid_axis(long coord)
+{
+  long cell = coord - SPATIAL_GRID_MIN;
+
+  if (cell < 0)
+    return 0;
+  cell /= SPATIAL_GRID_CELL_SIZE;
+  return cell >= SPATIAL_GRID_DIM ? SPATIAL_GRID_DIM - 1 : (int)cell;
+}
+
+int spatial_grid_insert(struct spatial_grid *grid, void *item, int x, int y)
+{
+  struct spatial_grid_cell *cell;
+  int index = grid_axis(y) * SPATIAL_GRID_DIM + grid_axis(x);
+
+  if (!grid->cells)
+  {
+    CREATE(grid->cells, struct spatial_grid_cell, SPATIAL_GRID_CELLS);
+    CREATE(grid->occupied, int, SPATIAL_GRID_CELLS);
+  }
+
+  cell = &grid->cells[index];
+  if (cell->count == cell->capacity)
+  {
+    cell->capacity = MAX(4, cell->capacity * 2);
+    RECREATE(cell->entries, struct spatial_grid_entry, cell->capacity);
+  }
+  if (cell->count == 0)
+  {
+    cell->occupied_slot = grid->occupied_count;
+    grid->occupied[grid->occupied_count++] = index;
+  }
+  cell->entries[cell->count].item = item;
+  cell->entries[cell->count].x = x;
+  cell->entries[cell->count].y = y;
+  cell->count++;
+  grid->count++;
+  return index;
+}
+
+void spatial_grid_remove(struct spatial_grid *grid, void *item, int cell_index)
+{
+  struct spatial_grid_cell *cell;
+  int i, moved;
+
+  if (!grid->cells || cell_index < 0 || cell_index >= SPATIAL_GRID_CELLS)
+    return;
+
+  cell = &grid->cells[cell_index];
+  for (i = 0; i < cell->count; i++)
+    if (cell->entries[i].item == item)
+      break;
+  if (i == cell->count)
+    return;
+
+  cell->entries[i] = cell->entries[--cell->count];
+  grid->count--;
+  if (cell->count == 0)
+  {
+    moved = grid->occupied[--grid->occupied_count];
+    grid->occupied[cell->occupied_slot] = moved;
+    grid->cells[moved].occupied_slot = cell->occupied_slot;
+  }
+}
+
+static void grid_collect(const struct spatial_grid_cell *cell, int x, int y, int range,
+                         struct spatial_grid_result *result)
+{
+  int i;
+
+  for (i = 0; i < cell->count; i++)
+  {
+    if (labs((long)cell->entries[i].x - x) > range || labs((long)cell->entries[i].y - y) > range)
+      continue;
+    if (result->count == result->capacity)
+    {
+      result->capacity = MAX(16, result->capacity * 2);
+      RECREATE(result->items, void *, result->capacity);
+    }
+    result->items[result->count++] = cell->entries[i].item;
+  }
+}
+
+int spatial_grid_query(const struct spatial_grid *grid, int x, int y, int range,
+                       struct spatial_grid_result *result)
+{
+  int min_cx, max_cx, min_cy, max_cy, cx, cy, i, index;
+
+  result->count = 0;
+  if (!grid->cells || grid->count == 0)
+    return 0;
+  if (range < 0)
+    range = 0;
+
+  min_cx = grid_axis((long)x - range);
+  max_cx = grid_axis((long)x + range);
+  min_cy = grid_axis((long)y - range);
+  max_cy = grid_axis((long)y + range);
+
+  /* A wide query visits the occupied cells rather than every cell it
+   * covers. */
+  if ((long)(max_cx - min_cx + 1) * (max_cy - min_cy + 1) > grid->occupied_count)
+  {
+    for (i = 0; i < grid->occupied_count; i++)
+    {
+      index = grid->occupied[i];
+      cx = index % SPATIAL_GRID_DIM;
+      cy = index / SPATIAL_GRID_DIM;
+      if (cx >= min_cx && cx <= max_cx && cy >= min_cy && cy <= max_cy)
+        grid_collect(&grid->cells[index], x, y, range, result);
+    }
+    return result->count;
+  }
+
+  for (cy = min_cy; cy <= max_cy; cy++)
+    for (cx = min_cx; cx <= max_cx; cx++)
+      grid_collect(&grid->cells[cy * SPATIAL_GRID_DIM + cx], x, y, range, result);
+  return result->count;
+}
+
+void spatial_grid_free(struct spatial_grid *grid)
+{
+  int i;
+
+  if (grid->cells)
+    for (i = 0; i < SPATIAL_GRID_CELLS; i++)
+      free(grid->cells[i].entries);
+  free(grid->cells);
+  free(grid->occupied);
+  memset(grid, 0, sizeof(*grid));
+}
+
+void spatial_grid_free_result(struct spatial_grid_result *result)
+{
+  free(result->items);
+  memset(result, 0, sizeof(*result));
+}
+
+static bool spatial_grid_wanted(struct char_data *ch)
+{
+  zone_rnum zone;
+
+  if (IS_NPC(ch) || IN_ROOM(ch) == NOWHERE || IN_ROOM(ch) > top_of_world)
+    return FALSE;
+  zone = world[IN_ROOM(ch)].zone;
+  return zone != NOWHERE && zone <= top_of_zone_table && ZONE_FLAGGED(zone, ZONE_WILDERNESS);
+}
+
+void spatial_grid_char_leave(struct char_data *ch)
+{
+  if (ch && ch->in_spatial_grid)
+  {
+    spatial_grid_remove(&player_grid, ch, ch->spatial_grid_cell);
+    ch->in_spatial_grid = FALSE;
+  }
+}
+
+void spatial_grid_char_update(struct char_data *ch)
+{
+  if (ch == NULL || world == NULL || zone_table == NULL)
+    return;
+
+  spatial_grid_char_leave(ch);
+  if (spatial_grid_wanted(ch))
+  {
+    ch->spatial_grid_cell = spatial_grid_insert(&player_grid, ch, X_LOC(ch), Y_LOC(ch));
+    ch->in_spatial_grid = TRUE;
+  }
+}
+
+int spatial_grid_players_near(int x, int y, int range, struct spatial_grid_result *result)
+{
+  return spatial_grid_query(&player_grid, x, y, range, result);
+}
+
+int spatial_grid_player_count(void)
+{
+  return player_grid.count;
+}
+
+void spatial_grid_shutdown(void)
+{
+  spatial_grid_free(&player_grid);
+}
@@ -0,0 +1,84 @@
+/* *************************************************************************
+ *   File: spatial_grid.h                              Part of LuminariMUD *
+ *  Usage: Bucketed grid over wilderness coordinates                      *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Spatial Grid                                                            *
+ * ============                                                            *
+ * Visual and audio stimuli used to find their observers by walking the   *
+ * whole character_list, and the audio mixer walked every sound still    *
+ * ringing, to compute a distance to each.  A spatial grid files items   *
+ * by the SPATIAL_GRID_CELL_SIZE square of wilderness they stand in, so  *
+ * a query looks only at the cells its range reaches.                     *
+ *                                                                         *
+ * One grid holds every player standing in a wilderness room;             *
+ * char_to_room() and char_from_room() keep it current, which covers      *
+ * char_to_coords() too.  Other systems keep grids of their own (the      *
+ * audio mixer files its active sources in one).  A query hands back     *
+ * everything inside the square around a point; callers still apply      *
+ * their own distance test.                                               *
+ ***************************************************************************/
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#define SPATIAL_GRID_CELL_SIZE 32 /* tiles along each side of a cell */
+/* The grid spans twice the map each way; anything past it is filed in the
+ * edge cells, so queries there still find it. */
+#define SPATIAL_GRID_MIN (-WILD_X_SIZE)
+#define SPATIAL_GRID_DIM (2 * WILD_X_SIZE / SPATIAL_GRID_CELL_SIZE)
+#define SPATIAL_GRID_CELLS (SPATIAL_GRID_DIM * SPATIAL_GRID_DIM)
+
+struct spatial_grid_entry
+{
+  void *item;
+  int x, y;
+};
+
+struct spatial_grid_cell
+{
+  struct spatial_grid_entry *entries;
+  int count, capacity;
+  int occupied_slot; /* Index in the grid's occupied list while count > 0 */
+};
+
+/* Zero-initialise to get an empty grid; the cells are allocated on the
+ * first insert. */
+struct spatial_grid
+{
+  struct spatial_grid_cell *cells;
+  int *occupied; /* Cells with anything in them, for wide queries */
+  int occupied_count;
+  int count;
+};
+
+/* What a query found.  Reuse one across queries; free it with
+ * spatial_grid_free_result(). */
+struct spatial_grid_result
+{
+  void **items;
+  int count, capacity;
+};
+
+/* File item at (x, y); returns the cell, which spatial_grid_remove()
+ * needs back. */
+int spatial_grid_insert(struct spatial_grid *grid, void *item, int x, int y);
+void spatial_grid_remove(struct spatial_grid *grid, void *item, int cell);
+/* Everything filed within range tiles of (x, y) along both axes, in no
+ * particular order.  Returns result->count. */
+int spatial_grid_query(const struct spatial_grid *grid, int x, int y, int range,
+                       struct spatial_grid_result *result);
+void spatial_grid_free(struct spatial_grid *grid);
+void spatial_grid_free_result(struct spatial_grid_result *result);
+
+/* The wilderness player grid.  Update after IN_ROOM(ch) is set, leave
+ * before it changes; both are safe to call for anyone at any time. */
+void spatial_grid_char_update(struct char_data *ch);
+void spatial_grid_char_leave(struct char_data *ch);
+/* Players in wilderness rooms within range tiles of (x, y) along both
+ * axes, connected or not. */
+int spatial_grid_players_near(int x, int y, int range, struct spatial_grid_result *result);
+int spatial_grid_player_count(void);
+void spatial_grid_shutdown(void);
+
+#endif /* SPATIAL_GRID_H */
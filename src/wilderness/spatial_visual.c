@@ -19,6 +19,7 @@
 #include "comm.h"
 #include "wilderness.h"
 #include "spatial_core.h"
+#include "spatial_grid.h"
 
 /* Visual System Constants */
 #define VISUAL_BASE_RANGE 1000.0f
@@ -144,6 +145,15 @@ struct spatial_system visual_system = {.system_name = "Visual",
                                        .pubsub_topic = "visual_wilderness",
                                        .pubsub_handler = "visual_stimulus_handler"};
 
+/* Observers found for the stimulus being delivered, reused between calls */
+static struct spatial_grid_result visual_observers;
+
+/* How far spatial_process_stimulus() lets a visual stimulus reach */
+static int visual_system_range(void)
+{
+  return (int)ceil(visual_system.stimulus->base_range * visual_system.global_range_multiplier);
+}
+
 /*
  * Visual Stimulus Strategy Implementation
  */
@@ -715,7 +725,7 @@ int spatial_visual_test_ship_passing(int ship_x, int ship_y, const char *ship_de
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!ship_desc)
   {
@@ -736,15 +746,15 @@ int spatial_visual_test_ship_passing(int ship_x, int ship_y, const char *ship_de
   ctx->source_x = ship_x;
   ctx->source_y = ship_y;
   ctx->source_z = 0; /* Sea level */
-  ctx->source_description = strdup(ship_desc);
+  ctx->source_description = (char *)ship_desc;
   ctx->base_intensity = 1.0;
 
-  /* Process for all wilderness players */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within the system's range */
+  spatial_grid_players_near(ship_x, ship_y, visual_system_range(), &visual_observers);
+  for (i = 0; i < visual_observers.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = visual_observers.items[i];
+    if (!ch->desc)
       continue;
 
     /* Set observer information */
@@ -788,7 +798,7 @@ int spatial_visual_meteor_approach(int meteor_x, int meteor_y, const char *meteo
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!meteor_desc)
   {
@@ -809,18 +819,19 @@ int spatial_visual_meteor_approach(int meteor_x, int meteor_y, const char *meteo
   ctx->source_x = meteor_x;
   ctx->source_y = meteor_y;
   ctx->source_z = 0; /* Will be updated per observer */
-  ctx->source_description = strdup(meteor_desc);
+  ctx->source_description = (char *)meteor_desc;
   ctx->base_intensity = 1.5; /* High intensity for dramatic meteor approach */
 
   /* Use extended range for distant meteors */
   ctx->effective_range = visual_range;
 
-  /* Process for all wilderness players within extended range */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within extended range; the elevation
+   * bonus at most doubles visual_range */
+  spatial_grid_players_near(meteor_x, meteor_y, 2 * visual_range, &visual_observers);
+  for (i = 0; i < visual_observers.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = visual_observers.items[i];
+    if (!ch->desc)
       continue;
 
     /* Debug: Log player coordinates */
@@ -888,7 +899,7 @@ int spatial_visual_meteor_descent(int meteor_x, int meteor_y, const char *meteor
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!meteor_desc)
   {
@@ -909,18 +920,19 @@ int spatial_visual_meteor_descent(int meteor_x, int meteor_y, const char *meteor
   ctx->source_x = meteor_x;
   ctx->source_y = meteor_y;
   ctx->source_z = 0; /* Will be updated per observer */
-  ctx->source_description = strdup(meteor_desc);
+  ctx->source_description = (char *)meteor_desc;
   ctx->base_intensity = 2.0; /* Very intense descending meteors */
 
   /* Use closer range for descending meteors */
   ctx->effective_range = visual_range;
 
-  /* Process for all wilderness players within range */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within range; the elevation bonus at
+   * most doubles visual_range */
+  spatial_grid_players_near(meteor_x, meteor_y, 2 * visual_range, &visual_observers);
+  for (i = 0; i < visual_observers.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = visual_observers.items[i];
+    if (!ch->desc)
       continue;
 
     /* Check if player can see descending meteors using elevation-aware horizontal visibility */
@@ -978,7 +990,7 @@ int spatial_visual_meteor_impact(int impact_x, int impact_y, const char *impact_
 {
   struct spatial_context *ctx;
   struct char_data *ch;
-  int processed_count = 0;
+  int processed_count = 0, i;
 
   if (!impact_desc)
   {
@@ -999,15 +1011,15 @@ int spatial_visual_meteor_impact(int impact_x, int impact_y, const char *impact_
   ctx->source_x = impact_x;
   ctx->source_y = impact_y;
   ctx->source_z = 0; /* Ground level impact */
-  ctx->source_description = strdup(impact_desc);
+  ctx->source_description = (char *)impact_desc;
   ctx->base_intensity = 2.5; /* Extremely intense ground impact explosion */
 
-  /* Process for all wilderness players within range */
-  for (ch = character_list; ch; ch = ch->next)
+  /* Process for the wilderness players within range */
+  spatial_grid_players_near(impact_x, impact_y, range, &visual_observers);
+  for (i = 0; i < visual_observers.count; i++)
   {
-    if (IS_NPC(ch) || !ch->desc)
-      continue;
-    if (!ZONE_FLAGGED(GET_ROOM_ZONE(IN_ROOM(ch)), ZONE_WILDERNESS))
+    ch = visual_observers.items[i];
+    if (!ch->desc)
       continue;
 
     /* Check if player is within range - impacts are ground level, use horizontal distance only */
@@ -19,6 +19,7 @@
 #include "wilderness.h"
 #include "modify.h" /* For strip_colors() */
 #include "mysql.h"
+#include "perfmon.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -125,29 +126,41 @@ static bool terrain_api_database_is_healthy(void)
   return mysql_available && conn && ensure_mysql_connection(conn, __func__);
 }
 
-static bool terrain_api_send_all(socket_t client_socket, const char *data, size_t data_length)
+/**
+ * @brief Send as much of a client's queued HTTP response as its socket takes
+ *
+ * Never waits: a reader that is slow to drain the response is left for a
+ * later pass rather than holding up the game loop.
+ *
+ * @return 1 once all of it is sent, 0 while some remains, -1 on an error
+ */
+static int terrain_api_send_output(struct terrain_api_client *client)
 {
-  size_t total_sent = 0;
   ssize_t sent;
 
-  while (total_sent < data_length)
+  while (client->output_sent < client->output_length)
   {
-    sent = send(client_socket, data + total_sent, data_length - total_sent, 0);
+    sent = send(client->socket, client->output + client->output_sent,
+                client->output_length - client->output_sent, 0);
     if (sent > 0)
     {
-      total_sent += (size_t)sent;
+      client->output_sent += (size_t)sent;
       continue;
     }
     if (sent < 0 && errno == EINTR)
       continue;
-    return false;
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return 0;
+    return -1;
   }
 
-  return true;
+  return 1;
 }
 
-static bool terrain_api_send_http_response(socket_t client_socket, int status_code, bool head_only,
-                                           const char *body)
+/* Queue a complete HTTP response on client, for terrain_api_send_output(). */
+static bool terrain_api_queue_http_response(struct terrain_api_client *client, int status_code,
+                                            bool head_only, const char *content_type,
+                                            const char *body)
 {
   const char *reason;
   char header[512];
@@ -183,27 +196,36 @@ static bool terrain_api_send_http_response(socket_t client_socket, int status_co
   body_length = strlen(body);
   header_length = snprintf(header, sizeof(header),
                            "HTTP/1.1 %d %s\r\n"
-                           "Content-Type: application/json\r\n"
+                           "Content-Type: %s\r\n"
                            "Content-Length: %zu\r\n"
                            "Cache-Control: no-store\r\n"
                            "Connection: close\r\n\r\n",
-                           status_code, reason, body_length);
-  if (header_length < 0 || (size_t)header_length >= sizeof(header) ||
-      !terrain_api_send_all(client_socket, header, (size_t)header_length))
+                           status_code, reason, content_type, body_length);
+  if (header_length < 0 || (size_t)header_length >= sizeof(header))
     return false;
-
-  return head_only || terrain_api_send_all(client_socket, body, body_length);
+  if (head_only)
+    body_length = 0;
+
+  free(client->output);
+  client->output_length = (size_t)header_length + body_length;
+  client->output_sent = 0;
+  CREATE(client->output, char, client->output_length);
+  memcpy(client->output, header, (size_t)header_length);
+  memcpy(client->output + header_length, body, body_length);
+  return true;
 }
 
 /**
- * @brief Build the JSON body and status for the loopback HTTP health endpoint.
+ * @brief Build the body and status for the loopback HTTP endpoints.
  *
  * `/health` and `/health/ready` report readiness, including the required
  * MariaDB connection. `/health/live` only proves that the initialized game
- * loop is servicing requests. The listener itself remains bound to loopback.
+ * loop is servicing requests. `/metrics` serves perfmon's counters in
+ * OpenMetrics text format for Prometheus. The listener itself remains bound
+ * to loopback.
  */
 char *process_terrain_http_request(const char *http_request, bool database_healthy, long uptime,
-                                   int *status_code, bool *head_only)
+                                   int *status_code, bool *head_only, const char **content_type)
 {
   char method[16];
   char path[256];
@@ -212,11 +234,12 @@ char *process_terrain_http_request(const char *http_request, bool database_healt
   char *query;
   int written;
 
-  if (!status_code || !head_only)
+  if (!status_code || !head_only || !content_type)
     return NULL;
 
   *status_code = 400;
   *head_only = false;
+  *content_type = "application/json";
   if (!http_request || sscanf(http_request, "%15s %255s %15s", method, path, version) != 3 ||
       (strcmp(version, "HTTP/1.0") && strcmp(version, "HTTP/1.1")))
     return strdup("{\"service\":\"luminari-mud\",\"status\":\"bad_request\"}");
@@ -235,7 +258,17 @@ char *process_terrain_http_request(const char *http_request, bool database_healt
   if (uptime < 0)
     uptime = 0;
 
-  if (!strcmp(path, "/health/live"))
+  if (!strcmp(path, "/metrics"))
+  {
+    char *metrics;
+
+    CREATE(metrics, char, TERRAIN_API_METRICS_SIZE);
+    PERF_metrics_repr(metrics, TERRAIN_API_METRICS_SIZE);
+    *status_code = 200;
+    *content_type = PERF_METRICS_CONTENT_TYPE;
+    return metrics;
+  }
+  else if (!strcmp(path, "/health/live"))
   {
     *status_code = 200;
     written = snprintf(body, sizeof(body),
@@ -493,6 +526,9 @@ void terrain_api_disconnect_client(int client_index)
 
     CLOSE_SOCKET(client->socket);
     client->socket = INVALID_SOCKET;
+    free(client->output);
+    client->output = NULL;
+    client->output_length = client->output_sent = 0;
     client->input_pos = 0;
     client->connect_time = 0;
     client->requests_processed = 0;
@@ -1310,6 +1346,7 @@ void terrain_api_process_clients(void)
   char temp_buffer[1024];
   bool database_healthy;
   bool head_only;
+  const char *content_type;
   bool is_http;
   long uptime;
   size_t response_len;
@@ -1325,6 +1362,15 @@ void terrain_api_process_clients(void)
       continue;
     }
 
+    /* Finish a response the socket would not take at once; the connection
+     * closes after it. */
+    if (client->output)
+    {
+      if (terrain_api_send_output(client) != 0)
+        terrain_api_disconnect_client(i);
+      continue;
+    }
+
     /* Read data from client */
     bytes_read = recv(client->socket, temp_buffer, sizeof(temp_buffer) - 1, 0);
 
@@ -1354,9 +1400,9 @@ void terrain_api_process_clients(void)
             database_healthy = !terrain_api_http_request_needs_database(client->input_buffer) ||
                                terrain_api_database_is_healthy();
             response = process_terrain_http_request(client->input_buffer, database_healthy, uptime,
-                                                    &status_code, &head_only);
-            if (!response ||
-                !terrain_api_send_http_response(client->socket, status_code, head_only, response))
+                                                    &status_code, &head_only, &content_type);
+            if (!response || !terrain_api_queue_http_response(client, status_code, head_only,
+                                                              content_type, response))
               log("Terrain-API: HTTP response failed for client %d", i);
             else
             {
@@ -1364,7 +1410,8 @@ void terrain_api_process_clients(void)
               terrain_api->total_requests++;
             }
             free(response);
-            terrain_api_disconnect_client(i);
+            if (!client->output || terrain_api_send_output(client) != 0)
+              terrain_api_disconnect_client(i);
             continue;
           }
 
@@ -1467,6 +1514,23 @@ void log_terrain_api_stats(void)
 }
 
 /* Accessor functions for external code */
+/**
+ * @brief Whether any client still has part of a response to be sent
+ *
+ * The game loop keeps passing, rather than sleeping, until it is sent.
+ */
+bool terrain_api_has_pending_output(void)
+{
+  int i;
+
+  if (!terrain_api)
+    return false;
+  for (i = 0; i < terrain_api->max_clients; i++)
+    if (terrain_api->clients[i].socket != INVALID_SOCKET && terrain_api->clients[i].output)
+      return true;
+  return false;
+}
+
 int terrain_api_is_running(void)
 {
   return (terrain_api && terrain_api->server_socket != INVALID_SOCKET);
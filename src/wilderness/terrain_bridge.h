@@ -10,6 +10,7 @@
 #define TERRAIN_API_MAX_CLIENTS 10
 #define TERRAIN_API_MAX_MSG_SIZE 4096
 #define TERRAIN_API_MAX_BATCH_SIZE 1000
+#define TERRAIN_API_METRICS_SIZE (256 * 1024) /* Largest /metrics body */
 
 /* Client connection structure */
 struct terrain_api_client
@@ -19,6 +20,9 @@ struct terrain_api_client
   int input_pos;
   time_t connect_time;
   int requests_processed;
+  char *output;         /* HTTP response still being sent, or NULL */
+  size_t output_length; /* Its length, header included */
+  size_t output_sent;   /* How much of it the socket has taken */
 };
 
 /* Main server structure */
@@ -41,9 +45,10 @@ void terrain_api_process(void);
 void terrain_api_accept_connections(void);
 void terrain_api_process_clients(void);
 void terrain_api_disconnect_client(int client_index);
+bool terrain_api_has_pending_output(void);
 char *process_terrain_request(const char *json_request);
 char *process_terrain_http_request(const char *http_request, bool database_healthy, long uptime,
-                                   int *status_code, bool *head_only);
+                                   int *status_code, bool *head_only, const char **content_type);
 void log_terrain_api_stats(void);
 
 /* Accessor functions for terrain API server */
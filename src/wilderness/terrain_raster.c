@@ -0,0 +1,292 @@
+/* *************************************************************************
+ *   File: terrain_raster.c                            Part of LuminariMUD *
+ *  Usage: Baked wilderness elevation and moisture, mapped from disk      *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Terrain Raster                                                          *
+ * ==============                                                          *
+ * The file is a header followed by one cell per tile, row by row.  The   *
+ * header records the format version and the noise seeds it was baked     *
+ * with; a few cells are checked against the live noise whenever it is    *
+ * mapped, which also catches a C library whose random() differs.  See   *
+ * terrain_raster.h for the interface.                                    *
+ ***************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "wilderness.h"
+#include "terrain_raster.h"
+#include "perfmon.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TERRAIN_RASTER_MAGIC "LUMTRRN"
+#define TERRAIN_RASTER_SAMPLES 8 /* per axis, checked against live noise on open */
+
+/* The noise maps baked into each cell, in order. */
+static const int raster_maps[2] = {NOISE_MATERIAL_PLANE_ELEV, NOISE_MATERIAL_PLANE_MOISTURE};
+
+struct terrain_raster_header
+{
+  char magic[8];
+  int32_t version;
+  int32_t seeds[3]; /* Elevation, moisture and distortion noise */
+  int32_t min_x, min_y;
+  int32_t width, height;
+};
+
+struct terrain_raster_cell
+{
+  int16_t elevation[2]; /* get_elevation_noise() on each of raster_maps */
+  int16_t moisture[2];  /* get_moisture_noise() on each of raster_maps */
+};
+
+static struct
+{
+  void *base;
+  size_t length;
+  const struct terrain_raster_cell *cells;
+  long min_x, min_y;
+  long width, height;
+} raster;
+
+static void raster_header_init(struct terrain_raster_header *header, int min_x, int min_y,
+                               int width, int height)
+{
+  memset(header, 0, sizeof(*header));
+  strcpy(header->magic, TERRAIN_RASTER_MAGIC);
+  header->version = TERRAIN_RASTER_VERSION;
+  header->seeds[0] = NOISE_MATERIAL_PLANE_ELEV_SEED;
+  header->seeds[1] = NOISE_MATERIAL_PLANE_MOISTURE_SEED;
+  header->seeds[2] = NOISE_MATERIAL_PLANE_ELEV_DIST_SEED;
+  header->min_x = min_x;
+  header->min_y = min_y;
+  header->width = width;
+  header->height = height;
+}
+
+static int raster_slot(int map)
+{
+  if (map == raster_maps[0])
+    return 0;
+  if (map == raster_maps[1])
+    return 1;
+  return -1;
+}
+
+/* Live noise for one tile; FALSE if a value does not fit the cell. */
+static bool raster_bake_cell(int x, int y, struct terrain_raster_cell *cell)
+{
+  int slot, elevation, moisture;
+
+  for (slot = 0; slot < 2; slot++)
+  {
+    elevation = get_elevation_noise(raster_maps[slot], x, y);
+    moisture = get_moisture_noise(raster_maps[slot], x, y);
+    if (elevation < INT16_MIN || elevation > INT16_MAX || moisture < INT16_MIN ||
+        moisture > INT16_MAX)
+      return FALSE;
+    cell->elevation[slot] = (int16_t)elevation;
+    cell->moisture[slot] = (int16_t)moisture;
+  }
+  return TRUE;
+}
+
+bool terrain_raster_build(const char *path, int min_x, int min_y, int width, int height)
+{
+  struct terrain_raster_header header;
+  struct terrain_raster_cell *row = NULL;
+  char temp_path[PATH_MAX];
+  FILE *fl;
+  uint64_t started = PERF_monotonic_usec();
+  int x, y, tenths = 0;
+  bool ok = TRUE;
+
+  if (width <= 0 || height <= 0)
+    return FALSE;
+
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+  if (!(fl = fopen(temp_path, "wb")))
+  {
+    log("SYSERR: Cannot write terrain raster %s: %s", temp_path, strerror(errno));
+    return FALSE;
+  }
+
+  raster_header_init(&header, min_x, min_y, width, height);
+  ok = fwrite(&header, sizeof(header), 1, fl) == 1;
+
+  CREATE(row, struct terrain_raster_cell, width);
+  for (y = 0; ok && y < height; y++)
+  {
+    for (x = 0; ok && x < width; x++)
+      if (!raster_bake_cell(min_x + x, min_y + y, &row[x]))
+      {
+        log("SYSERR: Terrain at (%d, %d) does not fit the raster.", min_x + x, min_y + y);
+        ok = FALSE;
+      }
+    if (ok)
+      ok = fwrite(row, sizeof(*row), width, fl) == (size_t)width;
+    /* A full bake runs for many seconds at boot; show it is moving. */
+    if (ok && (y + 1) * 10L / height > tenths && y + 1 < height)
+    {
+      tenths = (int)((y + 1) * 10L / height);
+      log("Terrain raster: %d%% baked after %.1f seconds.", tenths * 10,
+          (PERF_monotonic_usec() - started) / 1000000.0);
+    }
+  }
+  free(row);
+
+  if (fclose(fl) != 0)
+    ok = FALSE;
+  if (ok && rename(temp_path, path) != 0)
+  {
+    log("SYSERR: Cannot rename terrain raster %s to %s: %s", temp_path, path, strerror(errno));
+    ok = FALSE;
+  }
+  if (!ok)
+    remove(temp_path);
+  else
+    log("Built terrain raster %s in %.1f seconds.", path,
+        (PERF_monotonic_usec() - started) / 1000000.0);
+  return ok;
+}
+
+/* Compare a grid of cells spread over the raster with the live noise. */
+static bool raster_matches_noise(void)
+{
+  struct terrain_raster_cell live;
+  const struct terrain_raster_cell *baked;
+  long col, row;
+  int i, j;
+
+  for (i = 0; i < TERRAIN_RASTER_SAMPLES; i++)
+    for (j = 0; j < TERRAIN_RASTER_SAMPLES; j++)
+    {
+      col = (raster.width - 1) * i / (TERRAIN_RASTER_SAMPLES - 1);
+      row = (raster.height - 1) * j / (TERRAIN_RASTER_SAMPLES - 1);
+      baked = &raster.cells[row * raster.width + col];
+      if (!raster_bake_cell((int)(raster.min_x + col), (int)(raster.min_y + row), &live) ||
+          memcmp(&live, baked, sizeof(live)))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+bool terrain_raster_open(const char *path)
+{
+  struct terrain_raster_header expected;
+  const struct terrain_raster_header *header;
+  struct stat st;
+  void *base;
+  int fd;
+
+  terrain_raster_close();
+
+  if ((fd = open(path, O_RDONLY)) < 0)
+    return FALSE;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*header))
+  {
+    close(fd);
+    return FALSE;
+  }
+  base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    log("SYSERR: Cannot map terrain raster %s: %s", path, strerror(errno));
+    return FALSE;
+  }
+
+  header = base;
+  raster_header_init(&expected, header->min_x, header->min_y, header->width, header->height);
+  if (memcmp(header, &expected, sizeof(expected)) || header->width <= 0 ||
+      header->height <= 0 ||
+      (size_t)st.st_size != sizeof(*header) + (size_t)header->width * (size_t)header->height *
+                                                   sizeof(struct terrain_raster_cell))
+  {
+    log("Terrain raster %s is from another version or seed.", path);
+    munmap(base, (size_t)st.st_size);
+    return FALSE;
+  }
+
+  raster.base = base;
+  raster.length = (size_t)st.st_size;
+  raster.cells = (const struct terrain_raster_cell *)(header + 1);
+  raster.min_x = header->min_x;
+  raster.min_y = header->min_y;
+  raster.width = header->width;
+  raster.height = header->height;
+
+  if (!raster_matches_noise())
+  {
+    log("Terrain raster %s does not match the live noise.", path);
+    terrain_raster_close();
+    return FALSE;
+  }
+  return TRUE;
+}
+
+bool terrain_raster_load(const char *path)
+{
+  if (terrain_raster_open(path))
+    return TRUE;
+
+  log("Building wilderness terrain raster %s (%dx%d tiles), this takes a while.", path,
+      TERRAIN_RASTER_WIDTH, TERRAIN_RASTER_HEIGHT);
+  if (terrain_raster_build(path, TERRAIN_RASTER_MIN_X, TERRAIN_RASTER_MIN_Y, TERRAIN_RASTER_WIDTH,
+                           TERRAIN_RASTER_HEIGHT) &&
+      terrain_raster_open(path))
+    return TRUE;
+
+  log("SYSERR: No terrain raster; wilderness terrain comes from live noise.");
+  return FALSE;
+}
+
+void terrain_raster_close(void)
+{
+  if (raster.base)
+    munmap(raster.base, raster.length);
+  memset(&raster, 0, sizeof(raster));
+}
+
+bool terrain_raster_active(void)
+{
+  return raster.cells != NULL;
+}
+
+static const struct terrain_raster_cell *raster_cell(int x, int y)
+{
+  unsigned long col = (unsigned long)((long)x - raster.min_x);
+  unsigned long row = (unsigned long)((long)y - raster.min_y);
+
+  if (!raster.cells || col >= (unsigned long)raster.width || row >= (unsigned long)raster.height)
+    return NULL;
+  return &raster.cells[row * raster.width + col];
+}
+
+bool terrain_raster_elevation(int map, int x, int y, int *value)
+{
+  const struct terrain_raster_cell *cell;
+  int slot = raster_slot(map);
+
+  if (slot < 0 || !(cell = raster_cell(x, y)))
+    return FALSE;
+  *value = cell->elevation[slot];
+  return TRUE;
+}
+
+bool terrain_raster_moisture(int map, int x, int y, int *value)
+{
+  const struct terrain_raster_cell *cell;
+  int slot = raster_slot(map);
+
+  if (slot < 0 || !(cell = raster_cell(x, y)))
+    return FALSE;
+  *value = cell->moisture[slot];
+  return TRUE;
+}
@@ -0,0 +1,50 @@
+/* *************************************************************************
+ *   File: terrain_raster.h                            Part of LuminariMUD *
+ *  Usage: Baked wilderness elevation and moisture, mapped from disk      *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Terrain Raster                                                          *
+ * ==============                                                          *
+ * get_elevation() and get_moisture() run many octaves of Perlin noise    *
+ * per call, and every map, room and resource lookup asks them again for  *
+ * the same tiles.  The seeds never change, so the answers are baked once *
+ * into a raster file, which the server maps read-only at boot.  Tiles    *
+ * outside the raster, and every tile when no raster could be mapped, go  *
+ * to the live noise as before.                                           *
+ ***************************************************************************/
+
+#ifndef TERRAIN_RASTER_H
+#define TERRAIN_RASTER_H
+
+#define TERRAIN_RASTER_FILE LIB_ETC "terrain.raster"
+
+/* Bump whenever get_elevation_noise() or get_moisture_noise() change what
+ * they return, so existing raster files are rebuilt. */
+#define TERRAIN_RASTER_VERSION 1
+
+/* What the boot-time raster covers: the continent's bounding box. */
+#define TERRAIN_RASTER_MIN_X (-(WILD_X_SIZE / 2))
+#define TERRAIN_RASTER_MIN_Y (-(WILD_Y_SIZE / 2))
+#define TERRAIN_RASTER_WIDTH (WILD_X_SIZE + 1)
+#define TERRAIN_RASTER_HEIGHT (WILD_Y_SIZE + 1)
+
+/* Write a raster of live noise over the given rectangle to path. */
+bool terrain_raster_build(const char *path, int min_x, int min_y, int width, int height);
+
+/* Map path if it is a current raster. FALSE, with nothing mapped, when
+ * the file is missing, truncated, from another version or seed, or
+ * disagrees with the live noise. */
+bool terrain_raster_open(const char *path);
+
+/* Boot: map path, rebuilding it first when it is missing or stale. */
+bool terrain_raster_load(const char *path);
+
+void terrain_raster_close(void);
+bool terrain_raster_active(void);
+
+/* Baked get_elevation_noise()/get_moisture_noise() for the elevation and
+ * moisture noise maps; FALSE when (map, x, y) is not in the raster. */
+bool terrain_raster_elevation(int map, int x, int y, int *value);
+bool terrain_raster_moisture(int map, int x, int y, int *value);
+
+#endif /* TERRAIN_RASTER_H */
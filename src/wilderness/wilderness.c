@@ -37,6 +37,8 @@
 #include "mud_event.h"
 #include "wilderness.h"
 #include "kdtree.h"
+#include "room_pool.h"
+#include "terrain_raster.h"
 
 #include "mysql.h"
 #include "desc_engine.h"
@@ -151,6 +153,9 @@ void initialize_wilderness_lists()
 
   kd_wilderness_rooms = kd_create(2);
 
+  /* Rooms were added or removed; the dynamic pool index rebuilds on next use. */
+  wild_pool_reset();
+
   /* Set destructor to free the room_rnum pointers when the tree is destroyed */
   kd_data_destructor(kd_wilderness_rooms, free);
 
@@ -232,7 +237,9 @@ double get_radial_gradient(int x, int y)
   return 0;
 }
 
-int get_elevation(int map, int x, int y)
+/* Elevation straight from the noise; get_elevation() answers from the
+ * terrain raster where it can. */
+int get_elevation_noise(int map, int x, int y)
 {
   double trans_x;
   double trans_y;
@@ -273,6 +280,15 @@ int get_elevation(int map, int x, int y)
   return 255 * result;
 }
 
+int get_elevation(int map, int x, int y)
+{
+  int elevation;
+
+  if (terrain_raster_elevation(map, x, y, &elevation))
+    return elevation;
+  return get_elevation_noise(map, x, y);
+}
+
 /* Get elevation with region modifications but maintaining wilderness scale (0-255) */
 int get_modified_elevation(int x, int y)
 {
@@ -374,7 +390,7 @@ int get_weather(int x, int y)
   return 255 * result;
 }
 
-int get_moisture(int map, int x, int y)
+int get_moisture_noise(int map, int x, int y)
 {
   double trans_x;
   double trans_y;
@@ -391,6 +407,15 @@ int get_moisture(int map, int x, int y)
   return 255 * result;
 }
 
+int get_moisture(int map, int x, int y)
+{
+  int moisture;
+
+  if (terrain_raster_moisture(map, x, y, &moisture))
+    return moisture;
+  return get_moisture_noise(map, x, y);
+}
+
 int get_temperature(int map, int x, int y)
 {
   /* This is a gradient in the y direction, modified
@@ -883,7 +908,6 @@ room_rnum find_static_room_by_coordinates(int x, int y)
  * vector and a pointer to struct room_data (the actual room!). */
 room_rnum find_room_by_coordinates(int x, int y)
 {
-  int i = 0;
   room_rnum room = NOWHERE;
 
   if ((room = find_static_room_by_coordinates(x, y)) != NOWHERE)
@@ -891,44 +915,13 @@ room_rnum find_room_by_coordinates(int x, int y)
     return room;
   }
   /* Check the dynamic rooms. */
-  for (i = WILD_DYNAMIC_ROOM_VNUM_START;
-       (i <= WILD_DYNAMIC_ROOM_VNUM_END) && (real_room(i) != NOWHERE); i++)
-  {
-    if ((ROOM_FLAGGED(real_room(i), ROOM_OCCUPIED)) && (world[real_room(i)].coords[X_COORD] == x) &&
-        (world[real_room(i)].coords[Y_COORD] == y))
-    {
-      /* Match */
-      return real_room(i);
-    }
-  }
-
-  /* No rooms currently allocated for (x,y), so allocate one. */
-  //  if((room = find_available_wilderness_room()) == NOWHERE)
-  //    return NOWHERE; /* No rooms available. */
-
-  //  assign_wilderness_room(room, x, y);
-
-  return room;
+  return wild_pool_find(x, y);
 }
 
+/* An unoccupied room from the dynamic pool; see room_pool.h. */
 room_rnum find_available_wilderness_room()
 {
-  int i = 0;
-
-  for (i = WILD_DYNAMIC_ROOM_VNUM_START; i <= WILD_DYNAMIC_ROOM_VNUM_END; i++)
-  {
-    /* Skip gaps. */
-    if (real_room(i) == NOWHERE)
-      continue;
-
-    if (!ROOM_FLAGGED(real_room(i), ROOM_OCCUPIED))
-    {
-      /* Here is our room. */
-      return real_room(i);
-    }
-  }
-  /* If we get here, there is a problem. */
-  return NOWHERE;
+  return wild_pool_available();
 }
 
 /*
@@ -987,6 +980,7 @@ void assign_wilderness_room(room_rnum room, int x, int y)
   /* Here we will set the coordinates, build the descriptions, set the exits, sector type, etc. */
   world[room].coords[0] = x;
   world[room].coords[1] = y;
+  wild_pool_note_moved(room);
 
   /* Get the enclosing regions. */
   regions = get_enclosing_regions(GET_ROOM_ZONE(room), x, y);
@@ -1095,6 +1089,7 @@ void mark_wilderness_room_occupied(room_rnum room)
   }
 
   SET_BIT_AR(ROOM_FLAGS(room), ROOM_OCCUPIED);
+  wild_pool_note_occupied(room);
   if (!room_has_mud_event(&world[room], eCHECK_OCCUPIED))
   {
     NEW_EVENT(eCHECK_OCCUPIED, &world[room].number, NULL, 10 RL_SEC);
@@ -1741,6 +1736,7 @@ EVENTFUNC(event_check_occupied)
       (room->events && room->events->iSize == 1))
   {
     REMOVE_BIT_AR(ROOM_FLAGS(rnum), ROOM_OCCUPIED);
+    wild_pool_note_released(rnum);
     return 0; /* No need to continue checking! */
   }
   else
@@ -229,6 +229,10 @@ struct wild_map_tile
 void get_map(int xsize, int ysize, int center_x, int center_y, struct wild_map_tile **map);
 void wild_map_cache_invalidate(void);
 int get_elevation(int map, int x, int y);
+int get_elevation_noise(int map, int x, int y);
+int get_moisture(int map, int x, int y);
+int get_moisture_noise(int map, int x, int y);
+int get_temperature(int map, int x, int y);
 int get_comprehensive_elevation(int x, int y, zone_rnum zone);
 int get_modified_elevation(int x, int y);
 float get_elevation_relative_sea_level(int x, int y);
@@ -0,0 +1,253 @@
+/* *************************************************************************
+ *   File: zone_presence.c                             Part of LuminariMUD *
+ *  Usage: Per-zone lists of the characters that can make a zone "busy"   *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * See zone_presence.h.  A listed character is always in a room of the    *
+ * zone whose list it is on, so taking it off only needs its room; that   *
+ * keeps the lists right when zedit inserts a zone and shifts the zone    *
+ * rnums, since the list heads move with their zone_table entries.        *
+ ***************************************************************************/
+
+#include "conf.h"
+#include "sysdep.h"
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "db.h"
+#include "perfmon.h"
+#include "zone_presence.h"
+
+#if defined(ZONE_PRESENCE_VALIDATE)
+bool zone_presence_validate = TRUE;
+#else
+bool zone_presence_validate = FALSE;
+#endif
+
+/* Listed characters across every zone; what the old scan had to wade
+ * through, near enough, since each one is a descriptor or a linkless PC. */
+static int presence_total = 0;
+
+static bool zone_presence_wanted(struct char_data *ch)
+{
+  if (IN_ROOM(ch) == NOWHERE || IN_ROOM(ch) > top_of_world ||
+      world[IN_ROOM(ch)].zone == NOWHERE || world[IN_ROOM(ch)].zone > top_of_zone_table)
+    return FALSE;
+  return !IS_NPC(ch) || ch->desc != NULL;
+}
+
+static void zone_presence_link(struct char_data *ch)
+{
+  struct zone_data *zone = &zone_table[world[IN_ROOM(ch)].zone];
+
+  ch->prev_in_zone = NULL;
+  ch->next_in_zone = zone->presence;
+  if (zone->presence)
+    zone->presence->prev_in_zone = ch;
+  zone->presence = ch;
+  zone->presence_count++;
+  ch->in_zone_presence = TRUE;
+  presence_total++;
+}
+
+static void zone_presence_unlink(struct char_data *ch)
+{
+  struct zone_data *zone = &zone_table[world[IN_ROOM(ch)].zone];
+
+  if (ch->prev_in_zone)
+    ch->prev_in_zone->next_in_zone = ch->next_in_zone;
+  else
+    zone->presence = ch->next_in_zone;
+  if (ch->next_in_zone)
+    ch->next_in_zone->prev_in_zone = ch->prev_in_zone;
+  ch->next_in_zone = ch->prev_in_zone = NULL;
+  zone->presence_count--;
+  ch->in_zone_presence = FALSE;
+  presence_total--;
+}
+
+void zone_presence_update(struct char_data *ch)
+{
+  bool wanted;
+
+  if (ch == NULL || world == NULL || zone_table == NULL)
+    return;
+
+  wanted = zone_presence_wanted(ch);
+  if (wanted && !ch->in_zone_presence)
+    zone_presence_link(ch);
+  else if (!wanted && ch->in_zone_presence)
+    zone_presence_unlink(ch);
+}
+
+void zone_presence_leave(struct char_data *ch)
+{
+  if (ch && ch->in_zone_presence && zone_table && IN_ROOM(ch) != NOWHERE &&
+      IN_ROOM(ch) <= top_of_world && world[IN_ROOM(ch)].zone <= top_of_zone_table)
+    zone_presence_unlink(ch);
+}
+
+/* The test the old descriptor scan applied to each descriptor's character.
+ * If an immortal has nohassle off, he counts as present. Added for testing
+ * zone reset triggers -Welcor */
+bool zone_presence_counts(struct char_data *ch)
+{
+  if (ch->desc == NULL || ch->desc->character != ch || STATE(ch->desc) != CON_PLAYING)
+    return FALSE;
+  if (!IS_NPC(ch) && GET_LEVEL(ch) >= LVL_IMMORT && PRF_FLAGGED(ch, PRF_NOHASSLE))
+    return FALSE;
+  return TRUE;
+}
+
+/* The old is_empty(), kept for zone_presence_validate and the audit. */
+static int zone_presence_scan_empty(zone_rnum zone)
+{
+  struct descriptor_data *i;
+
+  for (i = descriptor_list; i; i = i->next)
+  {
+    if (STATE(i) != CON_PLAYING)
+      continue;
+    if (IN_ROOM(i->character) == NOWHERE)
+      continue;
+    if (world[IN_ROOM(i->character)].zone != zone)
+      continue;
+    if ((!IS_NPC(i->character)) && (GET_LEVEL(i->character) >= LVL_IMMORT) &&
+        (PRF_FLAGGED(i->character, PRF_NOHASSLE)))
+      continue;
+
+    return (0);
+  }
+
+  return (1);
+}
+
+static void zone_presence_rebuild(void)
+{
+  struct char_data *ch;
+  zone_rnum zone;
+
+  for (zone = 0; zone <= top_of_zone_table; zone++)
+  {
+    zone_table[zone].presence = NULL;
+    zone_table[zone].presence_count = 0;
+  }
+  presence_total = 0;
+
+  for (ch = character_list; ch; ch = ch->next)
+  {
+    ch->in_zone_presence = FALSE;
+    ch->next_in_zone = ch->prev_in_zone = NULL;
+    zone_presence_update(ch);
+  }
+}
+
+static int zone_presence_list_empty(zone_rnum zone, uint64_t *visited)
+{
+  struct char_data *ch;
+
+  for (ch = zone_table[zone].presence; ch; ch = ch->next_in_zone)
+  {
+    (*visited)++;
+    if (zone_presence_counts(ch))
+      return (0);
+  }
+  return (1);
+}
+
+int zone_presence_is_empty(zone_rnum zone)
+{
+  uint64_t visited = 0;
+  int empty, scanned;
+
+  if (zone == NOWHERE || zone > top_of_zone_table)
+    return (zone_presence_scan_empty(zone));
+
+  empty = zone_presence_list_empty(zone, &visited);
+  PERF_note_zone_presence_check(visited, (uint64_t)presence_total);
+
+  if (zone_presence_validate && (scanned = zone_presence_scan_empty(zone)) != empty)
+  {
+    log("SYSERR: is_empty(%d) from the presence list was %d, descriptor scan %d; rebuilding",
+        zone_table[zone].number, empty, scanned);
+    zone_presence_rebuild();
+    empty = scanned;
+  }
+
+  return (empty);
+}
+
+bool zone_presence_occupied(zone_rnum zone)
+{
+  struct char_data *ch;
+
+  if (zone_table == NULL || zone == NOWHERE || zone > top_of_zone_table)
+    return FALSE;
+
+  for (ch = zone_table[zone].presence; ch; ch = ch->next_in_zone)
+    if (ch->desc && ch->desc->character == ch && STATE(ch->desc) == CON_PLAYING)
+      return TRUE;
+  return FALSE;
+}
+
+int zone_presence_audit(char *buf, size_t len)
+{
+  struct char_data *ch;
+  zone_rnum zone;
+  int problems = 0, listed, empty, offset = 0;
+  uint64_t visited = 0;
+
+  *buf = '\0';
+
+  for (zone = 0; zone <= top_of_zone_table; zone++)
+  {
+    listed = 0;
+    for (ch = zone_table[zone].presence; ch; ch = ch->next_in_zone)
+    {
+      listed++;
+      if (!ch->in_zone_presence || IN_ROOM(ch) == NOWHERE || IN_ROOM(ch) > top_of_world ||
+          world[IN_ROOM(ch)].zone != zone)
+      {
+        problems++;
+        offset = snprintf_append(buf, len, offset, "Zone %d lists %s, who is not there.\r\n",
+                                 zone_table[zone].number, GET_NAME(ch));
+      }
+    }
+    if (listed != zone_table[zone].presence_count)
+    {
+      problems++;
+      offset = snprintf_append(buf, len, offset, "Zone %d counts %d but lists %d.\r\n",
+                               zone_table[zone].number, zone_table[zone].presence_count, listed);
+    }
+    if ((empty = zone_presence_list_empty(zone, &visited)) != zone_presence_scan_empty(zone))
+    {
+      problems++;
+      offset = snprintf_append(buf, len, offset,
+                               "Zone %d is %s by its list but %s by the descriptor scan.\r\n",
+                               zone_table[zone].number, empty ? "empty" : "busy",
+                               empty ? "busy" : "empty");
+    }
+  }
+
+  /* A mobile that lost its descriptor stays listed until it next moves,
+   * which costs a look but is not wrong; a missing character is. */
+  for (ch = character_list; ch; ch = ch->next)
+    if (zone_presence_wanted(ch) && !ch->in_zone_presence)
+    {
+      problems++;
+      offset = snprintf_append(buf, len, offset, "%s is in room %d but on no presence list.\r\n",
+                               GET_NAME(ch), GET_ROOM_VNUM(IN_ROOM(ch)));
+    }
+
+  if (problems)
+  {
+    zone_presence_rebuild();
+    snprintf_append(buf, len, offset, "%d problem%s found; presence lists rebuilt.\r\n", problems,
+                    problems == 1 ? "" : "s");
+  }
+  else
+    snprintf_append(buf, len, offset, "Presence lists agree: %d characters listed.\r\n",
+                    presence_total);
+
+  return problems;
+}
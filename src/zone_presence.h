@@ -0,0 +1,48 @@
+/* *************************************************************************
+ *   File: zone_presence.h                             Part of LuminariMUD *
+ *  Usage: Per-zone lists of the characters that can make a zone "busy"   *
+ * Author: Development Team                                                *
+ ***************************************************************************
+ * Zone Presence                                                           *
+ * =============                                                           *
+ * is_empty() decides whether random triggers fire and whether a          *
+ * reset_mode 1 zone may reset.  It used to walk the whole               *
+ * descriptor_list on every call, once per random-trigger mobile and     *
+ * room, every trigger pulse.                                              *
+ *                                                                         *
+ * Every zone now keeps a list of the characters standing in it that     *
+ * could count as a player there: every PC, connected or linkless, and   *
+ * any mobile a descriptor is driving (switch, wizard eye, eidolons).    *
+ * char_to_room() and char_from_room() keep the lists current; the       *
+ * few places that hand a mobile a descriptor call                        *
+ * zone_presence_update().  Whether a listed character really counts     *
+ * (connected, playing, not a nohassle immortal) is checked when asked,  *
+ * so logins, link loss, OLC and nohassle toggles need no hooks, and a   *
+ * zone with nobody in it answers without looking at anyone.             *
+ ***************************************************************************/
+
+#ifndef ZONE_PRESENCE_H
+#define ZONE_PRESENCE_H
+
+/* When TRUE every is_empty() answer is cross-checked against the old
+ * descriptor scan.  Defaults on when built with -DZONE_PRESENCE_VALIDATE. */
+extern bool zone_presence_validate;
+
+/* Put ch on, or take it off, its zone's list as its room and descriptor
+ * now warrant.  Safe to call at any time. */
+void zone_presence_update(struct char_data *ch);
+/* Take ch off its zone's list; call before IN_ROOM(ch) changes. */
+void zone_presence_leave(struct char_data *ch);
+
+/* Whether ch, on its zone's list, keeps the zone from being empty. */
+bool zone_presence_counts(struct char_data *ch);
+/* The body of is_empty(). */
+int zone_presence_is_empty(zone_rnum zone);
+/* Whether anyone connected is playing in the zone, nohassle or not. */
+bool zone_presence_occupied(zone_rnum zone);
+
+/* Check every list against the character list, print what disagrees into
+ * buf and rebuild the lists if anything did.  Returns the problems found. */
+int zone_presence_audit(char *buf, size_t len);
+
+#endif /* ZONE_PRESENCE_H */
@@ -1,9 +1,18 @@
 #include "CuTest.h"
 
 #include "../../src/helpers.h"
+#include "test.helpers.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+bool test_benchmarks_enabled(void)
+{
+  const char *enabled = getenv("LUMINARI_TEST_BENCHMARKS");
+
+  return enabled != NULL && strcmp(enabled, "1") == 0;
+}
 
 void Test_one_argument_u(CuTest *tc)
 {
@@ -0,0 +1,12 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+
+/* Whether LUMINARI_TEST_BENCHMARKS=1 asks for the timing benchmarks, which
+ * otherwise pass without running so the suite checks only behaviour. */
+bool test_benchmarks_enabled(void);
+
+#endif
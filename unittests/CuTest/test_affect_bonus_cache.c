@@ -0,0 +1,288 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/handler.h"
+#include "../../src/perfmon.h"
+#include "test.helpers.h"
+
+#include <string.h>
+
+#define BONUS_CACHE_TEST_ITEMS 20
+#define BONUS_CACHE_BENCH_AFFECTS 40
+#define BONUS_CACHE_BENCH_ROUNDS 2000
+
+static const int bonus_cache_locations[] = {APPLY_STR,     APPLY_DEX,     APPLY_CON,
+                                            APPLY_HIT,     APPLY_HITROLL, APPLY_DAMROLL,
+                                            APPLY_AC_NEW,  APPLY_SIZE,    APPLY_SAVING_FORT,
+                                            APPLY_SAVING_WILL};
+static const int bonus_cache_types[] = {BONUS_TYPE_ENHANCEMENT, BONUS_TYPE_MORALE,
+                                        BONUS_TYPE_LUCK,        BONUS_TYPE_DODGE,
+                                        BONUS_TYPE_SACRED,      BONUS_TYPE_RESISTANCE};
+
+struct bonus_cache_fixture
+{
+  struct room_data room;
+  struct char_data ch;
+  struct player_special_data player_specials;
+  struct obj_data items[BONUS_CACHE_TEST_ITEMS];
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  unsigned int seed;
+};
+
+static int bonus_cache_next(struct bonus_cache_fixture *fixture, int range)
+{
+  fixture->seed = fixture->seed * 1103515245U + 12345U;
+  return (int)((fixture->seed >> 8) % (unsigned int)range);
+}
+
+static void bonus_cache_random_affect(struct bonus_cache_fixture *fixture,
+                                      struct affected_type *af)
+{
+  memset(af, 0, sizeof(*af));
+  af->spell = 1 + bonus_cache_next(fixture, 50);
+  af->duration = 10;
+  af->location = bonus_cache_locations[bonus_cache_next(
+      fixture, sizeof(bonus_cache_locations) / sizeof(bonus_cache_locations[0]))];
+  /* Keep size swings small so the character stays a sane size. */
+  if (af->location == APPLY_SIZE)
+    af->modifier = bonus_cache_next(fixture, 3) - 1;
+  else
+    af->modifier = bonus_cache_next(fixture, 9) - 2;
+  af->bonus_type = bonus_cache_types[bonus_cache_next(
+      fixture, sizeof(bonus_cache_types) / sizeof(bonus_cache_types[0]))];
+}
+
+static void bonus_cache_random_item(struct bonus_cache_fixture *fixture, struct obj_data *obj,
+                                    int type)
+{
+  int j;
+
+  memset(obj, 0, sizeof(*obj));
+  obj->in_room = NOWHERE;
+  obj->item_number = NOTHING;
+  obj->worn_on = -1;
+  obj->short_description = "bonus cache test item";
+  GET_OBJ_TYPE(obj) = type;
+  GET_OBJ_SIZE(obj) = SIZE_MEDIUM;
+  for (j = 0; j < MAX_OBJ_AFFECT; j++)
+  {
+    if (bonus_cache_next(fixture, 3) == 0)
+      continue;
+    obj->affected[j].location = bonus_cache_locations[bonus_cache_next(
+        fixture, sizeof(bonus_cache_locations) / sizeof(bonus_cache_locations[0]))];
+    if (obj->affected[j].location == APPLY_SIZE)
+      obj->affected[j].location = APPLY_STR;
+    obj->affected[j].modifier = bonus_cache_next(fixture, 8) - 1;
+    obj->affected[j].bonus_type = bonus_cache_types[bonus_cache_next(
+        fixture, sizeof(bonus_cache_types) / sizeof(bonus_cache_types[0]))];
+  }
+}
+
+static void begin_bonus_cache_fixture(struct bonus_cache_fixture *fixture)
+{
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->seed = 4242U;
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  world = &fixture->room;
+  top_of_world = 0;
+
+  clear_char(&fixture->ch);
+  fixture->ch.player_specials = &fixture->player_specials;
+  fixture->ch.player.name = "bonus cache test character";
+  IN_ROOM(&fixture->ch) = 0;
+  GET_LEVEL(&fixture->ch) = 10;
+  GET_REAL_SIZE(&fixture->ch) = SIZE_MEDIUM;
+  fixture->ch.points.size = SIZE_MEDIUM;
+  fixture->ch.real_abils.str = fixture->ch.real_abils.dex = fixture->ch.real_abils.con = 14;
+  fixture->ch.aff_abils = fixture->ch.real_abils;
+  GET_POS(&fixture->ch) = POS_STANDING;
+  fixture->room.people = &fixture->ch;
+}
+
+static void end_bonus_cache_fixture(struct bonus_cache_fixture *fixture)
+{
+  int i;
+
+  for (i = 0; i < NUM_WEARS; i++)
+    if (GET_EQ(&fixture->ch, i))
+      unequip_char(&fixture->ch, i);
+  while (fixture->ch.affected != NULL)
+    affect_remove_no_total(&fixture->ch, fixture->ch.affected);
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+}
+
+/* The old affect_total() inner loop, kept here as the benchmark baseline. */
+static int bonus_cache_full_recompute(struct char_data *ch)
+{
+  int loc, type, sum = 0;
+
+  for (loc = 0; loc < NUM_APPLIES; loc++)
+    for (type = 0; type < NUM_BONUS_TYPES; type++)
+      sum += calculate_best_mod(ch, loc, type, -1, -1);
+  return sum;
+}
+
+void Test_affect_bonus_cache_matches_full_recompute_through_affect_and_gear_churn(CuTest *tc)
+{
+  static const int slots[] = {WEAR_FINGER_R, WEAR_NECK_1, WEAR_BODY, WEAR_HEAD,
+                              WEAR_LEGS,     WEAR_FEET,   WEAR_HANDS, WEAR_ARMS};
+  struct bonus_cache_fixture fixture;
+  struct affected_type af;
+  struct char_data *ch;
+  int step, slot, nslots = sizeof(slots) / sizeof(slots[0]);
+
+  begin_bonus_cache_fixture(&fixture);
+  ch = &fixture.ch;
+
+  for (step = 0; step < 300; step++)
+  {
+    switch (bonus_cache_next(&fixture, 4))
+    {
+    case 0:
+    case 1:
+      bonus_cache_random_affect(&fixture, &af);
+      affect_to_char(ch, &af);
+      break;
+    case 2:
+      if (ch->affected)
+        affect_remove(ch, ch->affected->next ? ch->affected->next : ch->affected);
+      break;
+    default:
+      slot = bonus_cache_next(&fixture, nslots);
+      if (GET_EQ(ch, slots[slot]))
+        unequip_char(ch, slots[slot]);
+      else
+      {
+        bonus_cache_random_item(&fixture, &fixture.items[slot], ITEM_WORN);
+        equip_char(ch, &fixture.items[slot], slots[slot]);
+      }
+      break;
+    }
+    CuAssertIntEquals(tc, 0, affect_bonus_cache_verify(ch));
+  }
+
+  end_bonus_cache_fixture(&fixture);
+}
+
+void Test_affect_bonus_cache_tracks_two_handed_weapon_doubling(CuTest *tc)
+{
+  struct bonus_cache_fixture fixture;
+  struct obj_data *sword, *shield;
+  struct char_data *ch;
+  int one_handed, two_handed;
+
+  begin_bonus_cache_fixture(&fixture);
+  ch = &fixture.ch;
+  sword = &fixture.items[0];
+  shield = &fixture.items[1];
+  bonus_cache_random_item(&fixture, sword, ITEM_WEAPON);
+  memset(sword->affected, 0, sizeof(sword->affected));
+  sword->affected[0].location = APPLY_DAMROLL;
+  sword->affected[0].modifier = 3;
+  sword->affected[0].bonus_type = BONUS_TYPE_ENHANCEMENT;
+  bonus_cache_random_item(&fixture, shield, ITEM_ARMOR);
+  memset(shield->affected, 0, sizeof(shield->affected));
+
+  equip_char(ch, sword, WEAR_WIELD_1);
+  two_handed = affect_bonus_total(ch, APPLY_DAMROLL);
+  CuAssertIntEquals(tc, 6, two_handed);
+
+  /* Equipping a shield never touches damroll affects, but it does stop the
+   * sword counting double. */
+  equip_char(ch, shield, WEAR_SHIELD);
+  one_handed = affect_bonus_total(ch, APPLY_DAMROLL);
+  CuAssertIntEquals(tc, 3, one_handed);
+  CuAssertIntEquals(tc, 0, affect_bonus_cache_verify(ch));
+
+  unequip_char(ch, WEAR_SHIELD);
+  CuAssertIntEquals(tc, 6, affect_bonus_total(ch, APPLY_DAMROLL));
+
+  end_bonus_cache_fixture(&fixture);
+}
+
+void Test_affect_bonus_cache_catches_in_place_edits_and_corruption(CuTest *tc)
+{
+  struct bonus_cache_fixture fixture;
+  struct affected_type af;
+  struct char_data *ch;
+
+  begin_bonus_cache_fixture(&fixture);
+  ch = &fixture.ch;
+
+  memset(&af, 0, sizeof(af));
+  af.spell = 1;
+  af.duration = 10;
+  af.location = APPLY_HITROLL;
+  af.modifier = 2;
+  af.bonus_type = BONUS_TYPE_MORALE;
+  affect_to_char(ch, &af);
+  CuAssertIntEquals(tc, 2, affect_bonus_total(ch, APPLY_HITROLL));
+
+  /* Callers such as change_spell_mod() edit modifiers without telling us. */
+  ch->affected->modifier = 5;
+  affect_bonus_cache_sync(ch);
+  CuAssertIntEquals(tc, 5, affect_bonus_total(ch, APPLY_HITROLL));
+
+  /* Validation mode reports and repairs a cache that went wrong anyway. */
+  ch->char_specials.bonus_cache.total[APPLY_HITROLL] += 7;
+  CuAssertIntEquals(tc, 1, affect_bonus_cache_verify(ch));
+  CuAssertIntEquals(tc, 5, affect_bonus_total(ch, APPLY_HITROLL));
+
+  end_bonus_cache_fixture(&fixture);
+}
+
+void Test_affect_bonus_cache_benchmark_affect_total(CuTest *tc)
+{
+  static const int slots[] = {WEAR_FINGER_R, WEAR_NECK_1, WEAR_BODY, WEAR_HEAD,  WEAR_LEGS,
+                              WEAR_FEET,     WEAR_HANDS,  WEAR_ARMS, WEAR_ABOUT, WEAR_WAIST};
+  struct bonus_cache_fixture fixture;
+  struct affected_type af;
+  struct char_data *ch;
+  uint64_t start_usec, cached_usec, full_usec;
+  int i, checksum = 0;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  begin_bonus_cache_fixture(&fixture);
+  ch = &fixture.ch;
+  for (i = 0; i < (int)(sizeof(slots) / sizeof(slots[0])); i++)
+  {
+    bonus_cache_random_item(&fixture, &fixture.items[i], ITEM_WORN);
+    equip_char(ch, &fixture.items[i], slots[i]);
+  }
+  for (i = 0; i < BONUS_CACHE_BENCH_AFFECTS; i++)
+  {
+    bonus_cache_random_affect(&fixture, &af);
+    affect_to_char(ch, &af);
+  }
+
+  start_usec = PERF_monotonic_usec();
+  for (i = 0; i < BONUS_CACHE_BENCH_ROUNDS; i++)
+    affect_total(ch);
+  cached_usec = PERF_monotonic_usec() - start_usec;
+
+  start_usec = PERF_monotonic_usec();
+  for (i = 0; i < BONUS_CACHE_BENCH_ROUNDS; i++)
+    checksum += bonus_cache_full_recompute(ch);
+  full_usec = PERF_monotonic_usec() - start_usec;
+
+  CuAssertIntEquals(tc, 0, affect_bonus_cache_verify(ch));
+  log("BENCHMARK: %d affect_total() calls took %llu usec with the bonus cache; the old "
+      "calculate_best_mod() loop alone took %llu usec (checksum %d).",
+      BONUS_CACHE_BENCH_ROUNDS, (unsigned long long)cached_usec, (unsigned long long)full_usec,
+      checksum);
+
+  end_bonus_cache_fixture(&fixture);
+}
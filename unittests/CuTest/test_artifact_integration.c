@@ -104,10 +104,7 @@ static int artint_rnum_of(int vnum)
 
 static void artint_clear_output(struct artint_fixture *fixture)
 {
-  fixture->descriptor.small_outbuf[0] = '\0';
-  fixture->descriptor.output = fixture->descriptor.small_outbuf;
-  fixture->descriptor.bufptr = 0;
-  fixture->descriptor.bufspace = SMALL_BUFSIZE - 1;
+  comm_test_clear_output(&fixture->descriptor);
 }
 
 static int artint_said(struct artint_fixture *fixture, const char *needle)
@@ -284,15 +281,7 @@ static void artint_end(struct artint_fixture *fixture)
     ProtocolDestroy(fixture->descriptor.pProtocol);
     fixture->descriptor.pProtocol = NULL;
   }
-  if (fixture->descriptor.large_outbuf)
-  {
-    free(fixture->descriptor.large_outbuf->text);
-    free(fixture->descriptor.large_outbuf);
-    fixture->descriptor.large_outbuf = NULL;
-    fixture->descriptor.output = fixture->descriptor.small_outbuf;
-    if (buf_largecount > 0)
-      buf_largecount--;
-  }
+  artint_clear_output(fixture);
 
   fixture->rooms[0].people = NULL;
   fixture->rooms[1].people = NULL;
@@ -0,0 +1,173 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/interpreter.h"
+
+#include <string.h>
+
+void create_command_list(void);
+void free_command_list(void);
+
+
+/* Socials chosen to share prefixes with commands ("lo", "s"), with level
+ * gates of their own. */
+static const struct
+{
+  const char *command;
+  int min_level;
+} test_socials[] = {
+    {"laugh", 0}, {"lounge", 0}, {"loom", LVL_IMMORT}, {"sashay", 0}, {"smile", 0},
+    {"smirk", 5}, {"zzzap", LVL_IMPL},
+};
+#define NUM_TEST_SOCIALS ((int)(sizeof(test_socials) / sizeof(test_socials[0])))
+
+static const int test_levels[] = {0,  1,          5,         10,          20,
+                                  30, LVL_IMMORT, LVL_STAFF, LVL_GRSTAFF, LVL_IMPL};
+#define NUM_TEST_LEVELS ((int)(sizeof(test_levels) / sizeof(test_levels[0])))
+
+struct command_index_fixture
+{
+  struct social_messg socials[NUM_TEST_SOCIALS];
+  struct social_messg *saved_soc_mess_list;
+  int saved_top_of_socialt;
+  bool had_command_list;
+};
+
+static void begin_command_index_fixture(struct command_index_fixture *fixture)
+{
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_soc_mess_list = soc_mess_list;
+  fixture->saved_top_of_socialt = top_of_socialt;
+  fixture->had_command_list = complete_cmd_info != NULL;
+
+  for (i = 0; i < NUM_TEST_SOCIALS; i++)
+  {
+    fixture->socials[i].command = (char *)test_socials[i].command;
+    fixture->socials[i].sort_as = (char *)test_socials[i].command;
+    fixture->socials[i].min_level_char = test_socials[i].min_level;
+    fixture->socials[i].min_char_position = POS_RESTING;
+  }
+  soc_mess_list = fixture->socials;
+  top_of_socialt = NUM_TEST_SOCIALS - 1;
+  create_command_list();
+}
+
+static void end_command_index_fixture(struct command_index_fixture *fixture)
+{
+  soc_mess_list = fixture->saved_soc_mess_list;
+  top_of_socialt = fixture->saved_top_of_socialt;
+  if (fixture->had_command_list)
+    create_command_list();
+  else
+    free_command_list();
+}
+
+/* Every abbreviation of every command and social, at every level, as the
+ * old scans would resolve it; returns how many disagree. */
+static int count_lookup_mismatches(CuTest *tc)
+{
+  char abbrev[MAX_INPUT_LENGTH];
+  size_t length, full;
+  int cmd, level, mismatches = 0;
+
+  for (cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
+  {
+    full = strlen(complete_cmd_info[cmd].command);
+    for (length = 0; length <= full && length < sizeof(abbrev); length++)
+    {
+      memcpy(abbrev, complete_cmd_info[cmd].command, length);
+      abbrev[length] = '\0';
+      for (level = 0; level < NUM_TEST_LEVELS; level++)
+        if (lookup_command(abbrev, test_levels[level]) !=
+            lookup_command_scan(abbrev, test_levels[level]))
+        {
+          if (!mismatches)
+            CuFail(tc, abbrev);
+          mismatches++;
+        }
+    }
+  }
+  return mismatches;
+}
+
+void Test_command_index_matches_scan_for_every_abbreviation(CuTest *tc)
+{
+  struct command_index_fixture fixture;
+
+  begin_command_index_fixture(&fixture);
+  CuAssertIntEquals(tc, 0, count_lookup_mismatches(tc));
+  end_command_index_fixture(&fixture);
+}
+
+void Test_command_index_keeps_commands_before_socials(CuTest *tc)
+{
+  struct command_index_fixture fixture;
+  int cmd, end;
+
+  begin_command_index_fixture(&fixture);
+  for (end = 0; *complete_cmd_info[end].command != '\n'; end++)
+    ;
+
+  /* "lo" is "look" even though "lounge" sorts before it. */
+  cmd = lookup_command("lo", 1);
+  CuAssertStrEquals(tc, "look", complete_cmd_info[cmd].command);
+  cmd = lookup_command("loun", 1);
+  CuAssertStrEquals(tc, "lounge", complete_cmd_info[cmd].command);
+
+  /* Level gates apply to socials as to commands. */
+  CuAssertIntEquals(tc, end, lookup_command("zzz", LVL_IMMORT));
+  cmd = lookup_command("zzz", LVL_IMPL);
+  CuAssertStrEquals(tc, "zzzap", complete_cmd_info[cmd].command);
+  CuAssertIntEquals(tc, end, lookup_command("no-such-command", LVL_IMPL));
+  CuAssertIntEquals(tc, end, lookup_command("lookx", LVL_IMPL));
+
+  end_command_index_fixture(&fixture);
+}
+
+void Test_command_index_follows_level_changes(CuTest *tc)
+{
+  struct command_index_fixture fixture;
+  int cmd;
+
+  begin_command_index_fixture(&fixture);
+
+  /* What do_cmdlev does: put "look" out of mortal reach. */
+  cmd = find_command("look");
+  CuAssertTrue(tc, cmd >= 0);
+  complete_cmd_info[cmd].minimum_level = LVL_IMPL;
+  command_index_changed();
+
+  CuAssertTrue(tc, lookup_command("look", 1) != cmd);
+  CuAssertIntEquals(tc, cmd, lookup_command("look", LVL_IMPL));
+  CuAssertIntEquals(tc, 0, count_lookup_mismatches(tc));
+
+  end_command_index_fixture(&fixture);
+}
+
+void Test_command_index_find_command_matches_exact_scan(CuTest *tc)
+{
+  struct command_index_fixture fixture;
+  int cmd, scanned, found;
+
+  begin_command_index_fixture(&fixture);
+
+  for (cmd = 0; *complete_cmd_info[cmd].command != '\n'; cmd++)
+  {
+    found = find_command(complete_cmd_info[cmd].command);
+    for (scanned = 0; strcmp(complete_cmd_info[scanned].command, complete_cmd_info[cmd].command);
+         scanned++)
+      ;
+    CuAssertIntEquals(tc, scanned, found);
+  }
+  CuAssertIntEquals(tc, -1, find_command("lookx"));
+  CuAssertIntEquals(tc, -1, find_command("loo"));
+
+  end_command_index_fixture(&fixture);
+}
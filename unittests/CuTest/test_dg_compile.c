@@ -0,0 +1,457 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/net/protocol.h"
+#include "../../src/dgscript/dg_scripts.h"
+#include "../../src/dgscript/dg_event.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DG_COMPILE_TRANSCRIPT 16384
+#define DG_COMPILE_MAX_WAIT_PULSES 400
+
+/* Scripts that lean on every block keyword, including the broken shapes
+ * the block scans have to cope with. */
+static const char *const dg_compile_scripts[] = {
+    /* if / elseif / else, nested, inside a while */
+    "set n 0\n"
+    "while %n% < 6\n"
+    "  if %n% == 0\n"
+    "    %echo% zero\n"
+    "  elseif %n% == 1\n"
+    "    %echo% one\n"
+    "    if %n% > 0\n"
+    "      %echo% inner\n"
+    "    else\n"
+    "      %echo% never\n"
+    "    end\n"
+    "  elseif %n% < 4\n"
+    "    %echo% small %n%\n"
+    "  else\n"
+    "    %echo% big %n%\n"
+    "  end\n"
+    "  eval n %n% + 1\n"
+    "done\n"
+    "global n\n",
+
+    /* switch with fall-through cases, default, break and a nested while */
+    "set i 0\n"
+    "while %i% < 5\n"
+    "  switch %i%\n"
+    "    case 0\n"
+    "      %echo% case zero\n"
+    "      break\n"
+    "    case 1\n"
+    "    case 2\n"
+    "      %echo% one or two %i%\n"
+    "      set j 0\n"
+    "      while %j% < 2\n"
+    "        eval j %j% + 1\n"
+    "      done\n"
+    "      break\n"
+    "    default\n"
+    "      %echo% default %i%\n"
+    "      break\n"
+    "  done\n"
+    "  eval i %i% + 1\n"
+    "done\n"
+    "global i\n",
+
+    /* stray else/end/done and an if with no end */
+    "else\n"
+    "end\n"
+    "done\n"
+    "%echo% after strays\n"
+    "if 1\n"
+    "  %echo% unterminated\n",
+
+    "if 0\n"
+    "  %echo% no\n"
+    "elseif 1\n"
+    "  %echo% yes\n"
+    "  if 1\n"
+    "    %echo% nested without end\n",
+
+    /* waits, resumed by the event queue, with context globals */
+    "context 7\n"
+    "set count 1\n"
+    "global count\n"
+    "%echo% before wait\n"
+    "wait 2\n"
+    "eval count %count% + 1\n"
+    "global count\n"
+    "%echo% after wait %count%\n"
+    "wait 1\n"
+    "%echo% done waiting\n",
+
+    /* a loop long enough to be paused every 30 passes */
+    "set k 0\n"
+    "while %k% < 45\n"
+    "  eval k %k% + 1\n"
+    "done\n"
+    "global k\n"
+    "%echo% looped %k%\n",
+
+    /* keywords are matched without regard to case or indentation */
+    "   IF 1\n"
+    "  %echo% upper\n"
+    "ELSE\n"
+    "  %echo% not upper\n"
+    "     End\n"
+    "Switch 3\n"
+    "  Case 3\n"
+    "    %echo% case three\n"
+    "  Done\n"
+    "if %actor.name% == listener\n"
+    "  return 0\n"
+    "  halt\n"
+    "end\n"
+    "%echo% not reached\n",
+
+    /* conditions and substitutions: operators, nested parentheses, %%,
+     * fields with arguments and fields of fields; the tail line's lookup may
+     * write over its own text, so it is left to be read as text */
+    "set s hello big world\n"
+    "set n 7\n"
+    "if ((%n% > 3) && !(%n% == 4)) || %s% /= xyz\n"
+    "  %echo% paren %n% 100%% %s.strlen% %s.car% %s.cdr%\n"
+    "end\n"
+    "eval m (%n% * 3 - 1) / 2 + %s.strlen%\n"
+    "if %m% != 25 || %s.contains(big)% <= 0\n"
+    "  %echo% math wrong %m%\n"
+    "elseif %s.cdr.strlen% >= 9\n"
+    "  %echo% math %m% %s.cdr.car.toupper%\n"
+    "end\n"
+    "while %n% >= 5 && %n% != 0\n"
+    "  eval n %n% - 1\n"
+    "done\n"
+    "switch %s.car%\n"
+    "  case hello\n"
+    "    %echo% switched %n%\n"
+    "    break\n"
+    "done\n"
+    "%echo% tail %s.x.strlen% 50%% %\n"
+    "global m\n",
+};
+#define NUM_DG_COMPILE_SCRIPTS ((int)(sizeof(dg_compile_scripts) / sizeof(dg_compile_scripts[0])))
+
+struct dg_compile_fixture
+{
+  struct room_data rooms[1];
+  struct zone_data zones[1];
+  struct char_data listener;
+  struct player_special_data listener_specials;
+  struct descriptor_data desc;
+  char output[LARGE_BUFSIZE];
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  struct zone_data *saved_zone_table;
+  zone_rnum saved_top_of_zone_table;
+  struct index_data **saved_trig_index;
+  int saved_top_of_trigt;
+  struct trig_data *saved_trigger_list;
+  unsigned long saved_pulse;
+  bool saved_from_text;
+};
+
+/* One room holding a player with a descriptor to catch what the scripts
+ * say, and an empty trigger table for the scripts to be parsed into. */
+static void begin_dg_compile_fixture(struct dg_compile_fixture *fixture)
+{
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  fixture->saved_zone_table = zone_table;
+  fixture->saved_top_of_zone_table = top_of_zone_table;
+  fixture->saved_trig_index = trig_index;
+  fixture->saved_top_of_trigt = top_of_trigt;
+  fixture->saved_trigger_list = trigger_list;
+  fixture->saved_pulse = pulse;
+  fixture->saved_from_text = dg_scripts_from_text;
+
+  fixture->rooms[0].number = 100;
+  fixture->rooms[0].zone = 0;
+  fixture->rooms[0].name = "Trigger compiler test room";
+  fixture->zones[0].number = 0;
+  fixture->zones[0].bot = 100;
+  fixture->zones[0].top = 100;
+  world = fixture->rooms;
+  top_of_world = 0;
+  zone_table = fixture->zones;
+  top_of_zone_table = 0;
+
+  fixture->listener.player_specials = &fixture->listener_specials;
+  fixture->listener.player.name = "listener";
+  GET_LEVEL(&fixture->listener) = 10;
+  GET_POS(&fixture->listener) = POS_STANDING;
+  IN_ROOM(&fixture->listener) = 0;
+  fixture->listener.desc = &fixture->desc;
+  fixture->rooms[0].people = &fixture->listener;
+  fixture->desc.character = &fixture->listener;
+  fixture->desc.output = fixture->output;
+  fixture->desc.bufspace = LARGE_BUFSIZE - 1;
+  fixture->desc.pProtocol = ProtocolCreate();
+  STATE(&fixture->desc) = CON_PLAYING;
+
+  trig_index = NULL;
+  top_of_trigt = 0;
+  trigger_list = NULL;
+  pulse = 1000;
+  event_free_all();
+  event_init();
+}
+
+static void free_dg_compile_triggers(void)
+{
+  struct cmdlist_element *cmd, *next_cmd;
+  struct trig_data *proto;
+  int i;
+
+  for (i = 0; i < top_of_trigt; i++)
+  {
+    proto = (struct trig_data *)trig_index[i]->proto;
+    for (cmd = proto->cmdlist; cmd; cmd = next_cmd)
+    {
+      next_cmd = cmd->next;
+      free(cmd->cmd);
+      free(cmd->tokens);
+      free(cmd);
+    }
+    free_trigger(proto);
+    free(trig_index[i]);
+  }
+  free(trig_index);
+  trig_index = NULL;
+  top_of_trigt = 0;
+}
+
+static void end_dg_compile_fixture(struct dg_compile_fixture *fixture)
+{
+  free_dg_compile_triggers();
+  if (GET_ID(&fixture->listener) != 0)
+    remove_from_lookup_table(GET_ID(&fixture->listener));
+  if (SCRIPT(&fixture->listener))
+    extract_script(&SCRIPT(&fixture->listener));
+  ProtocolDestroy(fixture->desc.pProtocol);
+  event_free_all();
+  event_init();
+
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  zone_table = fixture->saved_zone_table;
+  top_of_zone_table = fixture->saved_top_of_zone_table;
+  trig_index = fixture->saved_trig_index;
+  top_of_trigt = fixture->saved_top_of_trigt;
+  trigger_list = fixture->saved_trigger_list;
+  pulse = fixture->saved_pulse;
+  dg_scripts_from_text = fixture->saved_from_text;
+}
+
+/* Parse every trigger in fp into trig_index. */
+static int load_dg_compile_triggers(FILE *fp)
+{
+  char line[256];
+  int vnum, loaded = 0;
+
+  while (fgets(line, sizeof(line), fp))
+  {
+    if (*line == '$')
+      break;
+    if (sscanf(line, "#%d", &vnum) != 1)
+      continue;
+    RECREATE(trig_index, struct index_data *, top_of_trigt + 1);
+    parse_trigger(fp, vnum);
+    loaded++;
+  }
+  return loaded;
+}
+
+static void add_dg_compile_script(const char *script, int vnum)
+{
+  FILE *fp = tmpfile();
+
+  if (fp == NULL)
+    return;
+  fprintf(fp, "#%d\nCompiler test %d~\n2 c 100\nprobe~\n%s~\n$~\n", vnum, vnum, script);
+  rewind(fp);
+  load_dg_compile_triggers(fp);
+  fclose(fp);
+}
+
+/* Every .trg file one directory down from lib/world. */
+static int load_dg_compile_corpus(void)
+{
+  char world_dir[PATH_MAX], path[PATH_MAX * 2 + 256];
+  const char *root = getenv("LUMINARI_TEST_ROOT");
+  struct dirent *zone_entry, *file_entry;
+  DIR *world_listing, *zone_listing;
+  FILE *fp;
+  size_t length;
+  int loaded = 0;
+
+  snprintf(world_dir, sizeof(world_dir), "%s/lib/world", root && *root ? root : ".");
+  if ((world_listing = opendir(world_dir)) == NULL)
+    return 0;
+
+  while ((zone_entry = readdir(world_listing)) != NULL)
+  {
+    if (*zone_entry->d_name == '.')
+      continue;
+    snprintf(path, sizeof(path), "%s/%s", world_dir, zone_entry->d_name);
+    if ((zone_listing = opendir(path)) == NULL)
+      continue;
+    while ((file_entry = readdir(zone_listing)) != NULL)
+    {
+      length = strlen(file_entry->d_name);
+      if (length < 5 || strcmp(file_entry->d_name + length - 4, ".trg"))
+        continue;
+      snprintf(path, sizeof(path), "%s/%s/%s", world_dir, zone_entry->d_name,
+               file_entry->d_name);
+      if ((fp = fopen(path, "r")) == NULL)
+        continue;
+      loaded += load_dg_compile_triggers(fp);
+      fclose(fp);
+    }
+    closedir(zone_listing);
+  }
+  closedir(world_listing);
+  return loaded;
+}
+
+static void take_dg_compile_output(struct dg_compile_fixture *fixture, char *transcript,
+                                   size_t size)
+{
+  strlcat(transcript, fixture->desc.output, size);
+  *fixture->desc.output = '\0';
+  fixture->desc.bufptr = 0;
+  fixture->desc.bufspace = LARGE_BUFSIZE - 1;
+}
+
+/* Run trigger rnum on the test room from a clean start, waits and all, and
+ * write down everything it said, returned and left behind. */
+static void run_dg_compile_trigger(struct dg_compile_fixture *fixture, int rnum, bool from_text,
+                                   char *transcript, size_t size)
+{
+  struct room_data *room = &fixture->rooms[0];
+  struct trig_var_data *var;
+  struct trig_data *trig;
+  char buf[MAX_INPUT_LENGTH];
+  int result, waited = 0;
+
+  *transcript = '\0';
+  dg_scripts_from_text = from_text;
+  if (SCRIPT(&fixture->listener))
+    extract_script(&SCRIPT(&fixture->listener));
+
+  CREATE(room->script, struct script_data, 1);
+  trig = read_trigger(rnum);
+  add_trigger(room->script, trig, -1);
+  ADD_UID_VAR(buf, trig, &fixture->listener, "actor", 0);
+
+  {
+    struct script_call_args args = {&room, trig, WLD_TRIGGER, TRIG_NEW};
+    result = script_driver(&args);
+  }
+  take_dg_compile_output(fixture, transcript, size);
+
+  while (GET_TRIG_WAIT(trig) && waited++ < DG_COMPILE_MAX_WAIT_PULSES)
+  {
+    pulse++;
+    event_process();
+    take_dg_compile_output(fixture, transcript, size);
+  }
+
+  snprintf(buf, sizeof(buf), "[returned %d, waited %d]\n", result, waited);
+  strlcat(transcript, buf, size);
+  for (var = room->script->global_vars; var; var = var->next)
+  {
+    snprintf(buf, sizeof(buf), "[global %s(%ld) = %s]\n", var->name, var->context, var->value);
+    strlcat(transcript, buf, size);
+  }
+  if (SCRIPT(&fixture->listener))
+    for (var = SCRIPT(&fixture->listener)->global_vars; var; var = var->next)
+    {
+      snprintf(buf, sizeof(buf), "[actor %s = %s]\n", var->name, var->value);
+      strlcat(transcript, buf, size);
+    }
+
+  extract_script(&room->script);
+}
+
+/* Every loaded trigger, once from its text and once compiled. */
+static int count_dg_compile_differences(CuTest *tc, struct dg_compile_fixture *fixture)
+{
+  static char from_text[DG_COMPILE_TRANSCRIPT], compiled[DG_COMPILE_TRANSCRIPT];
+  int rnum, differences = 0;
+
+  for (rnum = 0; rnum < top_of_trigt; rnum++)
+  {
+    run_dg_compile_trigger(fixture, rnum, TRUE, from_text, sizeof(from_text));
+    run_dg_compile_trigger(fixture, rnum, FALSE, compiled, sizeof(compiled));
+    if (strcmp(from_text, compiled))
+    {
+      if (!differences)
+        CuAssertStrEquals(tc, from_text, compiled);
+      differences++;
+    }
+  }
+  return differences;
+}
+
+void Test_dg_compile_runs_world_triggers_as_their_text_does(CuTest *tc)
+{
+  struct dg_compile_fixture fixture;
+
+  begin_dg_compile_fixture(&fixture);
+  CuAssertTrue(tc, load_dg_compile_corpus() > 0);
+  CuAssertIntEquals(tc, 0, count_dg_compile_differences(tc, &fixture));
+  end_dg_compile_fixture(&fixture);
+}
+
+void Test_dg_compile_runs_block_keywords_as_their_text_does(CuTest *tc)
+{
+  struct dg_compile_fixture fixture;
+  static char transcript[DG_COMPILE_TRANSCRIPT];
+  struct cmdlist_element *cmd;
+  int i;
+
+  begin_dg_compile_fixture(&fixture);
+  for (i = 0; i < NUM_DG_COMPILE_SCRIPTS; i++)
+    add_dg_compile_script(dg_compile_scripts[i], 90000 + i);
+  CuAssertIntEquals(tc, NUM_DG_COMPILE_SCRIPTS, top_of_trigt);
+  CuAssertIntEquals(tc, 0, count_dg_compile_differences(tc, &fixture));
+
+  /* And they did what they say, not merely the same wrong thing twice.
+   * (The room echo capitalises each line.) */
+  run_dg_compile_trigger(&fixture, 0, FALSE, transcript, sizeof(transcript));
+  CuAssertTrue(tc, strstr(transcript, "Inner") && !strstr(transcript, "Never"));
+  CuAssertTrue(tc, strstr(transcript, "Small 3") && strstr(transcript, "Big 5"));
+  run_dg_compile_trigger(&fixture, 1, FALSE, transcript, sizeof(transcript));
+  CuAssertTrue(tc, strstr(transcript, "One or two 2") && strstr(transcript, "Default 4"));
+  run_dg_compile_trigger(&fixture, 4, FALSE, transcript, sizeof(transcript));
+  CuAssertTrue(tc, strstr(transcript, "After wait 2") && strstr(transcript, "Done waiting"));
+  run_dg_compile_trigger(&fixture, 5, FALSE, transcript, sizeof(transcript));
+  CuAssertTrue(tc, strstr(transcript, "Looped 45") != NULL);
+  run_dg_compile_trigger(&fixture, 6, FALSE, transcript, sizeof(transcript));
+  CuAssertTrue(tc, strstr(transcript, "Case three") && strstr(transcript, "[returned 0"));
+  CuAssertTrue(tc, !strstr(transcript, "Not reached") && !strstr(transcript, "Not upper"));
+  run_dg_compile_trigger(&fixture, 7, FALSE, transcript, sizeof(transcript));
+  CuAssertTrue(tc, strstr(transcript, "Paren 7 100% 15 hello big world") != NULL);
+  CuAssertTrue(tc, strstr(transcript, "Math 25 Big") && !strstr(transcript, "Math wrong"));
+  CuAssertTrue(tc, strstr(transcript, "Switched 4") && strstr(transcript, "[global m(0) = 25]"));
+  for (cmd = ((struct trig_data *)trig_index[7]->proto)->cmdlist; cmd; cmd = cmd->next)
+    if (!strn_cmp(cmd->body, "if ((", 5) || !strn_cmp(cmd->body, "switch", 6))
+      CuAssertTrue(tc, cmd->tokens != NULL);
+    else if (!strn_cmp(cmd->body, "%echo% tail", 11))
+      CuAssertTrue(tc, cmd->tokens == NULL);
+
+  end_dg_compile_fixture(&fixture);
+}
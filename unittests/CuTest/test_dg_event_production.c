@@ -0,0 +1,233 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/dgscript/dg_event.h"
+#include "../../src/perfmon.h"
+#include "test.helpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EVENT_WHEEL_TEST_DELAYS 12
+#define EVENT_WHEEL_BENCH_TOTAL 1000000
+#define EVENT_WHEEL_BENCH_BATCH 50000
+
+struct event_wheel_test_record
+{
+  unsigned long fired_pulse;
+  int fire_count;
+  int repeats;
+  long repeat_delay;
+};
+
+static EVENTFUNC(event_wheel_test_callback)
+{
+  struct event_wheel_test_record *record = (struct event_wheel_test_record *)event_obj;
+
+  record->fired_pulse = pulse;
+  record->fire_count++;
+  if (record->fire_count <= record->repeats)
+    return record->repeat_delay;
+  return 0;
+}
+
+static EVENTFUNC(event_wheel_bench_callback)
+{
+  return 0;
+}
+
+/* Records live on the test stack, so canceled events must not free them. */
+static void event_wheel_test_keep_record(struct event *event)
+{
+  (void)event;
+}
+
+static void event_wheel_test_fire_at(unsigned long target)
+{
+  pulse = target;
+  event_process();
+}
+
+void Test_event_wheel_fires_each_event_on_its_scheduled_pulse(CuTest *tc)
+{
+  static const long delays[EVENT_WHEEL_TEST_DELAYS] = {
+      1, 2, 255, 256, 257, 511, 65535, 65536, 65537, 300000, (1L << 24) + 3, (1L << 26) + 77};
+  struct event_wheel_test_record records[EVENT_WHEEL_TEST_DELAYS];
+  unsigned long saved_pulse;
+  unsigned long start;
+  int i, j;
+
+  saved_pulse = pulse;
+  pulse = 1000;
+  start = pulse;
+  event_free_all();
+  event_init();
+  memset(records, 0, sizeof(records));
+
+  for (i = 0; i < EVENT_WHEEL_TEST_DELAYS; i++)
+    CuAssertPtrNotNull(tc, event_create_with_cleanup(event_wheel_test_callback, &records[i],
+                                                     delays[i], event_wheel_test_keep_record));
+  CuAssertIntEquals(tc, EVENT_WHEEL_TEST_DELAYS, event_queue_depth());
+
+  /* Stop one pulse short of each deadline, then on it, so cascades across
+   * every wheel level are exercised without ticking millions of pulses. */
+  for (i = 0; i < EVENT_WHEEL_TEST_DELAYS; i++)
+  {
+    event_wheel_test_fire_at(start + (unsigned long)delays[i] - 1);
+    CuAssertIntEquals(tc, 0, records[i].fire_count);
+
+    event_wheel_test_fire_at(start + (unsigned long)delays[i]);
+    CuAssertIntEquals(tc, 1, records[i].fire_count);
+    CuAssertTrue(tc, records[i].fired_pulse == start + (unsigned long)delays[i]);
+    for (j = i + 1; j < EVENT_WHEEL_TEST_DELAYS; j++)
+      CuAssertIntEquals(tc, 0, records[j].fire_count);
+  }
+  CuAssertIntEquals(tc, 0, event_queue_depth());
+
+  event_free_all();
+  pulse = saved_pulse;
+}
+
+void Test_event_wheel_requeues_repeating_events(CuTest *tc)
+{
+  struct event_wheel_test_record record;
+  unsigned long saved_pulse;
+  unsigned long start;
+  int i;
+
+  saved_pulse = pulse;
+  pulse = 250;
+  start = pulse;
+  event_free_all();
+  event_init();
+  memset(&record, 0, sizeof(record));
+  record.repeats = 3;
+  record.repeat_delay = 300;
+
+  CuAssertPtrNotNull(tc, event_create_with_cleanup(event_wheel_test_callback, &record, 10,
+                                                   event_wheel_test_keep_record));
+
+  for (i = 0; i < 10 + 3 * 300; i++)
+  {
+    pulse++;
+    event_process();
+  }
+
+  CuAssertIntEquals(tc, 4, record.fire_count);
+  CuAssertTrue(tc, record.fired_pulse == start + 10 + 3 * 300);
+  CuAssertIntEquals(tc, 0, event_queue_depth());
+
+  event_free_all();
+  pulse = saved_pulse;
+}
+
+void Test_event_wheel_cancel_and_event_time_track_the_slot(CuTest *tc)
+{
+  struct event_wheel_test_record first, second;
+  struct event *early, *late;
+  unsigned long saved_pulse;
+
+  saved_pulse = pulse;
+  pulse = 5000;
+  event_free_all();
+  event_init();
+  memset(&first, 0, sizeof(first));
+  memset(&second, 0, sizeof(second));
+
+  early = event_create_with_cleanup(event_wheel_test_callback, &first, 40,
+                                    event_wheel_test_keep_record);
+  late = event_create_with_cleanup(event_wheel_test_callback, &second, 70000,
+                                   event_wheel_test_keep_record);
+  CuAssertPtrNotNull(tc, early);
+  CuAssertPtrNotNull(tc, late);
+  CuAssertTrue(tc, event_is_queued(early));
+  CuAssertIntEquals(tc, 40, (int)event_time(early));
+  CuAssertIntEquals(tc, 70000, (int)event_time(late));
+
+  event_wheel_test_fire_at(5000 + 1000);
+  CuAssertIntEquals(tc, 1, first.fire_count);
+  CuAssertIntEquals(tc, 69000, (int)event_time(late));
+
+  event_cancel(late);
+  CuAssertIntEquals(tc, 0, event_queue_depth());
+  event_wheel_test_fire_at(5000 + 70000);
+  CuAssertIntEquals(tc, 0, second.fire_count);
+
+  /* A pulse counter that moves backwards re-files the queue instead of
+   * firing everything at once. */
+  CuAssertPtrNotNull(tc, event_create_with_cleanup(event_wheel_test_callback, &second, 20,
+                                                   event_wheel_test_keep_record));
+  event_wheel_test_fire_at(100);
+  CuAssertIntEquals(tc, 0, second.fire_count);
+  event_wheel_test_fire_at(5000 + 70000 + 20);
+  CuAssertIntEquals(tc, 1, second.fire_count);
+
+  event_free_all();
+  pulse = saved_pulse;
+}
+
+void Test_event_wheel_benchmark_schedules_and_cancels_one_million_events(CuTest *tc)
+{
+  static struct event *batch[EVENT_WHEEL_BENCH_BATCH];
+  unsigned long saved_pulse;
+  unsigned int seed = 12345U;
+  uint64_t start_usec, schedule_usec = 0, cancel_usec = 0, mark_usec;
+  long scheduled = 0, canceled = 0;
+  int i, stride;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  saved_pulse = pulse;
+  pulse = 77;
+  event_free_all();
+  event_init();
+
+  while (scheduled < EVENT_WHEEL_BENCH_TOTAL)
+  {
+    start_usec = PERF_monotonic_usec();
+    for (i = 0; i < EVENT_WHEEL_BENCH_BATCH; i++)
+    {
+      /* Delays from one pulse out to about a day, spread across every level. */
+      seed = seed * 1103515245U + 12345U;
+      batch[i] = event_create(event_wheel_bench_callback, NULL, 1 + (long)((seed >> 8) % 864000U));
+      if (!batch[i])
+        break;
+    }
+    mark_usec = PERF_monotonic_usec();
+    schedule_usec += mark_usec - start_usec;
+    CuAssertIntEquals(tc, EVENT_WHEEL_BENCH_BATCH, i);
+    scheduled += EVENT_WHEEL_BENCH_BATCH;
+
+    /* Cancel in a strided order so removal never just pops a list head. */
+    stride = 7919;
+    for (i = 0; i < EVENT_WHEEL_BENCH_BATCH; i++)
+    {
+      event_cancel(batch[((long)i * stride) % EVENT_WHEEL_BENCH_BATCH]);
+      canceled++;
+    }
+    cancel_usec += PERF_monotonic_usec() - mark_usec;
+    CuAssertIntEquals(tc, 0, event_queue_depth());
+
+    pulse += 97;
+    event_process();
+  }
+
+  CuAssertTrue(tc, scheduled == EVENT_WHEEL_BENCH_TOTAL);
+  CuAssertTrue(tc, canceled == EVENT_WHEEL_BENCH_TOTAL);
+  log("BENCHMARK: event wheel scheduled %ld events in %llu usec, canceled %ld in %llu usec "
+      "(%d live per batch).",
+      scheduled, (unsigned long long)schedule_usec, canceled, (unsigned long long)cancel_usec,
+      EVENT_WHEEL_BENCH_BATCH);
+
+  event_free_all();
+  pulse = saved_pulse;
+}
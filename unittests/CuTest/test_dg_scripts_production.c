@@ -204,3 +204,30 @@ void Test_dg_production_empty_expression_operands_are_safe(CuTest *tc)
   CuAssertTrue(tc, found_empty_left);
   free_varlist(trigger.var_list);
 }
+
+void Test_dg_production_text_fields_resolve_by_name(CuTest *tc)
+{
+  struct trig_var_data variable = {0};
+  char value[] = "  Hello world  ";
+  char words[] = "Hello world";
+  char name[] = "greeting";
+  char field_strlen[] = "STRLEN";
+  char field_trim[] = "trim";
+  char field_car[] = "car";
+  char field_unknown[] = "strlength";
+  char subfield_none[] = "";
+  char result[MAX_INPUT_LENGTH];
+
+  variable.name = name;
+  variable.value = value;
+
+  CuAssertTrue(tc, text_processed(field_strlen, subfield_none, &variable, result, sizeof(result)));
+  CuAssertStrEquals(tc, "15", result);
+  CuAssertTrue(tc, text_processed(field_trim, subfield_none, &variable, result, sizeof(result)));
+  CuAssertStrEquals(tc, "Hello world", result);
+  variable.value = words;
+  CuAssertTrue(tc, text_processed(field_car, subfield_none, &variable, result, sizeof(result)));
+  CuAssertStrEquals(tc, "Hello", result);
+  CuAssertTrue(tc,
+               !text_processed(field_unknown, subfield_none, &variable, result, sizeof(result)));
+}
@@ -0,0 +1,128 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/perfmon.h"
+#include "../../src/dgscript/dg_scripts.h"
+#include "test.helpers.h"
+
+#include <string.h>
+
+/* UIDs far above anything the game hands out, so the tests can share the
+ * table with whatever the rest of the suite left in it. */
+#define UID_TEST_BASE 1500000000L
+#define UID_TEST_MOBS 300
+#define UID_CHURN_KEYS 4096
+#define UID_CHURN_STEPS 50000
+#define UID_BENCH_ENTRIES 1000000
+
+static unsigned int uid_test_rand(unsigned int *seed)
+{
+  *seed = *seed * 1103515245U + 12345U;
+  return *seed >> 8;
+}
+
+void Test_dg_uid_table_finds_updates_and_removes(CuTest *tc)
+{
+  static struct char_data mobs[UID_TEST_MOBS], replacement;
+  long base = ROOM_ID_BASE - UID_TEST_MOBS, uid;
+  int i;
+
+  for (i = 0; i < UID_TEST_MOBS; i++)
+    CuAssertTrue(tc, !has_obj_by_uid_in_lookup_table(base + i));
+
+  for (i = 0; i < UID_TEST_MOBS; i++)
+    add_to_lookup_table(base + i, &mobs[i]);
+  for (i = 0; i < UID_TEST_MOBS; i++)
+    CuAssertPtrEquals(tc, &mobs[i], find_char(base + i));
+
+  /* Adding a UID again replaces what it points at. */
+  add_to_lookup_table(base + 7, &replacement);
+  CuAssertPtrEquals(tc, &replacement, find_char(base + 7));
+
+  /* Removing from the middle of probe runs must leave the rest findable. */
+  for (i = 0; i < UID_TEST_MOBS; i += 3)
+    remove_from_lookup_table(base + i);
+  for (i = 0; i < UID_TEST_MOBS; i++)
+  {
+    uid = base + i;
+    if (i % 3 == 0)
+      CuAssertPtrEquals(tc, NULL, find_char(uid));
+    else
+      CuAssertPtrEquals(tc, i == 7 ? &replacement : &mobs[i], find_char(uid));
+  }
+
+  for (i = 0; i < UID_TEST_MOBS; i++)
+    if (i % 3)
+      remove_from_lookup_table(base + i);
+  for (i = 0; i < UID_TEST_MOBS; i++)
+    CuAssertTrue(tc, !has_obj_by_uid_in_lookup_table(base + i));
+}
+
+/* Random adds and removes against a plain array of what should be there,
+ * through several resizes. */
+void Test_dg_uid_table_survives_churn(CuTest *tc)
+{
+  static bool present[UID_CHURN_KEYS];
+  unsigned int seed = 42;
+  int step, key, wrong = 0;
+
+  memset(present, 0, sizeof(present));
+  for (step = 0; step < UID_CHURN_STEPS; step++)
+  {
+    key = (int)(uid_test_rand(&seed) % UID_CHURN_KEYS);
+    if (present[key])
+      remove_from_lookup_table(UID_TEST_BASE + key);
+    else
+      add_to_lookup_table(UID_TEST_BASE + key, &present[key]);
+    present[key] = !present[key];
+
+    if (step % 5000 == 4999)
+      for (key = 0; key < UID_CHURN_KEYS; key++)
+        if (has_obj_by_uid_in_lookup_table(UID_TEST_BASE + key) != present[key])
+          wrong++;
+  }
+  CuAssertIntEquals(tc, 0, wrong);
+
+  for (key = 0; key < UID_CHURN_KEYS; key++)
+    if (present[key])
+      remove_from_lookup_table(UID_TEST_BASE + key);
+  for (key = 0; key < UID_CHURN_KEYS; key++)
+    CuAssertTrue(tc, !has_obj_by_uid_in_lookup_table(UID_TEST_BASE + key));
+}
+
+void Test_dg_uid_table_benchmark(CuTest *tc)
+{
+  static char target;
+  uint64_t start, add_usec, find_usec, remove_usec;
+  long i, found = 0;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < UID_BENCH_ENTRIES; i++)
+    add_to_lookup_table(UID_TEST_BASE + i, &target);
+  add_usec = PERF_monotonic_usec() - start;
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < UID_BENCH_ENTRIES; i++)
+    found += has_obj_by_uid_in_lookup_table(UID_TEST_BASE + i);
+  find_usec = PERF_monotonic_usec() - start;
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < UID_BENCH_ENTRIES; i++)
+    remove_from_lookup_table(UID_TEST_BASE + i);
+  remove_usec = PERF_monotonic_usec() - start;
+
+  CuAssertTrue(tc, found == UID_BENCH_ENTRIES);
+  CuAssertTrue(tc, !has_obj_by_uid_in_lookup_table(UID_TEST_BASE));
+  log("BENCHMARK: DG UID table, %d entries: add %llu usec, lookup %llu usec, remove %llu usec",
+      UID_BENCH_ENTRIES, (unsigned long long)add_usec, (unsigned long long)find_usec,
+      (unsigned long long)remove_usec);
+}
@@ -0,0 +1,199 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/handler.h"
+#include "../../src/olc/genolc.h"
+#include "../../src/olc/genobj.h"
+
+#include <string.h>
+
+#define FEAT_CACHE_TEST_ITEMS 10
+#define FEAT_CACHE_TEST_VNUM 169900
+
+struct feat_cache_fixture
+{
+  struct room_data room;
+  struct char_data ch;
+  struct player_special_data player_specials;
+  struct obj_data items[FEAT_CACHE_TEST_ITEMS];
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+};
+
+static void feat_cache_item(struct obj_data *obj, int featnum)
+{
+  memset(obj, 0, sizeof(*obj));
+  obj->in_room = NOWHERE;
+  obj->item_number = NOTHING;
+  obj->worn_on = -1;
+  obj->short_description = "feat cache test item";
+  GET_OBJ_TYPE(obj) = ITEM_WORN;
+  obj->affected[0].location = APPLY_STR;
+  obj->affected[0].modifier = 1;
+  obj->affected[0].bonus_type = BONUS_TYPE_ENHANCEMENT;
+  obj->affected[1].location = APPLY_FEAT;
+  obj->affected[1].modifier = featnum;
+}
+
+static void begin_feat_cache_fixture(struct feat_cache_fixture *fixture)
+{
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  world = &fixture->room;
+  top_of_world = 0;
+
+  clear_char(&fixture->ch);
+  fixture->ch.player_specials = &fixture->player_specials;
+  fixture->ch.player.name = "feat cache test character";
+  IN_ROOM(&fixture->ch) = 0;
+  GET_LEVEL(&fixture->ch) = 10;
+  GET_REAL_SIZE(&fixture->ch) = SIZE_MEDIUM;
+  fixture->ch.points.size = SIZE_MEDIUM;
+  GET_POS(&fixture->ch) = POS_STANDING;
+  fixture->room.people = &fixture->ch;
+}
+
+static void end_feat_cache_fixture(struct feat_cache_fixture *fixture)
+{
+  int i;
+
+  for (i = 0; i < NUM_WEARS; i++)
+    if (GET_EQ(&fixture->ch, i))
+      unequip_char(&fixture->ch, i);
+  while (fixture->ch.affected != NULL)
+    affect_remove_no_total(&fixture->ch, fixture->ch.affected);
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+}
+
+void Test_feat_cache_counts_worn_feats_once_per_item(CuTest *tc)
+{
+  struct feat_cache_fixture fixture;
+  struct char_data *ch;
+  bool saved_validate = feat_cache_validate;
+
+  begin_feat_cache_fixture(&fixture);
+  ch = &fixture.ch;
+  feat_cache_validate = TRUE;
+
+  SET_FEAT(ch, FEAT_DODGE, 1);
+  feat_cache_item(&fixture.items[0], FEAT_POWER_ATTACK);
+  /* A second copy of the same feat on one item still only counts once. */
+  fixture.items[0].affected[2].location = APPLY_FEAT;
+  fixture.items[0].affected[2].modifier = FEAT_POWER_ATTACK;
+  feat_cache_item(&fixture.items[1], FEAT_POWER_ATTACK);
+  feat_cache_item(&fixture.items[2], FEAT_DODGE);
+
+  CuAssertIntEquals(tc, 0, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+  equip_char(ch, &fixture.items[0], WEAR_FINGER_R);
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+  equip_char(ch, &fixture.items[1], WEAR_NECK_1);
+  CuAssertIntEquals(tc, 2, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+  equip_char(ch, &fixture.items[2], WEAR_HEAD);
+  CuAssertIntEquals(tc, 2, HAS_FEAT(ch, FEAT_DODGE));
+
+  unequip_char(ch, WEAR_FINGER_R);
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+
+  /* Feats gained after the gear went on are read straight from the pfile data. */
+  SET_FEAT(ch, FEAT_POWER_ATTACK, 1);
+  CuAssertIntEquals(tc, 2, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+
+  unequip_char(ch, WEAR_NECK_1);
+  unequip_char(ch, WEAR_HEAD);
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_DODGE));
+
+  feat_cache_validate = saved_validate;
+  end_feat_cache_fixture(&fixture);
+}
+
+void Test_feat_cache_validation_repairs_in_place_item_edits(CuTest *tc)
+{
+  struct feat_cache_fixture fixture;
+  struct char_data *ch;
+  bool saved_validate = feat_cache_validate;
+
+  begin_feat_cache_fixture(&fixture);
+  ch = &fixture.ch;
+  feat_cache_item(&fixture.items[0], FEAT_DODGE);
+  equip_char(ch, &fixture.items[0], WEAR_FINGER_R);
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_DODGE));
+
+  /* Editing a worn item behind equip_char()'s back leaves the cache stale
+   * until the debug cross-check notices. */
+  fixture.items[0].affected[1].modifier = FEAT_POWER_ATTACK;
+  feat_cache_validate = FALSE;
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_DODGE));
+  feat_cache_validate = TRUE;
+  CuAssertIntEquals(tc, 0, HAS_FEAT(ch, FEAT_DODGE));
+  CuAssertIntEquals(tc, 1, HAS_FEAT(ch, FEAT_POWER_ATTACK));
+
+  feat_cache_validate = saved_validate;
+  end_feat_cache_fixture(&fixture);
+}
+
+void Test_feat_cache_follows_olc_prototype_saves(CuTest *tc)
+{
+  struct feat_cache_fixture fixture;
+  struct index_data index;
+  struct obj_data proto, edited, *saved_object_list = object_list;
+  struct index_data *saved_obj_index = obj_index;
+  struct obj_data *saved_obj_proto = obj_proto;
+  obj_rnum saved_top_of_objt = top_of_objt;
+  struct zone_data zone, *saved_zone_table = zone_table;
+  zone_rnum saved_top_of_zone_table = top_of_zone_table;
+  bool saved_validate = feat_cache_validate;
+
+  begin_feat_cache_fixture(&fixture);
+  feat_cache_validate = FALSE;
+
+  memset(&index, 0, sizeof(index));
+  index.vnum = FEAT_CACHE_TEST_VNUM;
+  feat_cache_item(&proto, FEAT_DODGE);
+  proto.item_number = 0;
+  proto.short_description = strdup("feat cache test item");
+  memset(&zone, 0, sizeof(zone));
+  zone.number = FEAT_CACHE_TEST_VNUM / 100;
+  zone.bot = FEAT_CACHE_TEST_VNUM;
+  zone.top = FEAT_CACHE_TEST_VNUM + 99;
+  obj_index = &index;
+  obj_proto = &proto;
+  top_of_objt = 0;
+  zone_table = &zone;
+  top_of_zone_table = 0;
+
+  /* A live copy of the prototype, worn. */
+  fixture.items[0] = proto;
+  fixture.items[0].next = NULL;
+  object_list = &fixture.items[0];
+  equip_char(&fixture.ch, &fixture.items[0], WEAR_FINGER_R);
+  CuAssertIntEquals(tc, 1, HAS_FEAT(&fixture.ch, FEAT_DODGE));
+
+  /* oedit saves the prototype with a different feat, which rewrites the
+   * worn copy in place. */
+  edited = proto;
+  edited.short_description = "feat cache test item";
+  edited.affected[1].modifier = FEAT_POWER_ATTACK;
+  CuAssertIntEquals(tc, 0, add_object(&edited, FEAT_CACHE_TEST_VNUM));
+  CuAssertIntEquals(tc, FEAT_POWER_ATTACK, fixture.items[0].affected[1].modifier);
+  CuAssertIntEquals(tc, 0, HAS_FEAT(&fixture.ch, FEAT_DODGE));
+  CuAssertIntEquals(tc, 1, HAS_FEAT(&fixture.ch, FEAT_POWER_ATTACK));
+
+  end_feat_cache_fixture(&fixture);
+  remove_from_save_list(zone.number, SL_OBJ);
+  free_object_strings(&proto);
+  object_list = saved_object_list;
+  obj_index = saved_obj_index;
+  obj_proto = saved_obj_proto;
+  top_of_objt = saved_top_of_objt;
+  zone_table = saved_zone_table;
+  top_of_zone_table = saved_top_of_zone_table;
+  feat_cache_validate = saved_validate;
+}
@@ -1362,6 +1362,7 @@ void Test_gameplay_e2e_dg_trigger_parse_and_execute(CuTest *tc)
     {
       next_command = commands->next;
       free(commands->cmd);
+      free(commands->tokens);
       free(commands);
       commands = next_command;
     }
@@ -1479,6 +1480,7 @@ void Test_gameplay_e2e_damage_trigger_overrides_damage(CuTest *tc)
     {
       next_command = commands->next;
       free(commands->cmd);
+      free(commands->tokens);
       free(commands);
       commands = next_command;
     }
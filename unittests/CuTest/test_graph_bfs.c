@@ -0,0 +1,405 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/graph.h"
+#include "../../src/perfmon.h"
+#include "test.helpers.h"
+
+#include <string.h>
+
+#define GRAPH_TEST_SIDE 12
+#define GRAPH_BENCH_SIDE 20   /* 400 rooms, the size of the biggest stock zones */
+#define GRAPH_BENCH_FILLER 20000 /* Rooms elsewhere in the world the old search unmarked */
+#define GRAPH_BENCH_TRACKS 20000
+#define GRAPH_BENCH_LEGACY_TRACKS 2000 /* The old search is far too slow for more */
+
+/* Zone 0 holds room 0 and any filler, zone 1 is a side x side grid, zone 2 a
+ * two-room corridor that offers zone 1 a shortcut through another zone. */
+struct graph_fixture
+{
+  struct room_data *rooms;
+  struct zone_data zones[3];
+  int side, filler, count;
+  room_rnum grid, shortcut;
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  struct zone_data *saved_zone_table;
+  zone_rnum saved_top_of_zone_table;
+  int saved_track_doors, saved_diagonal_dirs;
+  bool saved_cache, saved_validate;
+};
+
+static room_rnum graph_cell(struct graph_fixture *fixture, int x, int y)
+{
+  return fixture->grid + y * fixture->side + x;
+}
+
+static void graph_link(room_rnum from, int dir, room_rnum to)
+{
+  if (world[from].dir_option[dir] == NULL)
+    CREATE(world[from].dir_option[dir], struct room_direction_data, 1);
+  world[from].dir_option[dir]->to_room = to;
+  world[from].dir_option[dir]->exit_info = 0;
+}
+
+static void graph_unlink(room_rnum from, int dir)
+{
+  if (world[from].dir_option[dir])
+    free(world[from].dir_option[dir]);
+  world[from].dir_option[dir] = NULL;
+}
+
+static void begin_graph_fixture(struct graph_fixture *fixture, int side, int filler, bool walls)
+{
+  int x, y, i;
+  room_rnum room;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  fixture->saved_zone_table = zone_table;
+  fixture->saved_top_of_zone_table = top_of_zone_table;
+  fixture->saved_track_doors = CONFIG_TRACK_T_DOORS;
+  fixture->saved_diagonal_dirs = CONFIG_DIAGONAL_DIRS;
+  fixture->saved_cache = graph_next_hop_cache;
+  fixture->saved_validate = graph_cache_validate;
+
+  fixture->side = side;
+  fixture->filler = filler;
+  fixture->grid = 1 + filler;
+  fixture->shortcut = fixture->grid + side * side;
+  fixture->count = fixture->shortcut + 2;
+  CREATE(fixture->rooms, struct room_data, fixture->count);
+  for (i = 0; i < fixture->count; i++)
+  {
+    fixture->rooms[i].number = i;
+    fixture->rooms[i].zone = i < (int)fixture->grid ? 0 : (i < (int)fixture->shortcut ? 1 : 2);
+  }
+  for (i = 0; i < 3; i++)
+    fixture->zones[i].number = i;
+
+  world = fixture->rooms;
+  top_of_world = fixture->count - 1;
+  zone_table = fixture->zones;
+  top_of_zone_table = 2;
+  CONFIG_TRACK_T_DOORS = TRUE;
+  CONFIG_DIAGONAL_DIRS = 0;
+  graph_next_hop_cache = TRUE;
+  graph_cache_validate = FALSE;
+  graph_exits_changed();
+
+  /* Filler rooms form one long corridor hanging off room 0. */
+  for (i = 0; i < filler; i++)
+  {
+    graph_link(i, EAST, i + 1);
+    graph_link(i + 1, WEST, i);
+  }
+
+  for (y = 0; y < side; y++)
+    for (x = 0; x < side; x++)
+    {
+      room = graph_cell(fixture, x, y);
+      if (x + 1 < side && !(walls && x == side / 2 && y > 0))
+      {
+        graph_link(room, EAST, graph_cell(fixture, x + 1, y));
+        graph_link(graph_cell(fixture, x + 1, y), WEST, room);
+      }
+      if (y + 1 < side && !(walls && y == side / 3 && x < side - 1))
+      {
+        graph_link(room, SOUTH, graph_cell(fixture, x, y + 1));
+        graph_link(graph_cell(fixture, x, y + 1), NORTH, room);
+      }
+    }
+
+  if (!walls)
+    return;
+
+  /* A one-way chute, a room trackers may not enter, and a corridor through
+   * zone 2 that is the short way between the grid's bottom corners. */
+  graph_link(graph_cell(fixture, 0, side - 1), UP, graph_cell(fixture, side - 1, 0));
+  SET_BIT_AR(ROOM_FLAGS(graph_cell(fixture, 2, 2)), ROOM_NOTRACK);
+  graph_link(graph_cell(fixture, 0, side - 1), DOWN, fixture->shortcut);
+  graph_link(fixture->shortcut, UP, graph_cell(fixture, 0, side - 1));
+  graph_link(fixture->shortcut, EAST, fixture->shortcut + 1);
+  graph_link(fixture->shortcut + 1, WEST, fixture->shortcut);
+  graph_link(fixture->shortcut + 1, UP, graph_cell(fixture, side - 1, side - 1));
+  graph_link(graph_cell(fixture, side - 1, side - 1), DOWN, fixture->shortcut + 1);
+}
+
+static void end_graph_fixture(struct graph_fixture *fixture)
+{
+  int i, dir;
+
+  for (i = 0; i < fixture->count; i++)
+    for (dir = 0; dir < NUM_OF_DIRS; dir++)
+      graph_unlink(i, dir);
+  free(fixture->rooms);
+
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  zone_table = fixture->saved_zone_table;
+  top_of_zone_table = fixture->saved_top_of_zone_table;
+  CONFIG_TRACK_T_DOORS = fixture->saved_track_doors;
+  CONFIG_DIAGONAL_DIRS = fixture->saved_diagonal_dirs;
+  graph_next_hop_cache = fixture->saved_cache;
+  graph_cache_validate = fixture->saved_validate;
+  graph_exits_changed();
+}
+
+/* find_first_step() as it was, flag marks and linked queue and all, as the
+ * reference answer and the benchmark baseline. */
+struct legacy_bfs_node
+{
+  room_rnum room;
+  char dir;
+  struct legacy_bfs_node *next;
+};
+
+static struct legacy_bfs_node *legacy_head = NULL, *legacy_tail = NULL;
+
+#define LEGACY_MARK(room) (SET_BIT_AR(ROOM_FLAGS(room), ROOM_BFS_MARK))
+#define LEGACY_UNMARK(room) (REMOVE_BIT_AR(ROOM_FLAGS(room), ROOM_BFS_MARK))
+#define LEGACY_IS_MARKED(room) (ROOM_FLAGGED(room, ROOM_BFS_MARK))
+#define LEGACY_TOROOM(x, y) (world[(x)].dir_option[(y)]->to_room)
+
+static int legacy_valid_edge(room_rnum x, int y)
+{
+  if (world[x].dir_option[y] == NULL || LEGACY_TOROOM(x, y) == NOWHERE)
+    return 0;
+  if (CONFIG_TRACK_T_DOORS == FALSE && EXIT_FLAGGED(world[x].dir_option[y], EX_CLOSED))
+    return 0;
+  if (ROOM_FLAGGED(LEGACY_TOROOM(x, y), ROOM_NOTRACK) || LEGACY_IS_MARKED(LEGACY_TOROOM(x, y)))
+    return 0;
+  return 1;
+}
+
+static void legacy_enqueue(room_rnum room, int dir)
+{
+  struct legacy_bfs_node *curr;
+
+  CREATE(curr, struct legacy_bfs_node, 1);
+  curr->room = room;
+  curr->dir = dir;
+  curr->next = 0;
+  if (legacy_tail)
+  {
+    legacy_tail->next = curr;
+    legacy_tail = curr;
+  }
+  else
+    legacy_head = legacy_tail = curr;
+}
+
+static void legacy_dequeue(void)
+{
+  struct legacy_bfs_node *curr = legacy_head;
+
+  if (!(legacy_head = legacy_head->next))
+    legacy_tail = 0;
+  free(curr);
+}
+
+static int legacy_find_first_step(room_rnum src, room_rnum target)
+{
+  int curr_dir;
+  room_rnum curr_room;
+
+  if (GET_ROOM_ZONE(src) != GET_ROOM_ZONE(target))
+    return BFS_NO_PATH;
+  if (src == target)
+    return BFS_ALREADY_THERE;
+
+  for (curr_room = 0; curr_room <= top_of_world; curr_room++)
+    LEGACY_UNMARK(curr_room);
+  LEGACY_MARK(src);
+
+  for (curr_dir = 0; curr_dir < DIR_COUNT; curr_dir++)
+    if (legacy_valid_edge(src, curr_dir))
+    {
+      LEGACY_MARK(LEGACY_TOROOM(src, curr_dir));
+      legacy_enqueue(LEGACY_TOROOM(src, curr_dir), curr_dir);
+    }
+
+  while (legacy_head)
+  {
+    if (legacy_head->room == target)
+    {
+      curr_dir = legacy_head->dir;
+      while (legacy_head)
+        legacy_dequeue();
+      return curr_dir;
+    }
+    for (curr_dir = 0; curr_dir < DIR_COUNT; curr_dir++)
+      if (legacy_valid_edge(legacy_head->room, curr_dir))
+      {
+        LEGACY_MARK(LEGACY_TOROOM(legacy_head->room, curr_dir));
+        legacy_enqueue(LEGACY_TOROOM(legacy_head->room, curr_dir), legacy_head->dir);
+      }
+    legacy_dequeue();
+  }
+  return BFS_NO_PATH;
+}
+
+/* Every ordered pair of grid rooms, asked twice so the second pass is served
+ * from the next-hop tables. */
+static int graph_mismatches(struct graph_fixture *fixture)
+{
+  room_rnum src, target, end = fixture->grid + fixture->side * fixture->side;
+  int pass, bad = 0;
+
+  for (pass = 0; pass < 2; pass++)
+    for (src = fixture->grid; src < end; src++)
+      for (target = fixture->grid; target < end; target++)
+        if (find_first_step(src, target) != legacy_find_first_step(src, target))
+          bad++;
+  return bad;
+}
+
+void Test_graph_bfs_matches_legacy_search(CuTest *tc)
+{
+  struct graph_fixture fixture;
+  room_rnum corner;
+
+  begin_graph_fixture(&fixture, GRAPH_TEST_SIDE, 5, TRUE);
+  corner = graph_cell(&fixture, 0, GRAPH_TEST_SIDE - 1);
+
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+
+  /* The shortcut through zone 2 wins, and the untrackable room is no target. */
+  CuAssertIntEquals(tc, DOWN,
+                    find_first_step(corner, graph_cell(&fixture, GRAPH_TEST_SIDE - 1,
+                                                       GRAPH_TEST_SIDE - 1)));
+  CuAssertIntEquals(tc, BFS_NO_PATH, find_first_step(corner, graph_cell(&fixture, 2, 2)));
+  CuAssertIntEquals(tc, BFS_NO_PATH, find_first_step(corner, fixture.shortcut));
+  CuAssertIntEquals(tc, BFS_ALREADY_THERE, find_first_step(corner, corner));
+  CuAssertIntEquals(tc, BFS_ERROR, find_first_step(corner, top_of_world + 1));
+
+  /* The old search left its marks in the room flags; the new one does not. */
+  LEGACY_UNMARK(corner);
+  find_first_step(graph_cell(&fixture, 1, 1), graph_cell(&fixture, 3, 3));
+  CuAssertTrue(tc, !LEGACY_IS_MARKED(corner));
+
+  /* Diagonal directions on changes which exits count. */
+  graph_link(graph_cell(&fixture, 0, 0), SOUTHEAST, graph_cell(&fixture, 1, 1));
+  graph_exits_changed();
+  CONFIG_DIAGONAL_DIRS = 1;
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+
+  /* Without the tables at all. */
+  graph_next_hop_cache = FALSE;
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+
+  CuAssertIntEquals(tc, 3, count_rooms_between(graph_cell(&fixture, 0, 0),
+                                               graph_cell(&fixture, 3, 0)));
+
+  end_graph_fixture(&fixture);
+}
+
+void Test_graph_bfs_doors_and_invalidation(CuTest *tc)
+{
+  struct graph_fixture fixture;
+  room_rnum a, b;
+
+  begin_graph_fixture(&fixture, GRAPH_TEST_SIDE, 0, TRUE);
+  a = graph_cell(&fixture, 0, 0);
+  b = graph_cell(&fixture, 1, 0);
+
+  /* Warm the tables, then close a door: it only matters when trackers may
+   * not pass closed doors, and then the tables must stay out of it. */
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+  SET_BIT(world[a].dir_option[EAST]->exit_info, EX_ISDOOR | EX_CLOSED);
+  CuAssertIntEquals(tc, EAST, find_first_step(a, b));
+  CONFIG_TRACK_T_DOORS = FALSE;
+  CuAssertIntEquals(tc, SOUTH, find_first_step(a, b));
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+  CONFIG_TRACK_T_DOORS = TRUE;
+  CuAssertIntEquals(tc, EAST, find_first_step(a, b));
+
+  /* Removing an exit and saying so drops the tables. */
+  graph_unlink(a, EAST);
+  graph_unlink(b, WEST);
+  graph_exits_changed();
+  CuAssertIntEquals(tc, SOUTH, find_first_step(a, b));
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+
+  /* Changing an exit without saying so is caught in validation mode. */
+  graph_link(a, EAST, b);
+  graph_cache_validate = TRUE;
+  CuAssertIntEquals(tc, EAST, find_first_step(a, b));
+  CuAssertIntEquals(tc, 0, graph_mismatches(&fixture));
+
+  /* A new world array is noticed on its own. */
+  graph_cache_validate = FALSE;
+  top_of_world--;
+  CuAssertIntEquals(tc, legacy_find_first_step(a, b), find_first_step(a, b));
+  top_of_world++;
+
+  end_graph_fixture(&fixture);
+}
+
+/* Trackers repeatedly asking their way between random rooms of one zone, in a
+ * world big enough that clearing every room's mark shows up. */
+static long graph_track(struct graph_fixture *fixture, int tracks, bool legacy, long *sum)
+{
+  unsigned int seed = 4242U;
+  int i, cells = fixture->side * fixture->side;
+  room_rnum src, target;
+
+  *sum = 0;
+  for (i = 0; i < tracks; i++)
+  {
+    seed = seed * 1103515245U + 12345U;
+    src = fixture->grid + (seed >> 8) % (unsigned int)cells;
+    seed = seed * 1103515245U + 12345U;
+    target = fixture->grid + (seed >> 8) % (unsigned int)cells;
+    *sum += legacy ? legacy_find_first_step(src, target) : find_first_step(src, target);
+  }
+  return tracks;
+}
+
+void Test_graph_bfs_benchmark_zone_tracking(CuTest *tc)
+{
+  struct graph_fixture fixture;
+  uint64_t start_usec, legacy_usec, stamped_usec, cached_usec;
+  long legacy_sum, stamped_sum, cached_sum, legacy_n, stamped_n, cached_n;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  begin_graph_fixture(&fixture, GRAPH_BENCH_SIDE, GRAPH_BENCH_FILLER, FALSE);
+
+  start_usec = PERF_monotonic_usec();
+  legacy_n = graph_track(&fixture, GRAPH_BENCH_LEGACY_TRACKS, TRUE, &legacy_sum);
+  legacy_usec = PERF_monotonic_usec() - start_usec;
+
+  graph_next_hop_cache = FALSE;
+  start_usec = PERF_monotonic_usec();
+  stamped_n = graph_track(&fixture, GRAPH_BENCH_LEGACY_TRACKS, FALSE, &stamped_sum);
+  stamped_usec = PERF_monotonic_usec() - start_usec;
+  CuAssertTrue(tc, legacy_sum == stamped_sum);
+
+  graph_next_hop_cache = TRUE;
+  graph_track(&fixture, GRAPH_BENCH_TRACKS, FALSE, &cached_sum); /* warm the tables */
+  start_usec = PERF_monotonic_usec();
+  cached_n = graph_track(&fixture, GRAPH_BENCH_TRACKS, FALSE, &cached_sum);
+  cached_usec = PERF_monotonic_usec() - start_usec;
+  graph_track(&fixture, GRAPH_BENCH_LEGACY_TRACKS, FALSE, &stamped_sum);
+  CuAssertTrue(tc, legacy_sum == stamped_sum);
+
+  log("BENCHMARK: find_first_step in a %d-room zone of a %d-room world: %.0f tracks/sec "
+      "marking rooms, %.0f tracks/sec stamped, %.0f tracks/sec from the next-hop tables.",
+      GRAPH_BENCH_SIDE * GRAPH_BENCH_SIDE, fixture.count,
+      legacy_n * 1000000.0 / (double)MAX(legacy_usec, 1),
+      stamped_n * 1000000.0 / (double)MAX(stamped_usec, 1),
+      cached_n * 1000000.0 / (double)MAX(cached_usec, 1));
+
+  end_graph_fixture(&fixture);
+}
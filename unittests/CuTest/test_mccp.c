@@ -0,0 +1,381 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/perfmon.h"
+#include "../../src/net/protocol.h"
+#include "../../src/net/mccp.h"
+
+#include <arpa/telnet.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#ifdef USING_MCCP
+#include <zlib.h>
+#endif
+
+#define MCCP_TEST_PULSES 200
+#define MCCP_TEST_CAPTURE (512 * 1024)
+
+struct mccp_peer
+{
+  struct descriptor_data d;
+  int sv[2];
+  unsigned char *seen;
+  size_t seen_length;
+};
+
+static void mccp_peer_open(CuTest *tc, struct mccp_peer *p)
+{
+  memset(p, 0, sizeof(*p));
+  CuAssertIntEquals(tc, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, p->sv));
+  p->d.descriptor = p->sv[0];
+  p->d.output = p->d.small_outbuf;
+  p->d.bufspace = SMALL_BUFSIZE - 1;
+  p->d.connected = CON_CLOSE;
+  p->d.pProtocol = ProtocolCreate();
+  CREATE(p->seen, unsigned char, MCCP_TEST_CAPTURE);
+}
+
+/* Collect whatever the server side has sent so far. */
+static void mccp_peer_drain(struct mccp_peer *p)
+{
+  ssize_t got;
+
+  while (p->seen_length < MCCP_TEST_CAPTURE &&
+         (got = recv(p->sv[1], p->seen + p->seen_length, MCCP_TEST_CAPTURE - p->seen_length,
+                     MSG_DONTWAIT)) > 0)
+    p->seen_length += (size_t)got;
+}
+
+static void mccp_peer_close(struct mccp_peer *p)
+{
+  mccp_free(&p->d);
+  ProtocolDestroy(p->d.pProtocol);
+  close(p->sv[0]);
+  close(p->sv[1]);
+  free(p->seen);
+}
+
+/* One pulse of the sort of text a wilderness player sees: a map, a room and
+ * some combat, with the colour codes already expanded. */
+static void mccp_pulse_text(int pulse, char *buf, size_t size)
+{
+  static const char *const terrain[] = {"\033[0;32m.", "\033[1;32m^", "\033[0;34m~",
+                                        "\033[0;33m:", "\033[1;37m*"};
+  size_t len = 0;
+  int row, col;
+
+  for (row = 0; row < 5; row++)
+  {
+    for (col = 0; col < 11; col++)
+      len += snprintf(buf + len, size - len, "%s", terrain[(pulse + row * 3 + col) % 5]);
+    len += snprintf(buf + len, size - len, "\033[0m\r\n");
+  }
+  snprintf(buf + len, size - len,
+           "The Wilderness of Luminari [%d, %d]\r\n"
+           "An orc hits you hard. (%d damage)\r\n",
+           pulse % 1024, (pulse * 7) % 1024, pulse % 37);
+}
+
+#ifdef USING_MCCP
+/* Inflate a whole MCCP2 stream, stopping at its end; returns bytes used. */
+static size_t mccp_test_inflate(CuTest *tc, const unsigned char *in, size_t length,
+                                unsigned char *out, size_t *out_length, size_t size)
+{
+  z_stream z;
+  int result;
+
+  memset(&z, 0, sizeof(z));
+  CuAssertIntEquals(tc, Z_OK, inflateInit(&z));
+  z.next_in = (Bytef *)in;
+  z.avail_in = (uInt)length;
+  z.next_out = out;
+  z.avail_out = (uInt)size;
+  result = inflate(&z, Z_SYNC_FLUSH);
+  CuAssertTrue(tc, result == Z_OK || result == Z_STREAM_END);
+  *out_length = size - z.avail_out;
+  length -= z.avail_in;
+  inflateEnd(&z);
+  return length;
+}
+#endif
+
+void Test_mccp_output_matches_plain_stream(CuTest *tc)
+{
+#ifdef USING_MCCP
+  static const unsigned char start[] = {IAC, SB, TELOPT_MCCP, IAC, SE};
+  struct mccp_peer plain, packed;
+  unsigned char *inflated;
+  size_t inflated_length, used;
+  uint64_t raw_before, raw_after, compressed_before, compressed_after;
+  char text[SMALL_BUFSIZE];
+  int pulse;
+
+  mccp_peer_open(tc, &plain);
+  mccp_peer_open(tc, &packed);
+  PERF_mccp_output_stats(&raw_before, &compressed_before);
+
+  CuAssertTrue(tc, mccp_start(&packed.d));
+  for (pulse = 0; pulse < MCCP_TEST_PULSES; pulse++)
+  {
+    mccp_pulse_text(pulse, text, sizeof(text));
+    write_to_output(&plain.d, "%s", text);
+    write_to_output(&packed.d, "%s", text);
+    CuAssertTrue(tc, comm_test_process_output(&plain.d) > 0);
+    CuAssertTrue(tc, comm_test_process_output(&packed.d) > 0);
+    mccp_peer_drain(&plain);
+    mccp_peer_drain(&packed);
+  }
+
+  /* Ending the stream sends its tail; what follows is plain again. */
+  mccp_end(&packed.d);
+  CuAssertPtrEquals(tc, NULL, packed.d.mccp);
+  write_to_output(&plain.d, "Goodbye.\r\n");
+  write_to_output(&packed.d, "Goodbye.\r\n");
+  CuAssertTrue(tc, comm_test_process_output(&plain.d) > 0);
+  CuAssertTrue(tc, comm_test_process_output(&packed.d) > 0);
+  mccp_peer_drain(&plain);
+  mccp_peer_drain(&packed);
+
+  CuAssertTrue(tc, packed.seen_length > sizeof(start));
+  CuAssertTrue(tc, memcmp(packed.seen, start, sizeof(start)) == 0);
+  CuAssertTrue(tc, packed.seen_length < plain.seen_length / 2);
+
+  CREATE(inflated, unsigned char, MCCP_TEST_CAPTURE);
+  used = mccp_test_inflate(tc, packed.seen + sizeof(start), packed.seen_length - sizeof(start),
+                           inflated, &inflated_length, MCCP_TEST_CAPTURE);
+  PERF_mccp_output_stats(&raw_after, &compressed_after);
+  CuAssertIntEquals(tc, (int)inflated_length, (int)(raw_after - raw_before));
+  CuAssertIntEquals(tc, (int)used, (int)(compressed_after - compressed_before));
+  memcpy(inflated + inflated_length, packed.seen + sizeof(start) + used,
+         packed.seen_length - sizeof(start) - used);
+  inflated_length += packed.seen_length - sizeof(start) - used;
+
+  CuAssertIntEquals(tc, (int)plain.seen_length, (int)inflated_length);
+  CuAssertTrue(tc, memcmp(plain.seen, inflated, plain.seen_length) == 0);
+
+  free(inflated);
+  mccp_peer_close(&plain);
+  mccp_peer_close(&packed);
+#else
+  (void)tc;
+#endif
+}
+
+void Test_mccp_output_waits_for_a_full_socket(CuTest *tc)
+{
+#ifdef USING_MCCP
+  struct mccp_peer packed;
+  unsigned char *inflated;
+  size_t inflated_length;
+  char text[SMALL_BUFSIZE];
+  int sndbuf = 4096, pulse, result, stalled = 0;
+  size_t expected = 0;
+
+  mccp_peer_open(tc, &packed);
+  setsockopt(packed.sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+  CuAssertIntEquals(tc, 0, fcntl(packed.sv[0], F_SETFL, O_NONBLOCK));
+  CuAssertTrue(tc, mccp_start(&packed.d));
+
+  /* Without a reader the socket fills; the text then stays queued. */
+  for (pulse = 0; pulse < MCCP_TEST_PULSES && !stalled; pulse++)
+  {
+    mccp_pulse_text(pulse * 13, text, sizeof(text));
+    write_to_output(&packed.d, "%s", text);
+    result = comm_test_process_output(&packed.d);
+    CuAssertTrue(tc, result >= 0);
+    if (result == 0)
+      stalled = 1;
+    expected += (size_t)result;
+  }
+  CuAssertTrue(tc, stalled);
+  CuAssertTrue(tc, mccp_pending(packed.d.mccp));
+  CuAssertTrue(tc, packed.d.bufptr > 0);
+
+  /* Once the client reads, the queued text follows the stream in order. */
+  while (packed.d.bufptr > 0 || mccp_pending(packed.d.mccp))
+  {
+    mccp_peer_drain(&packed);
+    CuAssertIntEquals(tc, 0, mccp_flush(&packed.d));
+    if (packed.d.bufptr > 0 && (result = comm_test_process_output(&packed.d)) > 0)
+      expected += (size_t)result;
+  }
+  mccp_peer_drain(&packed);
+
+  CREATE(inflated, unsigned char, MCCP_TEST_CAPTURE + 1);
+  mccp_test_inflate(tc, packed.seen + 5, packed.seen_length - 5, inflated, &inflated_length,
+                    MCCP_TEST_CAPTURE);
+  CuAssertIntEquals(tc, (int)expected, (int)inflated_length);
+  inflated[inflated_length] = '\0';
+  mccp_pulse_text((pulse - 1) * 13, text, sizeof(text));
+  CuAssertPtrNotNull(tc, strstr((const char *)inflated, text));
+
+  free(inflated);
+  mccp_peer_close(&packed);
+#else
+  (void)tc;
+#endif
+}
+
+#ifdef USING_MCCP
+/* What a client's MCCP3 stream holds for text: deflated, sync-flushed. */
+static size_t mccp_client_deflate(z_stream *z, const char *text, int flush, unsigned char *out,
+                                  size_t size)
+{
+  z->next_in = (Bytef *)text;
+  z->avail_in = (uInt)strlen(text);
+  z->next_out = out;
+  z->avail_out = (uInt)size;
+  deflate(z, flush);
+  return size - z->avail_out;
+}
+#endif
+
+void Test_mccp3_input_is_inflated_before_parsing(CuTest *tc)
+{
+#ifdef USING_MCCP
+  static const char mccp3_do[] = {(char)IAC, (char)DO, TELOPT_MCCP3};
+  static const char mccp3_start[] = {(char)IAC, (char)SB, TELOPT_MCCP3, (char)IAC, (char)SE};
+  struct mccp_peer client;
+  char in[MAX_PROTOCOL_BUFFER], out[MAX_PROTOCOL_BUFFER + 1];
+  unsigned char packed[1024];
+  size_t packed_length, half, len = 0;
+  z_stream z;
+
+  mccp_peer_open(tc, &client);
+  memset(&z, 0, sizeof(z));
+  CuAssertIntEquals(tc, Z_OK, deflateInit(&z, Z_DEFAULT_COMPRESSION));
+
+  *out = '\0';
+  CuAssertTrue(tc, ProtocolInput(&client.d, (char *)mccp3_do, sizeof(mccp3_do), out) >= 0);
+  CuAssertTrue(tc, client.d.pProtocol->bMCCP3);
+
+  /* Plain text, the start sequence and the first half of a command. */
+  packed_length = mccp_client_deflate(&z, "say hello\n", Z_SYNC_FLUSH, packed, sizeof(packed));
+  half = packed_length / 2;
+  memcpy(in, "look\n", 5);
+  len = 5;
+  memcpy(in + len, mccp3_start, sizeof(mccp3_start));
+  len += sizeof(mccp3_start);
+  memcpy(in + len, packed, half);
+  len += half;
+  *out = '\0';
+  CuAssertTrue(tc, ProtocolInput(&client.d, in, (int)len, out) >= 0);
+  CuAssertPtrNotNull(tc, client.d.mccp_in);
+
+  /* The rest of it, then the end of the stream and plain text after it. */
+  memcpy(in, packed + half, packed_length - half);
+  len = packed_length - half;
+  len += mccp_client_deflate(&z, "score\n", Z_FINISH, (unsigned char *)in + len,
+                             sizeof(in) - len);
+  memcpy(in + len, "quit\n", 5);
+  len += 5;
+  CuAssertTrue(tc, ProtocolInput(&client.d, in, (int)len, out) >= 0);
+  CuAssertPtrEquals(tc, NULL, client.d.mccp_in);
+  CuAssertStrEquals(tc, "look\nsay hello\nscore\nquit\n", out);
+
+  /* A corrupt stream is refused rather than parsed. */
+  len = 0;
+  memcpy(in, mccp3_start, sizeof(mccp3_start));
+  len += sizeof(mccp3_start);
+  memcpy(in + len, "not zlib at all", 15);
+  len += 15;
+  *out = '\0';
+  CuAssertIntEquals(tc, PROTOCOL_ERROR_INVALID_INPUT,
+                    (int)ProtocolInput(&client.d, in, (int)len, out));
+
+  deflateEnd(&z);
+  mccp_peer_close(&client);
+#else
+  (void)tc;
+#endif
+}
+
+void Test_mccp_finish_sends_the_end_of_a_stalled_stream(CuTest *tc)
+{
+#ifdef USING_MCCP
+  struct mccp_peer packed;
+  unsigned char *inflated;
+  size_t inflated_length;
+  char text[SMALL_BUFSIZE];
+  int sndbuf = 4096, pulse, rounds = 0;
+
+  mccp_peer_open(tc, &packed);
+  setsockopt(packed.sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+  CuAssertIntEquals(tc, 0, fcntl(packed.sv[0], F_SETFL, O_NONBLOCK));
+  CuAssertTrue(tc, mccp_start(&packed.d));
+  for (pulse = 0; pulse < MCCP_TEST_PULSES && !mccp_pending(packed.d.mccp); pulse++)
+  {
+    mccp_pulse_text(pulse * 13, text, sizeof(text));
+    write_to_output(&packed.d, "%s", text);
+    CuAssertTrue(tc, comm_test_process_output(&packed.d) >= 0);
+  }
+  comm_test_clear_output(&packed.d);
+
+  /* With the socket full the end of the stream is left behind, and no
+   * reader means waiting for it gives up once its time is out. */
+  mccp_end(&packed.d);
+  CuAssertTrue(tc, mccp_pending(packed.d.mccp));
+  CuAssertTrue(tc, !mccp_finish(&packed.d, 20));
+  CuAssertPtrNotNull(tc, packed.d.mccp);
+
+  /* Once the client reads, all of it goes and the stream is dropped. */
+  while (packed.d.mccp != NULL && rounds++ < 1000)
+  {
+    mccp_peer_drain(&packed);
+    mccp_finish(&packed.d, 20);
+  }
+  mccp_peer_drain(&packed);
+  CuAssertPtrEquals(tc, NULL, packed.d.mccp);
+
+  CREATE(inflated, unsigned char, MCCP_TEST_CAPTURE);
+  CuAssertIntEquals(tc, (int)(packed.seen_length - 5),
+                    (int)mccp_test_inflate(tc, packed.seen + 5, packed.seen_length - 5, inflated,
+                                           &inflated_length, MCCP_TEST_CAPTURE));
+
+  free(inflated);
+  mccp_peer_close(&packed);
+#else
+  (void)tc;
+#endif
+}
+
+void Test_mccp3_input_past_the_input_buffer_is_refused(CuTest *tc)
+{
+#ifdef USING_MCCP
+  static const char mccp3_do[] = {(char)IAC, (char)DO, TELOPT_MCCP3};
+  static const char mccp3_start[] = {(char)IAC, (char)SB, TELOPT_MCCP3, (char)IAC, (char)SE};
+  struct mccp_peer client;
+  char *line, in[MAX_PROTOCOL_BUFFER], out[MAX_PROTOCOL_BUFFER + 1];
+  size_t len;
+  z_stream z;
+
+  mccp_peer_open(tc, &client);
+  memset(&z, 0, sizeof(z));
+  CuAssertIntEquals(tc, Z_OK, deflateInit(&z, Z_DEFAULT_COMPRESSION));
+  *out = '\0';
+  CuAssertTrue(tc, ProtocolInput(&client.d, (char *)mccp3_do, sizeof(mccp3_do), out) >= 0);
+
+  /* A few hundred bytes on the wire that inflate past the whole buffer. */
+  CREATE(line, char, MAX_PROTOCOL_BUFFER * 2);
+  memset(line, 'a', MAX_PROTOCOL_BUFFER * 2 - 2);
+  line[MAX_PROTOCOL_BUFFER * 2 - 2] = '\n';
+  memcpy(in, mccp3_start, sizeof(mccp3_start));
+  len = sizeof(mccp3_start);
+  len += mccp_client_deflate(&z, line, Z_SYNC_FLUSH, (unsigned char *)in + len, sizeof(in) - len);
+  CuAssertTrue(tc, len < 1024);
+  CuAssertIntEquals(tc, PROTOCOL_ERROR_BUFFER_FULL,
+                    (int)ProtocolInput(&client.d, in, (int)len, out));
+
+  free(line);
+  deflateEnd(&z);
+  mccp_peer_close(&client);
+#else
+  (void)tc;
+#endif
+}
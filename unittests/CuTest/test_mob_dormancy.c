@@ -0,0 +1,271 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/graph.h"
+#include "../../src/perfmon.h"
+#include "../../src/zone_presence.h"
+#include "../../src/mob/mob_act.h"
+
+#include <string.h>
+
+#define DORMANCY_TEST_ZONES 6 /* A chain 0-1-2-3-4, and 5 on its own */
+#define DORMANCY_TEST_MOBS 8
+
+struct dormancy_fixture
+{
+  struct zone_data *zones;
+  struct room_data *rooms;
+  struct room_direction_data *exits;
+  struct char_data player, mobs[DORMANCY_TEST_MOBS];
+  struct player_special_data player_specials;
+  struct descriptor_data desc;
+  struct index_data mob_index_entry;
+  int zone_count;
+  struct zone_data *saved_zone_table;
+  zone_rnum saved_top_of_zone_table;
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  struct char_data *saved_character_list;
+  struct descriptor_data *saved_descriptor_list;
+  struct index_data *saved_mob_index;
+  mob_rnum saved_top_of_mobt;
+  int saved_ring, saved_cadence;
+};
+
+/* One room per zone, each joined east to the next but the last, which
+ * stands alone. The player starts nowhere. */
+static void begin_dormancy_fixture(struct dormancy_fixture *fixture, int zone_count)
+{
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_zone_table = zone_table;
+  fixture->saved_top_of_zone_table = top_of_zone_table;
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  fixture->saved_character_list = character_list;
+  fixture->saved_descriptor_list = descriptor_list;
+  fixture->saved_mob_index = mob_index;
+  fixture->saved_top_of_mobt = top_of_mobt;
+  fixture->saved_ring = CONFIG_MOB_ACTIVE_RING;
+  fixture->saved_cadence = CONFIG_MOB_DORMANT_CADENCE;
+
+  fixture->zone_count = zone_count;
+  CREATE(fixture->zones, struct zone_data, zone_count);
+  CREATE(fixture->rooms, struct room_data, zone_count);
+  CREATE(fixture->exits, struct room_direction_data, 2 * zone_count);
+  for (i = 0; i < zone_count; i++)
+  {
+    fixture->zones[i].number = i;
+    fixture->rooms[i].number = i * 100;
+    fixture->rooms[i].zone = i;
+  }
+  for (i = 0; i + 2 < zone_count; i++)
+  {
+    fixture->exits[2 * i].to_room = i + 1;
+    fixture->rooms[i].dir_option[EAST] = &fixture->exits[2 * i];
+    fixture->exits[2 * i + 1].to_room = i;
+    fixture->rooms[i + 1].dir_option[WEST] = &fixture->exits[2 * i + 1];
+  }
+
+  zone_table = fixture->zones;
+  top_of_zone_table = zone_count - 1;
+  world = fixture->rooms;
+  top_of_world = zone_count - 1;
+  mob_index = &fixture->mob_index_entry;
+  top_of_mobt = 0;
+  character_list = NULL;
+  descriptor_list = &fixture->desc;
+  mobile_activity_reset();
+
+  fixture->player.player_specials = &fixture->player_specials;
+  fixture->player.player.level = 1;
+  fixture->player.desc = &fixture->desc;
+  IN_ROOM(&fixture->player) = NOWHERE;
+  fixture->desc.character = &fixture->player;
+  STATE(&fixture->desc) = CON_PLAYING;
+
+  for (i = 0; i < DORMANCY_TEST_MOBS; i++)
+  {
+    SET_BIT_AR(MOB_FLAGS(&fixture->mobs[i]), MOB_ISNPC);
+    SET_BIT_AR(MOB_FLAGS(&fixture->mobs[i]), MOB_NO_AI);
+    fixture->mobs[i].player_specials = &dummy_mob;
+    fixture->mobs[i].nr = 0;
+    IN_ROOM(&fixture->mobs[i]) = NOWHERE;
+  }
+}
+
+static void end_dormancy_fixture(struct dormancy_fixture *fixture)
+{
+  if (IN_ROOM(&fixture->player) != NOWHERE)
+    zone_presence_leave(&fixture->player);
+  mobile_activity_reset();
+  zone_table = fixture->saved_zone_table;
+  top_of_zone_table = fixture->saved_top_of_zone_table;
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  character_list = fixture->saved_character_list;
+  descriptor_list = fixture->saved_descriptor_list;
+  mob_index = fixture->saved_mob_index;
+  top_of_mobt = fixture->saved_top_of_mobt;
+  CONFIG_MOB_ACTIVE_RING = fixture->saved_ring;
+  CONFIG_MOB_DORMANT_CADENCE = fixture->saved_cadence;
+  free(fixture->zones);
+  free(fixture->rooms);
+  free(fixture->exits);
+}
+
+static void dormancy_move_player(struct dormancy_fixture *fixture, room_rnum room)
+{
+  if (IN_ROOM(&fixture->player) != NOWHERE)
+    zone_presence_leave(&fixture->player);
+  IN_ROOM(&fixture->player) = room;
+  zone_presence_update(&fixture->player);
+}
+
+void Test_mob_dormancy_tiers_follow_players_and_ring(CuTest *tc)
+{
+  struct dormancy_fixture fixture;
+
+  begin_dormancy_fixture(&fixture, DORMANCY_TEST_ZONES);
+  CONFIG_MOB_ACTIVE_RING = 1;
+
+  /* Nobody about: every zone sleeps. */
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(0));
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(5));
+
+  dormancy_move_player(&fixture, 2);
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(0));
+  CuAssertIntEquals(tc, MOB_TIER_NEARBY, mob_dormancy_zone_tier(1));
+  CuAssertIntEquals(tc, MOB_TIER_OCCUPIED, mob_dormancy_zone_tier(2));
+  CuAssertIntEquals(tc, MOB_TIER_NEARBY, mob_dormancy_zone_tier(3));
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(4));
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(5));
+
+  /* A wider ring reaches further, but never across a missing exit. */
+  CONFIG_MOB_ACTIVE_RING = 3;
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_NEARBY, mob_dormancy_zone_tier(0));
+  CuAssertIntEquals(tc, MOB_TIER_NEARBY, mob_dormancy_zone_tier(4));
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(5));
+
+  /* New exits count once graph_exits_changed() says so. */
+  fixture.exits[2 * (DORMANCY_TEST_ZONES - 2)].to_room = 5;
+  fixture.rooms[4].dir_option[EAST] = &fixture.exits[2 * (DORMANCY_TEST_ZONES - 2)];
+  graph_exits_changed();
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_NEARBY, mob_dormancy_zone_tier(5));
+  CONFIG_MOB_ACTIVE_RING = 2;
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(5));
+
+  /* A nohassle immortal still wakes the zone, and link loss puts it back
+   * to sleep. */
+  CONFIG_MOB_ACTIVE_RING = 0;
+  fixture.player.player.level = LVL_IMMORT;
+  SET_BIT_AR(PRF_FLAGS(&fixture.player), PRF_NOHASSLE);
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_OCCUPIED, mob_dormancy_zone_tier(2));
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(1));
+  STATE(&fixture.desc) = CON_CLOSE;
+  mob_dormancy_begin_cycle();
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_zone_tier(2));
+
+  /* A zone table that changed under the cycle is not guessed at. */
+  top_of_zone_table--;
+  CuAssertIntEquals(tc, MOB_TIER_ALWAYS, mob_dormancy_zone_tier(2));
+  top_of_zone_table++;
+
+  end_dormancy_fixture(&fixture);
+}
+
+void Test_mob_dormancy_exceptions_and_cadence(CuTest *tc)
+{
+  struct dormancy_fixture fixture;
+  struct char_data *mob;
+  int i, cycle, acted[DORMANCY_TEST_MOBS] = {0};
+
+  begin_dormancy_fixture(&fixture, DORMANCY_TEST_ZONES);
+  CONFIG_MOB_ACTIVE_RING = 1;
+  mob_dormancy_begin_cycle();
+  mob = &fixture.mobs[0];
+  IN_ROOM(mob) = 5;
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_tier(mob));
+
+  /* Busy mobiles stay on wherever they are. */
+  FIGHTING(mob) = &fixture.mobs[1];
+  CuAssertIntEquals(tc, MOB_TIER_ALWAYS, mob_dormancy_tier(mob));
+  FIGHTING(mob) = NULL;
+  HUNTING(mob) = &fixture.player;
+  CuAssertIntEquals(tc, MOB_TIER_ALWAYS, mob_dormancy_tier(mob));
+  HUNTING(mob) = NULL;
+  SET_BIT_AR(MOB_FLAGS(mob), MOB_HUNTER);
+  CuAssertIntEquals(tc, MOB_TIER_ALWAYS, mob_dormancy_tier(mob));
+  REMOVE_BIT_AR(MOB_FLAGS(mob), MOB_HUNTER);
+  mob->master = &fixture.player;
+  CuAssertIntEquals(tc, MOB_TIER_ALWAYS, mob_dormancy_tier(mob));
+  mob->master = NULL;
+  fixture.rooms[5].ship = (struct greyhawk_ship_data *)&fixture; /* Only tested against NULL */
+  CuAssertIntEquals(tc, MOB_TIER_ALWAYS, mob_dormancy_tier(mob));
+  fixture.rooms[5].ship = NULL;
+  CuAssertIntEquals(tc, MOB_TIER_DORMANT, mob_dormancy_tier(mob));
+
+  /* Off, never, and one cycle in four with every mobile getting its turn. */
+  CONFIG_MOB_DORMANT_CADENCE = 0;
+  CuAssertTrue(tc, mob_dormancy_should_act(mob, MOB_TIER_DORMANT));
+  CONFIG_MOB_DORMANT_CADENCE = -1;
+  CuAssertTrue(tc, !mob_dormancy_should_act(mob, MOB_TIER_DORMANT));
+  CuAssertTrue(tc, mob_dormancy_should_act(mob, MOB_TIER_NEARBY));
+  CONFIG_MOB_DORMANT_CADENCE = 4;
+  for (cycle = 0; cycle < 8; cycle++)
+  {
+    mob_dormancy_begin_cycle();
+    for (i = 0; i < DORMANCY_TEST_MOBS; i++)
+      acted[i] += mob_dormancy_should_act(&fixture.mobs[i], MOB_TIER_DORMANT);
+  }
+  for (i = 0; i < DORMANCY_TEST_MOBS; i++)
+    CuAssertIntEquals(tc, 2, acted[i]);
+
+  end_dormancy_fixture(&fixture);
+}
+
+void Test_mob_dormancy_scheduler_counts_tiers(CuTest *tc)
+{
+  struct dormancy_fixture fixture;
+  char report[8192];
+  int i;
+
+  begin_dormancy_fixture(&fixture, DORMANCY_TEST_ZONES);
+  CONFIG_MOB_ACTIVE_RING = 1;
+  CONFIG_MOB_DORMANT_CADENCE = -1;
+  dormancy_move_player(&fixture, 0);
+
+  /* Two mobiles with the player, two next door, four asleep. */
+  for (i = DORMANCY_TEST_MOBS - 1; i >= 0; i--)
+  {
+    IN_ROOM(&fixture.mobs[i]) = i < 2 ? 0 : (i < 4 ? 1 : 5);
+    fixture.mobs[i].next = character_list;
+    character_list = &fixture.mobs[i];
+  }
+
+  PERF_reset();
+  mobile_activity();
+  PERF_repr(report, sizeof(report));
+  CuAssertPtrNotNull(tc, strstr(report, "occupied=2/2 nearby=2/2 dormant=4/0"));
+
+  /* The sliced scheduler sees the same mobiles over one cycle. */
+  PERF_reset();
+  for (i = 0; i < PULSE_MOBILE; i++)
+    mobile_activity_pulse(i);
+  PERF_repr(report, sizeof(report));
+  CuAssertPtrNotNull(tc, strstr(report, "occupied=2/2 nearby=2/2 dormant=4/0"));
+
+  end_dormancy_fixture(&fixture);
+}
@@ -6,6 +6,7 @@
 #include "../../src/utils.h"
 #include "../../src/comm.h"
 #include "../../src/mysql.h"
+#include "../../src/perfmon.h"
 #include "../../src/wilderness/wilderness.h"
 
 #include <string.h>
@@ -212,3 +213,99 @@ void TestMsdpMapStateChangesDirtyOnlyReportedMaps(CuTest *tc)
   descriptor_list = old_descriptor_list;
   ProtocolDestroy(descriptor.pProtocol);
 }
+
+void TestMsdpMarkDirtyAccumulatesOnDescriptor(CuTest *tc)
+{
+  struct descriptor_data descriptor;
+  struct char_data *ch;
+
+  memset(&descriptor, 0, sizeof(descriptor));
+  CREATE(ch, struct char_data, 1);
+
+  /* A character without a connection has nothing to mark. */
+  msdp_mark_dirty(ch, MSDP_DIRTY_AFFECTS);
+  msdp_mark_dirty(NULL, MSDP_DIRTY_AFFECTS);
+
+  ch->desc = &descriptor;
+  msdp_mark_dirty(ch, MSDP_DIRTY_AFFECTS);
+  msdp_mark_dirty(ch, MSDP_DIRTY_INVENTORY);
+  CuAssertIntEquals(tc, MSDP_DIRTY_AFFECTS | MSDP_DIRTY_INVENTORY, descriptor.msdp_dirty);
+
+  free(ch);
+}
+
+void TestMsdpUpdateSkipsClientsWithoutMsdp(CuTest *tc)
+{
+  struct descriptor_data descriptor, *saved_list = descriptor_list;
+  struct char_data *ch;
+
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.pProtocol = ProtocolCreate();
+  descriptor.connected = CON_PLAYING;
+  CREATE(ch, struct char_data, 1);
+  ch->desc = &descriptor;
+  descriptor.character = ch;
+  msdp_mark_dirty(ch, MSDP_DIRTY_GROUP);
+
+  /* A plain telnet client: its marks are left alone and nothing is built. */
+  descriptor_list = &descriptor;
+  comm_test_msdp_update();
+  descriptor_list = saved_list;
+
+  CuAssertIntEquals(tc, MSDP_DIRTY_GROUP, descriptor.msdp_dirty);
+  CuAssertPtrEquals(tc, NULL, descriptor.msdp_character);
+  CuAssertTrue(tc, !descriptor.pProtocol->pVariables[eMSDP_HEALTH]->bDirty);
+
+  free(ch);
+  ProtocolDestroy(descriptor.pProtocol);
+}
+
+void TestMsdpUpdateCountsOnlyChangedVariables(CuTest *tc)
+{
+  struct descriptor_data descriptor;
+  uint64_t before = PERF_msdp_emit_count(eMSDP_HEALTH);
+
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.output = descriptor.small_outbuf;
+  descriptor.bufspace = SMALL_BUFSIZE - 1;
+  descriptor.pProtocol = ProtocolCreate();
+  descriptor.pProtocol->bMSDP = true;
+  descriptor.pProtocol->pVariables[eMSDP_HEALTH]->bReport = true;
+
+  MSDPSetNumber(&descriptor, eMSDP_HEALTH, 42);
+  CuAssertIntEquals(tc, PROTOCOL_SUCCESS, MSDPUpdate(&descriptor));
+  CuAssertTrue(tc, PERF_msdp_emit_count(eMSDP_HEALTH) == before + 1);
+  CuAssertPtrNotNull(tc, strstr(descriptor.output, "HEALTH"));
+
+  /* Setting the same value again sends nothing. */
+  MSDPSetNumber(&descriptor, eMSDP_HEALTH, 42);
+  CuAssertIntEquals(tc, PROTOCOL_SUCCESS, MSDPUpdate(&descriptor));
+  CuAssertTrue(tc, PERF_msdp_emit_count(eMSDP_HEALTH) == before + 1);
+
+  ProtocolDestroy(descriptor.pProtocol);
+}
+
+void TestMsdpStatusFingerprintFollowsTitleText(CuTest *tc)
+{
+  struct char_data *ch;
+  char title[32] = "the Novice";
+  char *copy;
+  unsigned long before;
+
+  CREATE(ch, struct char_data, 1);
+  ch->player.name = "Tester";
+  ch->player.title = title;
+  before = comm_test_msdp_status_fingerprint(ch);
+
+  /* The same text somewhere else is no change ... */
+  copy = strdup(title);
+  ch->player.title = copy;
+  CuAssertTrue(tc, comm_test_msdp_status_fingerprint(ch) == before);
+
+  /* ... but new text in the same buffer is. */
+  strlcpy(copy, "the Adept", strlen(copy) + 1);
+  CuAssertTrue(tc, comm_test_msdp_status_fingerprint(ch) != before);
+
+  free(copy);
+  free(ch);
+}
@@ -0,0 +1,210 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/perfmon.h"
+#include "../../src/net/netpoll.h"
+#include "test.helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#define NETPOLL_BENCH_SOCKETS 4000
+#define NETPOLL_BENCH_ACTIVE 16
+#define NETPOLL_BENCH_PULSES 500
+
+static const enum netpoll_backend netpoll_test_backends[] = {NETPOLL_EPOLL, NETPOLL_SELECT};
+
+/* The event reported for fd by the last wait, if any. */
+static const struct netpoll_event *netpoll_test_event(struct netpoll_event *events, int count,
+                                                      socket_t fd)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    if (events[i].fd == fd)
+      return &events[i];
+  return NULL;
+}
+
+void Test_netpoll_reports_ready_sockets(CuTest *tc)
+{
+  struct netpoll_event *events;
+  const struct netpoll_event *ev;
+  int quiet[2], talky[2], full[2], bridge[2];
+  int owner_quiet, owner_talky, owner_full;
+  socket_t watched = -1;
+  size_t b;
+  int count;
+
+  for (b = 0; b < sizeof(netpoll_test_backends) / sizeof(netpoll_test_backends[0]); b++)
+  {
+    if (!netpoll_init(netpoll_test_backends[b]))
+      continue;
+    CuAssertIntEquals(tc, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, quiet));
+    CuAssertIntEquals(tc, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, talky));
+    CuAssertIntEquals(tc, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, full));
+    CuAssertIntEquals(tc, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, bridge));
+    CuAssertTrue(tc, netpoll_add(quiet[0], &owner_quiet));
+    CuAssertTrue(tc, netpoll_add(talky[0], &owner_talky));
+    CuAssertTrue(tc, netpoll_add(full[0], &owner_full));
+
+    /* Idle sockets, writable or not, are not reported. */
+    CuAssertIntEquals(tc, 0, netpoll_wait(0, &events));
+
+    CuAssertIntEquals(tc, 1, (int)write(talky[1], "x", 1));
+    CuAssertIntEquals(tc, 1, netpoll_wait(0, &events));
+    CuAssertIntEquals(tc, talky[0], events[0].fd);
+    CuAssertPtrEquals(tc, &owner_talky, events[0].owner);
+    CuAssertIntEquals(tc, NETPOLL_READ, events[0].ready);
+    CuAssertIntEquals(tc, NETPOLL_READ, netpoll_ready(talky[0]));
+    CuAssertIntEquals(tc, 0, netpoll_ready(quiet[0]));
+
+    /* Write interest is reported until it is dropped. */
+    netpoll_want_write(full[0], TRUE);
+    CuAssertTrue(tc, netpoll_waiting_write(full[0]));
+    count = netpoll_wait(0, &events);
+    CuAssertIntEquals(tc, 2, count);
+    ev = netpoll_test_event(events, count, full[0]);
+    CuAssertPtrNotNull(tc, ev);
+    CuAssertIntEquals(tc, NETPOLL_WRITE, ev->ready);
+    netpoll_want_write(full[0], FALSE);
+    CuAssertTrue(tc, !netpoll_waiting_write(full[0]));
+
+    /* Removing a socket drops the event the last wait gave it. */
+    count = netpoll_wait(0, &events);
+    CuAssertIntEquals(tc, 1, count);
+    netpoll_remove(talky[0]);
+    CuAssertIntEquals(tc, 0, events[0].ready);
+    CuAssertIntEquals(tc, 0, netpoll_ready(talky[0]));
+
+    /* A peer hanging up reads as input, so the read finds the EOF. */
+    close(quiet[1]);
+    count = netpoll_wait(0, &events);
+    ev = netpoll_test_event(events, count, quiet[0]);
+    CuAssertPtrNotNull(tc, ev);
+    CuAssertTrue(tc, ev->ready & NETPOLL_READ);
+
+    /* A followed socket is swapped and dropped, but never one a descriptor
+     * has taken over. */
+    netpoll_follow(&watched, bridge[0]);
+    CuAssertIntEquals(tc, bridge[0], watched);
+    CuAssertIntEquals(tc, 1, (int)write(bridge[1], "y", 1));
+    count = netpoll_wait(0, &events);
+    CuAssertPtrNotNull(tc, netpoll_test_event(events, count, bridge[0]));
+    netpoll_follow(&watched, -1);
+    CuAssertIntEquals(tc, -1, watched);
+    count = netpoll_wait(0, &events);
+    CuAssertPtrEquals(tc, NULL, (void *)netpoll_test_event(events, count, bridge[0]));
+    netpoll_follow(&watched, bridge[0]);
+    CuAssertTrue(tc, netpoll_add(bridge[0], &owner_full));
+    netpoll_follow(&watched, -1);
+    count = netpoll_wait(0, &events);
+    ev = netpoll_test_event(events, count, bridge[0]);
+    CuAssertPtrNotNull(tc, ev);
+    CuAssertPtrEquals(tc, &owner_full, ev->owner);
+
+    netpoll_shutdown();
+    CuAssertStrEquals(tc, "none", netpoll_backend_name());
+    close(quiet[0]);
+    close(talky[0]);
+    close(talky[1]);
+    close(full[0]);
+    close(full[1]);
+    close(bridge[0]);
+    close(bridge[1]);
+  }
+}
+
+/* Run pulses over the first count socket pairs (fds 2i and 2i + 1),
+ * NETPOLL_BENCH_ACTIVE of them sending a byte each pulse, and return the
+ * average usec per pulse. */
+static double netpoll_bench_pulses(CuTest *tc, enum netpoll_backend backend, int *pairs,
+                                   int count)
+{
+  struct netpoll_event *events;
+  uint64_t start, total = 0;
+  char byte;
+  int pulse, i, ready;
+
+  CuAssertTrue(tc, netpoll_init(backend));
+  for (i = 0; i < count; i++)
+    CuAssertTrue(tc, netpoll_add(pairs[2 * i], &pairs[2 * i]));
+
+  for (pulse = 0; pulse < NETPOLL_BENCH_PULSES; pulse++)
+  {
+    for (i = 0; i < NETPOLL_BENCH_ACTIVE; i++)
+      CuAssertIntEquals(tc, 1, (int)write(pairs[2 * ((pulse * 37 + i * 97) % count) + 1], "x", 1));
+
+    start = PERF_monotonic_usec();
+    ready = netpoll_wait(0, &events);
+    for (i = 0; i < ready; i++)
+      if (events[i].ready & NETPOLL_READ)
+        CuAssertIntEquals(tc, 1, (int)read(*(int *)events[i].owner, &byte, 1));
+    total += PERF_monotonic_usec() - start;
+    CuAssertIntEquals(tc, NETPOLL_BENCH_ACTIVE, ready);
+  }
+
+  netpoll_shutdown();
+  return (double)total / NETPOLL_BENCH_PULSES;
+}
+
+void Test_netpoll_pulse_overhead_benchmark(CuTest *tc)
+{
+  struct rlimit saved, raised;
+  int *pairs;
+  int opened = 0, wanted, low = 0, i;
+  double epoll_all = 0.0, epoll_low = 0.0, select_low;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  CuAssertIntEquals(tc, 0, getrlimit(RLIMIT_NOFILE, &saved));
+  raised = saved;
+  if (raised.rlim_max == RLIM_INFINITY || raised.rlim_max > 2 * NETPOLL_BENCH_SOCKETS + 256)
+    raised.rlim_cur = 2 * NETPOLL_BENCH_SOCKETS + 256;
+  else
+    raised.rlim_cur = raised.rlim_max;
+  if (raised.rlim_cur > saved.rlim_cur)
+    setrlimit(RLIMIT_NOFILE, &raised);
+  getrlimit(RLIMIT_NOFILE, &raised);
+  wanted = (int)MIN((rlim_t)NETPOLL_BENCH_SOCKETS, (raised.rlim_cur - 128) / 2);
+
+  CREATE(pairs, int, 2 * NETPOLL_BENCH_SOCKETS);
+  for (opened = 0; opened < wanted; opened++)
+  {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, &pairs[2 * opened]) < 0)
+      break;
+    /* The pairs select() can take come first. */
+    if (pairs[2 * opened + 1] < FD_SETSIZE)
+      low = opened + 1;
+  }
+  CuAssertTrue(tc, low >= 2 * NETPOLL_BENCH_ACTIVE);
+
+  /* Against as many sockets as select() can take, then all of them. */
+  select_low = netpoll_bench_pulses(tc, NETPOLL_SELECT, pairs, low);
+  if (netpoll_init(NETPOLL_EPOLL))
+  {
+    epoll_low = netpoll_bench_pulses(tc, NETPOLL_EPOLL, pairs, low);
+    epoll_all = netpoll_bench_pulses(tc, NETPOLL_EPOLL, pairs, opened);
+  }
+
+  log("BENCHMARK: network poll, %d active per pulse: select %.1f usec/pulse and epoll %.1f "
+      "over %d sockets, epoll %.1f over %d",
+      NETPOLL_BENCH_ACTIVE, select_low, epoll_low, low, epoll_all, opened);
+
+  for (i = 0; i < opened; i++)
+  {
+    close(pairs[2 * i]);
+    close(pairs[2 * i + 1]);
+  }
+  free(pairs);
+  setrlimit(RLIMIT_NOFILE, &saved);
+}
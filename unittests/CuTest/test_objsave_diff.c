@@ -0,0 +1,295 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/handler.h"
+#include "../../src/mysql.h"
+#include "../../src/perfmon.h"
+#include "../../src/character/feats.h"
+#include "../../src/combat/assign_wpn_armor.h"
+#include "../../src/olc/oasis.h"
+#include "../../src/obj/objsave.h"
+#include "test.helpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Prototypes covering each adjustment read_object() makes to a fresh copy:
+ * weapon dice caps, untyped affects, instruments, and set-stats-at-load
+ * weapons and armor. */
+#define OBJDIFF_PROTO_COUNT 6
+#define OBJDIFF_BASE_VNUM 169800
+#define OBJDIFF_OBJECT_COUNT (2 * OBJDIFF_PROTO_COUNT + 1)
+#define OBJDIFF_BENCH_SAVES 20000
+
+struct objdiff_fixture
+{
+  struct index_data indexes[OBJDIFF_PROTO_COUNT];
+  struct obj_data protos[OBJDIFF_PROTO_COUNT];
+  struct zone_data zones[1];
+  struct index_data *saved_obj_index;
+  struct obj_data *saved_obj_proto;
+  obj_rnum saved_top_of_objt;
+  struct zone_data *saved_zone_table;
+  zone_rnum saved_top_of_zone_table;
+};
+
+static void objdiff_proto(struct objdiff_fixture *fixture, int i, int type)
+{
+  struct obj_data *proto = &fixture->protos[i];
+
+  fixture->indexes[i].vnum = OBJDIFF_BASE_VNUM + i;
+  clear_object(proto);
+  GET_OBJ_RNUM(proto) = i;
+  proto->name = (char *)"diff test";
+  proto->short_description = (char *)"a diff test object";
+  proto->description = (char *)"A diff test object lies here.";
+  GET_OBJ_TYPE(proto) = type;
+  GET_OBJ_WEIGHT(proto) = 3;
+  GET_OBJ_COST(proto) = 250;
+  GET_OBJ_LEVEL(proto) = 5;
+  SET_BIT_AR(GET_OBJ_WEAR(proto), ITEM_WEAR_TAKE);
+}
+
+static void objdiff_begin(struct objdiff_fixture *fixture)
+{
+  memset(fixture, 0, sizeof(*fixture));
+  if (weapon_list[WEAPON_TYPE_LONG_SWORD].name == NULL)
+  {
+    load_weapons();
+    load_armor();
+  }
+
+  fixture->saved_obj_index = obj_index;
+  fixture->saved_obj_proto = obj_proto;
+  fixture->saved_top_of_objt = top_of_objt;
+  fixture->saved_zone_table = zone_table;
+  fixture->saved_top_of_zone_table = top_of_zone_table;
+
+  objdiff_proto(fixture, 0, ITEM_TRASH);
+
+  /* Dice past the caps, and an affect with no bonus type. */
+  objdiff_proto(fixture, 1, ITEM_WEAPON);
+  GET_OBJ_VAL(&fixture->protos[1], 0) = WEAPON_TYPE_LONG_SWORD;
+  GET_OBJ_VAL(&fixture->protos[1], 1) = MAX_WEAPON_NDICE + 20;
+  GET_OBJ_VAL(&fixture->protos[1], 2) = MAX_WEAPON_SDICE + 20;
+  fixture->protos[1].affected[0].location = APPLY_STR;
+  fixture->protos[1].affected[0].modifier = 2;
+  fixture->protos[1].affected[0].bonus_type = BONUS_TYPE_UNDEFINED;
+
+  objdiff_proto(fixture, 2, ITEM_INSTRUMENT);
+
+  objdiff_proto(fixture, 3, ITEM_WEAPON);
+  SET_BIT_AR(GET_OBJ_EXTRA(&fixture->protos[3]), ITEM_SET_STATS_AT_LOAD);
+  GET_OBJ_VAL(&fixture->protos[3], 0) = WEAPON_TYPE_LONG_SWORD;
+  GET_OBJ_VAL(&fixture->protos[3], 4) = 2;
+  GET_OBJ_LEVEL(&fixture->protos[3]) = 45;
+
+  objdiff_proto(fixture, 4, ITEM_ARMOR);
+  SET_BIT_AR(GET_OBJ_EXTRA(&fixture->protos[4]), ITEM_SET_STATS_AT_LOAD);
+  GET_OBJ_VAL(&fixture->protos[4], 1) = SPEC_ARMOR_TYPE_CHAINMAIL;
+  GET_OBJ_VAL(&fixture->protos[4], 4) = 1;
+  GET_OBJ_COST(&fixture->protos[4]) = 80;
+
+  /* A spell value and affects whose specific is always written. */
+  objdiff_proto(fixture, 5, ITEM_POTION);
+  GET_OBJ_VAL(&fixture->protos[5], 1) = 7;
+  fixture->protos[5].affected[1].location = APPLY_HIT;
+  fixture->protos[5].affected[1].modifier = 10;
+  fixture->protos[5].affected[1].bonus_type = BONUS_TYPE_ENHANCEMENT;
+  fixture->protos[5].affected[2].location = APPLY_SKILL;
+  fixture->protos[5].affected[2].modifier = 1;
+  fixture->protos[5].affected[2].bonus_type = BONUS_TYPE_COMPETENCE;
+  fixture->protos[5].affected[2].specific = 4;
+
+  fixture->zones[0].number = 1698;
+  fixture->zones[0].bot = OBJDIFF_BASE_VNUM;
+  fixture->zones[0].top = OBJDIFF_BASE_VNUM + 99;
+
+  obj_index = fixture->indexes;
+  obj_proto = fixture->protos;
+  top_of_objt = OBJDIFF_PROTO_COUNT - 1;
+  zone_table = fixture->zones;
+  top_of_zone_table = 0;
+}
+
+static void objdiff_end(struct objdiff_fixture *fixture)
+{
+  obj_index = fixture->saved_obj_index;
+  obj_proto = fixture->saved_obj_proto;
+  top_of_objt = fixture->saved_top_of_objt;
+  zone_table = fixture->saved_zone_table;
+  top_of_zone_table = fixture->saved_top_of_zone_table;
+}
+
+/* One record as the rent file gets it.  There is no database here, so the
+ * INSERT is made to fail; the record is already in the file by then. */
+static void objdiff_save(struct obj_data *obj, FILE *fp)
+{
+  mysql_test_fail_nth_query(1);
+  objsave_save_obj_record(obj, NULL, fp, 0);
+  mysql_test_clear_query_failure();
+}
+
+static char *objdiff_read_back(FILE *fp)
+{
+  long length = ftell(fp);
+  char *text;
+
+  CREATE(text, char, length + 1);
+  rewind(fp);
+  if (fread(text, 1, (size_t)length, fp) != (size_t)length)
+    *text = '\0';
+  return text;
+}
+
+/* Every prototype fresh from read_object(), then each with a few fields
+ * changed, then an object with no prototype at all: the records the save
+ * wrote back when it loaded a scratch copy of the prototype to diff with. */
+static const char objdiff_expected[] =
+    "#169800\nFlag: 0 0 0 0\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 1 0 0 0\n\n"
+    "#169801\nFlag: 0 0 0 0\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 1 0 0 0\n\n"
+    "#169802\nFlag: 0 0 0 0\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 1048577 0 0 0\n\n"
+    "#169803\nFlag: 0 0 0 4\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 8193 0 0 0\n\n"
+    "#169804\nFlag: 0 0 0 4\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 9 0 0 0\n\n"
+    "#169805\nFlag: 0 0 0 0\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 1 0 0 0\n"
+    "Aff : 2 50 1 4 4\n\n"
+    "#169800\nVals: 3 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\nFlag: 0 0 0 0\n"
+    "Shrt: a changed diff test object\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\nWear: 1 0 0 0\n"
+    "Aff : 3 2 0 0 0\n\n"
+    "#169801\nVals: 26 5 12 0 0 0 0 0 0 0 0 0 0 0 0 0\nFlag: 0 0 0 0\n"
+    "Shrt: a changed diff test object\nWght: 4\nLevl: 12\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\n"
+    "Wear: 1 0 0 0\nAff : 3 2 1 0 0\n\n"
+    "#169802\nVals: 0 0 3 0 0 0 0 0 0 0 0 0 0 0 0 0\nFlag: 0 0 0 0\n"
+    "Shrt: a changed diff test object\nWght: 5\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\n"
+    "Wear: 1048577 0 0 0\nAff : 3 2 2 0 0\n\n"
+    "#169803\nVals: 26 1 8 3 2 0 0 0 0 0 0 0 0 0 0 0\nFlag: 0 0 0 4\n"
+    "Shrt: a changed diff test object\nWght: 7\nLevl: 12\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\n"
+    "Wear: 8193 0 0 0\nAff : 3 2 3 0 0\n\n"
+    "#169804\nVals: 40 8 0 0 0 0 0 0 0 0 0 0 0 0 0 0\nFlag: 0 0 0 4\n"
+    "Shrt: a changed diff test object\nWght: 31\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\n"
+    "Wear: 9 0 0 0\nAff : 3 2 4 0 0\n\n"
+    "#169805\nVals: 0 10 0 0 0 0 0 0 0 0 0 0 0 0 0 0\nFlag: 0 0 0 0\n"
+    "Shrt: a changed diff test object\nWght: 8\nLevl: 12\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\n"
+    "Wear: 1 0 0 0\nAff : 2 50 1 4 4\nAff : 3 2 5 0 0\n\n"
+    "#-1\nFlag: 0 0 0 0\nName: loose object\nShrt: a loose object\n"
+    "Desc: A loose object lies here.\nType: 12\nWght: 1\nPerm: 0 0 0 0\nPrm2: 0 0 0 0\n"
+    "Wear: 0 0 0 0\n\n";
+
+/* Every prototype as it loads, then with a few fields changed, then an
+ * object with no prototype; returns how many went into objs. */
+static int objdiff_make_objects(struct obj_data **objs)
+{
+  int i, count = 0;
+
+  for (i = 0; i < OBJDIFF_PROTO_COUNT; i++)
+    objs[count++] = read_object(i, REAL);
+  for (i = 0; i < OBJDIFF_PROTO_COUNT; i++)
+  {
+    objs[count] = read_object(i, REAL);
+    GET_OBJ_VAL(objs[count], i % 4) += 3;
+    GET_OBJ_WEIGHT(objs[count]) += i;
+    if (i % 2)
+      GET_OBJ_LEVEL(objs[count]) = 12;
+    objs[count]->affected[3].location = APPLY_DEX;
+    objs[count]->affected[3].modifier = i;
+    objs[count]->short_description = strdup("a changed diff test object");
+    count++;
+  }
+  objs[count] = create_obj();
+  objs[count]->name = strdup("loose object");
+  objs[count]->short_description = strdup("a loose object");
+  objs[count]->description = strdup("A loose object lies here.");
+  GET_OBJ_TYPE(objs[count]) = ITEM_OTHER;
+  GET_OBJ_WEIGHT(objs[count]) = 1;
+  return count + 1;
+}
+
+void Test_objsave_diff_output_unchanged(CuTest *tc)
+{
+  struct objdiff_fixture fixture;
+  struct obj_data *objs[OBJDIFF_OBJECT_COUNT];
+  uint64_t created_before, created_after, unused;
+  int i, count;
+  FILE *fp;
+  char *text;
+
+  objdiff_begin(&fixture);
+  fp = tmpfile();
+  CuAssertPtrNotNull(tc, fp);
+  count = objdiff_make_objects(objs);
+
+  /* The prototype is compared in place; no object is made to diff with. */
+  PERF_entity_totals(&unused, &unused, &created_before, &unused);
+  for (i = 0; i < count; i++)
+    objdiff_save(objs[i], fp);
+  PERF_entity_totals(&unused, &unused, &created_after, &unused);
+  CuAssertTrue(tc, created_before == created_after);
+  CuAssertPtrEquals(tc, objs[count - 1], object_list);
+
+  text = objdiff_read_back(fp);
+  CuAssertStrEquals(tc, objdiff_expected, text);
+
+  free(text);
+  fclose(fp);
+  for (i = 0; i < count; i++)
+    extract_obj(objs[i]);
+  objdiff_end(&fixture);
+}
+
+void Test_objsave_diff_benchmark(CuTest *tc)
+{
+  struct objdiff_fixture fixture;
+  struct obj_data *objs[OBJDIFF_OBJECT_COUNT];
+  uint64_t start, save_usec, copy_usec;
+  int i, count;
+  FILE *fp, *saved_logfile = logfile;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  objdiff_begin(&fixture);
+  fp = tmpfile();
+  CuAssertPtrNotNull(tc, fp);
+  count = objdiff_make_objects(objs);
+
+  /* Each failed INSERT logs a SYSERR, which would swamp the timing. */
+  logfile = fopen("/dev/null", "w");
+  start = PERF_monotonic_usec();
+  for (i = 0; i < OBJDIFF_BENCH_SAVES; i++)
+  {
+    if (i % count == 0)
+      rewind(fp);
+    objdiff_save(objs[i % count], fp);
+  }
+  save_usec = PERF_monotonic_usec() - start;
+  if (logfile)
+    fclose(logfile);
+  logfile = saved_logfile;
+
+  /* What each record used to cost on top: a scratch copy of its prototype. */
+  start = PERF_monotonic_usec();
+  for (i = 0; i < OBJDIFF_BENCH_SAVES; i++)
+    extract_obj(read_object(i % OBJDIFF_PROTO_COUNT, REAL));
+  copy_usec = PERF_monotonic_usec() - start;
+
+  CuAssertTrue(tc, ftell(fp) > 0);
+  log("BENCHMARK: object save, %d records: %llu usec (%.0f records/sec); a read_object() and "
+      "extract_obj() per record adds %llu usec",
+      OBJDIFF_BENCH_SAVES, (unsigned long long)save_usec,
+      save_usec ? OBJDIFF_BENCH_SAVES * 1000000.0 / save_usec : 0.0,
+      (unsigned long long)copy_usec);
+
+  fclose(fp);
+  for (i = 0; i < count; i++)
+    extract_obj(objs[i]);
+  objdiff_end(&fixture);
+}
@@ -0,0 +1,313 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/db.h"
+#include "../../src/handler.h"
+#include "../../src/mysql.h"
+#include "../../src/perfmon.h"
+#include "../../src/obj/house.h"
+#include "../../src/obj/objsave.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INCSAVE_HOUSE_VNUM 169900
+
+/* A player with something worn, a bag in their inventory and a gem in the
+ * bag, saving into a scratch lib directory with every query accepted and
+ * written down instead of sent. */
+struct incsave_fixture
+{
+  char oldcwd[PATH_MAX];
+  char dir[64];
+  char transcript[65536];
+  struct char_data ch;
+  struct player_special_data specials;
+  struct bag_data bags;
+  struct obj_data *worn, *bag, *gem;
+};
+
+static struct obj_data *incsave_object(const char *short_description, int weight)
+{
+  struct obj_data *obj = create_obj();
+
+  obj->name = strdup("incremental test");
+  obj->short_description = strdup(short_description);
+  obj->description = strdup("An incremental test object lies here.");
+  GET_OBJ_TYPE(obj) = ITEM_OTHER;
+  GET_OBJ_WEIGHT(obj) = weight;
+  return obj;
+}
+
+static void incsave_put(struct obj_data *obj, struct obj_data *container)
+{
+  obj->in_obj = container;
+  obj->next_content = container->contains;
+  container->contains = obj;
+}
+
+static int incsave_begin(struct incsave_fixture *fixture)
+{
+  char path[PATH_MAX];
+
+  memset(fixture, 0, sizeof(*fixture));
+  strlcpy(fixture->dir, "/tmp/luminari_incsave_XXXXXX", sizeof(fixture->dir));
+  if (!getcwd(fixture->oldcwd, sizeof(fixture->oldcwd)) || !mkdtemp(fixture->dir))
+    return FALSE;
+  snprintf(path, sizeof(path), "%s/plrobjs", fixture->dir);
+  mkdir(path, 0700);
+  snprintf(path, sizeof(path), "%s/plrobjs/A-E", fixture->dir);
+  mkdir(path, 0700);
+  snprintf(path, sizeof(path), "%s/house", fixture->dir);
+  mkdir(path, 0700);
+  if (chdir(fixture->dir) != 0)
+    return FALSE;
+
+  fixture->ch.player_specials = &fixture->specials;
+  fixture->ch.bags = &fixture->bags;
+  fixture->ch.player.name = (char *)"Ebbie";
+
+  fixture->worn = incsave_object("a worn test cloak", 4);
+  fixture->worn->worn_by = &fixture->ch;
+  fixture->ch.equipment[WEAR_ABOUT] = fixture->worn;
+  fixture->bag = incsave_object("a test bag", 7);
+  GET_OBJ_TYPE(fixture->bag) = ITEM_CONTAINER;
+  fixture->bag->carried_by = &fixture->ch;
+  fixture->ch.carrying = fixture->bag;
+  fixture->gem = incsave_object("a test gem", 2);
+  incsave_put(fixture->gem, fixture->bag);
+
+  mysql_test_accept_queries(TRUE, fixture->transcript, sizeof(fixture->transcript));
+  return TRUE;
+}
+
+static void incsave_extract(struct obj_data *obj)
+{
+  struct obj_data *next;
+
+  for (; obj != NULL; obj = next)
+  {
+    next = obj->next_content;
+    incsave_extract(obj->contains);
+    obj->contains = NULL;
+    obj->next_content = NULL;
+    obj->in_obj = NULL;
+    obj->carried_by = NULL;
+    obj->worn_by = NULL;
+    extract_obj(obj);
+  }
+}
+
+static void incsave_end(struct incsave_fixture *fixture)
+{
+  char path[PATH_MAX];
+
+  mysql_test_accept_queries(FALSE, NULL, 0);
+  mysql_test_clear_query_failure();
+  incsave_extract(fixture->ch.carrying);
+  incsave_extract(fixture->ch.equipment[WEAR_ABOUT]);
+  if (chdir(fixture->oldcwd) != 0)
+    fixture->oldcwd[0] = '\0';
+
+  snprintf(path, sizeof(path), "%s/plrobjs/A-E/ebbie.objs", fixture->dir);
+  remove(path);
+  snprintf(path, sizeof(path), "%s/house/%d.house", fixture->dir, INCSAVE_HOUSE_VNUM);
+  remove(path);
+  snprintf(path, sizeof(path), "%s/plrobjs/A-E", fixture->dir);
+  rmdir(path);
+  snprintf(path, sizeof(path), "%s/plrobjs", fixture->dir);
+  rmdir(path);
+  snprintf(path, sizeof(path), "%s/house", fixture->dir);
+  rmdir(path);
+  rmdir(fixture->dir);
+}
+
+static int incsave_count(const char *haystack, const char *needle)
+{
+  int count = 0;
+
+  for (; (haystack = strstr(haystack, needle)) != NULL; haystack += strlen(needle))
+    count++;
+  return count;
+}
+
+/* The rent file without its first line, which holds the save time. */
+static char *incsave_file_records(void)
+{
+  static char records[16384];
+  char *start;
+  size_t length;
+  FILE *fl = fopen("plrobjs/A-E/ebbie.objs", "r");
+
+  *records = '\0';
+  if (fl == NULL)
+    return records;
+  length = fread(records, 1, sizeof(records) - 1, fl);
+  records[length] = '\0';
+  fclose(fl);
+  if ((start = strchr(records, '\n')) != NULL)
+    memmove(records, start + 1, strlen(start + 1) + 1);
+  return records;
+}
+
+/* Queries one crash save sent. */
+static int incsave_crashsave(struct incsave_fixture *fixture)
+{
+  uint64_t before = mysql_query_counter_value();
+
+  fixture->transcript[0] = '\0';
+  SET_BIT_AR(PLR_FLAGS(&fixture->ch), PLR_CRASH);
+  Crash_crashsave(&fixture->ch);
+  return (int)(mysql_query_counter_value() - before);
+}
+
+void Test_objsave_incremental_fingerprint(CuTest *tc)
+{
+  struct incsave_fixture fixture;
+  struct obj_data *dagger;
+  uint64_t first;
+
+  CuAssertTrue(tc, incsave_begin(&fixture));
+
+  first = objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying);
+  CuAssertTrue(tc, first == objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying));
+
+  /* Anything that changes what is written, however deep it sits. */
+  GET_OBJ_VAL(fixture.gem, 3) = 9;
+  CuAssertTrue(tc, first != objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying));
+  GET_OBJ_VAL(fixture.gem, 3) = 0;
+  CuAssertTrue(tc, first == objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying));
+
+  free(fixture.gem->short_description);
+  fixture.gem->short_description = strdup("a test gen");
+  CuAssertTrue(tc, first != objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying));
+  free(fixture.gem->short_description);
+  fixture.gem->short_description = strdup("a test gem");
+
+  /* A weapon in a sheath is saved with it. */
+  dagger = incsave_object("a sheathed test dagger", 1);
+  fixture.bag->sheath_primary = dagger;
+  CuAssertTrue(tc, first != objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying));
+  fixture.bag->sheath_primary = NULL;
+  CuAssertTrue(tc, first == objsave_hash_objects(OBJSAVE_HASH_SEED, fixture.ch.carrying));
+  extract_obj(dagger);
+
+  incsave_end(&fixture);
+}
+
+void Test_objsave_incremental_crashsave(CuTest *tc)
+{
+  struct incsave_fixture fixture;
+  uint64_t written, unchanged, inserts;
+  uint64_t written_before, unchanged_before, inserts_before;
+  char records[16384];
+
+  CuAssertTrue(tc, incsave_begin(&fixture));
+  PERF_object_save_row_stats(&written_before, &unchanged_before, &inserts_before);
+
+  /* First save: the rows go in together, stamped in the order saved. */
+  CuAssertIntEquals(tc, 5, incsave_crashsave(&fixture));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "start transaction;"));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "delete from player_save_objs"));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "insert into player_save_objs"));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "commit;"));
+  CuAssertIntEquals(tc, 3, incsave_count(fixture.transcript, "('Ebbie', '#-1\n"));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "INTERVAL 2 MICROSECOND)\n"));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "obj_save_header"));
+  CuAssertTrue(tc, !PLR_FLAGGED(&fixture.ch, PLR_CRASH));
+  PERF_object_save_row_stats(&written, &unchanged, &inserts);
+  CuAssertTrue(tc, written - written_before == 3 && inserts - inserts_before == 1);
+  strlcpy(records, incsave_file_records(), sizeof(records));
+  CuAssertTrue(tc, strstr(records, "a test gem") != NULL);
+
+  /* Nothing changed: the header is updated and the rows are left alone, but
+   * the rent file is still written in full. */
+  CuAssertIntEquals(tc, 1, incsave_crashsave(&fixture));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "update player_data set"));
+  CuAssertTrue(tc, !PLR_FLAGGED(&fixture.ch, PLR_CRASH));
+  CuAssertStrEquals(tc, records, incsave_file_records());
+  PERF_object_save_row_stats(&written_before, &unchanged_before, &inserts_before);
+  CuAssertTrue(tc, written_before == written && unchanged_before - unchanged == 3);
+
+  /* The saves left the bag weighing what it did. */
+  CuAssertIntEquals(tc, 7, GET_OBJ_WEIGHT(fixture.bag));
+
+  /* A change deep in the bag rewrites the rows. */
+  GET_OBJ_WEIGHT(fixture.gem) = 3;
+  CuAssertIntEquals(tc, 5, incsave_crashsave(&fixture));
+  CuAssertTrue(tc, strstr(fixture.transcript, "Wght: 3\n") != NULL);
+  CuAssertIntEquals(tc, 1, incsave_crashsave(&fixture));
+
+  /* A failed INSERT rolls the save back and leaves the next one to rewrite. */
+  GET_OBJ_WEIGHT(fixture.gem) = 2;
+  mysql_test_fail_nth_query(4);
+  CuAssertIntEquals(tc, 5, incsave_crashsave(&fixture));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "rollback;"));
+  CuAssertIntEquals(tc, 0, incsave_count(fixture.transcript, "commit;"));
+  CuAssertTrue(tc, PLR_FLAGGED(&fixture.ch, PLR_CRASH));
+  CuAssertIntEquals(tc, 5, incsave_crashsave(&fixture));
+  CuAssertIntEquals(tc, 1, incsave_count(fixture.transcript, "commit;"));
+
+  /* Renting out replaces the rows some other way. */
+  fixture.ch.player_specials->obj_save_fingerprint_valid = FALSE;
+  CuAssertIntEquals(tc, 5, incsave_crashsave(&fixture));
+
+  incsave_end(&fixture);
+}
+
+void Test_objsave_incremental_house(CuTest *tc)
+{
+  struct incsave_fixture fixture;
+  struct room_data rooms[1];
+  struct room_data *saved_world = world;
+  room_rnum saved_top_of_world = top_of_world;
+  struct obj_data *chest, *coin;
+  uint64_t before;
+
+  CuAssertTrue(tc, incsave_begin(&fixture));
+  memset(rooms, 0, sizeof(rooms));
+  rooms[0].number = INCSAVE_HOUSE_VNUM;
+  world = rooms;
+  top_of_world = 0;
+  chest = incsave_object("a test chest", 20);
+  GET_OBJ_TYPE(chest) = ITEM_CONTAINER;
+  coin = incsave_object("a test coin", 1);
+  incsave_put(coin, chest);
+  rooms[0].contents = chest;
+
+  before = mysql_query_counter_value();
+  CuAssertTrue(tc, House_crashsave(INCSAVE_HOUSE_VNUM));
+  CuAssertIntEquals(tc, 5, (int)(mysql_query_counter_value() - before));
+
+  /* Unchanged: not even the file is touched. */
+  before = mysql_query_counter_value();
+  SET_BIT_AR(ROOM_FLAGS(0), ROOM_HOUSE_CRASH);
+  CuAssertTrue(tc, House_crashsave(INCSAVE_HOUSE_VNUM));
+  CuAssertIntEquals(tc, 0, (int)(mysql_query_counter_value() - before));
+  CuAssertTrue(tc, !ROOM_FLAGGED(0, ROOM_HOUSE_CRASH));
+  CuAssertIntEquals(tc, 20, GET_OBJ_WEIGHT(chest));
+
+  GET_OBJ_VAL(coin, 0) = 5;
+  before = mysql_query_counter_value();
+  CuAssertTrue(tc, House_crashsave(INCSAVE_HOUSE_VNUM));
+  CuAssertIntEquals(tc, 5, (int)(mysql_query_counter_value() - before));
+
+  /* Deleting the house file forgets what was saved. */
+  House_delete_file(INCSAVE_HOUSE_VNUM);
+  before = mysql_query_counter_value();
+  CuAssertTrue(tc, House_crashsave(INCSAVE_HOUSE_VNUM));
+  CuAssertIntEquals(tc, 5, (int)(mysql_query_counter_value() - before));
+  House_delete_file(INCSAVE_HOUSE_VNUM);
+
+  incsave_extract(chest);
+  world = saved_world;
+  top_of_world = saved_top_of_world;
+  incsave_end(&fixture);
+}
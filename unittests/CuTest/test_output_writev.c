@@ -0,0 +1,188 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/net/protocol.h"
+
+#include <arpa/telnet.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#define OUTPUT_TEST_CAPTURE (256 * 1024)
+
+struct output_peer
+{
+  struct descriptor_data d;
+  int sv[2];
+  char *seen;
+  size_t seen_length;
+};
+
+static void output_peer_open(CuTest *tc, struct output_peer *p)
+{
+  memset(p, 0, sizeof(*p));
+  CuAssertIntEquals(tc, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, p->sv));
+  p->d.descriptor = p->sv[0];
+  p->d.output = p->d.small_outbuf;
+  p->d.bufspace = SMALL_BUFSIZE - 1;
+  p->d.connected = CON_CLOSE;
+  p->d.pProtocol = ProtocolCreate();
+  CREATE(p->seen, char, OUTPUT_TEST_CAPTURE + 1);
+}
+
+/* Collect whatever the server side has sent so far. */
+static void output_peer_drain(struct output_peer *p)
+{
+  ssize_t got;
+
+  while (p->seen_length < OUTPUT_TEST_CAPTURE &&
+         (got = recv(p->sv[1], p->seen + p->seen_length, OUTPUT_TEST_CAPTURE - p->seen_length,
+                     MSG_DONTWAIT)) > 0)
+    p->seen_length += (size_t)got;
+  p->seen[p->seen_length] = '\0';
+}
+
+static void output_peer_close(struct output_peer *p)
+{
+  ProtocolDestroy(p->d.pProtocol);
+  close(p->sv[0]);
+  close(p->sv[1]);
+  free(p->seen);
+}
+
+void Test_output_writev_sends_queue_and_prompt(CuTest *tc)
+{
+  static const char prompt[] = {(char)IAC, (char)GA, '\0'};
+  struct output_peer p;
+  char expected[128];
+
+  output_peer_open(tc, &p);
+
+  /* An interruption leads with a CRLF, which is not counted as sent. */
+  p.d.has_prompt = TRUE;
+  write_to_output(&p.d, "You hear %s.\r\n", "a howl");
+  CuAssertIntEquals(tc, (int)strlen("You hear a howl.\r\n") + 2, comm_test_process_output(&p.d));
+  output_peer_drain(&p);
+  snprintf(expected, sizeof(expected), "\r\nYou hear a howl.\r\n%s", prompt);
+  CuAssertStrEquals(tc, expected, p.seen);
+  CuAssertTrue(tc, !p.d.has_prompt);
+  CuAssertIntEquals(tc, 0, p.d.bufptr);
+  CuAssertIntEquals(tc, SMALL_BUFSIZE - 1, p.d.bufspace);
+
+  /* The overflow notice goes between the queued text and the prompt. */
+  p.seen_length = 0;
+  write_to_output(&p.d, "Too much.\r\n");
+  p.d.bufspace = 0;
+  CuAssertTrue(tc, comm_test_process_output(&p.d) > 0);
+  output_peer_drain(&p);
+  snprintf(expected, sizeof(expected), "Too much.\r\n**OVERFLOW**%s", prompt);
+  CuAssertStrEquals(tc, expected, p.seen);
+  CuAssertIntEquals(tc, SMALL_BUFSIZE - 1, p.d.bufspace);
+
+  output_peer_close(&p);
+}
+
+void Test_output_writev_keeps_unsent_bytes(CuTest *tc)
+{
+  struct output_peer p;
+  char *text;
+  size_t length = 0, sent = 0;
+  int line, sndbuf = 4096, rounds = 0, result, segments;
+
+  output_peer_open(tc, &p);
+  CuAssertIntEquals(tc, 0, setsockopt(p.sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)));
+  CuAssertIntEquals(tc, 0, fcntl(p.sv[0], F_SETFL, fcntl(p.sv[0], F_GETFL) | O_NONBLOCK));
+
+  /* Enough to fill small_outbuf, chain segments after it and need several
+   * writes to send. */
+  CREATE(text, char, OUTPUT_TEST_CAPTURE);
+  for (line = 0; line < 300; line++)
+    length += snprintf(text + length, OUTPUT_TEST_CAPTURE - length,
+                       "Line %03d of a long help file, sent in pieces.\r\n", line);
+  write_to_output(&p.d, "%s", text);
+  CuAssertPtrNotNull(tc, p.d.output_segments);
+  CuAssertIntEquals(tc, SMALL_BUFSIZE - 1, (int)strlen(p.d.small_outbuf));
+  CuAssertIntEquals(tc, (int)length, p.d.bufptr);
+
+  while (p.d.bufptr > 0 && rounds++ < 1000)
+  {
+    CuAssertTrue(tc, (result = comm_test_process_output(&p.d)) >= 0);
+    output_peer_drain(&p);
+
+    /* What is left is read where it was queued, past what was sent. */
+    if (p.d.bufptr > 0)
+    {
+      sent += (size_t)result;
+      CuAssertIntEquals(tc, (int)(length - sent), p.d.bufptr);
+      CuAssertIntEquals(tc, 0, memcmp(p.d.output, text + sent, strlen(p.d.output)));
+    }
+  }
+
+  /* Every byte arrives once and in order, and the segments are given up. */
+  CuAssertIntEquals(tc, 0, p.d.bufptr);
+  CuAssertTrue(tc, p.seen_length >= length);
+  CuAssertIntEquals(tc, 0, memcmp(p.seen, text, length));
+  CuAssertPtrEquals(tc, NULL, p.d.output_segments);
+  CuAssertPtrEquals(tc, NULL, p.d.output_tail);
+  CuAssertPtrEquals(tc, p.d.small_outbuf, p.d.output);
+
+  /* The same output again is queued in segments from the pool. */
+  segments = buf_largecount;
+  write_to_output(&p.d, "%s", text);
+  CuAssertIntEquals(tc, segments, buf_largecount);
+  CuAssertIntEquals(tc, (int)length, p.d.bufptr);
+  p.seen_length = 0;
+  rounds = 0;
+  while (p.d.bufptr > 0 && rounds++ < 1000)
+  {
+    CuAssertTrue(tc, comm_test_process_output(&p.d) >= 0);
+    output_peer_drain(&p);
+  }
+  CuAssertIntEquals(tc, 0, memcmp(p.seen, text, length));
+
+  free(text);
+  output_peer_close(&p);
+}
+
+void Test_output_writev_pass_visits_pending_only(CuTest *tc)
+{
+  static const char prompt[] = {(char)IAC, (char)GA, '\0'};
+  struct output_peer a, b;
+  char expected[128];
+
+  comm_test_reset_output_pending();
+  output_peer_open(tc, &a);
+  output_peer_open(tc, &b);
+  a.d.has_prompt = TRUE;
+  b.d.has_prompt = TRUE;
+
+  /* Queueing output is what puts a descriptor on the pass. */
+  write_to_output(&a.d, "You hear %s.\r\n", "a howl");
+  CuAssertTrue(tc, a.d.output_pending);
+  CuAssertTrue(tc, !b.d.output_pending);
+  comm_test_process_pending_output();
+  output_peer_drain(&a);
+  output_peer_drain(&b);
+  snprintf(expected, sizeof(expected), "\r\nYou hear a howl.\r\n%s", prompt);
+  CuAssertStrEquals(tc, expected, a.seen);
+  CuAssertIntEquals(tc, 0, (int)b.seen_length);
+  CuAssertTrue(tc, !a.d.output_pending);
+  CuAssertTrue(tc, a.d.has_prompt);
+
+  /* One owed a prompt and nothing else gets just the prompt. */
+  b.d.has_prompt = FALSE;
+  mark_output_pending(&b.d);
+  comm_test_process_pending_output();
+  output_peer_drain(&b);
+  CuAssertStrEquals(tc, prompt, b.seen);
+  CuAssertTrue(tc, b.d.has_prompt);
+  CuAssertTrue(tc, !b.d.output_pending);
+
+  output_peer_close(&a);
+  output_peer_close(&b);
+}
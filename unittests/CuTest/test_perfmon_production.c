@@ -338,6 +338,50 @@ void Test_perfmon_summary_labels_window_budget_and_dropped_heartbeats(CuTest *tc
   CuAssertPtrNotNull(tc, strstr(report, "Max pulse:      150.00 ms (150.00%)"));
 }
 
+void Test_perfmon_metrics_exposition_reads_aggregated_counters(CuTest *tc)
+{
+  static struct PERF_prof_sect *section = NULL;
+  static char report[65536];
+  size_t length;
+
+  PERF_reset();
+  PERF_prof_sect_init(&section, "metrics \"quoted\"");
+  PERF_prof_sect_enter(section);
+  PERF_prof_sect_exit(section);
+  PERF_log_pulse(20.0);
+  PERF_log_pulse(150.0);
+  PERF_note_sql_pool_wait(1500);
+  PERF_note_event_process(4, 3, 1, 0);
+
+  length = PERF_metrics_repr(report, sizeof(report));
+  CuAssertIntEquals(tc, (int)strlen(report), (int)length);
+  CuAssertPtrNotNull(tc, strstr(report, "# TYPE luminari_pulse_duration_seconds histogram\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_bucket{le=\"0.01\"} 0\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_bucket{le=\"0.03\"} 1\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_bucket{le=\"0.1\"} 1\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_bucket{le=\"0.25\"} 2\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_bucket{le=\"+Inf\"} 2\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_count 2\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_sum 0.170000\n"));
+  CuAssertPtrNotNull(
+      tc, strstr(report, "luminari_section_calls_total{section=\"metrics \\\"quoted\\\"\"} 1\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_sql_pool_waits_total 1\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_sql_pool_wait_seconds_total 0.001500\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_event_queue_depth 3\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_descriptors{state=\"connected\"} "));
+  CuAssertIntEquals(tc, 1, perfmon_count_text_occurrences(report, "# EOF\n"));
+  CuAssertStrEquals(tc, "# EOF\n", report + length - strlen("# EOF\n"));
+
+  /* A short buffer is filled and terminated, never overrun. */
+  CuAssertIntEquals(tc, 15, (int)PERF_metrics_repr(report, 16));
+  CuAssertIntEquals(tc, 15, (int)strlen(report));
+
+  PERF_reset();
+  PERF_metrics_repr(report, sizeof(report));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_sql_pool_waits_total 0\n"));
+  CuAssertPtrNotNull(tc, strstr(report, "luminari_pulse_duration_seconds_count 0\n"));
+}
+
 void Test_pending_extraction_batch_clears_cross_character_references(CuTest *tc)
 {
   struct room_data room;
@@ -0,0 +1,337 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/db.h"
+#include "../../src/handler.h"
+#include "../../src/mysql.h"
+#include "../../src/perfmon.h"
+#include "../../src/persistence_writer.h"
+#include "../../src/obj/objsave.h"
+#include "test.helpers.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PWRITER_LATENCY_USEC 20000
+#define PWRITER_PULSES 25
+
+/* A scratch lib directory with a player in it: a sheath worn with a
+ * blade in it, and a gem carried.  Queries are accepted and written
+ * down instead of sent. */
+struct pwriter_fixture
+{
+  char oldcwd[PATH_MAX];
+  char dir[64];
+  char transcript[65536];
+  struct char_data ch;
+  struct player_special_data specials;
+  struct bag_data bags;
+  struct obj_data *sheath, *blade, *gem;
+};
+
+static int pwriter_done_calls;
+static bool pwriter_done_failed;
+static struct char_data *pwriter_done_ch;
+
+static void pwriter_done(struct persistence_write *job, struct char_data *ch)
+{
+  pwriter_done_calls++;
+  pwriter_done_failed = job->failed;
+  pwriter_done_ch = ch;
+}
+
+static struct obj_data *pwriter_object(const char *short_description)
+{
+  struct obj_data *obj = create_obj();
+
+  obj->name = strdup("writer test");
+  obj->short_description = strdup(short_description);
+  obj->description = strdup("A writer test object lies here.");
+  GET_OBJ_TYPE(obj) = ITEM_OTHER;
+  GET_OBJ_WEIGHT(obj) = 1;
+  return obj;
+}
+
+static int pwriter_begin(struct pwriter_fixture *fixture)
+{
+  char path[PATH_MAX];
+
+  memset(fixture, 0, sizeof(*fixture));
+  pwriter_done_calls = 0;
+  pwriter_done_failed = FALSE;
+  pwriter_done_ch = NULL;
+  strlcpy(fixture->dir, "/tmp/luminari_pwriter_XXXXXX", sizeof(fixture->dir));
+  if (!getcwd(fixture->oldcwd, sizeof(fixture->oldcwd)) || !mkdtemp(fixture->dir))
+    return FALSE;
+  snprintf(path, sizeof(path), "%s/plrobjs", fixture->dir);
+  mkdir(path, 0700);
+  snprintf(path, sizeof(path), "%s/plrobjs/P-T", fixture->dir);
+  mkdir(path, 0700);
+  if (chdir(fixture->dir) != 0)
+    return FALSE;
+
+  fixture->ch.player_specials = &fixture->specials;
+  fixture->ch.bags = &fixture->bags;
+  fixture->ch.player.name = (char *)"Pell";
+
+  fixture->sheath = pwriter_object("a test scabbard");
+  SET_BIT_AR(GET_OBJ_WEAR(fixture->sheath), ITEM_WEAR_SHEATH);
+  fixture->sheath->worn_by = &fixture->ch;
+  fixture->ch.equipment[WEAR_SHEATH] = fixture->sheath;
+  fixture->blade = pwriter_object("a sheathed test blade");
+  fixture->sheath->sheath_primary = fixture->blade;
+  fixture->gem = pwriter_object("a carried test gem");
+  fixture->gem->carried_by = &fixture->ch;
+  fixture->ch.carrying = fixture->gem;
+
+  mysql_test_accept_queries(TRUE, fixture->transcript, sizeof(fixture->transcript));
+  return TRUE;
+}
+
+/* Files left in the scratch directory, not counting . and .. */
+static int pwriter_files(const char *dir)
+{
+  DIR *d = opendir(dir);
+  struct dirent *entry;
+  int count = 0;
+
+  if (d == NULL)
+    return -1;
+  while ((entry = readdir(d)) != NULL)
+    if (*entry->d_name != '.')
+      count++;
+  closedir(d);
+  return count;
+}
+
+static void pwriter_end(struct pwriter_fixture *fixture)
+{
+  char path[PATH_MAX];
+
+  persistence_writer_test_latency(0);
+  persistence_writer_stop();
+  mysql_test_accept_queries(FALSE, NULL, 0);
+  mysql_test_clear_query_failure();
+  fixture->sheath->sheath_primary = NULL;
+  fixture->sheath->worn_by = NULL;
+  fixture->gem->carried_by = NULL;
+  extract_obj(fixture->blade);
+  extract_obj(fixture->sheath);
+  extract_obj(fixture->gem);
+  if (chdir(fixture->oldcwd) != 0)
+    fixture->oldcwd[0] = '\0';
+
+  snprintf(path, sizeof(path), "%s/plrobjs/P-T/pell.objs", fixture->dir);
+  remove(path);
+  snprintf(path, sizeof(path), "%s/note", fixture->dir);
+  remove(path);
+  snprintf(path, sizeof(path), "%s/plrobjs/P-T", fixture->dir);
+  rmdir(path);
+  snprintf(path, sizeof(path), "%s/plrobjs", fixture->dir);
+  rmdir(path);
+  rmdir(fixture->dir);
+}
+
+static struct persistence_write *pwriter_job(const char *path, const char *text)
+{
+  struct persistence_write *job = persistence_write_new("test note", 0, pwriter_done);
+
+  persistence_write_file(job, path, strdup(text), strlen(text));
+  return job;
+}
+
+static char *pwriter_read(const char *path)
+{
+  static char contents[4096];
+  size_t length;
+  FILE *fl = fopen(path, "r");
+
+  *contents = '\0';
+  if (fl == NULL)
+    return contents;
+  length = fread(contents, 1, sizeof(contents) - 1, fl);
+  contents[length] = '\0';
+  fclose(fl);
+  return contents;
+}
+
+void Test_persistence_writer_inline(CuTest *tc)
+{
+  struct pwriter_fixture fixture;
+  struct persistence_write *job;
+  struct stat st;
+
+  CuAssertTrue(tc, pwriter_begin(&fixture));
+
+  /* With no writer running the write is done, and answered, in place. */
+  CuAssertTrue(tc, persistence_writer_submit(pwriter_job("note", "first\n"), &fixture.ch, FALSE));
+  CuAssertIntEquals(tc, 1, pwriter_done_calls);
+  CuAssertTrue(tc, !pwriter_done_failed);
+  CuAssertPtrEquals(tc, &fixture.ch, pwriter_done_ch);
+  CuAssertStrEquals(tc, "first\n", pwriter_read("note"));
+
+  /* A replacement keeps the old file's mode and leaves no temporary file. */
+  CuAssertIntEquals(tc, 0, chmod("note", 0604));
+  CuAssertTrue(tc, persistence_writer_submit(pwriter_job("note", "second\n"), NULL, TRUE));
+  CuAssertStrEquals(tc, "second\n", pwriter_read("note"));
+  CuAssertIntEquals(tc, 0, stat("note", &st));
+  CuAssertIntEquals(tc, 0604, (int)(st.st_mode & 07777));
+  CuAssertIntEquals(tc, 2, pwriter_files("."));
+
+  /* A file that cannot be written fails the job before its statements. */
+  job = pwriter_job("missing/note", "lost\n");
+  persistence_write_sql(job, "update nothing;");
+  fixture.transcript[0] = '\0';
+  CuAssertTrue(tc, !persistence_writer_submit(job, NULL, FALSE));
+  CuAssertTrue(tc, pwriter_done_failed);
+  CuAssertStrEquals(tc, "", fixture.transcript);
+
+  /* Statements run as one transaction, and a failure rolls it back. */
+  job = persistence_write_new("test rows", 0, pwriter_done);
+  persistence_write_sql(job, "delete from rows;");
+  persistence_write_sql(job, "insert into rows;");
+  mysql_test_fail_nth_query(3);
+  CuAssertTrue(tc, !persistence_writer_submit(job, NULL, FALSE));
+  CuAssertStrEquals(tc, "start transaction;\ndelete from rows;\nrollback;\n", fixture.transcript);
+
+  pwriter_end(&fixture);
+}
+
+void Test_persistence_writer_thread(CuTest *tc)
+{
+  struct pwriter_fixture fixture;
+  struct persistence_writer_stats stats;
+  char text[32];
+  int i;
+
+  CuAssertTrue(tc, pwriter_begin(&fixture));
+  CuAssertTrue(tc, persistence_writer_start());
+
+  /* Writes of one file land in the order they were queued. */
+  for (i = 0; i < 10; i++)
+  {
+    snprintf(text, sizeof(text), "version %d\n", i);
+    CuAssertTrue(tc, persistence_writer_submit(pwriter_job("note", text), NULL, FALSE));
+  }
+  persistence_writer_flush();
+  CuAssertStrEquals(tc, "version 9\n", pwriter_read("note"));
+  CuAssertIntEquals(tc, 0, pwriter_done_calls);
+  persistence_writer_drain();
+  CuAssertIntEquals(tc, 10, pwriter_done_calls);
+
+  /* A waiting submit is answered on return, not through the drain. */
+  CuAssertTrue(tc, persistence_writer_submit(pwriter_job("note", "waited\n"), NULL, TRUE));
+  CuAssertIntEquals(tc, 11, pwriter_done_calls);
+  CuAssertStrEquals(tc, "waited\n", pwriter_read("note"));
+
+  /* A crash save taken on this thread is written by the writer; the blade's
+   * row finds its sheath's id once the writer has inserted the sheath. */
+  SET_BIT_AR(PLR_FLAGS(&fixture.ch), PLR_CRASH);
+  Crash_crashsave(&fixture.ch);
+  CuAssertTrue(tc, !PLR_FLAGGED(&fixture.ch, PLR_CRASH));
+  persistence_writer_flush();
+  CuAssertTrue(tc, strstr(fixture.transcript,
+                          "set @objsave_sheath = last_insert_id();\n"
+                          "insert into player_save_objs_sheathed (id, sheath_obj_id, "
+                          "sheathed_position, owner_name, serialized_obj) values (NULL, "
+                          "@objsave_sheath, 1, 'Pell', '") != NULL);
+  CuAssertTrue(tc, strstr(fixture.transcript, "commit;\n") != NULL);
+  CuAssertTrue(tc, strstr(pwriter_read("plrobjs/P-T/pell.objs"), "a carried test gem") != NULL);
+
+  persistence_writer_get_stats(&stats);
+  CuAssertTrue(tc, stats.running);
+  CuAssertIntEquals(tc, 0, stats.queued);
+  persistence_writer_stop();
+  persistence_writer_get_stats(&stats);
+  CuAssertTrue(tc, !stats.running);
+
+  pwriter_end(&fixture);
+}
+
+/* Each pulse saves the player, with every write made slow.  Inline, the
+ * pulse waits for the disk; with the writer running it does not. */
+static void pwriter_pulses(struct pwriter_fixture *fixture, uint64_t *total_usec,
+                           uint64_t *max_usec)
+{
+  uint64_t start, elapsed;
+  int i;
+
+  *total_usec = *max_usec = 0;
+  for (i = 0; i < PWRITER_PULSES; i++)
+  {
+    start = PERF_monotonic_usec();
+    persistence_writer_drain();
+    GET_OBJ_VAL(fixture->gem, 0) = i;
+    SET_BIT_AR(PLR_FLAGS(&fixture->ch), PLR_CRASH);
+    Crash_crashsave(&fixture->ch);
+    elapsed = PERF_monotonic_usec() - start;
+    *total_usec += elapsed;
+    if (elapsed > *max_usec)
+      *max_usec = elapsed;
+  }
+}
+
+void Test_persistence_writer_pulses_do_not_wait_on_slow_writes(CuTest *tc)
+{
+  struct pwriter_fixture fixture;
+  struct persistence_writer_stats before, after;
+  uint64_t total_usec, max_usec;
+
+  CuAssertTrue(tc, pwriter_begin(&fixture));
+  persistence_writer_test_latency(PWRITER_LATENCY_USEC);
+
+  CuAssertTrue(tc, persistence_writer_start());
+  persistence_writer_get_stats(&before);
+  pwriter_pulses(&fixture, &total_usec, &max_usec);
+  persistence_writer_get_stats(&after);
+  persistence_writer_flush();
+  persistence_writer_drain();
+
+  /* The pulses finished before the writer did instead of waiting on it,
+   * and every save still made it out. */
+  CuAssertTrue(tc, after.written - before.written < PWRITER_PULSES);
+  CuAssertTrue(tc, after.submitted - before.submitted == PWRITER_PULSES);
+  persistence_writer_get_stats(&after);
+  CuAssertTrue(tc, after.written - before.written == PWRITER_PULSES);
+  CuAssertTrue(tc, !PLR_FLAGGED(&fixture.ch, PLR_CRASH));
+
+  pwriter_end(&fixture);
+}
+
+void Test_persistence_writer_latency_benchmark(CuTest *tc)
+{
+  struct pwriter_fixture fixture;
+  uint64_t inline_total, inline_max, thread_total, thread_max;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  CuAssertTrue(tc, pwriter_begin(&fixture));
+  persistence_writer_test_latency(PWRITER_LATENCY_USEC);
+
+  pwriter_pulses(&fixture, &inline_total, &inline_max);
+
+  CuAssertTrue(tc, persistence_writer_start());
+  pwriter_pulses(&fixture, &thread_total, &thread_max);
+  persistence_writer_flush();
+  persistence_writer_drain();
+
+  log("BENCHMARK: %d crash saves, %d usec injected per write: inline pulses avg %llu max %llu "
+      "usec; with the writer avg %llu max %llu usec",
+      PWRITER_PULSES, PWRITER_LATENCY_USEC,
+      (unsigned long long)(inline_total / PWRITER_PULSES), (unsigned long long)inline_max,
+      (unsigned long long)(thread_total / PWRITER_PULSES), (unsigned long long)thread_max);
+
+  pwriter_end(&fixture);
+}
@@ -0,0 +1,245 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/db.h"
+#include "../../src/perfmon.h"
+#include "test.helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PINDEX_BENCH_ENTRIES 100000
+#define PINDEX_BENCH_SCANS 1000
+
+struct pindex_fixture
+{
+  struct player_index_element *saved_table;
+  int saved_top;
+};
+
+/* Give the tests an empty player index of their own. */
+static void pindex_setup(struct pindex_fixture *fx)
+{
+  fx->saved_table = player_table;
+  fx->saved_top = top_of_p_table;
+  player_table = NULL;
+  top_of_p_table = -1;
+  player_index_rebuild();
+}
+
+static void pindex_teardown(struct pindex_fixture *fx)
+{
+  free_player_index();
+  player_table = fx->saved_table;
+  top_of_p_table = fx->saved_top;
+  player_index_rebuild();
+}
+
+static int pindex_add(const char *name, long id)
+{
+  char buf[MAX_NAME_LENGTH + 1];
+  int pos;
+
+  snprintf(buf, sizeof(buf), "%s", name);
+  pos = create_entry(buf);
+  player_table[pos].id = id;
+  player_index_id_changed(pos, 0);
+  return pos;
+}
+
+void Test_player_index_tracks_create_and_remove(CuTest *tc)
+{
+  struct pindex_fixture fx;
+  char again[] = "BRYNN";
+
+  pindex_setup(&fx);
+
+  CuAssertIntEquals(tc, 0, pindex_add("Alaric", 10));
+  CuAssertIntEquals(tc, 1, pindex_add("Brynn", 11));
+  CuAssertIntEquals(tc, 2, pindex_add("Corwin", 12));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  CuAssertIntEquals(tc, 1, (int)get_ptable_by_name("bRYNN"));
+  CuAssertIntEquals(tc, 12, (int)get_id_by_name("CORWIN"));
+  CuAssertStrEquals(tc, "alaric", get_name_by_id(10));
+  CuAssertIntEquals(tc, -1, (int)get_ptable_by_name("Dagny"));
+  CuAssertIntEquals(tc, -1, (int)get_id_by_name("Dagny"));
+  CuAssertPtrEquals(tc, NULL, get_name_by_id(13));
+
+  /* Re-creating a name reuses its slot and drops its old id. */
+  CuAssertIntEquals(tc, 1, create_entry(again));
+  CuAssertPtrEquals(tc, NULL, get_name_by_id(11));
+  CuAssertIntEquals(tc, 0, (int)get_id_by_name("brynn"));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+  player_table[1].id = 14;
+  player_index_id_changed(1, 0);
+  CuAssertStrEquals(tc, "brynn", get_name_by_id(14));
+
+  /* Removal moves everything after it down a place. */
+  remove_player_from_index(0);
+  CuAssertIntEquals(tc, 0, player_index_validate());
+  CuAssertIntEquals(tc, -1, (int)get_ptable_by_name("alaric"));
+  CuAssertPtrEquals(tc, NULL, get_name_by_id(10));
+  CuAssertIntEquals(tc, 0, (int)get_ptable_by_name("brynn"));
+  CuAssertIntEquals(tc, 1, (int)get_ptable_by_name("corwin"));
+  CuAssertStrEquals(tc, "corwin", get_name_by_id(12));
+
+  remove_player_from_index(1);
+  remove_player_from_index(0);
+  CuAssertIntEquals(tc, -1, top_of_p_table);
+  CuAssertIntEquals(tc, -1, (int)get_ptable_by_name("brynn"));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  pindex_teardown(&fx);
+}
+
+void Test_player_index_follows_renames_and_duplicates(CuTest *tc)
+{
+  struct pindex_fixture fx;
+  char *old_name, *new_name;
+
+  pindex_setup(&fx);
+  pindex_add("Elspeth", 20);
+  pindex_add("Fenwick", 21);
+
+  /* A rename as the rename flow does it: swap the pointer, then report. */
+  old_name = player_table[0].name;
+  player_table[0].name = new_name = strdup("galen");
+  player_index_name_changed(0, old_name);
+  CuAssertIntEquals(tc, -1, (int)get_ptable_by_name("elspeth"));
+  CuAssertIntEquals(tc, 0, (int)get_ptable_by_name("Galen"));
+  CuAssertStrEquals(tc, "galen", get_name_by_id(20));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  /* And its rollback. */
+  player_table[0].name = old_name;
+  player_index_name_changed(0, new_name);
+  free(new_name);
+  CuAssertIntEquals(tc, 0, (int)get_ptable_by_name("elspeth"));
+  CuAssertIntEquals(tc, -1, (int)get_ptable_by_name("galen"));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  /* A name or id held twice resolves to the first holder, as a scan would,
+   * and passes to the next one when the first lets it go. */
+  old_name = player_table[1].name;
+  player_table[1].name = strdup("elspeth");
+  player_index_name_changed(1, old_name);
+  free(old_name);
+  player_table[1].id = 20;
+  player_index_id_changed(1, 21);
+  CuAssertIntEquals(tc, 0, (int)get_ptable_by_name("elspeth"));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  old_name = player_table[0].name;
+  player_table[0].name = strdup("hollis");
+  player_index_name_changed(0, old_name);
+  free(old_name);
+  player_table[0].id = 22;
+  player_index_id_changed(0, 20);
+  CuAssertIntEquals(tc, 1, (int)get_ptable_by_name("elspeth"));
+  CuAssertStrEquals(tc, "elspeth", get_name_by_id(20));
+  CuAssertStrEquals(tc, "hollis", get_name_by_id(22));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  pindex_teardown(&fx);
+}
+
+void Test_player_index_validator_catches_drift(CuTest *tc)
+{
+  struct player_index_element fixture[2];
+  struct player_index_element *saved_table = player_table;
+  int saved_top = top_of_p_table;
+  char first[] = "ivo", second[] = "jorah", other[] = "kestrel";
+
+  memset(fixture, 0, sizeof(fixture));
+  fixture[0].name = first;
+  fixture[0].id = 30;
+  fixture[1].name = second;
+  fixture[1].id = 31;
+  player_table = fixture;
+  top_of_p_table = 1;
+
+  /* A swapped-in table is picked up on the next lookup. */
+  CuAssertIntEquals(tc, 1, (int)get_ptable_by_name("Jorah"));
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  /* Changes nobody reported are found, and a rebuild clears them. */
+  fixture[1].name = other;
+  fixture[0].id = 32;
+  CuAssertTrue(tc, player_index_validate() > 0);
+  player_index_rebuild();
+  CuAssertIntEquals(tc, 0, player_index_validate());
+  CuAssertIntEquals(tc, 1, (int)get_ptable_by_name("kestrel"));
+  CuAssertStrEquals(tc, "ivo", get_name_by_id(32));
+
+  player_table = saved_table;
+  top_of_p_table = saved_top;
+  player_index_rebuild();
+}
+
+void Test_player_index_benchmark(CuTest *tc)
+{
+  struct pindex_fixture fx;
+  char name[MAX_NAME_LENGTH + 1];
+  uint64_t start, build_usec, name_usec, id_usec, scan_usec;
+  long found = 0;
+  int i, j;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  pindex_setup(&fx);
+  CREATE(player_table, struct player_index_element, PINDEX_BENCH_ENTRIES);
+  for (i = 0; i < PINDEX_BENCH_ENTRIES; i++)
+  {
+    snprintf(name, sizeof(name), "bench%d", i);
+    player_table[i].name = strdup(name);
+    player_table[i].id = i + 1;
+  }
+  top_of_p_table = PINDEX_BENCH_ENTRIES - 1;
+
+  start = PERF_monotonic_usec();
+  player_index_rebuild();
+  build_usec = PERF_monotonic_usec() - start;
+  CuAssertIntEquals(tc, 0, player_index_validate());
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < PINDEX_BENCH_ENTRIES; i++)
+  {
+    snprintf(name, sizeof(name), "BENCH%d", (i * 7919) % PINDEX_BENCH_ENTRIES);
+    found += get_ptable_by_name(name) != -1;
+  }
+  name_usec = PERF_monotonic_usec() - start;
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < PINDEX_BENCH_ENTRIES; i++)
+    found += get_name_by_id((i * 7919) % PINDEX_BENCH_ENTRIES + 1) != NULL;
+  id_usec = PERF_monotonic_usec() - start;
+  CuAssertTrue(tc, found == 2 * PINDEX_BENCH_ENTRIES);
+
+  /* What the same lookups cost as the old linear scan. */
+  start = PERF_monotonic_usec();
+  for (i = 0; i < PINDEX_BENCH_SCANS; i++)
+  {
+    snprintf(name, sizeof(name), "bench%d", (i * 7919) % PINDEX_BENCH_ENTRIES);
+    for (j = 0; j <= top_of_p_table; j++)
+      if (!str_cmp(player_table[j].name, name))
+        break;
+    CuAssertIntEquals(tc, (int)get_ptable_by_name(name), j);
+  }
+  scan_usec = PERF_monotonic_usec() - start;
+
+  log("BENCHMARK: player index, %d entries: build %llu usec, %d name lookups %llu usec, "
+      "%d id lookups %llu usec, %d linear name scans %llu usec",
+      PINDEX_BENCH_ENTRIES, (unsigned long long)build_usec, PINDEX_BENCH_ENTRIES,
+      (unsigned long long)name_usec, PINDEX_BENCH_ENTRIES, (unsigned long long)id_usec,
+      PINDEX_BENCH_SCANS, (unsigned long long)scan_usec);
+
+  pindex_teardown(&fx);
+}
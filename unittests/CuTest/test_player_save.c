@@ -0,0 +1,325 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/db.h"
+#include "../../src/handler.h"
+#include "../../src/perfmon.h"
+#include "../../src/magic/spells.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Player files for two characters, checked byte for byte against what the
+ * old save wrote when it stripped the character before formatting: one
+ * with only affects, one wearing gear with stat, apply and AFF bonuses and
+ * holding spell damage reduction. */
+struct psave_fixture
+{
+  char oldcwd[PATH_MAX];
+  char root[PATH_MAX];
+  char dir[64];
+  struct room_data rooms[1];
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  struct player_index_element index[2];
+  struct player_index_element *saved_player_table;
+  int saved_top_of_p_table;
+  struct char_data *bare, *geared;
+  struct obj_data *helm, *ring;
+};
+
+static void psave_affect(struct char_data *ch, int spell, int location, int modifier,
+                         int bonus_type, int aff_bit)
+{
+  struct affected_type af;
+
+  new_affect(&af);
+  af.spell = spell;
+  af.duration = 10;
+  af.location = location;
+  af.modifier = modifier;
+  af.bonus_type = bonus_type;
+  if (aff_bit)
+    SET_BIT_AR(af.bitvector, aff_bit);
+  affect_to_char(ch, &af);
+}
+
+static void psave_dr(struct char_data *ch, int spell, int amount)
+{
+  struct damage_reduction_type *dr;
+
+  CREATE(dr, struct damage_reduction_type, 1);
+  dr->amount = amount;
+  dr->max_damage = amount * 10;
+  dr->spell = spell;
+  dr->bypass_cat[0] = DR_BYPASS_CAT_MAGIC;
+  dr->next = GET_DR(ch);
+  GET_DR(ch) = dr;
+}
+
+static struct obj_data *psave_object(const char *short_description)
+{
+  struct obj_data *obj = create_obj();
+
+  obj->name = strdup("player save test");
+  obj->short_description = strdup(short_description);
+  obj->description = strdup("A player save test object lies here.");
+  GET_OBJ_TYPE(obj) = ITEM_OTHER;
+  GET_OBJ_WEIGHT(obj) = 1;
+  return obj;
+}
+
+static struct char_data *psave_character(const char *name, long idnum, room_rnum room)
+{
+  struct char_data *ch = new_char();
+
+  ch->player.name = strdup(name);
+  GET_PFILEPOS(ch) = 0;
+  GET_IDNUM(ch) = idnum;
+  GET_LEVEL(ch) = 9;
+  GET_GOLD(ch) = 4321;
+  ch->player.time.birth = 1000000;
+  ch->player.time.logon = 0;
+  ch->player.height = 170;
+  ch->player.weight = 150;
+  ch->real_abils.str = 15;
+  ch->real_abils.dex = 13;
+  ch->real_abils.con = 14;
+  ch->real_abils.intel = 12;
+  ch->real_abils.wis = 11;
+  ch->real_abils.cha = 10;
+  ch->aff_abils = ch->real_abils;
+  ch->real_points.max_hit = 120;
+  ch->real_points.max_move = 200;
+  ch->real_points.max_psp = 30;
+  ch->real_points.armor = 100;
+  ch->points = ch->real_points;
+  GET_HIT(ch) = 95;
+  GET_MOVE(ch) = 180;
+  GET_PSP(ch) = 25;
+  IN_ROOM(ch) = room;
+  return ch;
+}
+
+static int psave_begin(struct psave_fixture *fixture)
+{
+  const char *root = getenv("LUMINARI_TEST_ROOT");
+  char path[PATH_MAX];
+
+  memset(fixture, 0, sizeof(*fixture));
+  if (!realpath(root != NULL && *root != '\0' ? root : ".", fixture->root))
+    return FALSE;
+  strlcpy(fixture->dir, "/tmp/luminari_psave_XXXXXX", sizeof(fixture->dir));
+  if (!getcwd(fixture->oldcwd, sizeof(fixture->oldcwd)) || !mkdtemp(fixture->dir))
+    return FALSE;
+  snprintf(path, sizeof(path), "%s/plrfiles", fixture->dir);
+  mkdir(path, 0700);
+  snprintf(path, sizeof(path), "%s/plrfiles/P-T", fixture->dir);
+  mkdir(path, 0700);
+  if (chdir(fixture->dir) != 0)
+    return FALSE;
+
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  fixture->rooms[0].number = 100;
+  fixture->rooms[0].name = "Player save test room";
+  fixture->rooms[0].description = "A room for saving players.\r\n";
+  world = fixture->rooms;
+  top_of_world = 0;
+
+  fixture->saved_player_table = player_table;
+  fixture->saved_top_of_p_table = top_of_p_table;
+  fixture->index[0].name = (char *)"pfbare";
+  fixture->index[0].id = 5101;
+  fixture->index[0].level = 9;
+  fixture->index[1].name = (char *)"pfgeared";
+  fixture->index[1].id = 5102;
+  fixture->index[1].level = 9;
+  player_table = fixture->index;
+  top_of_p_table = 1;
+
+  /* Affects only, one of them granting an AFF bit. */
+  fixture->bare = psave_character("Pfbare", 5101, 0);
+  affect_total(fixture->bare);
+  psave_affect(fixture->bare, SPELL_BLESS, APPLY_WIS, 2, BONUS_TYPE_MORALE, 0);
+  psave_affect(fixture->bare, SPELL_HASTE, APPLY_DEX, 1, BONUS_TYPE_UNDEFINED, AFF_HASTE);
+
+  /* Gear and affects on every kind of location the save strips, a base AFF
+   * bit of their own, and damage reduction both from a spell affect and
+   * standing on its own. */
+  fixture->geared = psave_character("Pfgeared", 5102, 0);
+  SET_BIT_AR(AFF_FLAGS(fixture->geared), AFF_SNEAK);
+  psave_dr(fixture->geared, SPELL_IRONSKIN, 3);
+  affect_total(fixture->geared);
+
+  fixture->helm = psave_object("a test helm");
+  fixture->helm->affected[0].location = APPLY_STR;
+  fixture->helm->affected[0].modifier = 2;
+  fixture->helm->affected[0].bonus_type = BONUS_TYPE_ENHANCEMENT;
+  fixture->helm->affected[1].location = APPLY_CHAR_HEIGHT;
+  fixture->helm->affected[1].modifier = 5;
+  fixture->helm->affected[1].bonus_type = BONUS_TYPE_UNDEFINED;
+  fixture->helm->affected[2].location = APPLY_HP_REGEN;
+  fixture->helm->affected[2].modifier = 3;
+  fixture->helm->affected[2].bonus_type = BONUS_TYPE_ENHANCEMENT;
+  SET_BIT_AR(GET_OBJ_AFFECT(fixture->helm), AFF_INFRAVISION);
+  equip_char(fixture->geared, fixture->helm, WEAR_HEAD);
+
+  fixture->ring = psave_object("a test ring");
+  fixture->ring->affected[0].location = APPLY_AC_NEW;
+  fixture->ring->affected[0].modifier = 2;
+  fixture->ring->affected[0].bonus_type = BONUS_TYPE_DEFLECTION;
+  fixture->ring->affected[1].location = APPLY_SAVING_WILL;
+  fixture->ring->affected[1].modifier = 1;
+  fixture->ring->affected[1].bonus_type = BONUS_TYPE_RESISTANCE;
+  fixture->ring->affected[2].location = APPLY_RES_FIRE;
+  fixture->ring->affected[2].modifier = 10;
+  fixture->ring->affected[2].bonus_type = BONUS_TYPE_UNDEFINED;
+  fixture->ring->affected[3].location = APPLY_ENCUMBRANCE;
+  fixture->ring->affected[3].modifier = 4;
+  fixture->ring->affected[3].bonus_type = BONUS_TYPE_UNDEFINED;
+  equip_char(fixture->geared, fixture->ring, WEAR_FINGER_R);
+
+  psave_affect(fixture->geared, SPELL_HASTE, APPLY_DEX, 1, BONUS_TYPE_UNDEFINED, AFF_HASTE);
+  psave_affect(fixture->geared, SPELL_STONESKIN, APPLY_DR, 0, BONUS_TYPE_UNDEFINED, 0);
+  psave_dr(fixture->geared, SPELL_STONESKIN, 5);
+  psave_affect(fixture->geared, SPELL_BARKSKIN, APPLY_AC_NEW, 3, BONUS_TYPE_NATURALARMOR, 0);
+  psave_affect(fixture->geared, SPELL_BLESS, APPLY_FAST_HEALING, 2, BONUS_TYPE_UNDEFINED, 0);
+  psave_affect(fixture->geared, SPELL_BLESS, APPLY_CHAR_WEIGHT, -4, BONUS_TYPE_UNDEFINED, 0);
+  return TRUE;
+}
+
+static void psave_remove(const char *dir, const char *name)
+{
+  char path[PATH_MAX];
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  remove(path);
+}
+
+static void psave_end(struct psave_fixture *fixture)
+{
+  int i;
+
+  for (i = 0; i < NUM_WEARS; i++)
+    if (GET_EQ(fixture->geared, i))
+      extract_obj(unequip_char(fixture->geared, i));
+  free_char(fixture->bare);
+  free_char(fixture->geared);
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  player_table = fixture->saved_player_table;
+  top_of_p_table = fixture->saved_top_of_p_table;
+  if (chdir(fixture->oldcwd) != 0)
+    fixture->oldcwd[0] = '\0';
+
+  psave_remove(fixture->dir, "plrfiles/P-T/pfbare.plr");
+  psave_remove(fixture->dir, "plrfiles/P-T/pfgeared.plr");
+  psave_remove(fixture->dir, "plrfiles/index");
+  psave_remove(fixture->dir, "plrfiles/P-T");
+  psave_remove(fixture->dir, "plrfiles");
+  rmdir(fixture->dir);
+}
+
+/* The whole of path, or NULL; *length gets its size. */
+static char *psave_slurp(const char *path, long *length)
+{
+  FILE *fl = fopen(path, "rb");
+  char *contents;
+
+  *length = -1;
+  if (fl == NULL)
+    return NULL;
+  fseek(fl, 0, SEEK_END);
+  *length = ftell(fl);
+  rewind(fl);
+  CREATE(contents, char, *length + 1);
+  if (fread(contents, 1, *length, fl) != (size_t)*length)
+    *length = -1;
+  fclose(fl);
+  return contents;
+}
+
+static void psave_check_file(CuTest *tc, struct psave_fixture *fixture, struct char_data *ch,
+                             const char *expected_name)
+{
+  char filename[MAX_FILEPATH], expected_path[PATH_MAX + 64];
+  char *expected, *actual;
+  long expected_length, actual_length;
+
+  CuAssertTrue(tc, get_filename(filename, sizeof(filename), PLR_FILE, GET_NAME(ch)));
+  CuAssertTrue(tc, save_char_checked(ch, 0));
+
+  snprintf(expected_path, sizeof(expected_path), "%s/unittests/CuTest/fixtures/player_save/%s",
+           fixture->root, expected_name);
+  expected = psave_slurp(expected_path, &expected_length);
+  actual = psave_slurp(filename, &actual_length);
+  CuAssertPtrNotNull(tc, expected);
+  CuAssertPtrNotNull(tc, actual);
+  CuAssertIntEquals(tc, (int)expected_length, (int)actual_length);
+  CuAssertStrEquals(tc, expected, actual);
+  free(expected);
+  free(actual);
+}
+
+void Test_player_save_matches_stripped_output(CuTest *tc)
+{
+  struct psave_fixture fixture;
+
+  CuAssertTrue(tc, psave_begin(&fixture));
+  psave_check_file(tc, &fixture, fixture.bare, "pfbare.plr");
+  psave_check_file(tc, &fixture, fixture.geared, "pfgeared.plr");
+
+  /* Saving again writes the same bytes. */
+  psave_check_file(tc, &fixture, fixture.geared, "pfgeared.plr");
+  psave_end(&fixture);
+}
+
+void Test_player_save_leaves_character_untouched(CuTest *tc)
+{
+  struct psave_fixture fixture;
+  struct char_data before;
+  struct affected_type *affects[8];
+  struct damage_reduction_type *dr_list;
+  struct affected_type *af;
+  uint64_t saves_before = 0, saves_after = 0, total_usec = 0, max_usec = 0;
+  int i, count = 0;
+
+  CuAssertTrue(tc, psave_begin(&fixture));
+  for (af = fixture.geared->affected; af && count < 8; af = af->next)
+    affects[count++] = af;
+  dr_list = GET_DR(fixture.geared);
+  before = *fixture.geared;
+  PERF_player_save_stats(&saves_before, &total_usec, &max_usec);
+
+  CuAssertTrue(tc, save_char_checked(fixture.geared, 0));
+
+  /* Same gear in the same slots, the same affect and DR records, and every
+   * derived value as it was. */
+  CuAssertPtrEquals(tc, fixture.helm, GET_EQ(fixture.geared, WEAR_HEAD));
+  CuAssertPtrEquals(tc, fixture.ring, GET_EQ(fixture.geared, WEAR_FINGER_R));
+  CuAssertPtrEquals(tc, fixture.geared, fixture.helm->worn_by);
+  for (i = 0, af = fixture.geared->affected; i < count; i++, af = af->next)
+    CuAssertPtrEquals(tc, affects[i], af);
+  CuAssertPtrEquals(tc, NULL, af);
+  CuAssertPtrEquals(tc, dr_list, GET_DR(fixture.geared));
+  CuAssertTrue(tc, !memcmp(&before.aff_abils, &fixture.geared->aff_abils,
+                           sizeof(before.aff_abils)));
+  CuAssertTrue(tc, !memcmp(&before.points, &fixture.geared->points, sizeof(before.points)));
+  CuAssertTrue(tc, !memcmp(&before.char_specials.saved, &fixture.geared->char_specials.saved,
+                           sizeof(before.char_specials.saved)));
+  CuAssertIntEquals(tc, before.player.height, fixture.geared->player.height);
+  CuAssertIntEquals(tc, before.player.weight, fixture.geared->player.weight);
+
+  PERF_player_save_stats(&saves_after, &total_usec, &max_usec);
+  CuAssertTrue(tc, saves_after == saves_before + 1);
+  CuAssertTrue(tc, max_usec <= total_usec);
+  psave_end(&fixture);
+}
@@ -0,0 +1,289 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/perfmon.h"
+#include "../../src/pubsub/pubsub.h"
+#include "test.helpers.h"
+
+#include <string.h>
+
+#define PUBSUB_TEST_TOPIC 9001
+#define PUBSUB_OTHER_TOPIC 9002
+#define PUBSUB_TEST_PLAYERS 6
+#define PUBSUB_BENCH_PLAYERS 2000
+#define PUBSUB_BENCH_SUBSCRIBERS 50
+#define PUBSUB_BENCH_SPACING (PUBSUB_BENCH_PLAYERS / PUBSUB_BENCH_SUBSCRIBERS)
+#define PUBSUB_BENCH_ROUNDS 20
+#define PUBSUB_BENCH_PUBLISHES 100 /* per round, under PUBSUB_QUEUE_MAX_SIZE queued */
+
+struct pubsub_index_fixture
+{
+  struct pubsub_topic topics[2];
+  struct char_data *players;
+  char **names;
+  int player_count;
+  struct descriptor_data desc;
+  struct pubsub_topic *saved_topic_list;
+  struct char_data *saved_character_list;
+  struct pubsub_message_queue saved_queue;
+  struct pubsub_statistics saved_stats;
+  bool saved_enabled, saved_processing;
+};
+
+/* Two topics and a list of players, all in the game with a (shared)
+ * connection. Nobody subscribes to anything yet. */
+static void begin_pubsub_index_fixture(struct pubsub_index_fixture *fixture, int player_count)
+{
+  char name[32];
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_topic_list = topic_list;
+  fixture->saved_character_list = character_list;
+  fixture->saved_queue = message_queue;
+  fixture->saved_stats = pubsub_stats;
+  fixture->saved_enabled = pubsub_system_enabled;
+  fixture->saved_processing = pubsub_queue_processing;
+
+  for (i = 0; i < 2; i++)
+  {
+    fixture->topics[i].topic_id = i ? PUBSUB_OTHER_TOPIC : PUBSUB_TEST_TOPIC;
+    fixture->topics[i].name = (char *)(i ? "other" : "test");
+    fixture->topics[i].message_ttl = 60;
+    fixture->topics[i].is_active = TRUE;
+  }
+  fixture->topics[0].next = &fixture->topics[1];
+  topic_list = &fixture->topics[0];
+
+  fixture->player_count = player_count;
+  CREATE(fixture->players, struct char_data, player_count);
+  CREATE(fixture->names, char *, player_count);
+  character_list = NULL;
+  for (i = player_count - 1; i >= 0; i--)
+  {
+    snprintf(name, sizeof(name), "Pubsubtester%d", i);
+    fixture->names[i] = strdup(name);
+    fixture->players[i].player.name = fixture->names[i];
+    fixture->players[i].desc = &fixture->desc;
+    fixture->players[i].next = character_list;
+    character_list = &fixture->players[i];
+  }
+
+  memset(&message_queue, 0, sizeof(message_queue));
+  pubsub_system_enabled = TRUE;
+  pubsub_queue_processing = TRUE;
+}
+
+static void end_pubsub_index_fixture(struct pubsub_index_fixture *fixture)
+{
+  int i;
+
+  for (i = 0; i < fixture->player_count; i++)
+  {
+    pubsub_index_player_offline(&fixture->players[i]);
+    pubsub_invalidate_player_cache(fixture->names[i]);
+    free(fixture->names[i]);
+  }
+  for (i = 0; i < 2; i++)
+    free(fixture->topics[i].online_subscribers);
+  free(fixture->players);
+  free(fixture->names);
+
+  topic_list = fixture->saved_topic_list;
+  character_list = fixture->saved_character_list;
+  message_queue = fixture->saved_queue;
+  pubsub_stats = fixture->saved_stats;
+  pubsub_system_enabled = fixture->saved_enabled;
+  pubsub_queue_processing = fixture->saved_processing;
+}
+
+/* How many queued nodes there are for ch, and whether they all share msg. */
+static int queued_for(struct char_data *ch, struct pubsub_message **msg)
+{
+  struct pubsub_queue_node *node;
+  int count = 0;
+
+  for (node = message_queue.normal_head; node; node = node->next)
+    if (node->target_player == ch)
+    {
+      if (*msg && node->message != *msg)
+        return -1;
+      *msg = node->message;
+      count++;
+    }
+  return count;
+}
+
+void Test_pubsub_index_publishes_to_online_subscribers_only(CuTest *tc)
+{
+  struct pubsub_index_fixture fixture;
+  struct pubsub_message *msg = NULL;
+  const int both[] = {PUBSUB_TEST_TOPIC, PUBSUB_OTHER_TOPIC}, other[] = {PUBSUB_OTHER_TOPIC};
+  int i;
+
+  begin_pubsub_index_fixture(&fixture, PUBSUB_TEST_PLAYERS);
+
+  /* 0-2 on the test topic, 3 only elsewhere, 4 on the test topic but link
+   * dead, 5 on nothing. */
+  for (i = 0; i < 3; i++)
+    pubsub_index_set_player_topics(&fixture.players[i], both, 2);
+  pubsub_index_set_player_topics(&fixture.players[3], other, 1);
+  pubsub_index_add(&fixture.players[4], PUBSUB_TEST_TOPIC);
+  fixture.players[4].desc = NULL;
+
+  CuAssertIntEquals(tc, PUBSUB_SUCCESS,
+                    pubsub_publish(PUBSUB_TEST_TOPIC, "Tester", "Hello", 0,
+                                   PUBSUB_PRIORITY_NORMAL));
+  CuAssertIntEquals(tc, 3, pubsub_queue_get_size());
+  for (i = 0; i < PUBSUB_TEST_PLAYERS; i++)
+    CuAssertIntEquals(tc, i < 3 ? 1 : 0, queued_for(&fixture.players[i], &msg));
+
+  /* One payload for every recipient, held once per queued node. */
+  CuAssertPtrNotNull(tc, msg);
+  CuAssertStrEquals(tc, "Hello", msg->content);
+  CuAssertIntEquals(tc, 3, msg->reference_count);
+
+  /* Leaving the game takes a player's queued messages with them. */
+  pubsub_index_player_offline(&fixture.players[1]);
+  CuAssertIntEquals(tc, 2, pubsub_queue_get_size());
+  CuAssertIntEquals(tc, 2, msg->reference_count);
+  CuAssertIntEquals(tc, 0, queued_for(&fixture.players[1], &msg));
+
+  CuAssertIntEquals(tc, PUBSUB_ERROR_NOT_FOUND,
+                    pubsub_publish(PUBSUB_TEST_TOPIC + 100, "Tester", "Nobody", 0,
+                                   PUBSUB_PRIORITY_NORMAL));
+
+  end_pubsub_index_fixture(&fixture);
+  CuAssertIntEquals(tc, 0, message_queue.total_queued);
+}
+
+void Test_pubsub_index_follows_subscription_changes(CuTest *tc)
+{
+  struct pubsub_index_fixture fixture;
+  const int test_only[] = {PUBSUB_TEST_TOPIC}, other_only[] = {PUBSUB_OTHER_TOPIC, 12345};
+  struct pubsub_topic *test = NULL, *other = NULL;
+
+  begin_pubsub_index_fixture(&fixture, PUBSUB_TEST_PLAYERS);
+  test = &fixture.topics[0];
+  other = &fixture.topics[1];
+
+  pubsub_index_set_player_topics(&fixture.players[0], test_only, 1);
+  pubsub_index_add(&fixture.players[0], PUBSUB_TEST_TOPIC);
+  pubsub_index_add(&fixture.players[1], PUBSUB_TEST_TOPIC);
+  CuAssertIntEquals(tc, 2, test->online_count);
+
+  /* A refresh replaces the old list; unknown topics are skipped. */
+  pubsub_index_set_player_topics(&fixture.players[0], other_only, 2);
+  CuAssertIntEquals(tc, 1, test->online_count);
+  CuAssertPtrEquals(tc, &fixture.players[1], test->online_subscribers[0]);
+  CuAssertIntEquals(tc, 1, other->online_count);
+
+  pubsub_index_remove(&fixture.players[1], PUBSUB_TEST_TOPIC);
+  CuAssertIntEquals(tc, 0, test->online_count);
+  CuAssertIntEquals(tc, PUBSUB_ERROR_NOT_FOUND,
+                    pubsub_publish(PUBSUB_TEST_TOPIC, "Tester", "Gone", 0,
+                                   PUBSUB_PRIORITY_NORMAL));
+
+  pubsub_index_player_offline(&fixture.players[0]);
+  CuAssertIntEquals(tc, 0, other->online_count);
+
+  end_pubsub_index_fixture(&fixture);
+}
+
+/* Cache entries as the database would have loaded them, so the old walk
+ * never reaches for SQL. */
+static void prime_subscription_cache(struct pubsub_index_fixture *fixture)
+{
+  struct pubsub_player_cache *cache;
+  int i, hash, c;
+
+  for (i = 0; i < fixture->player_count; i++)
+  {
+    CREATE(cache, struct pubsub_player_cache, 1);
+    cache->player_name = strdup(fixture->names[i]);
+    cache->last_cache_update = time(NULL);
+    CREATE(cache->subscribed_topics, int, 1);
+    cache->subscribed_topics[0] = i % PUBSUB_BENCH_SPACING ? PUBSUB_OTHER_TOPIC : PUBSUB_TEST_TOPIC;
+    cache->subscription_count = 1;
+    for (hash = 0, c = 0; cache->player_name[c]; c++)
+      hash = (hash * 31 + cache->player_name[c]) % SUBSCRIPTION_CACHE_SIZE;
+    cache->next = subscription_cache[hash];
+    subscription_cache[hash] = cache;
+
+    pubsub_index_set_player_topics(&fixture->players[i], cache->subscribed_topics, 1);
+  }
+}
+
+static void drain_queue(struct pubsub_index_fixture *fixture)
+{
+  int i;
+
+  for (i = 0; i < fixture->player_count; i += PUBSUB_BENCH_SPACING)
+    pubsub_queue_forget_player(&fixture->players[i]);
+}
+
+void Test_pubsub_index_benchmark(CuTest *tc)
+{
+  struct pubsub_index_fixture fixture;
+  struct pubsub_message *msg;
+  struct char_data *target;
+  uint64_t start, walk_usec = 0, index_usec = 0;
+  long walk_queued = 0, index_queued = 0;
+  int round, publish;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  begin_pubsub_index_fixture(&fixture, PUBSUB_BENCH_PLAYERS);
+  prime_subscription_cache(&fixture);
+  CuAssertIntEquals(tc, PUBSUB_BENCH_SUBSCRIBERS, fixture.topics[0].online_count);
+
+  for (round = 0; round < PUBSUB_BENCH_ROUNDS; round++)
+  {
+    /* The old fan-out: every character, a subscription check each and a
+     * message per publish. */
+    start = PERF_monotonic_usec();
+    for (publish = 0; publish < PUBSUB_BENCH_PUBLISHES; publish++)
+    {
+      msg = PUBSUB_CREATE_MESSAGE();
+      msg->topic_id = PUBSUB_TEST_TOPIC;
+      msg->sender_name = strdup("Tester");
+      msg->content = strdup("Benchmark");
+      msg->priority = PUBSUB_PRIORITY_NORMAL;
+      msg->reference_count = 1;
+      for (target = character_list; target; target = target->next)
+        if (!IS_NPC(target) && target->desc &&
+            pubsub_is_subscribed(GET_NAME(target), PUBSUB_TEST_TOPIC) &&
+            pubsub_queue_message(msg, target, "send_text") == PUBSUB_SUCCESS)
+          walk_queued++;
+      pubsub_release_message(msg);
+    }
+    walk_usec += PERF_monotonic_usec() - start;
+    drain_queue(&fixture);
+
+    start = PERF_monotonic_usec();
+    for (publish = 0; publish < PUBSUB_BENCH_PUBLISHES; publish++)
+      if (pubsub_publish(PUBSUB_TEST_TOPIC, "Tester", "Benchmark", 0, PUBSUB_PRIORITY_NORMAL) ==
+          PUBSUB_SUCCESS)
+        index_queued += PUBSUB_BENCH_SUBSCRIBERS;
+    index_usec += PERF_monotonic_usec() - start;
+    drain_queue(&fixture);
+  }
+
+  CuAssertTrue(tc, walk_queued == index_queued);
+  CuAssertIntEquals(tc, 0, pubsub_queue_get_size());
+  log("BENCHMARK: pubsub publish to %d of %d players, %d messages: character walk %llu usec, "
+      "subscriber index %llu usec",
+      PUBSUB_BENCH_SUBSCRIBERS, PUBSUB_BENCH_PLAYERS, PUBSUB_BENCH_ROUNDS * PUBSUB_BENCH_PUBLISHES,
+      (unsigned long long)walk_usec, (unsigned long long)index_usec);
+
+  end_pubsub_index_fixture(&fixture);
+}
@@ -0,0 +1,461 @@
+#include "CuTest.h"
+
+#include <math.h>
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/mysql.h"
+#include "../../src/wilderness/wilderness.h"
+#include "../../src/wilderness/region_grid.h"
+#include "../../src/wilderness/region_geometry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REGION_GEOM_FIXED_REGIONS 4
+#define REGION_GEOM_RANDOM_REGIONS 40
+#define REGION_GEOM_RANDOM_EXTENT 120
+#define REGION_GEOM_DIFF_SAMPLES 400
+#define REGION_GEOM_NEARBY_RADIUS 5
+
+struct region_geom_fixture
+{
+  struct region_data *regions;
+  int count;
+  struct region_data *saved_region_table;
+  region_rnum saved_top_of_region_table;
+  unsigned int seed;
+};
+
+static int region_geom_next(struct region_geom_fixture *fixture, int range)
+{
+  fixture->seed = fixture->seed * 1103515245U + 12345U;
+  return (int)((fixture->seed >> 8) % (unsigned int)range);
+}
+
+/* Closed ring, with the first vertex repeated the way load_regions() reads
+ * the exterior ring back from MariaDB. */
+static void region_geom_set_ring(struct region_data *region, const int *coords, int points)
+{
+  int v;
+
+  region->num_vertices = points + 1;
+  CREATE(region->vertices, struct vertex, region->num_vertices);
+  for (v = 0; v < points; v++)
+  {
+    region->vertices[v].x = coords[v * 2];
+    region->vertices[v].y = coords[v * 2 + 1];
+  }
+  region->vertices[points] = region->vertices[0];
+}
+
+/* Star-shaped octagons: one vertex every 45 degrees at a random radius, so
+ * the ring never crosses itself and MariaDB accepts it as a valid polygon. */
+static void region_geom_random_ring(struct region_geom_fixture *fixture,
+                                    struct region_data *region)
+{
+  int coords[16];
+  int cx, cy, v, radius;
+
+  cx = region_geom_next(fixture, REGION_GEOM_RANDOM_EXTENT);
+  cy = region_geom_next(fixture, REGION_GEOM_RANDOM_EXTENT);
+  for (v = 0; v < 8; v++)
+  {
+    radius = 3 + region_geom_next(fixture, 18);
+    coords[v * 2] = cx + (int)lround(radius * cos(v * M_PI / 4.0));
+    coords[v * 2 + 1] = cy + (int)lround(radius * sin(v * M_PI / 4.0));
+  }
+  region_geom_set_ring(region, coords, 8);
+}
+
+static void begin_region_geom_fixture(struct region_geom_fixture *fixture, int random_regions)
+{
+  /* A 10x10 square, an L whose notch faces north-east, a square that is
+   * not geographic, and a square far away from everything. */
+  static const int square[] = {0, 0, 10, 0, 10, 10, 0, 10};
+  static const int ell[] = {20, 0, 40, 0, 40, 10, 30, 10, 30, 20, 20, 20};
+  static const int other[] = {0, 30, 10, 30, 10, 40, 0, 40};
+  static const int far[] = {500, 500, 510, 500, 510, 510, 500, 510};
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->seed = 777U;
+  fixture->saved_region_table = region_table;
+  fixture->saved_top_of_region_table = top_of_region_table;
+  fixture->count = REGION_GEOM_FIXED_REGIONS + random_regions;
+
+  CREATE(fixture->regions, struct region_data, fixture->count);
+  for (i = 0; i < fixture->count; i++)
+  {
+    fixture->regions[i].vnum = 100 + i;
+    fixture->regions[i].rnum = i;
+    fixture->regions[i].zone = i % 3;
+    fixture->regions[i].region_type = REGION_GEOGRAPHIC;
+  }
+  region_geom_set_ring(&fixture->regions[0], square, 4);
+  region_geom_set_ring(&fixture->regions[1], ell, 6);
+  region_geom_set_ring(&fixture->regions[2], other, 4);
+  fixture->regions[2].region_type = REGION_ENCOUNTER;
+  region_geom_set_ring(&fixture->regions[3], far, 4);
+  for (i = REGION_GEOM_FIXED_REGIONS; i < fixture->count; i++)
+  {
+    region_geom_random_ring(fixture, &fixture->regions[i]);
+    if (i % 7 == 0)
+      fixture->regions[i].region_type = REGION_ENCOUNTER;
+  }
+
+  region_table = fixture->regions;
+  top_of_region_table = fixture->count - 1;
+  region_grid_build_regions();
+}
+
+static void end_region_geom_fixture(struct region_geom_fixture *fixture)
+{
+  int i;
+
+  region_grid_free_regions();
+  for (i = 0; i < fixture->count; i++)
+    free(fixture->regions[i].vertices);
+  free(fixture->regions);
+  region_table = fixture->saved_region_table;
+  top_of_region_table = fixture->saved_top_of_region_table;
+}
+
+static void free_nearby_list(struct region_proximity_list *list)
+{
+  struct region_proximity_list *next;
+
+  for (; list; list = next)
+  {
+    next = list->next;
+    free(list);
+  }
+}
+
+static struct region_proximity_list *find_nearby(struct region_proximity_list *list,
+                                                 region_rnum rnum)
+{
+  for (; list; list = list->next)
+    if (list->rnum == rnum)
+      return list;
+  return NULL;
+}
+
+void Test_region_geometry_predicates_match_ogc_semantics(CuTest *tc)
+{
+  struct region_geom_fixture fixture;
+  const struct region_data *square, *ell;
+
+  begin_region_geom_fixture(&fixture, 0);
+  square = &region_table[0];
+  ell = &region_table[1];
+
+  /* ST_Within: strict interior only. */
+  CuAssertTrue(tc, region_geom_point_within(square->vertices, square->num_vertices, 5, 5));
+  CuAssertTrue(tc, !region_geom_point_within(square->vertices, square->num_vertices, 0, 5));
+  CuAssertTrue(tc, !region_geom_point_within(square->vertices, square->num_vertices, 10, 10));
+  CuAssertTrue(tc, !region_geom_point_within(ell->vertices, ell->num_vertices, 35, 15));
+  CuAssertTrue(tc, region_geom_point_within(ell->vertices, ell->num_vertices, 25, 15));
+
+  /* ST_Distance: 0 inside and on the boundary. */
+  CuAssertDblEquals(tc, 0.0,
+                    region_geom_point_distance(square->vertices, square->num_vertices, 5, 5),
+                    1e-12);
+  CuAssertDblEquals(tc, 0.0,
+                    region_geom_point_distance(square->vertices, square->num_vertices, 10, 4),
+                    1e-12);
+  CuAssertDblEquals(tc, 3.0,
+                    region_geom_point_distance(square->vertices, square->num_vertices, 13, 5),
+                    1e-12);
+  CuAssertDblEquals(tc, 5.0,
+                    region_geom_point_distance(square->vertices, square->num_vertices, 13, 14),
+                    1e-12);
+  /* Inside the L's notch the nearest edges are the notch walls. */
+  CuAssertDblEquals(tc, 3.0, region_geom_point_distance(ell->vertices, ell->num_vertices, 35, 13),
+                    1e-12);
+
+  /* ST_Intersects against closed rectangles. */
+  CuAssertTrue(tc, region_geom_intersects_rect(square->vertices, square->num_vertices, 2, 2, 4, 4));
+  CuAssertTrue(tc,
+               region_geom_intersects_rect(square->vertices, square->num_vertices, -5, -5, 20, 20));
+  CuAssertTrue(tc,
+               region_geom_intersects_rect(square->vertices, square->num_vertices, 10, 10, 12, 12));
+  CuAssertTrue(tc,
+               !region_geom_intersects_rect(square->vertices, square->num_vertices, 11, 0, 12, 10));
+  CuAssertTrue(tc, !region_geom_intersects_rect(ell->vertices, ell->num_vertices, 32, 12, 38, 18));
+  CuAssertTrue(tc, region_geom_intersects_rect(ell->vertices, ell->num_vertices, 28, 12, 38, 18));
+
+  /* is_point_within_region() works from the loaded vertices by vnum. */
+  CuAssertTrue(tc, is_point_within_region(100, 5, 5));
+  CuAssertTrue(tc, !is_point_within_region(100, 10, 5));
+  CuAssertTrue(tc, !is_point_within_region(999, 5, 5));
+
+  end_region_geom_fixture(&fixture);
+}
+
+void Test_region_geometry_nearby_regions_positions_and_sectors(CuTest *tc)
+{
+  struct region_geom_fixture fixture;
+  struct region_proximity_list *list, *node;
+  int d;
+
+  begin_region_geom_fixture(&fixture, 0);
+
+  /* Three tiles east of the square: it reaches into the west-facing sectors. */
+  list = get_nearby_regions(0, 13, 5, REGION_GEOM_NEARBY_RADIUS);
+  node = find_nearby(list, 0);
+  CuAssertPtrNotNull(tc, node);
+  CuAssertIntEquals(tc, REGION_POS_UNDEFINED, node->pos);
+  CuAssertTrue(tc, !node->is_inside);
+  CuAssertDblEquals(tc, 3.0, node->dist, 1e-12);
+  CuAssertDblEquals(tc, 25.0, node->dirs[5], 1e-12); /* sw */
+  CuAssertDblEquals(tc, 25.0, node->dirs[6], 1e-12); /* w */
+  CuAssertDblEquals(tc, 25.0, node->dirs[7], 1e-12); /* nw */
+  for (d = 0; d < 5; d++)
+    CuAssertDblEquals(tc, 0.0, node->dirs[d], 1e-12);
+  /* The L is seven tiles away: out of range. */
+  CuAssertTrue(tc, find_nearby(list, 1) == NULL);
+  free_nearby_list(list);
+
+  /* On the boundary and inside. */
+  list = get_nearby_regions(0, 10, 5, REGION_GEOM_NEARBY_RADIUS);
+  node = find_nearby(list, 0);
+  CuAssertPtrNotNull(tc, node);
+  CuAssertIntEquals(tc, REGION_POS_EDGE, node->pos);
+  CuAssertTrue(tc, node->is_inside);
+  for (d = 0; d < 8; d++)
+    CuAssertDblEquals(tc, 100.0, node->dirs[d], 1e-12);
+  free_nearby_list(list);
+
+  list = get_nearby_regions(0, 5, 5, REGION_GEOM_NEARBY_RADIUS);
+  node = find_nearby(list, 0);
+  CuAssertPtrNotNull(tc, node);
+  CuAssertIntEquals(tc, REGION_POS_INSIDE, node->pos);
+  CuAssertDblEquals(tc, 0.0, node->dist, 1e-12);
+  free_nearby_list(list);
+
+  /* Between the square and the L: both listed, farthest first, and the
+   * non-geographic square to the north never is. */
+  list = get_nearby_regions(0, 14, 28, 20);
+  CuAssertPtrNotNull(tc, list);
+  CuAssertTrue(tc, find_nearby(list, 2) == NULL);
+  for (node = list; node && node->next; node = node->next)
+    CuAssertTrue(tc, node->dist >= node->next->dist);
+  CuAssertPtrNotNull(tc, find_nearby(list, 0));
+  CuAssertPtrNotNull(tc, find_nearby(list, 1));
+  free_nearby_list(list);
+
+  CuAssertTrue(tc, get_nearby_regions(0, 300, 300, REGION_GEOM_NEARBY_RADIUS) == NULL);
+
+  end_region_geom_fixture(&fixture);
+}
+
+/* The query get_nearby_regions() used to send, kept here as the reference
+ * the native version is checked against. */
+static bool region_geom_sql_nearby(MYSQL *connection, int x, int y, int r,
+                                   struct region_proximity_list **out)
+{
+  char buf[8192];
+  MYSQL_RES *result;
+  MYSQL_ROW row;
+  struct region_proximity_list *node;
+  int i;
+
+  *out = NULL;
+  snprintf(
+      buf, sizeof(buf),
+      "SELECT ri.vnum, rd.name, "
+      "CASE WHEN ST_Within(ST_GeomFromText('POINT(%d %d)'), ri.region_polygon) THEN 'INSIDE' "
+      "WHEN ST_Distance(ri.region_polygon, ST_GeomFromText('POINT(%d %d)')) = 0 THEN 'EDGE' "
+      "ELSE 'NEARBY' END AS position, "
+      "ST_Distance(ri.region_polygon, ST_GeomFromText('POINT(%d %d)')) AS distance, "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')), "
+      "ST_Intersects(ri.region_polygon, ST_GeomFromText('POLYGON((%d %d, %d %d, %d %d, %d %d, %d "
+      "%d))')) "
+      "FROM region_index ri JOIN region_data rd ON ri.vnum = rd.vnum "
+      "WHERE rd.region_type = 1 "
+      "AND (ST_Within(ST_GeomFromText('POINT(%d %d)'), ri.region_polygon) "
+      "OR ST_Distance(ri.region_polygon, ST_GeomFromText('POINT(%d %d)')) <= %d) "
+      "ORDER BY distance ASC",
+      x, y, x, y, x, y, x - 1, y + 1, x + 1, y + 1, x + 1, y + r, x - 1, y + r, x - 1, y + 1,
+      x + 1, y + 1, x + r, y + 1, x + r, y + r, x + 1, y + r, x + 1, y + 1, x + 1, y - 1, x + r,
+      y - 1, x + r, y + 1, x + 1, y + 1, x + 1, y - 1, x + 1, y - r, x + r, y - r, x + r, y - 1,
+      x + 1, y - 1, x + 1, y - r, x - 1, y - r, x + 1, y - r, x + 1, y - 1, x - 1, y - 1, x - 1,
+      y - r, x - r, y - r, x - 1, y - r, x - 1, y - 1, x - r, y - 1, x - r, y - r, x - r, y - 1,
+      x - 1, y - 1, x - 1, y + 1, x - r, y + 1, x - r, y - 1, x - r, y + 1, x - 1, y + 1, x - 1,
+      y + r, x - r, y + r, x - r, y + 1, x, y, x, y, r);
+
+  if (mysql_query(connection, buf) || !(result = mysql_store_result(connection)))
+    return false;
+
+  while ((row = mysql_fetch_row(result)))
+  {
+    CREATE(node, struct region_proximity_list, 1);
+    node->rnum = real_region(atoi(row[0]));
+    node->dist = atof(row[3]);
+    node->pos = !strcmp(row[2], "INSIDE") ? REGION_POS_INSIDE
+                : !strcmp(row[2], "EDGE") ? REGION_POS_EDGE
+                                          : REGION_POS_UNDEFINED;
+    node->is_inside = node->pos != REGION_POS_UNDEFINED;
+    for (i = 0; i < 8; i++)
+      node->dirs[i] = node->is_inside ? 100.0
+                      : atoi(row[i + 4]) ? (node->dist > 0 ? 100.0 / (1.0 + node->dist) : 100.0)
+                                         : 0.0;
+    node->next = *out;
+    *out = node;
+  }
+  mysql_free_result(result);
+  return true;
+}
+
+static bool region_geom_sql_within(MYSQL *connection, region_vnum vnum, int x, int y)
+{
+  char buf[512];
+  MYSQL_RES *result;
+  bool found;
+
+  snprintf(buf, sizeof(buf),
+           "SELECT 1 FROM region_index WHERE vnum = %d AND "
+           "ST_Within(ST_GeomFromText('POINT(%d %d)'), region_polygon)",
+           vnum, x, y);
+  if (mysql_query(connection, buf) || !(result = mysql_store_result(connection)))
+    return false;
+  found = mysql_fetch_row(result) != NULL;
+  mysql_free_result(result);
+  return found;
+}
+
+static bool region_geom_load_temporary_tables(MYSQL *connection)
+{
+  char buf[4096];
+  size_t len;
+  int i, v;
+
+  if (mysql_query(connection,
+                  "CREATE TEMPORARY TABLE region_data (vnum INT PRIMARY KEY, "
+                  "zone_vnum INT NOT NULL, name VARCHAR(50), region_type INT NOT NULL)") ||
+      mysql_query(connection, "CREATE TEMPORARY TABLE region_index (vnum INT PRIMARY KEY, "
+                              "zone_vnum INT NOT NULL, region_polygon POLYGON NOT NULL)"))
+    return false;
+
+  for (i = 0; i <= (int)top_of_region_table; i++)
+  {
+    snprintf(buf, sizeof(buf), "INSERT INTO region_data VALUES (%d, %d, 'fixture %d', %d)",
+             region_table[i].vnum, region_table[i].zone, i, region_table[i].region_type);
+    if (mysql_query(connection, buf))
+      return false;
+
+    len = snprintf(buf, sizeof(buf),
+                   "INSERT INTO region_index VALUES (%d, %d, ST_GeomFromText('POLYGON((",
+                   region_table[i].vnum, region_table[i].zone);
+    for (v = 0; v < region_table[i].num_vertices && len < sizeof(buf); v++)
+      len += snprintf(buf + len, sizeof(buf) - len, "%s%d %d", v ? ", " : "",
+                      region_table[i].vertices[v].x, region_table[i].vertices[v].y);
+    if (len < sizeof(buf))
+      snprintf(buf + len, sizeof(buf) - len, "))'))");
+    if (mysql_query(connection, buf))
+      return false;
+  }
+  return true;
+}
+
+static MYSQL *region_geom_open_test_database(void)
+{
+  const char *port_text = getenv("LUMINARI_TEST_MYSQL_PORT");
+  MYSQL *connection;
+
+  if (!getenv("LUMINARI_TEST_MYSQL_HOST") || !getenv("LUMINARI_TEST_MYSQL_USER") ||
+      !getenv("LUMINARI_TEST_MYSQL_PASSWORD") || !getenv("LUMINARI_TEST_MYSQL_DATABASE"))
+    return NULL;
+  if ((connection = mysql_init(NULL)) == NULL)
+    return NULL;
+  if (mysql_real_connect(connection, getenv("LUMINARI_TEST_MYSQL_HOST"),
+                         getenv("LUMINARI_TEST_MYSQL_USER"), getenv("LUMINARI_TEST_MYSQL_PASSWORD"),
+                         getenv("LUMINARI_TEST_MYSQL_DATABASE"),
+                         port_text ? (unsigned int)strtoul(port_text, NULL, 10) : 3306, NULL,
+                         0) == NULL)
+  {
+    mysql_close(connection);
+    return NULL;
+  }
+  return connection;
+}
+
+/* Needs a real MariaDB: set LUMINARI_TEST_MYSQL_ENABLE=1 and the
+ * LUMINARI_TEST_MYSQL_* connection variables. The fixture is loaded into
+ * session-temporary region_data/region_index tables that shadow the real
+ * ones, and every sample point is answered both ways. */
+void Test_region_geometry_matches_sql_on_fixture_regions(CuTest *tc)
+{
+  const char *enabled = getenv("LUMINARI_TEST_MYSQL_ENABLE");
+  struct region_geom_fixture fixture;
+  struct region_proximity_list *native, *sql, *node, *match;
+  MYSQL *connection;
+  int sample, x, y, d, native_count, sql_count;
+  region_rnum rnum;
+
+  if (enabled == NULL || strcmp(enabled, "1") != 0)
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+  if ((connection = region_geom_open_test_database()) == NULL)
+  {
+    CuFail(tc, "could not connect to the explicitly configured test database");
+    return;
+  }
+
+  begin_region_geom_fixture(&fixture, REGION_GEOM_RANDOM_REGIONS);
+  CuAssertTrue(tc, region_geom_load_temporary_tables(connection));
+
+  for (sample = 0; sample < REGION_GEOM_DIFF_SAMPLES; sample++)
+  {
+    x = region_geom_next(&fixture, REGION_GEOM_RANDOM_EXTENT + 40) - 20;
+    y = region_geom_next(&fixture, REGION_GEOM_RANDOM_EXTENT + 40) - 20;
+
+    native = get_nearby_regions(0, x, y, REGION_GEOM_NEARBY_RADIUS);
+    CuAssertTrue(tc, region_geom_sql_nearby(connection, x, y, REGION_GEOM_NEARBY_RADIUS, &sql));
+
+    native_count = sql_count = 0;
+    for (node = native; node; node = node->next)
+      native_count++;
+    for (node = sql; node; node = node->next)
+    {
+      sql_count++;
+      match = find_nearby(native, node->rnum);
+      CuAssertPtrNotNull(tc, match);
+      CuAssertIntEquals(tc, node->pos, match->pos);
+      CuAssertDblEquals(tc, node->dist, match->dist, 1e-6);
+      for (d = 0; d < 8; d++)
+        CuAssertDblEquals(tc, node->dirs[d], match->dirs[d], 1e-6);
+    }
+    CuAssertIntEquals(tc, sql_count, native_count);
+    free_nearby_list(native);
+    free_nearby_list(sql);
+
+    rnum = region_geom_next(&fixture, fixture.count);
+    CuAssertIntEquals(tc, region_geom_sql_within(connection, region_table[rnum].vnum, x, y),
+                      is_point_within_region(region_table[rnum].vnum, x, y));
+  }
+
+  end_region_geom_fixture(&fixture);
+  mysql_close(connection);
+}
@@ -0,0 +1,308 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/mysql.h"
+#include "../../src/perfmon.h"
+#include "../../src/wilderness/wilderness.h"
+#include "../../src/wilderness/region_grid.h"
+#include "test.helpers.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define REGION_GRID_TEST_REGIONS 600
+#define REGION_GRID_TEST_PATHS 200
+#define REGION_GRID_TEST_EXTENT 1024
+#define REGION_GRID_MAP_SIZE 41
+#define REGION_GRID_BENCH_MAPS 25
+#define REGION_GRID_TEST_SAMPLES 20000
+
+struct region_grid_fixture
+{
+  struct region_data *regions;
+  struct path_data *paths;
+  struct region_data *saved_region_table;
+  struct path_data *saved_path_table;
+  region_rnum saved_top_of_region_table;
+  path_rnum saved_top_of_path_table;
+  unsigned int seed;
+};
+
+static int region_grid_next(struct region_grid_fixture *fixture, int range)
+{
+  fixture->seed = fixture->seed * 1103515245U + 12345U;
+  return (int)((fixture->seed >> 8) % (unsigned int)range);
+}
+
+/* Random convex-ish and concave polygons: a jittered ring of vertices around
+ * a centre, with every other vertex pulled in for the concave ones. */
+static void region_grid_random_polygon(struct region_grid_fixture *fixture,
+                                       struct region_data *region)
+{
+  static const int ring_x[8] = {2, 2, 0, -2, -2, -2, 0, 2};
+  static const int ring_y[8] = {0, 2, 2, 2, 0, -2, -2, -2};
+  int cx, cy, radius, v, concave;
+
+  cx = region_grid_next(fixture, REGION_GRID_TEST_EXTENT * 2) - REGION_GRID_TEST_EXTENT;
+  cy = region_grid_next(fixture, REGION_GRID_TEST_EXTENT * 2) - REGION_GRID_TEST_EXTENT;
+  radius = 3 + region_grid_next(fixture, 40);
+  concave = region_grid_next(fixture, 2);
+
+  region->num_vertices = 8;
+  CREATE(region->vertices, struct vertex, region->num_vertices);
+  for (v = 0; v < 8; v++)
+  {
+    int r = (concave && (v % 2)) ? radius / 2 : radius;
+    region->vertices[v].x = cx + ring_x[v] * r / 2 + region_grid_next(fixture, 3) - 1;
+    region->vertices[v].y = cy + ring_y[v] * r / 2 + region_grid_next(fixture, 3) - 1;
+  }
+}
+
+/* Axis-aligned polylines, like the rivers generate_river() lays down. */
+static void region_grid_random_path(struct region_grid_fixture *fixture, struct path_data *path)
+{
+  int v, x, y, step;
+
+  path->num_vertices = 2 + region_grid_next(fixture, 5);
+  CREATE(path->vertices, struct vertex, path->num_vertices);
+  x = region_grid_next(fixture, REGION_GRID_TEST_EXTENT * 2) - REGION_GRID_TEST_EXTENT;
+  y = region_grid_next(fixture, REGION_GRID_TEST_EXTENT * 2) - REGION_GRID_TEST_EXTENT;
+  for (v = 0; v < path->num_vertices; v++)
+  {
+    path->vertices[v].x = x;
+    path->vertices[v].y = y;
+    step = 1 + region_grid_next(fixture, 60);
+    if (v % 2)
+      x += region_grid_next(fixture, 2) ? step : -step;
+    else
+      y += region_grid_next(fixture, 2) ? step : -step;
+  }
+}
+
+static void begin_region_grid_fixture(struct region_grid_fixture *fixture)
+{
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->seed = 20240611U;
+  fixture->saved_region_table = region_table;
+  fixture->saved_top_of_region_table = top_of_region_table;
+  fixture->saved_path_table = path_table;
+  fixture->saved_top_of_path_table = top_of_path_table;
+
+  CREATE(fixture->regions, struct region_data, REGION_GRID_TEST_REGIONS);
+  for (i = 0; i < REGION_GRID_TEST_REGIONS; i++)
+  {
+    fixture->regions[i].vnum = 1000 + i;
+    fixture->regions[i].rnum = i;
+    /* A few regions belong to another zone and must never be reported. */
+    fixture->regions[i].zone = (i % 17 == 0) ? 1 : 0;
+    fixture->regions[i].region_type = REGION_GEOGRAPHIC;
+    region_grid_random_polygon(fixture, &fixture->regions[i]);
+  }
+  /* One continent-sized region covering everything else. */
+  free(fixture->regions[0].vertices);
+  CREATE(fixture->regions[0].vertices, struct vertex, 4);
+  fixture->regions[0].num_vertices = 4;
+  fixture->regions[0].zone = 0;
+  fixture->regions[0].vertices[0].x = -REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[0].y = -REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[1].x = REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[1].y = -REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[2].x = REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[2].y = REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[3].x = -REGION_GRID_TEST_EXTENT;
+  fixture->regions[0].vertices[3].y = REGION_GRID_TEST_EXTENT;
+
+  CREATE(fixture->paths, struct path_data, REGION_GRID_TEST_PATHS);
+  for (i = 0; i < REGION_GRID_TEST_PATHS; i++)
+  {
+    fixture->paths[i].vnum = 5000 + i;
+    fixture->paths[i].rnum = i;
+    fixture->paths[i].zone = (i % 13 == 0) ? 1 : 0;
+    fixture->paths[i].path_type = PATH_RIVER;
+    region_grid_random_path(fixture, &fixture->paths[i]);
+  }
+
+  region_table = fixture->regions;
+  top_of_region_table = REGION_GRID_TEST_REGIONS - 1;
+  path_table = fixture->paths;
+  top_of_path_table = REGION_GRID_TEST_PATHS - 1;
+}
+
+static void end_region_grid_fixture(struct region_grid_fixture *fixture)
+{
+  int i;
+
+  region_grid_free_regions();
+  region_grid_free_paths();
+  for (i = 0; i < REGION_GRID_TEST_REGIONS; i++)
+    free(fixture->regions[i].vertices);
+  for (i = 0; i < REGION_GRID_TEST_PATHS; i++)
+    free(fixture->paths[i].vertices);
+  free(fixture->regions);
+  free(fixture->paths);
+  region_table = fixture->saved_region_table;
+  top_of_region_table = fixture->saved_top_of_region_table;
+  path_table = fixture->saved_path_table;
+  top_of_path_table = fixture->saved_top_of_path_table;
+}
+
+static bool region_lists_equal(struct region_list *a, struct region_list *b)
+{
+  for (; a && b; a = a->next, b = b->next)
+    if (a->rnum != b->rnum || a->pos != b->pos)
+      return FALSE;
+  return a == NULL && b == NULL;
+}
+
+static bool path_lists_equal(struct path_list *a, struct path_list *b)
+{
+  for (; a && b; a = a->next, b = b->next)
+    if (a->rnum != b->rnum || a->glyph_type != b->glyph_type)
+      return FALSE;
+  return a == NULL && b == NULL;
+}
+
+/* Region and path lookups for every tile of one map, as get_map() does. */
+static int region_grid_render_map(int center_x, int center_y)
+{
+  struct region_list *regions, *r;
+  struct path_list *paths, *p;
+  int x, y, hits = 0;
+  int half = (REGION_GRID_MAP_SIZE - 1) / 2;
+
+  for (y = center_y - half; y <= center_y + half; y++)
+    for (x = center_x - half; x <= center_x + half; x++)
+    {
+      regions = get_enclosing_regions(0, x, y);
+      paths = get_enclosing_paths(0, x, y);
+      for (r = regions; r; r = r->next)
+        hits++;
+      for (p = paths; p; p = p->next)
+        hits++;
+      free_region_list(regions);
+      free_path_list(paths);
+    }
+  return hits;
+}
+
+void Test_region_grid_matches_full_table_scan(CuTest *tc)
+{
+  static struct region_list *scanned_regions[REGION_GRID_TEST_SAMPLES];
+  static struct path_list *scanned_paths[REGION_GRID_TEST_SAMPLES];
+  struct region_grid_fixture fixture;
+  struct region_list *indexed_regions;
+  struct path_list *indexed_paths;
+  unsigned int sample_seed;
+  int sample, x, y, found = 0;
+
+  begin_region_grid_fixture(&fixture);
+  sample_seed = fixture.seed;
+
+  /* Same sample points twice: first with a plain table scan, then through the grid. */
+  for (sample = 0; sample < REGION_GRID_TEST_SAMPLES; sample++)
+  {
+    x = region_grid_next(&fixture, REGION_GRID_TEST_EXTENT * 2 + 40) - REGION_GRID_TEST_EXTENT - 20;
+    y = region_grid_next(&fixture, REGION_GRID_TEST_EXTENT * 2 + 40) - REGION_GRID_TEST_EXTENT - 20;
+    scanned_regions[sample] = get_enclosing_regions(0, x, y);
+    scanned_paths[sample] = get_enclosing_paths(0, x, y);
+  }
+
+  region_grid_build_regions();
+  region_grid_build_paths();
+  fixture.seed = sample_seed;
+  for (sample = 0; sample < REGION_GRID_TEST_SAMPLES; sample++)
+  {
+    x = region_grid_next(&fixture, REGION_GRID_TEST_EXTENT * 2 + 40) - REGION_GRID_TEST_EXTENT - 20;
+    y = region_grid_next(&fixture, REGION_GRID_TEST_EXTENT * 2 + 40) - REGION_GRID_TEST_EXTENT - 20;
+    indexed_regions = get_enclosing_regions(0, x, y);
+    indexed_paths = get_enclosing_paths(0, x, y);
+
+    CuAssertTrue(tc, region_lists_equal(scanned_regions[sample], indexed_regions));
+    CuAssertTrue(tc, path_lists_equal(scanned_paths[sample], indexed_paths));
+    if (indexed_paths || (indexed_regions && indexed_regions->next))
+      found++;
+
+    free_region_list(scanned_regions[sample]);
+    free_region_list(indexed_regions);
+    free_path_list(scanned_paths[sample]);
+    free_path_list(indexed_paths);
+  }
+  /* Make sure the fixture actually exercised overlaps and paths. */
+  CuAssertTrue(tc, found > 100);
+
+  end_region_grid_fixture(&fixture);
+}
+
+void Test_region_grid_ignores_a_swapped_table(CuTest *tc)
+{
+  struct region_grid_fixture fixture;
+  struct region_data single;
+  struct vertex square[4] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}};
+  struct region_list *regions;
+  const int *candidates;
+
+  begin_region_grid_fixture(&fixture);
+  region_grid_build_regions();
+  CuAssertTrue(tc, region_grid_region_candidates(0, 0, &candidates) >= 1);
+
+  /* Code that swaps in its own table (tests, reloads) gets a plain scan. */
+  memset(&single, 0, sizeof(single));
+  single.vertices = square;
+  single.num_vertices = 4;
+  region_table = &single;
+  top_of_region_table = 0;
+  CuAssertIntEquals(tc, -1, region_grid_region_candidates(5, 5, &candidates));
+  regions = get_enclosing_regions(0, 5, 5);
+  CuAssertPtrNotNull(tc, regions);
+  CuAssertIntEquals(tc, 0, (int)regions->rnum);
+  free_region_list(regions);
+
+  region_table = fixture.regions;
+  top_of_region_table = REGION_GRID_TEST_REGIONS - 1;
+  end_region_grid_fixture(&fixture);
+}
+
+void Test_region_grid_benchmark_full_map_render(CuTest *tc)
+{
+  struct region_grid_fixture fixture;
+  uint64_t start_usec, scan_usec, grid_usec;
+  int i, scan_hits = 0, grid_hits = 0;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  begin_region_grid_fixture(&fixture);
+
+  region_grid_free_regions();
+  region_grid_free_paths();
+  start_usec = PERF_monotonic_usec();
+  for (i = 0; i < REGION_GRID_BENCH_MAPS; i++)
+    scan_hits += region_grid_render_map(i * 37 - 400, i * -29 + 300);
+  scan_usec = PERF_monotonic_usec() - start_usec;
+
+  region_grid_build_regions();
+  region_grid_build_paths();
+  start_usec = PERF_monotonic_usec();
+  for (i = 0; i < REGION_GRID_BENCH_MAPS; i++)
+    grid_hits += region_grid_render_map(i * 37 - 400, i * -29 + 300);
+  grid_usec = PERF_monotonic_usec() - start_usec;
+
+  CuAssertIntEquals(tc, scan_hits, grid_hits);
+  log("BENCHMARK: %d full %dx%d map region/path passes over %d regions and %d paths took "
+      "%llu usec scanning, %llu usec with the region grid.",
+      REGION_GRID_BENCH_MAPS, REGION_GRID_MAP_SIZE, REGION_GRID_MAP_SIZE,
+      REGION_GRID_TEST_REGIONS, REGION_GRID_TEST_PATHS, (unsigned long long)scan_usec,
+      (unsigned long long)grid_usec);
+
+  end_region_grid_fixture(&fixture);
+}
@@ -0,0 +1,350 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/db.h"
+#include "../../src/wilderness/wilderness.h"
+#include "../../src/wilderness/spatial_core.h"
+#include "../../src/wilderness/spatial_grid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GRID_TEST_ITEMS 600
+#define GRID_TEST_SPREAD 2600 /* past the grid's edges on every side */
+
+struct grid_test_item
+{
+  int x, y;
+  int cell;
+  bool filed;
+  bool found;
+};
+
+static unsigned int grid_test_seed;
+
+static int grid_test_random(int low, int high)
+{
+  grid_test_seed = grid_test_seed * 1103515245u + 12345u;
+  return low + (int)((grid_test_seed >> 8) % (unsigned int)(high - low + 1));
+}
+
+/* Every query must find exactly the filed items inside its square. */
+static void grid_test_check_query(CuTest *tc, struct spatial_grid *grid,
+                                  struct grid_test_item *items, int x, int y, int range,
+                                  struct spatial_grid_result *result)
+{
+  int i, expected = 0;
+
+  for (i = 0; i < GRID_TEST_ITEMS; i++)
+    items[i].found = FALSE;
+
+  spatial_grid_query(grid, x, y, range, result);
+  for (i = 0; i < result->count; i++)
+  {
+    struct grid_test_item *item = result->items[i];
+
+    CuAssertTrue(tc, item->filed && !item->found);
+    item->found = TRUE;
+  }
+
+  for (i = 0; i < GRID_TEST_ITEMS; i++)
+    if (items[i].filed && abs(items[i].x - x) <= range && abs(items[i].y - y) <= range)
+    {
+      CuAssertTrue(tc, items[i].found);
+      expected++;
+    }
+  CuAssertIntEquals(tc, expected, result->count);
+}
+
+void Test_spatial_grid_query_matches_scan(CuTest *tc)
+{
+  static const int ranges[] = {0, 3, 31, 32, 100, 700, 5000};
+  struct spatial_grid grid;
+  struct spatial_grid_result result;
+  struct grid_test_item *items;
+  int i, r, q, filed = 0;
+
+  memset(&grid, 0, sizeof(grid));
+  memset(&result, 0, sizeof(result));
+  CREATE(items, struct grid_test_item, GRID_TEST_ITEMS);
+  grid_test_seed = 7;
+
+  for (i = 0; i < GRID_TEST_ITEMS; i++)
+  {
+    /* Crowd a few cells as well as spreading out. */
+    if (i % 4 == 0)
+    {
+      items[i].x = grid_test_random(-40, 40);
+      items[i].y = grid_test_random(-40, 40);
+    }
+    else
+    {
+      items[i].x = grid_test_random(-GRID_TEST_SPREAD, GRID_TEST_SPREAD);
+      items[i].y = grid_test_random(-GRID_TEST_SPREAD, GRID_TEST_SPREAD);
+    }
+    items[i].cell = spatial_grid_insert(&grid, &items[i], items[i].x, items[i].y);
+    items[i].filed = TRUE;
+  }
+
+  /* Take some out again, emptying cells along the way. */
+  for (i = 0; i < GRID_TEST_ITEMS; i += 3)
+  {
+    spatial_grid_remove(&grid, &items[i], items[i].cell);
+    items[i].filed = FALSE;
+  }
+  for (i = 0; i < GRID_TEST_ITEMS; i++)
+    filed += items[i].filed;
+  CuAssertIntEquals(tc, filed, grid.count);
+
+  for (q = 0; q < 40; q++)
+    for (r = 0; r < (int)(sizeof(ranges) / sizeof(ranges[0])); r++)
+    {
+      int x = q < 20 ? items[q * 7].x : grid_test_random(-GRID_TEST_SPREAD, GRID_TEST_SPREAD);
+      int y = q < 20 ? items[q * 7].y : grid_test_random(-GRID_TEST_SPREAD, GRID_TEST_SPREAD);
+
+      grid_test_check_query(tc, &grid, items, x, y, ranges[r], &result);
+    }
+
+  /* Removing something twice, or from the wrong cell, changes nothing. */
+  spatial_grid_remove(&grid, &items[0], items[0].cell);
+  spatial_grid_remove(&grid, &items[1], (items[1].cell + 1) % SPATIAL_GRID_CELLS);
+  CuAssertIntEquals(tc, filed, grid.count);
+
+  for (i = 0; i < GRID_TEST_ITEMS; i++)
+    if (items[i].filed)
+      spatial_grid_remove(&grid, &items[i], items[i].cell);
+  CuAssertIntEquals(tc, 0, grid.count);
+  CuAssertIntEquals(tc, 0, grid.occupied_count);
+  CuAssertIntEquals(tc, 0, spatial_grid_query(&grid, 0, 0, 5000, &result));
+
+  spatial_grid_free(&grid);
+  spatial_grid_free_result(&result);
+  free(items);
+}
+
+struct grid_fixture
+{
+  struct zone_data *zones;
+  struct room_data *rooms;
+  struct char_data *chars;
+  struct player_special_data *specials;
+  struct zone_data *saved_zone_table;
+  zone_rnum saved_top_of_zone_table;
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+};
+
+/* Zone 0 is wilderness with a room per tile along y = 0, zone 1 is not. */
+static void begin_grid_fixture(struct grid_fixture *fixture, int rooms, int chars)
+{
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_zone_table = zone_table;
+  fixture->saved_top_of_zone_table = top_of_zone_table;
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+
+  CREATE(fixture->zones, struct zone_data, 2);
+  CREATE(fixture->rooms, struct room_data, rooms + 1);
+  CREATE(fixture->chars, struct char_data, chars);
+  CREATE(fixture->specials, struct player_special_data, chars);
+
+  SET_BIT_AR(fixture->zones[0].zone_flags, ZONE_WILDERNESS);
+  for (i = 0; i < rooms; i++)
+  {
+    fixture->rooms[i].zone = 0;
+    fixture->rooms[i].coords[0] = i * 10;
+  }
+  fixture->rooms[rooms].zone = 1;
+
+  zone_table = fixture->zones;
+  top_of_zone_table = 1;
+  world = fixture->rooms;
+  top_of_world = rooms;
+
+  for (i = 0; i < chars; i++)
+  {
+    fixture->chars[i].player_specials = &fixture->specials[i];
+    IN_ROOM(&fixture->chars[i]) = NOWHERE;
+  }
+}
+
+static void end_grid_fixture(struct grid_fixture *fixture, int chars)
+{
+  int i;
+
+  for (i = 0; i < chars; i++)
+    spatial_grid_char_leave(&fixture->chars[i]);
+  zone_table = fixture->saved_zone_table;
+  top_of_zone_table = fixture->saved_top_of_zone_table;
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  free(fixture->zones);
+  free(fixture->rooms);
+  free(fixture->chars);
+  free(fixture->specials);
+}
+
+/* What char_from_room() and char_to_room() do to the grid. */
+static void grid_move(struct char_data *ch, room_rnum room)
+{
+  if (IN_ROOM(ch) != NOWHERE)
+    spatial_grid_char_leave(ch);
+  IN_ROOM(ch) = room;
+  X_LOC(ch) = world[room].coords[0];
+  Y_LOC(ch) = world[room].coords[1];
+  spatial_grid_char_update(ch);
+}
+
+void Test_spatial_grid_follows_players(CuTest *tc)
+{
+  struct grid_fixture fixture;
+  struct spatial_grid_result result;
+  struct char_data *a, *b, *mob;
+  int before = spatial_grid_player_count();
+
+  memset(&result, 0, sizeof(result));
+  begin_grid_fixture(&fixture, 10, 3);
+  a = &fixture.chars[0];
+  b = &fixture.chars[1];
+  mob = &fixture.chars[2];
+  SET_BIT_AR(MOB_FLAGS(mob), MOB_ISNPC);
+
+  grid_move(a, 0);
+  grid_move(b, 5);
+  grid_move(mob, 1);
+  CuAssertIntEquals(tc, before + 2, spatial_grid_player_count());
+
+  CuAssertIntEquals(tc, 1, spatial_grid_players_near(0, 0, 20, &result));
+  CuAssertPtrEquals(tc, a, result.items[0]);
+  CuAssertIntEquals(tc, 2, spatial_grid_players_near(25, 0, 25, &result));
+
+  /* Walking along moves them between cells. */
+  grid_move(a, 9);
+  CuAssertIntEquals(tc, 0, spatial_grid_players_near(0, 0, 20, &result));
+  CuAssertIntEquals(tc, 1, spatial_grid_players_near(90, 0, 0, &result));
+  CuAssertPtrEquals(tc, a, result.items[0]);
+
+  /* Leaving the wilderness takes them off the grid. */
+  grid_move(b, 10);
+  CuAssertTrue(tc, !b->in_spatial_grid);
+  CuAssertIntEquals(tc, before + 1, spatial_grid_player_count());
+  spatial_grid_char_leave(a);
+  spatial_grid_char_leave(a);
+  CuAssertIntEquals(tc, before, spatial_grid_player_count());
+
+  end_grid_fixture(&fixture, 3);
+  spatial_grid_free_result(&result);
+}
+
+static int los_test_calculations;
+
+static int los_test_intensity(struct spatial_context *ctx)
+{
+  ctx->final_intensity = ctx->base_intensity;
+  return SPATIAL_SUCCESS;
+}
+
+static int los_test_message(struct spatial_context *ctx, char *output, size_t max_len)
+{
+  snprintf(output, max_len, "You notice %s.", ctx->source_description);
+  return SPATIAL_SUCCESS;
+}
+
+static int los_test_obstruction(struct spatial_context *ctx, float *obstruction_factor)
+{
+  los_test_calculations++;
+  *obstruction_factor = (ctx->observer_x % 2) ? 0.5f : 0.25f;
+  return SPATIAL_SUCCESS;
+}
+
+static int los_test_modifiers(struct spatial_context *ctx __attribute__((unused)),
+                              float *range_mod, float *clarity_mod)
+{
+  *range_mod = 1.0f;
+  *clarity_mod = 1.0f;
+  return SPATIAL_SUCCESS;
+}
+
+static int los_test_modify_message(struct spatial_context *ctx __attribute__((unused)),
+                                   char *message __attribute__((unused)),
+                                   size_t max_len __attribute__((unused)))
+{
+  return SPATIAL_SUCCESS;
+}
+
+void Test_spatial_los_cache(CuTest *tc)
+{
+  struct stimulus_strategy stimulus = {.name = "Test",
+                                       .base_range = 1000.0f,
+                                       .calculate_intensity = los_test_intensity,
+                                       .generate_base_message = los_test_message,
+                                       .enabled = TRUE};
+  struct los_strategy los = {.name = "Test",
+                             .calculate_obstruction = los_test_obstruction,
+                             .enabled = TRUE,
+                             .use_caching = TRUE};
+  struct modifier_strategy modifiers = {.name = "Test",
+                                        .apply_environmental_modifiers = los_test_modifiers,
+                                        .modify_message = los_test_modify_message,
+                                        .enabled = TRUE};
+  struct spatial_system system = {.system_name = "Test",
+                                  .stimulus = &stimulus,
+                                  .line_of_sight = &los,
+                                  .modifiers = &modifiers,
+                                  .enabled = TRUE,
+                                  .global_range_multiplier = 1.0f,
+                                  .global_intensity_multiplier = 1.0f};
+  struct spatial_context *ctx = spatial_create_context();
+  bool saved_enabled = spatial_system_enabled;
+  float intensity;
+
+  spatial_system_enabled = TRUE;
+  spatial_init_cache();
+  los_test_calculations = 0;
+
+  ctx->source_x = 10;
+  ctx->source_y = 20;
+  ctx->observer_x = 13;
+  ctx->observer_y = 24;
+  ctx->base_intensity = 1.0f;
+  ctx->source_description = (char *)"a test";
+
+  CuAssertIntEquals(tc, SPATIAL_SUCCESS, spatial_process_stimulus(ctx, &system));
+  intensity = ctx->final_intensity;
+  CuAssertIntEquals(tc, SPATIAL_SUCCESS, spatial_process_stimulus(ctx, &system));
+  CuAssertIntEquals(tc, 1, los_test_calculations);
+  CuAssertIntEquals(tc, 1, los.cache_hits);
+  CuAssertTrue(tc, ctx->final_intensity == intensity);
+
+  /* Another observer is another path. */
+  ctx->observer_x = 14;
+  CuAssertIntEquals(tc, SPATIAL_SUCCESS, spatial_process_stimulus(ctx, &system));
+  CuAssertIntEquals(tc, 2, los_test_calculations);
+  CuAssertTrue(tc, ctx->final_intensity != intensity);
+
+  /* Not for contexts or strategies that opt out. */
+  ctx->use_cache = FALSE;
+  spatial_process_stimulus(ctx, &system);
+  ctx->use_cache = TRUE;
+  los.use_caching = FALSE;
+  spatial_process_stimulus(ctx, &system);
+  CuAssertIntEquals(tc, 4, los_test_calculations);
+  los.use_caching = TRUE;
+
+  /* A cleared cache misses, and there is nothing to key on without a
+   * system. */
+  spatial_cleanup_cache();
+  spatial_process_stimulus(ctx, &system);
+  CuAssertIntEquals(tc, 5, los_test_calculations);
+  ctx->active_system = NULL;
+  CuAssertIntEquals(tc, SPATIAL_ERROR_INVALID_PARAM, spatial_get_cached_result(ctx, &intensity));
+
+  spatial_cleanup_cache();
+  spatial_free_context(ctx);
+  spatial_system_enabled = saved_enabled;
+}
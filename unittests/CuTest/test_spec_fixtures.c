@@ -101,7 +101,6 @@ struct spec_test_fixture
   struct char_data builder;
   struct player_special_data builder_specials;
   struct oasis_olc_data olc;
-  struct txt_block output_block;
   char output_buffer[LARGE_BUFSIZE];
 
   char original_cwd[PATH_MAX];
@@ -637,10 +636,7 @@ static void spec_test_restore_globals(const struct spec_test_fixture *fixture)
 static void spec_test_reset_output(struct spec_test_fixture *fixture)
 {
   fixture->output_buffer[0] = '\0';
-  fixture->output_block.text = fixture->output_buffer;
-  fixture->output_block.next = NULL;
   fixture->descriptor.output = fixture->output_buffer;
-  fixture->descriptor.large_outbuf = &fixture->output_block;
   fixture->descriptor.bufptr = 0;
   fixture->descriptor.bufspace = LARGE_BUFSIZE - 1;
 }
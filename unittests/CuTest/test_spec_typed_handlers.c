@@ -72,10 +72,7 @@ static int spec_typed_test_handler(struct spec_event_context *context)
 
 static void spec_typed_clear_output(struct spec_typed_fixture *fixture)
 {
-  fixture->descriptor.small_outbuf[0] = '\0';
-  fixture->descriptor.output = fixture->descriptor.small_outbuf;
-  fixture->descriptor.bufptr = 0;
-  fixture->descriptor.bufspace = SMALL_BUFSIZE - 1;
+  comm_test_clear_output(&fixture->descriptor);
 }
 
 static bool spec_typed_begin(struct spec_typed_fixture *fixture)
@@ -143,11 +140,7 @@ static void spec_typed_end(struct spec_typed_fixture *fixture)
 {
   if (fixture->descriptor.pProtocol != NULL)
     ProtocolDestroy(fixture->descriptor.pProtocol);
-  if (fixture->descriptor.large_outbuf != NULL)
-  {
-    free(fixture->descriptor.large_outbuf->text);
-    free(fixture->descriptor.large_outbuf);
-  }
+  spec_typed_clear_output(fixture);
 
   fixture->actor.desc = NULL;
   GET_EQ(&fixture->actor, WEAR_ABOUT) = NULL;
@@ -0,0 +1,239 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/db.h"
+#include "../../src/perfmon.h"
+#include "../../src/wilderness/perlin.h"
+#include "../../src/wilderness/wilderness.h"
+#include "../../src/wilderness/terrain_raster.h"
+#include "test.helpers.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* A window near the middle of the continent that holds both land and sea. */
+#define TERRAIN_TEST_MIN_X -80
+#define TERRAIN_TEST_MIN_Y -60
+#define TERRAIN_TEST_WIDTH 160
+#define TERRAIN_TEST_HEIGHT 120
+#define TERRAIN_TEST_MARGIN 4 /* tiles checked past each edge, which fall back to noise */
+#define TERRAIN_MAP_SIZE 41
+#define TERRAIN_BENCH_MAPS 30
+
+#define TERRAIN_TEST_TILES                                                                         \
+  ((TERRAIN_TEST_WIDTH + 2 * TERRAIN_TEST_MARGIN) * (TERRAIN_TEST_HEIGHT + 2 * TERRAIN_TEST_MARGIN))
+
+struct terrain_sample
+{
+  int elevation[3]; /* On the elevation, moisture and distortion noise maps */
+  int moisture[3];
+  int temperature;
+  int sector;
+};
+
+static const int terrain_test_maps[3] = {NOISE_MATERIAL_PLANE_ELEV, NOISE_MATERIAL_PLANE_MOISTURE,
+                                         NOISE_MATERIAL_PLANE_ELEV_DIST};
+
+static void terrain_test_path(char *path, size_t size)
+{
+  snprintf(path, size, "/tmp/luminari_terrain_raster_%ld", (long)getpid());
+}
+
+/* The noise tables the raster is baked from, as boot_world() sets them. */
+static void terrain_test_begin(char *path, size_t size)
+{
+  init_perlin(NOISE_MATERIAL_PLANE_ELEV, NOISE_MATERIAL_PLANE_ELEV_SEED);
+  init_perlin(NOISE_MATERIAL_PLANE_MOISTURE, NOISE_MATERIAL_PLANE_MOISTURE_SEED);
+  init_perlin(NOISE_MATERIAL_PLANE_ELEV_DIST, NOISE_MATERIAL_PLANE_ELEV_DIST_SEED);
+  terrain_raster_close();
+  terrain_test_path(path, size);
+  remove(path);
+}
+
+static void terrain_test_end(const char *path)
+{
+  terrain_raster_close();
+  remove(path);
+}
+
+static void terrain_sample_tile(int x, int y, struct terrain_sample *sample)
+{
+  int m;
+
+  for (m = 0; m < 3; m++)
+  {
+    sample->elevation[m] = get_elevation(terrain_test_maps[m], x, y);
+    sample->moisture[m] = get_moisture(terrain_test_maps[m], x, y);
+  }
+  sample->temperature = get_temperature(NOISE_MATERIAL_PLANE_ELEV, x, y);
+  sample->sector = get_sector_type(sample->elevation[0], sample->temperature,
+                                   get_moisture(NOISE_MATERIAL_PLANE_MOISTURE, x, y));
+}
+
+static void terrain_sample_window(struct terrain_sample *samples)
+{
+  int x, y, i = 0;
+
+  for (y = TERRAIN_TEST_MIN_Y - TERRAIN_TEST_MARGIN;
+       y < TERRAIN_TEST_MIN_Y + TERRAIN_TEST_HEIGHT + TERRAIN_TEST_MARGIN; y++)
+    for (x = TERRAIN_TEST_MIN_X - TERRAIN_TEST_MARGIN;
+         x < TERRAIN_TEST_MIN_X + TERRAIN_TEST_WIDTH + TERRAIN_TEST_MARGIN; x++)
+      terrain_sample_tile(x, y, &samples[i++]);
+}
+
+static bool terrain_test_build(const char *path)
+{
+  return terrain_raster_build(path, TERRAIN_TEST_MIN_X, TERRAIN_TEST_MIN_Y, TERRAIN_TEST_WIDTH,
+                              TERRAIN_TEST_HEIGHT);
+}
+
+void Test_terrain_raster_matches_live_noise(CuTest *tc)
+{
+  struct terrain_sample *live, *mapped;
+  char path[256];
+  int i, mismatches = 0, land = 0, water = 0;
+
+  terrain_test_begin(path, sizeof(path));
+  CREATE(live, struct terrain_sample, TERRAIN_TEST_TILES);
+  CREATE(mapped, struct terrain_sample, TERRAIN_TEST_TILES);
+
+  terrain_sample_window(live);
+  CuAssertTrue(tc, terrain_test_build(path));
+  CuAssertTrue(tc, terrain_raster_open(path));
+  CuAssertTrue(tc, terrain_raster_active());
+  terrain_sample_window(mapped);
+
+  for (i = 0; i < TERRAIN_TEST_TILES; i++)
+  {
+    if (memcmp(&live[i], &mapped[i], sizeof(live[i])))
+      mismatches++;
+    if (live[i].sector == SECT_OCEAN || live[i].sector == SECT_WATER_SWIM)
+      water++;
+    else
+      land++;
+  }
+  CuAssertIntEquals(tc, 0, mismatches);
+  CuAssertTrue(tc, land > 0 && water > 0);
+
+  free(live);
+  free(mapped);
+  terrain_test_end(path);
+}
+
+static void terrain_test_patch(const char *path, long offset, const void *bytes, size_t length)
+{
+  FILE *fl = fopen(path, "r+b");
+
+  if (fl)
+  {
+    fseek(fl, offset, SEEK_SET);
+    fwrite(bytes, 1, length, fl);
+    fclose(fl);
+  }
+}
+
+void Test_terrain_raster_refuses_stale_files(CuTest *tc)
+{
+  char path[256];
+  int32_t version = TERRAIN_RASTER_VERSION + 1;
+  int16_t wrong = -12345;
+  int elevation;
+
+  terrain_test_begin(path, sizeof(path));
+
+  /* No file: live noise answers. */
+  CuAssertTrue(tc, !terrain_raster_open(path));
+  CuAssertTrue(tc, !terrain_raster_elevation(NOISE_MATERIAL_PLANE_ELEV, TERRAIN_TEST_MIN_X,
+                                             TERRAIN_TEST_MIN_Y, &elevation));
+
+  /* Another generator version. */
+  CuAssertTrue(tc, terrain_test_build(path));
+  terrain_test_patch(path, 8, &version, sizeof(version));
+  CuAssertTrue(tc, !terrain_raster_open(path));
+
+  /* Truncated. */
+  CuAssertTrue(tc, terrain_test_build(path));
+  CuAssertIntEquals(tc, 0, truncate(path, 4096));
+  CuAssertTrue(tc, !terrain_raster_open(path));
+
+  /* A cell that no longer agrees with the noise (the first is always
+   * checked). */
+  CuAssertTrue(tc, terrain_test_build(path));
+  CuAssertTrue(tc, terrain_raster_open(path));
+  terrain_raster_close();
+  terrain_test_patch(path, 40, &wrong, sizeof(wrong)); /* just past the header */
+  CuAssertTrue(tc, !terrain_raster_open(path));
+  CuAssertTrue(tc, !terrain_raster_active());
+  CuAssertIntEquals(tc, get_elevation_noise(NOISE_MATERIAL_PLANE_ELEV, TERRAIN_TEST_MIN_X,
+                                            TERRAIN_TEST_MIN_Y),
+                    get_elevation(NOISE_MATERIAL_PLANE_ELEV, TERRAIN_TEST_MIN_X,
+                                  TERRAIN_TEST_MIN_Y));
+
+  terrain_test_end(path);
+}
+
+/* Base terrain for every tile of one map, as get_map() works it out:
+ * the sector and the elevation that picks its glyph variant. */
+static long terrain_render_map(int center_x, int center_y)
+{
+  int x, y, half = (TERRAIN_MAP_SIZE - 1) / 2;
+  long checksum = 0;
+
+  for (y = center_y - half; y <= center_y + half; y++)
+    for (x = center_x - half; x <= center_x + half; x++)
+    {
+      checksum += get_sector_type(get_elevation(NOISE_MATERIAL_PLANE_ELEV, x, y),
+                                  get_temperature(NOISE_MATERIAL_PLANE_ELEV, x, y),
+                                  get_moisture(NOISE_MATERIAL_PLANE_MOISTURE, x, y));
+      checksum += get_elevation(NOISE_MATERIAL_PLANE_MOISTURE, x, y) % NUM_VARIANT_GLYPHS;
+    }
+  return checksum;
+}
+
+void Test_terrain_raster_benchmark(CuTest *tc)
+{
+  char path[256];
+  uint64_t start, build_usec, open_usec, live_usec, mapped_usec;
+  long live_sum = 0, mapped_sum = 0;
+  int i, cx = TERRAIN_TEST_MIN_X + TERRAIN_TEST_WIDTH / 2;
+  int cy = TERRAIN_TEST_MIN_Y + TERRAIN_TEST_HEIGHT / 2;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  terrain_test_begin(path, sizeof(path));
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < TERRAIN_BENCH_MAPS; i++)
+    live_sum += terrain_render_map(cx + i % 3 - 1, cy + i % 5 - 2);
+  live_usec = PERF_monotonic_usec() - start;
+
+  start = PERF_monotonic_usec();
+  CuAssertTrue(tc, terrain_test_build(path));
+  build_usec = PERF_monotonic_usec() - start;
+
+  start = PERF_monotonic_usec();
+  CuAssertTrue(tc, terrain_raster_open(path));
+  open_usec = PERF_monotonic_usec() - start;
+
+  start = PERF_monotonic_usec();
+  for (i = 0; i < TERRAIN_BENCH_MAPS; i++)
+    mapped_sum += terrain_render_map(cx + i % 3 - 1, cy + i % 5 - 2);
+  mapped_usec = PERF_monotonic_usec() - start;
+
+  CuAssertTrue(tc, live_sum == mapped_sum);
+  log("BENCHMARK: terrain raster, %dx%d tiles: build %llu usec, open %llu usec; "
+      "%d maps of %dx%d: live noise %llu usec, raster %llu usec",
+      TERRAIN_TEST_WIDTH, TERRAIN_TEST_HEIGHT, (unsigned long long)build_usec,
+      (unsigned long long)open_usec, TERRAIN_BENCH_MAPS, TERRAIN_MAP_SIZE, TERRAIN_MAP_SIZE,
+      (unsigned long long)live_usec, (unsigned long long)mapped_usec);
+
+  terrain_test_end(path);
+}
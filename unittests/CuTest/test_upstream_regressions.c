@@ -14,13 +14,19 @@
 #include "../../src/character/feats.h"
 #include "../../src/dgscript/dg_olc.h"
 #include "../../src/net/protocol.h"
+#include "../../src/perfmon.h"
 #include "../../src/quest/hlquest.h"
 #include "../../src/wilderness/terrain_bridge.h"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <time.h>
 
+#define TERRAIN_TEST_PADDING_SECTIONS 100
+
 void Test_feat_sort_contains_each_valid_feat_once(CuTest *tc)
 {
   bool seen[FEAT_LAST_FEAT] = {false};
@@ -79,10 +85,13 @@ void Test_partial_output_writes_preserve_buffer_accounting(CuTest *tc)
   descriptor.bufptr = 6;
   descriptor.bufspace = SMALL_BUFSIZE - 1 - descriptor.bufptr;
 
+  /* The unsent bytes stay where they were queued, so the room behind them
+   * is what it was. */
   comm_test_retain_unsent_output(&descriptor, "abcdef", 2);
   CuAssertStrEquals(tc, "cdef", descriptor.output);
+  CuAssertPtrEquals(tc, descriptor.small_outbuf + 2, descriptor.output);
   CuAssertIntEquals(tc, 4, descriptor.bufptr);
-  CuAssertIntEquals(tc, SMALL_BUFSIZE - 5, descriptor.bufspace);
+  CuAssertIntEquals(tc, SMALL_BUFSIZE - 7, descriptor.bufspace);
 
   strlcpy(descriptor.output, "abcdef", sizeof(descriptor.small_outbuf));
   descriptor.bufptr = 6;
@@ -123,22 +132,24 @@ void Test_terrain_bridge_rejects_unbounded_batch_ranges(CuTest *tc)
 
 void Test_terrain_bridge_http_health_contract(CuTest *tc)
 {
+  const char *content_type;
   char *response;
   int status_code;
   bool head_only;
 
   response = process_terrain_http_request("GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n", true,
-                                          42, &status_code, &head_only);
+                                          42, &status_code, &head_only, &content_type);
   CuAssertPtrNotNull(tc, response);
   CuAssertIntEquals(tc, 200, status_code);
   CuAssertTrue(tc, !head_only);
   CuAssertPtrNotNull(tc, strstr(response, "\"status\":\"healthy\""));
   CuAssertPtrNotNull(tc, strstr(response, "\"database\":\"healthy\""));
   CuAssertPtrNotNull(tc, strstr(response, "\"uptime_seconds\":42"));
+  CuAssertStrEquals(tc, "application/json", content_type);
   free(response);
 
   response = process_terrain_http_request("GET /health/ready HTTP/1.1\r\n\r\n", false, 7,
-                                          &status_code, &head_only);
+                                          &status_code, &head_only, &content_type);
   CuAssertPtrNotNull(tc, response);
   CuAssertIntEquals(tc, 503, status_code);
   CuAssertPtrNotNull(tc, strstr(response, "\"status\":\"unhealthy\""));
@@ -146,7 +157,7 @@ void Test_terrain_bridge_http_health_contract(CuTest *tc)
   free(response);
 
   response = process_terrain_http_request("HEAD /health/live HTTP/1.0\r\n\r\n", false, 9,
-                                          &status_code, &head_only);
+                                          &status_code, &head_only, &content_type);
   CuAssertPtrNotNull(tc, response);
   CuAssertIntEquals(tc, 200, status_code);
   CuAssertTrue(tc, head_only);
@@ -154,16 +165,101 @@ void Test_terrain_bridge_http_health_contract(CuTest *tc)
   free(response);
 
   response = process_terrain_http_request("POST /health HTTP/1.1\r\n\r\n", true, 1, &status_code,
-                                          &head_only);
+                                          &head_only, &content_type);
   CuAssertPtrNotNull(tc, response);
   CuAssertIntEquals(tc, 405, status_code);
   free(response);
 
   response = process_terrain_http_request("GET /not-health HTTP/1.1\r\n\r\n", true, 1, &status_code,
-                                          &head_only);
+                                          &head_only, &content_type);
   CuAssertPtrNotNull(tc, response);
   CuAssertIntEquals(tc, 404, status_code);
   free(response);
+
+  /* Metrics need no database and are served as OpenMetrics text. */
+  response = process_terrain_http_request("GET /metrics HTTP/1.1\r\n\r\n", false, 1, &status_code,
+                                          &head_only, &content_type);
+  CuAssertPtrNotNull(tc, response);
+  CuAssertIntEquals(tc, 200, status_code);
+  CuAssertStrEquals(tc, PERF_METRICS_CONTENT_TYPE, content_type);
+  CuAssertPtrNotNull(tc, strstr(response, "# TYPE luminari_pulse_duration_seconds histogram\n"));
+  CuAssertPtrNotNull(tc, strstr(response, "# EOF\n"));
+  free(response);
+}
+
+void Test_terrain_bridge_http_response_waits_for_slow_reader(CuTest *tc)
+{
+  static char received[TERRAIN_API_METRICS_SIZE + 1024];
+  static const char request[] = "GET /metrics HTTP/1.1\r\n\r\n";
+  struct terrain_api_server *server;
+  struct terrain_api_client *client = NULL;
+  struct sockaddr_in address;
+  socklen_t address_length = sizeof(address);
+  size_t received_length = 0, content_length;
+  ssize_t got;
+  const char *body;
+  int reader, buffer_size = 4096, i;
+
+  CuAssertIntEquals(tc, 1, start_terrain_api_server(0));
+  server = get_terrain_api_server();
+  CuAssertIntEquals(tc, 0, getsockname(server->server_socket, (struct sockaddr *)&address,
+                                       &address_length));
+  reader = socket(AF_INET, SOCK_STREAM, 0);
+  CuAssertTrue(tc, reader >= 0);
+  setsockopt(reader, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+  CuAssertIntEquals(tc, 0, connect(reader, (struct sockaddr *)&address, address_length));
+
+  for (i = 0; i < 100 && server->num_clients == 0; i++)
+    terrain_api_process();
+  CuAssertIntEquals(tc, 1, server->num_clients);
+  for (i = 0; i < server->max_clients; i++)
+    if (server->clients[i].socket >= 0)
+      client = &server->clients[i];
+  setsockopt(client->socket, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+
+  /* Sections with no runs yet, so the body is well past what the two socket
+   * buffers hold whichever tests ran first. */
+  for (i = 0; i < TERRAIN_TEST_PADDING_SECTIONS; i++)
+  {
+    static struct PERF_prof_sect *padding[TERRAIN_TEST_PADDING_SECTIONS];
+    char id[64];
+
+    snprintf(id, sizeof(id), "terrain_bridge_test.slow_reader_padding_section_%03d", i);
+    PERF_prof_sect_init(&padding[i], id);
+  }
+
+  /* The reader does not read, so the rest of the response waits. */
+  CuAssertIntEquals(tc, (int)strlen(request), (int)send(reader, request, strlen(request), 0));
+  for (i = 0; i < 100 && !client->output; i++)
+    terrain_api_process();
+  CuAssertPtrNotNull(tc, client->output);
+  terrain_api_process();
+  CuAssertTrue(tc, client->output_sent < client->output_length);
+  CuAssertTrue(tc, terrain_api_has_pending_output());
+
+  /* Once it reads, every byte arrives and the connection closes. */
+  for (i = 0; i < 100000; i++)
+  {
+    got = recv(reader, received + received_length, sizeof(received) - 1 - received_length,
+               MSG_DONTWAIT);
+    if (got == 0)
+      break;
+    if (got > 0)
+      received_length += (size_t)got;
+    terrain_api_process();
+  }
+  received[received_length] = '\0';
+  CuAssertIntEquals(tc, 0, server->num_clients);
+  CuAssertTrue(tc, !terrain_api_has_pending_output());
+  CuAssertPtrNotNull(tc, strstr(received, "Content-Length: "));
+  content_length = strtoul(strstr(received, "Content-Length: ") + strlen("Content-Length: "), NULL,
+                           10);
+  body = strstr(received, "\r\n\r\n") + 4;
+  CuAssertIntEquals(tc, (int)content_length, (int)(received_length - (size_t)(body - received)));
+  CuAssertStrEquals(tc, "# EOF\n", received + received_length - strlen("# EOF\n"));
+
+  close(reader);
+  stop_terrain_api_server();
 }
 
 void Test_upstream_random_generator_sequence(CuTest *tc)
@@ -369,6 +465,7 @@ void Test_column_list_pages_complete_output_with_visible_separators(CuTest *tc)
 
 void Test_column_list_maximum_page_settings_stay_within_descriptor_capacity(CuTest *tc)
 {
+  static char page[LARGE_BUFSIZE];
   const char *items[300];
   struct char_data ch;
   struct descriptor_data descriptor;
@@ -384,6 +481,8 @@ void Test_column_list_maximum_page_settings_stay_within_descriptor_capacity(CuTe
   for (i = 0; i < 300; i++)
     items[i] = "maximum pager boundary item";
 
+  /* Each page overflows small_outbuf into pooled segments, and is read back
+   * whole from the queue. */
   descriptor.character = &ch;
   descriptor.output = descriptor.small_outbuf;
   descriptor.bufspace = SMALL_BUFSIZE - 1;
@@ -403,35 +502,30 @@ void Test_column_list_maximum_page_settings_stay_within_descriptor_capacity(CuTe
 
   column_list(&ch, 1, items, 300, TRUE);
   initial_page_count = descriptor.showstr_count;
+  CuAssertPtrNotNull(tc, descriptor.output_segments);
 
   while (descriptor.showstr_count > 0)
   {
-    if (descriptor.bufspace == 0 || strstr(descriptor.output, "OVERFLOW") != NULL)
+    comm_test_output_text(&descriptor, page, sizeof(page));
+    if (descriptor.bufspace == 0 || strstr(page, "OVERFLOW") != NULL)
       all_pages_fit = false;
-    if (strstr(descriptor.output, "300) maximum pager boundary item") != NULL)
+    if (strstr(page, "300) maximum pager boundary item") != NULL)
       saw_last_item = true;
 
-    descriptor.output[0] = '\0';
-    descriptor.bufptr = 0;
-    descriptor.bufspace = descriptor.large_outbuf ? LARGE_BUFSIZE - 1 : SMALL_BUFSIZE - 1;
+    comm_test_clear_output(&descriptor);
     if (descriptor.showstr_count > 0)
       show_string(&descriptor, "");
   }
 
-  if (descriptor.bufspace == 0 || strstr(descriptor.output, "OVERFLOW") != NULL)
+  comm_test_output_text(&descriptor, page, sizeof(page));
+  if (descriptor.bufspace == 0 || strstr(page, "OVERFLOW") != NULL)
     all_pages_fit = false;
-  if (strstr(descriptor.output, "300) maximum pager boundary item") != NULL)
+  if (strstr(page, "300) maximum pager boundary item") != NULL)
     saw_last_item = true;
 
+  comm_test_clear_output(&descriptor);
   ch.desc = NULL;
   ProtocolDestroy(descriptor.pProtocol);
-  if (descriptor.large_outbuf != NULL)
-  {
-    free(descriptor.large_outbuf->text);
-    free(descriptor.large_outbuf);
-    if (buf_largecount > 0)
-      buf_largecount--;
-  }
 
   CuAssertTrue(tc, initial_page_count > 1);
   CuAssertTrue(tc, all_pages_fit);
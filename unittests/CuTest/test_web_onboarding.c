@@ -1289,12 +1289,25 @@ static void reset_restart_test_hooks(void)
   character_creation_set_restart_hooks_for_test(&hooks);
 }
 
+/* The editor descriptor's whole output queue, small_outbuf and the pooled
+ * segments it overflowed into, read back as one string. */
+static char editor_test_output[LARGE_BUFSIZE];
+
+static const char *editor_output(struct descriptor_data *d)
+{
+  comm_test_output_text(d, editor_test_output, sizeof(editor_test_output));
+  return editor_test_output;
+}
+
+static void reset_editor_test_output(struct descriptor_data *d);
+
 static bool init_editor_descriptor(struct descriptor_data *d, struct char_data *ch,
                                    struct player_special_data *specials, int state)
 {
   memset(ch, 0, sizeof(*ch));
   memset(specials, 0, sizeof(*specials));
   init_test_descriptor(d, state);
+  reset_editor_test_output(d);
 
   d->pProtocol = ProtocolCreate();
   if (d->pProtocol == NULL)
@@ -1322,19 +1335,7 @@ static void reset_editor_test_output(struct descriptor_data *d)
   if (d == NULL)
     return;
 
-  if (d->large_outbuf != NULL)
-  {
-    d->output = d->large_outbuf->text;
-    d->bufspace = LARGE_BUFSIZE - 1;
-  }
-  else
-  {
-    d->output = d->small_outbuf;
-    d->bufspace = SMALL_BUFSIZE - 1;
-  }
-
-  d->output[0] = '\0';
-  d->bufptr = 0;
+  comm_test_clear_output(d);
 }
 
 static void cleanup_editor_descriptor(struct descriptor_data *d)
@@ -1345,13 +1346,7 @@ static void cleanup_editor_descriptor(struct descriptor_data *d)
     ProtocolDestroy(d->pProtocol);
     d->pProtocol = NULL;
   }
-  if (d->large_outbuf != NULL)
-  {
-    free(d->large_outbuf->text);
-    free(d->large_outbuf);
-    d->large_outbuf = NULL;
-    d->output = d->small_outbuf;
-  }
+  comm_test_clear_output(d);
   roleplay_text_set_save_callback_for_test(NULL);
   roleplay_index_set_save_callback_for_test(NULL);
   character_creation_set_save_callback_for_test(NULL);
@@ -1929,7 +1924,7 @@ void TestWebOnboardingExistingEditorEmitsVerifiedContentAfterState(CuTest *tc)
   d.web_onboarding_dirty = TRUE;
   web_onboarding_tick(&d);
 
-  strlcpy(emitted, d.output, sizeof(emitted));
+  strlcpy(emitted, editor_output(&d), sizeof(emitted));
   CuAssertPtrNotNull(tc, strstr(emitted, WEB_ONBOARDING_MSDP_VARIABLE));
   CuAssertTrue(tc, strstr(emitted, WEB_ONBOARDING_CONTENT_VARIABLE) == NULL);
   CuAssertTrue(tc, web_onboarding_has_active_outbound_transfer_for_test(&d));
@@ -1938,7 +1933,7 @@ void TestWebOnboardingExistingEditorEmitsVerifiedContentAfterState(CuTest *tc)
   while (web_onboarding_has_active_outbound_transfer_for_test(&d) && ticks < 5)
   {
     web_onboarding_tick(&d);
-    strlcat(emitted, d.output, sizeof(emitted));
+    strlcat(emitted, editor_output(&d), sizeof(emitted));
     reset_editor_test_output(&d);
     ticks++;
   }
@@ -1990,9 +1985,9 @@ void TestWebOnboardingMaximumEditorDownloadIsPacedWithoutOverflow(CuTest *tc)
     d.web_onboarding_dirty = TRUE;
     web_onboarding_tick(&d);
 
-    CuAssertPtrNotNull(tc, strstr(d.output, "\"totalBytes\":49152"));
-    CuAssertPtrNotNull(tc, strstr(d.output, "\"chunkCount\":8"));
-    CuAssertTrue(tc, strstr(d.output, WEB_ONBOARDING_CONTENT_VARIABLE) == NULL);
+    CuAssertPtrNotNull(tc, strstr(editor_output(&d), "\"totalBytes\":49152"));
+    CuAssertPtrNotNull(tc, strstr(editor_output(&d), "\"chunkCount\":8"));
+    CuAssertTrue(tc, strstr(editor_output(&d), WEB_ONBOARDING_CONTENT_VARIABLE) == NULL);
     CuAssertTrue(tc, (size_t)d.bufptr < LARGE_BUFSIZE);
     reset_editor_test_output(&d);
 
@@ -2000,14 +1995,14 @@ void TestWebOnboardingMaximumEditorDownloadIsPacedWithoutOverflow(CuTest *tc)
            ticks < WEB_ONBOARDING_EDITOR_MAX_CHUNKS + 3)
     {
       web_onboarding_tick(&d);
-      CuAssertPtrNotNull(tc, strstr(d.output, WEB_ONBOARDING_CONTENT_VARIABLE));
-      CuAssertTrue(tc, strstr(d.output, "OVERFLOW") == NULL);
+      CuAssertPtrNotNull(tc, strstr(editor_output(&d), WEB_ONBOARDING_CONTENT_VARIABLE));
+      CuAssertTrue(tc, strstr(editor_output(&d), "OVERFLOW") == NULL);
       CuAssertTrue(tc, (size_t)d.bufptr < LARGE_BUFSIZE);
-      if (strstr(d.output, "\"phase\":\"begin\"") != NULL)
+      if (strstr(editor_output(&d), "\"phase\":\"begin\"") != NULL)
         begin_frames++;
-      if (strstr(d.output, "\"phase\":\"chunk\"") != NULL)
+      if (strstr(editor_output(&d), "\"phase\":\"chunk\"") != NULL)
         chunk_frames++;
-      if (strstr(d.output, "\"phase\":\"commit\"") != NULL)
+      if (strstr(editor_output(&d), "\"phase\":\"commit\"") != NULL)
         commit_frames++;
       reset_editor_test_output(&d);
       ticks++;
@@ -2045,10 +2040,10 @@ void TestWebOnboardingInvalidExistingEditorContentFailsClosed(CuTest *tc)
     d.web_onboarding_dirty = TRUE;
     web_onboarding_tick(&d);
 
-    CuAssertPtrNotNull(tc, strstr(d.output, WEB_ONBOARDING_MSDP_VARIABLE));
-    CuAssertPtrNotNull(tc, strstr(d.output, "\"code\":\"editor-load-failed\""));
-    CuAssertTrue(tc, strstr(d.output, WEB_ONBOARDING_CONTENT_VARIABLE) == NULL);
-    CuAssertTrue(tc, strstr(d.output, "\"editor\":") == NULL);
+    CuAssertPtrNotNull(tc, strstr(editor_output(&d), WEB_ONBOARDING_MSDP_VARIABLE));
+    CuAssertPtrNotNull(tc, strstr(editor_output(&d), "\"code\":\"editor-load-failed\""));
+    CuAssertTrue(tc, strstr(editor_output(&d), WEB_ONBOARDING_CONTENT_VARIABLE) == NULL);
+    CuAssertTrue(tc, strstr(editor_output(&d), "\"editor\":") == NULL);
     CuAssertTrue(tc, !web_onboarding_has_active_outbound_transfer_for_test(&d));
   }
 
@@ -2062,26 +2057,30 @@ void TestWebOnboardingStateWaitsForOutputCapacity(CuTest *tc)
   struct descriptor_data d;
   struct char_data ch;
   struct player_special_data specials;
+  int queued;
 
   CuAssertTrue(tc, init_editor_descriptor(&d, &ch, &specials, CON_PLR_BG));
   if (d.pProtocol == NULL)
     return;
 
+  /* Fill the queue until it is in the overflow state. */
+  while (d.bufspace > 0)
+    write_to_output(&d, "%s", "Queued output the client has not read yet.\r\n");
+  queued = d.bufptr;
   d.web_onboarding_dirty = TRUE;
-  d.bufptr = LARGE_BUFSIZE - 1;
-  d.bufspace = 0;
   web_onboarding_tick(&d);
 
   CuAssertIntEquals(tc, 7, d.web_onboarding_revision);
   CuAssertTrue(tc, d.web_onboarding_dirty);
-  CuAssertTrue(tc, d.output[0] == '\0');
+  CuAssertIntEquals(tc, queued, d.bufptr);
+  CuAssertTrue(tc, strstr(editor_output(&d), WEB_ONBOARDING_MSDP_VARIABLE) == NULL);
   CuAssertTrue(tc, !web_onboarding_has_active_outbound_transfer_for_test(&d));
 
   reset_editor_test_output(&d);
   web_onboarding_tick(&d);
   CuAssertIntEquals(tc, 8, d.web_onboarding_revision);
   CuAssertTrue(tc, !d.web_onboarding_dirty);
-  CuAssertPtrNotNull(tc, strstr(d.output, WEB_ONBOARDING_MSDP_VARIABLE));
+  CuAssertPtrNotNull(tc, strstr(editor_output(&d), WEB_ONBOARDING_MSDP_VARIABLE));
 
   cleanup_editor_descriptor(&d);
 }
@@ -2262,10 +2261,7 @@ void TestWebOnboardingEditorEnforcesCommitAndByteRateBudgets(CuTest *tc)
     editor_test_transfer(&d, "background-story", transfer_id, short_content,
                          sizeof(short_content) - 1, NULL, 1000);
     CuAssertIntEquals(tc, index + 1, editor_test_save_calls);
-    d.output = d.small_outbuf;
-    d.small_outbuf[0] = '\0';
-    d.bufptr = 0;
-    d.bufspace = SMALL_BUFSIZE - 1;
+    reset_editor_test_output(&d);
   }
 
   d.connected = CON_PLR_BG;
@@ -2290,10 +2286,7 @@ void TestWebOnboardingEditorEnforcesCommitAndByteRateBudgets(CuTest *tc)
                            byte_window_ms);
       CuAssertIntEquals(tc, WEB_ONBOARDING_EDITOR_MAX_COMMITS_PER_WINDOW + index + 1,
                         editor_test_save_calls);
-      d.output = d.small_outbuf;
-      d.small_outbuf[0] = '\0';
-      d.bufptr = 0;
-      d.bufspace = SMALL_BUFSIZE - 1;
+      reset_editor_test_output(&d);
     }
 
     d.connected = CON_PLR_BG;
@@ -0,0 +1,310 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/perfmon.h"
+#include "../../src/wilderness/wilderness.h"
+#include "../../src/wilderness/kdtree.h"
+#include "../../src/wilderness/room_pool.h"
+#include "test.helpers.h"
+
+#include <string.h>
+
+#define ROOM_POOL_TEST_GAP 3 /* Pool offset left out of the fixture world */
+#define ROOM_POOL_BENCH_RESIDENTS 400
+#define ROOM_POOL_BENCH_WALKERS 20
+#define ROOM_POOL_BENCH_STEPS 2000
+#define ROOM_POOL_BENCH_LEGACY_STEPS 100 /* The old scans are far too slow for more */
+
+extern struct kdtree *kd_wilderness_rooms;
+
+struct room_pool_fixture
+{
+  struct room_data *rooms;
+  int count;
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  struct kdtree *saved_kd;
+  bool saved_validate;
+  unsigned int seed;
+};
+
+static int room_pool_next(struct room_pool_fixture *fixture, int range)
+{
+  fixture->seed = fixture->seed * 1103515245U + 12345U;
+  return (int)((fixture->seed >> 8) % (unsigned int)range);
+}
+
+/* One ordinary room, then the dynamic pool, optionally with one vnum missing. */
+static void begin_room_pool_fixture(struct room_pool_fixture *fixture, int pool_rooms,
+                                    bool with_gap)
+{
+  int i, offset;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->seed = 31337U;
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  fixture->saved_kd = kd_wilderness_rooms;
+  fixture->saved_validate = wild_pool_validate;
+
+  fixture->count = pool_rooms + 1;
+  CREATE(fixture->rooms, struct room_data, fixture->count);
+  fixture->rooms[0].number = 3001;
+  for (i = 1, offset = 0; i < fixture->count; i++, offset++)
+  {
+    if (with_gap && offset == ROOM_POOL_TEST_GAP)
+      offset++;
+    fixture->rooms[i].number = WILD_DYNAMIC_ROOM_VNUM_START + offset;
+  }
+
+  world = fixture->rooms;
+  top_of_world = fixture->count - 1;
+  kd_wilderness_rooms = kd_create(2);
+  wild_pool_reset();
+}
+
+static void end_room_pool_fixture(struct room_pool_fixture *fixture)
+{
+  kd_free(kd_wilderness_rooms);
+  kd_wilderness_rooms = fixture->saved_kd;
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  wild_pool_validate = fixture->saved_validate;
+  free(fixture->rooms);
+  wild_pool_reset();
+}
+
+/* What mark_wilderness_room_occupied() and event_check_occupied() do to the
+ * room, minus the mud event. */
+static void room_pool_occupy(room_rnum room, int x, int y)
+{
+  world[room].coords[X_COORD] = x;
+  world[room].coords[Y_COORD] = y;
+  wild_pool_note_moved(room);
+  SET_BIT_AR(ROOM_FLAGS(room), ROOM_OCCUPIED);
+  wild_pool_note_occupied(room);
+}
+
+static void room_pool_release(room_rnum room)
+{
+  REMOVE_BIT_AR(ROOM_FLAGS(room), ROOM_OCCUPIED);
+  wild_pool_note_released(room);
+}
+
+/* The scans find_room_by_coordinates() and find_available_wilderness_room()
+ * used to run, verbatim, as the benchmark baseline. */
+static room_rnum room_pool_legacy_find(int x, int y)
+{
+  int i = 0;
+
+  for (i = WILD_DYNAMIC_ROOM_VNUM_START;
+       (i <= WILD_DYNAMIC_ROOM_VNUM_END) && (real_room(i) != NOWHERE); i++)
+  {
+    if ((ROOM_FLAGGED(real_room(i), ROOM_OCCUPIED)) && (world[real_room(i)].coords[X_COORD] == x) &&
+        (world[real_room(i)].coords[Y_COORD] == y))
+      return real_room(i);
+  }
+  return NOWHERE;
+}
+
+static room_rnum room_pool_legacy_available(void)
+{
+  int i = 0;
+
+  for (i = WILD_DYNAMIC_ROOM_VNUM_START; i <= WILD_DYNAMIC_ROOM_VNUM_END; i++)
+  {
+    if (real_room(i) == NOWHERE)
+      continue;
+    if (!ROOM_FLAGGED(real_room(i), ROOM_OCCUPIED))
+      return real_room(i);
+  }
+  return NOWHERE;
+}
+
+/* Reference answer that, unlike the old loop, does not stop at a gap. */
+static room_rnum room_pool_scan_find(int x, int y)
+{
+  room_rnum i;
+
+  for (i = 0; i <= top_of_world; i++)
+    if (IS_DYNAMIC(i) && ROOM_FLAGGED(i, ROOM_OCCUPIED) && world[i].coords[X_COORD] == x &&
+        world[i].coords[Y_COORD] == y)
+      return i;
+  return NOWHERE;
+}
+
+void Test_wild_room_pool_tracks_occupancy_and_coordinates(CuTest *tc)
+{
+  struct room_pool_fixture fixture;
+  room_rnum first, second, after_gap;
+
+  begin_room_pool_fixture(&fixture, 10, TRUE);
+  wild_pool_validate = FALSE;
+
+  /* Lowest free vnum first, and the ordinary room is never handed out. */
+  first = find_available_wilderness_room();
+  CuAssertIntEquals(tc, 1, first);
+  CuAssertIntEquals(tc, NOWHERE, find_room_by_coordinates(5, 5));
+
+  room_pool_occupy(first, 5, 5);
+  CuAssertIntEquals(tc, first, find_room_by_coordinates(5, 5));
+  second = find_available_wilderness_room();
+  CuAssertIntEquals(tc, 2, second);
+
+  /* Two rooms on one tile: the lower vnum wins, as the old scan did. */
+  room_pool_occupy(second, 5, 5);
+  CuAssertIntEquals(tc, first, find_room_by_coordinates(5, 5));
+  room_pool_release(first);
+  CuAssertIntEquals(tc, second, find_room_by_coordinates(5, 5));
+
+  /* A released room goes back on the free-list and is reused next. */
+  CuAssertIntEquals(tc, first, find_available_wilderness_room());
+
+  /* Reassigning an occupied room re-keys it. */
+  room_pool_occupy(second, -40, 12);
+  CuAssertIntEquals(tc, NOWHERE, find_room_by_coordinates(5, 5));
+  CuAssertIntEquals(tc, second, find_room_by_coordinates(-40, 12));
+
+  /* Rooms past the gap in the pool are found too. */
+  after_gap = fixture.count - 1;
+  room_pool_occupy(after_gap, 900, -900);
+  CuAssertIntEquals(tc, after_gap, find_room_by_coordinates(900, -900));
+
+  /* Clearing the flag by hand, as the vessel cache tests do, is caught. */
+  REMOVE_BIT_AR(ROOM_FLAGS(second), ROOM_OCCUPIED);
+  CuAssertIntEquals(tc, NOWHERE, find_room_by_coordinates(-40, 12));
+
+  end_room_pool_fixture(&fixture);
+}
+
+void Test_wild_room_pool_matches_scan_through_churn(CuTest *tc)
+{
+  struct room_pool_fixture fixture;
+  room_rnum room, free_room;
+  int step, x, y;
+
+  begin_room_pool_fixture(&fixture, 200, TRUE);
+  wild_pool_validate = FALSE;
+
+  for (step = 0; step < 5000; step++)
+  {
+    x = room_pool_next(&fixture, 30);
+    y = room_pool_next(&fixture, 30);
+    switch (room_pool_next(&fixture, 3))
+    {
+    case 0:
+      if ((free_room = find_available_wilderness_room()) != NOWHERE)
+      {
+        CuAssertTrue(tc, IS_DYNAMIC(free_room));
+        CuAssertTrue(tc, !ROOM_FLAGGED(free_room, ROOM_OCCUPIED));
+        room_pool_occupy(free_room, x, y);
+      }
+      break;
+    case 1:
+      room = 1 + room_pool_next(&fixture, fixture.count - 1);
+      if (ROOM_FLAGGED(room, ROOM_OCCUPIED))
+        room_pool_release(room);
+      break;
+    default:
+      CuAssertIntEquals(tc, room_pool_scan_find(x, y), find_room_by_coordinates(x, y));
+      break;
+    }
+  }
+
+  /* Resizing the world under the index forces a rebuild. */
+  top_of_world--;
+  CuAssertIntEquals(tc, room_pool_scan_find(x, y), find_room_by_coordinates(x, y));
+  top_of_world++;
+
+  /* Validation mode agrees with the index on every tile. */
+  wild_pool_validate = TRUE;
+  for (x = 0; x < 30; x++)
+    for (y = 0; y < 30; y++)
+      CuAssertIntEquals(tc, room_pool_scan_find(x, y), find_room_by_coordinates(x, y));
+
+  end_room_pool_fixture(&fixture);
+}
+
+/* Walkers wander a full pool that already holds a crowd of parked
+ * residents, the way players moving through the wilderness do: look up the
+ * destination tile, claim a free room on a miss, release the one behind. */
+static long room_pool_walk(struct room_pool_fixture *fixture, int steps, bool legacy)
+{
+  room_rnum here[ROOM_POOL_BENCH_WALKERS], there;
+  int wx[ROOM_POOL_BENCH_WALKERS], wy[ROOM_POOL_BENCH_WALKERS];
+  int w, step;
+  long moves = 0;
+
+  for (w = 0; w < ROOM_POOL_BENCH_WALKERS; w++)
+  {
+    wx[w] = -500 + w * 50;
+    wy[w] = 500;
+    here[w] = legacy ? room_pool_legacy_available() : find_available_wilderness_room();
+    room_pool_occupy(here[w], wx[w], wy[w]);
+  }
+
+  for (step = 0; step < steps; step++)
+    for (w = 0; w < ROOM_POOL_BENCH_WALKERS; w++)
+    {
+      wx[w] += room_pool_next(fixture, 3) - 1;
+      wy[w] -= 1;
+      there = legacy ? room_pool_legacy_find(wx[w], wy[w]) : find_room_by_coordinates(wx[w], wy[w]);
+      if (there == NOWHERE)
+      {
+        there = legacy ? room_pool_legacy_available() : find_available_wilderness_room();
+        room_pool_occupy(there, wx[w], wy[w]);
+      }
+      room_pool_release(here[w]);
+      here[w] = there;
+      moves++;
+    }
+
+  for (w = 0; w < ROOM_POOL_BENCH_WALKERS; w++)
+    room_pool_release(here[w]);
+  return moves;
+}
+
+void Test_wild_room_pool_benchmark_wilderness_movement(CuTest *tc)
+{
+  struct room_pool_fixture fixture;
+  uint64_t start_usec, legacy_usec, indexed_usec;
+  long legacy_moves, indexed_moves;
+  int i;
+
+  if (!test_benchmarks_enabled())
+  {
+    CuAssertTrue(tc, 1);
+    return;
+  }
+
+  begin_room_pool_fixture(&fixture, WILD_POOL_SIZE, FALSE);
+  wild_pool_validate = FALSE;
+
+  /* Park residents across the low vnums so the old scans have to wade
+   * through them, as they would on a busy server. */
+  for (i = 0; i < ROOM_POOL_BENCH_RESIDENTS; i++)
+    room_pool_occupy(1 + i * 3, 2000 + i, 2000);
+
+  fixture.seed = 99U;
+  start_usec = PERF_monotonic_usec();
+  legacy_moves = room_pool_walk(&fixture, ROOM_POOL_BENCH_LEGACY_STEPS, TRUE);
+  legacy_usec = PERF_monotonic_usec() - start_usec;
+
+  fixture.seed = 99U;
+  start_usec = PERF_monotonic_usec();
+  indexed_moves = room_pool_walk(&fixture, ROOM_POOL_BENCH_STEPS, FALSE);
+  indexed_usec = PERF_monotonic_usec() - start_usec;
+
+  CuAssertTrue(tc, legacy_moves > 0 && indexed_moves > 0);
+  log("BENCHMARK: wilderness movement with %d parked rooms: %.0f rooms/sec scanning (%ld moves), "
+      "%.0f rooms/sec with the pool index (%ld moves).",
+      ROOM_POOL_BENCH_RESIDENTS, legacy_moves * 1000000.0 / (double)MAX(legacy_usec, 1),
+      legacy_moves, indexed_moves * 1000000.0 / (double)MAX(indexed_usec, 1), indexed_moves);
+
+  end_room_pool_fixture(&fixture);
+}
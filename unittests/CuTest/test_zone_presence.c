@@ -0,0 +1,273 @@
+#include "CuTest.h"
+
+#include "../../src/conf.h"
+#include "../../src/sysdep.h"
+#include "../../src/structs.h"
+#include "../../src/utils.h"
+#include "../../src/comm.h"
+#include "../../src/db.h"
+#include "../../src/zone_presence.h"
+
+#include <string.h>
+
+#define PRESENCE_TEST_ZONES 3
+#define PRESENCE_TEST_CHARS 5
+
+struct presence_fixture
+{
+  struct zone_data *zones;
+  struct room_data *rooms;
+  struct char_data *chars;
+  struct player_special_data *specials;
+  struct descriptor_data *descs;
+  int zone_count, room_count, char_count;
+  struct zone_data *saved_zone_table;
+  zone_rnum saved_top_of_zone_table;
+  struct room_data *saved_world;
+  room_rnum saved_top_of_world;
+  struct char_data *saved_character_list;
+  struct descriptor_data *saved_descriptor_list;
+  bool saved_validate;
+};
+
+/* Zones of rooms_per_zone rooms each, and char_count connected mortals in
+ * the lists, all standing nowhere yet. */
+static void begin_presence_fixture(struct presence_fixture *fixture, int zone_count,
+                                   int rooms_per_zone, int char_count)
+{
+  int i;
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->saved_zone_table = zone_table;
+  fixture->saved_top_of_zone_table = top_of_zone_table;
+  fixture->saved_world = world;
+  fixture->saved_top_of_world = top_of_world;
+  fixture->saved_character_list = character_list;
+  fixture->saved_descriptor_list = descriptor_list;
+  fixture->saved_validate = zone_presence_validate;
+
+  fixture->zone_count = zone_count;
+  fixture->room_count = zone_count * rooms_per_zone;
+  fixture->char_count = char_count;
+  CREATE(fixture->zones, struct zone_data, zone_count);
+  CREATE(fixture->rooms, struct room_data, fixture->room_count);
+  CREATE(fixture->chars, struct char_data, char_count);
+  CREATE(fixture->specials, struct player_special_data, char_count);
+  CREATE(fixture->descs, struct descriptor_data, char_count);
+
+  for (i = 0; i < zone_count; i++)
+    fixture->zones[i].number = 100 + i;
+  for (i = 0; i < fixture->room_count; i++)
+  {
+    fixture->rooms[i].number = 10000 + i;
+    fixture->rooms[i].zone = i / rooms_per_zone;
+  }
+
+  zone_table = fixture->zones;
+  top_of_zone_table = zone_count - 1;
+  world = fixture->rooms;
+  top_of_world = fixture->room_count - 1;
+  character_list = NULL;
+  descriptor_list = NULL;
+
+  for (i = char_count - 1; i >= 0; i--)
+  {
+    fixture->chars[i].player_specials = &fixture->specials[i];
+    fixture->chars[i].player.name = (char *)"Tester";
+    fixture->chars[i].player.level = 1;
+    IN_ROOM(&fixture->chars[i]) = NOWHERE;
+    fixture->chars[i].desc = &fixture->descs[i];
+    fixture->chars[i].next = character_list;
+    character_list = &fixture->chars[i];
+
+    fixture->descs[i].character = &fixture->chars[i];
+    STATE(&fixture->descs[i]) = CON_PLAYING;
+    fixture->descs[i].next = descriptor_list;
+    descriptor_list = &fixture->descs[i];
+  }
+}
+
+static void end_presence_fixture(struct presence_fixture *fixture)
+{
+  zone_table = fixture->saved_zone_table;
+  top_of_zone_table = fixture->saved_top_of_zone_table;
+  world = fixture->saved_world;
+  top_of_world = fixture->saved_top_of_world;
+  character_list = fixture->saved_character_list;
+  descriptor_list = fixture->saved_descriptor_list;
+  zone_presence_validate = fixture->saved_validate;
+  free(fixture->zones);
+  free(fixture->rooms);
+  free(fixture->chars);
+  free(fixture->specials);
+  free(fixture->descs);
+}
+
+/* What char_from_room() and char_to_room() do to the lists. */
+static void presence_move(struct char_data *ch, room_rnum room)
+{
+  if (IN_ROOM(ch) != NOWHERE)
+    zone_presence_leave(ch);
+  IN_ROOM(ch) = room;
+  zone_presence_update(ch);
+}
+
+/* The descriptor scan is_empty() used to run, verbatim. */
+static int presence_legacy_is_empty(zone_rnum zone_nr)
+{
+  struct descriptor_data *i;
+
+  for (i = descriptor_list; i; i = i->next)
+  {
+    if (STATE(i) != CON_PLAYING)
+      continue;
+    if (IN_ROOM(i->character) == NOWHERE)
+      continue;
+    if (world[IN_ROOM(i->character)].zone != zone_nr)
+      continue;
+    /* If an immortal has nohassle off, he counts as present. Added for testing
+     * zone reset triggers -Welcor */
+    if ((!IS_NPC(i->character)) && (GET_LEVEL(i->character) >= LVL_IMMORT) &&
+        (PRF_FLAGGED(i->character, PRF_NOHASSLE)))
+      continue;
+
+    return (0);
+  }
+
+  return (1);
+}
+
+static void assert_presence_matches_scan(CuTest *tc, struct presence_fixture *fixture)
+{
+  zone_rnum zone;
+
+  for (zone = 0; (int)zone < fixture->zone_count; zone++)
+    CuAssertIntEquals(tc, presence_legacy_is_empty(zone), is_empty(zone));
+}
+
+void Test_zone_presence_matches_descriptor_scan(CuTest *tc)
+{
+  struct presence_fixture fixture;
+  struct char_data *mortal, *immortal, *linkless;
+  char audit[MAX_STRING_LENGTH];
+
+  begin_presence_fixture(&fixture, PRESENCE_TEST_ZONES, 2, PRESENCE_TEST_CHARS);
+  zone_presence_validate = FALSE;
+  mortal = &fixture.chars[0];
+  immortal = &fixture.chars[1];
+  linkless = &fixture.chars[2];
+
+  CuAssertIntEquals(tc, 1, is_empty(0));
+  presence_move(mortal, 0);
+  CuAssertIntEquals(tc, 0, is_empty(0));
+  CuAssertIntEquals(tc, 1, zone_table[0].presence_count);
+
+  /* Moving within the zone keeps one listing; moving out empties it. */
+  presence_move(mortal, 1);
+  CuAssertIntEquals(tc, 1, zone_table[0].presence_count);
+  presence_move(mortal, 2);
+  CuAssertIntEquals(tc, 1, is_empty(0));
+  CuAssertIntEquals(tc, 0, is_empty(1));
+  CuAssertIntEquals(tc, 0, zone_table[0].presence_count);
+
+  /* A nohassle immortal does not count until nohassle is off. */
+  immortal->player.level = LVL_IMMORT;
+  SET_BIT_AR(PRF_FLAGS(immortal), PRF_NOHASSLE);
+  presence_move(immortal, 4);
+  CuAssertIntEquals(tc, 1, is_empty(2));
+  REMOVE_BIT_AR(PRF_FLAGS(immortal), PRF_NOHASSLE);
+  CuAssertIntEquals(tc, 0, is_empty(2));
+
+  /* Nor does a player still at the menu or in OLC... */
+  STATE(immortal->desc) = CON_MENU;
+  CuAssertIntEquals(tc, 1, is_empty(2));
+  STATE(immortal->desc) = CON_PLAYING;
+
+  /* ...or one who lost link, though they stay listed for when they return. */
+  presence_move(linkless, 0);
+  STATE(linkless->desc) = CON_CLOSE;
+  linkless->desc->character = NULL;
+  linkless->desc = NULL;
+  CuAssertIntEquals(tc, 1, is_empty(0));
+  CuAssertIntEquals(tc, 1, zone_table[0].presence_count);
+  assert_presence_matches_scan(tc, &fixture);
+
+  CuAssertIntEquals(tc, 0, zone_presence_audit(audit, sizeof(audit)));
+  end_presence_fixture(&fixture);
+}
+
+void Test_zone_presence_follows_switched_mobiles(CuTest *tc)
+{
+  struct presence_fixture fixture;
+  struct char_data *god, *mob;
+
+  begin_presence_fixture(&fixture, PRESENCE_TEST_ZONES, 2, 2);
+  zone_presence_validate = FALSE;
+  god = &fixture.chars[0];
+  mob = &fixture.chars[1];
+
+  /* A mobile with no descriptor is never listed. */
+  SET_BIT_AR(MOB_FLAGS(mob), MOB_ISNPC);
+  mob->desc = NULL;
+  fixture.descs[1].character = NULL;
+  STATE(&fixture.descs[1]) = CON_CLOSE;
+  presence_move(mob, 4);
+  presence_move(god, 0);
+  CuAssertIntEquals(tc, 0, zone_table[2].presence_count);
+  CuAssertIntEquals(tc, 1, is_empty(2));
+
+  /* do_switch hands the god's descriptor to the mobile. */
+  mob->desc = god->desc;
+  god->desc->character = mob;
+  god->desc = NULL;
+  zone_presence_update(mob);
+  CuAssertIntEquals(tc, 0, is_empty(2));
+  CuAssertIntEquals(tc, 1, is_empty(0));
+  assert_presence_matches_scan(tc, &fixture);
+
+  /* The switched mobile carries the zone it walks into with it. */
+  presence_move(mob, 2);
+  CuAssertIntEquals(tc, 1, is_empty(2));
+  CuAssertIntEquals(tc, 0, is_empty(1));
+
+  /* do_return gives it back; the mobile falls off at its next update. */
+  god->desc = mob->desc;
+  god->desc->character = god;
+  mob->desc = NULL;
+  zone_presence_update(mob);
+  CuAssertIntEquals(tc, 0, zone_table[1].presence_count);
+  assert_presence_matches_scan(tc, &fixture);
+
+  end_presence_fixture(&fixture);
+}
+
+void Test_zone_presence_audit_and_validation_repair_lists(CuTest *tc)
+{
+  struct presence_fixture fixture;
+  char audit[MAX_STRING_LENGTH];
+
+  begin_presence_fixture(&fixture, PRESENCE_TEST_ZONES, 2, PRESENCE_TEST_CHARS);
+  zone_presence_validate = FALSE;
+  presence_move(&fixture.chars[0], 0);
+  presence_move(&fixture.chars[1], 5);
+
+  /* Placed behind the lists' back, as a caller that skips char_to_room would. */
+  IN_ROOM(&fixture.chars[2]) = 3;
+  CuAssertIntEquals(tc, 1, is_empty(1));
+  CuAssertTrue(tc, zone_presence_audit(audit, sizeof(audit)) > 0);
+  CuAssertPtrNotNull(tc, strstr(audit, "on no presence list"));
+  CuAssertIntEquals(tc, 0, is_empty(1));
+  CuAssertIntEquals(tc, 0, zone_presence_audit(audit, sizeof(audit)));
+
+  /* Validation mode catches the same thing on the spot and answers right. */
+  presence_move(&fixture.chars[2], 0);
+  IN_ROOM(&fixture.chars[3]) = 2;
+  zone_presence_validate = TRUE;
+  CuAssertIntEquals(tc, 0, is_empty(1));
+  zone_presence_validate = FALSE;
+  CuAssertIntEquals(tc, 0, is_empty(1));
+  CuAssertIntEquals(tc, 0, zone_presence_audit(audit, sizeof(audit)));
+  assert_presence_matches_scan(tc, &fixture);
+
+  end_presence_fixture(&fixture);
+}